@@ -0,0 +1,695 @@
+#include "graphics/animation.hpp"
+#include "graphics/animation_compression.hpp"
+#include "graphics/scene_graph.hpp"
+
+#include "foundation/numerics.hpp"
+#include "foundation/time.hpp"
+
+#include "external/cglm/struct/affine.h"
+#include "external/cglm/struct/mat4.h"
+#include "external/cglm/struct/quat.h"
+#include "external/cglm/struct/vec3.h"
+#include "external/cglm/struct/vec4.h"
+#include "external/tracy/tracy/Tracy.hpp"
+
+#include <math.h>
+#include <string.h>
+
+namespace raptor {
+
+static const u32 k_animation_cursor_steps       = 4;    // Key frames walked forward before searching.
+static const u32 k_animation_parallel_instances = 8;    // Fewer instances are updated on the calling thread.
+static const u32 k_animation_task_range         = 16;
+
+// Sampling ///////////////////////////////////////////////////////////////
+
+// Key frame k with key_frames[ k ] <= time < key_frames[ k + 1 ], time must be strictly inside the key frames.
+// Key frames are seconds, or 16 bits times for compressed tracks, compared as integers.
+template<typename KeyFrame>
+static u32 animation_find_key_frame( const KeyFrame* key_frames, u32 count, KeyFrame time, u32& cursor ) {
+    u32 k = cursor < count - 1 ? cursor : 0;
+
+    if ( time >= key_frames[ k ] ) {
+        // Playback usually moves forward by less than a key frame per update.
+        for ( u32 step = 0; step < k_animation_cursor_steps; ++step ) {
+            if ( time < key_frames[ k + 1 ] ) {
+                cursor = k;
+                return k;
+            }
+            ++k;
+        }
+    }
+
+    // Seek, loop or big step: search the last key frame not after time.
+    u32 low = 0;
+    u32 high = count - 1;
+    while ( high - low > 1 ) {
+        const u32 middle = ( low + high ) / 2;
+        if ( key_frames[ middle ] <= time ) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+
+    cursor = low;
+    return low;
+}
+
+vec4s animation_sampler_evaluate( const AnimationSampler& sampler, f32 time, u32& cursor, bool rotation ) {
+    if ( sampler.compressed.key_frame_count > 0 ) {
+        return animation_compressed_track_evaluate( sampler.compressed, time, cursor );
+    }
+
+    const f32* key_frames = sampler.key_frames.data;
+    const u32 count = sampler.key_frames.size;
+
+    // Cubic splines store in tangent, value and out tangent for each key frame.
+    const bool cubic = sampler.interpolation_type == AnimationSampler::CubicSpline;
+    const u32 stride = cubic ? 3 : 1;
+    const u32 value = cubic ? 1 : 0;
+
+    if ( count < 2 || time <= key_frames[ 0 ] ) {
+        cursor = 0;
+        return sampler.data[ value ];
+    }
+
+    if ( time >= key_frames[ count - 1 ] ) {
+        cursor = count - 2;
+        return sampler.data[ ( count - 1 ) * stride + value ];
+    }
+
+    const u32 k = animation_find_key_frame( key_frames, count, time, cursor );
+    const f32 delta = key_frames[ k + 1 ] - key_frames[ k ];
+    const f32 t = delta > 0.f ? ( time - key_frames[ k ] ) / delta : 0.f;
+
+    switch ( sampler.interpolation_type ) {
+        case AnimationSampler::Step:
+        {
+            return sampler.data[ k ];
+        }
+
+        case AnimationSampler::CubicSpline:
+        {
+            // Hermite spline, tangents are scaled by the key frame duration.
+            const f32 t2 = t * t;
+            const f32 t3 = t2 * t;
+            const vec4s p0 = sampler.data[ k * 3 + 1 ];
+            const vec4s m0 = glms_vec4_scale( sampler.data[ k * 3 + 2 ], delta );
+            const vec4s p1 = sampler.data[ ( k + 1 ) * 3 + 1 ];
+            const vec4s m1 = glms_vec4_scale( sampler.data[ ( k + 1 ) * 3 ], delta );
+
+            vec4s result = glms_vec4_scale( p0, 2.f * t3 - 3.f * t2 + 1.f );
+            result = glms_vec4_muladds( m0, t3 - 2.f * t2 + t, result );
+            result = glms_vec4_muladds( p1, -2.f * t3 + 3.f * t2, result );
+            result = glms_vec4_muladds( m1, t3 - t2, result );
+
+            return rotation ? glms_vec4_normalize( result ) : result;
+        }
+
+        default:
+        {
+            const vec4s current_data = sampler.data[ k ];
+            const vec4s next_data = sampler.data[ k + 1 ];
+
+            if ( rotation ) {
+                // glms_quat_slerp lerps nearly equal rotations without flipping them to the same hemisphere.
+                const f32 sign = glms_vec4_dot( current_data, next_data ) < 0.f ? -1.f : 1.f;
+                const versors current_rotation = glms_quat_init( current_data.x, current_data.y, current_data.z, current_data.w );
+                const versors next_rotation = glms_quat_init( next_data.x * sign, next_data.y * sign, next_data.z * sign, next_data.w * sign );
+                const versors result = glms_quat_normalize( glms_quat_slerp( current_rotation, next_rotation, t ) );
+
+                return vec4s{ result.x, result.y, result.z, result.w };
+            }
+
+            return glms_vec4_lerp( current_data, next_data, t );
+        }
+    }
+}
+
+// Inlined in animation_compressed_track_evaluate, calls returning vec4s cost more than decoding.
+static RAPTOR_FINLINE vec4s animation_compressed_decode( const AnimationCompressedTrack& track, u32 key_frame ) {
+    const u16* value = track.data + track.key_frame_count + key_frame * 3;
+
+    if ( !track.rotation ) {
+        return vec4s{ track.range_min.x + value[ 0 ] * track.range_scale.x, track.range_min.y + value[ 1 ] * track.range_scale.y,
+                      track.range_min.z + value[ 2 ] * track.range_scale.z, 0.f };
+    }
+
+    const u64 bits = ( u64 )value[ 0 ] | ( ( u64 )value[ 1 ] << 16 ) | ( ( u64 )value[ 2 ] << 32 );
+
+    const f32 scale = 2.f * k_animation_quaternion_range / k_animation_quaternion_steps;
+    const f32 a = ( u32 )( bits & 0x7fff ) * scale - k_animation_quaternion_range;
+    const f32 b = ( u32 )( ( bits >> 15 ) & 0x7fff ) * scale - k_animation_quaternion_range;
+    const f32 c = ( u32 )( ( bits >> 30 ) & 0x7fff ) * scale - k_animation_quaternion_range;
+    // The largest component is stored positive.
+    const f32 largest = sqrtf( raptor::max( 1.f - a * a - b * b - c * c, 0.f ) );
+
+    switch ( bits >> 46 ) {
+        case 0:
+            return vec4s{ largest, a, b, c };
+        case 1:
+            return vec4s{ a, largest, b, c };
+        case 2:
+            return vec4s{ a, b, largest, c };
+        default:
+            return vec4s{ a, b, c, largest };
+    }
+}
+
+vec4s animation_compressed_track_value( const AnimationCompressedTrack& track, u32 key_frame ) {
+    return animation_compressed_decode( track, key_frame );
+}
+
+vec4s animation_compressed_track_evaluate( const AnimationCompressedTrack& track, f32 time, u32& cursor ) {
+    const u16* key_frames = track.data;
+    const u32 count = track.key_frame_count;
+    const f32 key_time = ( time - track.time_start ) * track.time_scale;
+
+    if ( count < 2 || key_time <= key_frames[ 0 ] ) {
+        cursor = 0;
+        return animation_compressed_decode( track, 0 );
+    }
+
+    if ( key_time >= key_frames[ count - 1 ] ) {
+        cursor = count - 2;
+        return animation_compressed_decode( track, count - 1 );
+    }
+
+    // Key frames are integers, the one before key_time is the one before its integer part.
+    const u32 k = animation_find_key_frame( key_frames, count, ( u16 )key_time, cursor );
+    const vec4s current_data = animation_compressed_decode( track, k );
+    if ( track.step ) {
+        return current_data;
+    }
+
+    const u32 delta = key_frames[ k + 1 ] - key_frames[ k ];
+    const f32 t = delta > 0 ? ( key_time - key_frames[ k ] ) / delta : 0.f;
+    vec4s next_data = animation_compressed_decode( track, k + 1 );
+
+    if ( track.rotation ) {
+        // Rotations are stored with a positive largest component, blend them in the same hemisphere.
+        if ( glms_vec4_dot( current_data, next_data ) < 0.f ) {
+            next_data = glms_vec4_negate( next_data );
+        }
+        return glms_vec4_normalize( glms_vec4_lerp( current_data, next_data, t ) );
+    }
+
+    return glms_vec4_lerp( current_data, next_data, t );
+}
+
+static void animation_apply_channel( Transform& transform, AnimationChannel::TargetType target_type, const vec4s& value ) {
+    switch ( target_type ) {
+        case AnimationChannel::TargetType::Translation:
+        {
+            transform.translation = vec3s{ value.x, value.y, value.z };
+            break;
+        }
+        case AnimationChannel::TargetType::Rotation:
+        {
+            transform.rotation = glms_quat_init( value.x, value.y, value.z, value.w );
+            break;
+        }
+        case AnimationChannel::TargetType::Scale:
+        {
+            transform.scale = vec3s{ value.x, value.y, value.z };
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Morph target weights are not supported by the renderer.
+static bool animation_channel_supported( const AnimationChannel& channel ) {
+    return channel.target_type != AnimationChannel::TargetType::Weights;
+}
+
+static f32 animation_advance_time( const Animation& animation, f32 time, f32 delta_time, bool loop ) {
+    const f32 duration = animation.time_end - animation.time_start;
+    if ( duration <= 0.f ) {
+        return animation.time_start;
+    }
+
+    time += delta_time;
+
+    if ( time > animation.time_end ) {
+        time = loop ? animation.time_start + fmodf( time - animation.time_start, duration ) : animation.time_end;
+    } else if ( time < animation.time_start ) {
+        time = loop ? animation.time_end - fmodf( animation.time_start - time, duration ) : animation.time_start;
+    }
+
+    return time;
+}
+
+static void animation_sample_clip( const AnimationInstance& instance, const Animation& animation, f32 time, u32* cursors, Transform* pose ) {
+    for ( u32 c = 0; c < animation.channels.size; ++c ) {
+        const AnimationChannel& channel = animation.channels[ c ];
+        if ( !animation_channel_supported( channel ) ) {
+            continue;
+        }
+
+        const vec4s value = animation_sampler_evaluate( animation.samplers[ channel.sampler ], time, cursors[ channel.sampler ],
+                                                        channel.target_type == AnimationChannel::TargetType::Rotation );
+
+        const u32 node = channel.target_node + instance.target_offset - instance.first_node;
+        animation_apply_channel( pose[ node ], channel.target_type, value );
+    }
+}
+
+// AnimationInstance //////////////////////////////////////////////////////
+
+static void animation_transform_from_matrix( const mat4s& matrix, Transform& transform ) {
+    vec4s translation;
+    mat4s rotation;
+    glms_decompose( matrix, &translation, &rotation, &transform.scale );
+
+    transform.translation = vec3s{ translation.x, translation.y, translation.z };
+    transform.rotation = glms_mat4_quat( rotation );
+}
+
+// Nodes targeted by a clip are added once, they go back to the rest pose when no clip targets them anymore.
+static void animation_instance_add_targets( AnimationInstance& instance, const Animation& animation ) {
+    for ( u32 c = 0; c < animation.channels.size; ++c ) {
+        const AnimationChannel& channel = animation.channels[ c ];
+        if ( !animation_channel_supported( channel ) ) {
+            continue;
+        }
+
+        const u32 node = channel.target_node + instance.target_offset - instance.first_node;
+        RASSERTM( node < instance.node_count, "Animation channel targets node %d, outside of the instance nodes", channel.target_node );
+
+        if ( instance.node_animated[ node ] == 0 ) {
+            instance.node_animated[ node ] = 1;
+            instance.animated_nodes.push( node );
+        }
+    }
+}
+
+void AnimationInstance::init( Allocator* allocator, SceneGraph* scene_graph_, u32 first_node_, u32 node_count_ ) {
+    animation = nullptr;
+    previous_animation = nullptr;
+    current_time = 0.f;
+    previous_time = 0.f;
+    fade_time = 0.f;
+    fade_duration = 0.f;
+    speed = 1.f;
+    loop = true;
+    previous_loop = true;
+
+    scene_graph = scene_graph_;
+    first_node = first_node_;
+    node_count = node_count_;
+    target_offset = 0;
+
+    cursors.init( allocator, 16 );
+    previous_cursors.init( allocator, 16 );
+    rest_pose.init( allocator, node_count, node_count );
+    pose.init( allocator, node_count, node_count );
+    fade_pose.init( allocator, node_count, node_count );
+    animated_nodes.init( allocator, node_count );
+    node_animated.init( allocator, node_count, node_count );
+
+    memset( node_animated.data, 0, node_count );
+
+    for ( u32 n = 0; n < node_count; ++n ) {
+        animation_transform_from_matrix( scene_graph->local_matrices[ first_node + n ], rest_pose[ n ] );
+    }
+}
+
+void AnimationInstance::shutdown() {
+    cursors.shutdown();
+    previous_cursors.shutdown();
+    rest_pose.shutdown();
+    pose.shutdown();
+    fade_pose.shutdown();
+    animated_nodes.shutdown();
+    node_animated.shutdown();
+}
+
+void AnimationInstance::play( Animation* animation_, f32 fade_duration_, bool loop_ ) {
+    if ( animation != nullptr && animation_ != nullptr && fade_duration_ > 0.f ) {
+        // The current clip keeps playing from where it is while fading out.
+        previous_animation = animation;
+        previous_time = current_time;
+        previous_loop = loop;
+
+        const Array<u32> swap = previous_cursors;
+        previous_cursors = cursors;
+        cursors = swap;
+
+        fade_time = 0.f;
+        fade_duration = fade_duration_;
+    } else {
+        previous_animation = nullptr;
+    }
+
+    animation = animation_;
+    loop = loop_;
+
+    if ( animation == nullptr ) {
+        return;
+    }
+
+    current_time = animation->time_start;
+
+    cursors.set_size( animation->samplers.size );
+    memset( cursors.data, 0, sizeof( u32 ) * cursors.size );
+
+    animation_instance_add_targets( *this, *animation );
+}
+
+void AnimationInstance::update( f32 delta_time ) {
+    if ( animation == nullptr ) {
+        return;
+    }
+
+    current_time = animation_advance_time( *animation, current_time, delta_time * speed, loop );
+
+    for ( u32 i = 0; i < animated_nodes.size; ++i ) {
+        const u32 node = animated_nodes[ i ];
+        pose[ node ] = rest_pose[ node ];
+    }
+    animation_sample_clip( *this, *animation, current_time, cursors.data, pose.data );
+
+    if ( previous_animation ) {
+        fade_time += delta_time;
+
+        if ( fade_time >= fade_duration ) {
+            previous_animation = nullptr;
+        } else {
+            previous_time = animation_advance_time( *previous_animation, previous_time, delta_time * speed, previous_loop );
+
+            for ( u32 i = 0; i < animated_nodes.size; ++i ) {
+                const u32 node = animated_nodes[ i ];
+                fade_pose[ node ] = rest_pose[ node ];
+            }
+            animation_sample_clip( *this, *previous_animation, previous_time, previous_cursors.data, fade_pose.data );
+
+            const f32 weight = fade_time / fade_duration;
+            for ( u32 i = 0; i < animated_nodes.size; ++i ) {
+                const u32 node = animated_nodes[ i ];
+                const Transform& from = fade_pose[ node ];
+                Transform& to = pose[ node ];
+
+                to.translation = glms_vec3_lerp( from.translation, to.translation, weight );
+                // Same hemisphere flip as the sampler, compressed clips store the largest component positive.
+                const f32 sign = glms_quat_dot( from.rotation, to.rotation ) < 0.f ? -1.f : 1.f;
+                const versors to_rotation = glms_quat_init( to.rotation.x * sign, to.rotation.y * sign, to.rotation.z * sign, to.rotation.w * sign );
+                to.rotation = glms_quat_normalize( glms_quat_slerp( from.rotation, to_rotation, weight ) );
+                to.scale = glms_vec3_lerp( from.scale, to.scale, weight );
+            }
+        }
+    }
+
+    // Instances own their nodes, local matrices can be written from any thread.
+    mat4s* local_matrices = scene_graph->local_matrices.data + first_node;
+    for ( u32 i = 0; i < animated_nodes.size; ++i ) {
+        const u32 node = animated_nodes[ i ];
+        local_matrices[ node ] = pose[ node ].calculate_matrix();
+    }
+}
+
+// Update /////////////////////////////////////////////////////////////////
+
+//
+// Updates a range of animation instances.
+struct AnimationUpdateTask : public enki::ITaskSet {
+
+    void                    ExecuteRange( enki::TaskSetPartition range_, uint32_t threadnum_ ) override;
+
+    AnimationInstance*      instances       = nullptr;
+    f32                     delta_time      = 0.f;
+}; // struct AnimationUpdateTask
+
+void AnimationUpdateTask::ExecuteRange( enki::TaskSetPartition range_, uint32_t threadnum_ ) {
+    ZoneScoped;
+
+    for ( u32 i = range_.start; i < range_.end; ++i ) {
+        instances[ i ].update( delta_time );
+    }
+}
+
+// Updated bits of different instances can share a byte, they are set after the instances are updated.
+static void animation_mark_updated_nodes( AnimationInstance* instances, u32 count ) {
+    for ( u32 i = 0; i < count; ++i ) {
+        AnimationInstance& instance = instances[ i ];
+        if ( instance.animation == nullptr ) {
+            continue;
+        }
+
+        for ( u32 n = 0; n < instance.animated_nodes.size; ++n ) {
+            instance.scene_graph->updated_nodes.set_bit( instance.first_node + instance.animated_nodes[ n ] );
+        }
+    }
+}
+
+void animation_update_instances( AnimationInstance* instances, u32 count, f32 delta_time, enki::TaskScheduler* task_scheduler ) {
+    ZoneScoped;
+
+    if ( count == 0 ) {
+        return;
+    }
+
+    AnimationUpdateTask task;
+    task.instances = instances;
+    task.delta_time = delta_time;
+
+    if ( task_scheduler == nullptr || count < k_animation_parallel_instances ) {
+        task.ExecuteRange( { 0, count }, 0 );
+    } else {
+        task.m_SetSize = count;
+        task.m_MinRange = k_animation_task_range;
+        task_scheduler->AddTaskSetToPipe( &task );
+        task_scheduler->WaitforTask( &task );
+    }
+
+    animation_mark_updated_nodes( instances, count );
+}
+
+// Benchmark //////////////////////////////////////////////////////////////
+
+static const u32 k_animation_benchmark_characters   = 1000;
+static const u32 k_animation_benchmark_nodes        = 64;
+static const u32 k_animation_benchmark_key_frames   = 61;   // Two seconds at 30 frames per second.
+static const u32 k_animation_benchmark_frames       = 60;
+
+static f32 animation_benchmark_random( u32& state ) {
+    state = state * 1664525u + 1013904223u;
+    return ( state >> 8 ) * ( 2.f / 16777216.f ) - 1.f;
+}
+
+// Translation, rotation and scale channels for every node, all with the same interpolation.
+static void animation_benchmark_create_clip( Animation& clip, AnimationSampler::Interpolation interpolation, u32 seed, Allocator* allocator ) {
+    const u32 channel_count = k_animation_benchmark_nodes * 3;
+    const u32 values_per_key_frame = interpolation == AnimationSampler::CubicSpline ? 3 : 1;
+
+    clip.time_start = 0.f;
+    clip.time_end = ( k_animation_benchmark_key_frames - 1 ) / 30.f;
+    clip.channels.init( allocator, channel_count, channel_count );
+    clip.samplers.init( allocator, channel_count, channel_count );
+
+    u32 state = seed;
+    for ( u32 c = 0; c < channel_count; ++c ) {
+        AnimationChannel& channel = clip.channels[ c ];
+        channel.sampler = c;
+        channel.target_node = c / 3;
+        channel.target_type = ( AnimationChannel::TargetType )( c % 3 );
+
+        AnimationSampler& sampler = clip.samplers[ c ];
+        sampler.interpolation_type = interpolation;
+        sampler.compressed = { };
+        sampler.key_frames.init( allocator, k_animation_benchmark_key_frames, k_animation_benchmark_key_frames );
+        for ( u32 k = 0; k < k_animation_benchmark_key_frames; ++k ) {
+            sampler.key_frames[ k ] = k / 30.f;
+        }
+
+        const u32 value_count = k_animation_benchmark_key_frames * values_per_key_frame;
+        sampler.data = ( vec4s* )rallocaa( sizeof( vec4s ) * value_count, allocator, 16 );
+        for ( u32 v = 0; v < value_count; ++v ) {
+            const vec4s noise{ animation_benchmark_random( state ), animation_benchmark_random( state ), animation_benchmark_random( state ), animation_benchmark_random( state ) };
+            const bool tangent = values_per_key_frame == 3 && ( v % 3 ) != 1;
+
+            switch ( channel.target_type ) {
+                case AnimationChannel::TargetType::Translation:
+                    sampler.data[ v ] = tangent ? glms_vec4_scale( noise, 0.1f ) : vec4s{ noise.x * 0.1f, 1.f + noise.y * 0.1f, noise.z * 0.1f, 0.f };
+                    break;
+                case AnimationChannel::TargetType::Rotation:
+                    sampler.data[ v ] = tangent ? glms_vec4_scale( noise, 0.1f ) : glms_vec4_normalize( vec4s{ noise.x * 0.3f, noise.y * 0.3f, noise.z * 0.3f, 1.f } );
+                    break;
+                default:
+                    sampler.data[ v ] = tangent ? glms_vec4_scale( noise, 0.01f ) : vec4s{ 1.f + noise.x * 0.05f, 1.f + noise.y * 0.05f, 1.f + noise.z * 0.05f, 0.f };
+                    break;
+            }
+        }
+    }
+}
+
+static void animation_benchmark_destroy_clip( Animation& clip, Allocator* allocator ) {
+    for ( u32 s = 0; s < clip.samplers.size; ++s ) {
+        clip.samplers[ s ].key_frames.shutdown();
+        rfree( clip.samplers[ s ].data, allocator );
+    }
+    clip.samplers.shutdown();
+    clip.channels.shutdown();
+}
+
+// Same as AnimationInstance::update without cross fades, with every key frame found by a scan from the start.
+static void animation_benchmark_update_scan( AnimationInstance& instance, f32 delta_time ) {
+    const Animation& animation = *instance.animation;
+    instance.current_time = animation_advance_time( animation, instance.current_time, delta_time * instance.speed, instance.loop );
+
+    for ( u32 i = 0; i < instance.animated_nodes.size; ++i ) {
+        const u32 node = instance.animated_nodes[ i ];
+        instance.pose[ node ] = instance.rest_pose[ node ];
+    }
+
+    for ( u32 c = 0; c < animation.channels.size; ++c ) {
+        const AnimationChannel& channel = animation.channels[ c ];
+        const AnimationSampler& sampler = animation.samplers[ channel.sampler ];
+
+        u32 key_frame = 0;
+        while ( key_frame + 2 < sampler.key_frames.size && instance.current_time >= sampler.key_frames[ key_frame + 1 ] ) {
+            ++key_frame;
+        }
+
+        const vec4s value = animation_sampler_evaluate( sampler, instance.current_time, key_frame, channel.target_type == AnimationChannel::TargetType::Rotation );
+        animation_apply_channel( instance.pose[ channel.target_node + instance.target_offset - instance.first_node ], channel.target_type, value );
+    }
+
+    mat4s* local_matrices = instance.scene_graph->local_matrices.data + instance.first_node;
+    for ( u32 i = 0; i < instance.animated_nodes.size; ++i ) {
+        const u32 node = instance.animated_nodes[ i ];
+        local_matrices[ node ] = instance.pose[ node ].calculate_matrix();
+    }
+}
+
+// Start every character on the first clip at a different time, then fade to the second one if given.
+static void animation_benchmark_reset( Array<AnimationInstance>& instances, Animation* clip, Animation* fade_clip ) {
+    for ( u32 c = 0; c < instances.size; ++c ) {
+        AnimationInstance& instance = instances[ c ];
+        instance.play( clip );
+        instance.current_time = ( c % k_animation_benchmark_key_frames ) / 30.f;
+
+        if ( fade_clip ) {
+            instance.play( fade_clip, 2.f );
+        }
+    }
+}
+
+//
+//
+struct AnimationBenchmarkCase {
+    cstring                 name;
+    bool                    scan;
+    bool                    parallel;
+    bool                    cross_fade;
+    bool                    scene_graph;    // Include the scene graph update.
+}; // struct AnimationBenchmarkCase
+
+void animation_benchmark( enki::TaskScheduler* task_scheduler, Allocator* allocator ) {
+    static const u32 k_iterations = 3;
+
+    static const AnimationBenchmarkCase k_cases[] = {
+        { "linear, scan                 ", true,  false, false, false },
+        { "linear, cursors              ", false, false, false, false },
+        { "linear, cursors parallel     ", false, true,  false, false },
+        { "cross fade to cubic, parallel", false, true,  true,  false },
+        { "cross fade + scene graph     ", false, true,  true,  true },
+    };
+
+    const u32 node_count = k_animation_benchmark_characters * k_animation_benchmark_nodes;
+
+    // Characters are binary trees of nodes one unit above their parents.
+    SceneGraph scene_graph;
+    scene_graph.init( allocator, node_count );
+    scene_graph.resize( node_count );
+    scene_graph.init_new_nodes( 0, node_count );
+
+    for ( u32 n = 0; n < node_count; ++n ) {
+        scene_graph.set_local_matrix( n, glms_translate_make( vec3s{ 0.f, 1.f, 0.f } ) );
+
+        const u32 bone = n % k_animation_benchmark_nodes;
+        if ( bone > 0 ) {
+            const u32 parent = n - bone + ( bone - 1 ) / 2;
+            scene_graph.set_hierarchy( n, parent, scene_graph.nodes_hierarchy[ parent ].level + 1 );
+        }
+    }
+
+    Animation clips[ 2 ];
+    animation_benchmark_create_clip( clips[ 0 ], AnimationSampler::Linear, 7, allocator );
+    animation_benchmark_create_clip( clips[ 1 ], AnimationSampler::CubicSpline, 13, allocator );
+
+    Array<AnimationInstance> instances;
+    instances.init( allocator, k_animation_benchmark_characters, k_animation_benchmark_characters );
+    for ( u32 c = 0; c < k_animation_benchmark_characters; ++c ) {
+        AnimationInstance& instance = instances[ c ];
+        instance.init( allocator, &scene_graph, c * k_animation_benchmark_nodes, k_animation_benchmark_nodes );
+        instance.target_offset = c * k_animation_benchmark_nodes;
+    }
+
+    Array<mat4s> reference;
+    reference.init( allocator, node_count, node_count );
+
+    const u32 channel_count = clips[ 0 ].channels.size;
+    const f32 delta_time = 1.f / 60.f;
+
+    rprint( "Animation benchmark, %u characters, %u nodes, %u channels of %u key frames, %u task threads, best of %u runs\n", k_animation_benchmark_characters,
+            k_animation_benchmark_nodes, channel_count, k_animation_benchmark_key_frames, task_scheduler ? task_scheduler->GetNumTaskThreads() : 0, k_iterations );
+
+    for ( u32 c = 0; c < ArraySize( k_cases ); ++c ) {
+        const AnimationBenchmarkCase& bench = k_cases[ c ];
+
+        f64 best_ms = 1e30;
+        for ( u32 i = 0; i < k_iterations; ++i ) {
+            animation_benchmark_reset( instances, &clips[ 0 ], bench.cross_fade ? &clips[ 1 ] : nullptr );
+
+            const i64 begin_time = time_now();
+            for ( u32 frame = 0; frame < k_animation_benchmark_frames; ++frame ) {
+                if ( bench.scan ) {
+                    for ( u32 a = 0; a < instances.size; ++a ) {
+                        animation_benchmark_update_scan( instances[ a ], delta_time );
+                    }
+                    animation_mark_updated_nodes( instances.data, instances.size );
+                } else {
+                    animation_update_instances( instances.data, instances.size, delta_time, bench.parallel ? task_scheduler : nullptr );
+                }
+
+                if ( bench.scene_graph ) {
+                    scene_graph.update_matrices( task_scheduler );
+                }
+            }
+            const f64 ms = time_from_milliseconds( begin_time ) / k_animation_benchmark_frames;
+            best_ms = ms < best_ms ? ms : best_ms;
+        }
+
+        const f64 channels_sampled = ( f64 )k_animation_benchmark_characters * channel_count * ( bench.cross_fade ? 2 : 1 );
+        rprint( "    %s: %7.3f ms per frame, %7.1f M channels/s", bench.name, best_ms, channels_sampled / ( best_ms * 1e-3 * 1e6 ) );
+
+        // Clips without fade end at the same time, their local matrices should match the scan ones.
+        if ( bench.scan ) {
+            memcpy( reference.data, scene_graph.local_matrices.data, sizeof( mat4s ) * node_count );
+        } else if ( !bench.cross_fade ) {
+            f32 max_difference = 0.f;
+            for ( u32 n = 0; n < node_count; ++n ) {
+                for ( u32 e = 0; e < 16; ++e ) {
+                    max_difference = raptor::max( max_difference, fabsf( reference[ n ].raw[ e / 4 ][ e % 4 ] - scene_graph.local_matrices[ n ].raw[ e / 4 ][ e % 4 ] ) );
+                }
+            }
+            rprint( ", max difference with the scan %g", max_difference );
+        }
+        rprint( "\n" );
+    }
+
+    for ( u32 c = 0; c < instances.size; ++c ) {
+        instances[ c ].shutdown();
+    }
+    instances.shutdown();
+    reference.shutdown();
+
+    animation_benchmark_destroy_clip( clips[ 0 ], allocator );
+    animation_benchmark_destroy_clip( clips[ 1 ], allocator );
+    scene_graph.shutdown();
+}
+
+} // namespace raptor
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "graphics/render_scene.hpp"
+
+namespace raptor {
+
+    // Animation runtime //////////////////////////////////////////////////
+    //
+    // Each AnimationInstance plays clips on its own range of scene graph nodes: the nodes of a glTF scene,
+    // or a copy of them with target_offset moving the channel targets. Nodes start every update from the
+    // rest pose captured at init, and channels replace the components they target.
+    //
+    // Samplers remember the last key frame used, so playback moving forward finds the next one in a step
+    // or two and sampling costs the same for any clip length. Seeks and loops fall back to a binary search.
+    // During a cross fade both clips are sampled and each component is blended with the fade weight.
+
+    // Value of a sampler at time, clamped to its first and last key frames. cursor is the key frame found
+    // by the previous call on the same sampler, rotations are normalized quaternions as x, y, z, w.
+    // Compressed samplers are evaluated with animation_compressed_track_evaluate.
+    vec4s                       animation_sampler_evaluate( const AnimationSampler& sampler, f32 time, u32& cursor, bool rotation );
+
+    // Compressed tracks, written by animation_compress_sampler. Times are 16 bits across the track, values
+    // three 16 bits words: translations and scales quantized in the track range, rotations as the index
+    // of their largest component in the top 2 bits and the other three in 15 bits each. Key frames are
+    // interpolated linearly, rotations with a normalized lerp.
+    vec4s                       animation_compressed_track_value( const AnimationCompressedTrack& track, u32 key_frame );
+    vec4s                       animation_compressed_track_evaluate( const AnimationCompressedTrack& track, f32 time, u32& cursor );
+
+    // Update the instances, split between the task threads if a task scheduler is given, then mark
+    // their animated nodes as updated in the scene graph.
+    void                        animation_update_instances( AnimationInstance* instances, u32 count, f32 delta_time, enki::TaskScheduler* task_scheduler );
+
+    // Sample 1K characters of 64 nodes for a second of frames: key frame scans against cursors,
+    // serial against the task threads, and with every character cross fading between two clips.
+    void                        animation_benchmark( enki::TaskScheduler* task_scheduler, Allocator* allocator );
+
+} // namespace raptor
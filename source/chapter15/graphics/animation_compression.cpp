@@ -0,0 +1,466 @@
+#include "graphics/animation_compression.hpp"
+#include "graphics/animation.hpp"
+
+#include "foundation/numerics.hpp"
+#include "foundation/time.hpp"
+
+#include "external/cglm/struct/vec4.h"
+#include "external/tracy/tracy/Tracy.hpp"
+
+#include <math.h>
+#include <string.h>
+
+namespace raptor {
+
+// Quantization, mirrors animation_compressed_track_value.
+static const f32 k_animation_range_steps        = 65535.f;
+static const f32 k_animation_time_steps         = 65535.f;
+
+static const f32 k_animation_degrees_to_radians = rpi / 180.f;
+
+// Distance between translations or scales, angle in radians between rotations.
+static f32 animation_compression_error( const vec4s& a, const vec4s& b, bool rotation ) {
+    if ( rotation ) {
+        // From the chord between the quaternions, the arc cosine of their dot product is too imprecise for small angles.
+        const vec4s chord = glms_vec4_dot( a, b ) < 0.f ? glms_vec4_add( a, b ) : glms_vec4_sub( a, b );
+        return 4.f * asinf( raptor::min( glms_vec4_norm( chord ) * 0.5f, 1.f ) );
+    }
+
+    const f32 dx = a.x - b.x;
+    const f32 dy = a.y - b.y;
+    const f32 dz = a.z - b.z;
+    return sqrtf( dx * dx + dy * dy + dz * dz );
+}
+
+// Same interpolation as the compressed tracks.
+static vec4s animation_compression_lerp( const vec4s& a, vec4s b, f32 t, bool rotation ) {
+    if ( rotation ) {
+        if ( glms_vec4_dot( a, b ) < 0.f ) {
+            b = glms_vec4_negate( b );
+        }
+        return glms_vec4_normalize( glms_vec4_lerp( a, b, t ) );
+    }
+
+    return glms_vec4_lerp( a, b, t );
+}
+
+// Key frame reduction ////////////////////////////////////////////////////
+
+// Can values between start and end be interpolated from them?
+static bool animation_compression_segment_fits( const f32* times, const vec4s* values, u32 start, u32 end, bool rotation, f32 tolerance ) {
+    const f32 duration = times[ end ] - times[ start ];
+
+    for ( u32 s = start + 1; s < end; ++s ) {
+        const f32 t = duration > 0.f ? ( times[ s ] - times[ start ] ) / duration : 0.f;
+        const vec4s value = animation_compression_lerp( values[ start ], values[ end ], t, rotation );
+        if ( animation_compression_error( value, values[ s ], rotation ) > tolerance ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Mark the samples to keep, returns their count. Segments grow greedily from the last kept sample,
+// until the samples inside one of them are further than tolerance from its interpolation.
+static u32 animation_compression_reduce( const f32* times, const vec4s* values, u32 count, bool rotation, bool step, f32 tolerance, u8* keep ) {
+    memset( keep, 0, count );
+    keep[ 0 ] = 1;
+
+    bool constant = true;
+    for ( u32 s = 1; s < count && constant; ++s ) {
+        constant = animation_compression_error( values[ 0 ], values[ s ], rotation ) <= tolerance;
+    }
+    if ( constant ) {
+        return 1;
+    }
+
+    u32 kept_count = 1;
+    u32 start = 0;
+
+    if ( step ) {
+        // Values are held until the next key frame, keep the ones that change.
+        for ( u32 s = 1; s < count; ++s ) {
+            if ( animation_compression_error( values[ start ], values[ s ], rotation ) > tolerance ) {
+                keep[ s ] = 1;
+                start = s;
+                ++kept_count;
+            }
+        }
+        return kept_count;
+    }
+
+    for ( u32 end = 2; end < count; ++end ) {
+        if ( !animation_compression_segment_fits( times, values, start, end, rotation, tolerance ) ) {
+            start = end - 1;
+            keep[ start ] = 1;
+            ++kept_count;
+        }
+    }
+
+    keep[ count - 1 ] = 1;
+    return kept_count + 1;
+}
+
+// Quantization ///////////////////////////////////////////////////////////
+
+// Largest component index in bits 46 and 47, the other three in 15 bits each from bit 0.
+static void animation_compression_encode_rotation( const vec4s& rotation, u16* value ) {
+    const f32 components[ 4 ] = { rotation.x, rotation.y, rotation.z, rotation.w };
+
+    u32 largest = 0;
+    for ( u32 c = 1; c < 4; ++c ) {
+        if ( fabsf( components[ c ] ) > fabsf( components[ largest ] ) ) {
+            largest = c;
+        }
+    }
+
+    // q and -q are the same rotation, flip it to have a positive largest component.
+    const f32 sign = components[ largest ] < 0.f ? -1.f : 1.f;
+
+    u64 bits = ( u64 )largest << 46;
+    for ( u32 c = 0, shift = 0; c < 4; ++c ) {
+        if ( c == largest ) {
+            continue;
+        }
+
+        const f32 normalized = ( components[ c ] * sign + k_animation_quaternion_range ) / ( 2.f * k_animation_quaternion_range );
+        const f32 quantized = raptor::max( raptor::min( roundf( normalized * k_animation_quaternion_steps ), k_animation_quaternion_steps ), 0.f );
+        bits |= ( u64 )quantized << shift;
+        shift += 15;
+    }
+
+    value[ 0 ] = ( u16 )bits;
+    value[ 1 ] = ( u16 )( bits >> 16 );
+    value[ 2 ] = ( u16 )( bits >> 32 );
+}
+
+static u16 animation_compression_quantize( f32 value, f32 range_min, f32 range_scale ) {
+    if ( range_scale <= 0.f ) {
+        return 0;
+    }
+
+    const f32 quantized = roundf( ( value - range_min ) / range_scale );
+    return ( u16 )raptor::max( raptor::min( quantized, k_animation_range_steps ), 0.f );
+}
+
+// Compression ////////////////////////////////////////////////////////////
+
+void animation_compress_sampler( const AnimationSampler& sampler, AnimationChannel::TargetType target_type, const AnimationCompressionParameters& parameters,
+                                 Allocator* allocator, AnimationCompressedTrack& track ) {
+    ZoneScoped;
+
+    memset( &track, 0, sizeof( AnimationCompressedTrack ) );
+
+    const u32 key_frame_count = sampler.key_frames.size;
+    if ( key_frame_count == 0 ) {
+        return;
+    }
+
+    const bool rotation = target_type == AnimationChannel::TargetType::Rotation;
+    const bool step = sampler.interpolation_type == AnimationSampler::Step;
+
+    // Source values at each key frame, and inside the segments of cubic splines.
+    const u32 segment_samples = sampler.interpolation_type == AnimationSampler::CubicSpline ? raptor::max( parameters.cubic_samples, 1u ) : 1;
+    const u32 sample_count = ( key_frame_count - 1 ) * segment_samples + 1;
+
+    f32* times = ( f32* )rallocaa( sizeof( f32 ) * sample_count, allocator, 16 );
+    vec4s* values = ( vec4s* )rallocaa( sizeof( vec4s ) * sample_count, allocator, 16 );
+    u8* keep = ( u8* )rallocaa( sample_count, allocator, 16 );
+
+    u32 cursor = 0;
+    for ( u32 s = 0; s < sample_count; ++s ) {
+        const u32 k = s / segment_samples;
+        const u32 j = s % segment_samples;
+
+        times[ s ] = j == 0 ? sampler.key_frames[ k ] : sampler.key_frames[ k ] + ( sampler.key_frames[ k + 1 ] - sampler.key_frames[ k ] ) * j / segment_samples;
+        values[ s ] = animation_sampler_evaluate( sampler, times[ s ], cursor, rotation );
+        if ( rotation ) {
+            values[ s ] = glms_vec4_normalize( values[ s ] );
+        }
+    }
+
+    // Quantization ranges, and the part of the tolerance left to the key frame reduction.
+    f32 tolerance;
+    if ( rotation ) {
+        // Each stored component is off by half a step at most, the reconstructed one by a few times that.
+        const f32 half_step = k_animation_quaternion_range / k_animation_quaternion_steps;
+        const f32 quantization_error = 4.f * asinf( 2.5f * half_step );
+
+        tolerance = parameters.rotation_error * k_animation_degrees_to_radians;
+        tolerance = raptor::max( tolerance - quantization_error, tolerance * 0.25f );
+    } else {
+        vec3s range_max{ values[ 0 ].x, values[ 0 ].y, values[ 0 ].z };
+        track.range_min = range_max;
+        for ( u32 s = 1; s < sample_count; ++s ) {
+            track.range_min = vec3s{ raptor::min( track.range_min.x, values[ s ].x ), raptor::min( track.range_min.y, values[ s ].y ), raptor::min( track.range_min.z, values[ s ].z ) };
+            range_max = vec3s{ raptor::max( range_max.x, values[ s ].x ), raptor::max( range_max.y, values[ s ].y ), raptor::max( range_max.z, values[ s ].z ) };
+        }
+
+        track.range_scale = vec3s{ ( range_max.x - track.range_min.x ) / k_animation_range_steps, ( range_max.y - track.range_min.y ) / k_animation_range_steps,
+                                   ( range_max.z - track.range_min.z ) / k_animation_range_steps };
+
+        const vec3s& scale = track.range_scale;
+        const f32 quantization_error = 0.5f * sqrtf( scale.x * scale.x + scale.y * scale.y + scale.z * scale.z );
+
+        tolerance = target_type == AnimationChannel::TargetType::Translation ? parameters.translation_error : parameters.scale_error;
+        tolerance = raptor::max( tolerance - quantization_error, tolerance * 0.25f );
+    }
+
+    const u32 kept_count = animation_compression_reduce( times, values, sample_count, rotation, step, tolerance, keep );
+
+    track.data = ( u16* )rallocaa( sizeof( u16 ) * kept_count * 4, allocator, 16 );
+    track.key_frame_count = kept_count;
+    track.rotation = rotation;
+    track.step = step;
+    track.time_start = times[ 0 ];
+
+    const f32 duration = times[ sample_count - 1 ] - times[ 0 ];
+    track.time_scale = duration > 0.f ? k_animation_time_steps / duration : 0.f;
+
+    u16* track_values = track.data + kept_count;
+    for ( u32 s = 0, k = 0; s < sample_count; ++s ) {
+        if ( !keep[ s ] ) {
+            continue;
+        }
+
+        // Step key frames are rounded down, so that the value changes at the source key frame time or just before it.
+        const f32 time = ( times[ s ] - track.time_start ) * track.time_scale;
+        track.data[ k ] = ( u16 )raptor::min( step ? time : time + 0.5f, k_animation_time_steps );
+
+        u16* value = track_values + k * 3;
+        if ( rotation ) {
+            animation_compression_encode_rotation( values[ s ], value );
+        } else {
+            value[ 0 ] = animation_compression_quantize( values[ s ].x, track.range_min.x, track.range_scale.x );
+            value[ 1 ] = animation_compression_quantize( values[ s ].y, track.range_min.y, track.range_scale.y );
+            value[ 2 ] = animation_compression_quantize( values[ s ].z, track.range_min.z, track.range_scale.z );
+        }
+        ++k;
+    }
+
+    rfree( keep, allocator );
+    rfree( values, allocator );
+    rfree( times, allocator );
+}
+
+void animation_compressed_track_shutdown( AnimationCompressedTrack& track, Allocator* allocator ) {
+    if ( track.data ) {
+        rfree( track.data, allocator );
+    }
+    track.data = nullptr;
+    track.key_frame_count = 0;
+}
+
+void animation_compression_statistics( const AnimationSampler& sampler, AnimationChannel::TargetType target_type, const AnimationCompressedTrack& track,
+                                       AnimationCompressionStats& stats ) {
+    static const u32 k_segment_samples = 8;
+
+    const u32 key_frame_count = sampler.key_frames.size;
+    const u32 values_per_key_frame = sampler.interpolation_type == AnimationSampler::CubicSpline ? 3 : 1;
+    const bool rotation = target_type == AnimationChannel::TargetType::Rotation;
+
+    ++stats.sampler_count;
+    stats.source_key_frames += key_frame_count;
+    stats.compressed_key_frames += track.key_frame_count;
+    stats.source_bytes += ( sizeof( f32 ) + sizeof( vec4s ) * values_per_key_frame ) * key_frame_count;
+    stats.compressed_bytes += sizeof( u16 ) * 4 * track.key_frame_count;
+
+    if ( key_frame_count == 0 || track.key_frame_count == 0 ) {
+        return;
+    }
+
+    // Source key frames and points between them.
+    f32 max_error = 0.f;
+    u32 source_cursor = 0;
+    u32 track_cursor = 0;
+    for ( u32 k = 0; k < key_frame_count; ++k ) {
+        const u32 samples = k + 1 < key_frame_count ? k_segment_samples : 1;
+
+        for ( u32 j = 0; j < samples; ++j ) {
+            const f32 time = j == 0 ? sampler.key_frames[ k ] : sampler.key_frames[ k ] + ( sampler.key_frames[ k + 1 ] - sampler.key_frames[ k ] ) * j / k_segment_samples;
+
+            vec4s source = animation_sampler_evaluate( sampler, time, source_cursor, rotation );
+            if ( rotation ) {
+                source = glms_vec4_normalize( source );
+            }
+            const vec4s compressed = animation_compressed_track_evaluate( track, time, track_cursor );
+
+            max_error = raptor::max( max_error, animation_compression_error( source, compressed, rotation ) );
+        }
+    }
+
+    switch ( target_type ) {
+        case AnimationChannel::TargetType::Translation:
+            stats.max_translation_error = raptor::max( stats.max_translation_error, max_error );
+            break;
+        case AnimationChannel::TargetType::Rotation:
+            stats.max_rotation_error = raptor::max( stats.max_rotation_error, max_error / k_animation_degrees_to_radians );
+            break;
+        default:
+            stats.max_scale_error = raptor::max( stats.max_scale_error, max_error );
+            break;
+    }
+}
+
+void animation_compress( Animation& animation, const AnimationCompressionParameters& parameters, Allocator* allocator, AnimationCompressionStats* stats ) {
+    ZoneScoped;
+
+    for ( u32 c = 0; c < animation.channels.size; ++c ) {
+        const AnimationChannel& channel = animation.channels[ c ];
+        AnimationSampler& sampler = animation.samplers[ channel.sampler ];
+
+        if ( channel.target_type == AnimationChannel::TargetType::Weights || sampler.compressed.key_frame_count > 0 || sampler.key_frames.size == 0 ) {
+            continue;
+        }
+
+        AnimationCompressedTrack track;
+        animation_compress_sampler( sampler, channel.target_type, parameters, allocator, track );
+
+        if ( stats ) {
+            animation_compression_statistics( sampler, channel.target_type, track, *stats );
+        }
+
+        sampler.key_frames.shutdown();
+        rfree( sampler.data, allocator );
+        sampler.data = nullptr;
+        sampler.compressed = track;
+    }
+}
+
+// Benchmark //////////////////////////////////////////////////////////////
+
+static volatile f32 s_animation_compression_benchmark_sink;
+
+// Sample every compressed channel of the scene along its clip, from the source or the compressed key frames.
+static f32 animation_compression_benchmark_sample( const RenderScene& scene, const AnimationCompressedTrack* tracks, u32* cursors, u32 frames, bool compressed ) {
+    f32 sum = 0.f;
+
+    for ( u32 a = 0, offset = 0; a < scene.animations.size; offset += scene.animations[ a ].samplers.size, ++a ) {
+        const Animation& animation = scene.animations[ a ];
+
+        for ( u32 f = 0; f < frames; ++f ) {
+            const f32 time = animation.time_start + ( animation.time_end - animation.time_start ) * f / ( frames - 1 );
+
+            for ( u32 c = 0; c < animation.channels.size; ++c ) {
+                const AnimationChannel& channel = animation.channels[ c ];
+                const u32 s = offset + channel.sampler;
+                if ( tracks[ s ].key_frame_count == 0 ) {
+                    continue;
+                }
+
+                const vec4s value = compressed ? animation_compressed_track_evaluate( tracks[ s ], time, cursors[ s ] )
+                                               : animation_sampler_evaluate( animation.samplers[ channel.sampler ], time, cursors[ s ],
+                                                                             channel.target_type == AnimationChannel::TargetType::Rotation );
+                sum += value.x;
+            }
+        }
+    }
+
+    return sum;
+}
+
+void animation_compression_benchmark( const RenderScene& scene, Allocator* allocator ) {
+    static const u32 k_iterations = 5;
+    static const u32 k_frames = 1000;
+
+    if ( scene.animations.size == 0 ) {
+        rprint( "Animation compression benchmark: the scene has no animations\n" );
+        return;
+    }
+
+    u32 sampler_count = 0;
+    for ( u32 a = 0; a < scene.animations.size; ++a ) {
+        sampler_count += scene.animations[ a ].samplers.size;
+    }
+
+    Array<AnimationCompressedTrack> tracks;
+    tracks.init( allocator, sampler_count, sampler_count );
+    memset( tracks.data, 0, sizeof( AnimationCompressedTrack ) * sampler_count );
+
+    Array<u32> cursors;
+    cursors.init( allocator, sampler_count, sampler_count );
+
+    // Compress copies of the samplers that still have their source key frames.
+    AnimationCompressionParameters parameters;
+    u32 channel_count = 0;
+
+    const i64 begin_time = time_now();
+    for ( u32 a = 0, offset = 0; a < scene.animations.size; offset += scene.animations[ a ].samplers.size, ++a ) {
+        const Animation& animation = scene.animations[ a ];
+
+        for ( u32 c = 0; c < animation.channels.size; ++c ) {
+            const AnimationChannel& channel = animation.channels[ c ];
+            const AnimationSampler& sampler = animation.samplers[ channel.sampler ];
+            AnimationCompressedTrack& track = tracks[ offset + channel.sampler ];
+
+            if ( channel.target_type == AnimationChannel::TargetType::Weights || sampler.compressed.key_frame_count > 0 ) {
+                continue;
+            }
+
+            if ( track.key_frame_count == 0 ) {
+                animation_compress_sampler( sampler, channel.target_type, parameters, allocator, track );
+            }
+            channel_count += track.key_frame_count > 0 ? 1 : 0;
+        }
+    }
+    const f64 compression_ms = time_from_milliseconds( begin_time );
+
+    AnimationCompressionStats stats;
+    for ( u32 a = 0, offset = 0; a < scene.animations.size; offset += scene.animations[ a ].samplers.size, ++a ) {
+        const Animation& animation = scene.animations[ a ];
+
+        for ( u32 s = 0; s < animation.samplers.size; ++s ) {
+            if ( tracks[ offset + s ].key_frame_count == 0 ) {
+                continue;
+            }
+
+            // The target type of a sampler is the one of the first channel using it.
+            for ( u32 c = 0; c < animation.channels.size; ++c ) {
+                if ( animation.channels[ c ].sampler == ( i32 )s ) {
+                    animation_compression_statistics( animation.samplers[ s ], animation.channels[ c ].target_type, tracks[ offset + s ], stats );
+                    break;
+                }
+            }
+        }
+    }
+
+    if ( stats.sampler_count == 0 ) {
+        rprint( "Animation compression benchmark: no source key frames, run without --compress-animations to compare them with the compressed ones\n" );
+    } else {
+        rprint( "Animation compression benchmark, %u animations, %u samplers, %u channels sampled %u times per clip, best of %u runs\n", scene.animations.size,
+                stats.sampler_count, channel_count, k_frames, k_iterations );
+        rprint( "    key frames  source %u, compressed %u (%.1f%%), compressed in %.2f ms\n", stats.source_key_frames, stats.compressed_key_frames,
+                stats.compressed_key_frames * 100.0 / raptor::max( stats.source_key_frames, 1u ), compression_ms );
+        rprint( "    size        source %.1f KB, compressed %.1f KB, ratio %.2f:1\n", stats.source_bytes / 1024.0, stats.compressed_bytes / 1024.0,
+                ( f64 )stats.source_bytes / raptor::max<sizet>( stats.compressed_bytes, 1 ) );
+        rprint( "    max errors  translation %g, rotation %.4f deg, scale %g\n", stats.max_translation_error, stats.max_rotation_error, stats.max_scale_error );
+
+        const f64 samples = ( f64 )channel_count * k_frames;
+
+        f64 source_ms = 1e30, compressed_ms = 1e30;
+        for ( u32 i = 0; i < k_iterations; ++i ) {
+            memset( cursors.data, 0, sizeof( u32 ) * sampler_count );
+            i64 sample_time = time_now();
+            s_animation_compression_benchmark_sink = animation_compression_benchmark_sample( scene, tracks.data, cursors.data, k_frames, false );
+            f64 ms = time_from_milliseconds( sample_time );
+            source_ms = ms < source_ms ? ms : source_ms;
+
+            memset( cursors.data, 0, sizeof( u32 ) * sampler_count );
+            sample_time = time_now();
+            s_animation_compression_benchmark_sink = animation_compression_benchmark_sample( scene, tracks.data, cursors.data, k_frames, true );
+            ms = time_from_milliseconds( sample_time );
+            compressed_ms = ms < compressed_ms ? ms : compressed_ms;
+        }
+
+        rprint( "    sampling    source %8.3f ms, %7.1f M samples/s   compressed %8.3f ms, %7.1f M samples/s\n", source_ms, samples / ( source_ms * 1e3 ),
+                compressed_ms, samples / ( compressed_ms * 1e3 ) );
+    }
+
+    for ( u32 s = 0; s < sampler_count; ++s ) {
+        animation_compressed_track_shutdown( tracks[ s ], allocator );
+    }
+    tracks.shutdown();
+    cursors.shutdown();
+}
+
+} // namespace raptor
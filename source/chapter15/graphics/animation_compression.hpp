@@ -0,0 +1,62 @@
+#pragma once
+
+#include "graphics/render_scene.hpp"
+
+namespace raptor {
+
+    // Animation compression //////////////////////////////////////////////
+    //
+    // Samplers are resampled as linear curves, cubic splines with a few key frames per segment, then
+    // key frames that can be interpolated from their neighbours within the error tolerance are removed.
+    // The remaining ones are stored in an AnimationCompressedTrack: 8 bytes per key frame instead of
+    // 20, or 52 for cubic splines. Tolerances include the quantization error, they bound the error
+    // at the source key frames.
+
+    // Rotations store the three smallest components, within +-1/sqrt(2), as 15 bits each.
+    static const f32            k_animation_quaternion_range    = 0.70710678f;
+    static const f32            k_animation_quaternion_steps    = 32766.f;  // Even, so that 0 is exact.
+
+    //
+    //
+    struct AnimationCompressionParameters {
+        f32                     translation_error   = 0.0001f;  // Scene units.
+        f32                     rotation_error      = 0.05f;    // Degrees.
+        f32                     scale_error         = 0.0001f;
+        u32                     cubic_samples       = 4;        // Linear key frames per cubic spline segment, before reduction.
+    }; // struct AnimationCompressionParameters
+
+    //
+    //
+    struct AnimationCompressionStats {
+        u32                     sampler_count       = 0;
+        u32                     source_key_frames   = 0;
+        u32                     compressed_key_frames = 0;
+
+        sizet                   source_bytes        = 0;    // Key frames and values.
+        sizet                   compressed_bytes    = 0;
+
+        f32                     max_translation_error = 0.f;    // Scene units, sampled between key frames too.
+        f32                     max_rotation_error  = 0.f;      // Degrees.
+        f32                     max_scale_error     = 0.f;
+    }; // struct AnimationCompressionStats
+
+    // Compress a sampler targeting translations, rotations or scales, the source key frames are not changed.
+    void                        animation_compress_sampler( const AnimationSampler& sampler, AnimationChannel::TargetType target_type,
+                                                            const AnimationCompressionParameters& parameters, Allocator* allocator,
+                                                            AnimationCompressedTrack& track );
+    void                        animation_compressed_track_shutdown( AnimationCompressedTrack& track, Allocator* allocator );
+
+    // Compare a compressed track with its source sampler: sizes, and errors at the source key frames and between them.
+    void                        animation_compression_statistics( const AnimationSampler& sampler, AnimationChannel::TargetType target_type,
+                                                                  const AnimationCompressedTrack& track, AnimationCompressionStats& stats );
+
+    // Compress the samplers of the translation, rotation and scale channels in place, freeing their
+    // source key frames, allocated with allocator. Morph target weights are kept. Statistics are accumulated if given.
+    void                        animation_compress( Animation& animation, const AnimationCompressionParameters& parameters, Allocator* allocator,
+                                                    AnimationCompressionStats* stats );
+
+    // Compress the scene animations, print sizes and errors, then time sampling every channel along the
+    // clips from the source and compressed key frames.
+    void                        animation_compression_benchmark( const RenderScene& scene, Allocator* allocator );
+
+} // namespace raptor
@@ -1,221 +1,604 @@
 #include "graphics/asynchronous_loader.hpp"
 #include "graphics/renderer.hpp"
+#include "graphics/texture_cooker.hpp"
+#include "graphics/texture_mips.hpp"
 
+#include "foundation/hash_map.hpp"
 #include "foundation/time.hpp"
 
 #include "external/stb_image.h"
 
 #include "external/tracy/tracy/Tracy.hpp"
 
+#include <stdlib.h>
+
 namespace raptor
 {
-// AsynchonousLoader //////////////////////////////////////////////////////
 
-void AsynchronousLoader::init( Renderer* renderer_, enki::TaskScheduler* task_scheduler_, Allocator* resident_allocator ) {
-    renderer = renderer_;
-    task_scheduler = task_scheduler_;
-    allocator = resident_allocator;
+static const sizet          k_staging_alignment         = 64;
+
+// TextureLoad ////////////////////////////////////////////////////////////
+
+void TextureLoad::ExecuteRange( enki::TaskSetPartition range_, uint32_t threadnum_ ) {
+    ZoneScoped;
+
+    pixels = nullptr;
+    data_size = 0;
+    cooked = false;
+    if ( future.wait() ) {
+        CookedTexture cooked_texture;
+        if ( dds_read( ( const u8* )future.file.data, future.file.size, &cooked_texture ) ) {
+            // Blocks and mips are uploaded as they are stored, the file is unmapped once packed.
+            pixels = ( u8* )cooked_texture.data;
+            data_size = cooked_texture.data_size;
+            width = ( i32 )cooked_texture.width;
+            height = ( i32 )cooked_texture.height;
+            mip_levels = cooked_texture.mip_levels;
+            cooked = true;
+            return;
+        }
 
-    file_load_requests.init( allocator, 16 );
-    upload_requests.init( allocator, 16 );
+        int comp;
+        pixels = stbi_load_from_memory( ( const stbi_uc* )future.file.data, ( int )future.file.size, &width, &height, &comp, 4 );
+        data_size = ( sizet )width * height * 4;
+        file_unmap( &future.file );
+
+        if ( pixels && mip_levels > 1 ) {
+            // Grow the decoded image to hold the whole chain, stb_image allocates with malloc. The gpu then only copies.
+            const sizet chain_size = texture_mip_chain_size( width, height, mip_levels );
+            u8* chain = ( u8* )realloc( pixels, chain_size );
+            if ( chain ) {
+                texture_generate_mip_chain( chain, width, height, mip_levels, mip_flags, alpha_cutoff, TextureMipFilter::Box, nullptr );
+
+                pixels = chain;
+                data_size = chain_size;
+            }
+            else {
+                mip_levels = 1;
+            }
+        }
+    }
+}
 
-    texture_ready.index = k_invalid_texture.index;
-    cpu_buffer_ready.index = k_invalid_buffer.index;
-    gpu_buffer_ready.index = k_invalid_buffer.index;
+void TextureLoad::release_pixels() {
+    if ( cooked ) {
+        file_unmap( &future.file );
+        cooked = false;
+    }
+    else if ( pixels ) {
+        stbi_image_free( pixels );
+    }
+    pixels = nullptr;
+}
 
-    using namespace raptor;
+// VulkanTransferQueue ////////////////////////////////////////////////////
+
+void VulkanTransferQueue::init( Renderer* renderer_, sizet staging_size ) {
+    renderer = renderer_;
+
+    GpuDevice* gpu = renderer->gpu;
 
     // Create a persistently-mapped staging buffer
     BufferCreation bc;
-    bc.reset().set( VK_BUFFER_USAGE_TRANSFER_SRC_BIT, ResourceUsageType::Stream, rmega( 64 ) ).set_name( "staging_buffer" ).set_persistent( true );
-    BufferHandle staging_buffer_handle = renderer->gpu->create_buffer( bc );
+    bc.reset().set( VK_BUFFER_USAGE_TRANSFER_SRC_BIT, ResourceUsageType::Stream, ( u32 )staging_size ).set_name( "staging_buffer" ).set_persistent( true );
+    BufferHandle staging_buffer_handle = gpu->create_buffer( bc );
 
-    staging_buffer = renderer->gpu->access_buffer( staging_buffer_handle );
+    staging_buffer = gpu->access_buffer( staging_buffer_handle );
 
-    staging_buffer_offset = 0;
-
-    for ( u32 i = 0; i < k_max_frames; ++i) {
+    for ( u32 i = 0; i < k_max_transfer_batches; ++i ) {
         VkCommandPoolCreateInfo cmd_pool_info = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO, nullptr };
-        cmd_pool_info.queueFamilyIndex = renderer->gpu->vulkan_transfer_queue_family;
+        cmd_pool_info.queueFamilyIndex = gpu->vulkan_transfer_queue_family;
         cmd_pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
-        vkCreateCommandPool( renderer->gpu->vulkan_device, &cmd_pool_info, renderer->gpu->vulkan_allocation_callbacks, &command_pools[i]);
+        vkCreateCommandPool( gpu->vulkan_device, &cmd_pool_info, gpu->vulkan_allocation_callbacks, &command_pools[ i ] );
 
         VkCommandBufferAllocateInfo cmd = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO, nullptr };
-        cmd.commandPool = command_pools[i];
+        cmd.commandPool = command_pools[ i ];
         cmd.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
         cmd.commandBufferCount = 1;
 
-        vkAllocateCommandBuffers( renderer->gpu->vulkan_device, &cmd, &command_buffers[i].vk_command_buffer );
+        vkAllocateCommandBuffers( gpu->vulkan_device, &cmd, &command_buffers[ i ].vk_command_buffer );
 
         command_buffers[ i ].is_recording = false;
-        command_buffers[ i ].gpu_device = ( renderer->gpu );
+        command_buffers[ i ].gpu_device = gpu;
+
+        batch_timeline_values[ i ] = 0;
+        batch_fences[ i ] = VK_NULL_HANDLE;
     }
 
-    VkSemaphoreCreateInfo semaphore_info{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
-    vkCreateSemaphore( renderer->gpu->vulkan_device, &semaphore_info, renderer->gpu->vulkan_allocation_callbacks, &transfer_complete_semaphore );
+    if ( gpu->timeline_semaphore_extension_present ) {
+        VkSemaphoreTypeCreateInfo semaphore_type_info{ VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO };
+        semaphore_type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        semaphore_type_info.initialValue = 0;
+
+        VkSemaphoreCreateInfo semaphore_info{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+        semaphore_info.pNext = &semaphore_type_info;
+        vkCreateSemaphore( gpu->vulkan_device, &semaphore_info, gpu->vulkan_allocation_callbacks, &timeline_semaphore );
+
+        timeline_value = 0;
+    } else {
+        VkFenceCreateInfo fence_info{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+        fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        for ( u32 i = 0; i < k_max_transfer_batches; ++i ) {
+            vkCreateFence( gpu->vulkan_device, &fence_info, gpu->vulkan_allocation_callbacks, &batch_fences[ i ] );
+        }
+    }
 
-    VkFenceCreateInfo fence_info{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
-    fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-    vkCreateFence( renderer->gpu->vulkan_device, &fence_info, renderer->gpu->vulkan_allocation_callbacks, &transfer_fence );
+    last_submit_frame = u64_max;
 }
 
-void AsynchronousLoader::shutdown() {
+void VulkanTransferQueue::shutdown() {
+    GpuDevice* gpu = renderer->gpu;
 
-    renderer->gpu->destroy_buffer( staging_buffer->handle );
+    gpu->destroy_buffer( staging_buffer->handle );
 
-    file_load_requests.shutdown();
-    upload_requests.shutdown();
-
-    for ( u32 i = 0; i < k_max_frames; ++i ) {
-        vkDestroyCommandPool( renderer->gpu->vulkan_device, command_pools[ i ], renderer->gpu->vulkan_allocation_callbacks );
+    for ( u32 i = 0; i < k_max_transfer_batches; ++i ) {
+        vkDestroyCommandPool( gpu->vulkan_device, command_pools[ i ], gpu->vulkan_allocation_callbacks );
         // Command buffers are destroyed with the pool associated.
+
+        if ( batch_fences[ i ] != VK_NULL_HANDLE ) {
+            vkDestroyFence( gpu->vulkan_device, batch_fences[ i ], gpu->vulkan_allocation_callbacks );
+        }
     }
 
-    vkDestroySemaphore( renderer->gpu->vulkan_device, transfer_complete_semaphore, renderer->gpu->vulkan_allocation_callbacks );
-    vkDestroyFence( renderer->gpu->vulkan_device, transfer_fence, renderer->gpu->vulkan_allocation_callbacks );
+    if ( timeline_semaphore != VK_NULL_HANDLE ) {
+        vkDestroySemaphore( gpu->vulkan_device, timeline_semaphore, gpu->vulkan_allocation_callbacks );
+    }
 }
 
-void AsynchronousLoader::update( Allocator* scratch_allocator ) {
-    using namespace raptor;
+u8* VulkanTransferQueue::staging_memory() {
+    return ( u8* )staging_buffer->mapped_data;
+}
+
+sizet VulkanTransferQueue::staging_size() {
+    return staging_buffer->size;
+}
+
+bool VulkanTransferQueue::can_submit() {
+    // A single transfer submit per frame.
+    return renderer->gpu->absolute_frame != last_submit_frame;
+}
+
+void VulkanTransferQueue::begin( u32 batch ) {
+    if ( batch_fences[ batch ] != VK_NULL_HANDLE ) {
+        vkResetFences( renderer->gpu->vulkan_device, 1, &batch_fences[ batch ] );
+    }
+
+    command_buffers[ batch ].begin();
+}
+
+void VulkanTransferQueue::copy_texture( u32 batch, TextureHandle texture, sizet staging_offset, sizet size, u32 mip_levels ) {
+    // Data is already in the staging buffer.
+    Texture* gpu_texture = renderer->gpu->access_texture( texture );
+    if ( TextureFormat::is_block_compressed( gpu_texture->vk_format ) || mip_levels > 1 ) {
+        RASSERTM( mip_levels == gpu_texture->mip_level_count, "Texture mip chain does not match the uploaded data" );
+        command_buffers[ batch ].upload_texture_mips( texture, staging_buffer->handle, staging_offset );
+    }
+    else {
+        command_buffers[ batch ].upload_texture_data( texture, nullptr, staging_buffer->handle, staging_offset );
+    }
+}
+
+void VulkanTransferQueue::copy_buffer( u32 batch, BufferHandle buffer, sizet staging_offset, sizet size ) {
+    command_buffers[ batch ].upload_buffer_data( buffer, nullptr, staging_buffer->handle, staging_offset );
+}
+
+void VulkanTransferQueue::copy_buffer( u32 batch, BufferHandle src, BufferHandle dst ) {
+    command_buffers[ batch ].upload_buffer_data( src, dst );
+}
+
+void VulkanTransferQueue::submit( u32 batch ) {
+    ZoneScoped;
 
-    // If a texture was processed in the previous commands, signal the renderer
-    if ( texture_ready.index != k_invalid_texture.index ) {
-        // Add update request.
-        // This method is multithreaded_safe
-        renderer->add_texture_to_update( texture_ready );
+    CommandBuffer* cb = &command_buffers[ batch ];
+    cb->end();
+
+    VkSubmitInfo submit_info = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &cb->vk_command_buffer;
+
+    VkQueue used_queue = renderer->gpu->vulkan_transfer_queue;
+
+    if ( timeline_semaphore != VK_NULL_HANDLE ) {
+        batch_timeline_values[ batch ] = ++timeline_value;
+
+        VkTimelineSemaphoreSubmitInfo semaphore_info{ VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO };
+        semaphore_info.signalSemaphoreValueCount = 1;
+        semaphore_info.pSignalSemaphoreValues = &batch_timeline_values[ batch ];
+
+        submit_info.signalSemaphoreCount = 1;
+        submit_info.pSignalSemaphores = &timeline_semaphore;
+        submit_info.pNext = &semaphore_info;
+
+        vkQueueSubmit( used_queue, 1, &submit_info, VK_NULL_HANDLE );
+    } else {
+        vkQueueSubmit( used_queue, 1, &submit_info, batch_fences[ batch ] );
+    }
+
+    last_submit_frame = renderer->gpu->absolute_frame;
+}
+
+bool VulkanTransferQueue::is_complete( u32 batch ) {
+    if ( timeline_semaphore != VK_NULL_HANDLE ) {
+        u64 completed_value = 0;
+        vkGetSemaphoreCounterValue( renderer->gpu->vulkan_device, timeline_semaphore, &completed_value );
+        return completed_value >= batch_timeline_values[ batch ];
+    }
+
+    return vkGetFenceStatus( renderer->gpu->vulkan_device, batch_fences[ batch ] ) == VK_SUCCESS;
+}
+
+void VulkanTransferQueue::wait( u32 batch ) {
+    if ( timeline_semaphore != VK_NULL_HANDLE ) {
+        VkSemaphoreWaitInfo semaphore_wait_info{ VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO };
+        semaphore_wait_info.semaphoreCount = 1;
+        semaphore_wait_info.pSemaphores = &timeline_semaphore;
+        semaphore_wait_info.pValues = &batch_timeline_values[ batch ];
+
+        vkWaitSemaphores( renderer->gpu->vulkan_device, &semaphore_wait_info, ~0ull );
+    } else {
+        vkWaitForFences( renderer->gpu->vulkan_device, 1, &batch_fences[ batch ], VK_TRUE, ~0ull );
     }
+}
 
-    if ( cpu_buffer_ready.index != k_invalid_buffer.index && gpu_buffer_ready.index != k_invalid_buffer.index ) {
-        // TODO(marco): free cpu buffer
-        renderer->gpu->destroy_buffer( cpu_buffer_ready );
+void VulkanTransferQueue::complete( const UploadRequest& request ) {
+    if ( request.texture.index != k_invalid_texture.index ) {
+        // Signal the renderer, this method is multithreaded_safe
+        renderer->add_texture_to_update( request.texture );
+    }
+    else if ( request.cpu_buffer.index != k_invalid_buffer.index && request.gpu_buffer.index != k_invalid_buffer.index ) {
+        renderer->gpu->destroy_buffer( request.cpu_buffer );
 
-        Buffer* buffer = renderer->gpu->access_buffer( gpu_buffer_ready );
+        Buffer* buffer = renderer->gpu->access_buffer( request.gpu_buffer );
         buffer->ready = true;
+    }
+}
+
+// CpuTransferQueue ///////////////////////////////////////////////////////
+
+void CpuTransferQueue::init( Allocator* allocator_, sizet staging_size, sizet destination_size ) {
+    allocator = allocator_;
+
+    staging = ( u8* )rallocaa( staging_size, allocator, k_staging_alignment );
+    destination = ( u8* )rallocaa( destination_size, allocator, k_staging_alignment );
+    staging_capacity = staging_size;
+    destination_capacity = destination_size;
+
+    bytes_copied = 0;
+    textures_completed = 0;
+    submits = 0;
+}
+
+void CpuTransferQueue::shutdown() {
+    rfree( staging, allocator );
+    rfree( destination, allocator );
+}
 
-        gpu_buffer_ready.index = k_invalid_buffer.index;
-        cpu_buffer_ready.index = k_invalid_buffer.index;
+u8* CpuTransferQueue::staging_memory() {
+    return staging;
+}
+
+sizet CpuTransferQueue::staging_size() {
+    return staging_capacity;
+}
+
+bool CpuTransferQueue::can_submit() {
+    return true;
+}
+
+void CpuTransferQueue::begin( u32 batch ) {
+}
+
+void CpuTransferQueue::copy_texture( u32 batch, TextureHandle texture, sizet staging_offset, sizet size, u32 mip_levels ) {
+    // Stand-in for the copy engine reading the staging memory.
+    memcpy( destination, staging + staging_offset, size < destination_capacity ? size : destination_capacity );
+    bytes_copied += size;
+}
+
+void CpuTransferQueue::copy_buffer( u32 batch, BufferHandle buffer, sizet staging_offset, sizet size ) {
+    memcpy( destination, staging + staging_offset, size < destination_capacity ? size : destination_capacity );
+    bytes_copied += size;
+}
+
+void CpuTransferQueue::copy_buffer( u32 batch, BufferHandle src, BufferHandle dst ) {
+}
+
+void CpuTransferQueue::submit( u32 batch ) {
+    ++submits;
+}
+
+bool CpuTransferQueue::is_complete( u32 batch ) {
+    return true;
+}
+
+void CpuTransferQueue::wait( u32 batch ) {
+}
+
+void CpuTransferQueue::complete( const UploadRequest& request ) {
+    if ( request.texture.index != k_invalid_texture.index ) {
+        ++textures_completed;
     }
+}
+
+// AsynchonousLoader //////////////////////////////////////////////////////
 
-    texture_ready.index = k_invalid_texture.index;
+void AsynchronousLoader::init( Renderer* renderer_, enki::TaskScheduler* task_scheduler_, Allocator* resident_allocator ) {
 
-    // Process upload requests
-    if ( upload_requests.size ) {
-        ZoneScoped;
+    vulkan_transfer_queue.init( renderer_, rmega( 64 ) );
 
-        // Wait for transfer fence to be finished
-        if ( vkGetFenceStatus( renderer->gpu->vulkan_device, transfer_fence ) != VK_SUCCESS ) {
-            return;
+    init( &vulkan_transfer_queue, task_scheduler_, resident_allocator );
+    renderer = renderer_;
+}
+
+void AsynchronousLoader::init( TransferQueue* transfer_queue_, enki::TaskScheduler* task_scheduler_, Allocator* resident_allocator ) {
+    renderer = nullptr;
+    transfer_queue = transfer_queue_;
+    task_scheduler = task_scheduler_;
+    allocator = resident_allocator;
+
+    file_load_requests.init( allocator, 16 );
+    upload_requests.init( allocator, 16 );
+
+    file_reader.init( allocator, 2 );
+    for ( u32 i = 0; i < k_max_texture_loads; ++i ) {
+        texture_loads[ i ].state = TextureLoad::State_Free;
+    }
+    texture_loads_count = 0;
+
+    staging_ring.init( transfer_queue->staging_size(), "Staging buffer" );
+    submitted_batches = 0;
+
+    batches_head = 0;
+    batches_count = 0;
+
+    requested_texture_paths.init( rkilo( 64 ), allocator );
+}
+
+void AsynchronousLoader::shutdown() {
+
+    for ( u32 i = 0; i < k_max_texture_loads; ++i ) {
+        TextureLoad& load = texture_loads[ i ];
+        if ( load.state == TextureLoad::State_Reading ) {
+            if ( load.future.wait() ) {
+                file_unmap( &load.future.file );
+            }
         }
-        // Reset if file requests are present.
-        vkResetFences( renderer->gpu->vulkan_device, 1, &transfer_fence );
+        else if ( load.state == TextureLoad::State_Decoding ) {
+            task_scheduler->WaitforTask( &load );
+            load.release_pixels();
+        }
+        load.state = TextureLoad::State_Free;
+    }
+    texture_loads_count = 0;
 
-        // Get last request
-        UploadRequest request = upload_requests.back();
-        upload_requests.pop();
+    file_reader.shutdown();
 
-        CommandBuffer* cb = &command_buffers[ renderer->gpu->current_frame ];
-        cb->begin();
+    // Transfers in flight read from the staging memory.
+    for ( ; batches_count; --batches_count ) {
+        transfer_queue->wait( batches_head );
+        batches[ batches_head ].num_requests = 0;
+        batches_head = ( batches_head + 1 ) % k_max_transfer_batches;
+    }
 
-        if ( request.texture.index != k_invalid_texture.index ) {
-            Texture* texture = renderer->gpu->access_texture( request.texture );
-            const u32 k_texture_channels = 4;
-            const u32 k_texture_alignment = 4;
-            const sizet aligned_image_size = memory_align( texture->width * texture->height * k_texture_channels, k_texture_alignment );
-            // Request place in buffer
-            const sizet current_offset = std::atomic_fetch_add( &staging_buffer_offset, aligned_image_size );
+    for ( u32 i = 0; i < upload_requests.size; ++i ) {
+        if ( upload_requests[ i ].data ) {
+            free( upload_requests[ i ].data );
+        }
+    }
 
-            cb->upload_texture_data( texture->handle, request.data, staging_buffer->handle, current_offset );
+    file_load_requests.shutdown();
+    upload_requests.shutdown();
 
-            free( request.data );
+    requested_texture_paths.shutdown();
+
+    if ( transfer_queue == &vulkan_transfer_queue ) {
+        vulkan_transfer_queue.shutdown();
+    }
+}
+
+void AsynchronousLoader::update( Allocator* scratch_allocator ) {
+    using namespace raptor;
+
+    // Retire completed batches in submission order, releasing their staging memory.
+    while ( batches_count && transfer_queue->is_complete( batches_head ) ) {
+        TransferBatch& batch = batches[ batches_head ];
+        for ( u32 i = 0; i < batch.num_requests; ++i ) {
+            transfer_queue->complete( batch.requests[ i ] );
         }
-        else if ( request.cpu_buffer.index != k_invalid_buffer.index && request.gpu_buffer.index != k_invalid_buffer.index ) {
-            Buffer* src = renderer->gpu->access_buffer( request.cpu_buffer );
-            Buffer* dst = renderer->gpu->access_buffer( request.gpu_buffer );
 
-            cb->upload_buffer_data( src->handle, dst->handle );
+        staging_ring.release( batch.ring_value );
+        batch.num_requests = 0;
+
+        batches_head = ( batches_head + 1 ) % k_max_transfer_batches;
+        --batches_count;
+    }
+
+    // Start reading files while there are free loads.
+    for ( u32 i = 0; i < k_max_texture_loads && file_load_requests.size; ++i ) {
+        TextureLoad& load = texture_loads[ i ];
+        if ( load.state != TextureLoad::State_Free ) {
+            continue;
         }
-        else if ( request.cpu_buffer.index != k_invalid_buffer.index ) {
-            Buffer* buffer = renderer->gpu->access_buffer( request.cpu_buffer );
-            // TODO: proper alignment
-            const sizet aligned_image_size = memory_align( buffer->size, 64 );
-            const sizet current_offset = std::atomic_fetch_add( &staging_buffer_offset, aligned_image_size );
-            cb->upload_buffer_data( buffer->handle, request.data, staging_buffer->handle, current_offset );
 
-            free( request.data );
+        FileLoadRequest load_request = file_load_requests.back();
+        file_load_requests.pop();
+
+        load.texture = load_request.texture;
+        load.pixels = nullptr;
+        load.mip_levels = load_request.mip_levels;
+        load.mip_flags = load_request.mip_flags;
+        load.alpha_cutoff = load_request.alpha_cutoff;
+        load.start_time = time_now();
+        load.state = TextureLoad::State_Reading;
+        ++texture_loads_count;
+
+        file_reader.read( load_request.path, FileMapFlags_Sequential, &load.future );
+    }
+
+    // Decode read files on the task threads.
+    for ( u32 i = 0; i < k_max_texture_loads; ++i ) {
+        TextureLoad& load = texture_loads[ i ];
+        if ( load.state == TextureLoad::State_Reading && load.future.is_ready() ) {
+            load.state = TextureLoad::State_Decoding;
+            task_scheduler->AddTaskSetToPipe( &load );
+        }
+    }
+
+    u32 submitted_requests = 0;
+    if ( batches_count < k_max_transfer_batches && transfer_queue->can_submit() ) {
+        submitted_requests = submit_uploads();
+    }
+
+    // Help decoding instead of spinning when there is nothing to upload yet.
+    if ( submitted_requests == 0 ) {
+        for ( u32 i = 0; i < k_max_texture_loads; ++i ) {
+            TextureLoad& load = texture_loads[ i ];
+            if ( load.state == TextureLoad::State_Decoding && !load.GetIsComplete() ) {
+                task_scheduler->WaitforTask( &load );
+                break;
+            }
+        }
+    }
+}
+
+u32 AsynchronousLoader::submit_uploads() {
+    // Pack decoded textures and uploads into the staging ring, all recorded into one batch.
+    const u32 batch_index = ( batches_head + batches_count ) % k_max_transfer_batches;
+    TransferBatch& batch = batches[ batch_index ];
+    u8* staging_memory = transfer_queue->staging_memory();
+    bool staging_full = false;
+
+    for ( u32 i = 0; i < k_max_texture_loads && batch.num_requests < TransferBatch::k_max_requests; ++i ) {
+        TextureLoad& load = texture_loads[ i ];
+        if ( load.state != TextureLoad::State_Decoding || !load.GetIsComplete() ) {
+            continue;
         }
 
-        cb->end();
+        if ( !load.pixels ) {
+            rprint( "Error reading file %s\n", load.future.path );
 
-        VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &cb->vk_command_buffer;
-        VkPipelineStageFlags wait_flag[] { VK_PIPELINE_STAGE_TRANSFER_BIT };
-        VkSemaphore wait_semaphore[] { transfer_complete_semaphore };
-        submitInfo.pWaitSemaphores = wait_semaphore;
-        submitInfo.pWaitDstStageMask = wait_flag;
+            load.state = TextureLoad::State_Free;
+            --texture_loads_count;
+            continue;
+        }
 
-        VkQueue used_queue = renderer->gpu->vulkan_transfer_queue;
-        vkQueueSubmit( used_queue, 1, &submitInfo, transfer_fence );
+        const sizet image_size = load.data_size;
+        if ( image_size > staging_ring.offsets.size ) {
+            rprint( "Texture %s is too big for the staging buffer, %llu bytes\n", load.future.path, ( u64 )image_size );
 
-        // TODO(marco): better management for state machine. We need to account for file -> buffer,
-        // buffer -> texture and buffer -> buffer. One the CPU buffer has been used it should be freed.
-        if ( request.texture.index != k_invalid_index ) {
-            RASSERT( texture_ready.index == k_invalid_texture.index );
-            texture_ready = request.texture;
+            load.release_pixels();
+            load.state = TextureLoad::State_Free;
+            --texture_loads_count;
+            continue;
         }
-        else if ( request.cpu_buffer.index != k_invalid_buffer.index && request.gpu_buffer.index != k_invalid_buffer.index ) {
-            RASSERT( cpu_buffer_ready.index == k_invalid_index );
-            RASSERT( gpu_buffer_ready.index == k_invalid_index );
 
-            cpu_buffer_ready = request.cpu_buffer;
-            gpu_buffer_ready = request.gpu_buffer;
+        const sizet staging_offset = staging_ring.allocate( image_size, k_staging_alignment );
+        if ( staging_offset == k_ring_invalid_offset ) {
+            staging_full = true;
+            break;
         }
-        else if ( request.cpu_buffer.index != k_invalid_index ) {
-            RASSERT( cpu_buffer_ready.index == k_invalid_index );
-            cpu_buffer_ready = request.cpu_buffer;
+
+        if ( batch.num_requests == 0 ) {
+            transfer_queue->begin( batch_index );
         }
+
+        ZoneScopedN( "PackTexture" );
+
+        memcpy( staging_memory + staging_offset, load.pixels, image_size );
+        load.release_pixels();
+
+        transfer_queue->copy_texture( batch_index, load.texture, staging_offset, image_size, load.mip_levels );
+
+        UploadRequest& request = batch.requests[ batch.num_requests++ ];
+        request.data = nullptr;
+        request.size = image_size;
+        request.texture = load.texture;
+        request.cpu_buffer = k_invalid_buffer;
+        request.gpu_buffer = k_invalid_buffer;
+
+        rprint( "File %s read in %f ms\n", load.future.path, time_from_milliseconds( load.start_time ) );
+
+        load.state = TextureLoad::State_Free;
+        --texture_loads_count;
     }
 
-    // Process a file request
-    if ( file_load_requests.size ) {
-        FileLoadRequest load_request = file_load_requests.back();
-        file_load_requests.pop();
+    while ( upload_requests.size && !staging_full && batch.num_requests < TransferBatch::k_max_requests ) {
+        UploadRequest request = upload_requests.back();
 
-        i64 start_reading_file = time_now();
-        // Process request
-        int x, y, comp;
-        u8* texture_data = stbi_load( load_request.path, &x, &y, &comp, 4 );
+        sizet staging_offset = 0;
+        if ( request.data ) {
+            staging_offset = staging_ring.allocate( request.size, k_staging_alignment );
+            if ( staging_offset == k_ring_invalid_offset ) {
+                break;
+            }
+        }
 
-        if ( texture_data ) {
-            rprint( "File %s read in %f ms\n", load_request.path, time_from_milliseconds( start_reading_file ) );
+        upload_requests.pop();
 
-            UploadRequest& upload_request = upload_requests.push_use();
-            upload_request.data = texture_data;
-            upload_request.texture = load_request.texture;
-            upload_request.cpu_buffer = k_invalid_buffer;
+        if ( batch.num_requests == 0 ) {
+            transfer_queue->begin( batch_index );
+        }
+
+        if ( request.data ) {
+            memcpy( staging_memory + staging_offset, request.data, request.size );
+            free( request.data );
+            request.data = nullptr;
+
+            transfer_queue->copy_buffer( batch_index, request.cpu_buffer, staging_offset, request.size );
         }
         else {
-            rprint( "Error reading file %s\n", load_request.path );
+            transfer_queue->copy_buffer( batch_index, request.cpu_buffer, request.gpu_buffer );
         }
+
+        batch.requests[ batch.num_requests++ ] = request;
     }
 
-    staging_buffer_offset = 0;
+    if ( batch.num_requests ) {
+        batch.ring_value = ++submitted_batches;
+        staging_ring.retire( batch.ring_value );
+        staging_ring.plot_statistics();
+        transfer_queue->submit( batch_index );
+        ++batches_count;
+    }
+
+    return batch.num_requests;
+}
+
+bool AsynchronousLoader::is_idle() const {
+    return file_load_requests.size == 0 && upload_requests.size == 0 && texture_loads_count == 0 && batches_count == 0;
 }
 
-void AsynchronousLoader::request_texture_data( cstring filename, TextureHandle texture ) {
+void AsynchronousLoader::request_texture_data( cstring filename, TextureHandle texture, u32 mip_levels, u32 mip_flags, f32 alpha_cutoff ) {
 
     FileLoadRequest& request = file_load_requests.push_use();
     strcpy( request.path, filename );
     request.texture = texture;
     request.buffer = k_invalid_buffer;
+    request.mip_levels = mip_levels;
+    request.mip_flags = mip_flags;
+    request.alpha_cutoff = alpha_cutoff;
+
+    if ( requested_texture_paths.current_size + strlen( filename ) + 1 <= requested_texture_paths.buffer_size ) {
+        requested_texture_paths.intern( filename );
+    }
 }
 
 void AsynchronousLoader::request_buffer_upload( void* data, BufferHandle buffer ) {
 
+    Buffer* cpu_buffer = renderer->gpu->access_buffer( buffer );
+    // Same as textures: it would never fit in the staging ring and be retried forever.
+    if ( cpu_buffer->size > staging_ring.offsets.size ) {
+        rprint( "Buffer %s is too big for the staging buffer, %u bytes\n", cpu_buffer->name ? cpu_buffer->name : "", cpu_buffer->size );
+
+        free( data );
+        return;
+    }
+
     UploadRequest& upload_request = upload_requests.push_use();
     upload_request.data = data;
+    upload_request.size = cpu_buffer->size;
     upload_request.cpu_buffer = buffer;
+    upload_request.gpu_buffer = k_invalid_buffer;
     upload_request.texture = k_invalid_texture;
 }
 
@@ -223,6 +606,7 @@ void AsynchronousLoader::request_buffer_copy( BufferHandle src, BufferHandle dst
 
     UploadRequest& upload_request = upload_requests.push_use();
     upload_request.data = nullptr;
+    upload_request.size = 0;
     upload_request.cpu_buffer = src;
     upload_request.gpu_buffer = dst;
     upload_request.texture = k_invalid_texture;
@@ -231,4 +615,70 @@ void AsynchronousLoader::request_buffer_copy( BufferHandle src, BufferHandle dst
     buffer->ready = false;
 }
 
+// Benchmark //////////////////////////////////////////////////////////////
+
+void asynchronous_loader_benchmark( StringArray& texture_paths, enki::TaskScheduler* task_scheduler, Allocator* allocator ) {
+    const u32 num_textures = ( u32 )texture_paths.get_string_count();
+    if ( num_textures == 0 ) {
+        rprint( "Asynchronous loader benchmark: no texture requested, load a scene first\n" );
+        return;
+    }
+
+    // Serial baseline, read and decode on the calling thread.
+    u64 serial_bytes = 0;
+    i64 begin_time = time_now();
+
+    FlatHashMapIterator* it = texture_paths.begin_string_iteration();
+    while ( texture_paths.has_next_string( it ) ) {
+        cstring path = texture_paths.get_next_string( it );
+
+        MappedFile file;
+        if ( !file_map( path, &file, FileMapFlags_Sequential ) ) {
+            continue;
+        }
+
+        int width, height, comp;
+        u8* pixels = stbi_load_from_memory( ( const stbi_uc* )file.data, ( int )file.size, &width, &height, &comp, 4 );
+        if ( pixels ) {
+            serial_bytes += ( u64 )width * height * 4;
+            stbi_image_free( pixels );
+        }
+        file_unmap( &file );
+    }
+
+    const f64 serial_seconds = time_from_seconds( begin_time );
+
+    // Pipelined loader, uploading into a CPU stand-in for the transfer queue.
+    CpuTransferQueue cpu_transfer_queue;
+    cpu_transfer_queue.init( allocator, rmega( 64 ), rmega( 64 ) );
+
+    AsynchronousLoader loader;
+    loader.init( &cpu_transfer_queue, task_scheduler, allocator );
+
+    begin_time = time_now();
+
+    u32 texture_index = 0;
+    it = texture_paths.begin_string_iteration();
+    while ( texture_paths.has_next_string( it ) ) {
+        loader.request_texture_data( texture_paths.get_next_string( it ), { texture_index++ } );
+    }
+
+    while ( !loader.is_idle() ) {
+        loader.update( nullptr );
+    }
+
+    const f64 loader_seconds = time_from_seconds( begin_time );
+
+    rprint( "Asynchronous loader benchmark, %u textures, %u task threads\n", num_textures, task_scheduler->GetNumTaskThreads() );
+    rprint( "    serial read + decode  : %8.3f s, %8.1f textures/s, %8.1f MB/s\n", serial_seconds,
+            num_textures / serial_seconds, serial_bytes / ( 1024.0 * 1024.0 ) / serial_seconds );
+    rprint( "    pipelined loader      : %8.3f s, %8.1f textures/s, %8.1f MB/s, %u submits\n", loader_seconds,
+            cpu_transfer_queue.textures_completed / loader_seconds, cpu_transfer_queue.bytes_copied / ( 1024.0 * 1024.0 ) / loader_seconds,
+            cpu_transfer_queue.submits );
+    rprint( "    speedup               : %8.2fx\n", serial_seconds / loader_seconds );
+
+    loader.shutdown();
+    cpu_transfer_queue.shutdown();
+}
+
 } // namespace raptor
@@ -1,18 +1,20 @@
 #pragma once
 
 #include "foundation/array.hpp"
+#include "foundation/file.hpp"
 #include "foundation/platform.hpp"
+#include "foundation/string.hpp"
 
 #include "graphics/command_buffer.hpp"
 #include "graphics/gpu_device.hpp"
+#include "graphics/gpu_ring_allocator.hpp"
 #include "graphics/gpu_resources.hpp"
 
 #include "external/cglm/types-struct.h"
+#include "external/enkiTS/TaskScheduler.h"
 
 #include <atomic>
 
-namespace enki { class TaskScheduler; }
-
 namespace raptor
 {
     struct Allocator;
@@ -29,6 +31,10 @@ namespace raptor
         char                                    path[ 512 ];
         TextureHandle                           texture     = k_invalid_texture;
         BufferHandle                            buffer      = k_invalid_buffer;
+
+        u32                                     mip_levels  = 1;
+        u32                                     mip_flags   = 0;    // TextureMipFlags
+        f32                                     alpha_cutoff = 0.5f;
     }; // struct FileLoadRequest
 
     //
@@ -36,23 +42,179 @@ namespace raptor
     struct UploadRequest {
 
         void*                                   data        = nullptr;
+        sizet                                   size        = 0;
         TextureHandle                           texture     = k_invalid_texture;
         BufferHandle                            cpu_buffer  = k_invalid_buffer;
         BufferHandle                            gpu_buffer  = k_invalid_buffer;
     }; // struct UploadRequest
 
+    //
+    // Texture going through the loader: the file is read by the file reader,
+    // then decoded on a task thread and finally packed into the staging ring.
+    // Decoded images with more than one mip get their chain generated right after decoding, on the same thread.
+    // Cooked dds files are not decoded, pixels points to their blocks in the still mapped file.
+    struct TextureLoad : public enki::ITaskSet {
+
+        enum State : u32 {
+            State_Free, State_Reading, State_Decoding
+        };
+
+        void                                    ExecuteRange( enki::TaskSetPartition range_, uint32_t threadnum_ ) override;
+        // Free the decoded pixels or unmap the cooked file.
+        void                                    release_pixels();
+
+        FileReadFuture                          future;
+        TextureHandle                           texture     = k_invalid_texture;
+
+        u8*                                     pixels      = nullptr;
+        sizet                                   data_size   = 0;
+        i32                                     width       = 0;
+        i32                                     height      = 0;
+        i64                                     start_time  = 0;
+        bool                                    cooked      = false;
+
+        // Mips stored in pixels once decoded.
+        u32                                     mip_levels  = 1;
+        u32                                     mip_flags   = 0;    // TextureMipFlags
+        f32                                     alpha_cutoff = 0.5f;
+
+        // Only accessed by the loader, decoding is done when the task set is complete.
+        u32                                     state       = State_Free;
+    }; // struct TextureLoad
+
+    // Transfer queue /////////////////////////////////////////////////////
+
+    //
+    // Destination of the loader uploads. Copies are recorded in batches reading from the staging memory,
+    // a batch is submitted once and recycled when is_complete returns true.
+    struct TransferQueue {
+
+        virtual ~TransferQueue() { }
+
+        virtual u8*                             staging_memory() = 0;
+        virtual sizet                           staging_size() = 0;
+
+        virtual bool                            can_submit() = 0;
+        virtual void                            begin( u32 batch ) = 0;
+        // Staging holds mip_levels tightly packed mips, the missing ones are generated on the gpu.
+        virtual void                            copy_texture( u32 batch, TextureHandle texture, sizet staging_offset, sizet size, u32 mip_levels ) = 0;
+        virtual void                            copy_buffer( u32 batch, BufferHandle buffer, sizet staging_offset, sizet size ) = 0;
+        virtual void                            copy_buffer( u32 batch, BufferHandle src, BufferHandle dst ) = 0;
+        virtual void                            submit( u32 batch ) = 0;
+
+        virtual bool                            is_complete( u32 batch ) = 0;
+        virtual void                            wait( u32 batch ) = 0;
+        // Called for each request of a completed batch.
+        virtual void                            complete( const UploadRequest& request ) = 0;
+
+    }; // struct TransferQueue
+
+    static const u32                            k_max_transfer_batches = 3;
+
+    //
+    // Uploads through the persistent staging buffer on the transfer queue.
+    // Completion is tracked with a timeline semaphore when available, with a fence per batch otherwise.
+    struct VulkanTransferQueue : public TransferQueue {
+
+        void                                    init( Renderer* renderer, sizet staging_size );
+        void                                    shutdown();
+
+        u8*                                     staging_memory() override;
+        sizet                                   staging_size() override;
+
+        bool                                    can_submit() override;
+        void                                    begin( u32 batch ) override;
+        void                                    copy_texture( u32 batch, TextureHandle texture, sizet staging_offset, sizet size, u32 mip_levels ) override;
+        void                                    copy_buffer( u32 batch, BufferHandle buffer, sizet staging_offset, sizet size ) override;
+        void                                    copy_buffer( u32 batch, BufferHandle src, BufferHandle dst ) override;
+        void                                    submit( u32 batch ) override;
+
+        bool                                    is_complete( u32 batch ) override;
+        void                                    wait( u32 batch ) override;
+        void                                    complete( const UploadRequest& request ) override;
+
+        Renderer*                               renderer        = nullptr;
+        Buffer*                                 staging_buffer  = nullptr;
+
+        VkCommandPool                           command_pools[ k_max_transfer_batches ];
+        CommandBuffer                           command_buffers[ k_max_transfer_batches ];
+
+        VkSemaphore                             timeline_semaphore = VK_NULL_HANDLE;
+        u64                                     timeline_value  = 0;
+        u64                                     batch_timeline_values[ k_max_transfer_batches ];
+        VkFence                                 batch_fences[ k_max_transfer_batches ];
+
+        u64                                     last_submit_frame = u64_max;
+
+    }; // struct VulkanTransferQueue
+
+    //
+    // CPU only stand-in for the transfer queue, copies are memcpy into scratch memory and complete immediately.
+    // Used to measure the loader pipeline without a gpu.
+    struct CpuTransferQueue : public TransferQueue {
+
+        void                                    init( Allocator* allocator, sizet staging_size, sizet destination_size );
+        void                                    shutdown();
+
+        u8*                                     staging_memory() override;
+        sizet                                   staging_size() override;
+
+        bool                                    can_submit() override;
+        void                                    begin( u32 batch ) override;
+        void                                    copy_texture( u32 batch, TextureHandle texture, sizet staging_offset, sizet size, u32 mip_levels ) override;
+        void                                    copy_buffer( u32 batch, BufferHandle buffer, sizet staging_offset, sizet size ) override;
+        void                                    copy_buffer( u32 batch, BufferHandle src, BufferHandle dst ) override;
+        void                                    submit( u32 batch ) override;
+
+        bool                                    is_complete( u32 batch ) override;
+        void                                    wait( u32 batch ) override;
+        void                                    complete( const UploadRequest& request ) override;
+
+        Allocator*                              allocator       = nullptr;
+        u8*                                     staging         = nullptr;
+        u8*                                     destination     = nullptr;
+        sizet                                   staging_capacity = 0;
+        sizet                                   destination_capacity = 0;
+
+        u64                                     bytes_copied    = 0;
+        u32                                     textures_completed = 0;
+        u32                                     submits         = 0;
+
+    }; // struct CpuTransferQueue
+
+    //
+    // Recorded uploads, their staging memory is retired with ring_value and released when the batch completes.
+    struct TransferBatch {
+
+        static const u32                        k_max_requests  = 32;
+
+        UploadRequest                           requests[ k_max_requests ];
+        u32                                     num_requests    = 0;
+        u64                                     ring_value      = 0;
+    }; // struct TransferBatch
+
     //
     //
     struct AsynchronousLoader {
 
         void                                    init( Renderer* renderer, enki::TaskScheduler* task_scheduler, Allocator* resident_allocator );
+        // Upload through a custom transfer queue, renderer can be null.
+        void                                    init( TransferQueue* transfer_queue, enki::TaskScheduler* task_scheduler, Allocator* resident_allocator );
         void                                    update( Allocator* scratch_allocator );
         void                                    shutdown();
 
-        void                                    request_texture_data( cstring filename, TextureHandle texture );
+        // With more than one mip level the chain is generated on the loader threads and uploaded with a single copy,
+        // mip_flags are TextureMipFlags and alpha_cutoff is used to preserve the alpha test coverage.
+        void                                    request_texture_data( cstring filename, TextureHandle texture, u32 mip_levels = 1, u32 mip_flags = 0, f32 alpha_cutoff = 0.5f );
         void                                    request_buffer_upload( void* data, BufferHandle buffer );
         void                                    request_buffer_copy( BufferHandle src, BufferHandle dst );
 
+        // True when there are no pending requests and all the uploads are completed.
+        bool                                    is_idle() const;
+
+        // Record and submit one batch, returns the number of uploads in it.
+        u32                                     submit_uploads();
+
         Allocator*                              allocator       = nullptr;
         Renderer*                               renderer        = nullptr;
         enki::TaskScheduler*                    task_scheduler  = nullptr;
@@ -60,18 +222,30 @@ namespace raptor
         Array<FileLoadRequest>                  file_load_requests;
         Array<UploadRequest>                    upload_requests;
 
-        Buffer*                                 staging_buffer  = nullptr;
+        // Files are read and decoded ahead while previous textures are uploaded.
+        static const u32                        k_max_texture_loads = 16;
+
+        AsynchronousFileReader                  file_reader;
+        TextureLoad                             texture_loads[ k_max_texture_loads ];
+        u32                                     texture_loads_count = 0;
 
-        std::atomic_size_t                      staging_buffer_offset;
-        TextureHandle                           texture_ready;
-        BufferHandle                            cpu_buffer_ready;
-        BufferHandle                            gpu_buffer_ready;
+        VulkanTransferQueue                     vulkan_transfer_queue;
+        TransferQueue*                          transfer_queue  = nullptr;
 
-        VkCommandPool                           command_pools[ k_max_frames ];
-        CommandBuffer                           command_buffers[ k_max_frames ];
-        VkSemaphore                             transfer_complete_semaphore;
-        VkFence                                 transfer_fence;
+        GpuRingAllocator                        staging_ring;
+        u64                                     submitted_batches = 0;
+
+        TransferBatch                           batches[ k_max_transfer_batches ];
+        u32                                     batches_head    = 0;
+        u32                                     batches_count   = 0;
+
+        // Every texture requested, replayed by the loader benchmark.
+        StringArray                             requested_texture_paths;
 
     }; // struct AsynchonousLoader
 
+    // Load all the textures with a CPU transfer queue, printing textures/sec and MB/s
+    // against reading and decoding the same files serially.
+    void                                        asynchronous_loader_benchmark( StringArray& texture_paths, enki::TaskScheduler* task_scheduler, Allocator* allocator );
+
 } // namespace raptor
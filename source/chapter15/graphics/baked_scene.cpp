@@ -0,0 +1,1537 @@
+#include "graphics/baked_scene.hpp"
+#include "graphics/meshlet_cache.hpp"
+#include "graphics/texture_cooker.hpp"
+#include "graphics/texture_mips.hpp"
+
+#include "foundation/blob_serialization.hpp"
+#include "foundation/file.hpp"
+#include "foundation/gltf.hpp"
+#include "foundation/numerics.hpp"
+#include "foundation/time.hpp"
+
+#include "external/stb_image.h"
+
+#include "external/cglm/struct/mat4.h"
+#include "external/cglm/struct/vec3.h"
+#include "external/cglm/struct/quat.h"
+
+#include "external/tracy/tracy/Tracy.hpp"
+#include "external/meshoptimizer/meshoptimizer.h"
+
+#include <string.h>
+
+namespace raptor {
+
+//
+//
+struct BakeNode {
+    mat4s                   local_matrix;
+    i32                     parent;
+    u32                     level;
+}; // struct BakeNode
+
+// Blob size of an array, including worst case alignment padding.
+template<typename T>
+static sizet baked_array_size( sizet count ) {
+    return sizeof( T ) * count + alignof( T );
+}
+
+static void baked_vertex_buffer( glTF::glTF& gltf_scene, i32 accessor_index, u32 flag, u32& out_buffer, u32& out_offset, u32& out_flags ) {
+    if ( accessor_index != -1 ) {
+        glTF::Accessor& buffer_accessor = gltf_scene.accessors[ accessor_index ];
+        glTF::BufferView& buffer_view = gltf_scene.buffer_views[ buffer_accessor.buffer_view ];
+
+        out_buffer = buffer_view.buffer;
+        out_offset = glTF::get_data_offset( buffer_accessor.byte_offset, buffer_view.byte_offset );
+
+        out_flags |= flag;
+    } else {
+        out_buffer = k_baked_invalid_index;
+        out_offset = 0;
+    }
+}
+
+static u16 baked_texture_image( glTF::glTF& gltf_scene, i32 gltf_texture_index, Array<i32>& image_samplers ) {
+    if ( gltf_texture_index < 0 ) {
+        return k_invalid_scene_texture_index;
+    }
+
+    glTF::Texture& gltf_texture = gltf_scene.textures[ gltf_texture_index ];
+    // Samplers are linked to the texture, last referencing material wins as when linking at runtime.
+    if ( gltf_texture.sampler != i32_max ) {
+        image_samplers[ gltf_texture.source ] = gltf_texture.sampler;
+    }
+
+    return ( u16 )gltf_texture.source;
+}
+
+static void baked_fill_material( glTF::glTF& gltf_scene, glTF::Material& material, BakedMaterial& baked_material, Array<i32>& image_samplers ) {
+
+    // Handle flags
+    if ( material.alpha_mode.data != nullptr && strcmp( material.alpha_mode.data, "MASK" ) == 0 ) {
+        baked_material.flags |= DrawFlags_AlphaMask;
+    } else if ( material.alpha_mode.data != nullptr && strcmp( material.alpha_mode.data, "BLEND" ) == 0 ) {
+        baked_material.flags |= DrawFlags_Transparent;
+    }
+
+    baked_material.flags |= material.double_sided ? DrawFlags_DoubleSided : 0;
+    // Alpha cutoff
+    baked_material.alpha_cutoff = material.alpha_cutoff != glTF::INVALID_FLOAT_VALUE ? material.alpha_cutoff : 1.f;
+
+    if ( material.pbr_metallic_roughness != nullptr ) {
+        if ( material.pbr_metallic_roughness->base_color_factor_count != 0 ) {
+            RASSERT( material.pbr_metallic_roughness->base_color_factor_count == 4 );
+
+            memcpy( baked_material.base_color_factor.raw, material.pbr_metallic_roughness->base_color_factor, sizeof( vec4s ) );
+        }
+
+        baked_material.roughness = material.pbr_metallic_roughness->roughness_factor != glTF::INVALID_FLOAT_VALUE ? material.pbr_metallic_roughness->roughness_factor : 1.f;
+        baked_material.metallic = material.pbr_metallic_roughness->metallic_factor != glTF::INVALID_FLOAT_VALUE ? material.pbr_metallic_roughness->metallic_factor : 0.f;
+
+        glTF::TextureInfo* base_color_texture = material.pbr_metallic_roughness->base_color_texture;
+        glTF::TextureInfo* metallic_roughness_texture = material.pbr_metallic_roughness->metallic_roughness_texture;
+        baked_material.diffuse_image = baked_texture_image( gltf_scene, base_color_texture ? base_color_texture->index : -1, image_samplers );
+        baked_material.roughness_image = baked_texture_image( gltf_scene, metallic_roughness_texture ? metallic_roughness_texture->index : -1, image_samplers );
+    }
+
+    if ( material.emissive_texture != nullptr ) {
+        baked_material.emissive_image = baked_texture_image( gltf_scene, material.emissive_texture->index, image_samplers );
+    }
+
+    if ( material.emissive_factor_count != 0 ) {
+        RASSERT( material.emissive_factor_count == 3 );
+
+        memcpy( baked_material.emissive_factor.raw, material.emissive_factor, sizeof( vec3s ) );
+    }
+
+    baked_material.occlusion_image = baked_texture_image( gltf_scene, ( material.occlusion_texture != nullptr ) ? material.occlusion_texture->index : -1, image_samplers );
+    baked_material.normal_image = baked_texture_image( gltf_scene, ( material.normal_texture != nullptr ) ? material.normal_texture->index : -1, image_samplers );
+
+    if ( material.occlusion_texture != nullptr ) {
+        if ( material.occlusion_texture->strength != glTF::INVALID_FLOAT_VALUE ) {
+            baked_material.occlusion = material.occlusion_texture->strength;
+        } else {
+            baked_material.occlusion = 1.0f;
+        }
+    }
+}
+
+static u8* baked_accessor_data( glTF::glTF& gltf_scene, Array<MappedFile>& buffers_data, i32 accessor_index ) {
+    glTF::Accessor& buffer_accessor = gltf_scene.accessors[ accessor_index ];
+    glTF::BufferView& buffer_view = gltf_scene.buffer_views[ buffer_accessor.buffer_view ];
+
+    i32 byte_offset = glTF::get_data_offset( buffer_accessor.byte_offset, buffer_view.byte_offset );
+    return ( u8* )buffers_data[ buffer_view.buffer ].data + byte_offset;
+}
+
+static void baked_sampler_from_gltf( const glTF::Sampler& sampler, BakedSampler& baked_sampler ) {
+    // Same defaults as SamplerCreation
+    baked_sampler.min_filter = VK_FILTER_NEAREST;
+    baked_sampler.mag_filter = sampler.mag_filter == glTF::Sampler::Filter::LINEAR ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+    baked_sampler.mip_filter = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    baked_sampler.address_mode_u = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    baked_sampler.address_mode_v = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+
+    switch ( sampler.min_filter ) {
+        case glTF::Sampler::NEAREST:
+            baked_sampler.min_filter = VK_FILTER_NEAREST;
+            break;
+        case glTF::Sampler::LINEAR:
+            baked_sampler.min_filter = VK_FILTER_LINEAR;
+            break;
+        case glTF::Sampler::LINEAR_MIPMAP_NEAREST:
+            baked_sampler.min_filter = VK_FILTER_LINEAR;
+            baked_sampler.mip_filter = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+            break;
+        case glTF::Sampler::LINEAR_MIPMAP_LINEAR:
+            baked_sampler.min_filter = VK_FILTER_LINEAR;
+            baked_sampler.mip_filter = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+            break;
+        case glTF::Sampler::NEAREST_MIPMAP_NEAREST:
+            baked_sampler.min_filter = VK_FILTER_NEAREST;
+            baked_sampler.mip_filter = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+            break;
+        case glTF::Sampler::NEAREST_MIPMAP_LINEAR:
+            baked_sampler.min_filter = VK_FILTER_NEAREST;
+            baked_sampler.mip_filter = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+            break;
+    }
+
+    switch ( sampler.wrap_s ) {
+        case glTF::Sampler::CLAMP_TO_EDGE:
+            baked_sampler.address_mode_u = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            break;
+        case glTF::Sampler::MIRRORED_REPEAT:
+            baked_sampler.address_mode_u = VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
+            break;
+        case glTF::Sampler::REPEAT:
+            baked_sampler.address_mode_u = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+            break;
+    }
+
+    switch ( sampler.wrap_t ) {
+        case glTF::Sampler::CLAMP_TO_EDGE:
+            baked_sampler.address_mode_v = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            break;
+        case glTF::Sampler::MIRRORED_REPEAT:
+            baked_sampler.address_mode_v = VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
+            break;
+        case glTF::Sampler::REPEAT:
+            baked_sampler.address_mode_v = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+            break;
+    }
+}
+
+// Buffers of .glb files point in the glTF mapping and are released with it.
+static void baked_unmap_buffers( glTF::glTF& gltf_scene, Array<MappedFile>& buffers_data ) {
+    for ( u32 buffer_index = 0; buffer_index < gltf_scene.buffers_count; ++buffer_index ) {
+        if ( gltf_scene.buffers[ buffer_index ].data == nullptr ) {
+            file_unmap( &buffers_data[ buffer_index ] );
+        }
+    }
+}
+
+static void baked_extract_image( glTF::glTF& gltf_scene, Array<MappedFile>& buffers_data, cstring filename, u32 image_index ) {
+    glTF::Image& image = gltf_scene.images[ image_index ];
+    if ( image.uri.data != nullptr || image.buffer_view == glTF::INVALID_INT_VALUE ) {
+        return;
+    }
+
+    glTF::BufferView& buffer_view = gltf_scene.buffer_views[ image.buffer_view ];
+    const i32 byte_offset = buffer_view.byte_offset == glTF::INVALID_INT_VALUE ? 0 : buffer_view.byte_offset;
+    char* image_data = buffers_data[ buffer_view.buffer ].data + byte_offset;
+
+    const bool is_jpeg = image.mime_type.data != nullptr && strcmp( image.mime_type.data, "image/jpeg" ) == 0;
+    cstring extension = strrchr( filename, '.' );
+    const int name_length = extension ? ( int )( extension - filename ) : ( int )strlen( filename );
+
+    char image_filename[ 512 ];
+    const int image_filename_length = snprintf( image_filename, 512, "%.*s_image%u.%s", name_length, filename, image_index, is_jpeg ? "jpg" : "png" );
+    file_write_binary( image_filename, image_data, buffer_view.byte_length );
+
+    image.uri.init( image_filename_length + 1, &gltf_scene.allocator );
+    image.uri.append( image_filename );
+}
+
+static VkFormat baked_cooked_format( TextureCookFormat::Enum format ) {
+    switch ( format ) {
+        case TextureCookFormat::BC1:
+            return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        case TextureCookFormat::BC3:
+            return VK_FORMAT_BC3_UNORM_BLOCK;
+        case TextureCookFormat::BC4:
+            return VK_FORMAT_BC4_UNORM_BLOCK;
+        case TextureCookFormat::BC5:
+            return VK_FORMAT_BC5_UNORM_BLOCK;
+        case TextureCookFormat::BC7:
+            return VK_FORMAT_BC7_UNORM_BLOCK;
+        default:
+            return VK_FORMAT_UNDEFINED;
+    }
+}
+
+// How the materials sample each image decides how its mips are filtered: colors are sRGB, normal maps are renormalized
+// and alpha tested base colors keep their coverage.
+static void baked_image_mip_flags( Array<BakedMesh>& meshes, Array<u32>& mip_flags, Array<f32>& alpha_cutoffs ) {
+    for ( u32 mesh_index = 0; mesh_index < meshes.size; ++mesh_index ) {
+        const BakedMaterial& material = meshes[ mesh_index ].material;
+
+        if ( material.diffuse_image != k_invalid_scene_texture_index ) {
+            mip_flags[ material.diffuse_image ] |= TextureMipFlags_Srgb;
+
+            if ( material.flags & DrawFlags_AlphaMask ) {
+                mip_flags[ material.diffuse_image ] |= TextureMipFlags_AlphaCoverage;
+                alpha_cutoffs[ material.diffuse_image ] = material.alpha_cutoff;
+            }
+        }
+
+        if ( material.emissive_image != k_invalid_scene_texture_index ) {
+            mip_flags[ material.emissive_image ] |= TextureMipFlags_Srgb;
+        }
+
+        if ( material.normal_image != k_invalid_scene_texture_index ) {
+            mip_flags[ material.normal_image ] |= TextureMipFlags_NormalMap;
+        }
+    }
+}
+
+// Compress every image into a dds file next to it and point the image to it.
+// Normal maps keep only XY in BC5, everything else goes to BC7. Already cooked files are reused.
+static void baked_cook_images( glTF::glTF& gltf_scene, Array<u32>& mip_flags, Array<f32>& alpha_cutoffs, Allocator* allocator ) {
+    ZoneScoped;
+
+    char cooked_filename[ 512 ];
+    for ( u32 image_index = 0; image_index < gltf_scene.images_count; ++image_index ) {
+        glTF::Image& image = gltf_scene.images[ image_index ];
+        if ( image.uri.data == nullptr ) {
+            continue;
+        }
+
+        texture_cooked_path( image.uri.data, cooked_filename, 512 );
+        if ( strcmp( cooked_filename, image.uri.data ) == 0 ) {
+            continue;
+        }
+
+        if ( !file_exists( cooked_filename ) ) {
+            const TextureCookFormat::Enum format = ( mip_flags[ image_index ] & TextureMipFlags_NormalMap ) ? TextureCookFormat::BC5 : TextureCookFormat::BC7;
+
+            i64 start_cook = time_now();
+            if ( !texture_cook( image.uri.data, cooked_filename, format, mip_flags[ image_index ], alpha_cutoffs[ image_index ], allocator ) ) {
+                continue;
+            }
+
+            rprint( "Cooked texture %s to %s in %f seconds\n", image.uri.data, TextureCookFormat::ToString( format ), time_from_seconds( start_cook ) );
+        }
+
+        image.uri.init( strlen( cooked_filename ) + 1, &gltf_scene.allocator );
+        image.uri.append( cooked_filename );
+    }
+}
+
+// Index groups of zeroes added after the meshlet triangles.
+// Writing in group of fours can be problematic, if there are non multiple of 3
+// indices a triangle can be shared between meshlets.
+// We need to add some padding for that.
+// This is visible only when emulating meshlets, so probably there are controls
+// at driver level that avoid this problems when using mesh shaders.
+// Check for the last 3 indices: if last one are two are zero, then add one or two
+// groups of empty triangles.
+u32 baked_meshlet_padding_groups( const u32* index_groups, u32 index_group_count ) {
+    u32 last_index_group = index_groups[ index_group_count - 1 ];
+    u32 last_index = ( last_index_group >> 8 ) & 0xff;
+    u32 second_last_index = ( last_index_group >> 16 ) & 0xff;
+    u32 third_last_index = ( last_index_group >> 24 ) & 0xff;
+    if ( last_index != 0 && third_last_index == 0 ) {
+        return second_last_index != 0 ? 2 : 1;
+    }
+    return 0;
+}
+
+// Size in bytes of the data read from an accessor.
+static sizet baked_accessor_size( const glTF::Accessor& accessor ) {
+    static const u32 k_type_components[] = { 1, 2, 3, 4, 4, 9, 16 };
+
+    u32 component_size = 4;
+    switch ( accessor.component_type ) {
+        case glTF::Accessor::BYTE:
+        case glTF::Accessor::UNSIGNED_BYTE:
+            component_size = 1;
+            break;
+        case glTF::Accessor::SHORT:
+        case glTF::Accessor::UNSIGNED_SHORT:
+            component_size = 2;
+            break;
+    }
+
+    return ( sizet )accessor.count * k_type_components[ accessor.type ] * component_size;
+}
+
+//
+// Post transform cache and vertex fetch efficiency of a primitive, measured before and after optimizing it.
+struct BakeVertexCacheStats {
+    u32                     transformed_vertices;   // Cache misses of a 16 entries FIFO cache, over triangles gives ACMR, over vertices ATVR.
+    u32                     fetched_bytes;          // Position bytes read through 64 bytes cache lines.
+}; // struct BakeVertexCacheStats
+
+static BakeVertexCacheStats baked_vertex_cache_stats( const u32* indices, u32 index_count, u32 vertex_count ) {
+    BakeVertexCacheStats stats;
+    stats.transformed_vertices = meshopt_analyzeVertexCache( indices, index_count, vertex_count, 16, 0, 0 ).vertices_transformed;
+    stats.fetched_bytes = meshopt_analyzeVertexFetch( indices, index_count, vertex_count, sizeof( vec3s ) ).bytes_fetched;
+    return stats;
+}
+
+// A vertex stream can be reordered in place only if it is tightly packed, interleaved streams would move each other.
+static bool baked_accessor_packed( glTF::glTF& gltf_scene, const glTF::Accessor& accessor ) {
+    const glTF::BufferView& buffer_view = gltf_scene.buffer_views[ accessor.buffer_view ];
+    return buffer_view.byte_stride == glTF::INVALID_INT_VALUE || buffer_view.byte_stride == 0 ||
+           ( sizet )buffer_view.byte_stride * accessor.count == baked_accessor_size( accessor );
+}
+
+// Reorder the triangles of a primitive for the post transform cache then for overdraw, and with remap_vertices
+// its vertices in order of first use, moving every attribute stream the same way.
+// Data is patched in the copy on write mapping of the buffers, both the index buffer and the meshlets see the new order.
+static void baked_optimize_primitive( glTF::glTF& gltf_scene, Array<MappedFile>& buffers_data, const glTF::MeshPrimitive& mesh_primitive, u16* source_indices, u32 index_count,
+                                      const f32* vertices, u32 vertex_count, bool remap_vertices, BakeVertexCacheStats& out_before, BakeVertexCacheStats& out_after, Allocator* allocator ) {
+    ZoneScoped;
+
+    u32* indices = ( u32* )ralloca( index_count * sizeof( u32 ), allocator );
+    u32* cache_indices = ( u32* )ralloca( index_count * sizeof( u32 ), allocator );
+    for ( u32 i = 0; i < index_count; ++i ) {
+        indices[ i ] = source_indices[ i ];
+    }
+
+    out_before = baked_vertex_cache_stats( indices, index_count, vertex_count );
+
+    meshopt_optimizeVertexCache( cache_indices, indices, index_count, vertex_count );
+    // Overdraw sorting moves clusters of triangles, losing at most 5% of the cache efficiency.
+    meshopt_optimizeOverdraw( indices, cache_indices, index_count, vertices, vertex_count, sizeof( vec3s ), 1.05f );
+
+    if ( remap_vertices ) {
+        u32* remap = ( u32* )ralloca( vertex_count * sizeof( u32 ), allocator );
+        meshopt_optimizeVertexFetchRemap( remap, indices, index_count, vertex_count );
+        meshopt_remapIndexBuffer( indices, indices, index_count, remap );
+
+        // Unreferenced vertices are dropped by the remap, the end of each stream keeps old vertices nobody indexes.
+        for ( u32 a = 0; a < mesh_primitive.attribute_count; ++a ) {
+            const i32 accessor_index = mesh_primitive.attributes[ a ].accessor_index;
+            const glTF::Accessor& accessor = gltf_scene.accessors[ accessor_index ];
+
+            u8* attribute_data = baked_accessor_data( gltf_scene, buffers_data, accessor_index );
+            meshopt_remapVertexBuffer( attribute_data, attribute_data, vertex_count, baked_accessor_size( accessor ) / accessor.count, remap );
+        }
+
+        rfree( remap, allocator );
+    }
+
+    out_after = baked_vertex_cache_stats( indices, index_count, vertex_count );
+
+    for ( u32 i = 0; i < index_count; ++i ) {
+        source_indices[ i ] = ( u16 )indices[ i ];
+    }
+
+    rfree( cache_indices, allocator );
+    rfree( indices, allocator );
+}
+
+//
+// Meshlets of one level of detail, built before the cache entry so that its size is known.
+struct BakeMeshletLevel {
+    meshopt_Meshlet*        meshlets;
+    u32*                    vertex_indices;
+    u8*                     triangles;
+
+    u32                     meshlet_count;
+    u32                     data_count;         // Vertex indices, packed triangle indices and padding of every meshlet.
+    u32                     index_group_count;
+    f32                     error;
+}; // struct BakeMeshletLevel
+
+static void baked_build_level_meshlets( const MeshletBuildParameters& parameters, const u32* indices, u32 index_count, const f32* vertices, u32 vertex_count,
+                                        BakeMeshletLevel& level, Allocator* allocator ) {
+    const sizet max_meshlets = meshopt_buildMeshletsBound( index_count, parameters.max_vertices, parameters.max_triangles );
+
+    level.meshlets = ( meshopt_Meshlet* )ralloca( max_meshlets * sizeof( meshopt_Meshlet ), allocator );
+    level.vertex_indices = ( u32* )ralloca( max_meshlets * parameters.max_vertices * sizeof( u32 ), allocator );
+    level.triangles = ( u8* )ralloca( max_meshlets * parameters.max_triangles * 3, allocator );
+
+    level.meshlet_count = ( u32 )meshopt_buildMeshlets( level.meshlets, level.vertex_indices, level.triangles, indices,
+                                                        index_count, vertices, vertex_count, sizeof( vec3s ),
+                                                        parameters.max_vertices, parameters.max_triangles, parameters.cone_weight );
+
+    level.data_count = 0;
+    level.index_group_count = 0;
+    for ( u32 m = 0; m < level.meshlet_count; ++m ) {
+        const meshopt_Meshlet& local_meshlet = level.meshlets[ m ];
+        const u32 index_group_count = ( local_meshlet.triangle_count * 3 + 3 ) / 4;
+        const u32* index_groups = reinterpret_cast< const u32* >( level.triangles + local_meshlet.triangle_offset );
+
+        level.data_count += local_meshlet.vertex_count + index_group_count + baked_meshlet_padding_groups( index_groups, index_group_count );
+        level.index_group_count += index_group_count;
+    }
+}
+
+// Build the meshlets of a primitive and of its simplified levels of detail, and quantize its vertices into a meshlet
+// cache entry written with blob.
+// Called from task threads: allocator must be thread safe, it holds both the entry and the meshoptimizer output.
+static MeshletCacheEntry* baked_build_primitive_meshlets( const MeshletBuildParameters& parameters, const u16* source_indices, u32 index_count, const f32* vertices, u32 vertex_count,
+                                                          const f32* normals, const f32* tangents, const f32* tex_coords, BlobSerializer& blob, Allocator* allocator ) {
+    ZoneScoped;
+
+    i64 start_build = time_now();
+
+    u32* indices = ( u32* )ralloca( index_count * sizeof( u32 ), allocator );
+    u32* lod_indices = ( u32* )ralloca( index_count * sizeof( u32 ), allocator );
+    for ( u32 i = 0; i < index_count; ++i ) {
+        indices[ i ] = source_indices[ i ];
+    }
+
+    // Simplification errors are relative to the mesh extents.
+    const u32 max_lod_count = raptor::min( raptor::max( parameters.lod_count, 1u ), k_max_mesh_lods );
+    const f32 error_scale = max_lod_count > 1 ? meshopt_simplifyScale( vertices, vertex_count, sizeof( vec3s ) ) : 0.f;
+
+    BakeMeshletLevel levels[ k_max_mesh_lods ];
+    u32 lod_count = 0;
+    u32 meshlet_count = 0, meshlets_data_count = 0;
+
+    const u32* level_indices = indices;
+    u32 level_index_count = index_count;
+    f32 level_error = 0.f;
+    for ( u32 l = 0; l < max_lod_count; ++l ) {
+        if ( l > 0 ) {
+            // Every level is simplified from the full detail mesh, so that errors do not accumulate.
+            const u32 target_index_count = ( u32 )( level_index_count * parameters.lod_index_ratio ) / 3 * 3;
+            f32 simplify_error = 0.f;
+            const u32 simplified_count = ( u32 )meshopt_simplify( lod_indices, indices, index_count, vertices, vertex_count, sizeof( vec3s ),
+                                                                  target_index_count, parameters.lod_max_error, 0, &simplify_error );
+
+            // A level that barely removes triangles costs memory and selection time for nothing.
+            if ( simplified_count == 0 || simplified_count > level_index_count * 0.85f ) {
+                break;
+            }
+
+            level_indices = lod_indices;
+            level_index_count = simplified_count;
+            level_error = raptor::max( level_error, simplify_error * error_scale );
+        }
+
+        BakeMeshletLevel& level = levels[ lod_count++ ];
+        baked_build_level_meshlets( parameters, level_indices, level_index_count, vertices, vertex_count, level, allocator );
+        level.error = level_error;
+
+        meshlet_count += level.meshlet_count;
+        meshlets_data_count += level.data_count;
+    }
+
+    sizet blob_size = sizeof( MeshletCacheEntry );
+    blob_size += baked_array_size<GpuMeshlet>( meshlet_count );
+    blob_size += baked_array_size<GpuMeshletVertexPosition>( vertex_count );
+    blob_size += baked_array_size<GpuMeshletVertexData>( vertex_count );
+    blob_size += baked_array_size<u32>( meshlets_data_count );
+
+    MeshletCacheEntry* entry = blob.write_and_prepare<MeshletCacheEntry>( allocator, k_meshlet_cache_version, blob_size );
+    blob.allocate_and_set( entry->meshlets, meshlet_count );
+    blob.allocate_and_set( entry->vertex_positions, vertex_count );
+    blob.allocate_and_set( entry->vertex_data, vertex_count );
+    blob.allocate_and_set( entry->meshlets_data, meshlets_data_count );
+
+    entry->aabb[ 0 ] = vec3s{ FLT_MAX, FLT_MAX, FLT_MAX };
+    entry->aabb[ 1 ] = vec3s{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    for ( u32 v = 0; v < vertex_count; ++v ) {
+        GpuMeshletVertexPosition meshlet_vertex_pos{ };
+
+        f32 x = vertices[ v * 3 + 0 ];
+        f32 y = vertices[ v * 3 + 1 ];
+        f32 z = vertices[ v * 3 + 2 ];
+
+        entry->aabb[ 0 ] = glms_vec3_minv( entry->aabb[ 0 ], vec3s{ x, y, z } );
+        entry->aabb[ 1 ] = glms_vec3_maxv( entry->aabb[ 1 ], vec3s{ x, y, z } );
+
+        meshlet_vertex_pos.position[ 0 ] = x;
+        meshlet_vertex_pos.position[ 1 ] = y;
+        meshlet_vertex_pos.position[ 2 ] = z;
+
+        entry->vertex_positions[ v ] = meshlet_vertex_pos;
+
+        GpuMeshletVertexData meshlet_vertex_data{ };
+
+        if ( normals != nullptr ) {
+            meshlet_vertex_data.normal[ 0 ] = ( normals[ v * 3 + 0 ] + 1.0f ) * 127.0f;
+            meshlet_vertex_data.normal[ 1 ] = ( normals[ v * 3 + 1 ] + 1.0f ) * 127.0f;
+            meshlet_vertex_data.normal[ 2 ] = ( normals[ v * 3 + 2 ] + 1.0f ) * 127.0f;
+        }
+
+        if ( tangents != nullptr ) {
+            meshlet_vertex_data.tangent[ 0 ] = ( tangents[ v * 3 + 0 ] + 1.0f ) * 127.0f;
+            meshlet_vertex_data.tangent[ 1 ] = ( tangents[ v * 3 + 1 ] + 1.0f ) * 127.0f;
+            meshlet_vertex_data.tangent[ 2 ] = ( tangents[ v * 3 + 2 ] + 1.0f ) * 127.0f;
+            meshlet_vertex_data.tangent[ 3 ] = ( tangents[ v * 3 + 3 ] + 1.0f ) * 127.0f;
+        }
+
+        if ( tex_coords != nullptr ) {
+            meshlet_vertex_data.uv_coords[ 0 ] = meshopt_quantizeHalf( tex_coords[ v * 2 + 0 ] );
+            meshlet_vertex_data.uv_coords[ 1 ] = meshopt_quantizeHalf( tex_coords[ v * 2 + 1 ] );
+        }
+
+        entry->vertex_data[ v ] = meshlet_vertex_data;
+    }
+
+    entry->lod_count = lod_count;
+    entry->index_group_count = 0;
+
+    u32* meshlets_data = entry->meshlets_data.get();
+    u32 data_offset = 0;
+    u32 meshlet_offset = 0;
+
+    for ( u32 l = 0; l < lod_count; ++l ) {
+        const BakeMeshletLevel& level = levels[ l ];
+
+        GpuMeshLod& lod = entry->lods[ l ];
+        lod.meshlet_offset = meshlet_offset;
+        lod.meshlet_count = level.meshlet_count;
+        lod.meshlet_index_count = 0;
+        lod.error = level.error;
+
+        for ( u32 m = 0; m < level.meshlet_count; ++m ) {
+            meshopt_Meshlet& local_meshlet = level.meshlets[ m ];
+
+            meshopt_Bounds meshlet_bounds = meshopt_computeMeshletBounds( level.vertex_indices + local_meshlet.vertex_offset,
+                                                                          level.triangles + local_meshlet.triangle_offset, local_meshlet.triangle_count,
+                                                                          vertices, vertex_count, sizeof( vec3s ) );
+
+            GpuMeshlet meshlet{};
+            meshlet.data_offset = data_offset;
+            meshlet.vertex_count = local_meshlet.vertex_count;
+            meshlet.triangle_count = local_meshlet.triangle_count;
+
+            meshlet.center = vec3s{ meshlet_bounds.center[ 0 ], meshlet_bounds.center[ 1 ], meshlet_bounds.center[ 2 ] };
+            meshlet.radius = meshlet_bounds.radius;
+
+            meshlet.cone_axis[ 0 ] = meshlet_bounds.cone_axis_s8[ 0 ];
+            meshlet.cone_axis[ 1 ] = meshlet_bounds.cone_axis_s8[ 1 ];
+            meshlet.cone_axis[ 2 ] = meshlet_bounds.cone_axis_s8[ 2 ];
+
+            meshlet.cone_cutoff = meshlet_bounds.cone_cutoff_s8;
+            // Set when appended to the scene.
+            meshlet.mesh_index = 0;
+
+            for ( u32 i = 0; i < meshlet.vertex_count; ++i ) {
+                meshlets_data[ data_offset++ ] = level.vertex_indices[ local_meshlet.vertex_offset + i ];
+            }
+
+            // Store indices as uint32
+            // NOTE(marco): we write 4 indices at at time, it will come in handy in the mesh shader
+            const u32 index_group_count = ( local_meshlet.triangle_count * 3 + 3 ) / 4;
+            const u32* index_groups = reinterpret_cast< const u32* >( level.triangles + local_meshlet.triangle_offset );
+            for ( u32 i = 0; i < index_group_count; ++i ) {
+                meshlets_data[ data_offset++ ] = index_groups[ i ];
+            }
+
+            const u32 padding_groups = baked_meshlet_padding_groups( index_groups, index_group_count );
+            for ( u32 i = 0; i < padding_groups; ++i ) {
+                meshlets_data[ data_offset++ ] = 0;
+            }
+            meshlet.triangle_count += padding_groups;
+
+            lod.meshlet_index_count += meshlet.triangle_count * 3;
+
+            entry->meshlets[ meshlet_offset++ ] = meshlet;
+        }
+
+        // Instances draw a single level, the index buffer holds the largest one.
+        entry->index_group_count = raptor::max( entry->index_group_count, level.index_group_count );
+    }
+
+    RASSERT( data_offset == meshlets_data_count );
+    RASSERT( blob.allocated_offset <= blob.total_size );
+
+    for ( u32 l = 0; l < lod_count; ++l ) {
+        rfree( levels[ l ].triangles, allocator );
+        rfree( levels[ l ].vertex_indices, allocator );
+        rfree( levels[ l ].meshlets, allocator );
+    }
+    rfree( lod_indices, allocator );
+    rfree( indices, allocator );
+
+    entry->build_seconds = ( f32 )time_from_seconds( start_build );
+
+    return entry;
+}
+
+//
+// Source data of a primitive, the meshlets built from it and their place in the scene arrays.
+struct BakePrimitive {
+    const u16*              indices;
+    const f32*              vertices;
+    const f32*              normals;
+    const f32*              tangents;
+    const f32*              tex_coords;
+
+    u32                     index_count;
+    u32                     vertex_count;
+
+    // Bytes of each stream hashed in the meshlet cache key.
+    sizet                   indices_size;
+    sizet                   vertices_size;
+    sizet                   normals_size;
+    sizet                   tangents_size;
+    sizet                   tex_coords_size;
+
+    // Optimization of the primitive, when its index accessor is not shared with another one.
+    const glTF::MeshPrimitive* gltf_primitive;
+    bool                    optimize;
+    bool                    remap_vertices;     // All its vertex streams are packed and used only by this primitive.
+    BakeVertexCacheStats    stats_before;
+    BakeVertexCacheStats    stats_after;
+
+    u64                     cache_key;
+    u32                     source_primitive;   // Primitive whose meshlets are copied, itself unless the same data was seen before.
+
+    BlobSerializer          blob;
+    MeshletCacheEntry*      meshlets;
+
+    // Offsets in the scene arrays, prefix sums of the sizes of the previous primitives.
+    u32                     meshlet_offset;
+    u32                     vertex_offset;
+    u32                     data_offset;
+}; // struct BakePrimitive
+
+//
+// Runs one phase of the meshlet build over a range of primitives.
+// Primitives only write their own entry and their own range of the scene arrays, so no locking is needed.
+struct BakeMeshletsTask : public enki::ITaskSet {
+
+    enum Phase {
+        Phase_Optimize, Phase_CacheKeys, Phase_Build, Phase_Copy
+    };
+
+    void                    ExecuteRange( enki::TaskSetPartition range_, uint32_t threadnum_ ) override;
+
+    Phase                   phase               = Phase_Build;
+    BakePrimitive*          primitives          = nullptr;
+    BakePrimitive**         unique_primitives   = nullptr;  // Range of the build phase, primitives with their own data.
+    MeshletCache*           meshlet_cache       = nullptr;  // nullptr if not used.
+    Allocator*              allocator           = nullptr;  // Thread safe.
+    MeshletBuildParameters  build_parameters;
+
+    glTF::glTF*             gltf_scene          = nullptr;  // Source of the optimized streams.
+    Array<MappedFile>*      buffers_data        = nullptr;
+
+    GpuMeshlet*             meshlets            = nullptr;
+    GpuMeshletVertexPosition* meshlets_vertex_positions = nullptr;
+    GpuMeshletVertexData*   meshlets_vertex_data = nullptr;
+    u32*                    meshlets_data       = nullptr;
+}; // struct BakeMeshletsTask
+
+// Meshlets are padded to a multiple of 32 per level of detail, task shaders read them in groups of 32.
+static u32 baked_padded_meshlet_count( u32 meshlet_count ) {
+    return ( meshlet_count + 31 ) & ~31u;
+}
+
+void BakeMeshletsTask::ExecuteRange( enki::TaskSetPartition range_, uint32_t threadnum_ ) {
+    ZoneScoped;
+
+    for ( u32 primitive_index = range_.start; primitive_index < range_.end; ++primitive_index ) {
+        BakePrimitive& primitive = phase == Phase_Build ? *unique_primitives[ primitive_index ] : primitives[ primitive_index ];
+
+        switch ( phase ) {
+            case Phase_Optimize:
+            {
+                if ( primitive.optimize ) {
+                    baked_optimize_primitive( *gltf_scene, *buffers_data, *primitive.gltf_primitive, ( u16* )primitive.indices, primitive.index_count, primitive.vertices,
+                                              primitive.vertex_count, primitive.remap_vertices, primitive.stats_before, primitive.stats_after, allocator );
+                }
+                break;
+            }
+
+            case Phase_CacheKeys:
+            {
+                u64 key = meshlet_cache->key_begin( build_parameters );
+                key = meshlet_cache->key_add( key, primitive.indices, primitive.indices_size );
+                key = meshlet_cache->key_add( key, primitive.vertices, primitive.vertices_size );
+                key = meshlet_cache->key_add( key, primitive.normals, primitive.normals_size );
+                key = meshlet_cache->key_add( key, primitive.tangents, primitive.tangents_size );
+                key = meshlet_cache->key_add( key, primitive.tex_coords, primitive.tex_coords_size );
+                primitive.cache_key = key;
+                break;
+            }
+
+            case Phase_Build:
+            {
+                // Meshlets come from the cache when the same accessors were built with the same parameters.
+                if ( meshlet_cache ) {
+                    primitive.meshlets = meshlet_cache->read( primitive.cache_key, primitive.blob, allocator );
+                }
+
+                if ( primitive.meshlets == nullptr ) {
+                    primitive.meshlets = baked_build_primitive_meshlets( build_parameters, primitive.indices, primitive.index_count, primitive.vertices, primitive.vertex_count,
+                                                                         primitive.normals, primitive.tangents, primitive.tex_coords, primitive.blob, allocator );
+
+                    if ( meshlet_cache ) {
+                        meshlet_cache->write( primitive.cache_key, primitive.blob );
+                    }
+                }
+                break;
+            }
+
+            case Phase_Copy:
+            {
+                const MeshletCacheEntry& entry = *primitives[ primitive.source_primitive ].meshlets;
+
+                memcpy( meshlets_vertex_positions + primitive.vertex_offset, entry.vertex_positions.get(), sizeof( GpuMeshletVertexPosition ) * entry.vertex_positions.size );
+                memcpy( meshlets_vertex_data + primitive.vertex_offset, entry.vertex_data.get(), sizeof( GpuMeshletVertexData ) * entry.vertex_data.size );
+                // Vertex indices are rebased below, packed triangle indices are local to each meshlet.
+                memcpy( meshlets_data + primitive.data_offset, entry.meshlets_data.get(), sizeof( u32 ) * entry.meshlets_data.size );
+
+                GpuMeshlet* level_meshlets = meshlets + primitive.meshlet_offset;
+                for ( u32 l = 0; l < entry.lod_count; ++l ) {
+                    const GpuMeshLod& lod = entry.lods[ l ];
+
+                    for ( u32 m = 0; m < lod.meshlet_count; ++m ) {
+                        GpuMeshlet meshlet = entry.meshlets[ lod.meshlet_offset + m ];
+
+                        u32* vertex_indices = meshlets_data + primitive.data_offset + meshlet.data_offset;
+                        for ( u32 i = 0; i < meshlet.vertex_count; ++i ) {
+                            vertex_indices[ i ] += primitive.vertex_offset;
+                        }
+
+                        meshlet.data_offset += primitive.data_offset;
+                        // Meshes are added in primitive order.
+                        meshlet.mesh_index = primitive_index;
+
+                        level_meshlets[ m ] = meshlet;
+                    }
+
+                    for ( u32 m = lod.meshlet_count; m < baked_padded_meshlet_count( lod.meshlet_count ); ++m ) {
+                        level_meshlets[ m ] = GpuMeshlet();
+                    }
+
+                    level_meshlets += baked_padded_meshlet_count( lod.meshlet_count );
+                }
+                break;
+            }
+        }
+    }
+}
+
+// Run a phase over all primitives, on the calling thread if there is no task scheduler.
+static void baked_run_meshlets_task( enki::TaskScheduler* task_scheduler, BakeMeshletsTask& task, u32 primitive_count ) {
+    if ( primitive_count == 0 ) {
+        return;
+    }
+
+    if ( task_scheduler == nullptr ) {
+        task.ExecuteRange( { 0, primitive_count }, 0 );
+        return;
+    }
+
+    task.m_SetSize = primitive_count;
+    task.m_MinRange = 1;
+    task_scheduler->AddTaskSetToPipe( &task );
+    task_scheduler->WaitforTask( &task );
+}
+
+// Bake ///////////////////////////////////////////////////////////////////
+
+BakedScene* gltf_bake_scene( cstring filename, BlobSerializer& blob, Allocator* allocator, StackAllocator* temp_allocator, u32 flags, enki::TaskScheduler* task_scheduler ) {
+    ZoneScoped;
+
+    sizet temp_marker = temp_allocator->get_marker();
+
+    i64 start_bake = time_now();
+
+    glTF::glTF gltf_scene = gltf_load_file( filename );
+    if ( gltf_scene.scenes_count == 0 ) {
+        rprint( "Error baking scene %s: cannot load glTF file.\n", filename );
+        gltf_free( gltf_scene );
+        return nullptr;
+    }
+
+    i64 end_loading_file = time_now();
+
+    // Map all binary buffers, vertex data is read straight from the mapping.
+    // The OS reads them in the background while meshlets are built from the first pages.
+    Array<MappedFile> buffers_data;
+    buffers_data.init( temp_allocator, gltf_scene.buffers_count, gltf_scene.buffers_count );
+
+    bool buffers_valid = true;
+    for ( u32 buffer_index = 0; buffer_index < gltf_scene.buffers_count; ++buffer_index ) {
+        glTF::Buffer& buffer = gltf_scene.buffers[ buffer_index ];
+
+        MappedFile& buffer_data = buffers_data[ buffer_index ];
+        buffer_data = MappedFile{};
+        // .glb binary chunk, already mapped with the glTF file.
+        if ( buffer.data != nullptr ) {
+            buffer_data.data = ( char* )buffer.data;
+            buffer_data.size = buffer.byte_length;
+            continue;
+        }
+        if ( buffer.uri.data == nullptr || !file_map( buffer.uri.data, &buffer_data, FileMapFlags_WillNeed ) || buffer_data.size < ( sizet )buffer.byte_length ) {
+            rprint( "Error baking scene %s: cannot read buffer %s.\n", filename, buffer.uri.data );
+            buffers_valid = false;
+        }
+    }
+
+    if ( !buffers_valid ) {
+        baked_unmap_buffers( gltf_scene, buffers_data );
+        gltf_free( gltf_scene );
+        temp_allocator->free_marker( temp_marker );
+        return nullptr;
+    }
+
+    // Images stored in buffers are written next to the scene, textures are always loaded from files.
+    for ( u32 image_index = 0; image_index < gltf_scene.images_count; ++image_index ) {
+        baked_extract_image( gltf_scene, buffers_data, filename, image_index );
+    }
+
+    // Sampler linked to each image, filled while reading materials.
+    Array<i32> image_samplers;
+    image_samplers.init( temp_allocator, gltf_scene.images_count, gltf_scene.images_count );
+    for ( u32 image_index = 0; image_index < gltf_scene.images_count; ++image_index ) {
+        image_samplers[ image_index ] = -1;
+    }
+
+    // Build meshlets
+    MeshletBuildParameters build_parameters{ };
+    build_parameters.max_vertices = 64;
+    build_parameters.max_triangles = 124;
+    build_parameters.cone_weight = 0.0f;
+    build_parameters.lod_count = k_max_mesh_lods;
+    build_parameters.lod_index_ratio = 0.5f;
+    build_parameters.lod_max_error = 0.1f;
+
+    const bool use_meshlet_cache = ( flags & BakeFlags_MeshletCache ) != 0;
+    MeshletCache meshlet_cache;
+    if ( use_meshlet_cache ) {
+        meshlet_cache.init( k_meshlet_cache_directory );
+    }
+
+    Array<u32> gltf_mesh_to_mesh_offset;
+    gltf_mesh_to_mesh_offset.init( temp_allocator, gltf_scene.meshes_count );
+
+    u32 primitive_count = 0;
+    for ( u32 mi = 0; mi < gltf_scene.meshes_count; ++mi ) {
+        primitive_count += gltf_scene.meshes[ mi ].primitives_count;
+    }
+
+    // Accessors used by more than one primitive are left as authored, reordering them for one would break the others.
+    const bool optimize_meshes = ( flags & BakeFlags_OptimizeMeshes ) != 0;
+    Array<u32> accessor_references;
+    accessor_references.init( temp_allocator, gltf_scene.accessors_count, gltf_scene.accessors_count );
+    memset( accessor_references.data, 0, sizeof( u32 ) * gltf_scene.accessors_count );
+
+    if ( optimize_meshes ) {
+        for ( u32 mi = 0; mi < gltf_scene.meshes_count; ++mi ) {
+            glTF::Mesh& gltf_mesh = gltf_scene.meshes[ mi ];
+
+            for ( u32 p = 0; p < gltf_mesh.primitives_count; ++p ) {
+                glTF::MeshPrimitive& mesh_primitive = gltf_mesh.primitives[ p ];
+
+                ++accessor_references[ mesh_primitive.indices ];
+                for ( u32 a = 0; a < mesh_primitive.attribute_count; ++a ) {
+                    ++accessor_references[ mesh_primitive.attributes[ a ].accessor_index ];
+                }
+            }
+        }
+    }
+
+    // Primitives are gathered first, then meshlets are built in parallel and copied at their
+    // offset in the scene arrays, computed as prefix sums of the built sizes.
+    Array<BakePrimitive> primitives;
+    primitives.init( temp_allocator, primitive_count );
+
+    // Growing arrays live in the heap, so that per primitive temporary memory can be freed.
+    Array<BakedMesh> meshes;
+    meshes.init( allocator, primitive_count );
+
+    Array<GpuMeshlet> meshlets;
+    meshlets.init( allocator, 16 );
+    Array<GpuMeshletVertexPosition> meshlets_vertex_positions;
+    meshlets_vertex_positions.init( allocator, 16 );
+    Array<GpuMeshletVertexData> meshlets_vertex_data;
+    meshlets_vertex_data.init( allocator, 16 );
+    Array<u32> meshlets_data;
+    meshlets_data.init( allocator, 16 );
+    u32 meshlets_index_count = 0;
+
+    vec3s aabb[ 2 ];
+    aabb[ 0 ] = vec3s{ FLT_MAX, FLT_MAX, FLT_MAX };
+    aabb[ 1 ] = vec3s{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    for ( u32 mi = 0; mi < gltf_scene.meshes_count; ++mi ) {
+        glTF::Mesh& gltf_mesh = gltf_scene.meshes[ mi ];
+
+        gltf_mesh_to_mesh_offset.push( meshes.size );
+
+        for ( u32 p = 0; p < gltf_mesh.primitives_count; ++p ) {
+            glTF::MeshPrimitive& mesh_primitive = gltf_mesh.primitives[ p ];
+
+            BakedMesh mesh{};
+            // Same defaults as PBRMaterial
+            mesh.material.base_color_factor = { 1.f, 1.f, 1.f, 1.f };
+            mesh.material.emissive_factor = { 0.f, 0.f, 0.f };
+            mesh.material.roughness = 1.f;
+            mesh.material.alpha_cutoff = 1.f;
+            mesh.material.diffuse_image = k_invalid_scene_texture_index;
+            mesh.material.roughness_image = k_invalid_scene_texture_index;
+            mesh.material.normal_image = k_invalid_scene_texture_index;
+            mesh.material.occlusion_image = k_invalid_scene_texture_index;
+            mesh.material.emissive_image = k_invalid_scene_texture_index;
+            mesh.skin_index = i32_max;
+
+            // Vertex positions
+            const i32 position_accessor_index = gltf_get_attribute_accessor_index( mesh_primitive.attributes, mesh_primitive.attribute_count, "POSITION" );
+            glTF::Accessor& position_buffer_accessor = gltf_scene.accessors[ position_accessor_index ];
+            const f32* vertices = ( const f32* )baked_accessor_data( gltf_scene, buffers_data, position_accessor_index );
+
+            // Calculate bounding sphere center
+            vec3s position_min{ position_buffer_accessor.min[ 0 ], position_buffer_accessor.min[ 1 ], position_buffer_accessor.min[ 2 ] };
+            vec3s position_max{ position_buffer_accessor.max[ 0 ], position_buffer_accessor.max[ 1 ], position_buffer_accessor.max[ 2 ] };
+            vec3s bounding_center = glms_vec3_add( position_min, position_max );
+            bounding_center = glms_vec3_divs( bounding_center, 2.0f );
+
+            // Calculate bounding sphere radius
+            f32 radius = raptor::max( glms_vec3_distance( position_max, bounding_center ), glms_vec3_distance( position_min, bounding_center ) );
+            mesh.bounding_sphere = { bounding_center.x, bounding_center.y, bounding_center.z, radius };
+
+            const i32 normal_accessor_index = gltf_get_attribute_accessor_index( mesh_primitive.attributes, mesh_primitive.attribute_count, "NORMAL" );
+            const f32* normals = normal_accessor_index != -1 ? ( const f32* )baked_accessor_data( gltf_scene, buffers_data, normal_accessor_index ) : nullptr;
+
+            const i32 tex_coord_accessor_index = gltf_get_attribute_accessor_index( mesh_primitive.attributes, mesh_primitive.attribute_count, "TEXCOORD_0" );
+            const f32* tex_coords = tex_coord_accessor_index != -1 ? ( const f32* )baked_accessor_data( gltf_scene, buffers_data, tex_coord_accessor_index ) : nullptr;
+
+            const i32 tangent_accessor_index = gltf_get_attribute_accessor_index( mesh_primitive.attributes, mesh_primitive.attribute_count, "TANGENT" );
+            const f32* tangents = tangent_accessor_index != -1 ? ( const f32* )baked_accessor_data( gltf_scene, buffers_data, tangent_accessor_index ) : nullptr;
+
+            const i32 joints_accessor_index = gltf_get_attribute_accessor_index( mesh_primitive.attributes, mesh_primitive.attribute_count, "JOINTS_0" );
+            const i32 weights_accessor_index = gltf_get_attribute_accessor_index( mesh_primitive.attributes, mesh_primitive.attribute_count, "WEIGHTS_0" );
+
+            // Cache vertex buffers
+            baked_vertex_buffer( gltf_scene, position_accessor_index, 0, mesh.position_buffer, mesh.position_offset, mesh.material.flags );
+            baked_vertex_buffer( gltf_scene, tangent_accessor_index, DrawFlags_HasTangents, mesh.tangent_buffer, mesh.tangent_offset, mesh.material.flags );
+            baked_vertex_buffer( gltf_scene, normal_accessor_index, DrawFlags_HasNormals, mesh.normal_buffer, mesh.normal_offset, mesh.material.flags );
+            baked_vertex_buffer( gltf_scene, tex_coord_accessor_index, DrawFlags_HasTexCoords, mesh.texcoord_buffer, mesh.texcoord_offset, mesh.material.flags );
+            baked_vertex_buffer( gltf_scene, joints_accessor_index, DrawFlags_HasJoints, mesh.joints_buffer, mesh.joints_offset, mesh.material.flags );
+            baked_vertex_buffer( gltf_scene, weights_accessor_index, DrawFlags_HasWeights, mesh.weights_buffer, mesh.weights_offset, mesh.material.flags );
+
+            // Index buffer
+            glTF::Accessor& indices_accessor = gltf_scene.accessors[ mesh_primitive.indices ];
+            u32 index_flags = 0;
+            baked_vertex_buffer( gltf_scene, mesh_primitive.indices, 0, mesh.index_buffer, mesh.index_offset, index_flags );
+            const u16* indices = ( const u16* )baked_accessor_data( gltf_scene, buffers_data, mesh_primitive.indices );
+
+            mesh.index_type = VK_INDEX_TYPE_UINT16;
+            mesh.primitive_count = indices_accessor.count;
+
+            // Read pbr material data if present
+            if ( mesh_primitive.material != glTF::INVALID_INT_VALUE ) {
+                glTF::Material& material = gltf_scene.materials[ mesh_primitive.material ];
+                baked_fill_material( gltf_scene, material, mesh.material, image_samplers );
+            }
+
+            BakePrimitive& primitive = primitives.push_use();
+            primitive.indices = indices;
+            primitive.vertices = vertices;
+            primitive.normals = normals;
+            primitive.tangents = tangents;
+            primitive.tex_coords = tex_coords;
+            primitive.index_count = indices_accessor.count;
+            primitive.vertex_count = position_buffer_accessor.count;
+
+            primitive.indices_size = baked_accessor_size( indices_accessor );
+            primitive.vertices_size = baked_accessor_size( position_buffer_accessor );
+            primitive.normals_size = normals ? baked_accessor_size( gltf_scene.accessors[ normal_accessor_index ] ) : 0;
+            primitive.tangents_size = tangents ? baked_accessor_size( gltf_scene.accessors[ tangent_accessor_index ] ) : 0;
+            primitive.tex_coords_size = tex_coords ? baked_accessor_size( gltf_scene.accessors[ tex_coord_accessor_index ] ) : 0;
+
+            primitive.gltf_primitive = &mesh_primitive;
+            primitive.optimize = optimize_meshes && accessor_references[ mesh_primitive.indices ] == 1 && indices_accessor.component_type == glTF::Accessor::UNSIGNED_SHORT;
+            primitive.remap_vertices = primitive.optimize;
+            for ( u32 a = 0; a < mesh_primitive.attribute_count && primitive.remap_vertices; ++a ) {
+                const i32 accessor_index = mesh_primitive.attributes[ a ].accessor_index;
+                const glTF::Accessor& accessor = gltf_scene.accessors[ accessor_index ];
+
+                primitive.remap_vertices = accessor_references[ accessor_index ] == 1 && accessor.count == position_buffer_accessor.count && baked_accessor_packed( gltf_scene, accessor );
+            }
+
+            primitive.cache_key = 0;
+            primitive.source_primitive = primitives.size - 1;
+            primitive.blob = BlobSerializer{ };
+            primitive.meshlets = nullptr;
+
+            // Add mesh with all data, meshlets are filled once built.
+            meshes.push( mesh );
+        }
+    }
+
+    i64 end_gathering_primitives = time_now();
+
+    BakeMeshletsTask meshlets_task;
+    meshlets_task.primitives = primitives.data;
+    meshlets_task.meshlet_cache = use_meshlet_cache ? &meshlet_cache : nullptr;
+    meshlets_task.allocator = allocator;
+    meshlets_task.build_parameters = build_parameters;
+    meshlets_task.gltf_scene = &gltf_scene;
+    meshlets_task.buffers_data = &buffers_data;
+
+    // Optimized data is what gets keyed, built and copied in the scene buffers.
+    if ( optimize_meshes ) {
+        meshlets_task.phase = BakeMeshletsTask::Phase_Optimize;
+        baked_run_meshlets_task( task_scheduler, meshlets_task, primitive_count );
+    }
+
+    i64 end_optimizing_primitives = time_now();
+
+    // Keyed primitives with the same data build once, that also keeps two tasks from writing the same cache entry.
+    u32 unique_primitive_count = primitive_count;
+    if ( use_meshlet_cache ) {
+        meshlets_task.phase = BakeMeshletsTask::Phase_CacheKeys;
+        baked_run_meshlets_task( task_scheduler, meshlets_task, primitive_count );
+
+        FlatHashMap<u64, u32> primitive_keys;
+        primitive_keys.init( allocator, primitive_count );
+
+        for ( u32 primitive_index = 0; primitive_index < primitive_count; ++primitive_index ) {
+            BakePrimitive& primitive = primitives[ primitive_index ];
+
+            FlatHashMapIterator it = primitive_keys.find( primitive.cache_key );
+            if ( it.is_valid() ) {
+                primitive.source_primitive = primitive_keys.get( it );
+                --unique_primitive_count;
+            }
+            else {
+                primitive_keys.insert( primitive.cache_key, primitive_index );
+            }
+        }
+
+        primitive_keys.shutdown();
+    }
+
+    // Build only the unique primitives, moving them in front keeps the task ranges balanced.
+    Array<BakePrimitive*> unique_primitives;
+    unique_primitives.init( temp_allocator, unique_primitive_count );
+    for ( u32 primitive_index = 0; primitive_index < primitive_count; ++primitive_index ) {
+        if ( primitives[ primitive_index ].source_primitive == primitive_index ) {
+            unique_primitives.push( &primitives[ primitive_index ] );
+        }
+    }
+
+    meshlets_task.phase = BakeMeshletsTask::Phase_Build;
+    meshlets_task.unique_primitives = unique_primitives.data;
+    baked_run_meshlets_task( task_scheduler, meshlets_task, unique_primitives.size );
+
+    i64 end_building_primitives = time_now();
+
+    // Prefix sums of the built sizes give each primitive its place in the scene arrays.
+    u32 meshlet_total = 0, vertex_total = 0, data_total = 0;
+    u64 lod_triangle_counts[ k_max_mesh_lods ]{ };
+    u32 lod_primitive_counts[ k_max_mesh_lods ]{ };     // Primitives by number of levels.
+    for ( u32 primitive_index = 0; primitive_index < primitive_count; ++primitive_index ) {
+        BakePrimitive& primitive = primitives[ primitive_index ];
+        const MeshletCacheEntry& entry = *primitives[ primitive.source_primitive ].meshlets;
+
+        primitive.meshlet_offset = meshlet_total;
+        primitive.vertex_offset = vertex_total;
+        primitive.data_offset = data_total;
+
+        // Cache meshlet offset of each level
+        BakedMesh& mesh = meshes[ primitive_index ];
+        mesh.lod_count = entry.lod_count;
+        for ( u32 l = 0; l < entry.lod_count; ++l ) {
+            mesh.lods[ l ] = entry.lods[ l ];
+            mesh.lods[ l ].meshlet_offset = meshlet_total;
+
+            meshlet_total += baked_padded_meshlet_count( entry.lods[ l ].meshlet_count );
+
+            lod_triangle_counts[ l ] += entry.lods[ l ].meshlet_index_count / 3;
+        }
+        lod_primitive_counts[ entry.lod_count - 1 ] += 1;
+
+        vertex_total += entry.vertex_positions.size;
+        data_total += entry.meshlets_data.size;
+
+        mesh.meshlet_offset = mesh.lods[ 0 ].meshlet_offset;
+        mesh.meshlet_count = mesh.lods[ 0 ].meshlet_count;
+        mesh.meshlet_index_count = mesh.lods[ 0 ].meshlet_index_count;
+
+        meshlets_index_count += entry.index_group_count;
+
+        if ( entry.vertex_positions.size ) {
+            aabb[ 0 ] = glms_vec3_minv( aabb[ 0 ], entry.aabb[ 0 ] );
+            aabb[ 1 ] = glms_vec3_maxv( aabb[ 1 ], entry.aabb[ 1 ] );
+        }
+    }
+
+    meshlets.set_size( meshlet_total );
+    meshlets_vertex_positions.set_size( vertex_total );
+    meshlets_vertex_data.set_size( vertex_total );
+    meshlets_data.set_size( data_total );
+
+    meshlets_task.phase = BakeMeshletsTask::Phase_Copy;
+    meshlets_task.meshlets = meshlets.data;
+    meshlets_task.meshlets_vertex_positions = meshlets_vertex_positions.data;
+    meshlets_task.meshlets_vertex_data = meshlets_vertex_data.data;
+    meshlets_task.meshlets_data = meshlets_data.data;
+    baked_run_meshlets_task( task_scheduler, meshlets_task, primitive_count );
+
+    for ( u32 primitive_index = 0; primitive_index < primitive_count; ++primitive_index ) {
+        primitives[ primitive_index ].blob.shutdown();
+    }
+
+    i64 end_building_meshlets = time_now();
+
+    // Compose node transforms and collect mesh instances.
+    // Nodes keep their glTF index, so joints and animation channels can refer to them directly.
+    Array<BakeNode> nodes;
+    nodes.init( temp_allocator, gltf_scene.nodes_count, gltf_scene.nodes_count );
+    for ( u32 node_index = 0; node_index < gltf_scene.nodes_count; ++node_index ) {
+        nodes[ node_index ] = { glms_mat4_identity(), -1, 0 };
+    }
+
+    Array<BakedMeshInstance> mesh_instances;
+    mesh_instances.init( temp_allocator, 32 );
+
+    Array<i32> nodes_to_visit;
+    nodes_to_visit.init( temp_allocator, 4 );
+
+    glTF::Scene& root_gltf_scene = gltf_scene.scenes[ gltf_scene.scene ];
+    for ( u32 node_index = 0; node_index < root_gltf_scene.nodes_count; ++node_index ) {
+        nodes_to_visit.push( root_gltf_scene.nodes[ node_index ] );
+    }
+
+    while ( nodes_to_visit.size ) {
+        i32 node_index = nodes_to_visit.front();
+        nodes_to_visit.delete_swap( 0 );
+
+        glTF::Node& node = gltf_scene.nodes[ node_index ];
+        BakeNode& bake_node = nodes[ node_index ];
+
+        // Compute local transform: read either raw matrix or individual Scale/Rotation/Translation components
+        if ( node.matrix_count ) {
+            // CGLM and glTF have the same matrix layout, just memcopy it
+            memcpy( &bake_node.local_matrix, node.matrix, sizeof( mat4s ) );
+        } else {
+            // Handle individual transform components: SRT (scale, rotation, translation)
+            Transform transform;
+            transform.scale = vec3s{ 1.0f, 1.0f, 1.0f };
+            if ( node.scale_count ) {
+                RASSERT( node.scale_count == 3 );
+                transform.scale = vec3s{ node.scale[ 0 ], node.scale[ 1 ], node.scale[ 2 ] };
+            }
+
+            transform.translation = vec3s{ 0.f, 0.f, 0.f };
+            if ( node.translation_count ) {
+                RASSERT( node.translation_count == 3 );
+                transform.translation = vec3s{ node.translation[ 0 ], node.translation[ 1 ], node.translation[ 2 ] };
+            }
+
+            // Rotation is written as a plain quaternion
+            transform.rotation = glms_quat_identity();
+            if ( node.rotation_count ) {
+                RASSERT( node.rotation_count == 4 );
+                transform.rotation = glms_quat_init( node.rotation[ 0 ], node.rotation[ 1 ], node.rotation[ 2 ], node.rotation[ 3 ] );
+            }
+
+            // Final SRT composition
+            bake_node.local_matrix = transform.calculate_matrix();
+        }
+
+        // Handle parent-relationship
+        for ( u32 ch = 0; ch < node.children_count; ++ch ) {
+            const i32 children_index = node.children[ ch ];
+            nodes[ children_index ].parent = node_index;
+            nodes[ children_index ].level = bake_node.level + 1;
+
+            nodes_to_visit.push( children_index );
+        }
+
+        if ( node.mesh == glTF::INVALID_INT_VALUE ) {
+            continue;
+        }
+
+        // Gltf primitives are conceptually submeshes.
+        glTF::Mesh& gltf_mesh = gltf_scene.meshes[ node.mesh ];
+        u32 gltf_mesh_offset = gltf_mesh_to_mesh_offset[ node.mesh ];
+
+        for ( u32 primitive_index = 0; primitive_index < gltf_mesh.primitives_count; ++primitive_index ) {
+            const u32 mesh_index = gltf_mesh_offset + primitive_index;
+
+            // Found a skin index, cache it
+            if ( node.skin != glTF::INVALID_INT_VALUE ) {
+                RASSERT( node.skin < ( i32 )gltf_scene.skins_count );
+
+                meshes[ mesh_index ].skin_index = node.skin;
+            }
+
+            mesh_instances.push( { mesh_index, ( u32 )node_index } );
+        }
+    }
+
+    Array<u32> image_mip_flags;
+    image_mip_flags.init( temp_allocator, gltf_scene.images_count, gltf_scene.images_count );
+    memset( image_mip_flags.data, 0, sizeof( u32 ) * gltf_scene.images_count );
+
+    Array<f32> image_alpha_cutoffs;
+    image_alpha_cutoffs.init( temp_allocator, gltf_scene.images_count, gltf_scene.images_count );
+    memset( image_alpha_cutoffs.data, 0, sizeof( f32 ) * gltf_scene.images_count );
+
+    baked_image_mip_flags( meshes, image_mip_flags, image_alpha_cutoffs );
+
+    if ( flags & BakeFlags_CookTextures ) {
+        baked_cook_images( gltf_scene, image_mip_flags, image_alpha_cutoffs, allocator );
+    }
+
+    // Calculate blob size
+    sizet blob_size = sizeof( BakedScene );
+
+    blob_size += baked_array_size<BakedImage>( gltf_scene.images_count );
+    for ( u32 image_index = 0; image_index < gltf_scene.images_count; ++image_index ) {
+        blob_size += gltf_scene.images[ image_index ].uri.current_size + 1;
+    }
+
+    blob_size += baked_array_size<BakedSampler>( gltf_scene.samplers_count );
+
+    blob_size += baked_array_size<BakedBuffer>( gltf_scene.buffers_count );
+    for ( u32 buffer_index = 0; buffer_index < gltf_scene.buffers_count; ++buffer_index ) {
+        blob_size += baked_array_size<u8>( gltf_scene.buffers[ buffer_index ].byte_length );
+    }
+
+    blob_size += baked_array_size<BakedMesh>( meshes.size );
+    blob_size += baked_array_size<BakedMeshInstance>( mesh_instances.size );
+
+    blob_size += baked_array_size<BakedNode>( nodes.size );
+    for ( u32 node_index = 0; node_index < gltf_scene.nodes_count; ++node_index ) {
+        blob_size += gltf_scene.nodes[ node_index ].name.current_size + 1;
+    }
+
+    blob_size += baked_array_size<GpuMeshlet>( meshlets.size );
+    blob_size += baked_array_size<GpuMeshletVertexPosition>( meshlets_vertex_positions.size );
+    blob_size += baked_array_size<GpuMeshletVertexData>( meshlets_vertex_data.size );
+    blob_size += baked_array_size<u32>( meshlets_data.size );
+
+    blob_size += baked_array_size<BakedAnimation>( gltf_scene.animations_count );
+    for ( u32 animation_index = 0; animation_index < gltf_scene.animations_count; ++animation_index ) {
+        glTF::Animation& gltf_animation = gltf_scene.animations[ animation_index ];
+
+        blob_size += baked_array_size<AnimationChannel>( gltf_animation.channels_count );
+        blob_size += baked_array_size<BakedAnimationSampler>( gltf_animation.samplers_count );
+        for ( u32 sampler_index = 0; sampler_index < gltf_animation.samplers_count; ++sampler_index ) {
+            const glTF::AnimationSampler& gltf_sampler = gltf_animation.samplers[ sampler_index ];
+            const u32 key_frames_count = gltf_scene.accessors[ gltf_sampler.input_keyframe_buffer_index ].count;
+            const u32 data_count = gltf_scene.accessors[ gltf_sampler.output_keyframe_buffer_index ].count;
+            blob_size += baked_array_size<f32>( key_frames_count ) + baked_array_size<vec4s>( data_count );
+        }
+    }
+
+    blob_size += baked_array_size<BakedSkin>( gltf_scene.skins_count );
+    for ( u32 skin_index = 0; skin_index < gltf_scene.skins_count; ++skin_index ) {
+        const u32 joints_count = gltf_scene.skins[ skin_index ].joints_count;
+        blob_size += baked_array_size<i32>( joints_count ) + baked_array_size<mat4s>( joints_count );
+    }
+
+    RASSERTM( blob_size < u32_max, "Baked scene %s is too big for a single blob", filename );
+
+    // Write blob
+    BakedScene* baked_scene = blob.write_and_prepare<BakedScene>( allocator, k_baked_scene_version, blob_size );
+
+    blob.allocate_and_set( baked_scene->images, gltf_scene.images_count );
+    for ( u32 image_index = 0; image_index < gltf_scene.images_count; ++image_index ) {
+        glTF::Image& image = gltf_scene.images[ image_index ];
+        BakedImage& baked_image = baked_scene->images[ image_index ];
+
+        int comp, width = 0, height = 0;
+        u32 mip_levels = 1;
+        VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+
+        // Cooked textures come with all their mips, the others generate them on the loader threads after decoding.
+        cstring image_extension = image.uri.data ? strrchr( image.uri.data, '.' ) : nullptr;
+        const bool is_cooked = image_extension != nullptr && strcmp( image_extension, ".dds" ) == 0;
+
+        MappedFile cooked_file;
+        CookedTexture cooked_texture;
+        if ( is_cooked && file_map( image.uri.data, &cooked_file ) ) {
+            if ( dds_read( ( const u8* )cooked_file.data, cooked_file.size, &cooked_texture ) ) {
+                width = ( int )cooked_texture.width;
+                height = ( int )cooked_texture.height;
+                mip_levels = cooked_texture.mip_levels;
+                format = baked_cooked_format( cooked_texture.format );
+            }
+            else {
+                rprint( "Error baking scene %s: invalid cooked texture %s.\n", filename, image.uri.data );
+                width = height = 1;
+            }
+            file_unmap( &cooked_file );
+        }
+        else {
+            stbi_info( image.uri.data, &width, &height, &comp );
+            mip_levels = texture_mip_count( width, height );
+        }
+
+        blob.allocate_and_set( baked_image.uri, image.uri.data, image.uri.current_size );
+        baked_image.width = ( u16 )width;
+        baked_image.height = ( u16 )height;
+        baked_image.mip_levels = mip_levels;
+        baked_image.sampler_index = image_samplers[ image_index ];
+        baked_image.format = format;
+        baked_image.mip_flags = image_mip_flags[ image_index ];
+        baked_image.alpha_cutoff = image_alpha_cutoffs[ image_index ];
+    }
+
+    blob.allocate_and_set( baked_scene->samplers, gltf_scene.samplers_count );
+    for ( u32 sampler_index = 0; sampler_index < gltf_scene.samplers_count; ++sampler_index ) {
+        baked_sampler_from_gltf( gltf_scene.samplers[ sampler_index ], baked_scene->samplers[ sampler_index ] );
+    }
+
+    blob.allocate_and_set( baked_scene->buffers, gltf_scene.buffers_count );
+    for ( u32 buffer_index = 0; buffer_index < gltf_scene.buffers_count; ++buffer_index ) {
+        blob.allocate_and_set( baked_scene->buffers[ buffer_index ].data, gltf_scene.buffers[ buffer_index ].byte_length, buffers_data[ buffer_index ].data );
+    }
+
+    blob.allocate_and_set( baked_scene->meshes, meshes.size, meshes.data );
+    blob.allocate_and_set( baked_scene->mesh_instances, mesh_instances.size, mesh_instances.data );
+
+    blob.allocate_and_set( baked_scene->nodes, nodes.size );
+    for ( u32 node_index = 0; node_index < nodes.size; ++node_index ) {
+        const BakeNode& bake_node = nodes[ node_index ];
+        BakedNode& baked_node = baked_scene->nodes[ node_index ];
+
+        baked_node.local_matrix = bake_node.local_matrix;
+        baked_node.parent = bake_node.parent;
+        baked_node.level = bake_node.level;
+
+        glTF::Node& node = gltf_scene.nodes[ node_index ];
+        blob.allocate_and_set( baked_node.name, node.name.data ? node.name.data : ( char* )"", node.name.current_size );
+    }
+
+    blob.allocate_and_set( baked_scene->meshlets, meshlets.size, meshlets.data );
+    blob.allocate_and_set( baked_scene->meshlets_vertex_positions, meshlets_vertex_positions.size, meshlets_vertex_positions.data );
+    blob.allocate_and_set( baked_scene->meshlets_vertex_data, meshlets_vertex_data.size, meshlets_vertex_data.data );
+    blob.allocate_and_set( baked_scene->meshlets_data, meshlets_data.size, meshlets_data.data );
+    baked_scene->meshlets_index_count = meshlets_index_count;
+
+    // Animations
+    blob.allocate_and_set( baked_scene->animations, gltf_scene.animations_count );
+    for ( u32 animation_index = 0; animation_index < gltf_scene.animations_count; ++animation_index ) {
+        glTF::Animation& gltf_animation = gltf_scene.animations[ animation_index ];
+        BakedAnimation& animation = baked_scene->animations[ animation_index ];
+
+        animation.time_start = FLT_MAX;
+        animation.time_end = -FLT_MAX;
+
+        blob.allocate_and_set( animation.channels, gltf_animation.channels_count );
+        for ( u32 channel_index = 0; channel_index < gltf_animation.channels_count; ++channel_index ) {
+            glTF::AnimationChannel& gltf_channel = gltf_animation.channels[ channel_index ];
+            AnimationChannel& channel = animation.channels[ channel_index ];
+
+            channel.sampler = gltf_channel.sampler;
+            channel.target_node = gltf_channel.target_node;
+            channel.target_type = ( raptor::AnimationChannel::TargetType )gltf_channel.target_type;
+        }
+
+        blob.allocate_and_set( animation.samplers, gltf_animation.samplers_count );
+        for ( u32 sampler_index = 0; sampler_index < gltf_animation.samplers_count; ++sampler_index ) {
+            glTF::AnimationSampler& gltf_sampler = gltf_animation.samplers[ sampler_index ];
+            BakedAnimationSampler& sampler = animation.samplers[ sampler_index ];
+
+            sampler.interpolation_type = gltf_sampler.interpolation;
+
+            // Copy keyframe data
+            glTF::Accessor& key_frames_accessor = gltf_scene.accessors[ gltf_sampler.input_keyframe_buffer_index ];
+            const f32* key_frames = ( const f32* )baked_accessor_data( gltf_scene, buffers_data, gltf_sampler.input_keyframe_buffer_index );
+
+            blob.allocate_and_set( sampler.key_frames, key_frames_accessor.count, ( void* )key_frames );
+            for ( u32 i = 0; i < ( u32 )key_frames_accessor.count; ++i ) {
+                animation.time_start = glm_min( animation.time_start, key_frames[ i ] );
+                animation.time_end = glm_max( animation.time_end, key_frames[ i ] );
+            }
+
+            // Copy animation data, always expanded to vec4.
+            glTF::Accessor& data_accessor = gltf_scene.accessors[ gltf_sampler.output_keyframe_buffer_index ];
+            const f32* animation_data = ( const f32* )baked_accessor_data( gltf_scene, buffers_data, gltf_sampler.output_keyframe_buffer_index );
+
+            // Cubic splines store in tangent, value and out tangent for each key frame.
+            const u32 data_count = ( u32 )data_accessor.count;
+            RASSERT( data_count == key_frames_accessor.count * ( gltf_sampler.interpolation == glTF::AnimationSampler::CubicSpline ? 3 : 1 ) );
+            blob.allocate_and_set( sampler.data, data_count );
+
+            switch ( data_accessor.type ) {
+                case glTF::Accessor::Vec3:
+                {
+                    for ( u32 i = 0; i < data_count; ++i ) {
+                        sampler.data[ i ] = vec4s{ animation_data[ i * 3 ], animation_data[ i * 3 + 1 ], animation_data[ i * 3 + 2 ], 0.f };
+                    }
+                    break;
+                }
+                case glTF::Accessor::Vec4:
+                {
+                    for ( u32 i = 0; i < data_count; ++i ) {
+                        sampler.data[ i ] = vec4s{ animation_data[ i * 4 ], animation_data[ i * 4 + 1 ], animation_data[ i * 4 + 2 ], animation_data[ i * 4 + 3 ] };
+                    }
+                    break;
+                }
+                default:
+                {
+                    RASSERT( false );
+                    break;
+                }
+            }
+        }
+    }
+
+    // Skins
+    blob.allocate_and_set( baked_scene->skins, gltf_scene.skins_count );
+    for ( u32 skin_index = 0; skin_index < gltf_scene.skins_count; ++skin_index ) {
+        glTF::Skin& gltf_skin = gltf_scene.skins[ skin_index ];
+        BakedSkin& skin = baked_scene->skins[ skin_index ];
+
+        skin.skeleton_root_index = gltf_skin.skeleton_root_node_index;
+        blob.allocate_and_set( skin.joints, gltf_skin.joints_count, gltf_skin.joints );
+
+        RASSERT( ( u32 )gltf_scene.accessors[ gltf_skin.inverse_bind_matrices_buffer_index ].count == gltf_skin.joints_count );
+        u8* inverse_bind_matrices = baked_accessor_data( gltf_scene, buffers_data, gltf_skin.inverse_bind_matrices_buffer_index );
+        blob.allocate_and_set( skin.inverse_bind_matrices, gltf_skin.joints_count, inverse_bind_matrices );
+    }
+
+    baked_scene->aabb[ 0 ] = aabb[ 0 ];
+    baked_scene->aabb[ 1 ] = aabb[ 1 ];
+
+    RASSERT( blob.allocated_offset <= blob.total_size );
+
+    i64 end_bake = time_now();
+
+    rprint( "Baked scene %s in %f seconds, %u KB.\nStats:\n\tReading GLTF file %f seconds\n\tBuilding meshlets %f seconds\n\tWriting blob %f seconds\n", filename,
+            time_delta_seconds( start_bake, end_bake ), blob.allocated_offset / 1024, time_delta_seconds( start_bake, end_loading_file ),
+            time_delta_seconds( end_loading_file, end_building_meshlets ), time_delta_seconds( end_building_meshlets, end_bake ) );
+    rprint( "\tMeshlets breakdown:\n\t\tGathering %u primitives %f seconds\n\t\tBuilding %u unique primitives on %u threads %f seconds\n\t\tCopying to the scene arrays %f seconds\n",
+            primitive_count, time_delta_seconds( end_loading_file, end_gathering_primitives ), unique_primitive_count, task_scheduler ? task_scheduler->GetNumTaskThreads() : 1,
+            time_delta_seconds( end_optimizing_primitives, end_building_primitives ), time_delta_seconds( end_building_primitives, end_building_meshlets ) );
+    if ( use_meshlet_cache ) {
+        meshlet_cache.print_stats();
+    }
+
+    // Simplification stops early for small or hard to simplify primitives, later levels have fewer of them.
+    rprint( "\tLevels of detail:\n" );
+    u32 lod_primitives = primitive_count;
+    for ( u32 l = 0; l < k_max_mesh_lods && lod_primitives; ++l ) {
+        rprint( "\t\tLevel %u: %u primitives, %llu triangles (%.1f%% of level 0)\n", l, lod_primitives, ( unsigned long long )lod_triangle_counts[ l ],
+                lod_triangle_counts[ 0 ] ? lod_triangle_counts[ l ] * 100.0 / lod_triangle_counts[ 0 ] : 0.0 );
+        lod_primitives -= lod_primitive_counts[ l ];
+    }
+
+    if ( optimize_meshes ) {
+        u32 optimized_count = 0, remapped_count = 0;
+        u64 triangle_count = 0, vertex_count = 0;
+        u64 transformed_before = 0, transformed_after = 0, fetched_before = 0, fetched_after = 0;
+        for ( u32 primitive_index = 0; primitive_index < primitive_count; ++primitive_index ) {
+            const BakePrimitive& primitive = primitives[ primitive_index ];
+            if ( !primitive.optimize ) {
+                continue;
+            }
+
+            ++optimized_count;
+            remapped_count += primitive.remap_vertices ? 1 : 0;
+            triangle_count += primitive.index_count / 3;
+            vertex_count += primitive.vertex_count;
+            transformed_before += primitive.stats_before.transformed_vertices;
+            transformed_after += primitive.stats_after.transformed_vertices;
+            fetched_before += primitive.stats_before.fetched_bytes;
+            fetched_after += primitive.stats_after.fetched_bytes;
+        }
+
+        // Overfetch is relative to reading each position once.
+        const f64 triangles = ( f64 )raptor::max<u64>( triangle_count, 1 ), vertices = ( f64 )raptor::max<u64>( vertex_count, 1 );
+        rprint( "\tOptimized %u/%u primitives, %u with reordered vertices, %f seconds\n\t\tACMR %f -> %f, ATVR %f -> %f, overfetch %f -> %f\n",
+                optimized_count, primitive_count, remapped_count, time_delta_seconds( end_gathering_primitives, end_optimizing_primitives ),
+                transformed_before / triangles, transformed_after / triangles, transformed_before / vertices, transformed_after / vertices,
+                fetched_before / ( vertices * sizeof( vec3s ) ), fetched_after / ( vertices * sizeof( vec3s ) ) );
+    }
+
+    baked_unmap_buffers( gltf_scene, buffers_data );
+    gltf_free( gltf_scene );
+
+    meshes.shutdown();
+    meshlets.shutdown();
+    meshlets_vertex_positions.shutdown();
+    meshlets_vertex_data.shutdown();
+    meshlets_data.shutdown();
+
+    temp_allocator->free_marker( temp_marker );
+
+    return baked_scene;
+}
+
+// Load ///////////////////////////////////////////////////////////////////
+
+BakedScene* baked_scene_map( cstring filename, BlobSerializer& blob, Allocator* allocator ) {
+    ZoneScoped;
+
+    // Baked scenes have no serialization code: any other version needs a new bake.
+    BakedScene* baked_scene = blob.read_mapped<BakedScene>( allocator, k_baked_scene_version, filename, FileMapFlags_WillNeed, true );
+    if ( baked_scene == nullptr ) {
+        rprint( "Error loading baked scene %s: invalid or outdated file, bake it again.\n", filename );
+    }
+
+    return baked_scene;
+}
+
+} // namespace raptor
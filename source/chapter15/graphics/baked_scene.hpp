@@ -0,0 +1,206 @@
+#pragma once
+
+#include "foundation/blob.hpp"
+#include "foundation/relative_data_structures.hpp"
+
+#include "graphics/render_scene.hpp"
+
+namespace raptor {
+
+    struct BlobSerializer;
+    struct StackAllocator;
+
+    static const u32        k_baked_scene_version       = 5;
+    static const cstring    k_baked_scene_extension     = "rscene";
+    static const u32        k_baked_invalid_index       = u32_max;
+
+    // Baked scene ////////////////////////////////////////////////////////
+    //
+    // Fully processed scene data: meshlets are built, vertices quantized and node transforms
+    // composed, so loading is only a matter of creating gpu resources.
+    // Indices are local to the baked scene and are rebased when added to a RenderScene.
+    // Only Relative structures are used, so a baked file is used in place once mapped.
+
+    //
+    //
+    struct BakedImage {
+        RelativeString          uri;
+
+        u16                     width;
+        u16                     height;
+        u32                     mip_levels;
+        i32                     sampler_index;      // Sampler linked to the texture, -1 if none.
+        u32                     format;             // VkFormat, block compressed for cooked textures.
+        u32                     mip_flags;          // TextureMipFlags used to generate the mips.
+        f32                     alpha_cutoff;       // Coverage preserved in the mips of alpha tested textures.
+    }; // struct BakedImage
+
+    //
+    //
+    struct BakedSampler {
+        u32                     min_filter;         // VkFilter
+        u32                     mag_filter;         // VkFilter
+        u32                     mip_filter;         // VkSamplerMipmapMode
+        u32                     address_mode_u;     // VkSamplerAddressMode
+        u32                     address_mode_v;     // VkSamplerAddressMode
+    }; // struct BakedSampler
+
+    //
+    //
+    struct BakedBuffer {
+        RelativeArray<u8>       data;
+    }; // struct BakedBuffer
+
+    //
+    //
+    struct BakedMaterial {
+        vec4s                   base_color_factor;
+        vec3s                   emissive_factor;
+
+        f32                     metallic;
+        f32                     roughness;
+        f32                     occlusion;
+        f32                     alpha_cutoff;
+
+        u32                     flags;
+
+        // Indices in the baked images, k_invalid_scene_texture_index if not present.
+        u16                     diffuse_image;
+        u16                     roughness_image;
+        u16                     normal_image;
+        u16                     occlusion_image;
+        u16                     emissive_image;
+        u16                     padding;
+    }; // struct BakedMaterial
+
+    //
+    //
+    struct BakedMesh {
+        BakedMaterial           material;
+
+        // Indices in the baked buffers, k_baked_invalid_index if the attribute is not present.
+        u32                     position_buffer;
+        u32                     tangent_buffer;
+        u32                     normal_buffer;
+        u32                     texcoord_buffer;
+        u32                     joints_buffer;
+        u32                     weights_buffer;
+        u32                     index_buffer;
+
+        u32                     position_offset;
+        u32                     tangent_offset;
+        u32                     normal_offset;
+        u32                     texcoord_offset;
+        u32                     joints_offset;
+        u32                     weights_offset;
+        u32                     index_offset;
+
+        u32                     index_type;         // VkIndexType
+        u32                     primitive_count;
+
+        u32                     meshlet_offset;
+        u32                     meshlet_count;
+        u32                     meshlet_index_count;
+        i32                     skin_index;
+
+        vec4s                   bounding_sphere;
+
+        // Level 0 is the meshlet range above, each level range is padded to 32 meshlets.
+        u32                     lod_count;
+        GpuMeshLod              lods[ k_max_mesh_lods ];
+    }; // struct BakedMesh
+
+    //
+    //
+    struct BakedMeshInstance {
+        u32                     mesh_index;
+        u32                     node_index;
+    }; // struct BakedMeshInstance
+
+    //
+    //
+    struct BakedNode {
+        mat4s                   local_matrix;
+
+        i32                     parent;             // -1 for root nodes.
+        u32                     level;
+
+        RelativeString          name;
+    }; // struct BakedNode
+
+    //
+    //
+    struct BakedAnimationSampler {
+        RelativeArray<f32>      key_frames;
+        RelativeArray<vec4s>    data;               // Three values per key frame for CubicSpline.
+
+        u32                     interpolation_type; // AnimationSampler::Interpolation
+    }; // struct BakedAnimationSampler
+
+    //
+    //
+    struct BakedAnimation {
+        f32                     time_start;
+        f32                     time_end;
+
+        RelativeArray<AnimationChannel> channels;
+        RelativeArray<BakedAnimationSampler> samplers;
+    }; // struct BakedAnimation
+
+    //
+    //
+    struct BakedSkin {
+        u32                     skeleton_root_index;
+
+        RelativeArray<i32>      joints;
+        RelativeArray<mat4s>    inverse_bind_matrices;
+    }; // struct BakedSkin
+
+    //
+    //
+    struct BakedScene : public Blob {
+
+        RelativeArray<BakedImage>   images;
+        RelativeArray<BakedSampler> samplers;
+        RelativeArray<BakedBuffer>  buffers;
+
+        RelativeArray<BakedMesh>    meshes;
+        RelativeArray<BakedMeshInstance> mesh_instances;
+        RelativeArray<BakedNode>    nodes;
+
+        RelativeArray<GpuMeshlet>   meshlets;
+        RelativeArray<GpuMeshletVertexPosition> meshlets_vertex_positions;
+        RelativeArray<GpuMeshletVertexData> meshlets_vertex_data;
+        RelativeArray<u32>          meshlets_data;
+        u32                         meshlets_index_count;
+
+        RelativeArray<BakedAnimation> animations;
+        RelativeArray<BakedSkin>    skins;
+
+        vec3s                       aabb[ 2 ];      // 0 min, 1 max
+
+    }; // struct BakedScene
+
+    enum BakeFlags {
+        BakeFlags_None          = 0,
+        BakeFlags_CookTextures  = 1 << 0,   // Compress images into dds files next to the sources, the baked scene references them.
+        BakeFlags_MeshletCache  = 1 << 1,   // Reuse the meshlets of primitives built before, saving the new ones in the meshlet cache directory.
+        BakeFlags_OptimizeMeshes = 1 << 2,  // Reorder indices for the vertex cache and overdraw, and vertices for fetch locality, before building meshlets.
+    };
+
+    // Load the glTF file and all its buffers and process them into a baked scene written with blob.
+    // Blob memory comes from allocator and is owned by blob, call write_file on it to save the bake.
+    // With a task scheduler primitives are processed on the task threads, allocator must then be thread safe.
+    // Returns nullptr if the glTF or its buffers could not be read.
+    BakedScene*             gltf_bake_scene( cstring filename, BlobSerializer& blob, Allocator* allocator, StackAllocator* temp_allocator, u32 flags = BakeFlags_None,
+                                             enki::TaskScheduler* task_scheduler = nullptr );
+
+    // Map a baked scene file. The scene points inside the mapping, that lives until blob shutdown.
+    // Returns nullptr if the file is missing or baked with a different version.
+    BakedScene*             baked_scene_map( cstring filename, BlobSerializer& blob, Allocator* allocator );
+
+    // Zero index groups to add after the packed triangles of a meshlet, so that emulated meshlets
+    // reading indices four at a time never see part of a triangle.
+    u32                     baked_meshlet_padding_groups( const u32* index_groups, u32 index_group_count );
+
+} // namespace raptor
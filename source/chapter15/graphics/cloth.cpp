@@ -0,0 +1,712 @@
+#include "graphics/cloth.hpp"
+#include "graphics/render_scene.hpp"
+
+#include "foundation/bit.hpp"
+#include "foundation/log.hpp"
+#include "foundation/memory.hpp"
+#include "foundation/numerics.hpp"
+#include "foundation/simd.hpp"
+#include "foundation/time.hpp"
+
+#include "external/cglm/struct/vec3.h"
+#include "external/enkiTS/TaskScheduler.h"
+#include "external/tracy/tracy/Tracy.hpp"
+
+#include <math.h>
+#include <string.h>
+
+namespace raptor {
+
+// Same simulation steps as cloth.glsl.
+static const u32 k_cloth_substeps               = 10;
+static const f32 k_cloth_substep_time           = 1.f / 600.f;
+static const f32 k_cloth_gravity                = -9.8f;
+
+static const u32 k_cloth_vertex_block           = 8;    // Vertices are padded to a multiple of the widest lanes.
+static const u32 k_cloth_parallel_blocks        = 512;  // Fewer vertex blocks are updated on the calling thread.
+static const u32 k_cloth_vertex_task_range      = 128;
+static const u32 k_cloth_parallel_springs       = 2048; // Smaller colors are updated on the calling thread.
+static const u32 k_cloth_spring_task_range      = 512;
+static const u32 k_cloth_max_colors             = 64;
+
+// Vertices pinned by cloth.glsl.
+static const vec3s k_cloth_fixed_vertices[] = { { 0.f, 1.f, -1.f }, { 0.f, -1.f, -1.f } };
+
+// Lanes //////////////////////////////////////////////////////////////////
+
+#if defined(RAPTOR_SIMD_AVX)
+
+static cstring k_cloth_simd_name = "AVX";
+static const u32 k_cloth_lanes = 8;
+typedef __m256 ClothLanes;
+
+static inline ClothLanes cloth_load( const f32* values )                { return _mm256_load_ps( values ); }
+static inline ClothLanes cloth_load_unaligned( const f32* values )      { return _mm256_loadu_ps( values ); }
+static inline void cloth_store( f32* values, ClothLanes lanes )         { _mm256_store_ps( values, lanes ); }
+static inline void cloth_store_unaligned( f32* values, ClothLanes lanes ) { _mm256_storeu_ps( values, lanes ); }
+static inline ClothLanes cloth_set( f32 value )                         { return _mm256_set1_ps( value ); }
+static inline ClothLanes cloth_add( ClothLanes a, ClothLanes b )        { return _mm256_add_ps( a, b ); }
+static inline ClothLanes cloth_sub( ClothLanes a, ClothLanes b )        { return _mm256_sub_ps( a, b ); }
+static inline ClothLanes cloth_mul( ClothLanes a, ClothLanes b )        { return _mm256_mul_ps( a, b ); }
+static inline ClothLanes cloth_div( ClothLanes a, ClothLanes b )        { return _mm256_div_ps( a, b ); }
+static inline ClothLanes cloth_sqrt( ClothLanes a )                     { return _mm256_sqrt_ps( a ); }
+
+static inline ClothLanes cloth_gather( const f32* values, const u32* indices ) {
+    return _mm256_setr_ps( values[ indices[ 0 ] ], values[ indices[ 1 ] ], values[ indices[ 2 ] ], values[ indices[ 3 ] ],
+                           values[ indices[ 4 ] ], values[ indices[ 5 ] ], values[ indices[ 6 ] ], values[ indices[ 7 ] ] );
+}
+
+#elif defined(RAPTOR_SIMD_SSE2)
+
+static cstring k_cloth_simd_name = "SSE2";
+static const u32 k_cloth_lanes = 4;
+typedef __m128 ClothLanes;
+
+static inline ClothLanes cloth_load( const f32* values )                { return _mm_load_ps( values ); }
+static inline ClothLanes cloth_load_unaligned( const f32* values )      { return _mm_loadu_ps( values ); }
+static inline void cloth_store( f32* values, ClothLanes lanes )         { _mm_store_ps( values, lanes ); }
+static inline void cloth_store_unaligned( f32* values, ClothLanes lanes ) { _mm_storeu_ps( values, lanes ); }
+static inline ClothLanes cloth_set( f32 value )                         { return _mm_set1_ps( value ); }
+static inline ClothLanes cloth_add( ClothLanes a, ClothLanes b )        { return _mm_add_ps( a, b ); }
+static inline ClothLanes cloth_sub( ClothLanes a, ClothLanes b )        { return _mm_sub_ps( a, b ); }
+static inline ClothLanes cloth_mul( ClothLanes a, ClothLanes b )        { return _mm_mul_ps( a, b ); }
+static inline ClothLanes cloth_div( ClothLanes a, ClothLanes b )        { return _mm_div_ps( a, b ); }
+static inline ClothLanes cloth_sqrt( ClothLanes a )                     { return _mm_sqrt_ps( a ); }
+
+static inline ClothLanes cloth_gather( const f32* values, const u32* indices ) {
+    return _mm_setr_ps( values[ indices[ 0 ] ], values[ indices[ 1 ] ], values[ indices[ 2 ] ], values[ indices[ 3 ] ] );
+}
+
+#else
+
+static cstring k_cloth_simd_name = "scalar";
+static const u32 k_cloth_lanes = 1;
+typedef f32 ClothLanes;
+
+static inline ClothLanes cloth_load( const f32* values )                { return *values; }
+static inline ClothLanes cloth_load_unaligned( const f32* values )      { return *values; }
+static inline void cloth_store( f32* values, ClothLanes lanes )         { *values = lanes; }
+static inline void cloth_store_unaligned( f32* values, ClothLanes lanes ) { *values = lanes; }
+static inline ClothLanes cloth_set( f32 value )                         { return value; }
+static inline ClothLanes cloth_add( ClothLanes a, ClothLanes b )        { return a + b; }
+static inline ClothLanes cloth_sub( ClothLanes a, ClothLanes b )        { return a - b; }
+static inline ClothLanes cloth_mul( ClothLanes a, ClothLanes b )        { return a * b; }
+static inline ClothLanes cloth_div( ClothLanes a, ClothLanes b )        { return a / b; }
+static inline ClothLanes cloth_sqrt( ClothLanes a )                     { return sqrtf( a ); }
+
+static inline ClothLanes cloth_gather( const f32* values, const u32* indices ) {
+    return values[ indices[ 0 ] ];
+}
+
+#endif // RAPTOR_SIMD_AVX
+
+// Kernels ////////////////////////////////////////////////////////////////
+
+static bool cloth_vertex_fixed( const PhysicsVertex& vertex ) {
+    if ( vertex.fixed ) {
+        return true;
+    }
+
+    for ( u32 f = 0; f < ArraySize( k_cloth_fixed_vertices ); ++f ) {
+        if ( glms_vec3_eqv( vertex.start_position, k_cloth_fixed_vertices[ f ] ) ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Vertices in [ begin, end ), multiples of k_cloth_vertex_block. Integrate the last substep if asked,
+// then set the forces of the next one to gravity, damping and wind, when parameters are given.
+static void cloth_update_vertices( ClothSolver& cloth, const ClothParameters* parameters, bool integrate, u32 begin, u32 end ) {
+    const ClothLanes time_squared = cloth_set( k_cloth_substep_time * k_cloth_substep_time );
+    const ClothLanes two = cloth_set( 2.f );
+
+    ClothLanes gravity = cloth_set( 0.f );
+    ClothLanes damping = cloth_set( 0.f );
+    ClothLanes air_density = cloth_set( 0.f );
+    ClothLanes wind[ 3 ] = { damping, damping, damping };
+    if ( parameters ) {
+        gravity = cloth_set( k_cloth_gravity );
+        damping = cloth_set( -parameters->spring_damping );
+        air_density = cloth_set( parameters->air_density );
+        wind[ 0 ] = cloth_set( parameters->wind_direction.x );
+        wind[ 1 ] = cloth_set( parameters->wind_direction.y );
+        wind[ 2 ] = cloth_set( parameters->wind_direction.z );
+    }
+
+    for ( u32 v = begin; v < end; v += k_cloth_lanes ) {
+        if ( integrate ) {
+            // Fixed vertices have their previous position equal to the current one and no force.
+            const ClothLanes moving = cloth_load( cloth.moving + v );
+
+            for ( u32 c = 0; c < 3; ++c ) {
+                const ClothLanes current = cloth_load( cloth.positions[ c ] + v );
+                const ClothLanes previous = cloth_load( cloth.previous_positions[ c ] + v );
+                const ClothLanes force = cloth_mul( cloth_load( cloth.forces[ c ] + v ), moving );
+
+                // Verlet integration
+                const ClothLanes next = cloth_add( cloth_sub( cloth_mul( current, two ), previous ), cloth_mul( force, time_squared ) );
+
+                cloth_store( cloth.positions[ c ] + v, next );
+                cloth_store( cloth.previous_positions[ c ] + v, current );
+                cloth_store( cloth.velocities[ c ] + v, cloth_sub( next, current ) );
+            }
+        }
+
+        if ( parameters ) {
+            ClothLanes velocity[ 3 ], normal[ 3 ];
+            for ( u32 c = 0; c < 3; ++c ) {
+                velocity[ c ] = cloth_load( cloth.velocities[ c ] + v );
+                normal[ c ] = cloth_load( cloth.normals[ c ] + v );
+            }
+
+            // Wind pushes along the normal, relative to the vertex velocity.
+            ClothLanes wind_amount = cloth_mul( normal[ 0 ], cloth_sub( wind[ 0 ], velocity[ 0 ] ) );
+            wind_amount = cloth_add( wind_amount, cloth_mul( normal[ 1 ], cloth_sub( wind[ 1 ], velocity[ 1 ] ) ) );
+            wind_amount = cloth_add( wind_amount, cloth_mul( normal[ 2 ], cloth_sub( wind[ 2 ], velocity[ 2 ] ) ) );
+            wind_amount = cloth_mul( wind_amount, air_density );
+
+            for ( u32 c = 0; c < 3; ++c ) {
+                ClothLanes force = cloth_add( cloth_mul( velocity[ c ], damping ), cloth_mul( normal[ c ], wind_amount ) );
+                if ( c == 1 ) {
+                    force = cloth_add( force, cloth_mul( gravity, cloth_load( cloth.masses + v ) ) );
+                }
+                cloth_store( cloth.forces[ c ] + v, force );
+            }
+        }
+    }
+}
+
+// Springs of a color do not share vertices, their forces can be added in any order.
+static inline void cloth_apply_spring( ClothSolver& cloth, u32 spring, f32 force_x, f32 force_y, f32 force_z ) {
+    const u32 a = cloth.spring_vertices_a[ spring ];
+    const u32 b = cloth.spring_vertices_b[ spring ];
+    const f32 weight_a = cloth.spring_weights_a[ spring ];
+    const f32 weight_b = cloth.spring_weights_b[ spring ];
+
+    cloth.forces[ 0 ][ a ] -= force_x * weight_a;
+    cloth.forces[ 1 ][ a ] -= force_y * weight_a;
+    cloth.forces[ 2 ][ a ] -= force_z * weight_a;
+    cloth.forces[ 0 ][ b ] += force_x * weight_b;
+    cloth.forces[ 1 ][ b ] += force_y * weight_b;
+    cloth.forces[ 2 ][ b ] += force_z * weight_b;
+}
+
+// Springs in [ begin, end ) of the same color. The force on a is stiffness * ( d - normalize( d ) * rest_length ),
+// with d from b to a, subtracted from the force of a and added to the one of b.
+static void cloth_spring_forces( ClothSolver& cloth, f32 stiffness, u32 begin, u32 end ) {
+    const u32* vertices_a = cloth.spring_vertices_a.data;
+    const u32* vertices_b = cloth.spring_vertices_b.data;
+    const f32* rest_lengths = cloth.spring_rest_lengths.data;
+
+    const ClothLanes stiffness_lanes = cloth_set( stiffness );
+    const ClothLanes one = cloth_set( 1.f );
+
+    u32 s = begin;
+    for ( ; s + k_cloth_lanes <= end; s += k_cloth_lanes ) {
+        ClothLanes delta[ 3 ];
+        for ( u32 c = 0; c < 3; ++c ) {
+            delta[ c ] = cloth_sub( cloth_gather( cloth.positions[ c ], vertices_a + s ), cloth_gather( cloth.positions[ c ], vertices_b + s ) );
+        }
+
+        const ClothLanes length = cloth_sqrt( cloth_add( cloth_add( cloth_mul( delta[ 0 ], delta[ 0 ] ), cloth_mul( delta[ 1 ], delta[ 1 ] ) ), cloth_mul( delta[ 2 ], delta[ 2 ] ) ) );
+        const ClothLanes scale = cloth_mul( stiffness_lanes, cloth_sub( one, cloth_div( cloth_load_unaligned( rest_lengths + s ), length ) ) );
+
+        f32 force[ 3 ][ k_cloth_lanes ];
+        for ( u32 c = 0; c < 3; ++c ) {
+            cloth_store_unaligned( force[ c ], cloth_mul( delta[ c ], scale ) );
+        }
+
+        for ( u32 l = 0; l < k_cloth_lanes; ++l ) {
+            cloth_apply_spring( cloth, s + l, force[ 0 ][ l ], force[ 1 ][ l ], force[ 2 ][ l ] );
+        }
+    }
+
+    for ( ; s < end; ++s ) {
+        const u32 a = vertices_a[ s ];
+        const u32 b = vertices_b[ s ];
+
+        const f32 dx = cloth.positions[ 0 ][ a ] - cloth.positions[ 0 ][ b ];
+        const f32 dy = cloth.positions[ 1 ][ a ] - cloth.positions[ 1 ][ b ];
+        const f32 dz = cloth.positions[ 2 ][ a ] - cloth.positions[ 2 ][ b ];
+        const f32 scale = stiffness * ( 1.f - rest_lengths[ s ] / sqrtf( dx * dx + dy * dy + dz * dz ) );
+
+        cloth_apply_spring( cloth, s, dx * scale, dy * scale, dz * scale );
+    }
+}
+
+// Same accumulation as cloth.glsl, each triangle normal is added to the normalized normals of its vertices in order.
+static void cloth_update_normals( ClothSolver& cloth ) {
+    ZoneScoped;
+
+    f32* const* positions = cloth.positions;
+    f32* const* normals = cloth.normals;
+
+    for ( u32 i = 0; i + 2 < cloth.indices.size; i += 3 ) {
+        const u32 i0 = cloth.indices[ i + 0 ];
+        const u32 i1 = cloth.indices[ i + 1 ];
+        const u32 i2 = cloth.indices[ i + 2 ];
+
+        const vec3s p0{ positions[ 0 ][ i0 ], positions[ 1 ][ i0 ], positions[ 2 ][ i0 ] };
+        const vec3s p1{ positions[ 0 ][ i1 ], positions[ 1 ][ i1 ], positions[ 2 ][ i1 ] };
+        const vec3s p2{ positions[ 0 ][ i2 ], positions[ 1 ][ i2 ], positions[ 2 ][ i2 ] };
+
+        const vec3s n = glms_vec3_cross( glms_vec3_sub( p1, p0 ), glms_vec3_sub( p2, p0 ) );
+
+        const u32 triangle[ 3 ] = { i0, i1, i2 };
+        for ( u32 k = 0; k < 3; ++k ) {
+            const u32 v = triangle[ k ];
+            const vec3s normal = glms_vec3_normalize( vec3s{ normals[ 0 ][ v ] + n.x, normals[ 1 ][ v ] + n.y, normals[ 2 ][ v ] + n.z } );
+            normals[ 0 ][ v ] = normal.x;
+            normals[ 1 ][ v ] = normal.y;
+            normals[ 2 ][ v ] = normal.z;
+        }
+    }
+}
+
+// Tasks //////////////////////////////////////////////////////////////////
+
+//
+// Updates a range of vertex blocks.
+struct ClothVertexTask : public enki::ITaskSet {
+
+    void                    ExecuteRange( enki::TaskSetPartition range_, uint32_t threadnum_ ) override;
+
+    ClothSolver*            cloth           = nullptr;
+    const ClothParameters*  parameters      = nullptr;  // Forces of the next substep are set if given.
+    bool                    integrate       = false;
+}; // struct ClothVertexTask
+
+void ClothVertexTask::ExecuteRange( enki::TaskSetPartition range_, uint32_t threadnum_ ) {
+    ZoneScoped;
+
+    cloth_update_vertices( *cloth, parameters, integrate, range_.start * k_cloth_vertex_block, range_.end * k_cloth_vertex_block );
+}
+
+//
+// Adds the forces of a range of springs of the same color.
+struct ClothSpringTask : public enki::ITaskSet {
+
+    void                    ExecuteRange( enki::TaskSetPartition range_, uint32_t threadnum_ ) override;
+
+    ClothSolver*            cloth           = nullptr;
+    f32                     stiffness       = 0.f;
+    u32                     color_offset    = 0;
+}; // struct ClothSpringTask
+
+void ClothSpringTask::ExecuteRange( enki::TaskSetPartition range_, uint32_t threadnum_ ) {
+    ZoneScoped;
+
+    cloth_spring_forces( *cloth, stiffness, color_offset + range_.start, color_offset + range_.end );
+}
+
+static void cloth_run_task( enki::ITaskSet& task, u32 count, u32 parallel_count, u32 task_range, enki::TaskScheduler* task_scheduler ) {
+    if ( count == 0 ) {
+        return;
+    }
+
+    if ( task_scheduler == nullptr || count < parallel_count ) {
+        task.ExecuteRange( { 0, count }, 0 );
+        return;
+    }
+
+    task.m_SetSize = count;
+    task.m_MinRange = task_range;
+    task_scheduler->AddTaskSetToPipe( &task );
+    task_scheduler->WaitforTask( &task );
+}
+
+// ClothSolver ////////////////////////////////////////////////////////////
+
+//
+//
+struct ClothSpring {
+    u32                     a;
+    u32                     b;
+    f32                     rest_length;
+    f32                     weight_a;
+    f32                     weight_b;
+    u32                     color;
+}; // struct ClothSpring
+
+static bool cloth_has_joint( const PhysicsVertex& vertex, u32 other ) {
+    for ( u32 j = 0; j < vertex.joint_count; ++j ) {
+        if ( vertex.joints[ j ].vertex_index == ( i32 )other ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ClothSolver::init( Allocator* allocator_, const PhysicsVertex* vertices, u32 vertex_count_, const u32* indices_, u32 index_count ) {
+    ZoneScoped;
+
+    allocator = allocator_;
+    vertex_count = vertex_count_;
+    padded_vertex_count = ( vertex_count + k_cloth_vertex_block - 1 ) / k_cloth_vertex_block * k_cloth_vertex_block;
+
+    // Six vec3 arrays, masses and moving.
+    const u32 array_count = 6 * 3 + 2;
+    components = ( f32* )rallocaa( sizeof( f32 ) * padded_vertex_count * array_count, allocator, 64 );
+    memset( components, 0, sizeof( f32 ) * padded_vertex_count * array_count );
+
+    f32* component = components;
+    f32** vector_arrays[] = { positions, previous_positions, start_positions, velocities, normals, forces };
+    for ( u32 a = 0; a < ArraySize( vector_arrays ); ++a ) {
+        for ( u32 c = 0; c < 3; ++c ) {
+            vector_arrays[ a ][ c ] = component;
+            component += padded_vertex_count;
+        }
+    }
+    masses = component;
+    moving = component + padded_vertex_count;
+
+    for ( u32 v = 0; v < vertex_count; ++v ) {
+        const PhysicsVertex& vertex = vertices[ v ];
+
+        for ( u32 c = 0; c < 3; ++c ) {
+            positions[ c ][ v ] = vertex.position.raw[ c ];
+            previous_positions[ c ][ v ] = vertex.previous_position.raw[ c ];
+            start_positions[ c ][ v ] = vertex.start_position.raw[ c ];
+            velocities[ c ][ v ] = vertex.velocity.raw[ c ];
+            normals[ c ][ v ] = vertex.normal.raw[ c ];
+            forces[ c ][ v ] = vertex.force.raw[ c ];
+        }
+        masses[ v ] = vertex.mass;
+        moving[ v ] = cloth_vertex_fixed( vertex ) ? 0.f : 1.f;
+    }
+
+    indices.init( allocator, index_count, index_count );
+    memcpy( indices.data, indices_, sizeof( u32 ) * index_count );
+
+    // A spring for each pair of vertices joined in either direction, only the vertices with the joint are pulled.
+    Array<ClothSpring> springs;
+    springs.init( allocator, vertex_count * 4 );
+
+    Array<u64> vertex_colors;
+    vertex_colors.init( allocator, vertex_count, vertex_count );
+    memset( vertex_colors.data, 0, sizeof( u64 ) * vertex_count );
+
+    u32 color_counts[ k_cloth_max_colors ]{ };
+
+    for ( u32 v = 0; v < vertex_count; ++v ) {
+        const PhysicsVertex& vertex = vertices[ v ];
+
+        for ( u32 j = 0; j < vertex.joint_count; ++j ) {
+            const u32 other = vertex.joints[ j ].vertex_index;
+            const bool joined_back = cloth_has_joint( vertices[ other ], v );
+            if ( other == v || ( other < v && joined_back ) ) {
+                continue;
+            }
+
+            ClothSpring& spring = springs.push_use();
+            spring.a = v;
+            spring.b = other;
+            spring.rest_length = glms_vec3_distance( vertex.start_position, vertices[ other ].start_position );
+            spring.weight_a = 1.f;
+            spring.weight_b = joined_back ? 1.f : 0.f;
+
+            // Greedy edge coloring, the first color used by neither vertex.
+            spring.color = bit_trailing_zeros( ~( vertex_colors[ v ] | vertex_colors[ other ] ) );
+            RASSERTM( spring.color < k_cloth_max_colors, "Too many cloth spring colors" );
+
+            vertex_colors[ v ] |= 1ull << spring.color;
+            vertex_colors[ other ] |= 1ull << spring.color;
+            ++color_counts[ spring.color ];
+        }
+    }
+
+    u32 color_count = 0;
+    for ( u32 c = 0; c < k_cloth_max_colors; ++c ) {
+        color_count = color_counts[ c ] ? c + 1 : color_count;
+    }
+
+    color_offsets.init( allocator, color_count + 1, color_count + 1 );
+    color_offsets[ 0 ] = 0;
+    for ( u32 c = 0; c < color_count; ++c ) {
+        color_offsets[ c + 1 ] = color_offsets[ c ] + color_counts[ c ];
+    }
+
+    const u32 spring_count = springs.size;
+    spring_vertices_a.init( allocator, spring_count, spring_count );
+    spring_vertices_b.init( allocator, spring_count, spring_count );
+    spring_rest_lengths.init( allocator, spring_count, spring_count );
+    spring_weights_a.init( allocator, spring_count, spring_count );
+    spring_weights_b.init( allocator, spring_count, spring_count );
+
+    // Counting sort by color.
+    memset( color_counts, 0, sizeof( color_counts ) );
+    for ( u32 s = 0; s < spring_count; ++s ) {
+        const ClothSpring& spring = springs[ s ];
+        const u32 index = color_offsets[ spring.color ] + color_counts[ spring.color ]++;
+
+        spring_vertices_a[ index ] = spring.a;
+        spring_vertices_b[ index ] = spring.b;
+        spring_rest_lengths[ index ] = spring.rest_length;
+        spring_weights_a[ index ] = spring.weight_a;
+        spring_weights_b[ index ] = spring.weight_b;
+    }
+
+    vertex_colors.shutdown();
+    springs.shutdown();
+}
+
+void ClothSolver::shutdown() {
+    rfree( components, allocator );
+    components = nullptr;
+
+    spring_vertices_a.shutdown();
+    spring_vertices_b.shutdown();
+    spring_rest_lengths.shutdown();
+    spring_weights_a.shutdown();
+    spring_weights_b.shutdown();
+    color_offsets.shutdown();
+    indices.shutdown();
+}
+
+void ClothSolver::reset() {
+    for ( u32 c = 0; c < 3; ++c ) {
+        memcpy( positions[ c ], start_positions[ c ], sizeof( f32 ) * padded_vertex_count );
+        memcpy( previous_positions[ c ], start_positions[ c ], sizeof( f32 ) * padded_vertex_count );
+        memset( velocities[ c ], 0, sizeof( f32 ) * padded_vertex_count );
+        memset( forces[ c ], 0, sizeof( f32 ) * padded_vertex_count );
+    }
+}
+
+void ClothSolver::update( const ClothParameters& parameters, enki::TaskScheduler* task_scheduler ) {
+    ZoneScoped;
+
+    const u32 block_count = padded_vertex_count / k_cloth_vertex_block;
+
+    ClothVertexTask vertex_task;
+    vertex_task.cloth = this;
+
+    ClothSpringTask spring_task;
+    spring_task.cloth = this;
+    spring_task.stiffness = parameters.spring_stiffness;
+
+    // Forces of the first substep, the next ones are set while integrating the previous substep.
+    vertex_task.parameters = &parameters;
+    vertex_task.integrate = false;
+    cloth_run_task( vertex_task, block_count, k_cloth_parallel_blocks, k_cloth_vertex_task_range, task_scheduler );
+
+    for ( u32 s = 0; s < k_cloth_substeps; ++s ) {
+        for ( u32 c = 0; c + 1 < color_offsets.size; ++c ) {
+            spring_task.color_offset = color_offsets[ c ];
+            cloth_run_task( spring_task, color_offsets[ c + 1 ] - color_offsets[ c ], k_cloth_parallel_springs, k_cloth_spring_task_range, task_scheduler );
+        }
+
+        vertex_task.parameters = s + 1 < k_cloth_substeps ? &parameters : nullptr;
+        vertex_task.integrate = true;
+        cloth_run_task( vertex_task, block_count, k_cloth_parallel_blocks, k_cloth_vertex_task_range, task_scheduler );
+    }
+
+    cloth_update_normals( *this );
+}
+
+void ClothSolver::write_vertices( f32* positions_, f32* normals_ ) const {
+    ZoneScoped;
+
+    for ( u32 v = 0; v < vertex_count; ++v ) {
+        for ( u32 c = 0; c < 3; ++c ) {
+            positions_[ v * 3 + c ] = positions[ c ][ v ];
+            normals_[ v * 3 + c ] = normals[ c ][ v ];
+        }
+    }
+}
+
+// Benchmark //////////////////////////////////////////////////////////////
+
+static const u32 k_cloth_benchmark_updates = 10;
+
+// The cloth.glsl loops on PhysicsVertex, as the reference solver.
+static void cloth_benchmark_reference_update( PhysicsVertex* vertices, u32 vertex_count, const u32* indices, u32 index_count, const ClothParameters& parameters ) {
+    const f32 dt = k_cloth_substep_time;
+    const vec3s g{ 0.f, k_cloth_gravity, 0.f };
+
+    for ( u32 s = 0; s < k_cloth_substeps; ++s ) {
+        // First calculate the force to apply to each vertex
+        for ( u32 v = 0; v < vertex_count; ++v ) {
+            PhysicsVertex& vertex = vertices[ v ];
+            if ( cloth_vertex_fixed( vertex ) ) {
+                continue;
+            }
+
+            vec3s spring_force{ };
+            for ( u32 j = 0; j < vertex.joint_count; ++j ) {
+                const PhysicsVertex& other_vertex = vertices[ vertex.joints[ j ].vertex_index ];
+
+                const f32 spring_rest_length = glms_vec3_distance( vertex.start_position, other_vertex.start_position );
+
+                vec3s pull_direction = glms_vec3_sub( vertex.position, other_vertex.position );
+                const vec3s relative_pull_direction = glms_vec3_sub( pull_direction, glms_vec3_scale( glms_vec3_normalize( pull_direction ), spring_rest_length ) );
+                pull_direction = glms_vec3_scale( relative_pull_direction, parameters.spring_stiffness );
+                spring_force = glms_vec3_add( spring_force, pull_direction );
+            }
+
+            const vec3s viscous_damping = glms_vec3_scale( vertex.velocity, -parameters.spring_damping );
+
+            vec3s viscous_velocity = glms_vec3_sub( parameters.wind_direction, vertex.velocity );
+            viscous_velocity = glms_vec3_scale( vertex.normal, glms_vec3_dot( vertex.normal, viscous_velocity ) );
+            viscous_velocity = glms_vec3_scale( viscous_velocity, parameters.air_density );
+
+            vertex.force = glms_vec3_scale( g, vertex.mass );
+            vertex.force = glms_vec3_sub( vertex.force, spring_force );
+            vertex.force = glms_vec3_add( vertex.force, viscous_damping );
+            vertex.force = glms_vec3_add( vertex.force, viscous_velocity );
+        }
+
+        // Then update their position
+        for ( u32 v = 0; v < vertex_count; ++v ) {
+            PhysicsVertex& vertex = vertices[ v ];
+
+            const vec3s previous_position = vertex.previous_position;
+            const vec3s current_position = vertex.position;
+
+            // Verlet integration
+            vertex.position = glms_vec3_scale( current_position, 2.0f );
+            vertex.position = glms_vec3_sub( vertex.position, previous_position );
+            vertex.position = glms_vec3_add( vertex.position, glms_vec3_scale( vertex.force, dt * dt ) );
+
+            vertex.previous_position = current_position;
+            vertex.velocity = glms_vec3_sub( vertex.position, current_position );
+        }
+    }
+
+    for ( u32 i = 0; i + 2 < index_count; i += 3 ) {
+        PhysicsVertex& v0 = vertices[ indices[ i + 0 ] ];
+        PhysicsVertex& v1 = vertices[ indices[ i + 1 ] ];
+        PhysicsVertex& v2 = vertices[ indices[ i + 2 ] ];
+
+        const vec3s n = glms_vec3_cross( glms_vec3_sub( v1.position, v0.position ), glms_vec3_sub( v2.position, v0.position ) );
+
+        v0.normal = glms_vec3_normalize( glms_vec3_add( v0.normal, n ) );
+        v1.normal = glms_vec3_normalize( glms_vec3_add( v1.normal, n ) );
+        v2.normal = glms_vec3_normalize( glms_vec3_add( v2.normal, n ) );
+    }
+}
+
+// Square in the x = 0 plane with the cloth.glsl pins at two corners, each vertex joined to the vertices
+// 1 and 2 steps away along the grid and to its neighbours on one diagonal.
+static void cloth_benchmark_create( u32 side, Array<PhysicsVertex>& vertices, Array<u32>& indices, Allocator* allocator ) {
+    const u32 vertex_count = side * side;
+    vertices.init( allocator, vertex_count, vertex_count );
+    indices.init( allocator, ( side - 1 ) * ( side - 1 ) * 6 );
+
+    for ( u32 y = 0; y < side; ++y ) {
+        for ( u32 z = 0; z < side; ++z ) {
+            PhysicsVertex vertex{ };
+            vertex.start_position = vec3s{ 0.f, 1.f - 2.f * y / ( side - 1 ), -1.f + 2.f * z / ( side - 1 ) };
+            vertex.previous_position = vertex.start_position;
+            vertex.position = vertex.start_position;
+            vertex.normal = vec3s{ 1.f, 0.f, 0.f };
+            vertex.mass = 1.f;
+            vertices[ y * side + z ] = vertex;
+        }
+    }
+
+    static const i32 k_joint_offsets[][ 2 ] = { { 0, 1 }, { 0, -1 }, { 1, 0 }, { -1, 0 }, { 0, 2 }, { 0, -2 }, { 2, 0 }, { -2, 0 }, { 1, 1 }, { -1, -1 } };
+
+    for ( i32 y = 0; y < ( i32 )side; ++y ) {
+        for ( i32 z = 0; z < ( i32 )side; ++z ) {
+            for ( u32 j = 0; j < ArraySize( k_joint_offsets ); ++j ) {
+                const i32 other_y = y + k_joint_offsets[ j ][ 0 ];
+                const i32 other_z = z + k_joint_offsets[ j ][ 1 ];
+                if ( other_y >= 0 && other_y < ( i32 )side && other_z >= 0 && other_z < ( i32 )side ) {
+                    vertices[ y * side + z ].add_joint( other_y * side + other_z );
+                }
+            }
+
+            if ( y + 1 < ( i32 )side && z + 1 < ( i32 )side ) {
+                const u32 v = y * side + z;
+                indices.push( v );
+                indices.push( v + side );
+                indices.push( v + side + 1 );
+                indices.push( v );
+                indices.push( v + side + 1 );
+                indices.push( v + 1 );
+            }
+        }
+    }
+}
+
+void cloth_benchmark( enki::TaskScheduler* task_scheduler, Allocator* allocator ) {
+    static const u32 k_iterations = 3;
+    static const u32 k_sides[] = { 32, 128, 256 };
+
+    // Defaults of the physics settings.
+    ClothParameters parameters;
+    parameters.wind_direction = vec3s{ -2.f, 0.f, 0.f };
+    parameters.air_density = 2.f;
+    parameters.spring_stiffness = 10000.f;
+    parameters.spring_damping = 5000.f;
+
+    rprint( "Cloth benchmark (%s), %u updates of %u substeps, %u task threads, best of %u runs\n", k_cloth_simd_name, k_cloth_benchmark_updates,
+            k_cloth_substeps, task_scheduler ? task_scheduler->GetNumTaskThreads() : 0, k_iterations );
+
+    for ( u32 i = 0; i < ArraySize( k_sides ); ++i ) {
+        const u32 side = k_sides[ i ];
+
+        Array<PhysicsVertex> source_vertices;
+        Array<u32> indices;
+        cloth_benchmark_create( side, source_vertices, indices, allocator );
+
+        const u32 vertex_count = source_vertices.size;
+        const f64 vertex_substeps = ( f64 )vertex_count * k_cloth_substeps * k_cloth_benchmark_updates;
+
+        Array<PhysicsVertex> vertices;
+        vertices.init( allocator, vertex_count, vertex_count );
+
+        ClothSolver cloth;
+        cloth.init( allocator, source_vertices.data, vertex_count, indices.data, indices.size );
+
+        rprint( "    %3u x %3u vertices, %6u springs in %2u colors\n", side, side, cloth.spring_vertices_a.size, cloth.color_offsets.size - 1 );
+
+        // cloth.glsl loops
+        f64 best_ms = 1e30;
+        for ( u32 it = 0; it < k_iterations; ++it ) {
+            memcpy( vertices.data, source_vertices.data, sizeof( PhysicsVertex ) * vertex_count );
+
+            const i64 begin_time = time_now();
+            for ( u32 u = 0; u < k_cloth_benchmark_updates; ++u ) {
+                cloth_benchmark_reference_update( vertices.data, vertex_count, indices.data, indices.size, parameters );
+            }
+            const f64 ms = time_from_milliseconds( begin_time );
+            best_ms = ms < best_ms ? ms : best_ms;
+        }
+        rprint( "        cloth.glsl loops      : %8.3f ms per update, %8.0f vertex substeps/ms\n", best_ms / k_cloth_benchmark_updates, vertex_substeps / best_ms );
+
+        for ( u32 parallel = 0; parallel < 2; ++parallel ) {
+            best_ms = 1e30;
+            for ( u32 it = 0; it < k_iterations; ++it ) {
+                // Normals are not reset with the simulation, start from the source ones.
+                cloth.shutdown();
+                cloth.init( allocator, source_vertices.data, vertex_count, indices.data, indices.size );
+
+                const i64 begin_time = time_now();
+                for ( u32 u = 0; u < k_cloth_benchmark_updates; ++u ) {
+                    cloth.update( parameters, parallel ? task_scheduler : nullptr );
+                }
+                const f64 ms = time_from_milliseconds( begin_time );
+                best_ms = ms < best_ms ? ms : best_ms;
+            }
+
+            f32 max_difference = 0.f;
+            for ( u32 v = 0; v < vertex_count; ++v ) {
+                for ( u32 c = 0; c < 3; ++c ) {
+                    max_difference = raptor::max( max_difference, fabsf( cloth.positions[ c ][ v ] - vertices[ v ].position.raw[ c ] ) );
+                }
+            }
+
+            rprint( "        solver, %s: %8.3f ms per update, %8.0f vertex substeps/ms, max position difference %g\n", parallel ? "task threads " : "serial       ",
+                    best_ms / k_cloth_benchmark_updates, vertex_substeps / best_ms, max_difference );
+        }
+
+        cloth.shutdown();
+        vertices.shutdown();
+        indices.shutdown();
+        source_vertices.shutdown();
+    }
+}
+
+} // namespace raptor
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "foundation/array.hpp"
+
+#include "external/cglm/types-struct.h"
+
+namespace enki {
+    class TaskScheduler;
+}
+
+namespace raptor {
+
+    struct Allocator;
+    struct PhysicsVertex;
+
+    // Cloth //////////////////////////////////////////////////////////////
+    //
+    // CPU version of shaders/cloth.glsl, for when async compute is busy: mass spring cloth integrated
+    // with Verlet, 10 substeps of 1/600 of a second per update, normals updated after the last one.
+    //
+    // Vertex components live in separate arrays padded to 8 vertices, forces and integration run on
+    // 4 or 8 vertices at once. Each spring is stored once and pushes both its ends, springs are sorted
+    // by color so that no two springs of a color share a vertex: a color is split between the task
+    // threads without races, and colors run one after the other.
+
+    //
+    //
+    struct ClothParameters {
+        vec3s                   wind_direction;
+        f32                     air_density;
+        f32                     spring_stiffness;
+        f32                     spring_damping;
+    }; // struct ClothParameters
+
+    //
+    //
+    struct ClothSolver {
+
+        // Springs come from the vertex joints, triangles from indices, used for the normals.
+        void                    init( Allocator* allocator, const PhysicsVertex* vertices, u32 vertex_count, const u32* indices, u32 index_count );
+        void                    shutdown();
+
+        // Back to the start positions, at rest.
+        void                    reset();
+        void                    update( const ClothParameters& parameters, enki::TaskScheduler* task_scheduler );
+
+        // Packed x, y, z positions and normals, as in the vertex buffers.
+        void                    write_vertices( f32* positions, f32* normals ) const;
+
+        Allocator*              allocator           = nullptr;
+
+        u32                     vertex_count        = 0;
+        u32                     padded_vertex_count = 0;    // Multiple of 8, padding vertices are fixed.
+
+        f32*                    components          = nullptr;  // Single allocation for the arrays below.
+        f32*                    positions[ 3 ];
+        f32*                    previous_positions[ 3 ];
+        f32*                    start_positions[ 3 ];
+        f32*                    velocities[ 3 ];    // Last substep displacement, as in cloth.glsl.
+        f32*                    normals[ 3 ];
+        f32*                    forces[ 3 ];
+        f32*                    masses;
+        f32*                    moving;             // 0 for fixed vertices, 1 otherwise.
+
+        // Springs sorted by color, color c is [ color_offsets[ c ], color_offsets[ c + 1 ] ).
+        Array<u32>              spring_vertices_a;
+        Array<u32>              spring_vertices_b;
+        Array<f32>              spring_rest_lengths;
+        Array<f32>              spring_weights_a;   // 0 when only b has a joint to a.
+        Array<f32>              spring_weights_b;
+        Array<u32>              color_offsets;
+
+        Array<u32>              indices;
+
+    }; // struct ClothSolver
+
+    // Simulate square cloths of 1K to 64K vertices: the cloth.glsl loops on PhysicsVertex against the
+    // solver, serial and on the task threads, with the difference between their positions.
+    void                        cloth_benchmark( enki::TaskScheduler* task_scheduler, Allocator* allocator );
+
+} // namespace raptor
@@ -162,8 +162,12 @@ void CommandBuffer::bind_pass( RenderPassHandle handle_, FramebufferHandle frame
             if ( gpu_device->dynamic_rendering_extension_present ) {
                 Array<VkRenderingAttachmentInfoKHR> color_attachments_info;
 
-                u64 marker = gpu_device->temporary_allocator->get_marker();
-                color_attachments_info.init( gpu_device->temporary_allocator, framebuffer->num_color_attachments, framebuffer->num_color_attachments );
+                // Passes are recorded on the task threads: use the recording thread frame arena, cleared at new_frame.
+                // The shared temporary allocator is only safe when no arenas are present.
+                FrameThreadArenas* frame_arenas = gpu_device->frame_arenas;
+                u64 marker = frame_arenas ? 0 : gpu_device->temporary_allocator->get_marker();
+                Allocator* attachments_allocator = frame_arenas ? ( Allocator* )frame_arenas->get( thread_index ) : gpu_device->temporary_allocator;
+                color_attachments_info.init( attachments_allocator, framebuffer->num_color_attachments, framebuffer->num_color_attachments );
                 memset( color_attachments_info.data, 0, sizeof( VkRenderingAttachmentInfoKHR ) * framebuffer->num_color_attachments );
 
                 for ( u32 a = 0; a < framebuffer->num_color_attachments; ++a ) {
@@ -247,7 +251,9 @@ void CommandBuffer::bind_pass( RenderPassHandle handle_, FramebufferHandle frame
 
                 gpu_device->vkCmdBeginRenderingKHR( vk_command_buffer, &rendering_info );
 
-                gpu_device->temporary_allocator->free_marker( marker );
+                if ( !frame_arenas ) {
+                    gpu_device->temporary_allocator->free_marker( marker );
+                }
             } else {
                 VkRenderPassBeginInfo render_pass_begin{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
                 render_pass_begin.framebuffer = framebuffer->vk_framebuffer;
@@ -732,8 +738,10 @@ void CommandBuffer::upload_texture_data( TextureHandle texture_handle, void* tex
     Buffer* staging_buffer = gpu_device->access_buffer( staging_buffer_handle );
     u32 image_size = texture->width * texture->height * 4;
 
-    // Copy buffer_data to staging buffer
-    memcpy( staging_buffer->mapped_data + staging_buffer_offset, texture_data, static_cast< size_t >( image_size ) );
+    // Copy buffer_data to staging buffer, null if the data was already written there.
+    if ( texture_data ) {
+        memcpy( staging_buffer->mapped_data + staging_buffer_offset, texture_data, static_cast< size_t >( image_size ) );
+    }
 
     VkBufferImageCopy region = {};
     region.bufferOffset = staging_buffer_offset;
@@ -759,6 +767,53 @@ void CommandBuffer::upload_texture_data( TextureHandle texture_handle, void* tex
                                 QueueType::CopyTransfer, QueueType::Graphics );
 }
 
+void CommandBuffer::upload_texture_mips( TextureHandle texture_handle, BufferHandle staging_buffer_handle, sizet staging_buffer_offset ) {
+
+    Texture* texture = gpu_device->access_texture( texture_handle );
+    Buffer* staging_buffer = gpu_device->access_buffer( staging_buffer_handle );
+    const bool block_compressed = TextureFormat::is_block_compressed( texture->vk_format );
+    RASSERTM( block_compressed || texture->vk_format == VK_FORMAT_R8G8B8A8_UNORM, "Uncompressed mip chains are RGBA8 only" );
+
+    const u32 block_size = block_compressed ? TextureFormat::block_size( texture->vk_format ) : 0;
+
+    // One region per mip, data is tightly packed so row length and height are left to the extent.
+    VkBufferImageCopy regions[ 16 ];
+    const u32 mip_count = texture->mip_level_count < ArraySize( regions ) ? texture->mip_level_count : ArraySize( regions );
+
+    u32 width = texture->width;
+    u32 height = texture->height;
+    sizet offset = staging_buffer_offset;
+    for ( u32 mip = 0; mip < mip_count; ++mip ) {
+        VkBufferImageCopy& region = regions[ mip ];
+        region = {};
+        region.bufferOffset = offset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = mip;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = { width, height, 1 };
+
+        offset += block_compressed ? ( sizet )( ( width + 3 ) / 4 ) * ( ( height + 3 ) / 4 ) * block_size : ( sizet )width * height * 4;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+
+    RASSERT( offset <= staging_buffer->size );
+
+    util_add_image_barrier( gpu_device, vk_command_buffer, texture, RESOURCE_STATE_COPY_DEST, 0, mip_count, false );
+    vkCmdCopyBufferToImage( vk_command_buffer, staging_buffer->vk_buffer, texture->vk_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mip_count, regions );
+
+    // Mips are already there, release straight to be sampled.
+    util_add_image_barrier_ext( gpu_device, vk_command_buffer, texture, RESOURCE_STATE_SHADER_RESOURCE,
+                                0, mip_count, 0, 1, false, gpu_device->vulkan_transfer_queue_family, gpu_device->vulkan_main_queue_family,
+                                QueueType::CopyTransfer, QueueType::Graphics );
+}
+
 void CommandBuffer::copy_texture( TextureHandle src_, TextureHandle dst_, ResourceState dst_state ) {
     Texture* src = gpu_device->access_texture( src_ );
     Texture* dst = gpu_device->access_texture( dst_ );
@@ -921,8 +976,10 @@ void CommandBuffer::upload_buffer_data( BufferHandle buffer_handle, void* buffer
     Buffer* staging_buffer = gpu_device->access_buffer( staging_buffer_handle );
     u32 copy_size = buffer->size;
 
-    // Copy buffer_data to staging buffer
-    memcpy( staging_buffer->mapped_data + staging_buffer_offset, buffer_data, static_cast< size_t >( copy_size ) );
+    // Copy buffer_data to staging buffer, null if the data was already written there.
+    if ( buffer_data ) {
+        memcpy( staging_buffer->mapped_data + staging_buffer_offset, buffer_data, static_cast< size_t >( copy_size ) );
+    }
 
     VkBufferCopy region{};
     region.srcOffset = staging_buffer_offset;
@@ -992,6 +1049,7 @@ void CommandBufferManager::init( GpuDevice* gpu_, u32 num_threads ) {
 
         // TODO(marco): move to have a ring per queue per thread
         current_command_buffer.handle = i;
+        current_command_buffer.thread_index = thread_index;
         current_command_buffer.thread_frame_pool = &gpu->thread_frame_pools[ pool_index ];
         current_command_buffer.init( gpu );
     }
@@ -1012,6 +1070,7 @@ void CommandBufferManager::init( GpuDevice* gpu_, u32 num_threads ) {
             cb.vk_command_buffer = secondary_buffers[ scb_index ];
 
             cb.handle = handle++;
+            cb.thread_index = pool_index % num_pools_per_frame;
             cb.thread_frame_pool = &gpu->thread_frame_pools[ pool_index ];
             cb.init( gpu );
 
@@ -73,6 +73,8 @@ struct CommandBuffer {
 
     // Non-drawing methods
     void                            upload_texture_data( TextureHandle texture, void* texture_data, BufferHandle staging_buffer, sizet staging_buffer_offset );
+    // Block compressed or RGBA8 texture with all its mips tightly packed in the staging buffer, released to the main queue ready to be sampled.
+    void                            upload_texture_mips( TextureHandle texture, BufferHandle staging_buffer, sizet staging_buffer_offset );
     void                            copy_texture( TextureHandle src, TextureHandle dst, ResourceState dst_state );
     void                            copy_texture( TextureHandle src, TextureSubResource src_sub, TextureHandle dst, TextureSubResource dst_sub, ResourceState dst_state );
 
@@ -102,6 +104,7 @@ struct CommandBuffer {
     bool                            is_recording;
 
     u32                             handle;
+    u32                             thread_index;   // Recording thread, selects the per-thread frame arena.
 
     u32                             current_command;
     ResourceHandle                  resource_handle;
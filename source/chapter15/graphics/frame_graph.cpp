@@ -920,6 +920,10 @@ FrameGraphNode* FrameGraph::get_node( cstring name ) {
     return builder->get_node( name );
 }
 
+FrameGraphNode* FrameGraph::get_node( const HashedString& name ) {
+    return builder->get_node( name );
+}
+
 FrameGraphNode* FrameGraph::access_node( FrameGraphNodeHandle handle ) {
     return builder->access_node( handle );
 }
@@ -932,6 +936,10 @@ FrameGraphResource* FrameGraph::get_resource( cstring name ) {
     return builder->get_resource( name );
 }
 
+FrameGraphResource* FrameGraph::get_resource( const HashedString& name ) {
+    return builder->get_resource( name );
+}
+
 FrameGraphResource* FrameGraph::access_resource( FrameGraphResourceHandle handle ) {
     return builder->access_resource( handle );
 }
@@ -1050,7 +1058,9 @@ FrameGraphResourceHandle FrameGraphBuilder::create_node_output( const FrameGraph
         if ( producer_node->enabled ) {
             // TODO(marco): eventually we want to allow enabling/disabling a node at runtime.
             // We will need to patch the producer when the graph changes
-            resource_cache.resource_map.insert( hash_bytes( ( void* )resource->name, strlen( creation.name ) ), resource_handle.index );
+            const u64 name_hash = hash_bytes( ( void* )resource->name, strlen( creation.name ) );
+            hashed_string_check( name_hash, resource->name );
+            resource_cache.resource_map.insert( name_hash, resource_handle.index );
         }
     }
 
@@ -1100,7 +1110,9 @@ FrameGraphNodeHandle FrameGraphBuilder::create_node( const FrameGraphNodeCreatio
     node->framebuffer = k_invalid_framebuffer;
     node->render_pass = { k_invalid_index };
 
-    node_cache.node_map.insert( hash_bytes( ( void* )node->name, strlen( node->name ) ), node_handle.index );
+    const u64 name_hash = hash_bytes( ( void* )node->name, strlen( node->name ) );
+    hashed_string_check( name_hash, node->name );
+    node_cache.node_map.insert( name_hash, node_handle.index );
 
     // NOTE(marco): first create the outputs, then we can patch the input resources
     // with the right handles
@@ -1134,6 +1146,19 @@ FrameGraphNode* FrameGraphBuilder::get_node( cstring name ) {
     return node;
 }
 
+FrameGraphNode* FrameGraphBuilder::get_node( const HashedString& name ) {
+    hashed_string_check( name );
+
+    FlatHashMapIterator it = node_cache.node_map.find( name.hash, name.key_hash );
+    if ( it.is_invalid() ) {
+        return nullptr;
+    }
+
+    FrameGraphNode* node = ( FrameGraphNode* )node_cache.nodes.access_resource( node_cache.node_map.get( it ) );
+
+    return node;
+}
+
 FrameGraphNode* FrameGraphBuilder::access_node( FrameGraphNodeHandle handle ) {
     FrameGraphNode* node = ( FrameGraphNode* )node_cache.nodes.access_resource( handle.index );
 
@@ -1158,7 +1183,9 @@ void FrameGraphBuilder::add_resource( cstring name, FrameGraphResourceType type,
     resource->resource_info = resource_info;
     resource->ref_count = 0;
 
-    resource_cache.resource_map.insert( hash_bytes( ( void* )name, strlen( name ) ), resource_handle.index );
+    const u64 name_hash = hash_bytes( ( void* )name, strlen( name ) );
+    hashed_string_check( name_hash, name );
+    resource_cache.resource_map.insert( name_hash, resource_handle.index );
 }
 
 FrameGraphResource* FrameGraphBuilder::get_resource( cstring name ) {
@@ -1172,6 +1199,19 @@ FrameGraphResource* FrameGraphBuilder::get_resource( cstring name ) {
     return resource;
 }
 
+FrameGraphResource* FrameGraphBuilder::get_resource( const HashedString& name ) {
+    hashed_string_check( name );
+
+    FlatHashMapIterator it = resource_cache.resource_map.find( name.hash, name.key_hash );
+    if ( it.is_invalid() ) {
+        return nullptr;
+    }
+
+    FrameGraphResource* resource = resource_cache.resources.get( resource_cache.resource_map.get( it ) );
+
+    return resource;
+}
+
 FrameGraphResource* FrameGraphBuilder::access_resource( FrameGraphResourceHandle handle ) {
     FrameGraphResource* resource = resource_cache.resources.get( handle.index );
 
@@ -197,10 +197,12 @@ struct FrameGraphBuilder : public Service {
     FrameGraphNodeHandle            create_node( const FrameGraphNodeCreation& creation );
 
     FrameGraphNode*                 get_node( cstring name );
+    FrameGraphNode*                 get_node( const HashedString& name );
     FrameGraphNode*                 access_node( FrameGraphNodeHandle handle );
 
     void                            add_resource( cstring name, FrameGraphResourceType type, FrameGraphResourceInfo resource_info );
     FrameGraphResource*             get_resource( cstring name );
+    FrameGraphResource*             get_resource( const HashedString& name );
     FrameGraphResource*             access_resource( FrameGraphResourceHandle handle );
 
     FrameGraphResourceCache         resource_cache;
@@ -241,10 +243,12 @@ struct FrameGraph {
 
     void                            add_node( FrameGraphNodeCreation& creation );
     FrameGraphNode*                 get_node( cstring name );
+    FrameGraphNode*                 get_node( const HashedString& name );
     FrameGraphNode*                 access_node( FrameGraphNodeHandle handle );
 
     void                            add_resource( cstring name, FrameGraphResourceType type, FrameGraphResourceInfo resource_info );
     FrameGraphResource*             get_resource( cstring name );
+    FrameGraphResource*             get_resource( const HashedString& name );
     FrameGraphResource*             access_resource( FrameGraphResourceHandle handle );
 
     // NOTE(marco): nodes sorted in topological order
@@ -1,4 +1,6 @@
 #include "graphics/gltf_scene.hpp"
+#include "graphics/animation_compression.hpp"
+#include "graphics/baked_scene.hpp"
 #include "graphics/gpu_profiler.hpp"
 #include "graphics/raptor_imgui.hpp"
 #include "graphics/asynchronous_loader.hpp"
@@ -9,7 +11,6 @@
 #include "foundation/numerics.hpp"
 
 #include "external/imgui/imgui.h"
-#include "external/stb_image.h"
 
 #include "external/cglm/struct/affine.h"
 #include "external/cglm/struct/mat4.h"
@@ -17,117 +18,12 @@
 #include "external/cglm/struct/quat.h"
 
 #include "external/tracy/tracy/Tracy.hpp"
-#include "external/meshoptimizer/meshoptimizer.h"
 
 namespace raptor {
 
 //
 // glTFScene //////////////////////////////////////////////////////////////
 
-void glTFScene::get_mesh_vertex_buffer( glTF::glTF& gltf_scene, u32 buffers_offset, i32 accessor_index, u32 flag, BufferHandle& out_buffer_handle, u32& out_buffer_offset, u32& out_flags ) {
-    if ( accessor_index != -1 ) {
-        glTF::Accessor& buffer_accessor = gltf_scene.accessors[ accessor_index ];
-        glTF::BufferView& buffer_view = gltf_scene.buffer_views[ buffer_accessor.buffer_view ];
-        BufferResource& buffer_gpu = buffers[ buffer_view.buffer + buffers_offset ];
-
-        out_buffer_handle = buffer_gpu.handle;
-        out_buffer_offset = glTF::get_data_offset( buffer_accessor.byte_offset, buffer_view.byte_offset );
-
-        out_flags |= flag;
-    }
-}
-
-void glTFScene::fill_pbr_material( glTF::glTF& gltf_scene, Renderer& renderer, glTF::Material& material, PBRMaterial& pbr_material ) {
-    GpuDevice& gpu = *renderer.gpu;
-
-    // Handle flags
-    if ( material.alpha_mode.data != nullptr && strcmp( material.alpha_mode.data, "MASK" ) == 0 ) {
-        pbr_material.flags |= DrawFlags_AlphaMask;
-    } else if ( material.alpha_mode.data != nullptr && strcmp( material.alpha_mode.data, "BLEND" ) == 0 ) {
-        // TODO: how to choose when using dithering and traditional blending ?
-        pbr_material.flags |= DrawFlags_Transparent;
-        //pbr_material.flags |= DrawFlags_AlphaDither;
-    }
-
-    pbr_material.flags |= material.double_sided ? DrawFlags_DoubleSided : 0;
-    // Alpha cutoff
-    pbr_material.alpha_cutoff = material.alpha_cutoff != glTF::INVALID_FLOAT_VALUE ? material.alpha_cutoff : 1.f;
-
-    if ( material.pbr_metallic_roughness != nullptr ) {
-        if ( material.pbr_metallic_roughness->base_color_factor_count != 0 ) {
-            RASSERT( material.pbr_metallic_roughness->base_color_factor_count == 4 );
-
-            memcpy( pbr_material.base_color_factor.raw, material.pbr_metallic_roughness->base_color_factor, sizeof( vec4s ) );
-        } else {
-            pbr_material.base_color_factor = { 1.0f, 1.0f, 1.0f, 1.0f };
-        }
-
-        pbr_material.roughness = material.pbr_metallic_roughness->roughness_factor != glTF::INVALID_FLOAT_VALUE ? material.pbr_metallic_roughness->roughness_factor : 1.f;
-        pbr_material.metallic = material.pbr_metallic_roughness->metallic_factor != glTF::INVALID_FLOAT_VALUE ? material.pbr_metallic_roughness->metallic_factor : 0.f;
-
-        pbr_material.diffuse_texture_index = get_material_texture( gpu, gltf_scene, material.pbr_metallic_roughness->base_color_texture );
-        pbr_material.roughness_texture_index = get_material_texture( gpu, gltf_scene, material.pbr_metallic_roughness->metallic_roughness_texture );
-    }
-
-    if ( material.emissive_texture != nullptr ) {
-        pbr_material.emissive_texture_index = get_material_texture( gpu, gltf_scene, material.emissive_texture );
-    }
-
-    if ( material.emissive_factor_count != 0 ) {
-        RASSERT( material.emissive_factor_count == 3 );
-
-        memcpy( pbr_material.emissive_factor.raw, material.emissive_factor, sizeof( vec3s ) );
-    } else {
-        pbr_material.emissive_factor = { 0.0f, 0.0f, 0.0f };
-    }
-
-    pbr_material.occlusion_texture_index = get_material_texture( gpu, gltf_scene, ( material.occlusion_texture != nullptr ) ? material.occlusion_texture->index : -1 );
-    pbr_material.normal_texture_index = get_material_texture( gpu, gltf_scene, ( material.normal_texture != nullptr ) ? material.normal_texture->index : -1 );
-
-    if ( material.occlusion_texture != nullptr ) {
-        if ( material.occlusion_texture->strength != glTF::INVALID_FLOAT_VALUE ) {
-            pbr_material.occlusion = material.occlusion_texture->strength;
-        } else {
-            pbr_material.occlusion = 1.0f;
-        }
-    }
-}
-
-u16 glTFScene::get_material_texture( GpuDevice& gpu, glTF::glTF& gltf_scene, glTF::TextureInfo* texture_info ) {
-    if ( texture_info != nullptr ) {
-        glTF::Texture& gltf_texture = gltf_scene.textures[ texture_info->index ];
-        TextureResource& texture_gpu = images[ gltf_texture.source ];
-
-        if ( gltf_texture.sampler != i32_max ) {
-            SamplerResource& sampler_gpu = samplers[ gltf_texture.sampler ];
-
-            gpu.link_texture_sampler( texture_gpu.handle, sampler_gpu.handle );
-        }
-
-        return texture_gpu.handle.index;
-    }
-    else {
-        return k_invalid_scene_texture_index;
-    }
-}
-
-u16 glTFScene::get_material_texture( GpuDevice& gpu, glTF::glTF& gltf_scene, i32 gltf_texture_index ) {
-    if ( gltf_texture_index >= 0 ) {
-        glTF::Texture& gltf_texture = gltf_scene.textures[ gltf_texture_index ];
-        TextureResource& texture_gpu = images[ gltf_texture.source ];
-
-        if ( gltf_texture.sampler != i32_max ) {
-            SamplerResource& sampler_gpu = samplers[ gltf_texture.sampler ];
-
-            gpu.link_texture_sampler( texture_gpu.handle, sampler_gpu.handle );
-        }
-
-        return texture_gpu.handle.index;
-    } else {
-        return k_invalid_scene_texture_index;
-    }
-}
-
 void glTFScene::init( SceneGraph* scene_graph_, Allocator* resident_allocator_, Renderer* renderer_ ) {
 
     resident_allocator = resident_allocator_;
@@ -151,131 +47,85 @@ void glTFScene::init( SceneGraph* scene_graph_, Allocator* resident_allocator_,
     samplers.init( resident_allocator, 8 );
 
     animations.init( resident_allocator, 8 );
+    animation_instances.init( resident_allocator, 4 );
     skins.init( resident_allocator, 8 );
 
     geometries.init( resident_allocator, 16 );
     build_range_infos.init( resident_allocator, 16 );
     geometry_transform_buffers.init( resident_allocator, 4 );
 
-    gltf_scenes.init( resident_allocator, 4 );
+    baked_scenes.init( resident_allocator, 4 );
 }
 
 void glTFScene::add_mesh( cstring filename, cstring path, StackAllocator* temp_allocator, AsynchronousLoader* async_loader ) {
 
-    enki::TaskScheduler* task_scheduler = async_loader->task_scheduler;
-    sizet temp_allocator_initial_marker = temp_allocator->get_marker();
-
     // Time statistics
     i64 start_scene_loading = time_now();
 
-    glTF::glTF gltf_scene = gltf_load_file( filename );
-    gltf_scenes.push( gltf_scene );
+    // Baked scenes are mapped, glTF files are baked in memory first.
+    cstring extension = strrchr( filename, '.' );
+    const bool is_baked = extension != nullptr && strcmp( extension + 1, k_baked_scene_extension ) == 0;
 
-    i64 end_loading_file = time_now();
-
-    Array<TextureCreation> tcs;
-    tcs.init( temp_allocator, gltf_scene.images_count, gltf_scene.images_count );
+    BlobSerializer& blob = baked_scenes.push_use();
+    blob = BlobSerializer{ };
 
-    StringBuffer temp_name_buffer;
-    temp_name_buffer.init( 4096, temp_allocator );
+    const u32 bake_flags = ( cook_textures ? BakeFlags_CookTextures : BakeFlags_None ) | ( use_meshlet_cache ? BakeFlags_MeshletCache : BakeFlags_None ) |
+                           ( optimize_meshes ? BakeFlags_OptimizeMeshes : BakeFlags_None );
+    BakedScene* baked_scene = is_baked ? baked_scene_map( filename, blob, resident_allocator ) : gltf_bake_scene( filename, blob, resident_allocator, temp_allocator, bake_flags, async_loader->task_scheduler );
+    if ( baked_scene == nullptr ) {
+        blob.shutdown();
+        baked_scenes.pop();
+        return;
+    }
 
-    for ( u32 image_index = 0; image_index < gltf_scene.images_count; ++image_index ) {
-        glTF::Image& image = gltf_scene.images[ image_index ];
+    if ( !is_baked && write_baked_scenes ) {
+        const int name_length = extension ? ( int )( extension - filename ) : ( int )strlen( filename );
 
-        int comp, width, height;
+        char baked_filename[ 512 ];
+        snprintf( baked_filename, 512, "%.*s.%s", name_length, filename, k_baked_scene_extension );
+        blob.write_file( baked_filename );
 
-        stbi_info( image.uri.data, &width, &height, &comp );
+        rprint( "Written baked scene %s\n", baked_filename );
+    }
 
-        u32 mip_levels = 1;
-        if ( true ) {
-            u32 w = width;
-            u32 h = height;
+    i64 end_loading_file = time_now();
 
-            while ( w > 1 && h > 1 ) {
-                w /= 2;
-                h /= 2;
+    add_baked_scene( *baked_scene, path, temp_allocator, async_loader );
 
-                ++mip_levels;
-            }
-        }
+    i64 end_loading = time_now();
 
-        TextureCreation tc;
-        tc.set_data( nullptr ).set_format_type( VK_FORMAT_R8G8B8A8_UNORM, TextureType::Texture2D ).set_flags( 0 ).set_size( ( u16 )width, ( u16 )height, 1 ).set_name( image.uri.data ).set_mips( mip_levels );
-        TextureResource* tr = renderer->create_texture( tc );
-        RASSERT( tr != nullptr );
+    rprint( "Loaded scene %s in %f seconds.\nStats:\n\t%s %f seconds\n\tCreating resources %f seconds\n", filename,
+            time_delta_seconds( start_scene_loading, end_loading ), is_baked ? "Mapping baked file" : "Baking GLTF file",
+            time_delta_seconds( start_scene_loading, end_loading_file ), time_delta_seconds( end_loading_file, end_loading ) );
+}
 
-        images.push( *tr );
+static u16 baked_texture_index( Array<TextureResource>& images, u32 images_offset, u16 baked_image ) {
+    return baked_image != k_invalid_scene_texture_index ? ( u16 )images[ images_offset + baked_image ].handle.index : k_invalid_scene_texture_index;
+}
 
-        // Reconstruct file path
-        char* full_filename = temp_name_buffer.append_use_f( "%s%s", path, image.uri.data );
-        async_loader->request_texture_data( full_filename, tr->handle );
-        // Reset name buffer
-        temp_name_buffer.clear();
+static void baked_buffer_handle( Array<BufferResource>& buffers, u32 buffers_offset, u32 baked_buffer, BufferHandle& out_buffer_handle ) {
+    if ( baked_buffer != k_baked_invalid_index ) {
+        out_buffer_handle = buffers[ buffers_offset + baked_buffer ].handle;
     }
+}
+
+void glTFScene::add_baked_scene( BakedScene& baked_scene, cstring path, StackAllocator* temp_allocator, AsynchronousLoader* async_loader ) {
 
-    i64 end_loading_textures_files = time_now();
+    sizet temp_allocator_initial_marker = temp_allocator->get_marker();
 
-    i64 end_creating_textures = time_now();
+    StringBuffer temp_name_buffer;
+    temp_name_buffer.init( 4096, temp_allocator );
 
     // Load all samplers
-    for ( u32 sampler_index = 0; sampler_index < gltf_scene.samplers_count; ++sampler_index ) {
-        glTF::Sampler& sampler = gltf_scene.samplers[ sampler_index ];
+    const u32 samplers_offset = samplers.size;
+    for ( u32 sampler_index = 0; sampler_index < baked_scene.samplers.size; ++sampler_index ) {
+        BakedSampler& baked_sampler = baked_scene.samplers[ sampler_index ];
 
         char* sampler_name = names_buffer.append_use_f( "sampler_%u", sampler_index );
 
         SamplerCreation creation;
-        switch ( sampler.min_filter ) {
-            case glTF::Sampler::NEAREST:
-                creation.min_filter = VK_FILTER_NEAREST;
-                break;
-            case glTF::Sampler::LINEAR:
-                creation.min_filter = VK_FILTER_LINEAR;
-                break;
-            case glTF::Sampler::LINEAR_MIPMAP_NEAREST:
-                creation.min_filter = VK_FILTER_LINEAR;
-                creation.mip_filter = VK_SAMPLER_MIPMAP_MODE_NEAREST;
-                break;
-            case glTF::Sampler::LINEAR_MIPMAP_LINEAR:
-                creation.min_filter = VK_FILTER_LINEAR;
-                creation.mip_filter = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-                break;
-            case glTF::Sampler::NEAREST_MIPMAP_NEAREST:
-                creation.min_filter = VK_FILTER_NEAREST;
-                creation.mip_filter = VK_SAMPLER_MIPMAP_MODE_NEAREST;
-                break;
-            case glTF::Sampler::NEAREST_MIPMAP_LINEAR:
-                creation.min_filter = VK_FILTER_NEAREST;
-                creation.mip_filter = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-                break;
-        }
-
-        creation.mag_filter = sampler.mag_filter == glTF::Sampler::Filter::LINEAR ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
-
-        switch ( sampler.wrap_s ) {
-            case glTF::Sampler::CLAMP_TO_EDGE:
-                creation.address_mode_u = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-                break;
-            case glTF::Sampler::MIRRORED_REPEAT:
-                creation.address_mode_u = VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
-                break;
-            case glTF::Sampler::REPEAT:
-                creation.address_mode_u = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-                break;
-        }
-
-        switch ( sampler.wrap_t ) {
-            case glTF::Sampler::CLAMP_TO_EDGE:
-                creation.address_mode_v = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-                break;
-            case glTF::Sampler::MIRRORED_REPEAT:
-                creation.address_mode_v = VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
-                break;
-            case glTF::Sampler::REPEAT:
-                creation.address_mode_v = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-                break;
-        }
-
-        creation.name = sampler_name;
+        creation.set_min_mag_mip( ( VkFilter )baked_sampler.min_filter, ( VkFilter )baked_sampler.mag_filter, ( VkSamplerMipmapMode )baked_sampler.mip_filter )
+                .set_address_mode_uv( ( VkSamplerAddressMode )baked_sampler.address_mode_u, ( VkSamplerAddressMode )baked_sampler.address_mode_v ).set_name( sampler_name );
 
         SamplerResource* sr = renderer->create_sampler( creation );
         RASSERT( sr != nullptr );
@@ -283,319 +133,42 @@ void glTFScene::add_mesh( cstring filename, cstring path, StackAllocator* temp_a
         samplers.push( *sr );
     }
 
-    i64 end_creating_samplers = time_now();
+    // Create all textures and request their data
+    const u32 images_offset = images.size;
+    for ( u32 image_index = 0; image_index < baked_scene.images.size; ++image_index ) {
+        BakedImage& image = baked_scene.images[ image_index ];
 
-    // Temporary array of buffer data
-    Array<void*> buffers_data;
-    buffers_data.init( resident_allocator, gltf_scene.buffers_count );
-
-    for ( u32 buffer_index = 0; buffer_index < gltf_scene.buffers_count; ++buffer_index ) {
-        glTF::Buffer& buffer = gltf_scene.buffers[ buffer_index ];
+        TextureCreation tc;
+        tc.set_data( nullptr ).set_format_type( ( VkFormat )image.format, TextureType::Texture2D ).set_flags( 0 ).set_size( image.width, image.height, 1 ).set_name( image.uri.c_str() ).set_mips( image.mip_levels );
+        TextureResource* tr = renderer->create_texture( tc );
+        RASSERT( tr != nullptr );
 
-        FileReadResult buffer_data = file_read_binary( buffer.uri.data, resident_allocator );
-        buffers_data.push( buffer_data.data );
-    }
+        images.push( *tr );
 
+        if ( image.sampler_index >= 0 ) {
+            renderer->gpu->link_texture_sampler( tr->handle, samplers[ samplers_offset + image.sampler_index ].handle );
+        }
 
-    // Load all buffers and initialize them with buffer data
-    u32 buffers_offset = buffers.size;
-    for ( u32 buffer_index = 0; buffer_index < gltf_scene.buffers_count; ++buffer_index ) {
+        // Reconstruct file path
+        char* full_filename = temp_name_buffer.append_use_f( "%s%s", path, image.uri.c_str() );
+        async_loader->request_texture_data( full_filename, tr->handle, image.mip_levels, image.mip_flags, image.alpha_cutoff );
+        // Reset name buffer
+        temp_name_buffer.clear();
+    }
 
-        glTF::Buffer& buffer = gltf_scene.buffers[ buffer_index ];
+    // Load all buffers, data comes straight from the baked scene.
+    const u32 buffers_offset = buffers.size;
+    for ( u32 buffer_index = 0; buffer_index < baked_scene.buffers.size; ++buffer_index ) {
+        BakedBuffer& baked_buffer = baked_scene.buffers[ buffer_index ];
 
         VkBufferUsageFlags flags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT_KHR | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR;
 
         char* buffer_name = names_buffer.append_use_f( "buffer_%u", buffer_index );
 
-        u8* buffer_data = ( u8* )buffers_data[ buffer_index ];
-        BufferResource* br = renderer->create_buffer( flags, ResourceUsageType::Immutable, buffer.byte_length, buffer_data, buffer_name );
+        BufferResource* br = renderer->create_buffer( flags, ResourceUsageType::Immutable, baked_buffer.data.size, baked_buffer.data.get(), buffer_name );
         buffers.push( *br );
     }
 
-
-    i64 end_reading_buffers_data = time_now();
-
-    // Build meshlets
-    const sizet max_vertices = 64;
-    const sizet max_triangles = 124;
-    const f32 cone_weight = 0.0f;
-
-    u32 mesh_index = 0;
-
-    mesh_aabb[0] = vec3s{ FLT_MAX, FLT_MAX, FLT_MAX };
-    mesh_aabb[1] = vec3s{ FLT_MIN, FLT_MIN, FLT_MIN };
-
-    sizet temp_marker = temp_allocator->get_marker();
-
-    u32 mesh_offset = meshes.size;
-    u32 mesh_instances_offset = mesh_instances.size;
-
-    for ( u32 mi = 0; mi < gltf_scene.meshes_count; ++mi ) {
-        glTF::Mesh& mesh = gltf_scene.meshes[ mi ];
-
-        gltf_mesh_to_mesh_offset.push( meshes.size );
-
-        for ( u32 p = 0; p < mesh.primitives_count; ++p ) {
-            glTF::MeshPrimitive& mesh_primitive = mesh.primitives[ p ];
-
-            /*if ( mesh_primitive.material != glTF::INVALID_INT_VALUE ) {
-                glTF::Material& material = gltf_scene.materials[ mesh_primitive.material ];
-
-                if ( ( material.alpha_mode.data != nullptr && strcmp( material.alpha_mode.data, "MASK" ) == 0 ) ||
-                     ( material.alpha_mode.data != nullptr && strcmp( material.alpha_mode.data, "BLEND" ) == 0 ) ) {
-                    continue;
-                }
-            }*/
-
-            // Add meshes
-            Mesh mesh{};
-            // Load material defaults: flags is modified after this point.
-            mesh.pbr_material = {};
-
-            // Vertex positions
-            const i32 position_accessor_index = gltf_get_attribute_accessor_index( mesh_primitive.attributes, mesh_primitive.attribute_count, "POSITION" );
-            glTF::Accessor& position_buffer_accessor = gltf_scene.accessors[ position_accessor_index ];
-            glTF::BufferView& position_buffer_view = gltf_scene.buffer_views[ position_buffer_accessor.buffer_view ];
-            i32 position_data_offset = glTF::get_data_offset( position_buffer_accessor.byte_offset, position_buffer_view.byte_offset );
-            f32* vertices = ( f32* )((u8*)buffers_data[ position_buffer_view.buffer ] + position_data_offset);
-
-            // Calculate bounding sphere center
-            vec3s position_min{ position_buffer_accessor.min[ 0 ], position_buffer_accessor.min[ 1 ], position_buffer_accessor.min[ 2 ] };
-            vec3s position_max{ position_buffer_accessor.max[ 0 ], position_buffer_accessor.max[ 1 ], position_buffer_accessor.max[ 2 ] };
-            vec3s bounding_center = glms_vec3_add( position_min, position_max );
-            bounding_center = glms_vec3_divs( bounding_center, 2.0f );
-
-            // Calculate bounding sphere radius
-            f32 radius = raptor::max( glms_vec3_distance( position_max, bounding_center ), glms_vec3_distance( position_min, bounding_center ) );
-            mesh.bounding_sphere = { bounding_center.x, bounding_center.y, bounding_center.z, radius };
-
-            // Vertex normals
-            const i32 normal_accessor_index = gltf_get_attribute_accessor_index( mesh_primitive.attributes, mesh_primitive.attribute_count, "NORMAL" );
-            f32* normals = nullptr;
-            if ( normal_accessor_index != -1 ) {
-                glTF::Accessor& normal_buffer_accessor = gltf_scene.accessors[ normal_accessor_index ];
-                glTF::BufferView& normal_buffer_view = gltf_scene.buffer_views[ normal_buffer_accessor.buffer_view ];
-                i32 normal_data_offset = glTF::get_data_offset( normal_buffer_accessor.byte_offset, normal_buffer_view.byte_offset );
-                normals = ( f32* )((u8*)buffers_data[ normal_buffer_view.buffer ] + normal_data_offset);
-            }
-
-            // Vertex texture coords
-            const i32 tex_coord_accessor_index = gltf_get_attribute_accessor_index( mesh_primitive.attributes, mesh_primitive.attribute_count, "TEXCOORD_0" );
-            f32* tex_coords = nullptr;
-            if ( tex_coord_accessor_index != -1 ) {
-                glTF::Accessor& tex_coord_buffer_accessor = gltf_scene.accessors[ tex_coord_accessor_index ];
-                glTF::BufferView& tex_coord_buffer_view = gltf_scene.buffer_views[ tex_coord_buffer_accessor.buffer_view ];
-                i32 tex_coord_data_offset = glTF::get_data_offset( tex_coord_buffer_accessor.byte_offset, tex_coord_buffer_view.byte_offset );
-                tex_coords = ( f32* )((u8*)buffers_data[ tex_coord_buffer_view.buffer ] + tex_coord_data_offset);
-            }
-
-            // Vertex tangents
-            const i32 tangent_accessor_index = gltf_get_attribute_accessor_index( mesh_primitive.attributes, mesh_primitive.attribute_count, "TANGENT" );
-            f32* tangents = nullptr;
-            if ( tangent_accessor_index != -1 ) {
-                glTF::Accessor& tangent_buffer_accessor = gltf_scene.accessors[ tangent_accessor_index ];
-                glTF::BufferView& tangent_buffer_view = gltf_scene.buffer_views[ tangent_buffer_accessor.buffer_view ];
-                i32 tangent_data_offset = glTF::get_data_offset( tangent_buffer_accessor.byte_offset, tangent_buffer_view.byte_offset );
-                tangents = ( f32* )((u8*)buffers_data[ tangent_buffer_view.buffer ] + tangent_data_offset);
-            }
-
-            // Cache vertex buffers
-            get_mesh_vertex_buffer( gltf_scene, buffers_offset, position_accessor_index, 0, mesh.position_buffer, mesh.position_offset, mesh.pbr_material.flags );
-            get_mesh_vertex_buffer( gltf_scene, buffers_offset, tangent_accessor_index, DrawFlags_HasTangents, mesh.tangent_buffer, mesh.tangent_offset, mesh.pbr_material.flags );
-            get_mesh_vertex_buffer( gltf_scene, buffers_offset, normal_accessor_index, DrawFlags_HasNormals, mesh.normal_buffer, mesh.normal_offset, mesh.pbr_material.flags );
-            get_mesh_vertex_buffer( gltf_scene, buffers_offset, tex_coord_accessor_index, DrawFlags_HasTexCoords, mesh.texcoord_buffer, mesh.texcoord_offset, mesh.pbr_material.flags );
-
-            const i32 joints_accessor_index = gltf_get_attribute_accessor_index( mesh_primitive.attributes, mesh_primitive.attribute_count, "JOINTS_0" );
-            const i32 weights_accessor_index = gltf_get_attribute_accessor_index( mesh_primitive.attributes, mesh_primitive.attribute_count, "WEIGHTS_0" );
-
-            get_mesh_vertex_buffer( gltf_scene, buffers_offset, joints_accessor_index, DrawFlags_HasJoints, mesh.joints_buffer, mesh.joints_offset, mesh.pbr_material.flags );
-            get_mesh_vertex_buffer( gltf_scene, buffers_offset, weights_accessor_index, DrawFlags_HasWeights, mesh.weights_buffer, mesh.weights_offset, mesh.pbr_material.flags );
-
-
-            // Index buffer
-            glTF::Accessor& indices_accessor = gltf_scene.accessors[ mesh_primitive.indices ];
-            glTF::BufferView& indices_buffer_view = gltf_scene.buffer_views[ indices_accessor.buffer_view ];
-            u8* buffer_data = ( u8* )buffers_data[ indices_buffer_view.buffer ];
-            i32 index_data_offset = glTF::get_data_offset( indices_accessor.byte_offset, indices_buffer_view.byte_offset );
-            u16* indices = ( u16* )(buffer_data + index_data_offset);
-
-            // Read pbr material data if present
-            if ( mesh_primitive.material != glTF::INVALID_INT_VALUE ) {
-                glTF::Material& material = gltf_scene.materials[ mesh_primitive.material ];
-                fill_pbr_material( gltf_scene, *renderer, material, mesh.pbr_material );
-            }
-
-            BufferResource& indices_buffer_gpu = buffers[ indices_buffer_view.buffer + buffers_offset ];
-            mesh.index_buffer = indices_buffer_gpu.handle;
-            mesh.index_offset = glTF::get_data_offset( indices_accessor.byte_offset, indices_buffer_view.byte_offset );
-            mesh.primitive_count = indices_accessor.count;
-
-            mesh.gpu_mesh_index = meshes.size;
-
-            const sizet max_meshlets = meshopt_buildMeshletsBound( indices_accessor.count, max_vertices, max_triangles );
-
-            Array<meshopt_Meshlet> local_meshlets;
-            local_meshlets.init( temp_allocator, max_meshlets, max_meshlets );
-
-            Array<u32> meshlet_vertex_indices;
-            meshlet_vertex_indices.init( temp_allocator, max_meshlets * max_vertices, max_meshlets* max_vertices );
-
-            Array<u8> meshlet_triangles;
-            meshlet_triangles.init( temp_allocator, max_meshlets * max_triangles * 3, max_meshlets * max_triangles * 3 );
-
-            sizet meshlet_count = meshopt_buildMeshlets( local_meshlets.data, meshlet_vertex_indices.data, meshlet_triangles.data, indices,
-                                                         indices_accessor.count, vertices, position_buffer_accessor.count, sizeof( vec3s ),
-                                                         max_vertices, max_triangles, cone_weight );
-
-            u32 meshlet_vertex_offset = meshlets_vertex_positions.size;
-            for ( u32 v = 0; v < position_buffer_accessor.count; ++v ) {
-                GpuMeshletVertexPosition meshlet_vertex_pos{ };
-
-                f32 x = vertices[ v * 3 + 0 ];
-                f32 y = vertices[ v * 3 + 1 ];
-                f32 z = vertices[ v * 3 + 2 ];
-
-                if ( x < mesh_aabb[ 0 ].x )
-                {
-                    mesh_aabb[ 0 ].x = x;
-                }
-                if ( y < mesh_aabb[ 0 ].y )
-                {
-                    mesh_aabb[ 0 ].y = y;
-                }
-                if ( z < mesh_aabb[ 0 ].z )
-                {
-                    mesh_aabb[ 0 ].z = z;
-                }
-
-                if ( x > mesh_aabb[ 1 ].x )
-                {
-                    mesh_aabb[ 1 ].x = x;
-                }
-                if ( y > mesh_aabb[ 1 ].y )
-                {
-                    mesh_aabb[ 1 ].y = y;
-                }
-                if ( z > mesh_aabb[ 1 ].z )
-                {
-                    mesh_aabb[ 1 ].z = z;
-                }
-
-                meshlet_vertex_pos.position[ 0 ] = x;
-                meshlet_vertex_pos.position[ 1 ] = y;
-                meshlet_vertex_pos.position[ 2 ] = z;
-
-                meshlets_vertex_positions.push( meshlet_vertex_pos );
-
-                GpuMeshletVertexData meshlet_vertex_data{ };
-
-                if ( normals != nullptr ) {
-                    meshlet_vertex_data.normal[ 0 ] = ( normals[ v * 3 + 0 ] + 1.0f ) * 127.0f;
-                    meshlet_vertex_data.normal[ 1 ] = ( normals[ v * 3 + 1 ] + 1.0f ) * 127.0f;
-                    meshlet_vertex_data.normal[ 2 ] = ( normals[ v * 3 + 2 ] + 1.0f ) * 127.0f;
-                }
-
-                if ( tangents != nullptr ) {
-                    meshlet_vertex_data.tangent[ 0 ] = ( tangents[ v * 3 + 0 ] + 1.0f ) * 127.0f;
-                    meshlet_vertex_data.tangent[ 1 ] = ( tangents[ v * 3 + 1 ] + 1.0f ) * 127.0f;
-                    meshlet_vertex_data.tangent[ 2 ] = ( tangents[ v * 3 + 2 ] + 1.0f ) * 127.0f;
-                    meshlet_vertex_data.tangent[ 3 ] = ( tangents[ v * 3 + 3 ] + 1.0f ) * 127.0f;
-                }
-
-                meshlet_vertex_data.uv_coords[ 0 ] = meshopt_quantizeHalf( tex_coords[ v * 2 + 0 ] );
-                meshlet_vertex_data.uv_coords[ 1 ] = meshopt_quantizeHalf( tex_coords[ v * 2 + 1 ] );
-
-                meshlets_vertex_data.push( meshlet_vertex_data );
-            }
-
-            // Cache meshlet offset
-            mesh.meshlet_offset = meshlets.size;
-            mesh.meshlet_count = meshlet_count;
-            mesh.meshlet_index_count = 0;
-
-            // Append meshlet data
-            for ( u32 m = 0; m < meshlet_count; ++m ) {
-                meshopt_Meshlet& local_meshlet = local_meshlets[ m ];
-
-                meshopt_Bounds meshlet_bounds = meshopt_computeMeshletBounds(meshlet_vertex_indices.data + local_meshlet.vertex_offset,
-                                                                             meshlet_triangles.data + local_meshlet.triangle_offset, local_meshlet.triangle_count,
-                                                                             vertices, position_buffer_accessor.count, sizeof( vec3s ));
-
-                GpuMeshlet meshlet{};
-                meshlet.data_offset = meshlets_data.size;
-                meshlet.vertex_count = local_meshlet.vertex_count;
-                meshlet.triangle_count = local_meshlet.triangle_count;
-
-                meshlet.center = vec3s{ meshlet_bounds.center[ 0 ], meshlet_bounds.center[ 1 ], meshlet_bounds.center[ 2 ] };
-                meshlet.radius = meshlet_bounds.radius;
-
-                meshlet.cone_axis[ 0 ] = meshlet_bounds.cone_axis_s8[ 0 ];
-                meshlet.cone_axis[ 1 ] = meshlet_bounds.cone_axis_s8[ 1 ];
-                meshlet.cone_axis[ 2 ] = meshlet_bounds.cone_axis_s8[ 2 ];
-
-                meshlet.cone_cutoff = meshlet_bounds.cone_cutoff_s8;
-                meshlet.mesh_index = meshes.size;
-
-                // Resize data array
-                const u32 index_group_count = ( local_meshlet.triangle_count * 3 + 3 ) / 4;
-                meshlets_data.set_capacity( meshlets_data.size + local_meshlet.vertex_count + index_group_count );
-
-                for ( u32 i = 0; i < meshlet.vertex_count; ++i ) {
-                    const u32 vertex_index = meshlet_vertex_offset + meshlet_vertex_indices[ local_meshlet.vertex_offset + i ];
-                    meshlets_data.push( vertex_index );
-                }
-
-                // Store indices as uint32
-                // NOTE(marco): we write 4 indices at at time, it will come in handy in the mesh shader
-                const u32* index_groups = reinterpret_cast< const u32* >( meshlet_triangles.data + local_meshlet.triangle_offset );
-                for ( u32 i = 0; i < index_group_count; ++i ) {
-                    const u32 index_group = index_groups[ i ];
-                    meshlets_data.push( index_group );
-                }
-
-                // Writing in group of fours can be problematic, if there are non multiple of 3
-                // indices a triangle can be shared between meshlets.
-                // We need to add some padding for that.
-                // This is visible only when emulating meshlets, so probably there are controls
-                // at driver level that avoid this problems when using mesh shaders.
-                // Check for the last 3 indices: if last one are two are zero, then add one or two
-                // groups of empty triangles.
-                u32 last_index_group = index_groups[ index_group_count - 1 ];
-                u32 last_index = ( last_index_group >> 8 ) & 0xff;
-                u32 second_last_index = ( last_index_group >> 16 ) & 0xff;
-                u32 third_last_index = ( last_index_group >> 24 ) & 0xff;
-                if ( last_index != 0 && third_last_index == 0 ) {
-
-                    if ( second_last_index != 0 ) {
-                        // Add a single index group of zeroes
-                        meshlets_data.push( 0 );
-                        meshlet.triangle_count++;
-                    }
-
-                    meshlet.triangle_count++;
-                    // Add another index group of zeroes
-                    meshlets_data.push( 0 );
-                }
-
-                mesh.meshlet_index_count += meshlet.triangle_count * 3;
-
-                meshlets.push( meshlet );
-
-                meshlets_index_count += index_group_count;
-            }
-
-            // Add mesh with all data
-            meshes.push( mesh );
-
-            while ( meshlets.size % 32 )
-                meshlets.push( GpuMeshlet() );
-
-            temp_allocator->free_marker( temp_marker );
-
-            mesh_index++;
-        }
-    }
-
     // Create material
     const u64 hashed_name = hash_calculate( "main" );
     GpuTechnique* main_technique = renderer->resource_cache.techniques.get( hashed_name );
@@ -605,147 +178,154 @@ void glTFScene::add_mesh( cstring filename, cstring path, StackAllocator* temp_a
 
     Material* pbr_material = renderer->create_material( material_creation );
 
-    glTF::Scene& root_gltf_scene = gltf_scene.scenes[ gltf_scene.scene ];
-
-    //
-    Array<i32> nodes_to_visit;
-    nodes_to_visit.init( temp_allocator, 4 );
-
-    // Calculate total node count: add first the root nodes.
-    u32 total_node_count = root_gltf_scene.nodes_count;
-
-    // Add initial nodes
-    for ( u32 node_index = 0; node_index < root_gltf_scene.nodes_count; ++node_index ) {
-        const i32 node = root_gltf_scene.nodes[ node_index ];
-        nodes_to_visit.push( node );
-    }
-    // Visit nodes
-    while ( nodes_to_visit.size ) {
-        i32 node_index = nodes_to_visit.front();
-        nodes_to_visit.delete_swap( 0 );
-
-        glTF::Node& node = gltf_scene.nodes[ node_index ];
-        for ( u32 ch = 0; ch < node.children_count; ++ch ) {
-            const i32 children_index = node.children[ ch ];
-            nodes_to_visit.push( children_index );
+    // Append meshes and meshlets, rebasing indices when other scenes are already loaded.
+    const u32 mesh_offset = meshes.size;
+    const u32 meshlet_offset = meshlets.size;
+    const u32 meshlet_vertex_offset = meshlets_vertex_positions.size;
+    const u32 meshlet_data_offset = meshlets_data.size;
+    const u32 skin_offset = skins.size;
+
+    meshes.set_capacity( mesh_offset + baked_scene.meshes.size );
+
+    for ( u32 mesh_index = 0; mesh_index < baked_scene.meshes.size; ++mesh_index ) {
+        BakedMesh& baked_mesh = baked_scene.meshes[ mesh_index ];
+        BakedMaterial& baked_material = baked_mesh.material;
+
+        Mesh mesh{};
+        mesh.pbr_material = {};
+
+        PBRMaterial& material = mesh.pbr_material;
+        material.base_color_factor = baked_material.base_color_factor;
+        material.emissive_factor = baked_material.emissive_factor;
+        material.metallic = baked_material.metallic;
+        material.roughness = baked_material.roughness;
+        material.occlusion = baked_material.occlusion;
+        material.alpha_cutoff = baked_material.alpha_cutoff;
+        material.flags = baked_material.flags;
+
+        material.diffuse_texture_index = baked_texture_index( images, images_offset, baked_material.diffuse_image );
+        material.roughness_texture_index = baked_texture_index( images, images_offset, baked_material.roughness_image );
+        material.normal_texture_index = baked_texture_index( images, images_offset, baked_material.normal_image );
+        material.occlusion_texture_index = baked_texture_index( images, images_offset, baked_material.occlusion_image );
+        material.emissive_texture_index = baked_texture_index( images, images_offset, baked_material.emissive_image );
+
+        // Cache vertex buffers
+        baked_buffer_handle( buffers, buffers_offset, baked_mesh.position_buffer, mesh.position_buffer );
+        baked_buffer_handle( buffers, buffers_offset, baked_mesh.tangent_buffer, mesh.tangent_buffer );
+        baked_buffer_handle( buffers, buffers_offset, baked_mesh.normal_buffer, mesh.normal_buffer );
+        baked_buffer_handle( buffers, buffers_offset, baked_mesh.texcoord_buffer, mesh.texcoord_buffer );
+        baked_buffer_handle( buffers, buffers_offset, baked_mesh.joints_buffer, mesh.joints_buffer );
+        baked_buffer_handle( buffers, buffers_offset, baked_mesh.weights_buffer, mesh.weights_buffer );
+        baked_buffer_handle( buffers, buffers_offset, baked_mesh.index_buffer, mesh.index_buffer );
+
+        mesh.position_offset = baked_mesh.position_offset;
+        mesh.tangent_offset = baked_mesh.tangent_offset;
+        mesh.normal_offset = baked_mesh.normal_offset;
+        mesh.texcoord_offset = baked_mesh.texcoord_offset;
+        mesh.joints_offset = baked_mesh.joints_offset;
+        mesh.weights_offset = baked_mesh.weights_offset;
+        mesh.index_offset = baked_mesh.index_offset;
+
+        mesh.index_type = ( VkIndexType )baked_mesh.index_type;
+        mesh.primitive_count = baked_mesh.primitive_count;
+
+        mesh.meshlet_offset = meshlet_offset + baked_mesh.meshlet_offset;
+        mesh.meshlet_count = baked_mesh.meshlet_count;
+        mesh.meshlet_index_count = baked_mesh.meshlet_index_count;
+
+        mesh.lod_count = baked_mesh.lod_count;
+        for ( u32 l = 0; l < baked_mesh.lod_count; ++l ) {
+            mesh.lods[ l ] = baked_mesh.lods[ l ];
+            mesh.lods[ l ].meshlet_offset += meshlet_offset;
         }
 
-        // Add only children nodes to the count, as the current node is
-        // already calculated when inserting it.
-        total_node_count += node.children_count;
-    }
+        mesh.gpu_mesh_index = meshes.size;
+        mesh.skin_index = baked_mesh.skin_index != i32_max ? baked_mesh.skin_index + skin_offset : i32_max;
+        mesh.bounding_sphere = baked_mesh.bounding_sphere;
 
-    u32 node_offset = scene_graph->node_count();
-    u32 new_node_count = node_offset + total_node_count;
-    scene_graph->resize( new_node_count );
-    scene_graph->init_new_nodes( node_offset, total_node_count );
-
-    // Populate scene graph: visit again
-    nodes_to_visit.clear();
-    // Add initial nodes
-    for ( u32 node_index = 0; node_index < root_gltf_scene.nodes_count; ++node_index ) {
-        const i32 node = root_gltf_scene.nodes[ node_index ];
-        nodes_to_visit.push( node );
+        meshes.push( mesh );
     }
 
-    u32 total_meshlets = 0;
+    meshlets.set_size( meshlet_offset + baked_scene.meshlets.size );
+    memory_copy( meshlets.data + meshlet_offset, baked_scene.meshlets.get(), sizeof( GpuMeshlet ) * baked_scene.meshlets.size );
 
-    while ( nodes_to_visit.size ) {
-        i32 gltf_node = nodes_to_visit.front();
-        i32 node_index = gltf_node + node_offset;
-        nodes_to_visit.delete_swap( 0 );
+    meshlets_vertex_positions.set_size( meshlet_vertex_offset + baked_scene.meshlets_vertex_positions.size );
+    memory_copy( meshlets_vertex_positions.data + meshlet_vertex_offset, baked_scene.meshlets_vertex_positions.get(), sizeof( GpuMeshletVertexPosition ) * baked_scene.meshlets_vertex_positions.size );
 
-        glTF::Node& node = gltf_scene.nodes[ gltf_node ];
+    meshlets_vertex_data.set_size( meshlet_vertex_offset + baked_scene.meshlets_vertex_data.size );
+    memory_copy( meshlets_vertex_data.data + meshlet_vertex_offset, baked_scene.meshlets_vertex_data.get(), sizeof( GpuMeshletVertexData ) * baked_scene.meshlets_vertex_data.size );
 
-        // Compute local transform: read either raw matrix or individual Scale/Rotation/Translation components
-        if ( node.matrix_count ) {
-            // CGLM and glTF have the same matrix layout, just memcopy it
-            memcpy( &scene_graph->local_matrices[ node_index ], node.matrix, sizeof( mat4s ) );
-            scene_graph->updated_nodes.set_bit( node_index );
-        }
-        else {
-            // Handle individual transform components: SRT (scale, rotation, translation)
-            vec3s node_scale{ 1.0f, 1.0f, 1.0f };
-            if ( node.scale_count ) {
-                RASSERT( node.scale_count == 3 );
-                node_scale = vec3s{ node.scale[ 0 ], node.scale[ 1 ], node.scale[ 2 ] };
-            }
+    meshlets_data.set_size( meshlet_data_offset + baked_scene.meshlets_data.size );
+    memory_copy( meshlets_data.data + meshlet_data_offset, baked_scene.meshlets_data.get(), sizeof( u32 ) * baked_scene.meshlets_data.size );
 
-            vec3s node_translation{ 0.f, 0.f, 0.f };
-            if ( node.translation_count ) {
-                RASSERT( node.translation_count == 3 );
-                node_translation = vec3s{ node.translation[ 0 ], node.translation[ 1 ], node.translation[ 2 ] };
+    if ( mesh_offset != 0 || meshlet_vertex_offset != 0 || meshlet_data_offset != 0 ) {
+        for ( u32 m = meshlet_offset; m < meshlets.size; ++m ) {
+            GpuMeshlet& meshlet = meshlets[ m ];
+            // Skip padding meshlets
+            if ( meshlet.vertex_count == 0 ) {
+                continue;
             }
 
-            // Rotation is written as a plain quaternion
-            versors node_rotation = glms_quat_identity();
-            if ( node.rotation_count ) {
-                RASSERT( node.rotation_count == 4 );
-                node_rotation = glms_quat_init( node.rotation[ 0 ], node.rotation[ 1 ], node.rotation[ 2 ], node.rotation[ 3 ] );
-            }
+            meshlet.mesh_index += mesh_offset;
+            meshlet.data_offset += meshlet_data_offset;
 
-            Transform transform;
-            transform.translation = node_translation;
-            transform.scale = node_scale;
-            transform.rotation = node_rotation;
-
-            // Final SRT composition
-            const mat4s local_matrix = transform.calculate_matrix();
-            scene_graph->set_local_matrix( node_index, local_matrix );
+            // Vertex indices come first in meshlet data, followed by packed triangles.
+            for ( u32 v = 0; v < meshlet.vertex_count; ++v ) {
+                meshlets_data[ meshlet.data_offset + v ] += meshlet_vertex_offset;
+            }
         }
+    }
 
-        // Handle parent-relationship
-        if ( node.children_count ) {
-            const Hierarchy& node_hierarchy = scene_graph->nodes_hierarchy[ node_index ];
+    meshlets_index_count += baked_scene.meshlets_index_count;
+
+    if ( mesh_offset == 0 ) {
+        mesh_aabb[ 0 ] = baked_scene.aabb[ 0 ];
+        mesh_aabb[ 1 ] = baked_scene.aabb[ 1 ];
+    } else {
+        mesh_aabb[ 0 ] = glms_vec3_minv( mesh_aabb[ 0 ], baked_scene.aabb[ 0 ] );
+        mesh_aabb[ 1 ] = glms_vec3_maxv( mesh_aabb[ 1 ], baked_scene.aabb[ 1 ] );
+    }
 
-            for ( u32 ch = 0; ch < node.children_count; ++ch) {
-                const i32 children_index = node.children[ ch ];
-                i32 global_child_index = children_index + node_offset;
-                Hierarchy& children_hierarchy = scene_graph->nodes_hierarchy[ global_child_index ];
-                scene_graph->set_hierarchy( global_child_index, node_index, node_hierarchy.level + 1 );
+    // Populate scene graph
+    const u32 node_offset = scene_graph->node_count();
+    const u32 node_count = baked_scene.nodes.size;
+    scene_graph->resize( node_offset + node_count );
+    scene_graph->init_new_nodes( node_offset, node_count );
 
-                nodes_to_visit.push( children_index );
-            }
-        }
+    for ( u32 n = 0; n < node_count; ++n ) {
+        BakedNode& baked_node = baked_scene.nodes[ n ];
+        const u32 node_index = node_offset + n;
 
-        // Cache node name
-        scene_graph->set_debug_data( node_index, node.name.data );
+        scene_graph->set_local_matrix( node_index, baked_node.local_matrix );
 
-        if ( node.mesh == glTF::INVALID_INT_VALUE ) {
-            continue;
+        if ( baked_node.parent >= 0 ) {
+            scene_graph->set_hierarchy( node_index, node_offset + baked_node.parent, baked_node.level );
         }
 
-        // Start mesh part
-        glTF::Mesh& gltf_mesh = gltf_scene.meshes[ node.mesh ];
-        u32 gltf_mesh_offset = gltf_mesh_to_mesh_offset[ node.mesh ];
-
-        // Gltf primitives are conceptually submeshes.
-        for ( u32 primitive_index = 0; primitive_index < gltf_mesh.primitives_count; ++primitive_index ) {
-            MeshInstance mesh_instance{ };
-            // Assign scene graph node index
-            mesh_instance.scene_graph_node_index = node_index;
+        // Cache node name
+        scene_graph->set_debug_data( node_index, baked_node.name.c_str() );
+    }
 
-            glTF::MeshPrimitive& mesh_primitive = gltf_mesh.primitives[ primitive_index ];
+    // Add mesh instances
+    const u32 mesh_instances_offset = mesh_instances.size;
+    u32 total_meshlets = 0;
 
-            // Cache parent mesh and assign material
-            u32 mesh_primitive_index = gltf_mesh_offset + primitive_index;
-            mesh_instance.mesh = &meshes[ mesh_primitive_index ];
-            mesh_instance.mesh->pbr_material.material = pbr_material;
-            // Cache gpu mesh instance index, used to retrieve data on gpu.
-            mesh_instance.gpu_mesh_instance_index = mesh_instances.size;
+    for ( u32 i = 0; i < baked_scene.mesh_instances.size; ++i ) {
+        BakedMeshInstance& baked_mesh_instance = baked_scene.mesh_instances[ i ];
 
-            // Found a skin index, cache it
-            mesh_instance.mesh->skin_index = i32_max;
-            if ( node.skin != glTF::INVALID_INT_VALUE ) {
-                RASSERT( node.skin < skins.size );
+        MeshInstance mesh_instance{ };
+        // Assign scene graph node index
+        mesh_instance.scene_graph_node_index = node_offset + baked_mesh_instance.node_index;
 
-                mesh_instance.mesh->skin_index = node.skin;
-            }
+        // Cache parent mesh and assign material
+        mesh_instance.mesh = &meshes[ mesh_offset + baked_mesh_instance.mesh_index ];
+        mesh_instance.mesh->pbr_material.material = pbr_material;
+        // Cache gpu mesh instance index, used to retrieve data on gpu.
+        mesh_instance.gpu_mesh_instance_index = mesh_instances.size;
 
-            total_meshlets += mesh_instance.mesh->meshlet_count;
+        total_meshlets += mesh_instance.mesh->meshlet_count;
 
-            mesh_instances.push( mesh_instance );
-        }
+        mesh_instances.push( mesh_instance );
     }
 
     rprint( "Total meshlet instances %u\n", total_meshlets );
@@ -802,150 +382,104 @@ void glTFScene::add_mesh( cstring filename, cstring path, StackAllocator* temp_a
     Buffer* gpu_geometry_transform_buffer = renderer->gpu->access_buffer( geometry_transform_buffer );
     memcpy( gpu_geometry_transform_buffer->mapped_data, geometry_transform.data, geometry_transform_buffer_size );
 
-    i64 end_building_meshlets = time_now();
+    // Load animations
+    AnimationCompressionParameters animation_compression_parameters;
+    AnimationCompressionStats animation_compression_stats;
 
-    // Before unloading buffer data, load animations
-    for ( u32 animation_index = 0; animation_index < gltf_scene.animations_count; ++animation_index ) {
-        glTF::Animation& gltf_animation = gltf_scene.animations[ animation_index ];
+    const u32 animation_offset = animations.size;
+    const Animation* previous_animations = animations.data;
+    for ( u32 animation_index = 0; animation_index < baked_scene.animations.size; ++animation_index ) {
+        BakedAnimation& baked_animation = baked_scene.animations[ animation_index ];
 
         Animation& animation = animations.push_use();
-        animation.time_start = FLT_MAX;
-        animation.time_end = -FLT_MAX;
-        animation.channels.init( resident_allocator, gltf_animation.channels_count, gltf_animation.channels_count );
-        for ( u32 channel_index = 0; channel_index < gltf_animation.channels_count; ++channel_index ) {
+        animation.time_start = baked_animation.time_start;
+        animation.time_end = baked_animation.time_end;
 
-            glTF::AnimationChannel& gltf_channel = gltf_animation.channels[ channel_index ];
+        animation.channels.init( resident_allocator, baked_animation.channels.size, baked_animation.channels.size );
+        for ( u32 channel_index = 0; channel_index < baked_animation.channels.size; ++channel_index ) {
             AnimationChannel& channel = animation.channels[ channel_index ];
 
-            channel.sampler = gltf_channel.sampler;
-            channel.target_node = gltf_channel.target_node;
-            channel.target_type = (raptor::AnimationChannel::TargetType)gltf_channel.target_type;
+            channel = baked_animation.channels[ channel_index ];
+            channel.target_node += node_offset;
         }
 
-        animation.samplers.init( resident_allocator, gltf_animation.samplers_count, gltf_animation.samplers_count );
-        for ( u32 sampler_index = 0; sampler_index < gltf_animation.samplers_count; ++sampler_index ) {
-
-            glTF::AnimationSampler& gltf_sampler = gltf_animation.samplers[ sampler_index ];
+        animation.samplers.init( resident_allocator, baked_animation.samplers.size, baked_animation.samplers.size );
+        for ( u32 sampler_index = 0; sampler_index < baked_animation.samplers.size; ++sampler_index ) {
+            BakedAnimationSampler& baked_sampler = baked_animation.samplers[ sampler_index ];
             AnimationSampler& sampler = animation.samplers[ sampler_index ];
 
-            sampler.interpolation_type = ( raptor::AnimationSampler::Interpolation )gltf_sampler.interpolation;
+            sampler.interpolation_type = ( raptor::AnimationSampler::Interpolation )baked_sampler.interpolation_type;
+            sampler.compressed = { };
 
-            i32 key_frames_count = 0;
+            const u32 key_frames_count = baked_sampler.key_frames.size;
+            sampler.key_frames.init( resident_allocator, key_frames_count, key_frames_count );
+            memory_copy( sampler.key_frames.data, baked_sampler.key_frames.get(), sizeof( f32 ) * key_frames_count );
 
-            // Copy keyframe data
-            {
-                glTF::Accessor& buffer_accessor = gltf_scene.accessors[ gltf_sampler.input_keyframe_buffer_index ];
-                glTF::BufferView& buffer_view = gltf_scene.buffer_views[ buffer_accessor.buffer_view ];
-
-                i32 byte_offset = glTF::get_data_offset( buffer_accessor.byte_offset, buffer_view.byte_offset );
-
-                u8* buffer_data = ( u8* )buffers_data[ buffer_view.buffer ] + byte_offset;
-                sampler.key_frames.init( resident_allocator, buffer_accessor.count, buffer_accessor.count );
+            // Cubic splines have three values per key frame.
+            const u32 data_count = baked_sampler.data.size;
+            sampler.data = ( vec4s* )rallocaa( sizeof( vec4s ) * data_count, resident_allocator, 16 );
+            memory_copy( sampler.data, baked_sampler.data.get(), sizeof( vec4s ) * data_count );
+        }
 
-                const f32* key_frames = ( const f32* )buffer_data;
-                for ( u32 i = 0; i < buffer_accessor.count; ++i ) {
-                    sampler.key_frames[ i ] = key_frames[ i ];
+        if ( compress_animations ) {
+            animation_compress( animation, animation_compression_parameters, resident_allocator, &animation_compression_stats );
+        }
+    }
 
-                    animation.time_start = glm_min( animation.time_start, key_frames[ i ] );
-                    animation.time_end = glm_max( animation.time_end, key_frames[ i ] );
-                }
+    if ( compress_animations && animation_compression_stats.sampler_count > 0 ) {
+        const AnimationCompressionStats& stats = animation_compression_stats;
+        rprint( "Compressed %u animation samplers, %u key frames to %u, %.1f KB to %.1f KB, max errors translation %g, rotation %.4f deg, scale %g\n",
+                stats.sampler_count, stats.source_key_frames, stats.compressed_key_frames, stats.source_bytes / 1024.0, stats.compressed_bytes / 1024.0,
+                stats.max_translation_error, stats.max_rotation_error, stats.max_scale_error );
+    }
 
-                key_frames_count = buffer_accessor.count;
+    // Instances of previous scenes point into the animations array, that could have moved.
+    if ( previous_animations != nullptr && animations.data != previous_animations ) {
+        for ( u32 i = 0; i < animation_instances.size; ++i ) {
+            AnimationInstance& instance = animation_instances[ i ];
+            if ( instance.animation ) {
+                instance.animation = animations.data + ( instance.animation - previous_animations );
             }
-            // Copy animation data
-            {
-                glTF::Accessor& buffer_accessor = gltf_scene.accessors[ gltf_sampler.output_keyframe_buffer_index ];
-                glTF::BufferView& buffer_view = gltf_scene.buffer_views[ buffer_accessor.buffer_view ];
-
-                i32 byte_offset = glTF::get_data_offset( buffer_accessor.byte_offset, buffer_view.byte_offset );
-
-                RASSERT( buffer_accessor.count == key_frames_count );
-
-                u8* buffer_data = ( u8* )buffers_data[ buffer_view.buffer ] + byte_offset;
-
-                sampler.data = (vec4s*)rallocaa( sizeof(vec4s) * buffer_accessor.count, resident_allocator, 16 );
-
-                switch ( buffer_accessor.type ) {
-                    case glTF::Accessor::Vec3:
-                    {
-                        const vec3s* animation_data = ( const vec3s* )buffer_data;
-                        for ( u32 i = 0; i < buffer_accessor.count; ++i ) {
-                            sampler.data[ i ] = glms_vec4( animation_data[ i ], 0.f );
-                        }
-                        break;
-                    }
-                    case glTF::Accessor::Vec4:
-                    {
-                        const f32* animation_data = ( const f32* )buffer_data;
-                        for ( u32 i = 0; i < buffer_accessor.count; ++i ) {
-                            sampler.data[ i ] = vec4s{ animation_data[ i * 4 ], animation_data[ i * 4 + 1 ], animation_data[ i * 4 + 2 ], animation_data[ i * 4 + 3 ] };
-                        }
-                        break;
-                    }
-                    default:
-                    {
-                        RASSERT( false );
-                        break;
-                    }
-                }
-
+            if ( instance.previous_animation ) {
+                instance.previous_animation = animations.data + ( instance.previous_animation - previous_animations );
             }
         }
+    }
 
-        //rprint( "Done loading animation %f %f\n", animation.time_start, animation.time_end );
+    // Play the first animation of the scene on its nodes.
+    if ( baked_scene.animations.size > 0 ) {
+        AnimationInstance& instance = animation_instances.push_use();
+        instance.init( resident_allocator, scene_graph, node_offset, node_count );
+        instance.play( &animations[ animation_offset ] );
     }
 
     // Load skins
-    for ( u32 si = 0; si < gltf_scene.skins_count; ++si ) {
-        glTF::Skin& gltf_skin = gltf_scene.skins[ si ];
+    for ( u32 si = 0; si < baked_scene.skins.size; ++si ) {
+        BakedSkin& baked_skin = baked_scene.skins[ si ];
 
         Skin& skin = skins.push_use();
-        skin.skeleton_root_index = gltf_skin.skeleton_root_node_index;
+        skin.skeleton_root_index = baked_skin.skeleton_root_index != ( u32 )glTF::INVALID_INT_VALUE ? baked_skin.skeleton_root_index + node_offset : baked_skin.skeleton_root_index;
 
         // Copy joints
-        skin.joints.init( resident_allocator, gltf_skin.joints_count, gltf_skin.joints_count );
-        memory_copy( skin.joints.data, gltf_skin.joints, sizeof( i32 ) * gltf_skin.joints_count );
+        const u32 joints_count = baked_skin.joints.size;
+        skin.joints.init( resident_allocator, joints_count, joints_count );
+        for ( u32 j = 0; j < joints_count; ++j ) {
+            skin.joints[ j ] = baked_skin.joints[ j ] + node_offset;
+        }
 
         // Copy inverse bind matrices
-        glTF::Accessor& buffer_accessor = gltf_scene.accessors[ gltf_skin.inverse_bind_matrices_buffer_index ];
-        glTF::BufferView& buffer_view = gltf_scene.buffer_views[ buffer_accessor.buffer_view ];
-
-        i32 byte_offset = glTF::get_data_offset( buffer_accessor.byte_offset, buffer_view.byte_offset );
-
-        RASSERT( buffer_accessor.count == skin.joints.size );
-        skin.inverse_bind_matrices = ( mat4s* )rallocaa( sizeof( mat4s ) * buffer_accessor.count, resident_allocator, 16 );
+        skin.inverse_bind_matrices = ( mat4s* )rallocaa( sizeof( mat4s ) * joints_count, resident_allocator, 16 );
+        memory_copy( skin.inverse_bind_matrices, baked_skin.inverse_bind_matrices.get(), sizeof( mat4s ) * joints_count );
 
-        u8* buffer_data = ( u8* )buffers_data[ buffer_view.buffer ] + byte_offset;
-        memory_copy( skin.inverse_bind_matrices, buffer_data, sizeof( mat4s ) * buffer_accessor.count );
-
-        // Create matrix ssbo.
+        // Create matrix ssbo, written every frame by update_joints.
         // TODO: transforms use absolute indices, thus we need all nodes.
         BufferCreation bc;
-        bc.reset().set( VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, ResourceUsageType::Dynamic, sizeof( mat4s ) * gltf_scene.nodes_count )
-                  .set_data( buffer_data ).set_name( "Skin ssbo" );
+        bc.reset().set( VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, ResourceUsageType::Dynamic, sizeof( mat4s ) * node_count ).set_name( "Skin ssbo" );
 
         skin.joint_transforms = renderer->gpu->create_buffer( bc );
     }
 
-    // Deallocate file-read buffer data
-    for ( u32 buffer_index = 0; buffer_index < gltf_scene.buffers_count; ++buffer_index ) {
-        void* buffer = buffers_data[ buffer_index ];
-        resident_allocator->deallocate( buffer );
-    }
-    buffers_data.shutdown();
-
-    i64 end_creating_buffers = time_now();
-
-    // This is not needed anymore, free all temp memory after.
-    //resource_name_buffer.shutdown();
     temp_allocator->free_marker( temp_allocator_initial_marker );
-
-    i64 end_loading = time_now();
-
-    rprint( "Loaded scene %s in %f seconds.\nStats:\n\tReading GLTF file %f seconds\n\tTextures Creating %f seconds\n\tCreating Samplers %f seconds\n\tReading Buffers Data %f seconds\n\tCreating Buffers %f seconds\n", filename,
-            time_delta_seconds( start_scene_loading, end_loading ), time_delta_seconds( start_scene_loading, end_loading_file ), time_delta_seconds( end_loading_file, end_creating_textures ),
-            time_delta_seconds( end_creating_textures, end_creating_samplers ),
-            time_delta_seconds( end_creating_samplers, end_reading_buffers_data ), time_delta_seconds( end_reading_buffers_data, end_creating_buffers ) );
 }
 
 void glTFScene::shutdown( Renderer* renderer ) {
@@ -959,12 +493,21 @@ void glTFScene::shutdown( Renderer* renderer ) {
         for ( u32 si = 0; si < animation.samplers.size; ++si ) {
             AnimationSampler& sampler = animation.samplers[ si ];
             sampler.key_frames.shutdown();
-            rfree( sampler.data, resident_allocator );
+            // Compressed samplers have freed their source key frames.
+            if ( sampler.data ) {
+                rfree( sampler.data, resident_allocator );
+            }
+            animation_compressed_track_shutdown( sampler.compressed, resident_allocator );
         }
         animation.samplers.shutdown();
     }
     animations.shutdown();
 
+    for ( u32 i = 0; i < animation_instances.size; ++i ) {
+        animation_instances[ i ].shutdown();
+    }
+    animation_instances.shutdown();
+
     // Unload skins
     for ( u32 si = 0; si < skins.size; ++si ) {
         Skin& skin = skins[ si ];
@@ -1063,10 +606,10 @@ void glTFScene::shutdown( Renderer* renderer ) {
 
     // NOTE(marco): we can't destroy this sooner as textures and buffers
     // hold a pointer to the names stored here
-    for ( u32 i = 0; i < gltf_scenes.size; ++i ) {
-        gltf_free( gltf_scenes[ i ] );
+    for ( u32 i = 0; i < baked_scenes.size; ++i ) {
+        baked_scenes[ i ].shutdown();
     }
-    gltf_scenes.shutdown();
+    baked_scenes.shutdown();
 
     debug_renderer.shutdown();
 }
@@ -1214,7 +757,7 @@ void glTFScene::prepare_draws( Renderer* renderer, StackAllocator* scratch_alloc
 
         if ( renderer->gpu->mesh_shaders_extension_present ) {
 
-            u32 meshlet_index = meshlet_technique->get_pass_index( "gbuffer_culling" );
+            u32 meshlet_index = meshlet_technique->get_pass_index( rhashed( "gbuffer_culling" ) );
             GpuTechniquePass& meshlet_pass = meshlet_technique->passes[ meshlet_index ];
             DescriptorSetLayoutHandle layout = meshlet_index != u16_max ? renderer->gpu->get_descriptor_set_layout( meshlet_pass.pipeline, k_material_descriptor_set_index ) : k_invalid_layout;
 
@@ -1243,7 +786,7 @@ void glTFScene::prepare_draws( Renderer* renderer, StackAllocator* scratch_alloc
             }
         }
 
-        u32 meshlet_emulation_index = meshlet_technique->get_pass_index( "emulation_gbuffer_culling" );
+        u32 meshlet_emulation_index = meshlet_technique->get_pass_index( rhashed( "emulation_gbuffer_culling" ) );
         GpuTechniquePass& meshlet_emulation_pass = meshlet_technique->passes[ meshlet_emulation_index ];
         DescriptorSetLayoutHandle meshlet_emulation_layout = renderer->gpu->get_descriptor_set_layout( meshlet_emulation_pass.pipeline, k_material_descriptor_set_index );
 
@@ -1257,7 +800,7 @@ void glTFScene::prepare_draws( Renderer* renderer, StackAllocator* scratch_alloc
             add_meshlet_descriptors( ds_creation, meshlet_emulation_pass );
 
             ds_creation.buffer( mesh_task_indirect_early_commands_sb[ i ], 6 ).buffer( mesh_task_indirect_count_early_sb[ i ], 7 )
-                .buffer( meshlets_instances_sb[ i ], meshlet_emulation_pass.get_binding_index( "MeshletInstances" ) ).set_layout( meshlet_emulation_layout );
+                .buffer( meshlets_instances_sb[ i ], meshlet_emulation_pass.get_binding_index( rhashed( "MeshletInstances" ) ) ).set_layout( meshlet_emulation_layout );
 
             meshlet_emulation_descriptor_set[ i ] = renderer->gpu->create_descriptor_set( ds_creation );
         }
@@ -1355,7 +898,7 @@ void glTFScene::prepare_draws( Renderer* renderer, StackAllocator* scratch_alloc
 
     if ( use_meshlets ) {
         GpuTechnique* transparent_technique = renderer->resource_cache.techniques.get( hash_calculate( "meshlet" ) );
-        u32 meshlet_technique_index = transparent_technique->get_pass_index( "transparent_no_cull" );
+        u32 meshlet_technique_index = transparent_technique->get_pass_index( rhashed( "transparent_no_cull" ) );
         GpuTechniquePass& transparent_pass = transparent_technique->passes[ meshlet_technique_index ];
 
         DescriptorSetLayoutHandle transparent_layout = renderer->gpu->get_descriptor_set_layout( transparent_pass.pipeline, k_material_descriptor_set_index );
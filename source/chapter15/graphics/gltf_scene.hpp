@@ -3,9 +3,13 @@
 #include "graphics/gpu_resources.hpp"
 #include "graphics/render_scene.hpp"
 
+#include "foundation/blob_serialization.hpp"
 #include "foundation/gltf.hpp"
 
 namespace raptor {
+
+    struct BakedScene;
+
     //
     //
     struct glTFScene : public RenderScene {
@@ -16,18 +20,21 @@ namespace raptor {
 
         void                    prepare_draws( Renderer* renderer, StackAllocator* scratch_allocator, SceneGraph* scene_graph ) override;
 
-        void                    get_mesh_vertex_buffer( glTF::glTF& gltf_scene, u32 buffers_offset, i32 accessor_index, u32 flag, BufferHandle& out_buffer_handle, u32& out_buffer_offset, u32& out_flags );
-        u16                     get_material_texture( GpuDevice& gpu, glTF::glTF& gltf_scene, glTF::TextureInfo* texture_info );
-        u16                     get_material_texture( GpuDevice& gpu, glTF::glTF& gltf_scene, i32 gltf_texture_index );
-
-        void                    fill_pbr_material( glTF::glTF& gltf_scene, Renderer& renderer, glTF::Material& material, PBRMaterial& pbr_material );
+        // Create all gpu resources and append meshes, meshlets, nodes, animations and skins.
+        void                    add_baked_scene( BakedScene& baked_scene, cstring path, StackAllocator* temp_allocator, AsynchronousLoader* async_loader );
 
         // All graphics resources used by the scene
         Array<TextureResource>  images;
         Array<SamplerResource>  samplers;
         Array<BufferResource>   buffers;
 
-        Array<glTF::glTF>       gltf_scenes; // Source gltf scene
+        Array<BlobSerializer>   baked_scenes;   // Baked data, mapped or baked from glTF at load.
+
+        bool                    write_baked_scenes = false; // Save glTF scenes baked at load next to the source file.
+        bool                    cook_textures   = false;    // Compress glTF images to dds files while baking, loaded instead of the sources.
+        bool                    use_meshlet_cache = false;  // Read and write the meshlets of each primitive in the meshlet cache while baking.
+        bool                    optimize_meshes = false;    // Reorder primitives for the vertex cache, overdraw and vertex fetch while baking.
+        bool                    compress_animations = false; // Reduce and quantize animation key frames at load, the source ones are freed.
 
     }; // struct GltfScene
 
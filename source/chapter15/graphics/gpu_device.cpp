@@ -273,6 +273,7 @@ void GpuDevice::init( const GpuDeviceCreation& creation ) {
     // 1. Perform common code
     allocator = creation.allocator;
     temporary_allocator = creation.temporary_allocator;
+    frame_arenas = creation.frame_arenas;
 
     string_buffer.init( 1024 * 1024, creation.allocator );
 
@@ -1063,6 +1064,8 @@ void GpuDevice::init( const GpuDeviceCreation& creation ) {
 
     MapBufferParameters cb_map = { dynamic_buffer, 0, 0 };
     dynamic_mapped_memory = ( u8* )map_buffer( cb_map );
+
+    dynamic_ring.init( dynamic_per_frame_size * k_max_frames, "Dynamic buffer" );
 }
 
 void GpuDevice::shutdown() {
@@ -3880,10 +3883,15 @@ void GpuDevice::new_frame() {
 
     // Command pool reset
     command_buffer_ring.reset_pools( current_frame );
-    // Dynamic memory update
-    const u32 used_size = dynamic_allocated_size - ( dynamic_per_frame_size * previous_frame );
-    dynamic_max_per_frame_size = raptor_max( used_size, dynamic_max_per_frame_size );
-    dynamic_allocated_size = dynamic_per_frame_size * current_frame;
+    // Per-thread frame memory reset
+    if ( frame_arenas ) {
+        frame_arenas->new_frame();
+    }
+    // Dynamic memory update, frames up to absolute_frame - k_max_frames are completed after the wait above.
+    if ( absolute_frame >= k_max_frames ) {
+        dynamic_ring.release( absolute_frame - k_max_frames );
+    }
+    dynamic_ring.plot_statistics();
 
     // Descriptor Set Updates
     if ( descriptor_set_updates.size ) {
@@ -4583,6 +4591,8 @@ void GpuDevice::link_texture_sampler( TextureHandle texture, SamplerHandle sampl
 }
 
 void GpuDevice::frame_counters_advance() {
+    dynamic_ring.retire( absolute_frame );
+
     previous_frame = current_frame;
     current_frame = ( current_frame + 1 ) % k_max_frames;
 
@@ -4710,9 +4720,10 @@ void* GpuDevice::map_buffer( const MapBufferParameters& parameters ) {
 
     if ( buffer->parent_buffer.index == dynamic_buffer.index ) {
 
-        buffer->global_offset = dynamic_allocated_size;
+        u8* data = ( u8* )dynamic_allocate( parameters.size == 0 ? buffer->size : parameters.size );
+        buffer->global_offset = ( u32 )( data - dynamic_mapped_memory );
 
-        return dynamic_allocate( parameters.size == 0 ? buffer->size : parameters.size );
+        return data;
     }
 
     void* data;
@@ -4733,9 +4744,34 @@ void GpuDevice::unmap_buffer( const MapBufferParameters& parameters ) {
 }
 
 void* GpuDevice::dynamic_allocate( u32 size ) {
-    void* mapped_memory = dynamic_mapped_memory + dynamic_allocated_size;
-    dynamic_allocated_size += ( u32 )raptor::memory_align( size, ubo_alignment );
-    return mapped_memory;
+    sizet offset = dynamic_ring.allocate( size, ubo_alignment );
+    if ( offset == k_ring_invalid_offset ) {
+        // Stall: wait for the frames in flight to complete and release their memory.
+        if ( timeline_semaphore_extension_present ) {
+            VkSemaphoreWaitInfo semaphore_wait_info{ VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO };
+            semaphore_wait_info.semaphoreCount = 1;
+            semaphore_wait_info.pSemaphores = &vulkan_graphics_semaphore;
+            semaphore_wait_info.pValues = &absolute_frame;
+
+            vkWaitSemaphores( vulkan_device, &semaphore_wait_info, ~0ull );
+        } else {
+            // The current frame fence is reset and not submitted yet.
+            for ( u32 i = 0; i < k_max_frames; ++i ) {
+                if ( i != current_frame ) {
+                    vkWaitForFences( vulkan_device, 1, &vulkan_command_buffer_executed_fence[ i ], VK_TRUE, UINT64_MAX );
+                }
+            }
+        }
+
+        if ( absolute_frame > 0 ) {
+            dynamic_ring.release( absolute_frame - 1 );
+        }
+
+        offset = dynamic_ring.allocate( size, ubo_alignment );
+        RASSERTM( offset != k_ring_invalid_offset, "Dynamic buffer is too small for the allocations of a single frame, %u bytes requested", size );
+    }
+
+    return dynamic_mapped_memory + offset;
 }
 
 void GpuDevice::set_buffer_global_offset( BufferHandle buffer, u32 offset ) {
@@ -4906,6 +4942,11 @@ GpuDeviceCreation& GpuDeviceCreation::set_linear_allocator( StackAllocator* allo
     return *this;
 }
 
+GpuDeviceCreation& GpuDeviceCreation::set_frame_arenas( FrameThreadArenas* arenas ) {
+    frame_arenas = arenas;
+    return *this;
+}
+
 GpuDeviceCreation& GpuDeviceCreation::set_num_threads( u32 value ) {
     num_threads = value;
     return *this;
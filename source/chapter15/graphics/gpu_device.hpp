@@ -21,6 +21,7 @@
 VK_DEFINE_HANDLE( VmaAllocator )
 
 #include "graphics/gpu_resources.hpp"
+#include "graphics/gpu_ring_allocator.hpp"
 
 #include "foundation/data_structures.hpp"
 #include "foundation/string.hpp"
@@ -96,6 +97,7 @@ struct GpuDeviceCreation {
 
     Allocator*                      allocator       = nullptr;
     StackAllocator*                 temporary_allocator = nullptr;
+    FrameThreadArenas*              frame_arenas    = nullptr; // Optional, cleared at every new_frame.
     void*                           window          = nullptr; // Pointer to API-specific window: SDL_Window, GLFWWindow
     u16                             width           = 1;
     u16                             height          = 1;
@@ -110,6 +112,7 @@ struct GpuDeviceCreation {
     GpuDeviceCreation&              set_window( u32 width, u32 height, void* handle );
     GpuDeviceCreation&              set_allocator( Allocator* allocator );
     GpuDeviceCreation&              set_linear_allocator( StackAllocator* allocator );
+    GpuDeviceCreation&              set_frame_arenas( FrameThreadArenas* arenas );
     GpuDeviceCreation&              set_num_threads( u32 value );
 
 }; // struct GpuDeviceCreation
@@ -281,12 +284,13 @@ struct GpuDevice : public Service {
 
     Allocator*                      allocator;
     StackAllocator*                 temporary_allocator;
+    FrameThreadArenas*              frame_arenas;
 
-    u32                             dynamic_max_per_frame_size;
     BufferHandle                    dynamic_buffer;
     u8*                             dynamic_mapped_memory;
-    u32                             dynamic_allocated_size;
     u32                             dynamic_per_frame_size;
+    // Allocations are retired with the absolute frame and released when the frame is completed.
+    GpuRingAllocator                dynamic_ring;
 
     CommandBuffer**                 queued_command_buffers              = nullptr;
     u32                             num_allocated_command_buffers       = 0;
@@ -67,6 +67,8 @@ void GpuVisualProfiler::update( GpuDevice& gpu ) {
     // Collect pipeline statistics
     pipeline_statistics = &gpu.gpu_time_queries_manager->frame_pipeline_statistics;
 
+    dynamic_ring_statistics = gpu.dynamic_ring.statistics;
+
     s_framebuffer_pixel_count = gpu.swapchain_width * gpu.swapchain_height;
 
     // Get colors
@@ -291,6 +293,13 @@ void GpuVisualProfiler::imgui_draw() {
     }
 
     ImGui::Combo( "Stat Units", &stat_unit_index, stat_unit_names, IM_ARRAYSIZE( stat_unit_names ) );
+
+    ImGui::Separator();
+    const GpuRingStatistics& ring = dynamic_ring_statistics;
+    const f32 k_mega = 1024.f * 1024.f;
+    ImGui::Text( "Dynamic buffer: used %0.2fM / %0.2fM (%3.1f%%), peak %0.2fM", ring.used / k_mega, ring.size / k_mega,
+                 ring.size ? ring.used * 100.f / ring.size : 0.f, ring.peak_used / k_mega );
+    ImGui::Text( "Dynamic buffer: %llu allocations, %llu stalls, %llu wraps", ring.allocations, ring.stalls, ring.wraps );
 }
 
 
@@ -104,6 +104,7 @@ struct GpuVisualProfiler {
     GPUTimeQuery*               timestamps;     // Per frame timestamps collected from the profiler.
     u16*                        per_frame_active;
     GpuPipelineStatistics*      pipeline_statistics;    // Per frame collected pipeline statistics.
+    GpuRingStatistics           dynamic_ring_statistics;
 
     u32                         max_frames;
     u32                         max_queries_per_frame;
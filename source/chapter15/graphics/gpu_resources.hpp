@@ -594,6 +594,14 @@ namespace TextureFormat {
         return value >= VK_FORMAT_D16_UNORM && value <= VK_FORMAT_D32_SFLOAT_S8_UINT;
     }
 
+    inline bool                     is_block_compressed( VkFormat value ) {
+        return value >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && value <= VK_FORMAT_BC7_SRGB_BLOCK;
+    }
+    // Size in bytes of a 4x4 block, for the block compressed formats.
+    inline u32                      block_size( VkFormat value ) {
+        return ( value <= VK_FORMAT_BC1_RGBA_SRGB_BLOCK || value == VK_FORMAT_BC4_UNORM_BLOCK || value == VK_FORMAT_BC4_SNORM_BLOCK ) ? 8 : 16;
+    }
+
 } // namespace TextureFormat
 
 
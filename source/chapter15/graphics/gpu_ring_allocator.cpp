@@ -0,0 +1,216 @@
+#include "graphics/gpu_ring_allocator.hpp"
+
+#include "foundation/log.hpp"
+#include "foundation/memory.hpp"
+
+#include "external/tracy/tracy/Tracy.hpp"
+
+#include <stdio.h>
+
+namespace raptor {
+
+// GpuRingOffsets /////////////////////////////////////////////////////////
+
+void GpuRingOffsets::init( sizet size_ ) {
+    size = size_;
+    reset();
+}
+
+void GpuRingOffsets::reset() {
+    head = tail = retired_end = 0;
+    retired_head = retired_count = 0;
+}
+
+sizet GpuRingOffsets::allocate( sizet allocation_size, sizet alignment, bool& wrapped ) {
+    wrapped = false;
+    if ( allocation_size > size ) {
+        return k_ring_invalid_offset;
+    }
+
+    // Nothing in flight: restart from the beginning, so that big allocations are not split by the wrap.
+    if ( head == tail ) {
+        head = tail = retired_end = 0;
+    }
+
+    u64 offset = memory_align( head, alignment );
+    const sizet ring_offset = offset % size;
+    if ( ring_offset + allocation_size > size ) {
+        offset += size - ring_offset;
+        wrapped = true;
+    }
+
+    if ( offset + allocation_size - tail > size ) {
+        wrapped = false;
+        return k_ring_invalid_offset;
+    }
+
+    head = offset + allocation_size;
+
+    return offset % size;
+}
+
+void GpuRingOffsets::retire( u64 value ) {
+    if ( head == retired_end ) {
+        return;
+    }
+
+    if ( retired_count == k_max_retired_ranges ) {
+        // Values grow monotonically, merging with the last range only delays the release.
+        RetiredRange& last = retired_ranges[ ( retired_head + retired_count - 1 ) % k_max_retired_ranges ];
+        last.value = value;
+        last.end = head;
+    }
+    else {
+        RetiredRange& range = retired_ranges[ ( retired_head + retired_count ) % k_max_retired_ranges ];
+        range.value = value;
+        range.end = head;
+        ++retired_count;
+    }
+
+    retired_end = head;
+}
+
+void GpuRingOffsets::release( u64 completed_value ) {
+    while ( retired_count && retired_ranges[ retired_head ].value <= completed_value ) {
+        tail = retired_ranges[ retired_head ].end;
+
+        retired_head = ( retired_head + 1 ) % k_max_retired_ranges;
+        --retired_count;
+    }
+}
+
+bool GpuRingOffsets::is_empty() const {
+    return head == tail;
+}
+
+sizet GpuRingOffsets::used() const {
+    return head - tail;
+}
+
+// GpuRingAllocator ///////////////////////////////////////////////////////
+
+void GpuRingAllocator::init( sizet size, cstring name ) {
+    offsets.init( size );
+
+    snprintf( used_plot_name, sizeof( used_plot_name ), "%s used bytes", name );
+    snprintf( stalls_plot_name, sizeof( stalls_plot_name ), "%s stalls", name );
+
+    reset();
+}
+
+void GpuRingAllocator::reset() {
+    offsets.reset();
+
+    statistics = GpuRingStatistics();
+    statistics.size = offsets.size;
+}
+
+sizet GpuRingAllocator::allocate( sizet allocation_size, sizet alignment ) {
+    bool wrapped = false;
+    const sizet offset = offsets.allocate( allocation_size, alignment, wrapped );
+    if ( offset == k_ring_invalid_offset ) {
+        ++statistics.stalls;
+        return k_ring_invalid_offset;
+    }
+
+    ++statistics.allocations;
+    statistics.allocated_bytes += allocation_size;
+    statistics.wraps += wrapped ? 1 : 0;
+    statistics.used = used();
+    statistics.peak_used = statistics.used > statistics.peak_used ? statistics.used : statistics.peak_used;
+
+    return offset;
+}
+
+void GpuRingAllocator::retire( u64 value ) {
+    offsets.retire( value );
+}
+
+void GpuRingAllocator::release( u64 completed_value ) {
+    offsets.release( completed_value );
+
+    statistics.used = used();
+}
+
+bool GpuRingAllocator::is_empty() const {
+    return offsets.is_empty();
+}
+
+sizet GpuRingAllocator::used() const {
+    return offsets.used();
+}
+
+f32 GpuRingAllocator::occupancy() const {
+    return offsets.size ? ( f32 )used() / offsets.size : 0.f;
+}
+
+void GpuRingAllocator::plot_statistics() {
+    TracyPlot( used_plot_name, ( i64 )used() );
+    TracyPlot( stalls_plot_name, ( i64 )statistics.stalls );
+}
+
+// Check //////////////////////////////////////////////////////////////////
+
+static void gpu_ring_check( bool condition, cstring name, u32& failed_cases ) {
+    if ( !condition ) {
+        rprint( "GpuRingAllocator check failed: %s\n", name );
+        ++failed_cases;
+    }
+}
+
+bool gpu_ring_allocator_check() {
+    u32 failed_cases = 0;
+    bool wrapped = false;
+
+    GpuRingOffsets ring;
+    ring.init( 1024 );
+
+    // Alignment
+    gpu_ring_check( ring.allocate( 1, 1, wrapped ) == 0, "first allocation at the start", failed_cases );
+    gpu_ring_check( ring.allocate( 100, 256, wrapped ) == 256, "aligned allocation", failed_cases );
+    ring.retire( 1 );
+    ring.release( 1 );
+    gpu_ring_check( ring.is_empty(), "empty after release", failed_cases );
+
+    // Wrap-around: the third allocation does not fit before the end and restarts from 0.
+    gpu_ring_check( ring.allocate( 400, 1, wrapped ) == 0, "restart from 0 when empty", failed_cases );
+    ring.retire( 2 );
+    gpu_ring_check( ring.allocate( 400, 1, wrapped ) == 400 && !wrapped, "contiguous allocation", failed_cases );
+    ring.retire( 3 );
+    ring.release( 2 );
+    gpu_ring_check( ring.allocate( 400, 1, wrapped ) == 0 && wrapped, "wrap around the end", failed_cases );
+    ring.retire( 4 );
+    gpu_ring_check( ring.used() == ring.size, "skipped end counts as used", failed_cases );
+
+    // Full ring
+    gpu_ring_check( ring.allocate( 1, 1, wrapped ) == k_ring_invalid_offset, "full ring", failed_cases );
+    gpu_ring_check( ring.allocate( 2048, 1, wrapped ) == k_ring_invalid_offset, "bigger than the ring", failed_cases );
+
+    // Release order: ranges are released oldest first and only once their value completed.
+    ring.release( 1 );
+    gpu_ring_check( ring.used() == ring.size, "old value releases nothing", failed_cases );
+    ring.release( 3 );
+    gpu_ring_check( ring.used() == 624, "release up to value", failed_cases );
+    gpu_ring_check( ring.allocate( 100, 1, wrapped ) == 400, "allocate after partial release", failed_cases );
+    ring.retire( 5 );
+    ring.release( 4 );
+    gpu_ring_check( ring.used() == 100, "release in retire order", failed_cases );
+    ring.release( 5 );
+    gpu_ring_check( ring.is_empty(), "empty after last release", failed_cases );
+
+    // More retires than ranges: the newest ones are merged and released with the last value.
+    const u32 k_retires = GpuRingOffsets::k_max_retired_ranges + 8;
+    for ( u32 i = 0; i < k_retires; ++i ) {
+        ring.allocate( 1, 1, wrapped );
+        ring.retire( 10 + i );
+    }
+    ring.release( 10 + GpuRingOffsets::k_max_retired_ranges - 2 );
+    gpu_ring_check( !ring.is_empty(), "merged ranges wait for the last value", failed_cases );
+    ring.release( 10 + k_retires - 1 );
+    gpu_ring_check( ring.is_empty(), "merged ranges released", failed_cases );
+
+    rprint( "GpuRingAllocator check: %s, %u failed cases\n", failed_cases ? "FAILED" : "passed", failed_cases );
+    return failed_cases == 0;
+}
+
+} // namespace raptor
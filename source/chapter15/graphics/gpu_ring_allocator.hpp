@@ -0,0 +1,96 @@
+#pragma once
+
+#include "foundation/platform.hpp"
+
+namespace raptor {
+
+static const sizet                  k_ring_invalid_offset = ( sizet )-1;
+
+//
+//
+struct GpuRingStatistics {
+
+    u64                             allocations         = 0;
+    u64                             allocated_bytes     = 0;
+    u64                             stalls              = 0;    // Allocations that did not fit until older memory was released.
+    u64                             wraps               = 0;
+
+    sizet                           used                = 0;
+    sizet                           peak_used           = 0;
+    sizet                           size                = 0;
+}; // struct GpuRingStatistics
+
+//
+// Offsets, wrap and retire bookkeeping of a ring, values must be retired in increasing order.
+// Allocations are retired with a value, like the frame index or a timeline semaphore value,
+// and released once the gpu has completed that value. Only offsets are handled, so it does not need a device.
+struct GpuRingOffsets {
+
+    void                            init( sizet size );
+    void                            reset();
+
+    // Returns the offset in the ring, k_ring_invalid_offset if it does not fit until something is released.
+    // Allocations are contiguous and never wrap around the end of the ring, wrapped is set when the end was skipped.
+    sizet                           allocate( sizet size, sizet alignment, bool& wrapped );
+
+    // All the allocations since the previous retire are released with value.
+    void                            retire( u64 value );
+    // Release the retired allocations with value less or equal than completed_value.
+    void                            release( u64 completed_value );
+
+    bool                            is_empty() const;
+    sizet                           used() const;
+
+    //
+    //
+    struct RetiredRange {
+        u64                         value;
+        u64                         end;
+    }; // struct RetiredRange
+
+    static const u32                k_max_retired_ranges = 64;
+
+    // Positions grow monotonically, the offset in the ring is position % size.
+    u64                             head                = 0;
+    u64                             tail                = 0;
+    u64                             retired_end         = 0;
+
+    RetiredRange                    retired_ranges[ k_max_retired_ranges ];
+    u32                             retired_head        = 0;
+    u32                             retired_count       = 0;
+
+    sizet                           size                = 0;
+
+}; // struct GpuRingOffsets
+
+//
+// Ring of gpu memory, like the staging or the dynamic buffer: GpuRingOffsets plus statistics and profiler plots.
+struct GpuRingAllocator {
+
+    void                            init( sizet size, cstring name );
+    void                            reset();
+
+    sizet                           allocate( sizet size, sizet alignment );
+
+    void                            retire( u64 value );
+    void                            release( u64 completed_value );
+
+    bool                            is_empty() const;
+    sizet                           used() const;
+    f32                             occupancy() const;
+
+    // Send used bytes and stalls to the profiler.
+    void                            plot_statistics();
+
+    GpuRingOffsets                  offsets;
+    GpuRingStatistics               statistics;
+
+    char                            used_plot_name[ 64 ];
+    char                            stalls_plot_name[ 64 ];
+
+}; // struct GpuRingAllocator
+
+// Wrap-around, full ring and release order cases of GpuRingOffsets, results go to rprint.
+bool                                gpu_ring_allocator_check();
+
+} // namespace raptor
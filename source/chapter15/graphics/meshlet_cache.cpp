@@ -0,0 +1,105 @@
+#include "graphics/meshlet_cache.hpp"
+
+#include "foundation/blob_serialization.hpp"
+#include "foundation/hash_map.hpp"
+#include "foundation/time.hpp"
+
+#include "external/tracy/tracy/Tracy.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace raptor {
+
+// Arrays of a mapped entry must end inside the file, in case it was truncated.
+template<typename T>
+static bool meshlet_cache_array_valid( const RelativeArray<T>& array, const MappedFile& file ) {
+    const char* begin = ( const char* )array.get();
+    return array.size == 0 || ( begin >= file.data && begin + sizeof( T ) * array.size <= file.data + file.size );
+}
+
+static void meshlet_cache_entry_path( cstring directory, u64 key, char* out_path ) {
+    snprintf( out_path, k_max_path, "%s/%016llx.%s", directory, ( unsigned long long )key, k_meshlet_cache_extension );
+}
+
+void MeshletCache::init( cstring directory_ ) {
+    strncpy( directory, directory_, k_max_path - 1 );
+    directory[ k_max_path - 1 ] = 0;
+
+    stats = MeshletCacheStats{ };
+
+    writable = directory_exists( directory ) || directory_create( directory );
+    if ( !writable ) {
+        rprint( "Meshlet cache: cannot create directory %s, entries will not be saved.\n", directory );
+    }
+}
+
+u64 MeshletCache::key_begin( const MeshletBuildParameters& parameters ) const {
+    // Bumping the version invalidates every entry, as the output of the builder changed.
+    return hash_calculate( parameters, k_meshlet_cache_version );
+}
+
+u64 MeshletCache::key_add( u64 key, const void* data, sizet size ) const {
+    // Size first, so that a missing stream and streams split differently give different keys.
+    key = hash_calculate( data ? size : 0, key );
+    return data ? hash_bytes( ( void* )data, size, key ) : key;
+}
+
+MeshletCacheEntry* MeshletCache::read( u64 key, BlobSerializer& blob, Allocator* allocator ) {
+    ZoneScoped;
+
+    i64 start_read = time_now();
+
+    char path[ k_max_path ];
+    meshlet_cache_entry_path( directory, key, path );
+
+    // Same as baked scenes, there is no serialization code: a different version is a miss and gets overwritten.
+    MeshletCacheEntry* entry = file_exists( path ) ? blob.read_mapped<MeshletCacheEntry>( allocator, k_meshlet_cache_version, path, FileMapFlags_None, true ) : nullptr;
+    if ( entry ) {
+        const MappedFile& file = blob.mapped_file;
+        if ( !meshlet_cache_array_valid( entry->meshlets, file ) || !meshlet_cache_array_valid( entry->vertex_positions, file ) ||
+             !meshlet_cache_array_valid( entry->vertex_data, file ) || !meshlet_cache_array_valid( entry->meshlets_data, file ) ) {
+            file_unmap( &blob.mapped_file );
+            entry = nullptr;
+        }
+    }
+
+    std::lock_guard<std::mutex> guard( stats_mutex );
+
+    if ( entry == nullptr ) {
+        ++stats.misses;
+        return nullptr;
+    }
+
+    const f64 read_seconds = time_from_seconds( start_read );
+    ++stats.hits;
+    stats.read_seconds += read_seconds;
+    stats.saved_seconds += entry->build_seconds - read_seconds;
+
+    return entry;
+}
+
+void MeshletCache::write( u64 key, BlobSerializer& blob ) {
+    ZoneScoped;
+
+    if ( !writable ) {
+        return;
+    }
+
+    char path[ k_max_path ];
+    meshlet_cache_entry_path( directory, key, path );
+
+    blob.write_file( path );
+
+    std::lock_guard<std::mutex> guard( stats_mutex );
+    ++stats.writes;
+}
+
+void MeshletCache::print_stats() {
+    const u32 lookups = stats.hits + stats.misses;
+
+    rprint( "\tMeshlet cache %u/%u hits (%.1f%%), %u entries written, %f seconds reading, %f seconds saved\n", stats.hits, lookups,
+            lookups ? stats.hits * 100.0 / lookups : 0.0, stats.writes, stats.read_seconds, stats.saved_seconds );
+}
+
+} // namespace raptor
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "foundation/blob.hpp"
+#include "foundation/file.hpp"
+#include "foundation/relative_data_structures.hpp"
+
+#include "graphics/render_scene.hpp"
+
+#include <mutex>
+
+namespace raptor {
+
+    struct BlobSerializer;
+
+    static const u32        k_meshlet_cache_version     = 2;
+    static const cstring    k_meshlet_cache_extension   = "rmeshlets";
+    static const cstring    k_meshlet_cache_directory   = "meshlet_cache";
+
+    // Meshlet cache //////////////////////////////////////////////////////
+    //
+    // Content addressed cache of built meshlets: each primitive is stored in its own file,
+    // named after the hash of its source accessors and of the meshlet build parameters.
+    // Changing the source data or the parameters changes the name, so entries are never stale.
+
+    //
+    // Meshlets of a single primitive. Offsets are local to the primitive: meshlet data offsets
+    // start at 0 and the vertex indices in meshlets_data point into vertex_positions.
+    // Levels of detail follow each other in meshlets, without padding, and share the vertices.
+    struct MeshletCacheEntry : public Blob {
+
+        RelativeArray<GpuMeshlet>   meshlets;
+        RelativeArray<GpuMeshletVertexPosition> vertex_positions;
+        RelativeArray<GpuMeshletVertexData> vertex_data;
+        RelativeArray<u32>          meshlets_data;
+
+        GpuMeshLod                  lods[ k_max_mesh_lods ];    // Indices drawn count padding triangles.
+        u32                         lod_count;
+        u32                         index_group_count;      // Packed index groups of the largest level, padding excluded.
+        f32                         build_seconds;          // Time spent building the entry, saved on each hit.
+
+        vec3s                       aabb[ 2 ];              // 0 min, 1 max
+
+    }; // struct MeshletCacheEntry
+
+    //
+    // Build parameters, part of the key.
+    struct MeshletBuildParameters {
+        u32                         max_vertices;
+        u32                         max_triangles;
+        f32                         cone_weight;
+
+        u32                         lod_count;          // Levels of detail, full detail included.
+        f32                         lod_index_ratio;    // Indices of each level relative to the previous one.
+        f32                         lod_max_error;      // Simplification error relative to the mesh extents.
+    }; // struct MeshletBuildParameters
+
+    //
+    //
+    struct MeshletCacheStats {
+        u32                         hits            = 0;
+        u32                         misses          = 0;
+        u32                         writes          = 0;
+
+        f64                         read_seconds    = 0.0;  // Mapping the hit entries.
+        f64                         saved_seconds   = 0.0;  // Build time of the hit entries minus read_seconds.
+    }; // struct MeshletCacheStats
+
+    //
+    // Keys, reads and writes can run on multiple threads, as long as each key is written by a single one.
+    struct MeshletCache {
+
+        // Entries are read and written in directory, created if missing.
+        void                        init( cstring directory );
+
+        // Start a key from the build parameters and add every source stream, nullptr for a missing one.
+        u64                         key_begin( const MeshletBuildParameters& parameters ) const;
+        u64                         key_add( u64 key, const void* data, sizet size ) const;
+
+        // Map the entry for key, nullptr on a miss. The entry points inside the mapping, that lives until blob shutdown.
+        MeshletCacheEntry*          read( u64 key, BlobSerializer& blob, Allocator* allocator );
+        // Save the entry written with blob, skipped if the directory could not be created.
+        void                        write( u64 key, BlobSerializer& blob );
+
+        void                        print_stats();
+
+        MeshletCacheStats           stats;
+        std::mutex                  stats_mutex;
+        char                        directory[ k_max_path ];
+        bool                        writable        = false;
+
+    }; // struct MeshletCache
+
+} // namespace raptor
@@ -0,0 +1,380 @@
+#include "graphics/meshlet_encoding.hpp"
+
+#include "foundation/memory.hpp"
+#include "foundation/numerics.hpp"
+#include "foundation/time.hpp"
+
+#include "external/cglm/struct/vec3.h"
+#include "external/tracy/tracy/Tracy.hpp"
+
+#include <math.h>
+#include <string.h>
+
+namespace raptor {
+
+static const f32 k_meshlet_i8_inverse = 1.0f / 127.0f;
+
+// Source vertices store each axis as ( v + 1 ) * 127, decoded like the mesh shaders.
+static inline f32 meshlet_source_axis( u8 value ) {
+    return f32( value ) * k_meshlet_i8_inverse - 1.0f;
+}
+
+// Byte i of the packed triangle indices that start at index_offset.
+static inline u32 meshlet_source_index( const u32* meshlets_data, u32 index_offset, u32 i ) {
+    return ( meshlets_data[ index_offset + ( i >> 2 ) ] >> ( ( i & 3 ) * 8 ) ) & 0xff;
+}
+
+// Same as decode_oct_8 in shaders/meshlet.h.
+static vec3s meshlet_oct_decode( u32 encoded ) {
+    f32 x = f32( encoded & 0xff ) * ( 2.0f / 255.0f ) - 1.0f;
+    f32 y = f32( ( encoded >> 8 ) & 0xff ) * ( 2.0f / 255.0f ) - 1.0f;
+    const f32 z = 1.0f - fabsf( x ) - fabsf( y );
+    const f32 t = raptor::max( -z, 0.0f );
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+
+    return glms_vec3_normalize( { x, y, z } );
+}
+
+// Octahedral projection quantized to 8 bits per axis. Rounding each axis on its own can pick a neighbour
+// that decodes closer to the direction, so the four candidates around the projection are compared.
+static u32 meshlet_oct_encode( vec3s direction ) {
+    const f32 length = fabsf( direction.x ) + fabsf( direction.y ) + fabsf( direction.z );
+    if ( length == 0.0f ) {
+        direction = { 0.f, 0.f, 1.f };
+    }
+    else {
+        direction = glms_vec3_scale( direction, 1.0f / length );
+    }
+
+    f32 x = direction.x, y = direction.y;
+    if ( direction.z < 0.0f ) {
+        x = ( 1.0f - fabsf( direction.y ) ) * ( direction.x >= 0.0f ? 1.0f : -1.0f );
+        y = ( 1.0f - fabsf( direction.x ) ) * ( direction.y >= 0.0f ? 1.0f : -1.0f );
+    }
+
+    const vec3s normalized = glms_vec3_normalize( direction );
+    const f32 fx = raptor::clamp( x * 0.5f + 0.5f, 0.f, 1.f ) * 255.0f;
+    const f32 fy = raptor::clamp( y * 0.5f + 0.5f, 0.f, 1.f ) * 255.0f;
+
+    u32 best = 0;
+    f32 best_dot = -2.0f;
+    for ( u32 c = 0; c < 4; ++c ) {
+        const u32 ex = raptor::min( ( u32 )( c & 1 ? ceilf( fx ) : floorf( fx ) ), 255u );
+        const u32 ey = raptor::min( ( u32 )( c & 2 ? ceilf( fy ) : floorf( fy ) ), 255u );
+        const u32 encoded = ex | ( ey << 8 );
+        const f32 dot = glms_vec3_dot( meshlet_oct_decode( encoded ), normalized );
+        if ( dot > best_dot ) {
+            best_dot = dot;
+            best = encoded;
+        }
+    }
+
+    return best;
+}
+
+static f32 meshlet_angle_degrees( vec3s a, vec3s b ) {
+    const f32 dot = raptor::clamp( glms_vec3_dot( glms_vec3_normalize( a ), glms_vec3_normalize( b ) ), -1.f, 1.f );
+    return acosf( dot ) * ( 180.0f / rpi );
+}
+
+u32 meshlet_encoded_index_bits( u32 vertex_count ) {
+    u32 bits = 1;
+    while ( ( 1u << bits ) < vertex_count ) {
+        ++bits;
+    }
+    return bits;
+}
+
+u32 meshlet_encoded_size( u32 vertex_count, u32 triangle_count ) {
+    const u32 index_bits = triangle_count * 3 * meshlet_encoded_index_bits( vertex_count );
+    return vertex_count * k_meshlet_encoded_vertex_words + ( index_bits + 31 ) / 32 + 1;
+}
+
+void meshlet_encode( const GpuMeshlet* meshlets, u32 meshlet_count, const GpuMeshletVertexPosition* vertex_positions,
+                     const GpuMeshletVertexData* vertex_data, const u32* meshlets_data,
+                     Array<GpuMeshlet>& encoded_meshlets, Array<u32>& encoded_data ) {
+    ZoneScoped;
+
+    u32 data_count = 0;
+    for ( u32 m = 0; m < meshlet_count; ++m ) {
+        data_count += meshlet_encoded_size( meshlets[ m ].vertex_count, meshlets[ m ].triangle_count );
+    }
+
+    encoded_meshlets.set_size( meshlet_count );
+    encoded_data.set_size( data_count );
+    // Index bits are or'ed in place.
+    memset( encoded_data.data, 0, sizeof( u32 ) * data_count );
+
+    u32 data_offset = 0;
+    for ( u32 m = 0; m < meshlet_count; ++m ) {
+        const GpuMeshlet& meshlet = meshlets[ m ];
+        const u32 vertex_count = meshlet.vertex_count;
+        const u32 index_count = meshlet.triangle_count * 3;
+
+        GpuMeshlet& encoded_meshlet = encoded_meshlets[ m ];
+        encoded_meshlet = meshlet;
+        encoded_meshlet.data_offset = data_offset;
+
+        const f32 scale = meshlet.radius > 0.0f ? k_meshlet_position_scale / meshlet.radius : 0.0f;
+
+        u32* vertex_words = encoded_data.data + data_offset;
+        for ( u32 v = 0; v < vertex_count; ++v ) {
+            const u32 vertex_index = meshlets_data[ meshlet.data_offset + v ];
+            const GpuMeshletVertexPosition& position = vertex_positions[ vertex_index ];
+            const GpuMeshletVertexData& data = vertex_data[ vertex_index ];
+
+            u32 quantized[ 3 ];
+            for ( u32 i = 0; i < 3; ++i ) {
+                const f32 q = roundf( ( position.position[ i ] - meshlet.center.raw[ i ] ) * scale );
+                quantized[ i ] = ( u16 )( i16 )raptor::clamp( q, -k_meshlet_position_scale, k_meshlet_position_scale );
+            }
+
+            const vec3s normal{ meshlet_source_axis( data.normal[ 0 ] ), meshlet_source_axis( data.normal[ 1 ] ), meshlet_source_axis( data.normal[ 2 ] ) };
+            const vec3s tangent{ meshlet_source_axis( data.tangent[ 0 ] ), meshlet_source_axis( data.tangent[ 1 ] ), meshlet_source_axis( data.tangent[ 2 ] ) };
+            const u32 tangent_negative = meshlet_source_axis( data.tangent[ 3 ] ) < 0.0f ? 1 : 0;
+
+            u32* words = vertex_words + v * k_meshlet_encoded_vertex_words;
+            words[ 0 ] = quantized[ 0 ] | ( quantized[ 1 ] << 16 );
+            words[ 1 ] = quantized[ 2 ] | ( meshlet_oct_encode( normal ) << 16 );
+            words[ 2 ] = data.uv_coords[ 0 ] | ( data.uv_coords[ 1 ] << 16 );
+            words[ 3 ] = meshlet_oct_encode( tangent ) | ( tangent_negative << 16 );
+        }
+
+        const u32 source_index_offset = meshlet.data_offset + vertex_count;
+        const u32 index_bits = meshlet_encoded_index_bits( vertex_count );
+        u32* index_words = vertex_words + vertex_count * k_meshlet_encoded_vertex_words;
+        for ( u32 i = 0; i < index_count; ++i ) {
+            const u32 index = meshlet_source_index( meshlets_data, source_index_offset, i );
+            const u32 bit_offset = i * index_bits;
+            const u32 shift = bit_offset & 31;
+
+            index_words[ bit_offset >> 5 ] |= index << shift;
+            if ( shift + index_bits > 32 ) {
+                index_words[ ( bit_offset >> 5 ) + 1 ] |= index >> ( 32 - shift );
+            }
+        }
+
+        data_offset += meshlet_encoded_size( vertex_count, meshlet.triangle_count );
+    }
+}
+
+vec3s meshlet_decode_position( const GpuMeshlet& meshlet, const u32* encoded_data, u32 vertex_index ) {
+    const u32* words = encoded_data + meshlet.data_offset + vertex_index * k_meshlet_encoded_vertex_words;
+    const f32 scale = meshlet.radius / k_meshlet_position_scale;
+
+    return { meshlet.center.x + f32( ( i16 )( words[ 0 ] & 0xffff ) ) * scale,
+             meshlet.center.y + f32( ( i16 )( words[ 0 ] >> 16 ) ) * scale,
+             meshlet.center.z + f32( ( i16 )( words[ 1 ] & 0xffff ) ) * scale };
+}
+
+void meshlet_decode_vertex( const GpuMeshlet& meshlet, const u32* encoded_data, u32 vertex_index, MeshletDecodedVertex& vertex ) {
+    const u32* words = encoded_data + meshlet.data_offset + vertex_index * k_meshlet_encoded_vertex_words;
+
+    vertex.position = meshlet_decode_position( meshlet, encoded_data, vertex_index );
+    vertex.normal = meshlet_oct_decode( words[ 1 ] >> 16 );
+    vertex.uv_coords[ 0 ] = ( u16 )( words[ 2 ] & 0xffff );
+    vertex.uv_coords[ 1 ] = ( u16 )( words[ 2 ] >> 16 );
+    vertex.tangent = meshlet_oct_decode( words[ 3 ] );
+    vertex.tangent_sign = ( words[ 3 ] & 0x10000 ) ? -1.0f : 1.0f;
+}
+
+void meshlet_decode_triangle( const GpuMeshlet& meshlet, const u32* encoded_data, u32 triangle_index, u32 indices[ 3 ] ) {
+    const u32* index_words = encoded_data + meshlet.data_offset + meshlet.vertex_count * k_meshlet_encoded_vertex_words;
+    const u32 index_bits = meshlet_encoded_index_bits( meshlet.vertex_count );
+    const u32 mask = ( 1u << index_bits ) - 1;
+
+    for ( u32 c = 0; c < 3; ++c ) {
+        const u32 bit_offset = ( triangle_index * 3 + c ) * index_bits;
+        const u32 word = bit_offset >> 5;
+        const u32 shift = bit_offset & 31;
+        // Same as decode_meshlet_index in shaders/meshlet.h, the trailing word keeps the second read in bounds.
+        const u32 value = ( index_words[ word ] >> shift ) | ( shift != 0 ? index_words[ word + 1 ] << ( 32 - shift ) : 0 );
+        indices[ c ] = value & mask;
+    }
+}
+
+void meshlet_encoding_statistics( const GpuMeshlet* meshlets, u32 meshlet_count, const GpuMeshletVertexPosition* vertex_positions,
+                                  const GpuMeshletVertexData* vertex_data, u32 vertex_count, const u32* meshlets_data, u32 meshlets_data_count,
+                                  const GpuMeshlet* encoded_meshlets, const u32* encoded_data, u32 encoded_data_count,
+                                  MeshletEncodingStats& stats ) {
+    ZoneScoped;
+
+    stats = MeshletEncodingStats{ };
+    stats.meshlet_count = meshlet_count;
+    stats.vertex_count = vertex_count;
+    stats.meshlet_bytes = sizeof( GpuMeshlet ) * meshlet_count;
+    stats.source_vertex_bytes = ( sizeof( GpuMeshletVertexPosition ) + sizeof( GpuMeshletVertexData ) ) * vertex_count;
+    stats.source_index_bytes = sizeof( u32 ) * meshlets_data_count;
+
+    for ( u32 m = 0; m < meshlet_count; ++m ) {
+        const GpuMeshlet& meshlet = meshlets[ m ];
+        const GpuMeshlet& encoded_meshlet = encoded_meshlets[ m ];
+
+        stats.triangle_count += meshlet.triangle_count;
+        stats.meshlet_vertex_count += meshlet.vertex_count;
+
+        for ( u32 v = 0; v < meshlet.vertex_count; ++v ) {
+            const u32 vertex_index = meshlets_data[ meshlet.data_offset + v ];
+            const GpuMeshletVertexPosition& position = vertex_positions[ vertex_index ];
+            const GpuMeshletVertexData& data = vertex_data[ vertex_index ];
+
+            MeshletDecodedVertex vertex;
+            meshlet_decode_vertex( encoded_meshlet, encoded_data, v, vertex );
+
+            const vec3s source_position{ position.position[ 0 ], position.position[ 1 ], position.position[ 2 ] };
+            const f32 position_error = glms_vec3_distance( source_position, vertex.position );
+            stats.max_position_error = raptor::max( stats.max_position_error, position_error );
+            if ( meshlet.radius > 0.0f ) {
+                stats.max_position_error_radius = raptor::max( stats.max_position_error_radius, position_error / meshlet.radius );
+            }
+
+            const vec3s normal{ meshlet_source_axis( data.normal[ 0 ] ), meshlet_source_axis( data.normal[ 1 ] ), meshlet_source_axis( data.normal[ 2 ] ) };
+            const vec3s tangent{ meshlet_source_axis( data.tangent[ 0 ] ), meshlet_source_axis( data.tangent[ 1 ] ), meshlet_source_axis( data.tangent[ 2 ] ) };
+            stats.max_normal_error = raptor::max( stats.max_normal_error, meshlet_angle_degrees( normal, vertex.normal ) );
+            stats.max_tangent_error = raptor::max( stats.max_tangent_error, meshlet_angle_degrees( tangent, vertex.tangent ) );
+
+            const f32 source_sign = meshlet_source_axis( data.tangent[ 3 ] ) < 0.0f ? -1.0f : 1.0f;
+            stats.tangent_sign_errors += source_sign != vertex.tangent_sign ? 1 : 0;
+        }
+
+        const u32 source_index_offset = meshlet.data_offset + meshlet.vertex_count;
+        for ( u32 t = 0; t < meshlet.triangle_count; ++t ) {
+            u32 indices[ 3 ];
+            meshlet_decode_triangle( encoded_meshlet, encoded_data, t, indices );
+            for ( u32 c = 0; c < 3; ++c ) {
+                stats.index_errors += indices[ c ] != meshlet_source_index( meshlets_data, source_index_offset, t * 3 + c ) ? 1 : 0;
+            }
+        }
+    }
+
+    stats.encoded_vertex_bytes = sizeof( u32 ) * k_meshlet_encoded_vertex_words * stats.meshlet_vertex_count;
+    stats.encoded_index_bytes = sizeof( u32 ) * encoded_data_count - stats.encoded_vertex_bytes;
+}
+
+// Benchmark //////////////////////////////////////////////////////////////
+
+static volatile f32 s_meshlet_benchmark_sink;
+
+// Read every meshlet vertex and triangle of the current layout, converted like the mesh shaders do.
+static f32 meshlet_benchmark_source( const RenderScene& scene, bool positions_only ) {
+    f32 sum = 0.f;
+    u32 index_sum = 0;
+    for ( u32 m = 0; m < scene.meshlets.size; ++m ) {
+        const GpuMeshlet& meshlet = scene.meshlets[ m ];
+        const u32* vertex_indices = scene.meshlets_data.data + meshlet.data_offset;
+
+        for ( u32 v = 0; v < meshlet.vertex_count; ++v ) {
+            const GpuMeshletVertexPosition& position = scene.meshlets_vertex_positions[ vertex_indices[ v ] ];
+            sum += position.position[ 0 ] + position.position[ 1 ] + position.position[ 2 ];
+
+            if ( !positions_only ) {
+                const GpuMeshletVertexData& data = scene.meshlets_vertex_data[ vertex_indices[ v ] ];
+                for ( u32 i = 0; i < 4; ++i ) {
+                    sum += meshlet_source_axis( data.normal[ i ] ) + meshlet_source_axis( data.tangent[ i ] );
+                }
+                index_sum += data.uv_coords[ 0 ] + data.uv_coords[ 1 ];
+            }
+        }
+
+        const u32 index_offset = meshlet.data_offset + meshlet.vertex_count;
+        for ( u32 i = 0; i < meshlet.triangle_count * 3u; ++i ) {
+            index_sum += meshlet_source_index( scene.meshlets_data.data, index_offset, i );
+        }
+    }
+    return sum + f32( index_sum );
+}
+
+static f32 meshlet_benchmark_encoded( const Array<GpuMeshlet>& encoded_meshlets, const Array<u32>& encoded_data, bool positions_only ) {
+    f32 sum = 0.f;
+    u32 index_sum = 0;
+    for ( u32 m = 0; m < encoded_meshlets.size; ++m ) {
+        const GpuMeshlet& meshlet = encoded_meshlets[ m ];
+
+        for ( u32 v = 0; v < meshlet.vertex_count; ++v ) {
+            if ( positions_only ) {
+                const vec3s position = meshlet_decode_position( meshlet, encoded_data.data, v );
+                sum += position.x + position.y + position.z;
+            }
+            else {
+                MeshletDecodedVertex vertex;
+                meshlet_decode_vertex( meshlet, encoded_data.data, v, vertex );
+                sum += vertex.position.x + vertex.position.y + vertex.position.z + vertex.normal.x + vertex.normal.y + vertex.normal.z +
+                       vertex.tangent.x + vertex.tangent.y + vertex.tangent.z + vertex.tangent_sign;
+                index_sum += vertex.uv_coords[ 0 ] + vertex.uv_coords[ 1 ];
+            }
+        }
+
+        for ( u32 t = 0; t < meshlet.triangle_count; ++t ) {
+            u32 indices[ 3 ];
+            meshlet_decode_triangle( meshlet, encoded_data.data, t, indices );
+            index_sum += indices[ 0 ] + indices[ 1 ] + indices[ 2 ];
+        }
+    }
+    return sum + f32( index_sum );
+}
+
+void meshlet_encoding_benchmark( const RenderScene& scene, Allocator* allocator ) {
+    static const u32 k_iterations = 5;
+
+    if ( scene.meshlets.size == 0 ) {
+        rprint( "Meshlet encoding benchmark: the scene has no meshlets\n" );
+        return;
+    }
+
+    Array<GpuMeshlet> encoded_meshlets;
+    encoded_meshlets.init( allocator, scene.meshlets.size );
+    Array<u32> encoded_data;
+    encoded_data.init( allocator, scene.meshlets_data.size );
+
+    const i64 begin_encode = time_now();
+    meshlet_encode( scene.meshlets.data, scene.meshlets.size, scene.meshlets_vertex_positions.data, scene.meshlets_vertex_data.data,
+                    scene.meshlets_data.data, encoded_meshlets, encoded_data );
+    const f64 encode_ms = time_from_milliseconds( begin_encode );
+
+    MeshletEncodingStats stats;
+    meshlet_encoding_statistics( scene.meshlets.data, scene.meshlets.size, scene.meshlets_vertex_positions.data, scene.meshlets_vertex_data.data,
+                                 scene.meshlets_vertex_positions.size, scene.meshlets_data.data, scene.meshlets_data.size,
+                                 encoded_meshlets.data, encoded_data.data, encoded_data.size, stats );
+
+    const f64 triangles = raptor::max( stats.triangle_count, 1u );
+    const sizet source_bytes = stats.source_vertex_bytes + stats.source_index_bytes;
+    const sizet encoded_bytes = stats.encoded_vertex_bytes + stats.encoded_index_bytes;
+
+    rprint( "Meshlet encoding benchmark, %u meshlets, %u triangles, %u vertices, %u meshlet vertices (%.2f per vertex), encoded in %.2f ms\n",
+            stats.meshlet_count, stats.triangle_count, stats.vertex_count, stats.meshlet_vertex_count,
+            stats.meshlet_vertex_count / ( f64 )raptor::max( stats.vertex_count, 1u ), encode_ms );
+    rprint( "    bytes per triangle  source %6.2f (vertices %6.2f, indices %5.2f), encoded %6.2f (vertices %6.2f, indices %5.2f), meshlets %5.2f\n",
+            source_bytes / triangles, stats.source_vertex_bytes / triangles, stats.source_index_bytes / triangles,
+            encoded_bytes / triangles, stats.encoded_vertex_bytes / triangles, stats.encoded_index_bytes / triangles, stats.meshlet_bytes / triangles );
+    rprint( "    total               source %6.2f MB, encoded %6.2f MB, %.1f%% of the source\n",
+            source_bytes / ( 1024.0 * 1024.0 ), encoded_bytes / ( 1024.0 * 1024.0 ), encoded_bytes * 100.0 / raptor::max( source_bytes, ( sizet )1 ) );
+    rprint( "    max errors          position %g (%g of radius), normal %.2f deg, tangent %.2f deg, %u tangent signs, %u indices\n",
+            stats.max_position_error, stats.max_position_error_radius, stats.max_normal_error, stats.max_tangent_error,
+            stats.tangent_sign_errors, stats.index_errors );
+
+    for ( u32 p = 0; p < 2; ++p ) {
+        const bool positions_only = p == 1;
+
+        f64 source_ms = 1e30, encoded_ms = 1e30;
+        for ( u32 i = 0; i < k_iterations; ++i ) {
+            i64 begin_time = time_now();
+            s_meshlet_benchmark_sink = meshlet_benchmark_source( scene, positions_only );
+            f64 ms = time_from_milliseconds( begin_time );
+            source_ms = ms < source_ms ? ms : source_ms;
+
+            begin_time = time_now();
+            s_meshlet_benchmark_sink = meshlet_benchmark_encoded( encoded_meshlets, encoded_data, positions_only );
+            ms = time_from_milliseconds( begin_time );
+            encoded_ms = ms < encoded_ms ? ms : encoded_ms;
+        }
+
+        rprint( "    decode %s source %8.2f ms, %8.1f Mtri/s   encoded %8.2f ms, %8.1f Mtri/s\n", positions_only ? "positions " : "everything",
+                source_ms, triangles / ( source_ms * 1e3 ), encoded_ms, triangles / ( encoded_ms * 1e3 ) );
+    }
+
+    encoded_data.shutdown();
+    encoded_meshlets.shutdown();
+}
+
+} // namespace raptor
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "foundation/array.hpp"
+
+#include "graphics/render_scene.hpp"
+
+namespace raptor {
+
+    // Compact meshlet encoding ///////////////////////////////////////////
+    //
+    // Each meshlet owns a copy of its vertices, so positions can be quantized to 16 bits
+    // relative to the meshlet bounding sphere and the vertex indices of meshlets_data go away.
+    // Encoded meshlets are GpuMeshlet with data_offset pointing into a single u32 stream:
+    //
+    //   vertex_count * 4 words    x | y << 16, z | normal << 16, u | v << 16 (halves), tangent | sign << 16
+    //   index words               local indices bit packed with meshlet_encoded_index_bits, plus one word
+    //                             so that any index can be read with two loads.
+    //
+    // Normals and tangents are octahedral with 8 bits per axis. Position only passes read the first two words.
+    // The decode functions mirror the ones in shaders/meshlet.h.
+
+    static const u32        k_meshlet_encoded_vertex_words  = 4;
+    static const f32        k_meshlet_position_scale        = 32767.0f;
+
+    //
+    //
+    struct MeshletDecodedVertex {
+        vec3s                   position;
+        vec3s                   normal;
+        vec3s                   tangent;
+        f32                     tangent_sign;
+        u16                     uv_coords[ 2 ];     // Halves, stored unchanged.
+    }; // struct MeshletDecodedVertex
+
+    //
+    //
+    struct MeshletEncodingStats {
+        u32                     meshlet_count       = 0;
+        u32                     triangle_count      = 0;
+        u32                     vertex_count        = 0;    // Source vertices, shared between meshlets.
+        u32                     meshlet_vertex_count = 0;   // Vertices referenced by each meshlet, duplicates included.
+
+        sizet                   source_vertex_bytes = 0;
+        sizet                   source_index_bytes  = 0;    // Vertex indices and packed triangles of meshlets_data.
+        sizet                   encoded_vertex_bytes = 0;
+        sizet                   encoded_index_bytes = 0;
+        sizet                   meshlet_bytes       = 0;    // GpuMeshlet headers, the same for both.
+
+        f32                     max_position_error  = 0.f;  // World units.
+        f32                     max_position_error_radius = 0.f;    // Relative to the meshlet radius.
+        f32                     max_normal_error    = 0.f;  // Degrees.
+        f32                     max_tangent_error   = 0.f;  // Degrees.
+        u32                     index_errors        = 0;
+        u32                     tangent_sign_errors = 0;
+    }; // struct MeshletEncodingStats
+
+    // Bits of each local index, enough for vertex_count vertices.
+    u32                         meshlet_encoded_index_bits( u32 vertex_count );
+    // Words used by an encoded meshlet, vertices and indices.
+    u32                         meshlet_encoded_size( u32 vertex_count, u32 triangle_count );
+
+    // Encode meshlets and the vertices indexed by meshlets_data, data offsets of encoded_meshlets point into encoded_data.
+    void                        meshlet_encode( const GpuMeshlet* meshlets, u32 meshlet_count, const GpuMeshletVertexPosition* vertex_positions,
+                                                const GpuMeshletVertexData* vertex_data, const u32* meshlets_data,
+                                                Array<GpuMeshlet>& encoded_meshlets, Array<u32>& encoded_data );
+
+    vec3s                       meshlet_decode_position( const GpuMeshlet& meshlet, const u32* encoded_data, u32 vertex_index );
+    void                        meshlet_decode_vertex( const GpuMeshlet& meshlet, const u32* encoded_data, u32 vertex_index, MeshletDecodedVertex& vertex );
+    void                        meshlet_decode_triangle( const GpuMeshlet& meshlet, const u32* encoded_data, u32 triangle_index, u32 indices[ 3 ] );
+
+    // Compare the encoded meshlets with the source ones: sizes, quantization errors and indices.
+    void                        meshlet_encoding_statistics( const GpuMeshlet* meshlets, u32 meshlet_count, const GpuMeshletVertexPosition* vertex_positions,
+                                                             const GpuMeshletVertexData* vertex_data, u32 vertex_count, const u32* meshlets_data, u32 meshlets_data_count,
+                                                             const GpuMeshlet* encoded_meshlets, const u32* encoded_data, u32 encoded_data_count,
+                                                             MeshletEncodingStats& stats );
+
+    // Encode the scene meshlets, print memory per triangle and errors, then time decoding every
+    // meshlet with both layouts, as the mesh shaders do.
+    void                        meshlet_encoding_benchmark( const RenderScene& scene, Allocator* allocator );
+
+} // namespace raptor
@@ -0,0 +1,853 @@
+#include "graphics/meshlet_hierarchy.hpp"
+#include "graphics/baked_scene.hpp"
+
+#include "foundation/memory.hpp"
+#include "foundation/numerics.hpp"
+#include "foundation/time.hpp"
+
+#include "external/cglm/struct/affine.h"
+#include "external/cglm/struct/mat4.h"
+#include "external/cglm/struct/vec3.h"
+#include "external/cglm/struct/vec4.h"
+
+#include "external/tracy/tracy/Tracy.hpp"
+#include "external/meshoptimizer/meshoptimizer.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+namespace raptor {
+
+// Relative growth of group spheres, so that rounding never projects a parent error under a child one.
+static const f32 k_group_sphere_epsilon = 1e-4f;
+
+void MeshletHierarchy::init( Allocator* allocator ) {
+    meshlets.init( allocator, 64 );
+    meshlets_data.init( allocator, 1024 );
+    lod_bounds.init( allocator, 64 );
+
+    level_count = 0;
+    group_count = 0;
+    root_count = 0;
+    build_seconds = 0.f;
+}
+
+void MeshletHierarchy::shutdown() {
+    lod_bounds.shutdown();
+    meshlets_data.shutdown();
+    meshlets.shutdown();
+}
+
+// Smallest sphere containing both, spheres are center and radius.
+static vec4s meshlet_sphere_merge( vec4s a, vec4s b ) {
+    const vec3s delta{ b.x - a.x, b.y - a.y, b.z - a.z };
+    const f32 distance = glms_vec3_norm( delta );
+    if ( distance + b.w <= a.w ) {
+        return a;
+    }
+    if ( distance + a.w <= b.w ) {
+        return b;
+    }
+
+    const f32 radius = ( distance + a.w + b.w ) * 0.5f;
+    const f32 t = ( radius - a.w ) / distance;
+    return { a.x + delta.x * t, a.y + delta.y * t, a.z + delta.z * t, radius };
+}
+
+// Error in pixels of a sphere in mesh space, measured at its nearest point like select_mesh_lod in mesh.h.
+static f32 meshlet_projected_error( vec4s sphere, f32 error, const mat4s& model_view, f32 scale, f32 pixels_scale, f32 z_near ) {
+    if ( error == FLT_MAX ) {
+        return FLT_MAX;
+    }
+
+    const vec4s view_center = glms_mat4_mulv( model_view, vec4s{ sphere.x, sphere.y, sphere.z, 1.0f } );
+    const f32 distance = raptor::max( glms_vec3_norm( vec3s{ view_center.x, view_center.y, view_center.z } ) - sphere.w * scale, z_near );
+    return error * pixels_scale / distance;
+}
+
+//
+// Scratch state of a build. Clusters are the hierarchy meshlets with their triangles as source vertex indices.
+struct MeshletHierarchyBuilder {
+
+    void                    init( MeshletHierarchy* hierarchy, const MeshletHierarchyParameters* parameters, const f32* positions, u32 vertex_count, u32 stride,
+                                  const u32* indices, u32 index_count, Allocator* allocator );
+    void                    shutdown();
+
+    void                    add_meshlets( const u32* indices, u32 index_count, const f32* meshlet_positions, u32 meshlet_vertex_count, u32 meshlet_stride,
+                                          const u32* source_vertices, const vec4s* group_sphere, f32 group_error );
+    void                    partition( u32 cluster_begin, u32 cluster_end );
+    void                    simplify_group( const u32* clusters, u32 cluster_count );
+
+    MeshletHierarchy*       hierarchy;
+    const MeshletHierarchyParameters* parameters;
+
+    const f32*              positions;
+    u32                     vertex_count;
+    u32                     stride;
+    u32                     level;
+
+    Array<u32>              position_ids;           // Same id for vertices at the same position.
+    u32                     position_count;
+
+    Array<u32>              cluster_indices;        // Triangles of every cluster.
+    Array<u32>              cluster_index_offsets;  // One per meshlet, then cluster_indices.size.
+
+    // Partition
+    Array<u32>              position_stamps;        // Last cluster that counted each position.
+    Array<u32>              position_offsets;       // Clusters touching each position, in position_clusters.
+    Array<u32>              position_clusters;
+    Array<u32>              cluster_positions;      // Unique positions of each cluster, level local.
+    Array<u32>              cluster_position_offsets;
+    Array<u32>              cluster_scores;         // Positions shared with the group being grown, 0 if not a candidate.
+    Array<u32>              candidates;
+    Array<u8>               grouped;
+    Array<u32>              groups;                 // Clusters of every group.
+    Array<u32>              group_offsets;
+
+    // Group simplification
+    Array<u32>              vertex_to_local;        // u32_max when the vertex is not in the group.
+    Array<u32>              local_vertices;
+    Array<f32>              local_positions;
+    Array<u32>              local_indices;
+    Array<u32>              simplified_indices;
+
+    // Meshlet building
+    Array<meshopt_Meshlet>  meshopt_meshlets;
+    Array<u32>              meshlet_vertices;
+    Array<u8>               meshlet_triangles;
+
+}; // struct MeshletHierarchyBuilder
+
+void MeshletHierarchyBuilder::init( MeshletHierarchy* hierarchy_, const MeshletHierarchyParameters* parameters_, const f32* positions_, u32 vertex_count_, u32 stride_,
+                                    const u32* indices, u32 index_count, Allocator* allocator ) {
+    hierarchy = hierarchy_;
+    parameters = parameters_;
+    positions = positions_;
+    vertex_count = vertex_count_;
+    stride = stride_;
+    level = 0;
+
+    position_ids.init( allocator, vertex_count, vertex_count );
+    meshopt_Stream position_stream{ positions, sizeof( f32 ) * 3, stride };
+    // Vertices not referenced by indices are never part of a cluster, they get no id.
+    position_count = ( u32 )meshopt_generateVertexRemapMulti( position_ids.data, indices, index_count, vertex_count, &position_stream, 1 );
+
+    cluster_indices.init( allocator, 1024 );
+    cluster_index_offsets.init( allocator, 64 );
+    cluster_index_offsets.push( 0 );
+
+    position_stamps.init( allocator, position_count, position_count );
+    memset( position_stamps.data, 0xff, sizeof( u32 ) * position_count );
+    position_offsets.init( allocator, position_count + 1, position_count + 1 );
+    position_clusters.init( allocator, 1024 );
+    cluster_positions.init( allocator, 1024 );
+    cluster_position_offsets.init( allocator, 64 );
+    cluster_scores.init( allocator, 64 );
+    candidates.init( allocator, 64 );
+    grouped.init( allocator, 64 );
+    groups.init( allocator, 64 );
+    group_offsets.init( allocator, 64 );
+
+    vertex_to_local.init( allocator, vertex_count, vertex_count );
+    memset( vertex_to_local.data, 0xff, sizeof( u32 ) * vertex_count );
+    local_vertices.init( allocator, 1024 );
+    local_positions.init( allocator, 1024 * 3 );
+    local_indices.init( allocator, 1024 );
+    simplified_indices.init( allocator, 1024 );
+
+    meshopt_meshlets.init( allocator, 64 );
+    meshlet_vertices.init( allocator, 1024 );
+    meshlet_triangles.init( allocator, 1024 );
+}
+
+void MeshletHierarchyBuilder::shutdown() {
+    meshlet_triangles.shutdown();
+    meshlet_vertices.shutdown();
+    meshopt_meshlets.shutdown();
+
+    simplified_indices.shutdown();
+    local_indices.shutdown();
+    local_positions.shutdown();
+    local_vertices.shutdown();
+    vertex_to_local.shutdown();
+
+    group_offsets.shutdown();
+    groups.shutdown();
+    grouped.shutdown();
+    candidates.shutdown();
+    cluster_scores.shutdown();
+    cluster_position_offsets.shutdown();
+    cluster_positions.shutdown();
+    position_clusters.shutdown();
+    position_offsets.shutdown();
+    position_stamps.shutdown();
+
+    cluster_index_offsets.shutdown();
+    cluster_indices.shutdown();
+    position_ids.shutdown();
+}
+
+// Split triangles into meshlets appended to the hierarchy. Meshlet vertices index meshlet_positions and are mapped
+// back with source_vertices, nullptr when they are already source vertices. Without a group sphere, each meshlet
+// uses its own bounds: it is full detail.
+void MeshletHierarchyBuilder::add_meshlets( const u32* indices, u32 index_count, const f32* meshlet_positions, u32 meshlet_vertex_count, u32 meshlet_stride,
+                                            const u32* source_vertices, const vec4s* group_sphere, f32 group_error ) {
+    const u32 max_meshlets = ( u32 )meshopt_buildMeshletsBound( index_count, parameters->max_vertices, parameters->max_triangles );
+    meshopt_meshlets.set_size( max_meshlets );
+    meshlet_vertices.set_size( max_meshlets * parameters->max_vertices );
+    meshlet_triangles.set_size( max_meshlets * parameters->max_triangles * 3 );
+
+    const u32 meshlet_count = ( u32 )meshopt_buildMeshlets( meshopt_meshlets.data, meshlet_vertices.data, meshlet_triangles.data, indices, index_count,
+                                                            meshlet_positions, meshlet_vertex_count, meshlet_stride,
+                                                            parameters->max_vertices, parameters->max_triangles, parameters->cone_weight );
+
+    for ( u32 m = 0; m < meshlet_count; ++m ) {
+        const meshopt_Meshlet& local_meshlet = meshopt_meshlets[ m ];
+        const u32* vertices = meshlet_vertices.data + local_meshlet.vertex_offset;
+        const u8* triangles = meshlet_triangles.data + local_meshlet.triangle_offset;
+
+        const meshopt_Bounds meshlet_bounds = meshopt_computeMeshletBounds( vertices, triangles, local_meshlet.triangle_count,
+                                                                            meshlet_positions, meshlet_vertex_count, meshlet_stride );
+
+        // Same layout as the baked scene meshlets.
+        GpuMeshlet meshlet{};
+        meshlet.center = vec3s{ meshlet_bounds.center[ 0 ], meshlet_bounds.center[ 1 ], meshlet_bounds.center[ 2 ] };
+        meshlet.radius = meshlet_bounds.radius;
+        meshlet.cone_axis[ 0 ] = meshlet_bounds.cone_axis_s8[ 0 ];
+        meshlet.cone_axis[ 1 ] = meshlet_bounds.cone_axis_s8[ 1 ];
+        meshlet.cone_axis[ 2 ] = meshlet_bounds.cone_axis_s8[ 2 ];
+        meshlet.cone_cutoff = meshlet_bounds.cone_cutoff_s8;
+        meshlet.data_offset = hierarchy->meshlets_data.size;
+        meshlet.mesh_index = 0;
+        meshlet.vertex_count = ( u8 )local_meshlet.vertex_count;
+        meshlet.triangle_count = ( u8 )local_meshlet.triangle_count;
+
+        for ( u32 v = 0; v < local_meshlet.vertex_count; ++v ) {
+            hierarchy->meshlets_data.push( source_vertices ? source_vertices[ vertices[ v ] ] : vertices[ v ] );
+        }
+
+        // Triangles are padded to 4 bytes by meshoptimizer.
+        const u32 index_group_count = ( local_meshlet.triangle_count * 3 + 3 ) / 4;
+        const u32 data_offset = hierarchy->meshlets_data.size;
+        hierarchy->meshlets_data.set_size( data_offset + index_group_count );
+        memcpy( hierarchy->meshlets_data.data + data_offset, triangles, sizeof( u32 ) * index_group_count );
+
+        const u32 padding_groups = baked_meshlet_padding_groups( hierarchy->meshlets_data.data + data_offset, index_group_count );
+        for ( u32 i = 0; i < padding_groups; ++i ) {
+            hierarchy->meshlets_data.push( 0 );
+        }
+        meshlet.triangle_count += padding_groups;
+
+        hierarchy->meshlets.push( meshlet );
+        hierarchy->level_triangles[ level ] += meshlet.triangle_count;
+
+        GpuMeshletLodBounds& bounds = hierarchy->lod_bounds.push_use();
+        bounds.sphere = group_sphere ? *group_sphere : vec4s{ meshlet.center.x, meshlet.center.y, meshlet.center.z, meshlet.radius };
+        bounds.error = group_error;
+        bounds.parent_sphere = bounds.sphere;
+        bounds.parent_error = FLT_MAX;
+        bounds.padding[ 0 ] = bounds.padding[ 1 ] = 0.f;
+
+        for ( u32 i = 0; i < local_meshlet.triangle_count * 3; ++i ) {
+            const u32 vertex = vertices[ triangles[ i ] ];
+            cluster_indices.push( source_vertices ? source_vertices[ vertex ] : vertex );
+        }
+        cluster_index_offsets.push( cluster_indices.size );
+    }
+}
+
+// Greedy grouping of the clusters in [cluster_begin, cluster_end): groups grow from the first free cluster,
+// adding the free one sharing the most positions with the group, until full or without free neighbours.
+void MeshletHierarchyBuilder::partition( u32 cluster_begin, u32 cluster_end ) {
+    ZoneScoped;
+
+    const u32 cluster_count = cluster_end - cluster_begin;
+
+    // Unique positions of each cluster, then the clusters touching each position.
+    cluster_positions.set_size( 0 );
+    cluster_position_offsets.set_size( 0 );
+    memset( position_offsets.data, 0, sizeof( u32 ) * ( position_count + 1 ) );
+
+    for ( u32 c = 0; c < cluster_count; ++c ) {
+        const u32 cluster = cluster_begin + c;
+        cluster_position_offsets.push( cluster_positions.size );
+
+        for ( u32 i = cluster_index_offsets[ cluster ]; i < cluster_index_offsets[ cluster + 1 ]; ++i ) {
+            const u32 position = position_ids[ cluster_indices[ i ] ];
+            if ( position_stamps[ position ] != cluster ) {
+                position_stamps[ position ] = cluster;
+                cluster_positions.push( position );
+                ++position_offsets[ position + 1 ];
+            }
+        }
+    }
+    cluster_position_offsets.push( cluster_positions.size );
+
+    for ( u32 p = 0; p < position_count; ++p ) {
+        position_offsets[ p + 1 ] += position_offsets[ p ];
+    }
+
+    position_clusters.set_size( cluster_positions.size );
+    for ( u32 c = 0; c < cluster_count; ++c ) {
+        for ( u32 i = cluster_position_offsets[ c ]; i < cluster_position_offsets[ c + 1 ]; ++i ) {
+            position_clusters[ position_offsets[ cluster_positions[ i ] ]++ ] = c;
+        }
+    }
+    // Filling moved each offset to the start of the next position.
+    for ( u32 p = position_count; p > 0; --p ) {
+        position_offsets[ p ] = position_offsets[ p - 1 ];
+    }
+    position_offsets[ 0 ] = 0;
+
+    cluster_scores.set_size( cluster_count );
+    memset( cluster_scores.data, 0, sizeof( u32 ) * cluster_count );
+    grouped.set_size( cluster_count );
+    memset( grouped.data, 0, cluster_count );
+
+    groups.set_size( 0 );
+    group_offsets.set_size( 0 );
+
+    for ( u32 seed = 0; seed < cluster_count; ++seed ) {
+        if ( grouped[ seed ] ) {
+            continue;
+        }
+
+        group_offsets.push( groups.size );
+        candidates.set_size( 0 );
+
+        u32 added = seed;
+        for ( u32 size = 1; ; ++size ) {
+            grouped[ added ] = 1;
+            groups.push( cluster_begin + added );
+
+            if ( size == parameters->group_size ) {
+                break;
+            }
+
+            for ( u32 i = cluster_position_offsets[ added ]; i < cluster_position_offsets[ added + 1 ]; ++i ) {
+                const u32 position = cluster_positions[ i ];
+                for ( u32 j = position_offsets[ position ]; j < position_offsets[ position + 1 ]; ++j ) {
+                    const u32 neighbour = position_clusters[ j ];
+                    if ( grouped[ neighbour ] ) {
+                        continue;
+                    }
+                    if ( cluster_scores[ neighbour ]++ == 0 ) {
+                        candidates.push( neighbour );
+                    }
+                }
+            }
+
+            u32 best = u32_max, best_score = 0;
+            for ( u32 i = 0; i < candidates.size; ++i ) {
+                const u32 candidate = candidates[ i ];
+                if ( !grouped[ candidate ] && cluster_scores[ candidate ] > best_score ) {
+                    best = candidate;
+                    best_score = cluster_scores[ candidate ];
+                }
+            }
+
+            if ( best == u32_max ) {
+                break;
+            }
+            added = best;
+        }
+
+        for ( u32 i = 0; i < candidates.size; ++i ) {
+            cluster_scores[ candidates[ i ] ] = 0;
+        }
+    }
+    group_offsets.push( groups.size );
+}
+
+// Simplify the triangles of a group to half, with its border locked, and split them again into meshlets.
+// Groups that do not simplify enough are left alone, their clusters are roots.
+void MeshletHierarchyBuilder::simplify_group( const u32* clusters, u32 cluster_count ) {
+    local_vertices.set_size( 0 );
+    local_positions.set_size( 0 );
+    local_indices.set_size( 0 );
+
+    for ( u32 c = 0; c < cluster_count; ++c ) {
+        const u32 cluster = clusters[ c ];
+        for ( u32 i = cluster_index_offsets[ cluster ]; i < cluster_index_offsets[ cluster + 1 ]; ++i ) {
+            const u32 vertex = cluster_indices[ i ];
+            if ( vertex_to_local[ vertex ] == u32_max ) {
+                vertex_to_local[ vertex ] = local_vertices.size;
+                local_vertices.push( vertex );
+
+                const f32* position = ( const f32* )( ( const u8* )positions + ( sizet )vertex * stride );
+                local_positions.push( position[ 0 ] );
+                local_positions.push( position[ 1 ] );
+                local_positions.push( position[ 2 ] );
+            }
+            local_indices.push( vertex_to_local[ vertex ] );
+        }
+    }
+
+    for ( u32 v = 0; v < local_vertices.size; ++v ) {
+        vertex_to_local[ local_vertices[ v ] ] = u32_max;
+    }
+
+    const u32 index_count = local_indices.size;
+    const u32 target_index_count = index_count / 6 * 3;
+    simplified_indices.set_size( index_count );
+
+    f32 simplify_error = 0.f;
+    const u32 simplified_count = ( u32 )meshopt_simplify( simplified_indices.data, local_indices.data, index_count, local_positions.data, local_vertices.size,
+                                                          sizeof( f32 ) * 3, target_index_count, parameters->max_error, meshopt_SimplifyLockBorder, &simplify_error );
+
+    if ( simplified_count == 0 || simplified_count > index_count * parameters->min_reduction ) {
+        return;
+    }
+
+    // The group contains the groups of its clusters, and its error adds to theirs: both only grow up the hierarchy.
+    vec4s sphere = hierarchy->lod_bounds[ clusters[ 0 ] ].sphere;
+    f32 children_error = 0.f;
+    for ( u32 c = 0; c < cluster_count; ++c ) {
+        const GpuMeshletLodBounds& bounds = hierarchy->lod_bounds[ clusters[ c ] ];
+        sphere = meshlet_sphere_merge( sphere, bounds.sphere );
+        children_error = raptor::max( children_error, bounds.error );
+    }
+    sphere.w *= 1.0f + k_group_sphere_epsilon;
+
+    const f32 error = children_error + simplify_error * meshopt_simplifyScale( local_positions.data, local_vertices.size, sizeof( f32 ) * 3 );
+
+    for ( u32 c = 0; c < cluster_count; ++c ) {
+        GpuMeshletLodBounds& bounds = hierarchy->lod_bounds[ clusters[ c ] ];
+        bounds.parent_sphere = sphere;
+        bounds.parent_error = error;
+    }
+
+    ++hierarchy->group_count;
+    add_meshlets( simplified_indices.data, simplified_count, local_positions.data, local_vertices.size, sizeof( f32 ) * 3,
+                  local_vertices.data, &sphere, error );
+}
+
+void meshlet_hierarchy_build( MeshletHierarchy& hierarchy, const f32* positions, u32 vertex_count, u32 stride,
+                              const u32* indices, u32 index_count, const MeshletHierarchyParameters& parameters, Allocator* temp_allocator ) {
+    ZoneScoped;
+
+    const i64 start_build = time_now();
+
+    hierarchy.meshlets.set_size( 0 );
+    hierarchy.meshlets_data.set_size( 0 );
+    hierarchy.lod_bounds.set_size( 0 );
+    hierarchy.level_count = 0;
+    hierarchy.group_count = 0;
+    memset( hierarchy.level_triangles, 0, sizeof( hierarchy.level_triangles ) );
+
+    MeshletHierarchyBuilder builder;
+    builder.init( &hierarchy, &parameters, positions, vertex_count, stride, indices, index_count, temp_allocator );
+
+    hierarchy.level_offsets[ 0 ] = 0;
+    builder.add_meshlets( indices, index_count, positions, vertex_count, stride, nullptr, nullptr, 0.f );
+    hierarchy.level_offsets[ 1 ] = hierarchy.meshlets.size;
+    hierarchy.level_count = 1;
+
+    // Each level groups and simplifies the meshlets of the previous one, until a single meshlet is left
+    // or no group could be simplified.
+    while ( hierarchy.level_count < k_meshlet_hierarchy_max_levels ) {
+        const u32 level_begin = hierarchy.level_offsets[ hierarchy.level_count - 1 ];
+        const u32 level_end = hierarchy.level_offsets[ hierarchy.level_count ];
+        if ( level_end - level_begin <= 1 ) {
+            break;
+        }
+
+        builder.level = hierarchy.level_count;
+        builder.partition( level_begin, level_end );
+
+        for ( u32 g = 0; g + 1 < builder.group_offsets.size; ++g ) {
+            const u32 group_begin = builder.group_offsets[ g ];
+            builder.simplify_group( builder.groups.data + group_begin, builder.group_offsets[ g + 1 ] - group_begin );
+        }
+
+        if ( hierarchy.meshlets.size == level_end ) {
+            break;
+        }
+
+        ++hierarchy.level_count;
+        hierarchy.level_offsets[ hierarchy.level_count ] = hierarchy.meshlets.size;
+    }
+
+    hierarchy.root_count = 0;
+    for ( u32 m = 0; m < hierarchy.lod_bounds.size; ++m ) {
+        hierarchy.root_count += hierarchy.lod_bounds[ m ].parent_error == FLT_MAX ? 1 : 0;
+    }
+
+    builder.shutdown();
+
+    hierarchy.build_seconds = ( f32 )time_from_seconds( start_build );
+}
+
+u32 meshlet_hierarchy_select_cut( const MeshletHierarchy& hierarchy, const mat4s& world, const GpuSceneData& scene_data,
+                                  u32 meshlet_offset, u32 mesh_instance_index, Array<GpuMeshletInstance>& instances ) {
+    const mat4s model_view = glms_mat4_mul( scene_data.world_to_camera, world );
+    const f32 scale = glms_vec4_norm( world.col[ 0 ] );
+    // Pixels covered by a mesh space unit at distance 1.
+    const f32 pixels_scale = scene_data.projection_11 * scene_data.resolution_y * 0.5f * scale;
+    const f32 max_error = scene_data.mesh_lods() ? scene_data.lod_error_pixels : 0.f;
+
+    u32 count = 0;
+    for ( u32 m = 0; m < hierarchy.meshlets.size; ++m ) {
+        const GpuMeshletLodBounds& bounds = hierarchy.lod_bounds[ m ];
+
+        // Drawn when precise enough, and the group it was simplified in is not.
+        if ( meshlet_projected_error( bounds.sphere, bounds.error, model_view, scale, pixels_scale, scene_data.z_near ) > max_error ) {
+            continue;
+        }
+        if ( meshlet_projected_error( bounds.parent_sphere, bounds.parent_error, model_view, scale, pixels_scale, scene_data.z_near ) <= max_error ) {
+            continue;
+        }
+
+        instances.push( { meshlet_offset + m, mesh_instance_index } );
+        ++count;
+    }
+
+    return count;
+}
+
+// Benchmark //////////////////////////////////////////////////////////////
+
+// Triangles and deepest level of the meshlets appended to instances after first.
+static u32 meshlet_hierarchy_cut_triangles( const MeshletHierarchy& hierarchy, const Array<GpuMeshletInstance>& instances, u32 first, u32& deepest_level ) {
+    u32 triangles = 0;
+    for ( u32 i = first; i < instances.size; ++i ) {
+        const u32 meshlet_index = instances[ i ].meshlet_index;
+
+        u32 level = 0;
+        while ( meshlet_index >= hierarchy.level_offsets[ level + 1 ] ) {
+            ++level;
+        }
+        deepest_level = raptor::max( deepest_level, level );
+
+        triangles += hierarchy.meshlets[ meshlet_index ].triangle_count;
+    }
+    return triangles;
+}
+
+void meshlet_hierarchy_benchmark( const RenderScene& scene, Allocator* allocator ) {
+    static const u32 k_iterations = 5;
+
+    if ( scene.meshlets.size == 0 ) {
+        rprint( "Meshlet hierarchy benchmark: the scene has no meshlets\n" );
+        return;
+    }
+
+    const u32 mesh_count = scene.meshes.size;
+    const u32 scene_vertex_count = scene.meshlets_vertex_positions.size;
+
+    Array<MeshletHierarchy> hierarchies;
+    hierarchies.init( allocator, mesh_count, mesh_count );
+
+    // Each mesh is rebuilt from its full detail meshlets, with its vertices compacted.
+    Array<u32> vertex_to_local;
+    vertex_to_local.init( allocator, scene_vertex_count, scene_vertex_count );
+    memset( vertex_to_local.data, 0xff, sizeof( u32 ) * scene_vertex_count );
+    Array<u32> local_vertices;
+    local_vertices.init( allocator, 1024 );
+    Array<f32> local_positions;
+    local_positions.init( allocator, 1024 * 3 );
+    Array<u32> indices;
+    indices.init( allocator, 1024 );
+
+    MeshletHierarchyParameters parameters;
+
+    u64 source_triangles = 0, full_detail_triangles = 0, root_triangles = 0;
+    u32 hierarchy_meshlets = 0, groups = 0, roots = 0, max_levels = 0, largest_mesh = u32_max;
+    sizet hierarchy_bytes = 0;
+    f64 build_seconds = 0.0;
+
+    for ( u32 mesh_index = 0; mesh_index < mesh_count; ++mesh_index ) {
+        const Mesh& mesh = scene.meshes[ mesh_index ];
+        MeshletHierarchy& hierarchy = hierarchies[ mesh_index ];
+        hierarchy.init( allocator );
+
+        local_vertices.set_size( 0 );
+        local_positions.set_size( 0 );
+        indices.set_size( 0 );
+
+        for ( u32 m = mesh.meshlet_offset; m < mesh.meshlet_offset + mesh.meshlet_count; ++m ) {
+            const GpuMeshlet& meshlet = scene.meshlets[ m ];
+            const u32* vertices = scene.meshlets_data.data + meshlet.data_offset;
+            const u8* triangles = ( const u8* )( vertices + meshlet.vertex_count );
+
+            for ( u32 t = 0; t < meshlet.triangle_count; ++t ) {
+                const u32 a = triangles[ t * 3 + 0 ], b = triangles[ t * 3 + 1 ], c = triangles[ t * 3 + 2 ];
+                // Skip the padding triangles.
+                if ( a == b || b == c || a == c ) {
+                    continue;
+                }
+
+                const u32 corners[ 3 ] = { vertices[ a ], vertices[ b ], vertices[ c ] };
+                for ( u32 i = 0; i < 3; ++i ) {
+                    const u32 vertex = corners[ i ];
+                    if ( vertex_to_local[ vertex ] == u32_max ) {
+                        vertex_to_local[ vertex ] = local_vertices.size;
+                        local_vertices.push( vertex );
+
+                        const GpuMeshletVertexPosition& position = scene.meshlets_vertex_positions[ vertex ];
+                        local_positions.push( position.position[ 0 ] );
+                        local_positions.push( position.position[ 1 ] );
+                        local_positions.push( position.position[ 2 ] );
+                    }
+                    indices.push( vertex_to_local[ vertex ] );
+                }
+            }
+        }
+
+        for ( u32 v = 0; v < local_vertices.size; ++v ) {
+            vertex_to_local[ local_vertices[ v ] ] = u32_max;
+        }
+
+        if ( indices.size == 0 ) {
+            continue;
+        }
+
+        meshlet_hierarchy_build( hierarchy, local_positions.data, local_vertices.size, sizeof( f32 ) * 3, indices.data, indices.size, parameters, allocator );
+
+        source_triangles += indices.size / 3;
+        full_detail_triangles += hierarchy.level_triangles[ 0 ];
+        hierarchy_meshlets += hierarchy.meshlets.size;
+        groups += hierarchy.group_count;
+        roots += hierarchy.root_count;
+        max_levels = raptor::max( max_levels, hierarchy.level_count );
+        hierarchy_bytes += sizeof( GpuMeshlet ) * hierarchy.meshlets.size + sizeof( u32 ) * hierarchy.meshlets_data.size +
+                           sizeof( GpuMeshletLodBounds ) * hierarchy.lod_bounds.size;
+        build_seconds += hierarchy.build_seconds;
+
+        for ( u32 m = 0; m < hierarchy.lod_bounds.size; ++m ) {
+            root_triangles += hierarchy.lod_bounds[ m ].parent_error == FLT_MAX ? hierarchy.meshlets[ m ].triangle_count : 0;
+        }
+
+        if ( largest_mesh == u32_max || hierarchy.level_triangles[ 0 ] > hierarchies[ largest_mesh ].level_triangles[ 0 ] ) {
+            largest_mesh = mesh_index;
+        }
+    }
+
+    rprint( "Meshlet hierarchy benchmark, %u meshes, %llu triangles\n", mesh_count, ( unsigned long long )source_triangles );
+    rprint( "    built in %.2f ms: %u meshlets (%u full detail), %u groups, up to %u levels, %.2f MB\n", build_seconds * 1000.0, hierarchy_meshlets,
+            scene.meshlets.size, groups, max_levels, hierarchy_bytes / ( 1024.0 * 1024.0 ) );
+    rprint( "    %u roots with %llu triangles, %.2f%% of the full detail\n", roots, ( unsigned long long )root_triangles,
+            full_detail_triangles ? root_triangles * 100.0 / full_detail_triangles : 0.0 );
+
+    // Cut of every mesh instance from the current camera.
+    Array<GpuMeshletInstance> instances;
+    instances.init( allocator, hierarchy_meshlets );
+
+    f64 select_ms = 1e30;
+    for ( u32 i = 0; i < k_iterations; ++i ) {
+        instances.set_size( 0 );
+
+        const i64 begin_time = time_now();
+        for ( u32 mi = 0; mi < scene.mesh_instances.size; ++mi ) {
+            const MeshInstance& mesh_instance = scene.mesh_instances[ mi ];
+            const u32 mesh_index = ( u32 )( mesh_instance.mesh - scene.meshes.data );
+            meshlet_hierarchy_select_cut( hierarchies[ mesh_index ], scene.mesh_instance_world_matrix( mesh_instance ), scene.scene_data, 0, mi, instances );
+        }
+        const f64 ms = time_from_milliseconds( begin_time );
+        select_ms = ms < select_ms ? ms : select_ms;
+    }
+
+    u64 cut_triangles = 0, full_triangles = 0;
+    u32 deepest_level = 0;
+    instances.set_size( 0 );
+    for ( u32 mi = 0; mi < scene.mesh_instances.size; ++mi ) {
+        const MeshInstance& mesh_instance = scene.mesh_instances[ mi ];
+        const MeshletHierarchy& hierarchy = hierarchies[ ( u32 )( mesh_instance.mesh - scene.meshes.data ) ];
+
+        const u32 first = instances.size;
+        meshlet_hierarchy_select_cut( hierarchy, scene.mesh_instance_world_matrix( mesh_instance ), scene.scene_data, 0, mi, instances );
+        cut_triangles += meshlet_hierarchy_cut_triangles( hierarchy, instances, first, deepest_level );
+        full_triangles += hierarchy.level_triangles[ 0 ];
+    }
+
+    rprint( "    camera cut of %u instances in %.3f ms: %u meshlets, %llu / %llu triangles, deepest level %u\n", scene.mesh_instances.size, select_ms,
+            instances.size, ( unsigned long long )cut_triangles, ( unsigned long long )full_triangles, deepest_level );
+
+    // Largest mesh moving away from the camera, errors on screen as set for the mesh levels of detail.
+    if ( largest_mesh != u32_max ) {
+        const MeshletHierarchy& hierarchy = hierarchies[ largest_mesh ];
+        const vec4s bounding_sphere = scene.meshes[ largest_mesh ].bounding_sphere;
+
+        GpuSceneData scene_data = scene.scene_data;
+        scene_data.world_to_camera = glms_mat4_identity();
+        scene_data.set_mesh_lods( true );
+
+        rprint( "    largest mesh, %u triangles, %u levels, cut at %.1f pixels:\n", hierarchy.level_triangles[ 0 ], hierarchy.level_count, scene_data.lod_error_pixels );
+        for ( f32 radii = 1.f; radii <= 1024.f; radii *= 4.f ) {
+            const f32 distance = bounding_sphere.w * radii;
+            const mat4s world = glms_translate_make( vec3s{ -bounding_sphere.x, -bounding_sphere.y, distance - bounding_sphere.z } );
+
+            instances.set_size( 0 );
+            u32 level = 0;
+            meshlet_hierarchy_select_cut( hierarchy, world, scene_data, 0, 0, instances );
+            const u32 triangles = meshlet_hierarchy_cut_triangles( hierarchy, instances, 0, level );
+
+            rprint( "        %6.0f radii: %5u meshlets, %8u triangles, deepest level %u\n", radii, instances.size, triangles, level );
+        }
+    }
+
+    instances.shutdown();
+    for ( u32 mesh_index = 0; mesh_index < mesh_count; ++mesh_index ) {
+        hierarchies[ mesh_index ].shutdown();
+    }
+    hierarchies.shutdown();
+    indices.shutdown();
+    local_positions.shutdown();
+    local_vertices.shutdown();
+    vertex_to_local.shutdown();
+}
+
+// Check //////////////////////////////////////////////////////////////////
+
+static bool meshlet_sphere_contains( vec4s outer, vec4s inner ) {
+    const f32 distance = glms_vec3_norm( vec3s{ inner.x - outer.x, inner.y - outer.y, inner.z - outer.z } );
+    return distance + inner.w <= outer.w * ( 1.0f + k_group_sphere_epsilon );
+}
+
+bool meshlet_hierarchy_check( Allocator* allocator ) {
+    static const u32 k_grid_size = 96;
+    static const f32 k_cut_scales[] = { 1.f, 3.f };
+
+    // Wavy grid, so that every group has some simplification error.
+    Array<f32> positions;
+    positions.init( allocator, k_grid_size * k_grid_size * 3 );
+    for ( u32 y = 0; y < k_grid_size; ++y ) {
+        for ( u32 x = 0; x < k_grid_size; ++x ) {
+            const f32 u = x / ( f32 )( k_grid_size - 1 ), v = y / ( f32 )( k_grid_size - 1 );
+            positions.push( u );
+            positions.push( v );
+            positions.push( 0.05f * sinf( u * 11.f ) * cosf( v * 7.f ) );
+        }
+    }
+
+    Array<u32> indices;
+    indices.init( allocator, ( k_grid_size - 1 ) * ( k_grid_size - 1 ) * 6 );
+    for ( u32 y = 0; y + 1 < k_grid_size; ++y ) {
+        for ( u32 x = 0; x + 1 < k_grid_size; ++x ) {
+            const u32 v0 = y * k_grid_size + x, v1 = v0 + 1, v2 = v0 + k_grid_size, v3 = v2 + 1;
+            indices.push( v0 ); indices.push( v1 ); indices.push( v2 );
+            indices.push( v2 ); indices.push( v1 ); indices.push( v3 );
+        }
+    }
+
+    MeshletHierarchy hierarchy;
+    hierarchy.init( allocator );
+    meshlet_hierarchy_build( hierarchy, positions.data, positions.size / 3, sizeof( f32 ) * 3, indices.data, indices.size, MeshletHierarchyParameters{ }, allocator );
+
+    const u32 meshlet_count = hierarchy.meshlets.size;
+    const u32 leaf_count = hierarchy.level_offsets[ 1 ];
+
+    // Error and bounds only grow from a meshlet to the group it is simplified in.
+    u32 monotonic_errors = 0;
+    for ( u32 m = 0; m < meshlet_count; ++m ) {
+        const GpuMeshletLodBounds& bounds = hierarchy.lod_bounds[ m ];
+        if ( bounds.parent_error != FLT_MAX && ( bounds.parent_error < bounds.error || !meshlet_sphere_contains( bounds.parent_sphere, bounds.sphere ) ) ) {
+            ++monotonic_errors;
+        }
+    }
+
+    // Meshlets built from the same group are contiguous and share its sphere and error: find the group each meshlet is simplified in.
+    Array<u32> parent_group_begin;
+    parent_group_begin.init( allocator, meshlet_count, meshlet_count );
+    Array<u32> parent_group_end;
+    parent_group_end.init( allocator, meshlet_count, meshlet_count );
+
+    u32 orphan_meshlets = 0;
+    for ( u32 m = 0; m < meshlet_count; ++m ) {
+        const GpuMeshletLodBounds& bounds = hierarchy.lod_bounds[ m ];
+        parent_group_begin[ m ] = parent_group_end[ m ] = u32_max;
+        if ( bounds.parent_error == FLT_MAX ) {
+            continue;
+        }
+
+        for ( u32 g = leaf_count; g < meshlet_count; ++g ) {
+            const GpuMeshletLodBounds& group = hierarchy.lod_bounds[ g ];
+            if ( group.error == bounds.parent_error && memcmp( &group.sphere, &bounds.parent_sphere, sizeof( vec4s ) ) == 0 ) {
+                u32 end = g + 1;
+                while ( end < meshlet_count && hierarchy.lod_bounds[ end ].error == group.error &&
+                        memcmp( &hierarchy.lod_bounds[ end ].sphere, &group.sphere, sizeof( vec4s ) ) == 0 ) {
+                    ++end;
+                }
+                parent_group_begin[ m ] = g;
+                parent_group_end[ m ] = end;
+                break;
+            }
+        }
+
+        orphan_meshlets += parent_group_begin[ m ] == u32_max ? 1 : 0;
+    }
+
+    // A cut is valid when every path from a leaf up to a root crosses exactly one selected meshlet,
+    // so each leaf is drawn exactly once, at a single level.
+    Array<GpuMeshletInstance> instances;
+    instances.init( allocator, meshlet_count );
+    Array<u8> selected;
+    selected.init( allocator, meshlet_count, meshlet_count );
+    Array<u32> min_crossed;
+    min_crossed.init( allocator, meshlet_count, meshlet_count );
+    Array<u32> max_crossed;
+    max_crossed.init( allocator, meshlet_count, meshlet_count );
+
+    GpuSceneData scene_data{ };
+    scene_data.world_to_camera = glms_mat4_identity();
+    scene_data.z_near = 0.1f;
+    scene_data.projection_11 = 1.f;
+    scene_data.resolution_y = 1080.f;
+    scene_data.lod_error_pixels = 1.f;
+    scene_data.set_mesh_lods( true );
+
+    u32 cuts = 0, uncovered_leaves = 0, deepest_level = 0;
+    for ( u32 s = 0; s < ArraySize( k_cut_scales ); ++s ) {
+        for ( f32 distance = 0.5f; distance <= 512.f; distance *= 2.f ) {
+            const mat4s world = glms_scale( glms_translate_make( vec3s{ -0.5f, -0.5f, -distance } ), vec3s{ k_cut_scales[ s ], k_cut_scales[ s ], k_cut_scales[ s ] } );
+
+            instances.set_size( 0 );
+            meshlet_hierarchy_select_cut( hierarchy, world, scene_data, 0, 0, instances );
+            meshlet_hierarchy_cut_triangles( hierarchy, instances, 0, deepest_level );
+            ++cuts;
+
+            memset( selected.data, 0, meshlet_count );
+            for ( u32 i = 0; i < instances.size; ++i ) {
+                selected[ instances[ i ].meshlet_index ] = 1;
+            }
+
+            // Groups come after the meshlets they are built from.
+            for ( u32 m = meshlet_count; m-- > 0; ) {
+                u32 min_above = 0, max_above = 0;
+                if ( parent_group_begin[ m ] != u32_max ) {
+                    min_above = u32_max;
+                    for ( u32 g = parent_group_begin[ m ]; g < parent_group_end[ m ]; ++g ) {
+                        min_above = raptor::min( min_above, min_crossed[ g ] );
+                        max_above = raptor::max( max_above, max_crossed[ g ] );
+                    }
+                }
+                min_crossed[ m ] = selected[ m ] + min_above;
+                max_crossed[ m ] = selected[ m ] + max_above;
+            }
+
+            for ( u32 m = 0; m < leaf_count; ++m ) {
+                uncovered_leaves += ( min_crossed[ m ] != 1 || max_crossed[ m ] != 1 ) ? 1 : 0;
+            }
+        }
+    }
+
+    const bool passed = monotonic_errors == 0 && orphan_meshlets == 0 && uncovered_leaves == 0 && hierarchy.level_count > 1;
+    rprint( "Meshlet hierarchy check: %s, %u meshlets in %u levels, %u monotonic errors, %u orphan meshlets, "
+            "%u leaves not drawn exactly once over %u cuts down to level %u\n", passed ? "passed" : "FAILED", meshlet_count, hierarchy.level_count,
+            monotonic_errors, orphan_meshlets, uncovered_leaves, cuts, deepest_level );
+
+    max_crossed.shutdown();
+    min_crossed.shutdown();
+    selected.shutdown();
+    instances.shutdown();
+    parent_group_end.shutdown();
+    parent_group_begin.shutdown();
+    hierarchy.shutdown();
+    indices.shutdown();
+    positions.shutdown();
+
+    return passed;
+}
+
+} // namespace raptor
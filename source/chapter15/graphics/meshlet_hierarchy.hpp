@@ -0,0 +1,93 @@
+#pragma once
+
+#include "foundation/array.hpp"
+
+#include "graphics/render_scene.hpp"
+
+namespace raptor {
+
+    // Meshlet hierarchy //////////////////////////////////////////////////
+    //
+    // Continuous level of detail: meshlets are grouped with their neighbours, each group is simplified
+    // to half its triangles with the group border locked, and the result is split again into meshlets.
+    // Repeating this until groups cannot be simplified anymore builds a DAG where the border shared by two
+    // groups only moves once both are merged into the same group, so levels can be mixed without cracks.
+    //
+    // Each meshlet keeps the bounds and error of the group it was built from and of the group it was
+    // simplified in. Errors grow at each level and group spheres contain the spheres of their meshlets,
+    // so drawing the meshlets whose own error is small enough on screen while the parent one is not
+    // always gives a single, consistent cut.
+
+    static const u32        k_meshlet_hierarchy_max_levels  = 32;
+
+    //
+    // Bounds and errors of a meshlet, error and spheres in mesh space.
+    struct alignas( 16 ) GpuMeshletLodBounds {
+
+        vec4s                   sphere;             // Group the meshlet was built from, its own bounds for the full detail meshlets.
+        vec4s                   parent_sphere;      // Group the meshlet was simplified in.
+        f32                     error;              // 0 for the full detail meshlets.
+        f32                     parent_error;       // FLT_MAX when the meshlet is never simplified, it is a root of the DAG.
+        f32                     padding[ 2 ];
+    }; // struct GpuMeshletLodBounds
+
+    //
+    // Same as the meshlet_instances written by generate_meshlet_instances in meshlet.glsl.
+    struct GpuMeshletInstance {
+        u32                     meshlet_index;
+        u32                     mesh_instance_index;
+    }; // struct GpuMeshletInstance
+
+    //
+    //
+    struct MeshletHierarchyParameters {
+        u32                     max_vertices        = 64;
+        u32                     max_triangles       = 124;
+        f32                     cone_weight         = 0.0f;
+
+        u32                     group_size          = 4;        // Meshlets simplified together.
+        f32                     max_error           = 0.1f;     // Simplification error relative to the group extents.
+        f32                     min_reduction       = 0.85f;    // Groups keeping more of their triangles are left as roots.
+    }; // struct MeshletHierarchyParameters
+
+    //
+    // Meshlets of every level, in the same format as the baked scene ones: vertex indices and
+    // packed triangles in meshlets_data, with vertex indices local to the source mesh.
+    struct MeshletHierarchy {
+
+        void                    init( Allocator* allocator );
+        void                    shutdown();
+
+        Array<GpuMeshlet>       meshlets;
+        Array<u32>              meshlets_data;
+        Array<GpuMeshletLodBounds> lod_bounds;      // One per meshlet.
+
+        u32                     level_count         = 0;
+        u32                     group_count         = 0;
+        u32                     level_offsets[ k_meshlet_hierarchy_max_levels + 1 ];  // First meshlet of each level, then meshlets.size.
+        u32                     level_triangles[ k_meshlet_hierarchy_max_levels ];    // Triangles drawn, padding included.
+        u32                     root_count          = 0;
+        f32                     build_seconds       = 0.f;
+
+    }; // struct MeshletHierarchy
+
+    // Build the hierarchy of an indexed triangle mesh, positions has stride bytes between vertices.
+    // Scratch memory comes from temp_allocator, the hierarchy arrays must be initialized.
+    void                        meshlet_hierarchy_build( MeshletHierarchy& hierarchy, const f32* positions, u32 vertex_count, u32 stride,
+                                                         const u32* indices, u32 index_count, const MeshletHierarchyParameters& parameters, Allocator* temp_allocator );
+
+    // Append the meshlets of the cut for a mesh instance, with meshlet_offset added to their indices.
+    // The error tolerated on screen is scene_data.lod_error_pixels, or none when mesh levels of detail are disabled.
+    // Returns the number of meshlets appended.
+    u32                         meshlet_hierarchy_select_cut( const MeshletHierarchy& hierarchy, const mat4s& world, const GpuSceneData& scene_data,
+                                                              u32 meshlet_offset, u32 mesh_instance_index, Array<GpuMeshletInstance>& instances );
+
+    // Build the hierarchy of a procedural mesh, check that errors and bounds grow up the hierarchy and that
+    // cuts from several distances draw every full detail meshlet exactly once. Results go to rprint.
+    bool                        meshlet_hierarchy_check( Allocator* allocator );
+
+    // Build the hierarchy of every scene mesh from its full detail meshlets, then time the cut selection
+    // of all mesh instances from the current camera and print the triangles kept at increasing distances.
+    void                        meshlet_hierarchy_benchmark( const RenderScene& scene, Allocator* allocator );
+
+} // namespace raptor
@@ -187,6 +187,7 @@ void ObjScene::init( SceneGraph* scene_graph_, Allocator* resident_allocator_, R
     meshes.init( resident_allocator, 32 );
 
     animations.init( resident_allocator, 0 );
+    animation_instances.init( resident_allocator, 0 );
     skins.init( resident_allocator, 0 );
 
     assimp_scenes.init( resident_allocator, 4 );
@@ -474,6 +475,15 @@ void ObjScene::add_mesh( cstring filename, cstring path, StackAllocator* temp_al
             async_loader->request_buffer_copy( cpu_buffer, gpu_buffer->handle );
 
             indirect_commands.shutdown();
+
+            // Cpu simulation, the indices of this mesh are the last ones added.
+            const u32 mesh_index_count = mesh->mNumFaces * 3;
+            physics_mesh->cloth.init( resident_allocator, physics_mesh->vertices.data, physics_mesh->vertices.size, indices.data + indices.size - mesh_index_count, mesh_index_count );
+
+            buffer_size = sizeof( vec3s ) * 2 * physics_mesh->vertices.size * k_max_frames;
+            creation.reset().set( VK_BUFFER_USAGE_TRANSFER_SRC_BIT, ResourceUsageType::Stream, buffer_size ).set_name( "cloth_staging_buffer" ).set_persistent( true );
+
+            physics_mesh->cloth_staging_buffer = renderer->gpu->create_buffer( creation );
         }
 
         meshes.push( render_mesh );
@@ -638,6 +648,8 @@ void ObjScene::shutdown( Renderer* renderer ) {
             gpu.destroy_descriptor_set( physics_mesh->debug_mesh_descriptor_set );
 
             physics_mesh->vertices.shutdown();
+            physics_mesh->cloth.shutdown();
+            gpu.destroy_buffer( physics_mesh->cloth_staging_buffer );
 
             resident_allocator->deallocate( physics_mesh );
         }
@@ -1,4 +1,6 @@
 #include "graphics/render_scene.hpp"
+#include "graphics/animation.hpp"
+#include "graphics/skinning.hpp"
 #include "graphics/renderer.hpp"
 #include "graphics/scene_graph.hpp"
 #include "graphics/asynchronous_loader.hpp"
@@ -71,20 +73,32 @@ static void copy_gpu_material_data( GpuDevice& gpu, GpuMaterialData& gpu_mesh_da
     gpu_mesh_data.meshlet_count = mesh.meshlet_count;
     gpu_mesh_data.meshlet_index_count = mesh.meshlet_index_count;
 
+    gpu_mesh_data.lod_count = mesh.lod_count;
+    gpu_mesh_data.lods[ 0 ] = { mesh.meshlet_offset, mesh.meshlet_count, mesh.meshlet_index_count, 0.f };
+    for ( u32 l = 1; l < mesh.lod_count; ++l ) {
+        gpu_mesh_data.lods[ l ] = mesh.lods[ l ];
+    }
+
     gpu_mesh_data.position_buffer = gpu.get_buffer_device_address( mesh.position_buffer ) + mesh.position_offset;
     gpu_mesh_data.uv_buffer = gpu.get_buffer_device_address( mesh.texcoord_buffer ) + mesh.texcoord_offset;
     gpu_mesh_data.index_buffer = gpu.get_buffer_device_address( mesh.index_buffer ) + mesh.index_offset;
     gpu_mesh_data.normals_buffer = gpu.get_buffer_device_address( mesh.normal_buffer ) + mesh.normal_offset;
 }
 
+//
+//
+static mat4s mesh_instance_world( const MeshInstance& mesh_instance, const f32 global_scale, const SceneGraph* scene_graph ) {
+    // Apply global scale matrix
+    // NOTE: for left-handed systems (as defined in cglm) need to invert positive and negative Z.
+    const mat4s scale_matrix = glms_scale_make( { global_scale, global_scale, -global_scale } );
+    return glms_mat4_mul( scale_matrix, scene_graph->world_matrices[ mesh_instance.scene_graph_node_index ] );
+}
+
 //
 //
 static void copy_gpu_mesh_transform( GpuMeshInstanceData& gpu_mesh_data, const MeshInstance& mesh_instance, const f32 global_scale, const SceneGraph* scene_graph ) {
     if ( scene_graph ) {
-        // Apply global scale matrix
-        // NOTE: for left-handed systems (as defined in cglm) need to invert positive and negative Z.
-        const mat4s scale_matrix = glms_scale_make( { global_scale, global_scale, -global_scale } );
-        gpu_mesh_data.world = glms_mat4_mul( scale_matrix, scene_graph->world_matrices[ mesh_instance.scene_graph_node_index ] );
+        gpu_mesh_data.world = mesh_instance_world( mesh_instance, global_scale, scene_graph );
 
         gpu_mesh_data.inverse_world = glms_mat4_inv( glms_mat4_transpose( gpu_mesh_data.world ) );
     } else {
@@ -95,6 +109,31 @@ static void copy_gpu_mesh_transform( GpuMeshInstanceData& gpu_mesh_data, const M
     gpu_mesh_data.mesh_index = mesh_instance.mesh->gpu_mesh_index;
 }
 
+// Levels of detail ///////////////////////////////////////////////////
+u32 mesh_lod_select( const Mesh& mesh, const mat4s& world, const GpuSceneData& scene_data ) {
+    if ( !scene_data.mesh_lods() ) {
+        return 0;
+    }
+
+    const vec4s world_center = glms_mat4_mulv( world, vec4s{ mesh.bounding_sphere.x, mesh.bounding_sphere.y, mesh.bounding_sphere.z, 1.0f } );
+    const vec4s view_center = glms_mat4_mulv( scene_data.world_to_camera, world_center );
+
+    const f32 scale = glms_vec4_norm( world.col[ 0 ] );
+    const f32 distance = raptor::max( glms_vec3_norm( vec3s{ view_center.x, view_center.y, view_center.z } ) - mesh.bounding_sphere.w * scale, scene_data.z_near );
+    // Pixels covered by a world space unit at distance.
+    const f32 pixels_per_unit = scene_data.projection_11 * scene_data.resolution_y * 0.5f / distance;
+
+    u32 lod = 0;
+    for ( u32 l = 1; l < mesh.lod_count; ++l ) {
+        if ( mesh.lods[ l ].error * scale * pixels_per_unit > scene_data.lod_error_pixels ) {
+            break;
+        }
+        lod = l;
+    }
+
+    return lod;
+}
+
 static FrameGraphResource* get_output_texture( FrameGraph* frame_graph, FrameGraphResourceHandle input ) {
     FrameGraphResource* input_resource = frame_graph->access_resource( input );
 
@@ -160,7 +199,7 @@ void DepthPrePass::render( u32 current_frame_index, CommandBuffer* gpu_commands,
 void DepthPrePass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allocator* resident_allocator, StackAllocator* scratch_allocator ) {
     renderer = scene.renderer;
 
-    FrameGraphNode* node = frame_graph->get_node( "depth_pre_pass" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "depth_pre_pass" ) );
     if ( node == nullptr ) {
         enabled = false;
 
@@ -187,7 +226,7 @@ void DepthPrePass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, A
 
         MeshInstanceDraw mesh_instance_draw{};
         mesh_instance_draw.mesh_instance = &mesh_instance;
-        mesh_instance_draw.material_pass_index = mesh->has_skinning() ? main_technique->get_pass_index( "depth_pre_skinning" ) : main_technique->get_pass_index(  "depth_pre" );
+        mesh_instance_draw.material_pass_index = mesh->has_skinning() ? main_technique->get_pass_index( rhashed( "depth_pre_skinning" ) ) : main_technique->get_pass_index( rhashed( "depth_pre" ) );
 
         mesh_instance_draws.push( mesh_instance_draw );
     }
@@ -197,7 +236,7 @@ void DepthPrePass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, A
     // Cache meshlet technique index
     if ( gpu.mesh_shaders_extension_present ) {
         GpuTechnique* main_technique = renderer->resource_cache.techniques.get( hash_calculate( "meshlet" ) );
-        meshlet_technique_index = main_technique->get_pass_index( "depth_pre" );
+        meshlet_technique_index = main_technique->get_pass_index( rhashed( "depth_pre" ) );
     }
 }
 
@@ -231,7 +270,7 @@ void DepthPyramidPass::post_render( u32 current_frame_index, CommandBuffer* gpu_
         u32 width = depth_pyramid_texture->width;
         u32 height = depth_pyramid_texture->height;
 
-        FrameGraphResource* depth_resource = ( FrameGraphResource* )frame_graph->get_resource( "depth" );
+        FrameGraphResource* depth_resource = ( FrameGraphResource* )frame_graph->get_resource( rhashed( "depth" ) );
         TextureHandle depth_handle = depth_resource->resource_info.texture.handle;
         Texture* depth_texture = gpu->access_texture( depth_handle );
 
@@ -266,7 +305,7 @@ void DepthPyramidPass::on_resize( GpuDevice& gpu, FrameGraph* frame_graph, u32 n
         gpu.destroy_texture( depth_pyramid_views[ i ] );
     }
 
-    FrameGraphResource* depth_resource = ( FrameGraphResource* )frame_graph->get_resource( "depth" );
+    FrameGraphResource* depth_resource = ( FrameGraphResource* )frame_graph->get_resource( rhashed( "depth" ) );
     TextureHandle depth_handle = depth_resource->resource_info.texture.handle;
     Texture* depth_texture = gpu.access_texture( depth_handle );
 
@@ -276,7 +315,7 @@ void DepthPyramidPass::on_resize( GpuDevice& gpu, FrameGraph* frame_graph, u32 n
 void DepthPyramidPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allocator* resident_allocator, StackAllocator* scratch_allocator ) {
     renderer = scene.renderer;
 
-    FrameGraphNode* node = frame_graph->get_node( "depth_pyramid_pass" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "depth_pyramid_pass" ) );
     if ( node == nullptr ) {
         enabled = false;
 
@@ -289,7 +328,7 @@ void DepthPyramidPass::prepare_draws( RenderScene& scene, FrameGraph* frame_grap
 
     GpuDevice& gpu = *renderer->gpu;
 
-    FrameGraphResource* depth_resource = ( FrameGraphResource* )frame_graph->get_resource( "depth" );
+    FrameGraphResource* depth_resource = ( FrameGraphResource* )frame_graph->get_resource( rhashed( "depth" ) );
     TextureHandle depth_handle = depth_resource->resource_info.texture.handle;
     Texture* depth_texture = gpu.access_texture( depth_handle );
 
@@ -456,7 +495,7 @@ void GBufferPass::render( u32 current_frame_index, CommandBuffer* gpu_commands,
 void GBufferPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allocator* resident_allocator, StackAllocator* scratch_allocator ) {
     renderer = scene.renderer;
 
-    FrameGraphNode* node = frame_graph->get_node( "gbuffer_pass_early" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "gbuffer_pass_early" ) );
     if ( node == nullptr ) {
         enabled = false;
 
@@ -483,7 +522,7 @@ void GBufferPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Al
 
         MeshInstanceDraw mesh_instance_draw{};
         mesh_instance_draw.mesh_instance = &mesh_instance;
-        mesh_instance_draw.material_pass_index = mesh->has_skinning() ? main_technique->get_pass_index( "gbuffer_skinning" ) : main_technique->get_pass_index( "gbuffer_cull" );
+        mesh_instance_draw.material_pass_index = mesh->has_skinning() ? main_technique->get_pass_index( rhashed( "gbuffer_skinning" ) ) : main_technique->get_pass_index( rhashed( "gbuffer_cull" ) );
 
         mesh_instance_draws.push( mesh_instance_draw );
     }
@@ -491,27 +530,27 @@ void GBufferPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Al
     // Cache meshlet technique index
     GpuTechnique* meshlet_technique = renderer->resource_cache.techniques.get( hash_calculate( "meshlet" ) );
 
-    u32 technique_index = meshlet_technique->get_pass_index( "gbuffer_culling" );
+    u32 technique_index = meshlet_technique->get_pass_index( rhashed( "gbuffer_culling" ) );
     if ( technique_index != u16_max ) {
         meshlet_draw_pipeline = meshlet_technique->passes[ technique_index ].pipeline;
     }
 
-    technique_index = meshlet_technique->get_pass_index( "emulation_gbuffer_culling" );
+    technique_index = meshlet_technique->get_pass_index( rhashed( "emulation_gbuffer_culling" ) );
     meshlet_emulation_draw_pipeline = meshlet_technique->passes[ technique_index ].pipeline;
 
-    technique_index = meshlet_technique->get_pass_index( "generate_meshlet_index_buffer" );
+    technique_index = meshlet_technique->get_pass_index( rhashed( "generate_meshlet_index_buffer" ) );
     GpuTechniquePass& generate_ib_pass = meshlet_technique->passes[ technique_index ];
     generate_meshlet_index_buffer_pipeline = generate_ib_pass.pipeline;
 
-    technique_index = meshlet_technique->get_pass_index( "generate_meshlet_instances" );
+    technique_index = meshlet_technique->get_pass_index( rhashed( "generate_meshlet_instances" ) );
     GpuTechniquePass& generate_inst_pass = meshlet_technique->passes[ technique_index ];
     generate_meshlets_instances_pipeline = generate_inst_pass.pipeline;
 
-    technique_index = meshlet_technique->get_pass_index( "meshlet_instance_culling" );
+    technique_index = meshlet_technique->get_pass_index( rhashed( "meshlet_instance_culling" ) );
     GpuTechniquePass& inst_cull_pass = meshlet_technique->passes[ technique_index ];
     meshlet_instance_culling_pipeline = inst_cull_pass.pipeline;
 
-    technique_index = meshlet_technique->get_pass_index( "meshlet_write_counts" );
+    technique_index = meshlet_technique->get_pass_index( rhashed( "meshlet_write_counts" ) );
     meshlet_write_counts_pipeline = meshlet_technique->passes[ technique_index ].pipeline;
 
     DescriptorSetLayoutHandle layout_generate_ib = renderer->gpu->get_descriptor_set_layout( generate_meshlet_index_buffer_pipeline, k_material_descriptor_set_index );
@@ -576,7 +615,7 @@ void GBufferPass::free_gpu_resources( GpuDevice& gpu ) {
 void LateGBufferPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allocator* resident_allocator, StackAllocator* scratch_allocator ) {
     renderer = scene.renderer;
 
-    FrameGraphNode* node = frame_graph->get_node( "gbuffer_pass_late" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "gbuffer_pass_late" ) );
     if ( node == nullptr ) {
         enabled = false;
 
@@ -603,7 +642,7 @@ void LateGBufferPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph
 
         MeshInstanceDraw mesh_instance_draw{};
         mesh_instance_draw.mesh_instance = &mesh_instance;
-        mesh_instance_draw.material_pass_index = mesh->has_skinning() ? main_technique->get_pass_index( "gbuffer_skinning" ) : main_technique->get_pass_index( "gbuffer_cull" );
+        mesh_instance_draw.material_pass_index = mesh->has_skinning() ? main_technique->get_pass_index( rhashed( "gbuffer_skinning" ) ) : main_technique->get_pass_index( rhashed( "gbuffer_cull" ) );
 
         mesh_instance_draws.push( mesh_instance_draw );
     }
@@ -611,7 +650,7 @@ void LateGBufferPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph
     // Cache meshlet technique index
     if ( renderer->gpu->mesh_shaders_extension_present ) {
         GpuTechnique* main_technique = renderer->resource_cache.techniques.get( hash_calculate( "meshlet" ) );
-        meshlet_technique_index = main_technique->get_pass_index( "gbuffer_culling" );
+        meshlet_technique_index = main_technique->get_pass_index( rhashed( "gbuffer_culling" ) );
     }
 }
 
@@ -683,7 +722,7 @@ void LightPass::on_resize( GpuDevice& gpu, FrameGraph* frame_graph, u32 new_widt
     if ( !enabled )
         return;
 
-    FrameGraphResource* resource = frame_graph->get_resource( "shading_rate_image" );
+    FrameGraphResource* resource = frame_graph->get_resource( rhashed( "shading_rate_image" ) );
     if ( resource ) {
         u32 adjusted_width = ( new_width + gpu.min_fragment_shading_rate_texel_size.width - 1 ) / gpu.min_fragment_shading_rate_texel_size.width;
         u32 adjusted_height = ( new_height + gpu.min_fragment_shading_rate_texel_size.height - 1 ) / gpu.min_fragment_shading_rate_texel_size.height;
@@ -724,7 +763,7 @@ void LightPass::post_render( u32 current_frame_index, CommandBuffer* gpu_command
 void LightPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allocator* resident_allocator, StackAllocator* scratch_allocator ) {
     renderer = scene.renderer;
 
-    FrameGraphNode* node = frame_graph->get_node( "lighting_pass" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "lighting_pass" ) );
     if ( node == nullptr ) {
         enabled = false;
 
@@ -778,7 +817,7 @@ void LightPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allo
     if ( renderer->gpu->fragment_shading_rate_present && !use_compute ) {
         Texture* colour_texture = renderer->gpu->access_texture( color_texture->resource_info.texture.handle );
 
-        u32 frs_pass_index = main_technique->get_pass_index( "edge_detection" );
+        u32 frs_pass_index = main_technique->get_pass_index( rhashed( "edge_detection" ) );
         GpuTechniquePass& pass = main_technique->passes[ frs_pass_index ];
 
         BufferCreation buffer_creation{ };
@@ -806,7 +845,7 @@ void LightPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allo
     {
         scene.renderer->gpu->destroy_descriptor_set( mesh.pbr_material.descriptor_set_transparent );
 
-        const u32 pass_index = use_compute ? main_technique->get_pass_index("deferred_lighting_compute") : main_technique->get_pass_index( "deferred_lighting_pixel");
+        const u32 pass_index = use_compute ? main_technique->get_pass_index( rhashed( "deferred_lighting_compute" ) ) : main_technique->get_pass_index( rhashed( "deferred_lighting_pixel" ) );
         DescriptorSetCreation ds_creation{};
         GpuTechniquePass& pass = main_technique->passes[ pass_index ];
         DescriptorSetLayoutHandle layout = renderer->gpu->get_descriptor_set_layout( pass.pipeline, k_material_descriptor_set_index );
@@ -964,7 +1003,7 @@ void TransparentPass::render( u32 current_frame_index, CommandBuffer* gpu_comman
 void TransparentPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allocator* resident_allocator, StackAllocator* scratch_allocator ) {
     renderer = scene.renderer;
 
-    FrameGraphNode* node = frame_graph->get_node( "transparent_pass" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "transparent_pass" ) );
     if ( node == nullptr ) {
         enabled = false;
 
@@ -990,7 +1029,7 @@ void TransparentPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph
 
         MeshInstanceDraw mesh_instance_draw{};
         mesh_instance_draw.mesh_instance = &mesh_instance;
-        mesh_instance_draw.material_pass_index = mesh->has_skinning() ? main_technique->get_pass_index( "transparent_skinning_no_cull" ) : main_technique->get_pass_index( "transparent_no_cull" );
+        mesh_instance_draw.material_pass_index = mesh->has_skinning() ? main_technique->get_pass_index( rhashed( "transparent_skinning_no_cull" ) ) : main_technique->get_pass_index( rhashed( "transparent_no_cull" ) );
 
         mesh_instance_draws.push( mesh_instance_draw );
     }
@@ -998,7 +1037,7 @@ void TransparentPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph
     // Cache meshlet technique index
     if ( renderer->gpu->mesh_shaders_extension_present ) {
         GpuTechnique* main_technique = renderer->resource_cache.techniques.get( hash_calculate( "meshlet" ) );
-        meshlet_technique_index = main_technique->get_pass_index( "transparent_no_cull" );
+        meshlet_technique_index = main_technique->get_pass_index( rhashed( "transparent_no_cull" ) );
     }
 }
 
@@ -1172,7 +1211,7 @@ void DebugPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allo
     renderer = scene.renderer;
     scene_graph = scene.scene_graph;
 
-    FrameGraphNode* node = frame_graph->get_node( "debug_pass" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "debug_pass" ) );
     if ( node == nullptr ) {
        enabled = false;
 
@@ -1391,7 +1430,7 @@ void DebugPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allo
         DescriptorSetCreation descriptor_set_creation{ };
 
         // Finalize pass
-        u32 pass_index = main_technique->get_pass_index( "commands_finalize" );
+        u32 pass_index = main_technique->get_pass_index( rhashed( "commands_finalize" ) );
         GpuTechniquePass& pass = main_technique->passes[ pass_index ];
         debug_lines_finalize_pipeline = pass.pipeline;
         DescriptorSetLayoutHandle layout = renderer->gpu->get_descriptor_set_layout( pass.pipeline, k_material_descriptor_set_index );
@@ -1403,7 +1442,7 @@ void DebugPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allo
         debug_lines_finalize_set = renderer->gpu->create_descriptor_set( set_creation );
 
         // Draw pass
-        pass_index = main_technique->get_pass_index( "debug_line_gpu" );
+        pass_index = main_technique->get_pass_index( rhashed( "debug_line_gpu" ) );
         GpuTechniquePass& line_gpu_pass = main_technique->passes[ pass_index ];
         debug_lines_draw_pipeline = main_technique->passes[ pass_index ].pipeline;
         layout = renderer->gpu->get_descriptor_set_layout( line_gpu_pass.pipeline, k_material_descriptor_set_index );
@@ -1413,7 +1452,7 @@ void DebugPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allo
         scene.add_debug_descriptors( set_creation, line_gpu_pass );
         debug_lines_draw_set = renderer->gpu->create_descriptor_set( set_creation );
 
-        pass_index = main_technique->get_pass_index( "debug_line_2d_gpu" );
+        pass_index = main_technique->get_pass_index( rhashed( "debug_line_2d_gpu" ) );
         GpuTechniquePass& line_2d_gpu_pass = main_technique->passes[ pass_index ];
         debug_lines_2d_draw_pipeline = line_2d_gpu_pass.pipeline;
 
@@ -1458,7 +1497,7 @@ void DebugPass::update_dependent_resources( GpuDevice& gpu, FrameGraph* frame_gr
         gpu.destroy_descriptor_set( gi_debug_probes_descriptor_set );
 
         // Probe raytracing
-        u32 pass_index = technique->get_pass_index( "debug_mesh" );
+        u32 pass_index = technique->get_pass_index( rhashed( "debug_mesh" ) );
         GpuTechniquePass& pass = technique->passes[ pass_index ];
 
         gi_debug_probes_pipeline = pass.pipeline;
@@ -1485,7 +1524,7 @@ void DoFPass::add_ui() {
 
 void DoFPass::pre_render( u32 current_frame_index, CommandBuffer* gpu_commands, FrameGraph* frame_graph, RenderScene* render_scene ) {
 
-    FrameGraphResource* texture = ( FrameGraphResource* )frame_graph->get_resource( "lighting" );
+    FrameGraphResource* texture = ( FrameGraphResource* )frame_graph->get_resource( rhashed( "lighting" ) );
     RASSERT( texture != nullptr );
 
     gpu_commands->copy_texture( texture->resource_info.texture.handle, scene_mips->handle, RESOURCE_STATE_PIXEL_SHADER_RESOURCE );
@@ -1533,7 +1572,7 @@ void DoFPass::on_resize( GpuDevice& gpu, FrameGraph* frame_graph, u32 new_width,
 void DoFPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allocator* resident_allocator, StackAllocator* scratch_allocator ) {
     renderer = scene.renderer;
 
-    FrameGraphNode* node = frame_graph->get_node( "depth_of_field_pass" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "depth_of_field_pass" ) );
     if ( node == nullptr ) {
         enabled = false;
 
@@ -1695,7 +1734,7 @@ void CullingEarlyPass::render( u32 current_frame_index, CommandBuffer* gpu_comma
 
 void CullingEarlyPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allocator* resident_allocator, StackAllocator* scratch_allocator ) {
 
-    FrameGraphNode* node = frame_graph->get_node( "mesh_occlusion_early_pass" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "mesh_occlusion_early_pass" ) );
     if ( node == nullptr ) {
         enabled = false;
 
@@ -1710,7 +1749,7 @@ void CullingEarlyPass::prepare_draws( RenderScene& scene, FrameGraph* frame_grap
     // Cache frustum cull shader
     GpuTechnique* culling_technique = renderer->resource_cache.techniques.get( hash_calculate( "culling" ) );
     {
-        u32 pipeline_index = culling_technique->get_pass_index( "gpu_mesh_culling" );
+        u32 pipeline_index = culling_technique->get_pass_index( rhashed( "gpu_mesh_culling" ) );
         GpuTechniquePass& pass = culling_technique->passes[ pipeline_index ];
         frustum_cull_pipeline = pass.pipeline;
         DescriptorSetLayoutHandle layout = gpu.get_descriptor_set_layout( frustum_cull_pipeline, k_material_descriptor_set_index );
@@ -1788,7 +1827,7 @@ void CullingLatePass::render( u32 current_frame_index, CommandBuffer* gpu_comman
 
 void CullingLatePass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allocator* resident_allocator, StackAllocator* scratch_allocator ) {
 
-    FrameGraphNode* node = frame_graph->get_node( "mesh_occlusion_late_pass" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "mesh_occlusion_late_pass" ) );
     if ( node == nullptr ) {
         enabled = false;
 
@@ -1858,7 +1897,7 @@ void RayTracingTestPass::on_resize( GpuDevice& gpu, FrameGraph* frame_graph, u32
 }
 
 void RayTracingTestPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allocator* resident_allocator, StackAllocator* scratch_allocator ) {
-    FrameGraphNode* node = frame_graph->get_node( "ray_tracing_test" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "ray_tracing_test" ) );
     if ( node == nullptr ) {
         enabled = false;
 
@@ -2081,7 +2120,7 @@ void ShadowVisibilityPass::recreate_textures( GpuDevice& gpu, u32 lights_count )
 }
 
 void ShadowVisibilityPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allocator* resident_allocator, StackAllocator* scratch_allocator ) {
-    FrameGraphNode* node = frame_graph->get_node( "shadow_visibility_pass" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "shadow_visibility_pass" ) );
     if ( node == nullptr ) {
         enabled = false;
 
@@ -2117,15 +2156,15 @@ void ShadowVisibilityPass::prepare_draws( RenderScene& scene, FrameGraph* frame_
 
     GpuTechnique* technique = renderer->resource_cache.techniques.get( hash_calculate( "pbr_lighting" ) );
 
-    u32 pass_index = technique->get_pass_index( "shadow_visibility_variance" );
+    u32 pass_index = technique->get_pass_index( rhashed( "shadow_visibility_variance" ) );
     GpuTechniquePass& variance_pass = technique->passes[ pass_index ];
     variance_pipeline = variance_pass.pipeline;
 
-    pass_index = technique->get_pass_index( "shadow_visibility" );
+    pass_index = technique->get_pass_index( rhashed( "shadow_visibility" ) );
     GpuTechniquePass& visiblity_pass = technique->passes[ pass_index ];
     visibility_pipeline = visiblity_pass.pipeline;
 
-    pass_index = technique->get_pass_index( "shadow_visibility_filtering" );
+    pass_index = technique->get_pass_index( rhashed( "shadow_visibility_filtering" ) );
     GpuTechniquePass& visiblity_filtering_pass = technique->passes[ pass_index ];
     visibility_filtering_pipeline = visiblity_filtering_pass.pipeline;
 
@@ -2141,7 +2180,7 @@ void ShadowVisibilityPass::prepare_draws( RenderScene& scene, FrameGraph* frame_
         descriptor_set[ i ] = renderer->gpu->create_descriptor_set( ds_creation );
     }
 
-    FrameGraphResource* resource = frame_graph->get_resource( "gbuffer_normals" );
+    FrameGraphResource* resource = frame_graph->get_resource( rhashed( "gbuffer_normals" ) );
     RASSERT( resource != nullptr );
     normals_texture = resource->resource_info.texture.handle;
 }
@@ -2193,7 +2232,7 @@ void ShadowVisibilityPass::update_dependent_resources( GpuDevice& gpu, FrameGrap
 
     GpuTechnique* technique = renderer->resource_cache.techniques.get( hash_calculate( "pbr_lighting" ) );
 
-    u32 pass_index = technique->get_pass_index( "shadow_visibility_variance" );
+    u32 pass_index = technique->get_pass_index( rhashed( "shadow_visibility_variance" ) );
     GpuTechniquePass& variance_pass = technique->passes[ pass_index ];
 
     for ( u32 i = 0; i < k_max_frames; ++i ) {
@@ -2721,7 +2760,7 @@ void PointlightShadowPass::prepare_draws( RenderScene& scene, FrameGraph* frame_
                                           Allocator* resident_allocator, StackAllocator* scratch_allocator ) {
     renderer = scene.renderer;
 
-    FrameGraphNode* node = frame_graph->get_node( "point_shadows_pass" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "point_shadows_pass" ) );
     if ( node == nullptr ) {
         enabled = false;
 
@@ -2759,7 +2798,7 @@ void PointlightShadowPass::prepare_draws( RenderScene& scene, FrameGraph* frame_
     const u64 hashed_name = hash_calculate( "main" );
     GpuTechnique* main_technique = renderer->resource_cache.techniques.get( hashed_name );
 
-    const u32 depth_cubemap_pass_index = main_technique->get_pass_index( "depth_cubemap" );
+    const u32 depth_cubemap_pass_index = main_technique->get_pass_index( rhashed( "depth_cubemap" ) );
 
     mesh_instance_draws.init( resident_allocator, 16 );
 
@@ -2785,7 +2824,7 @@ void PointlightShadowPass::prepare_draws( RenderScene& scene, FrameGraph* frame_
 
     // Meshlet culling
     {
-        u32 pass_index = meshlet_technique->get_pass_index( "meshlet_pointshadows_culling" );
+        u32 pass_index = meshlet_technique->get_pass_index( rhashed( "meshlet_pointshadows_culling" ) );
         GpuTechniquePass& pass = meshlet_technique->passes[ pass_index ];
 
         meshlet_culling_pipeline = pass.pipeline;
@@ -2813,7 +2852,7 @@ void PointlightShadowPass::prepare_draws( RenderScene& scene, FrameGraph* frame_
     }
     // Meshlet command writing
     {
-        u32 pass_index = meshlet_technique->get_pass_index( "meshlet_pointshadows_commands_generation" );
+        u32 pass_index = meshlet_technique->get_pass_index( rhashed( "meshlet_pointshadows_commands_generation" ) );
         GpuTechniquePass& pass = meshlet_technique->passes[ pass_index ];
 
         meshlet_write_commands_pipeline = pass.pipeline;
@@ -2833,7 +2872,7 @@ void PointlightShadowPass::prepare_draws( RenderScene& scene, FrameGraph* frame_
     }
     // Meshlet drawing
     if ( gpu.mesh_shaders_extension_present ) {
-        u32 pass_index = meshlet_technique->get_pass_index( "depth_cubemap" );
+        u32 pass_index = meshlet_technique->get_pass_index( rhashed( "depth_cubemap" ) );
         // Cubemap rendering
         cubemap_meshlets_pipeline = meshlet_technique->passes[ pass_index ].pipeline;
 
@@ -2850,13 +2889,13 @@ void PointlightShadowPass::prepare_draws( RenderScene& scene, FrameGraph* frame_
         }
 
         // Tetrahedron rendering
-        pass_index = meshlet_technique->get_pass_index( "depth_tetrahedron" );
+        pass_index = meshlet_technique->get_pass_index( rhashed( "depth_tetrahedron" ) );
 
         tetrahedron_meshlet_pipeline = meshlet_technique->passes[ pass_index ].pipeline;
     }
     // Shadow resolution computation
     {
-        u32 pass_index = meshlet_technique->get_pass_index( "pointshadows_resolution_calculation" );
+        u32 pass_index = meshlet_technique->get_pass_index( rhashed( "pointshadows_resolution_calculation" ) );
 
         GpuTechniquePass& pass = meshlet_technique->passes[ pass_index ];
         shadow_resolution_pipeline = pass.pipeline;
@@ -3113,7 +3152,7 @@ void VolumetricFogPass::prepare_draws( RenderScene& scene, FrameGraph* frame_gra
 
     renderer = scene.renderer;
 
-    FrameGraphNode* node = frame_graph->get_node( "volumetric_fog_pass" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "volumetric_fog_pass" ) );
     if ( node == nullptr ) {
         enabled = false;
 
@@ -3162,7 +3201,7 @@ void VolumetricFogPass::prepare_draws( RenderScene& scene, FrameGraph* frame_gra
     GpuTechnique* technique = renderer->resource_cache.techniques.get( hash_calculate( "volumetric_fog" ) );
     if ( technique ) {
         // Inject Data
-        u32 pass_index = technique->get_pass_index( "inject_data" );
+        u32 pass_index = technique->get_pass_index( rhashed( "inject_data" ) );
         GpuTechniquePass& inject_data_pass = technique->passes[ pass_index ];
 
         inject_data_pipeline = inject_data_pass.pipeline;
@@ -3177,28 +3216,28 @@ void VolumetricFogPass::prepare_draws( RenderScene& scene, FrameGraph* frame_gra
         fog_descriptor_set = gpu.create_descriptor_set( ds_creation );
 
         // Light integration
-        pass_index = technique->get_pass_index( "light_integration" );
+        pass_index = technique->get_pass_index( rhashed( "light_integration" ) );
         GpuTechniquePass& light_integration_pass = technique->passes[ pass_index ];
 
         light_integration_pipeline = light_integration_pass.pipeline;
 
-        pass_index = technique->get_pass_index( "spatial_filtering" );
+        pass_index = technique->get_pass_index( rhashed( "spatial_filtering" ) );
         GpuTechniquePass& spatial_filtering_pass = technique->passes[ pass_index ];
 
         spatial_filtering_pipeline = spatial_filtering_pass.pipeline;
 
-        pass_index = technique->get_pass_index( "temporal_filtering" );
+        pass_index = technique->get_pass_index( rhashed( "temporal_filtering" ) );
         GpuTechniquePass& temporal_filtering_pass = technique->passes[ pass_index ];
 
         temporal_filtering_pipeline = temporal_filtering_pass.pipeline;
 
-        pass_index = technique->get_pass_index( "volumetric_noise_baking" );
+        pass_index = technique->get_pass_index( rhashed( "volumetric_noise_baking" ) );
         GpuTechniquePass& noise_baking_pass = technique->passes[ pass_index ];
 
         volumetric_noise_baking = noise_baking_pass.pipeline;
 
         // Light scattering
-        pass_index = technique->get_pass_index( "light_scattering" );
+        pass_index = technique->get_pass_index( rhashed( "light_scattering" ) );
         GpuTechniquePass& light_scattering_pass = technique->passes[ pass_index ];
 
         light_scattering_pipeline = light_scattering_pass.pipeline;
@@ -3301,7 +3340,7 @@ void VolumetricFogPass::update_dependent_resources( GpuDevice& gpu, FrameGraph*
     GpuTechnique* technique = renderer->resource_cache.techniques.get( hash_calculate( "volumetric_fog" ) );
     if ( technique ) {
         // Light scattering
-        u32 pass_index = technique->get_pass_index( "light_scattering" );
+        u32 pass_index = technique->get_pass_index( rhashed( "light_scattering" ) );
         GpuTechniquePass& pass = technique->passes[ pass_index ];
 
         DescriptorSetLayoutHandle light_scattering_layout = gpu.get_descriptor_set_layout( light_scattering_pipeline, k_material_descriptor_set_index );
@@ -3333,7 +3372,7 @@ void TemporalAntiAliasingPass::pre_render( u32 current_frame_index, CommandBuffe
     // TODO: fix.
     temp_taa_output = history_textures[ current_history_texture_index ];
 
-    FrameGraphResource* resource = frame_graph->get_resource( "final" );
+    FrameGraphResource* resource = frame_graph->get_resource( rhashed( "final" ) );
     if ( resource ) {
         current_color_texture = resource->resource_info.texture.handle;
     }
@@ -3360,7 +3399,7 @@ void TemporalAntiAliasingPass::prepare_draws( RenderScene& scene, FrameGraph* fr
 
     renderer = scene.renderer;
 
-    FrameGraphNode* node = frame_graph->get_node( "temporal_anti_aliasing_pass" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "temporal_anti_aliasing_pass" ) );
     if ( node == nullptr ) {
         enabled = false;
 
@@ -3385,7 +3424,7 @@ void TemporalAntiAliasingPass::prepare_draws( RenderScene& scene, FrameGraph* fr
 
     GpuTechnique* technique = renderer->resource_cache.techniques.get( hash_calculate( "fullscreen" ) );
     if ( technique ) {
-        u32 pass_index = technique->get_pass_index( "temporal_aa" );
+        u32 pass_index = technique->get_pass_index( rhashed( "temporal_aa" ) );
         GpuTechniquePass& pass = technique->passes[ pass_index ];
 
         taa_pipeline = pass.pipeline;
@@ -3472,7 +3511,7 @@ void MotionVectorPass::on_resize( GpuDevice& gpu, FrameGraph* frame_graph, u32 n
 void MotionVectorPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allocator* resident_allocator, StackAllocator* scratch_allocator ) {
     renderer = scene.renderer;
 
-    FrameGraphNode* node = frame_graph->get_node( "motion_vector_pass" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "motion_vector_pass" ) );
     if ( node == nullptr ) {
         enabled = false;
 
@@ -3485,10 +3524,10 @@ void MotionVectorPass::prepare_draws( RenderScene& scene, FrameGraph* frame_grap
 
     GpuTechnique* technique = renderer->resource_cache.techniques.get( hash_calculate( "fullscreen" ) );
     if ( technique ) {
-        FrameGraphResource* gubffer_normals_resource = frame_graph->get_resource( "gbuffer_normals" );
+        FrameGraphResource* gubffer_normals_resource = frame_graph->get_resource( rhashed( "gbuffer_normals" ) );
         RASSERT( gubffer_normals_resource != nullptr );
 
-        u32 pass_index = technique->get_pass_index( "composite_camera_motion" );
+        u32 pass_index = technique->get_pass_index( rhashed( "composite_camera_motion" ) );
         GpuTechniquePass& pass = technique->passes[ pass_index ];
 
         camera_composite_pipeline = pass.pipeline;
@@ -3525,10 +3564,10 @@ void MotionVectorPass::update_dependent_resources( GpuDevice& gpu, FrameGraph* f
 
     GpuTechnique* technique = renderer->resource_cache.techniques.get( hash_calculate( "fullscreen" ) );
     if ( technique ) {
-        FrameGraphResource* gubffer_normals_resource = frame_graph->get_resource( "gbuffer_normals" );
+        FrameGraphResource* gubffer_normals_resource = frame_graph->get_resource( rhashed( "gbuffer_normals" ) );
         RASSERT( gubffer_normals_resource != nullptr );
 
-        u32 pass_index = technique->get_pass_index( "composite_camera_motion" );
+        u32 pass_index = technique->get_pass_index( rhashed( "composite_camera_motion" ) );
         GpuTechniquePass& pass = technique->passes[ pass_index ];
 
         DescriptorSetLayoutHandle common_layout = gpu.get_descriptor_set_layout( camera_composite_pipeline, k_material_descriptor_set_index );
@@ -3693,7 +3732,7 @@ void IndirectPass::on_resize( GpuDevice& gpu, FrameGraph* frame_graph, u32 new_w
 void IndirectPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allocator* resident_allocator, StackAllocator* scratch_allocator ) {
     renderer = scene.renderer;
 
-    FrameGraphNode* node = frame_graph->get_node( "indirect_lighting_pass" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "indirect_lighting_pass" ) );
     if ( node == nullptr ) {
         enabled = false;
 
@@ -3735,7 +3774,7 @@ void IndirectPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, A
 
     indirect_texture = gpu.create_texture( texture_creation );
 
-    FrameGraphResource* resource = frame_graph->get_resource( "indirect_lighting" );
+    FrameGraphResource* resource = frame_graph->get_resource( rhashed( "indirect_lighting" ) );
     resource->resource_info.set_external_texture_2d( adjusted_width, adjusted_height, VK_FORMAT_R16G16B16A16_SFLOAT, 0, indirect_texture );
 
     // Radiance texture
@@ -3763,21 +3802,21 @@ void IndirectPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, A
     probe_offsets_texture = gpu.create_texture( texture_creation );
 
     // Cache normals texture
-    resource = frame_graph->get_resource( "gbuffer_normals" );
+    resource = frame_graph->get_resource( rhashed( "gbuffer_normals" ) );
     normals_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "depth" );
+    resource = frame_graph->get_resource( rhashed( "depth" ) );
     depth_fullscreen_texture = resource->resource_info.texture.handle;
 
     // TODO: at this point this resource is not created still.
     // Use manual assignment in FrameRenderer::upload_gpu_data as occlusion passes.
-    //resource = frame_graph->get_resource( "depth_pyramid" );
+    //resource = frame_graph->get_resource( rhashed( "depth_pyramid" ) );
     //depth_pyramid_texture = resource->resource_info.texture.handle;
 
     GpuTechnique* technique = renderer->resource_cache.techniques.get( hash_calculate( "ddgi" ) );
     if ( technique ) {
         // Probe raytracing
-        u32 pass_index = technique->get_pass_index( "probe_rt" );
+        u32 pass_index = technique->get_pass_index( rhashed( "probe_rt" ) );
         GpuTechniquePass& pass = technique->passes[ pass_index ];
 
         probe_raytrace_pipeline = pass.pipeline;
@@ -3792,7 +3831,7 @@ void IndirectPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, A
         probe_raytrace_descriptor_set = gpu.create_descriptor_set( ds_creation );
 
         // Probe update irradiance
-        pass_index = technique->get_pass_index( "probe_update_irradiance" );
+        pass_index = technique->get_pass_index( rhashed( "probe_update_irradiance" ) );
         GpuTechniquePass& pass1 = technique->passes[ pass_index ];
 
         probe_grid_update_irradiance_pipeline = pass1.pipeline;
@@ -3804,25 +3843,25 @@ void IndirectPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, A
         probe_grid_update_descriptor_set = gpu.create_descriptor_set( ds_creation );
 
         // Probe update visibility
-        pass_index = technique->get_pass_index( "probe_update_visibility" );
+        pass_index = technique->get_pass_index( rhashed( "probe_update_visibility" ) );
         GpuTechniquePass& pass2 = technique->passes[ pass_index ];
 
         probe_grid_update_visibility_pipeline = pass2.pipeline;
 
         // Calculate probe offsets
-        pass_index = technique->get_pass_index( "calculate_probe_offsets" );
+        pass_index = technique->get_pass_index( rhashed( "calculate_probe_offsets" ) );
         GpuTechniquePass& pass3 = technique->passes[ pass_index ];
 
         calculate_probe_offset_pipeline = pass3.pipeline;
 
         // Calculate probe statuses. Used after initial probe offsets
-        pass_index = technique->get_pass_index( "calculate_probe_statuses" );
+        pass_index = technique->get_pass_index( rhashed( "calculate_probe_statuses" ) );
         GpuTechniquePass& pass4 = technique->passes[ pass_index ];
 
         calculate_probe_statuses_pipeline = pass4.pipeline;
 
         // Sample irradiance
-        pass_index = technique->get_pass_index( "sample_irradiance" );
+        pass_index = technique->get_pass_index( rhashed( "sample_irradiance" ) );
         GpuTechniquePass& pass5 = technique->passes[ pass_index ];
 
         sample_irradiance_pipeline = pass5.pipeline;
@@ -3967,7 +4006,7 @@ void ReflectionsPass::on_resize( GpuDevice& gpu, FrameGraph* frame_graph, u32 ne
 void ReflectionsPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allocator* resident_allocator, StackAllocator* scratch_allocator ) {
     renderer = scene.renderer;
 
-    FrameGraphNode* node = frame_graph->get_node( "reflections_pass" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "reflections_pass" ) );
     if ( node == nullptr ) {
         enabled = false;
 
@@ -3986,13 +4025,13 @@ void ReflectionsPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph
     reflections_constants_buffer = gpu.create_buffer( buffer_creation );
 
     // Cache normals texture
-    FrameGraphResource* resource = frame_graph->get_resource( "gbuffer_normals" );
+    FrameGraphResource* resource = frame_graph->get_resource( rhashed( "gbuffer_normals" ) );
     normals_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "gbuffer_occlusion_roughness_metalness" );
+    resource = frame_graph->get_resource( rhashed( "gbuffer_occlusion_roughness_metalness" ) );
     roughness_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "indirect_lighting" );
+    resource = frame_graph->get_resource( rhashed( "indirect_lighting" ) );
     indirect_texture = resource->resource_info.texture.handle;
 
     texture_scale = scene.rt_reflections_scale;
@@ -4004,7 +4043,7 @@ void ReflectionsPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph
 
     reflections_texture = gpu.create_texture( texture_creation );
 
-    resource = frame_graph->get_resource( "reflections" );
+    resource = frame_graph->get_resource( rhashed( "reflections" ) );
     resource->resource_info.set_external_texture_2d( adjusted_width, adjusted_height, VK_FORMAT_B10G11R11_UFLOAT_PACK32, 0, reflections_texture );
 
     // Create BRDF Lut texture
@@ -4017,7 +4056,7 @@ void ReflectionsPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph
     GpuTechnique* technique = renderer->resource_cache.techniques.get( hash_calculate( "reflections" ) );
     if ( technique ) {
         // Probe raytracing
-        u32 pass_index = technique->get_pass_index( "reflections_rt" );
+        u32 pass_index = technique->get_pass_index( rhashed( "reflections_rt" ) );
         GpuTechniquePass& pass = technique->passes[ pass_index ];
 
         reflections_pipeline = pass.pipeline;
@@ -4033,7 +4072,7 @@ void ReflectionsPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph
         reflections_descriptor_set = gpu.create_descriptor_set( ds_creation );
 
         // BRDF LUT generation
-        pass_index = technique->get_pass_index( "brdf_lut_generation" );
+        pass_index = technique->get_pass_index( rhashed( "brdf_lut_generation" ) );
         GpuTechniquePass& brdf_lut_pass = technique->passes[ pass_index ];
 
         brdf_lut_generation_pipeline = brdf_lut_pass.pipeline;
@@ -4096,7 +4135,7 @@ void ReflectionsPass::update_dependent_resources( GpuDevice& gpu, FrameGraph* fr
         gpu.destroy_descriptor_set( reflections_descriptor_set );
 
         // Probe raytracing
-        u32 pass_index = technique->get_pass_index( "reflections_rt" );
+        u32 pass_index = technique->get_pass_index( rhashed( "reflections_rt" ) );
         GpuTechniquePass& pass = technique->passes[ pass_index ];
 
         reflections_pipeline = pass.pipeline;
@@ -4113,7 +4152,7 @@ void ReflectionsPass::update_dependent_resources( GpuDevice& gpu, FrameGraph* fr
 
         gpu.destroy_descriptor_set( brdf_lut_generation_descriptor_set );
         // BRDF LUT generation
-        pass_index = technique->get_pass_index( "brdf_lut_generation" );
+        pass_index = technique->get_pass_index( rhashed( "brdf_lut_generation" ) );
         GpuTechniquePass& brdf_lut_pass = technique->passes[ pass_index ];
 
         brdf_lut_generation_pipeline = brdf_lut_pass.pipeline;
@@ -4189,7 +4228,7 @@ void SVGFAccumulationPass::on_resize( GpuDevice& gpu, FrameGraph* frame_graph, u
 void SVGFAccumulationPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allocator* resident_allocator, StackAllocator* scratch_allocator ) {
     renderer = scene.renderer;
 
-    FrameGraphNode* node = frame_graph->get_node( "svgf_accumulation_pass" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "svgf_accumulation_pass" ) );
     if ( node == nullptr ) {
         enabled = false;
 
@@ -4210,31 +4249,31 @@ void SVGFAccumulationPass::prepare_draws( RenderScene& scene, FrameGraph* frame_
     gpu_constants = gpu.create_buffer( buffer_creation );
 
     // NOTE(marco): cache textures from previous passes
-    FrameGraphResource* resource = frame_graph->get_resource( "gbuffer_normals" );
+    FrameGraphResource* resource = frame_graph->get_resource( rhashed( "gbuffer_normals" ) );
     normals_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "depth" );
+    resource = frame_graph->get_resource( rhashed( "depth" ) );
     depth_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "mesh_id" );
+    resource = frame_graph->get_resource( rhashed( "mesh_id" ) );
     mesh_id_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "motion_vectors" );
+    resource = frame_graph->get_resource( rhashed( "motion_vectors" ) );
     motion_vectors_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "reflections" );
+    resource = frame_graph->get_resource( rhashed( "reflections" ) );
     reflections_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "depth_normal_fwidth" );
+    resource = frame_graph->get_resource( rhashed( "depth_normal_fwidth" ) );
     depth_normal_fwidth_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "linear_z_dd" );
+    resource = frame_graph->get_resource( rhashed( "linear_z_dd" ) );
     linear_z_dd_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "integrated_reflection_color" );
+    resource = frame_graph->get_resource( rhashed( "integrated_reflection_color" ) );
     integrated_color_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "integrated_moments" );
+    resource = frame_graph->get_resource( rhashed( "integrated_moments" ) );
     integrated_moments_texture = resource->resource_info.texture.handle;
 
     TextureCreation texture_creation{ };
@@ -4244,33 +4283,33 @@ void SVGFAccumulationPass::prepare_draws( RenderScene& scene, FrameGraph* frame_
 
     reflections_history_texture = gpu.create_texture( texture_creation );
 
-    resource = frame_graph->get_resource( "reflections_history" );
+    resource = frame_graph->get_resource( rhashed( "reflections_history" ) );
     resource->resource_info.set_external_texture_2d( adjusted_width, adjusted_height, VK_FORMAT_B10G11R11_UFLOAT_PACK32, 0, reflections_history_texture );
 
     texture_creation.set_format_type( VK_FORMAT_R16G16_SFLOAT, TextureType::Texture2D ).set_name( "moments_history" );
     moments_history_texture = gpu.create_texture( texture_creation );
-    resource = frame_graph->get_resource( "moments_history" );
+    resource = frame_graph->get_resource( rhashed( "moments_history" ) );
     resource->resource_info.set_external_texture_2d( adjusted_width, adjusted_height, VK_FORMAT_R16G16_SFLOAT, 0, moments_history_texture );
 
     texture_creation.set_name( "normals_history" );
     last_frame_normals_texture = gpu.create_texture( texture_creation );
-    resource = frame_graph->get_resource( "normals_history" );
+    resource = frame_graph->get_resource( rhashed( "normals_history" ) );
     resource->resource_info.set_external_texture_2d( adjusted_width, adjusted_height, VK_FORMAT_R16G16_SFLOAT, 0, last_frame_normals_texture );
 
     texture_creation.set_name( "linear_depth_history" );
     last_frame_linear_depth_texture = gpu.create_texture( texture_creation );
-    resource = frame_graph->get_resource( "depth_history" );
+    resource = frame_graph->get_resource( rhashed( "depth_history" ) );
     resource->resource_info.set_external_texture_2d( adjusted_width, adjusted_height, VK_FORMAT_R16G16_SFLOAT, 0, last_frame_linear_depth_texture );
 
     texture_creation.set_format_type( VK_FORMAT_R32_UINT, TextureType::Texture2D ).set_name( "mesh_id_history" );
     last_frame_mesh_id_texture = gpu.create_texture( texture_creation );
-    resource = frame_graph->get_resource( "mesh_id_history" );
+    resource = frame_graph->get_resource( rhashed( "mesh_id_history" ) );
     resource->resource_info.set_external_texture_2d( adjusted_width, adjusted_height, VK_FORMAT_R32_UINT, 0, last_frame_mesh_id_texture );
 
     GpuTechnique* technique = renderer->resource_cache.techniques.get( hash_calculate( "reflections" ) );
     if ( technique ) {
         // Probe raytracing
-        u32 pass_index = technique->get_pass_index( "svgf_accumulation" );
+        u32 pass_index = technique->get_pass_index( rhashed( "svgf_accumulation" ) );
         GpuTechniquePass& pass = technique->passes[ pass_index ];
 
         pipeline = pass.pipeline;
@@ -4345,7 +4384,7 @@ void SVGFAccumulationPass::reload_shaders( RenderScene& scene, FrameGraph* frame
         gpu.destroy_descriptor_set( descriptor_set );
 
         // Probe raytracing
-        u32 pass_index = technique->get_pass_index( "svgf_accumulation" );
+        u32 pass_index = technique->get_pass_index( rhashed( "svgf_accumulation" ) );
         GpuTechniquePass& pass = technique->passes[ pass_index ];
 
         pipeline = pass.pipeline;
@@ -4415,7 +4454,7 @@ void SVGFVariancePass::on_resize( GpuDevice& gpu, FrameGraph* frame_graph, u32 n
 void SVGFVariancePass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allocator* resident_allocator, StackAllocator* scratch_allocator ) {
     renderer = scene.renderer;
 
-    FrameGraphNode* node = frame_graph->get_node( "svgf_variance_pass" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "svgf_variance_pass" ) );
     if ( node == nullptr ) {
         enabled = false;
 
@@ -4436,55 +4475,55 @@ void SVGFVariancePass::prepare_draws( RenderScene& scene, FrameGraph* frame_grap
     gpu_constants = gpu.create_buffer( buffer_creation );
 
     // NOTE(marco): cache textures from previous passes
-    FrameGraphResource* resource = frame_graph->get_resource( "gbuffer_normals" );
+    FrameGraphResource* resource = frame_graph->get_resource( rhashed( "gbuffer_normals" ) );
     normals_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "depth" );
+    resource = frame_graph->get_resource( rhashed( "depth" ) );
     depth_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "mesh_id" );
+    resource = frame_graph->get_resource( rhashed( "mesh_id" ) );
     mesh_id_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "motion_vectors" );
+    resource = frame_graph->get_resource( rhashed( "motion_vectors" ) );
     motion_vectors_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "reflections" );
+    resource = frame_graph->get_resource( rhashed( "reflections" ) );
     reflections_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "depth_normal_fwidth" );
+    resource = frame_graph->get_resource( rhashed( "depth_normal_fwidth" ) );
     depth_normal_fwidth_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "linear_z_dd" );
+    resource = frame_graph->get_resource( rhashed( "linear_z_dd" ) );
     linear_z_dd_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "integrated_reflection_color" );
+    resource = frame_graph->get_resource( rhashed( "integrated_reflection_color" ) );
     integrated_color_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "integrated_moments" );
+    resource = frame_graph->get_resource( rhashed( "integrated_moments" ) );
     integrated_moments_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "svgf_variance" );
+    resource = frame_graph->get_resource( rhashed( "svgf_variance" ) );
     variance_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "reflections_history" );
+    resource = frame_graph->get_resource( rhashed( "reflections_history" ) );
     reflections_history_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "moments_history" );
+    resource = frame_graph->get_resource( rhashed( "moments_history" ) );
     moments_history_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "normals_history" );
+    resource = frame_graph->get_resource( rhashed( "normals_history" ) );
     last_frame_normals_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "mesh_id_history" );
+    resource = frame_graph->get_resource( rhashed( "mesh_id_history" ) );
     last_frame_mesh_id_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "depth_history" );
+    resource = frame_graph->get_resource( rhashed( "depth_history" ) );
     last_frame_linear_depth_texture = resource->resource_info.texture.handle;
 
     GpuTechnique* technique = renderer->resource_cache.techniques.get( hash_calculate( "reflections" ) );
     if ( technique ) {
         
-        u32 pass_index = technique->get_pass_index( "svgf_variance" );
+        u32 pass_index = technique->get_pass_index( rhashed( "svgf_variance" ) );
         GpuTechniquePass& pass = technique->passes[ pass_index ];
 
         pipeline = pass.pipeline;
@@ -4497,7 +4536,7 @@ void SVGFVariancePass::prepare_draws( RenderScene& scene, FrameGraph* frame_grap
         descriptor_set = gpu.create_descriptor_set( ds_creation );
 
         // Downsample pipeline
-        pass_index = technique->get_pass_index( "svgf_downsample" );
+        pass_index = technique->get_pass_index( rhashed( "svgf_downsample" ) );
         GpuTechniquePass& downsample_pass = technique->passes[ pass_index ];
 
         downsample_pipeline = downsample_pass.pipeline;
@@ -4564,7 +4603,7 @@ void SVGFVariancePass::reload_shaders( RenderScene& scene, FrameGraph* frame_gra
         GpuDevice& gpu = *renderer->gpu;
         gpu.destroy_descriptor_set( descriptor_set );
         
-        u32 pass_index = technique->get_pass_index( "svgf_variance" );
+        u32 pass_index = technique->get_pass_index( rhashed( "svgf_variance" ) );
         GpuTechniquePass& pass = technique->passes[ pass_index ];
 
         pipeline = pass.pipeline;
@@ -4577,7 +4616,7 @@ void SVGFVariancePass::reload_shaders( RenderScene& scene, FrameGraph* frame_gra
         descriptor_set = gpu.create_descriptor_set( ds_creation );
 
         // Downsample pipeline
-        pass_index = technique->get_pass_index( "svgf_downsample" );
+        pass_index = technique->get_pass_index( rhashed( "svgf_downsample" ) );
         GpuTechniquePass& downsample_pass = technique->passes[ pass_index ];
 
         downsample_pipeline = pass.pipeline;
@@ -4661,7 +4700,7 @@ void SVGFWaveletPass::on_resize( GpuDevice& gpu, FrameGraph* frame_graph, u32 ne
 void SVGFWaveletPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph, Allocator* resident_allocator, StackAllocator* scratch_allocator ) {
     renderer = scene.renderer;
 
-    FrameGraphNode* node = frame_graph->get_node( "svgf_wavelet_pass" );
+    FrameGraphNode* node = frame_graph->get_node( rhashed( "svgf_wavelet_pass" ) );
     if ( node == nullptr ) {
         enabled = false;
 
@@ -4694,58 +4733,58 @@ void SVGFWaveletPass::prepare_draws( RenderScene& scene, FrameGraph* frame_graph
     ping_pong_variance_texture = gpu.create_texture( texture_creation );
 
     // NOTE(marco): cache textures from previous passes
-    FrameGraphResource* resource = frame_graph->get_resource( "gbuffer_normals" );
+    FrameGraphResource* resource = frame_graph->get_resource( rhashed( "gbuffer_normals" ) );
     normals_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "depth" );
+    resource = frame_graph->get_resource( rhashed( "depth" ) );
     depth_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "mesh_id" );
+    resource = frame_graph->get_resource( rhashed( "mesh_id" ) );
     mesh_id_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "motion_vectors" );
+    resource = frame_graph->get_resource( rhashed( "motion_vectors" ) );
     motion_vectors_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "reflections" );
+    resource = frame_graph->get_resource( rhashed( "reflections" ) );
     reflections_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "depth_normal_fwidth" );
+    resource = frame_graph->get_resource( rhashed( "depth_normal_fwidth" ) );
     depth_normal_fwidth_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "linear_z_dd" );
+    resource = frame_graph->get_resource( rhashed( "linear_z_dd" ) );
     linear_z_dd_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "integrated_reflection_color" );
+    resource = frame_graph->get_resource( rhashed( "integrated_reflection_color" ) );
     integrated_color_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "integrated_moments" );
+    resource = frame_graph->get_resource( rhashed( "integrated_moments" ) );
     integrated_moments_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "svgf_variance" );
+    resource = frame_graph->get_resource( rhashed( "svgf_variance" ) );
     variance_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "reflections_history" );
+    resource = frame_graph->get_resource( rhashed( "reflections_history" ) );
     reflections_history_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "moments_history" );
+    resource = frame_graph->get_resource( rhashed( "moments_history" ) );
     moments_history_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "normals_history" );
+    resource = frame_graph->get_resource( rhashed( "normals_history" ) );
     last_frame_normals_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "mesh_id_history" );
+    resource = frame_graph->get_resource( rhashed( "mesh_id_history" ) );
     last_frame_mesh_id_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "depth_history" );
+    resource = frame_graph->get_resource( rhashed( "depth_history" ) );
     last_frame_linear_depth_texture = resource->resource_info.texture.handle;
 
-    resource = frame_graph->get_resource( "svgf_output" );
+    resource = frame_graph->get_resource( rhashed( "svgf_output" ) );
     resource->resource_info.set_external_texture_2d( adjusted_width, adjusted_height, VK_FORMAT_B10G11R11_UFLOAT_PACK32, 0, ping_pong_color_texture );
 
     GpuTechnique* technique = renderer->resource_cache.techniques.get( hash_calculate( "reflections" ) );
     if ( technique ) {
         
-        u32 pass_index = technique->get_pass_index( "svgf_wavelet" );
+        u32 pass_index = technique->get_pass_index( rhashed( "svgf_wavelet" ) );
         GpuTechniquePass& pass = technique->passes[ pass_index ];
 
         pipeline = pass.pipeline;
@@ -4823,7 +4862,7 @@ void SVGFWaveletPass::reload_shaders( RenderScene& scene, FrameGraph* frame_grap
     if ( technique ) {
         GpuDevice& gpu = *renderer->gpu;
         
-        u32 pass_index = technique->get_pass_index( "svgf_wavelet" );
+        u32 pass_index = technique->get_pass_index( rhashed( "svgf_wavelet" ) );
         GpuTechniquePass& pass = technique->passes[ pass_index ];
 
         pipeline = pass.pipeline;
@@ -4849,7 +4888,8 @@ void SVGFWaveletPass::update_dependent_resources( GpuDevice& gpu, FrameGraph* fr
 }
 
 // RenderScene ////////////////////////////////////////////////////////////
-CommandBuffer* RenderScene::update_physics( f32 delta_time, f32 air_density, f32 spring_stiffness, f32 spring_damping, vec3s wind_direction, bool reset_simulation ) {
+CommandBuffer* RenderScene::update_physics( f32 delta_time, f32 air_density, f32 spring_stiffness, f32 spring_damping, vec3s wind_direction, bool reset_simulation,
+                                            enki::TaskScheduler* task_scheduler ) {
     // Based on http://graphics.stanford.edu/courses/cs468-02-winter/Papers/Rigidcloth.pdf
 
 #if 0
@@ -4997,37 +5037,74 @@ CommandBuffer* RenderScene::update_physics( f32 delta_time, f32 air_density, f32
 
     CommandBuffer* cb = nullptr;
 
-    for ( u32 m = 0; m < meshes.size; ++m ) {
-        Mesh& mesh = meshes[ m ];
+    if ( cloth_on_cpu ) {
+        const ClothParameters parameters{ wind_direction, air_density, spring_stiffness, spring_damping };
 
-        PhysicsMesh* physics_mesh = mesh.physics_mesh;
+        for ( u32 m = 0; m < meshes.size; ++m ) {
+            Mesh& mesh = meshes[ m ];
 
-        if ( physics_mesh != nullptr ) {
-            if ( !gpu.buffer_ready( mesh.position_buffer ) ||
-                 !gpu.buffer_ready( mesh.normal_buffer ) ||
-                 !gpu.buffer_ready( mesh.tangent_buffer ) ||
-                 !gpu.buffer_ready( mesh.index_buffer ) ||
-                 !gpu.buffer_ready( physics_mesh->gpu_buffer ) ||
-                 !gpu.buffer_ready( physics_mesh->draw_indirect_buffer ) ) {
+            PhysicsMesh* physics_mesh = mesh.physics_mesh;
+
+            if ( physics_mesh == nullptr || !gpu.buffer_ready( mesh.position_buffer ) || !gpu.buffer_ready( mesh.normal_buffer ) ) {
                 continue;
             }
 
+            ClothSolver& cloth = physics_mesh->cloth;
+            if ( reset_simulation ) {
+                cloth.reset();
+            }
+            cloth.update( parameters, task_scheduler );
+
+            // Positions then normals, in the range of the current frame.
+            const sizet vertices_size = sizeof( vec3s ) * cloth.vertex_count;
+            const sizet staging_offset = vertices_size * 2 * gpu.current_frame;
+
+            Buffer* staging_buffer = gpu.access_buffer( physics_mesh->cloth_staging_buffer );
+            cloth.write_vertices( ( f32* )( staging_buffer->mapped_data + staging_offset ), ( f32* )( staging_buffer->mapped_data + staging_offset + vertices_size ) );
+
             if ( cb == nullptr ) {
                 cb = gpu.get_command_buffer( 0, gpu.current_frame, true );
 
                 cb->push_marker( "Frame" );
                 cb->push_marker( "async" );
+            }
+
+            cb->copy_buffer( physics_mesh->cloth_staging_buffer, staging_offset, mesh.position_buffer, mesh.position_offset, vertices_size );
+            cb->copy_buffer( physics_mesh->cloth_staging_buffer, staging_offset + vertices_size, mesh.normal_buffer, mesh.normal_offset, vertices_size );
+        }
+    } else {
+        for ( u32 m = 0; m < meshes.size; ++m ) {
+            Mesh& mesh = meshes[ m ];
+
+            PhysicsMesh* physics_mesh = mesh.physics_mesh;
+
+            if ( physics_mesh != nullptr ) {
+                if ( !gpu.buffer_ready( mesh.position_buffer ) ||
+                     !gpu.buffer_ready( mesh.normal_buffer ) ||
+                     !gpu.buffer_ready( mesh.tangent_buffer ) ||
+                     !gpu.buffer_ready( mesh.index_buffer ) ||
+                     !gpu.buffer_ready( physics_mesh->gpu_buffer ) ||
+                     !gpu.buffer_ready( physics_mesh->draw_indirect_buffer ) ) {
+                    continue;
+                }
 
-                const u64 cloth_hashed_name = hash_calculate( "cloth" );
-                GpuTechnique* cloth_technique = renderer->resource_cache.techniques.get( cloth_hashed_name );
+                if ( cb == nullptr ) {
+                    cb = gpu.get_command_buffer( 0, gpu.current_frame, true );
 
-                cb->bind_pipeline( cloth_technique->passes[ 0 ].pipeline );
-            }
+                    cb->push_marker( "Frame" );
+                    cb->push_marker( "async" );
+
+                    const u64 cloth_hashed_name = hash_calculate( "cloth" );
+                    GpuTechnique* cloth_technique = renderer->resource_cache.techniques.get( cloth_hashed_name );
 
-            cb->bind_descriptor_set( &physics_mesh->descriptor_set, 1, nullptr, 0 );
+                    cb->bind_pipeline( cloth_technique->passes[ 0 ].pipeline );
+                }
 
-            // TODO(marco): submit all meshes at once
-            cb->dispatch( 1, 1, 1 );
+                cb->bind_descriptor_set( &physics_mesh->descriptor_set, 1, nullptr, 0 );
+
+                // TODO(marco): submit all meshes at once
+                cb->dispatch( 1, 1, 1 );
+            }
         }
     }
 
@@ -5047,118 +5124,16 @@ CommandBuffer* RenderScene::update_physics( f32 delta_time, f32 air_density, f32
 #endif
 }
 
-// TODO: refactor
-Transform animated_transforms[ 256 ];
-
-void RenderScene::update_animations( f32 delta_time ) {
-
-    if ( animations.size == 0 ) {
-        return;
-    }
-
-    // TODO: update the first animation as test
-    Animation& animation = animations[ 0 ];
-    static f32 current_time = 0.f;
-
-    current_time += delta_time;
-    if ( current_time > animation.time_end ) {
-        current_time -= animation.time_end;
-    }
-
-    // TODO: fix skeleton/scene graph relationship
-    for ( u32 i = 0; i < 256; ++i ) {
-
-        Transform& transform = animated_transforms[ i ];
-        transform.reset();
-    }
-    // Accumulate transformations
-
-    u8 changed[ 256 ];
-    memset( changed, 0, 256 );
-
-    // For each animation channel
-    for ( u32 ac = 0; ac < animation.channels.size; ++ac ) {
-        AnimationChannel& channel = animation.channels[ ac ];
-        AnimationSampler& sampler = animation.samplers[ channel.sampler ];
-
-        if ( sampler.interpolation_type != AnimationSampler::Linear ) {
-            rprint( "Interpolation %s still not supported.\n", sampler.interpolation_type );
-            continue;
-        }
-
-        // Scroll through all key frames
-        for ( u32 ki = 0; ki < sampler.key_frames.size - 1; ++ki ) {
-            const f32 keyframe = sampler.key_frames[ ki ];
-            const f32 next_keyframe = sampler.key_frames[ ki + 1 ];
-            if ( current_time >= keyframe && current_time <= next_keyframe ) {
-
-                const f32 interpolation = ( current_time - keyframe ) / ( next_keyframe - keyframe );
-
-                RASSERT( channel.target_node < 256 );
-                changed[ channel.target_node ] = 1;
-                Transform& transform = animated_transforms[ channel.target_node ];
-                switch ( channel.target_type ) {
-                    case AnimationChannel::TargetType::Translation:
-                    {
-                        const vec3s current_data{ sampler.data[ ki ].x, sampler.data[ ki ].y, sampler.data[ ki ].z };
-                        const vec3s next_data{ sampler.data[ ki + 1 ].x, sampler.data[ ki + 1 ].y, sampler.data[ ki + 1 ].z };
-                        transform.translation = glms_vec3_lerp( current_data, next_data, interpolation );
-
-                        break;
-                    }
-                    case AnimationChannel::TargetType::Rotation:
-                    {
-                        const vec4s current_data = sampler.data[ ki ];
-                        const versors current_rotation = glms_quat_init( current_data.x, current_data.y, current_data.z, current_data.w );
-
-                        const vec4s next_data = sampler.data[ ki + 1 ];
-                        const versors next_rotation = glms_quat_init( next_data.x, next_data.y, next_data.z, next_data.w );
-
-                        transform.rotation = glms_quat_normalize( glms_quat_slerp( current_rotation, next_rotation, interpolation ) );
-
-                        break;
-                    }
-                    case AnimationChannel::TargetType::Scale:
-                    {
-                        const vec3s current_data{ sampler.data[ ki ].x, sampler.data[ ki ].y, sampler.data[ ki ].z };
-                        const vec3s next_data{ sampler.data[ ki + 1 ].x, sampler.data[ ki + 1 ].y, sampler.data[ ki + 1 ].z };
-                        transform.scale = glms_vec3_lerp( current_data, next_data, interpolation );
-
-                        break;
-                    }
-                    default:
-                        break;
-                }
-
-                break;
-            }
-        }
-    }
-}
-
-// TODO: remove, improve
-mat4s get_local_matrix( SceneGraph* scene_graph, u32 node_index ) {
-    const mat4s& a = animated_transforms[ node_index ].calculate_matrix();
-    // NOTE(marco): according to the spec (3.7.3.2)
-    // Only the joint transforms are applied to the skinned mesh; the transform of the skinned mesh node MUST be ignored
-    return a;
-}
-
-mat4s get_node_transform( SceneGraph* scene_graph, u32 node_index ) {
-    mat4s node_transform = get_local_matrix( scene_graph, node_index );
-
-    i32 parent = scene_graph->nodes_hierarchy[ node_index ].parent;
-    while ( parent >= 0 ) {
-        node_transform = glms_mat4_mul( get_local_matrix( scene_graph, parent ), node_transform );
-
-        parent = scene_graph->nodes_hierarchy[ parent ].parent;
-    }
-
-    return node_transform;
+void RenderScene::update_animations( f32 delta_time, enki::TaskScheduler* task_scheduler ) {
+    animation_update_instances( animation_instances.data, animation_instances.size, delta_time, task_scheduler );
 }
 
 void RenderScene::update_joints() {
+    ZoneScoped;
 
+    // World matrices of the joints come from the scene graph, updated in level order before this.
+    // NOTE(marco): according to the spec (3.7.3.2)
+    // Only the joint transforms are applied to the skinned mesh; the transform of the skinned mesh node MUST be ignored
     for ( u32 i = 0; i < skins.size; i++ ) {
         Skin& skin = skins[ i ];
 
@@ -5167,13 +5142,7 @@ void RenderScene::update_joints() {
         mat4s* joint_transforms = (mat4s*)renderer->gpu->map_buffer( cb_map );
 
         if ( joint_transforms ) {
-            for ( u32 ji = 0; ji < skin.joints.size; ji++ ) {
-                u32 joint = skin.joints[ ji ];
-
-                mat4s& joint_transform = joint_transforms[ ji ];
-
-                joint_transform = glms_mat4_mul( get_node_transform( scene_graph, joint ), skin.inverse_bind_matrices[ ji ] );
-            }
+            skinning_compute_palette( scene_graph->world_matrices.data, skin.joints.data, skin.inverse_bind_matrices, skin.joints.size, joint_transforms );
 
             renderer->gpu->unmap_buffer( cb_map );
         }
@@ -5669,7 +5638,7 @@ void RenderScene::on_resize( GpuDevice& gpu, FrameGraph* frame_graph, u32 new_wi
 
     if ( use_meshlets ) {
         GpuTechnique* transparent_technique = renderer->resource_cache.techniques.get( hash_calculate( "meshlet" ) );
-        u32 meshlet_technique_index = transparent_technique->get_pass_index( "transparent_no_cull" );
+        u32 meshlet_technique_index = transparent_technique->get_pass_index( rhashed( "transparent_no_cull" ) );
         GpuTechniquePass& transparent_pass = transparent_technique->passes[ meshlet_technique_index ];
 
         DescriptorSetLayoutHandle transparent_layout = renderer->gpu->get_descriptor_set_layout( transparent_pass.pipeline, k_material_descriptor_set_index );
@@ -5716,8 +5685,30 @@ void RenderScene::draw_mesh_instance( CommandBuffer* gpu_commands, MeshInstance&
     gpu_commands->draw_indexed( TopologyType::Triangle, mesh.primitive_count, 1, 0, 0, mesh_instance.gpu_mesh_instance_index );
 }
 
+void RenderScene::lod_statistics( MeshLodStats& stats ) const {
+    ZoneScoped;
+
+    stats = MeshLodStats{ };
+
+    for ( u32 i = 0; i < mesh_instances.size; ++i ) {
+        const MeshInstance& mesh_instance = mesh_instances[ i ];
+        const Mesh& mesh = *mesh_instance.mesh;
+
+        const mat4s world = mesh_instance_world_matrix( mesh_instance );
+        const u32 lod = mesh_lod_select( mesh, world, scene_data );
+
+        stats.full_triangles += mesh.meshlet_index_count / 3;
+        stats.lod_triangles += ( lod == 0 ? mesh.meshlet_index_count : mesh.lods[ lod ].meshlet_index_count ) / 3;
+        ++stats.instance_counts[ lod ];
+    }
+}
+
+mat4s RenderScene::mesh_instance_world_matrix( const MeshInstance& mesh_instance ) const {
+    return scene_graph ? mesh_instance_world( mesh_instance, global_scale, scene_graph ) : glms_mat4_identity();
+}
+
 void RenderScene::add_scene_descriptors( DescriptorSetCreation& descriptor_set_creation, GpuTechniquePass& pass ) {
-    const u16 binding = pass.get_binding_index( "SceneConstants" );
+    const u16 binding = pass.get_binding_index( rhashed( "SceneConstants" ) );
     descriptor_set_creation.buffer( scene_cb, binding );
 }
 
@@ -5725,9 +5716,9 @@ void RenderScene::add_mesh_descriptors( DescriptorSetCreation& descriptor_set_cr
     //.buffer( meshes_sb, "MeshDraws").buffer(mesh_instances_sb, "MeshInstanceDraws").buffer(mesh_bounds_sb, "MeshBounds");
 
     // These are always defined together.
-    const u16 binding_md = pass.get_binding_index( "MeshDraws" );
-    const u16 binding_mid = pass.get_binding_index( "MeshInstanceDraws" );
-    const u16 binding_mb = pass.get_binding_index( "MeshBounds" );
+    const u16 binding_md = pass.get_binding_index( rhashed( "MeshDraws" ) );
+    const u16 binding_mid = pass.get_binding_index( rhashed( "MeshInstanceDraws" ) );
+    const u16 binding_mb = pass.get_binding_index( rhashed( "MeshBounds" ) );
 
     descriptor_set_creation.buffer( meshes_sb, binding_md ).buffer( mesh_instances_sb, binding_mid ).buffer( mesh_bounds_sb, binding_mb );
 }
@@ -5735,37 +5726,37 @@ void RenderScene::add_mesh_descriptors( DescriptorSetCreation& descriptor_set_cr
 void RenderScene::add_meshlet_descriptors( DescriptorSetCreation& descriptor_set_creation, GpuTechniquePass& pass ) {
     // .buffer(meshlets_sb, 1).buffer( meshlets_data_sb, 3 ).buffer( meshlets_vertex_pos_sb, 4 ).buffer( meshlets_vertex_data_sb, 5 )
     // Handle optional bindings
-    u16 binding = pass.get_binding_index( "Meshlets" );
+    u16 binding = pass.get_binding_index( rhashed( "Meshlets" ) );
     if ( binding != u16_max ) {
         descriptor_set_creation.buffer( meshlets_sb, binding );
     }
 
-    binding = pass.get_binding_index( "MeshletData" );
+    binding = pass.get_binding_index( rhashed( "MeshletData" ) );
     if ( binding != u16_max ) {
         descriptor_set_creation.buffer( meshlets_data_sb, binding );
     }
 
-    binding = pass.get_binding_index( "VertexPositions" );
+    binding = pass.get_binding_index( rhashed( "VertexPositions" ) );
     if ( binding != u16_max ) {
         descriptor_set_creation.buffer( meshlets_vertex_pos_sb, binding );
     }
 
-    binding = pass.get_binding_index( "VertexData" );
+    binding = pass.get_binding_index( rhashed( "VertexData" ) );
     if ( binding != u16_max ) {
         descriptor_set_creation.buffer( meshlets_vertex_data_sb, binding );
     }
 
-   // descriptor_set_creation.buffer( meshlets_sb, pass.get_binding_index( "Meshlets" ) ).buffer( meshlets_data_sb, pass.get_binding_index( "MeshletData" ) )
-       // .buffer( meshlets_vertex_pos_sb, pass.get_binding_index( "VertexPositions" ) ).buffer( meshlets_vertex_data_sb, pass.get_binding_index( "VertexData" ) );
+   // descriptor_set_creation.buffer( meshlets_sb, pass.get_binding_index( rhashed( "Meshlets" ) ) ).buffer( meshlets_data_sb, pass.get_binding_index( rhashed( "MeshletData" ) ) )
+       // .buffer( meshlets_vertex_pos_sb, pass.get_binding_index( rhashed( "VertexPositions" ) ) ).buffer( meshlets_vertex_data_sb, pass.get_binding_index( rhashed( "VertexData" ) ) );
 }
 
 void RenderScene::add_debug_descriptors( DescriptorSetCreation& descriptor_set_creation, GpuTechniquePass& pass ) {
     // .buffer( debug_line_sb, 20 ).buffer( debug_line_count_sb, 21 ).buffer( debug_line_commands_sb, 22 )
 
     //  These are always defined all together, no need to check.
-    const u16 binding_dl = pass.get_binding_index( "DebugLines" );
-    const u16 binding_dlc = pass.get_binding_index( "DebugLinesCount" );
-    const u16 binding_dlcmd = pass.get_binding_index( "DebugLineCommands" );
+    const u16 binding_dl = pass.get_binding_index( rhashed( "DebugLines" ) );
+    const u16 binding_dlc = pass.get_binding_index( rhashed( "DebugLinesCount" ) );
+    const u16 binding_dlcmd = pass.get_binding_index( rhashed( "DebugLineCommands" ) );
 
     descriptor_set_creation.buffer( debug_line_sb, binding_dl ).buffer( debug_line_count_sb, binding_dlc ).buffer( debug_line_commands_sb, binding_dlcmd );
 }
@@ -5773,32 +5764,32 @@ void RenderScene::add_debug_descriptors( DescriptorSetCreation& descriptor_set_c
 void RenderScene::add_lighting_descriptors( DescriptorSetCreation& descriptor_set_creation, GpuTechniquePass& pass, u32 frame_index ) {
     // .buffer( scene.lights_lut_sb[ i ], 20 ).buffer( scene.lights_list_sb, 21 )
     // .buffer( scene.lights_tiles_sb[ i ], 22 ).buffer( scene.lights_indices_sb[ i ], 25 )
-    u16 binding = pass.get_binding_index( "ZBins" );
+    u16 binding = pass.get_binding_index( rhashed( "ZBins" ) );
     if ( binding != u16_max ) {
         descriptor_set_creation.buffer( lights_lut_sb[ frame_index ], binding );
     }
 
-    binding = pass.get_binding_index( "Lights" );
+    binding = pass.get_binding_index( rhashed( "Lights" ) );
     if ( binding != u16_max ) {
         descriptor_set_creation.buffer( lights_list_sb, binding );
     }
 
-    binding = pass.get_binding_index( "Tiles" );
+    binding = pass.get_binding_index( rhashed( "Tiles" ) );
     if ( binding != u16_max ) {
         descriptor_set_creation.buffer( lights_tiles_sb[ frame_index ], binding );
     }
 
-    binding = pass.get_binding_index( "LightIndices" );
+    binding = pass.get_binding_index( rhashed( "LightIndices" ) );
     if ( binding != u16_max ) {
         descriptor_set_creation.buffer( lights_indices_sb[ frame_index ], binding );
     }
 
-    binding = pass.get_binding_index( "LightConstants" );
+    binding = pass.get_binding_index( rhashed( "LightConstants" ) );
     if ( binding != u16_max ) {
         descriptor_set_creation.buffer( lighting_constants_cb[ frame_index ], binding );
     }
 
-    binding = pass.get_binding_index( "as" );
+    binding = pass.get_binding_index( rhashed( "as" ) );
     if ( binding != u16_max ) {
         descriptor_set_creation.set_as( tlas, binding );
     }
@@ -5842,7 +5833,7 @@ void DrawTask::ExecuteRange( enki::TaskSetPartition range_, uint32_t threadnum_
     gpu_commands->set_viewport( nullptr );
 
     // Apply fullscreen material
-    FrameGraphResource* texture = frame_graph->get_resource( "final" );
+    FrameGraphResource* texture = frame_graph->get_resource( rhashed( "final" ) );
     RASSERT( texture != nullptr );
     // TODO: proper handling.
     TextureHandle output_texture = texture->resource_info.texture.handle;
@@ -5979,7 +5970,7 @@ void FrameRenderer::prepare_draws( StackAllocator* scratch_allocator ) {
     // Handle fullscreen pass.
     fullscreen_tech = renderer->resource_cache.techniques.get( hash_calculate( "fullscreen" ) );
 
-    u32 pass_index = fullscreen_tech->get_pass_index( "main_triangle" );
+    u32 pass_index = fullscreen_tech->get_pass_index( rhashed( "main_triangle" ) );
     GpuTechniquePass& pass = fullscreen_tech->passes[ pass_index ];
     passthrough_pipeline = pass.pipeline;
 
@@ -5987,7 +5978,7 @@ void FrameRenderer::prepare_draws( StackAllocator* scratch_allocator ) {
     buffer_creation.reset().set( VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, ResourceUsageType::Dynamic, sizeof( GpuPostConstants ) );
     post_uniforms_buffer = renderer->gpu->create_buffer( buffer_creation );
 
-    pass_index = fullscreen_tech->get_pass_index( "main_post" );
+    pass_index = fullscreen_tech->get_pass_index( rhashed( "main_post" ) );
     GpuTechniquePass& post_pass = fullscreen_tech->passes[ pass_index ];
     main_post_pipeline = post_pass.pipeline;
 
@@ -6295,7 +6286,7 @@ void DebugRenderer::init( RenderScene& scene, Allocator* resident_allocator, Sta
         DescriptorSetCreation set_creation{ };
 
         // Draw pass
-        u32 pass_index = main_technique->get_pass_index( "debug_line_cpu" );
+        u32 pass_index = main_technique->get_pass_index( rhashed( "debug_line_cpu" ) );
         GpuTechniquePass& pass = main_technique->passes[ pass_index ];
         debug_lines_draw_pipeline = pass.pipeline;
         DescriptorSetLayoutHandle layout = renderer->gpu->get_descriptor_set_layout( pass.pipeline, k_material_descriptor_set_index );
@@ -6305,7 +6296,7 @@ void DebugRenderer::init( RenderScene& scene, Allocator* resident_allocator, Sta
         scene.add_debug_descriptors( set_creation, pass );
         debug_lines_draw_set = renderer->gpu->create_descriptor_set( set_creation );
 
-        pass_index = main_technique->get_pass_index( "debug_line_2d_cpu" );
+        pass_index = main_technique->get_pass_index( rhashed( "debug_line_2d_cpu" ) );
         debug_lines_2d_draw_pipeline = main_technique->passes[ pass_index ].pipeline;
     }
 }
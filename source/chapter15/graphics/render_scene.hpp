@@ -4,6 +4,7 @@
 #include "foundation/platform.hpp"
 #include "foundation/color.hpp"
 
+#include "graphics/cloth.hpp"
 #include "graphics/command_buffer.hpp"
 #include "graphics/renderer.hpp"
 #include "graphics/gpu_resources.hpp"
@@ -34,6 +35,7 @@ namespace raptor {
     static const u32    k_material_descriptor_set_index    = 1;
     static const u32    k_max_joint_count                  = 12;
     static const u32    k_max_depth_pyramid_levels         = 16;
+    static const u32    k_max_mesh_lods                    = 5;     // Full detail level included, must match MAX_MESH_LODS in mesh.h.
 
     static const u32    k_num_lights                       = 256;
     static const u32    k_light_z_bins                     = 16;
@@ -106,6 +108,8 @@ namespace raptor {
 
         vec4s                   frustum_planes[ 6 ];
 
+        f32                     lod_error_pixels;   // Largest simplification error on screen when selecting mesh levels of detail.
+
         // Helpers for bit packing. Would be perfect for code generation
         // NOTE: must be in sync with scene.h!
         bool                    frustum_cull_meshes() const             { return ( culling_options &  1 ) ==  1; }
@@ -117,6 +121,7 @@ namespace raptor {
         bool                    shadow_meshlets_sphere_cull() const       { return ( culling_options & 64 ) == 64; }
         bool                    shadow_meshlets_cubemap_face_cull() const { return ( culling_options & 128 ) == 128; }
         bool                    shadow_mesh_sphere_cull() const         { return ( culling_options & 256 ) == 256; }
+        bool                    mesh_lods() const                       { return ( culling_options & 512 ) == 512; }
 
         void                    set_frustum_cull_meshes(bool value)     { value ? (culling_options |=  1) : (culling_options &= ~( 1)); }
         void                    set_frustum_cull_meshlets(bool value)   { value ? (culling_options |=  2) : (culling_options &= ~( 2)); }
@@ -127,6 +132,7 @@ namespace raptor {
         void                    set_shadow_meshlets_sphere_cull( bool value )    { value ? ( culling_options |= 64 ) : ( culling_options &= ~( 64 ) ); }
         void                    set_shadow_meshlets_cubemap_face_cull( bool value ) { value ? ( culling_options |= 128 ) : ( culling_options &= ~( 128 ) ); }
         void                    set_shadow_mesh_sphere_cull( bool value ) { value ? ( culling_options |= 256 ) : ( culling_options &= ~( 256 ) ); }
+        void                    set_mesh_lods( bool value )             { value ? ( culling_options |= 512 ) : ( culling_options &= ~( 512 ) ); }
 
     }; // struct GpuSceneData
 
@@ -283,8 +289,22 @@ namespace raptor {
         BufferHandle            draw_indirect_buffer;
         DescriptorSetHandle     descriptor_set;
         DescriptorSetHandle     debug_mesh_descriptor_set;
+
+        // Simulation on the cpu, positions and normals are copied to the mesh buffers from a staging
+        // buffer with a range per frame in flight.
+        ClothSolver             cloth;
+        BufferHandle            cloth_staging_buffer;
     };
 
+    //
+    // Meshlet range of a level of detail, levels after the first are simplified.
+    struct GpuMeshLod {
+        u32                     meshlet_offset;
+        u32                     meshlet_count;
+        u32                     meshlet_index_count;
+        f32                     error;              // Object space simplification error, 0 for the full detail level.
+    }; // struct GpuMeshLod
+
     //
     //
     struct Mesh {
@@ -320,6 +340,10 @@ namespace raptor {
         u32                     meshlet_count;
         u32                     meshlet_index_count;
 
+        // Level 0 is the meshlet range above.
+        u32                     lod_count               = 1;
+        GpuMeshLod              lods[ k_max_mesh_lods ];
+
         u32                     gpu_mesh_index          = u32_max;
         i32                     skin_index              = i32_max;
 
@@ -409,13 +433,15 @@ namespace raptor {
         u32                     meshlet_offset;
         u32                     meshlet_count;
         u32                     meshlet_index_count;
-        u32                     padding1_;
+        u32                     lod_count;
 
         VkDeviceAddress         position_buffer;
         VkDeviceAddress         uv_buffer;
         VkDeviceAddress         index_buffer;
         VkDeviceAddress         normals_buffer;
 
+        GpuMeshLod              lods[ k_max_mesh_lods ];
+
     }; // struct GpuMaterialData
 
     //
@@ -458,6 +484,33 @@ namespace raptor {
 
     }; // struct GpuMeshDrawCounts
 
+    // Levels of detail ///////////////////////////////////////////////////
+    //
+    // Triangles drawn by all mesh instances with the selected levels, culling excluded.
+    struct MeshLodStats {
+        u64                     full_triangles;
+        u64                     lod_triangles;
+        u32                     instance_counts[ k_max_mesh_lods ];
+    }; // struct MeshLodStats
+
+    // CPU reference of select_mesh_lod in mesh.h: coarsest level whose error, projected at the nearest point
+    // of the bounding sphere, stays under scene_data.lod_error_pixels.
+    u32                         mesh_lod_select( const Mesh& mesh, const mat4s& world, const GpuSceneData& scene_data );
+
+    // Transform //////////////////////////////////////////////////////////
+
+    //
+    struct Transform {
+
+        vec3s                   scale;
+        versors                 rotation;
+        vec3s                   translation;
+
+        void                    reset();
+        mat4s                   calculate_matrix() const;
+
+    }; // struct Transform
+
     // Animation structs //////////////////////////////////////////////////
     //
     //
@@ -473,6 +526,21 @@ namespace raptor {
 
     }; // struct AnimationChannel
 
+    //
+    // Sampler key frames after animation_compress_sampler, 16 bits times and 48 bits values.
+    struct AnimationCompressedTrack {
+
+        u16*                    data;               // key_frame_count times, then three words per value.
+        u32                     key_frame_count;    // 0 when the sampler is not compressed.
+        f32                     time_start;
+        f32                     time_scale;         // Seconds to 16 bits time.
+        vec3s                   range_min;          // Translations and scales are quantized in their range,
+        vec3s                   range_scale;        // rotations are packed as their three smallest components.
+        bool                    rotation;
+        bool                    step;               // Step interpolation, linear otherwise.
+
+    }; // struct AnimationCompressedTrack
+
     struct AnimationSampler {
 
         enum Interpolation {
@@ -480,9 +548,11 @@ namespace raptor {
         };
 
         Array<f32>              key_frames;
-        vec4s*                  data;       // Aligned-allocated data. Count is the same as key_frames.
+        vec4s*                  data;       // Aligned-allocated data. One value per key frame, in tangent, value and out tangent for CubicSpline.
         Interpolation           interpolation_type;
 
+        AnimationCompressedTrack compressed; // Sampled instead of key_frames and data when compressed.key_frame_count > 0.
+
     }; // struct AnimationSampler
 
     //
@@ -498,10 +568,40 @@ namespace raptor {
     }; // struct Animation
 
     //
-    //
+    // Playback of a clip on a contiguous range of scene graph nodes, implemented in animation.cpp.
     struct AnimationInstance {
-        Animation*              animation;
-        f32                     current_time;
+
+        void                    init( Allocator* allocator, SceneGraph* scene_graph, u32 first_node, u32 node_count );
+        void                    shutdown();
+
+        // Start a clip from its first key frame, cross fading from the current one over fade_duration seconds.
+        void                    play( Animation* animation, f32 fade_duration = 0.f, bool loop = true );
+        // Advance the clips and write the local matrices of the animated nodes, without marking them as updated.
+        void                    update( f32 delta_time );
+
+        Animation*              animation           = nullptr;
+        Animation*              previous_animation  = nullptr;  // Clip fading out, nullptr when not blending.
+        f32                     current_time        = 0.f;
+        f32                     previous_time       = 0.f;
+        f32                     fade_time           = 0.f;
+        f32                     fade_duration       = 0.f;
+        f32                     speed               = 1.f;
+        bool                    loop                = true;
+        bool                    previous_loop       = true;
+
+        SceneGraph*             scene_graph         = nullptr;
+        u32                     first_node          = 0;
+        u32                     node_count          = 0;
+        i32                     target_offset       = 0;        // Added to channel targets, to play clips on a copy of their nodes.
+
+        Array<u32>              cursors;            // Last key frame used by each sampler of the current clip.
+        Array<u32>              previous_cursors;
+        Array<Transform>        rest_pose;          // Decomposed local matrices of the range when the instance was created.
+        Array<Transform>        pose;
+        Array<Transform>        fade_pose;
+        Array<u32>              animated_nodes;     // Nodes of the range targeted by the current or the previous clip.
+        Array<u8>               node_animated;
+
     }; // struct AnimationInstance
 
     // Skinning ///////////////////////////////////////////////////////////
@@ -517,20 +617,6 @@ namespace raptor {
 
     }; // struct Skin
 
-    // Transform //////////////////////////////////////////////////////////
-
-    //
-    struct Transform {
-
-        vec3s                   scale;
-        versors                 rotation;
-        vec3s                   translation;
-
-        void                    reset();
-        mat4s                   calculate_matrix() const;
-
-    }; // struct Transform
-
     // Light //////////////////////////////////////////////////////////////
 
     //
@@ -1423,13 +1509,20 @@ namespace raptor {
 
         virtual void            prepare_draws( Renderer* renderer, StackAllocator* scratch_allocator, SceneGraph* scene_graph ) { };
 
-        CommandBuffer*          update_physics( f32 delta_time, f32 air_density, f32 spring_stiffness, f32 spring_damping, vec3s wind_direction, bool reset_simulation );
-        void                    update_animations( f32 delta_time );
+        // Cloth is simulated by the cloth shader, or on the cpu with the task threads when cloth_on_cpu is set.
+        CommandBuffer*          update_physics( f32 delta_time, f32 air_density, f32 spring_stiffness, f32 spring_damping, vec3s wind_direction, bool reset_simulation,
+                                                enki::TaskScheduler* task_scheduler = nullptr );
+        // Advance all animation instances, split between the task threads if a task scheduler is given.
+        void                    update_animations( f32 delta_time, enki::TaskScheduler* task_scheduler = nullptr );
         void                    update_joints();
 
         void                    upload_gpu_data( UploadGpuDataContext& context );
         void                    draw_mesh_instance( CommandBuffer* gpu_commands, MeshInstance& mesh_instance, bool transparent );
 
+        void                    lod_statistics( MeshLodStats& stats ) const;
+        // World matrix used by the gpu for the mesh instance, global scale included.
+        mat4s                   mesh_instance_world_matrix( const MeshInstance& mesh_instance ) const;
+
         // Helpers based on shaders. Ideally this would be coming from generated cpp files.
         void                    add_scene_descriptors( DescriptorSetCreation& descriptor_set_creation, GpuTechniquePass& pass );
         void                    add_mesh_descriptors( DescriptorSetCreation& descriptor_set_creation, GpuTechniquePass& pass );
@@ -1453,8 +1546,12 @@ namespace raptor {
 
         // Animation and skinning data
         Array<Animation>        animations;
+        Array<AnimationInstance> animation_instances;
         Array<Skin>             skins;
 
+        // Physics
+        bool                    cloth_on_cpu    = false;
+
         // Lights
         Array<Light>            lights;
         Array<u32>              lights_lut;
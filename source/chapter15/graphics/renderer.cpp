@@ -59,11 +59,6 @@ MaterialCreation& MaterialCreation::set_name( cstring name_ ) {
 
 // Renderer /////////////////////////////////////////////////////////////////////
 
-u64 TextureResource::k_type_hash = 0;
-u64 BufferResource::k_type_hash = 0;
-u64 SamplerResource::k_type_hash = 0;
-u64 Material::k_type_hash = 0;
-u64 GpuTechnique::k_type_hash = 0;
 
 static Renderer s_renderer;
 
@@ -91,13 +86,6 @@ void Renderer::init( const RendererCreation& creation ) {
 
     resource_cache.init( creation.allocator );
 
-    // Init resource hashes
-    TextureResource::k_type_hash = hash_calculate( TextureResource::k_type );
-    BufferResource::k_type_hash = hash_calculate( BufferResource::k_type );
-    SamplerResource::k_type_hash = hash_calculate( SamplerResource::k_type );
-    Material::k_type_hash = hash_calculate( Material::k_type );
-    GpuTechnique::k_type_hash = hash_calculate( GpuTechnique::k_type );
-
     const u32 gpu_heap_counts = gpu->get_memory_heap_count();
     gpu_heap_budgets.init( resident_allocator, gpu_heap_counts, gpu_heap_counts );
 }
@@ -276,12 +264,16 @@ GpuTechnique* Renderer::create_technique( const GpuTechniqueCreation& creation )
                 for ( u32 b = 0; b < descriptor_set_layout->num_bindings; ++b ) {
                     const DescriptorBinding& binding = descriptor_set_layout->bindings[ b ];
                     
-                    pass.name_hash_to_descriptor_index.insert( hash_calculate( binding.name ), ( u16 )binding.index );
+                    const u64 binding_name_hash = hash_calculate( binding.name );
+                    hashed_string_check( binding_name_hash, binding.name );
+                    pass.name_hash_to_descriptor_index.insert( binding_name_hash, ( u16 )binding.index );
                 }
             }
 
             RASSERT( pass_creation.name );
-            technique->name_hash_to_index.insert( hash_calculate( pass_creation.name ), ( u32 )i );
+            const u64 pass_name_hash = hash_calculate( pass_creation.name );
+            hashed_string_check( pass_name_hash, pass_creation.name );
+            technique->name_hash_to_index.insert( pass_name_hash, ( u32 )i );
         }
 
         temporary_allocator.clear();
@@ -509,6 +501,13 @@ void Renderer::add_texture_update_commands( u32 thread_id ) {
 
         Texture* texture = gpu->access_texture( textures_to_update[i] );
 
+        if ( texture->state == RESOURCE_STATE_SHADER_RESOURCE ) {
+            // Cooked textures and CPU generated chains are uploaded with all their mips, acquire them matching the transfer queue release.
+            util_add_image_barrier_ext( cb->gpu_device, cb->vk_command_buffer, texture->vk_image, RESOURCE_STATE_COPY_DEST, RESOURCE_STATE_SHADER_RESOURCE,
+                                        0, texture->mip_level_count, 0, 1, false, gpu->vulkan_transfer_queue_family, gpu->vulkan_main_queue_family, QueueType::CopyTransfer, QueueType::Graphics );
+            continue;
+        }
+
         util_add_image_barrier_ext( cb->gpu_device, cb->vk_command_buffer, texture->vk_image, RESOURCE_STATE_COPY_DEST, RESOURCE_STATE_COPY_SOURCE,
                                     0, 1, 0, 1, false, gpu->vulkan_transfer_queue_family, gpu->vulkan_main_queue_family, QueueType::CopyTransfer, QueueType::Graphics );
 
@@ -593,12 +592,22 @@ u32 GpuTechnique::get_pass_index( cstring name ) {
     return name_hash_to_index.get( name_hash );
 }
 
+u32 GpuTechnique::get_pass_index( const HashedString& name ) {
+    hashed_string_check( name );
+    return name_hash_to_index.get( name.hash, name.key_hash );
+}
+
 // GpuTechniquePass ///////////////////////////////////////////////////////
 u32 GpuTechniquePass::get_binding_index( cstring name ) {
     const u64 name_hash = hash_calculate( name );
     return name_hash_to_descriptor_index.get( name_hash );
 }
 
+u32 GpuTechniquePass::get_binding_index( const HashedString& name ) {
+    hashed_string_check( name );
+    return name_hash_to_descriptor_index.get( name.hash, name.key_hash );
+}
+
 GpuTechniqueDescriptorCreation& GpuTechniqueDescriptorCreation::reset() {
     descriptor_set_creation.reset();
     pass = nullptr;
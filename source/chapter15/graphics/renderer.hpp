@@ -18,7 +18,7 @@ struct BufferResource : public raptor::Resource {
     BufferDescription               desc;
 
     static constexpr cstring        k_type = "raptor_buffer_type";
-    static u64                      k_type_hash;
+    static constexpr u64            k_type_hash = hash_calculate_constexpr( k_type );
 
 }; // struct Buffer
 
@@ -31,7 +31,7 @@ struct TextureResource : public raptor::Resource {
     TextureDescription              desc;
 
     static constexpr cstring        k_type = "raptor_texture_type";
-    static u64                      k_type_hash;
+    static constexpr u64            k_type_hash = hash_calculate_constexpr( k_type );
 
 }; // struct Texture
 
@@ -44,7 +44,7 @@ struct SamplerResource : public raptor::Resource {
     SamplerDescription              desc;
 
     static constexpr cstring        k_type = "raptor_sampler_type";
-    static u64                      k_type_hash;
+    static constexpr u64            k_type_hash = hash_calculate_constexpr( k_type );
 
 }; // struct Sampler
 
@@ -74,6 +74,7 @@ struct GpuTechniquePass {
     FlatHashMap<u64, u16>           name_hash_to_descriptor_index;
 
     u32                             get_binding_index( cstring name );
+    u32                             get_binding_index( const HashedString& name );
 
 }; // struct GpuTechniquePass
 
@@ -102,9 +103,10 @@ struct GpuTechnique : public raptor::Resource {
     u32                             pool_index;
 
     u32                             get_pass_index( cstring name );
+    u32                             get_pass_index( const HashedString& name );
 
     static constexpr cstring        k_type = "raptor_gpu_technique_type";
-    static u64                      k_type_hash;
+    static constexpr u64            k_type_hash = hash_calculate_constexpr( k_type );
 
 }; // struct GpuTechnique
 
@@ -134,7 +136,7 @@ struct Material : public raptor::Resource {
     u32                             pool_index;
 
     static constexpr cstring        k_type = "raptor_material_type";
-    static u64                      k_type_hash;
+    static constexpr u64            k_type_hash = hash_calculate_constexpr( k_type );
 
 }; // struct Material
 
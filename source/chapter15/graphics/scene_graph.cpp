@@ -1,14 +1,79 @@
 #include "graphics/scene_graph.hpp"
 
+#include "foundation/assert.hpp"
+#include "foundation/log.hpp"
 #include "foundation/numerics.hpp"
+#include "foundation/simd.hpp"
 #include "foundation/time.hpp"
 
 #include "external/cglm/struct/affine.h"
+#include "external/enkiTS/TaskScheduler.h"
+#include "external/tracy/tracy/Tracy.hpp"
 
+#include <math.h>
 #include <string.h>
 
 namespace raptor {
 
+#if defined(RAPTOR_SIMD_AVX)
+static cstring k_scene_graph_simd_name = "AVX";
+#elif defined(RAPTOR_SIMD_SSE2)
+static cstring k_scene_graph_simd_name = "SSE2";
+#else
+static cstring k_scene_graph_simd_name = "scalar";
+#endif
+
+static const u32 k_scene_graph_parallel_nodes   = 4096;     // Smaller levels are updated on the calling thread.
+static const u32 k_scene_graph_task_range       = 1024;
+
+// Update a range of update_order, all inside the same level.
+static void scene_graph_update_range( SceneGraph& scene_graph, u32 begin, u32 end ) {
+    const u32* order = scene_graph.update_order.data;
+    const i32* parents = scene_graph.update_parents.data;
+    const mat4s* local_matrices = scene_graph.local_matrices.data;
+    mat4s* world_matrices = scene_graph.world_matrices.data;
+    u8* dirty_nodes = scene_graph.dirty_nodes.data;
+
+    for ( u32 i = begin; i < end; ++i ) {
+        const u32 node = order[ i ];
+        const i32 parent = parents[ i ];
+
+        if ( parent < 0 ) {
+            const u8 dirty = scene_graph.updated_nodes.get_bit( node ) ? 1 : 0;
+            if ( dirty ) {
+                world_matrices[ node ] = local_matrices[ node ];
+            }
+            dirty_nodes[ node ] = dirty;
+            continue;
+        }
+
+        // Parents belong to the previous level, they are already final.
+        const u8 dirty = ( scene_graph.updated_nodes.get_bit( node ) || dirty_nodes[ parent ] ) ? 1 : 0;
+        if ( dirty ) {
+            simd_mat4_mul( world_matrices[ parent ], local_matrices[ node ], world_matrices[ node ] );
+        }
+        dirty_nodes[ node ] = dirty;
+    }
+}
+
+//
+// Splits a level of the update order between the task threads.
+struct SceneGraphUpdateTask : public enki::ITaskSet {
+
+    void                    ExecuteRange( enki::TaskSetPartition range_, uint32_t threadnum_ ) override;
+
+    SceneGraph*             scene_graph     = nullptr;
+    u32                     offset          = 0;        // First entry of the level in update_order.
+}; // struct SceneGraphUpdateTask
+
+void SceneGraphUpdateTask::ExecuteRange( enki::TaskSetPartition range_, uint32_t /*threadnum_*/ ) {
+    ZoneScoped;
+
+    scene_graph_update_range( *scene_graph, offset + range_.start, offset + range_.end );
+}
+
+// SceneGraph /////////////////////////////////////////////////////////////
+
 void SceneGraph::init( Allocator* resident_allocator, u32 num_nodes ) {
     nodes_hierarchy.init( resident_allocator, num_nodes );
     local_matrices.init( resident_allocator, num_nodes );
@@ -16,6 +81,13 @@ void SceneGraph::init( Allocator* resident_allocator, u32 num_nodes ) {
     nodes_debug_data.init( resident_allocator, num_nodes );
 
     updated_nodes.init( resident_allocator, num_nodes );
+
+    update_order.init( resident_allocator, num_nodes );
+    update_parents.init( resident_allocator, num_nodes );
+    level_offsets.init( resident_allocator, 16 );
+    dirty_nodes.init( resident_allocator, num_nodes );
+
+    sort_update_order = true;
 }
 
 void SceneGraph::shutdown() {
@@ -24,6 +96,11 @@ void SceneGraph::shutdown() {
     updated_nodes.shutdown();
     local_matrices.shutdown();
     world_matrices.shutdown();
+
+    update_order.shutdown();
+    update_parents.shutdown();
+    level_offsets.shutdown();
+    dirty_nodes.shutdown();
 }
 
 void SceneGraph::resize( u32 num_nodes ) {
@@ -33,6 +110,8 @@ void SceneGraph::resize( u32 num_nodes ) {
     nodes_debug_data.set_size( num_nodes );
 
     updated_nodes.resize( num_nodes );
+
+    sort_update_order = true;
 }
 
 void SceneGraph::init_new_nodes( u32 offset, u32 num_nodes ) {
@@ -41,63 +120,86 @@ void SceneGraph::init_new_nodes( u32 offset, u32 num_nodes ) {
     for ( u32 i = offset; i < offset + num_nodes; ++i ) {
         nodes_hierarchy[ i ].parent = -1;
     }
+
+    sort_update_order = true;
 }
 
-void SceneGraph::update_matrices() {
+void SceneGraph::update_matrices( enki::TaskScheduler* task_scheduler ) {
+    ZoneScoped;
 
-    // TODO: per level update
-    u32 max_level = 0;
-    for ( u32 i = 0; i < nodes_hierarchy.size; ++i ) {
-        max_level = raptor::max(max_level, (u32)nodes_hierarchy[ i ].level );
+    sort_nodes();
+
+    if ( level_offsets.size < 2 ) {
+        return;
     }
-    u32 current_level = 0;
-    u32 nodes_visited = 0;
 
-    //i64 time = time_now();
-    while ( current_level <= max_level ) {
+    SceneGraphUpdateTask task;
+    task.scene_graph = this;
 
-        for ( u32 i = 0; i < nodes_hierarchy.size; ++i ) {
+    for ( u32 level = 0; level < level_offsets.size - 1; ++level ) {
+        const u32 begin = level_offsets[ level ];
+        const u32 count = level_offsets[ level + 1 ] - begin;
 
-            if ( nodes_hierarchy[ i ].level != current_level ) {
-                continue;
-            }
+        // Each level waits for the previous one, small levels are not worth the dispatch.
+        if ( task_scheduler == nullptr || count < k_scene_graph_parallel_nodes ) {
+            scene_graph_update_range( *this, begin, begin + count );
+            continue;
+        }
 
-            if ( updated_nodes.get_bit( i ) == 0 ) {
-                continue;
-            }
+        task.offset = begin;
+        task.m_SetSize = count;
+        task.m_MinRange = k_scene_graph_task_range;
+        task_scheduler->AddTaskSetToPipe( &task );
+        task_scheduler->WaitforTask( &task );
+    }
 
-            updated_nodes.clear_bit( i );
+    memset( updated_nodes.bits, 0, updated_nodes.size );
+}
 
-            if ( nodes_hierarchy[ i ].parent == -1 ) {
-                world_matrices[ i ] = local_matrices[ i ];
-            } else {
-                const mat4s& parent_matrix = world_matrices[ nodes_hierarchy[ i ].parent ];
-                world_matrices[ i ] = glms_mat4_mul( parent_matrix, local_matrices[ i ] );
-            }
+void SceneGraph::sort_nodes() {
+    if ( !sort_update_order ) {
+        return;
+    }
 
-            ++nodes_visited;
-        }
+    ZoneScoped;
 
-        ++current_level;
+    const u32 num_nodes = nodes_hierarchy.size;
+    u32 level_count = 0;
+    for ( u32 i = 0; i < num_nodes; ++i ) {
+        level_count = raptor::max( level_count, ( u32 )nodes_hierarchy[ i ].level + 1 );
     }
 
-    //rprint( "Updated scene graph in %fms\n", time_from_milliseconds( time ) );
+    // Counting sort by level, nodes keep their relative order inside a level.
+    level_offsets.set_size( level_count + 1 );
+    memset( level_offsets.data, 0, sizeof( u32 ) * level_offsets.size );
+    for ( u32 i = 0; i < num_nodes; ++i ) {
+        ++level_offsets[ nodes_hierarchy[ i ].level + 1 ];
+    }
+    for ( u32 level = 1; level <= level_count; ++level ) {
+        level_offsets[ level ] += level_offsets[ level - 1 ];
+    }
 
-    /*for ( u32 i = 0; i < nodes_hierarchy.size; ++i ) {
-        if ( updated_nodes.get_bit( i ) == 0 ) {
-            continue;
-        }
+    update_order.set_size( num_nodes );
+    update_parents.set_size( num_nodes );
+    dirty_nodes.set_size( num_nodes );
 
-        updated_nodes.clear_bit( i );
+    // Offsets are used as write cursors, leaving each one at the start of the next level.
+    for ( u32 i = 0; i < num_nodes; ++i ) {
+        const Hierarchy& hierarchy = nodes_hierarchy[ i ];
+        const u32 position = level_offsets[ hierarchy.level ]++;
+        update_order[ position ] = i;
+        update_parents[ position ] = hierarchy.parent;
 
-        if ( nodes_hierarchy[ i ].parent == -1 ) {
-            world_matrices[ i ] = local_matrices[ i ];
-        }
-        else {
-            const mat4s& parent_matrix = world_matrices[ nodes_hierarchy[ i ].parent ];
-            world_matrices[ i ] = glms_mat4_mul( parent_matrix, local_matrices[ i ] );
-        }
-    }*/
+        RASSERT( hierarchy.parent == -1 || ( u32 )nodes_hierarchy[ hierarchy.parent ].level < ( u32 )hierarchy.level );
+    }
+    for ( u32 level = level_count; level > 0; --level ) {
+        level_offsets[ level ] = level_offsets[ level - 1 ];
+    }
+    level_offsets[ 0 ] = 0;
+
+    memset( dirty_nodes.data, 0, num_nodes );
+
+    sort_update_order = false;
 }
 
 void SceneGraph::set_hierarchy( u32 node_index, u32 parent_index, u32 level ) {
@@ -123,4 +225,172 @@ u32 SceneGraph::node_count() {
     return nodes_hierarchy.size;
 }
 
+// Benchmark //////////////////////////////////////////////////////////////
+
+// Update used before the sorted order: all nodes are scanned once per level and only the ones
+// marked as updated are recomputed, children of moved nodes are not followed.
+static void scene_graph_update_matrices_scan( SceneGraph& scene_graph ) {
+    u32 max_level = 0;
+    for ( u32 i = 0; i < scene_graph.nodes_hierarchy.size; ++i ) {
+        max_level = raptor::max( max_level, ( u32 )scene_graph.nodes_hierarchy[ i ].level );
+    }
+
+    for ( u32 current_level = 0; current_level <= max_level; ++current_level ) {
+        for ( u32 i = 0; i < scene_graph.nodes_hierarchy.size; ++i ) {
+            const Hierarchy& hierarchy = scene_graph.nodes_hierarchy[ i ];
+            if ( ( u32 )hierarchy.level != current_level || scene_graph.updated_nodes.get_bit( i ) == 0 ) {
+                continue;
+            }
+
+            scene_graph.updated_nodes.clear_bit( i );
+
+            if ( hierarchy.parent == -1 ) {
+                scene_graph.world_matrices[ i ] = scene_graph.local_matrices[ i ];
+            } else {
+                scene_graph.world_matrices[ i ] = glms_mat4_mul( scene_graph.world_matrices[ hierarchy.parent ], scene_graph.local_matrices[ i ] );
+            }
+        }
+    }
+}
+
+static u32 scene_graph_benchmark_random( u32& state ) {
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+// Random recursive tree: each node picks an earlier node as parent, about one in a thousand is a root.
+static void scene_graph_benchmark_fill( SceneGraph& scene_graph, u32 num_nodes ) {
+    scene_graph.resize( num_nodes );
+    scene_graph.init_new_nodes( 0, num_nodes );
+
+    u32 state = 17;
+    for ( u32 i = 0; i < num_nodes; ++i ) {
+        const f32 angle = ( scene_graph_benchmark_random( state ) % 360 ) * ( rpi / 180.f );
+        const vec3s translation{ ( scene_graph_benchmark_random( state ) % 100 ) * 0.01f, 0.5f, 0.f };
+        scene_graph.set_local_matrix( i, glms_mat4_mul( glms_translate_make( translation ), glms_rotate_make( angle, vec3s{ 0.f, 1.f, 0.f } ) ) );
+
+        if ( i == 0 || scene_graph_benchmark_random( state ) % 1000 == 0 ) {
+            continue;
+        }
+
+        const u32 parent = scene_graph_benchmark_random( state ) % i;
+        const u32 level = scene_graph.nodes_hierarchy[ parent ].level + 1;
+        // Levels are stored in 8 signed bits.
+        if ( level < 128 ) {
+            scene_graph.set_hierarchy( i, parent, level );
+        }
+    }
+}
+
+static void scene_graph_benchmark_mark_all( SceneGraph& scene_graph ) {
+    memset( scene_graph.updated_nodes.bits, 0xff, scene_graph.updated_nodes.size );
+}
+
+static void scene_graph_benchmark_mark_some( SceneGraph& scene_graph, u32 one_in ) {
+    u32 state = 29;
+    for ( u32 i = 0; i < scene_graph.node_count(); ++i ) {
+        if ( scene_graph_benchmark_random( state ) % one_in == 0 ) {
+            scene_graph.updated_nodes.set_bit( i );
+        }
+    }
+}
+
+static f32 scene_graph_benchmark_difference( const mat4s* a, const mat4s* b, u32 count ) {
+    f32 max_difference = 0.f;
+    for ( u32 i = 0; i < count; ++i ) {
+        for ( u32 e = 0; e < 16; ++e ) {
+            max_difference = raptor::max( max_difference, fabsf( a[ i ].raw[ e / 4 ][ e % 4 ] - b[ i ].raw[ e / 4 ][ e % 4 ] ) );
+        }
+    }
+    return max_difference;
+}
+
+//
+//
+struct SceneGraphBenchmarkCase {
+    cstring                 name;
+    bool                    scan;
+    bool                    parallel;
+    u32                     mark_one_in;    // 1 marks all nodes.
+}; // struct SceneGraphBenchmarkCase
+
+void scene_graph_benchmark( enki::TaskScheduler* task_scheduler, Allocator* allocator ) {
+    static const u32 k_node_counts[] = { 10000, 100000, 1000000 };
+    static const u32 k_iterations = 5;
+
+    static const SceneGraphBenchmarkCase k_cases[] = {
+        { "full, level scan       ", true,  false, 1 },
+        { "full, sorted           ", false, false, 1 },
+        { "full, sorted parallel  ", false, true,  1 },
+        { "1%, sorted             ", false, false, 100 },
+        { "1%, sorted parallel    ", false, true,  100 },
+    };
+
+    rprint( "Scene graph benchmark, %s, %u task threads, best of %u runs\n", k_scene_graph_simd_name,
+            task_scheduler ? task_scheduler->GetNumTaskThreads() : 0, k_iterations );
+
+    for ( u32 n = 0; n < ArraySize( k_node_counts ); ++n ) {
+        const u32 num_nodes = k_node_counts[ n ];
+
+        SceneGraph scene_graph;
+        scene_graph.init( allocator, num_nodes );
+        scene_graph_benchmark_fill( scene_graph, num_nodes );
+
+        i64 begin_time = time_now();
+        scene_graph.sort_nodes();
+        const f64 sort_ms = time_from_milliseconds( begin_time );
+
+        u32 widest_level = 0;
+        for ( u32 level = 0; level < scene_graph.level_offsets.size - 1; ++level ) {
+            widest_level = raptor::max( widest_level, scene_graph.level_offsets[ level + 1 ] - scene_graph.level_offsets[ level ] );
+        }
+
+        rprint( "    %7u nodes, %3u levels, widest %6u nodes, sort %6.2f ms\n", num_nodes, scene_graph.level_offsets.size - 1, widest_level, sort_ms );
+
+        // Full serial update as reference for the other cases.
+        Array<mat4s> reference;
+        reference.init( allocator, num_nodes, num_nodes );
+        scene_graph_benchmark_mark_all( scene_graph );
+        scene_graph.update_matrices();
+        memcpy( reference.data, scene_graph.world_matrices.data, sizeof( mat4s ) * num_nodes );
+
+        for ( u32 c = 0; c < ArraySize( k_cases ); ++c ) {
+            const SceneGraphBenchmarkCase& bench = k_cases[ c ];
+
+            f64 best_ms = 1e30;
+            for ( u32 i = 0; i < k_iterations; ++i ) {
+                if ( bench.mark_one_in == 1 ) {
+                    scene_graph_benchmark_mark_all( scene_graph );
+                } else {
+                    scene_graph_benchmark_mark_some( scene_graph, bench.mark_one_in );
+                }
+
+                begin_time = time_now();
+                if ( bench.scan ) {
+                    scene_graph_update_matrices_scan( scene_graph );
+                } else {
+                    scene_graph.update_matrices( bench.parallel ? task_scheduler : nullptr );
+                }
+                const f64 ms = time_from_milliseconds( begin_time );
+                best_ms = ms < best_ms ? ms : best_ms;
+            }
+
+            u32 recomputed = num_nodes;
+            if ( !bench.scan ) {
+                recomputed = 0;
+                for ( u32 i = 0; i < num_nodes; ++i ) {
+                    recomputed += scene_graph.dirty_nodes[ i ];
+                }
+            }
+
+            const f32 difference = scene_graph_benchmark_difference( reference.data, scene_graph.world_matrices.data, num_nodes );
+            rprint( "        %s: %8.3f ms, %7u nodes recomputed, %7.1f M nodes/s, max difference %g\n", bench.name, best_ms, recomputed,
+                    recomputed / ( best_ms * 1e-3 * 1e6 ), difference );
+        }
+
+        reference.shutdown();
+        scene_graph.shutdown();
+    }
+}
+
 } // namespace raptor
@@ -5,6 +5,8 @@
 
 #include "external/cglm/struct/mat4.h"
 
+namespace enki { class TaskScheduler; }
+
 namespace raptor {
 
 //
@@ -19,6 +21,14 @@ struct SceneGraphNodeDebugData {
 }; // struct SceneGraphNodeDebugData
 
 
+// Scene graph ////////////////////////////////////////////////////////////
+//
+// Node indices never change, meshes and skins keep referencing them. Updates walk an order sorted
+// by level instead, so parents are always computed before their children and each level is a
+// contiguous range that can be split between threads: nodes of a level only read the world
+// matrices of the level above.
+// A node is recomputed when its local matrix or hierarchy changed or when its parent was recomputed.
+
 //
 //
 struct SceneGraph {
@@ -28,7 +38,10 @@ struct SceneGraph {
 
     void                init_new_nodes( u32 offset, u32 num_nodes );
     void                resize( u32 num_nodes );
-    void                update_matrices();
+    // Levels with enough nodes are split between the task threads if a task scheduler is given.
+    void                update_matrices( enki::TaskScheduler* task_scheduler = nullptr );
+    // Rebuild the update order when the hierarchy changed, called by update_matrices.
+    void                sort_nodes();
 
     void                set_hierarchy( u32 node_index, u32 parent_index, u32 level );
     void                set_local_matrix( u32 node_index, const mat4s& local_matrix );
@@ -43,8 +56,17 @@ struct SceneGraph {
 
     BitSet              updated_nodes;
 
+    Array<u32>          update_order;       // Node indices sorted by level, breadth first.
+    Array<i32>          update_parents;     // Parent of each node of update_order, -1 for roots.
+    Array<u32>          level_offsets;      // First entry of update_order for each level, then the node count.
+    Array<u8>           dirty_nodes;        // Per node, set during the update when the node was recomputed.
+
     bool                sort_update_order = true;
 
 }; // struct SceneGraph
 
+// Build synthetic hierarchies of 10K, 100K and 1M nodes and time full and partial updates
+// with the per level scan, the sorted order and the sorted order split between task threads.
+void                    scene_graph_benchmark( enki::TaskScheduler* task_scheduler, Allocator* allocator );
+
 } // namespace raptor
@@ -0,0 +1,193 @@
+#include "graphics/skinning.hpp"
+#include "graphics/scene_graph.hpp"
+
+#include "foundation/log.hpp"
+#include "foundation/memory.hpp"
+#include "foundation/numerics.hpp"
+#include "foundation/simd.hpp"
+#include "foundation/time.hpp"
+
+#include "external/cglm/struct/affine.h"
+#include "external/cglm/struct/mat4.h"
+#include "external/tracy/tracy/Tracy.hpp"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace raptor {
+
+#if defined(RAPTOR_SIMD_AVX)
+static cstring k_skinning_simd_name = "AVX";
+#elif defined(RAPTOR_SIMD_SSE2)
+static cstring k_skinning_simd_name = "SSE2";
+#else
+static cstring k_skinning_simd_name = "scalar";
+#endif
+
+// Palette ////////////////////////////////////////////////////////////////
+
+#if !defined(RAPTOR_SIMD_SCALAR)
+
+template <bool Stream>
+static void skinning_compute_palette_simd( const mat4s* world_matrices, const i32* joints, const mat4s* inverse_bind_matrices, u32 joint_count, mat4s* palette ) {
+    for ( u32 i = 0; i < joint_count; ++i ) {
+        simd_mat4_mul<Stream>( world_matrices[ joints[ i ] ], inverse_bind_matrices[ i ], palette[ i ] );
+    }
+}
+
+#endif // !RAPTOR_SIMD_SCALAR
+
+void skinning_compute_palette( const mat4s* world_matrices, const i32* joints, const mat4s* inverse_bind_matrices, u32 joint_count, mat4s* palette ) {
+#if defined(RAPTOR_SIMD_SCALAR)
+    for ( u32 i = 0; i < joint_count; ++i ) {
+        palette[ i ] = glms_mat4_mul( world_matrices[ joints[ i ] ], inverse_bind_matrices[ i ] );
+    }
+#else
+    if ( ( ( uintptr_t )palette & ( k_simd_stream_alignment - 1 ) ) == 0 ) {
+        skinning_compute_palette_simd<true>( world_matrices, joints, inverse_bind_matrices, joint_count, palette );
+        // Streaming stores are weakly ordered, make them visible before the buffer is handed to the gpu.
+        _mm_sfence();
+    } else {
+        skinning_compute_palette_simd<false>( world_matrices, joints, inverse_bind_matrices, joint_count, palette );
+    }
+#endif
+}
+
+// Benchmark //////////////////////////////////////////////////////////////
+
+// Previous update_joints: every joint multiplies the local matrices of all its ancestors.
+static void skinning_benchmark_palette_walk( SceneGraph& scene_graph, const i32* joints, const mat4s* inverse_bind_matrices, u32 joint_count, mat4s* palette ) {
+    for ( u32 i = 0; i < joint_count; ++i ) {
+        mat4s node_transform = scene_graph.local_matrices[ joints[ i ] ];
+
+        i32 parent = scene_graph.nodes_hierarchy[ joints[ i ] ].parent;
+        while ( parent >= 0 ) {
+            node_transform = glms_mat4_mul( scene_graph.local_matrices[ parent ], node_transform );
+            parent = scene_graph.nodes_hierarchy[ parent ].parent;
+        }
+
+        palette[ i ] = glms_mat4_mul( node_transform, inverse_bind_matrices[ i ] );
+    }
+}
+
+static u32 skinning_benchmark_random( u32& state ) {
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+//
+//
+struct SkinningBenchmarkCase {
+    cstring                 name;
+    bool                    walk;
+    bool                    scene_graph;    // Include the scene graph update.
+}; // struct SkinningBenchmarkCase
+
+void skinning_benchmark( Allocator* allocator ) {
+    static const u32 k_joint_counts[] = { 32, 128, 512 };
+    static const u32 k_skin_counts[] = { 16, 256 };
+    static const u32 k_iterations = 5;
+
+    static const SkinningBenchmarkCase k_cases[] = {
+        { "parent walk            ", true,  false },
+        { "scene graph + palette  ", false, true },
+        { "palette                ", false, false },
+    };
+
+    rprint( "Skinning benchmark, %s, best of %u runs\n", k_skinning_simd_name, k_iterations );
+
+    for ( u32 j = 0; j < ArraySize( k_joint_counts ); ++j ) {
+        for ( u32 s = 0; s < ArraySize( k_skin_counts ); ++s ) {
+            const u32 joint_count = k_joint_counts[ j ];
+            const u32 skin_count = k_skin_counts[ s ];
+            const u32 node_count = joint_count * skin_count;
+
+            // Skeletons are chains with short branches, each joint hangs from one of the four previous ones.
+            SceneGraph scene_graph;
+            scene_graph.init( allocator, node_count );
+            scene_graph.resize( node_count );
+            scene_graph.init_new_nodes( 0, node_count );
+
+            u32 state = 11;
+            u32 max_level = 0;
+            for ( u32 n = 0; n < node_count; ++n ) {
+                const f32 angle = ( skinning_benchmark_random( state ) % 90 ) * ( rpi / 180.f ) - rpi * 0.25f;
+                scene_graph.set_local_matrix( n, glms_mat4_mul( glms_translate_make( vec3s{ 0.f, 0.1f, 0.f } ), glms_rotate_make( angle, vec3s{ 0.f, 0.f, 1.f } ) ) );
+
+                const u32 joint = n % joint_count;
+                if ( joint > 0 ) {
+                    const u32 parent = n - 1 - skinning_benchmark_random( state ) % raptor::min( joint, 4u );
+                    const u32 level = scene_graph.nodes_hierarchy[ parent ].level + 1;
+                    // Levels are stored in 8 signed bits, deeper joints start a new root.
+                    if ( level < 128 ) {
+                        scene_graph.set_hierarchy( n, parent, level );
+                        max_level = raptor::max( max_level, level );
+                    }
+                }
+            }
+
+            // Inverse bind matrices of the rest pose, palettes start as identities.
+            memset( scene_graph.updated_nodes.bits, 0xff, scene_graph.updated_nodes.size );
+            scene_graph.update_matrices();
+
+            i32* joints = ( i32* )ralloca( sizeof( i32 ) * node_count, allocator );
+            mat4s* inverse_bind_matrices = ( mat4s* )rallocaa( sizeof( mat4s ) * node_count, allocator, 64 );
+            mat4s* palette = ( mat4s* )rallocaa( sizeof( mat4s ) * node_count, allocator, 64 );
+            mat4s* reference = ( mat4s* )rallocaa( sizeof( mat4s ) * node_count, allocator, 64 );
+            for ( u32 n = 0; n < node_count; ++n ) {
+                joints[ n ] = n;
+                inverse_bind_matrices[ n ] = glms_mat4_inv( scene_graph.world_matrices[ n ] );
+            }
+
+            rprint( "    %3u joints, %3u skins, depth %3u\n", joint_count, skin_count, max_level + 1 );
+
+            for ( u32 c = 0; c < ArraySize( k_cases ); ++c ) {
+                const SkinningBenchmarkCase& bench = k_cases[ c ];
+
+                f64 best_ms = 1e30;
+                for ( u32 i = 0; i < k_iterations; ++i ) {
+                    memset( scene_graph.updated_nodes.bits, 0xff, scene_graph.updated_nodes.size );
+
+                    const i64 begin_time = time_now();
+                    if ( bench.scene_graph ) {
+                        scene_graph.update_matrices();
+                    }
+
+                    for ( u32 skin = 0; skin < skin_count; ++skin ) {
+                        const u32 offset = skin * joint_count;
+                        if ( bench.walk ) {
+                            skinning_benchmark_palette_walk( scene_graph, joints + offset, inverse_bind_matrices + offset, joint_count, palette + offset );
+                        } else {
+                            skinning_compute_palette( scene_graph.world_matrices.data, joints + offset, inverse_bind_matrices + offset, joint_count, palette + offset );
+                        }
+                    }
+                    const f64 ms = time_from_milliseconds( begin_time );
+                    best_ms = ms < best_ms ? ms : best_ms;
+                }
+
+                if ( bench.walk ) {
+                    memcpy( reference, palette, sizeof( mat4s ) * node_count );
+                }
+
+                f32 max_difference = 0.f;
+                for ( u32 n = 0; n < node_count; ++n ) {
+                    for ( u32 e = 0; e < 16; ++e ) {
+                        max_difference = raptor::max( max_difference, fabsf( reference[ n ].raw[ e / 4 ][ e % 4 ] - palette[ n ].raw[ e / 4 ][ e % 4 ] ) );
+                    }
+                }
+
+                rprint( "        %s: %8.3f ms, %7.1f M joints/s, max difference with the walk %g\n", bench.name, best_ms,
+                        node_count / ( best_ms * 1e-3 * 1e6 ), max_difference );
+            }
+
+            rfree( reference, allocator );
+            rfree( palette, allocator );
+            rfree( inverse_bind_matrices, allocator );
+            rfree( joints, allocator );
+            scene_graph.shutdown();
+        }
+    }
+}
+
+} // namespace raptor
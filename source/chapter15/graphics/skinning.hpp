@@ -0,0 +1,25 @@
+#pragma once
+
+#include "foundation/platform.hpp"
+
+#include "external/cglm/types-struct.h"
+
+namespace raptor {
+
+    struct Allocator;
+
+    // Skinning ///////////////////////////////////////////////////////////
+    //
+    // Joint matrices are the scene graph world matrices of the joints, computed once per node in level
+    // order, times their inverse bind matrices. The palette usually goes to mapped gpu memory that is
+    // never read back, so it is written with streaming stores when the destination is aligned.
+
+    // palette[ i ] = world_matrices[ joints[ i ] ] * inverse_bind_matrices[ i ].
+    void                        skinning_compute_palette( const mat4s* world_matrices, const i32* joints, const mat4s* inverse_bind_matrices,
+                                                          u32 joint_count, mat4s* palette );
+
+    // Compute the palettes of skeletons of 32 to 512 joints for 16 and 256 skins, walking the parents
+    // of each joint as before, and from the scene graph world matrices with and without their update.
+    void                        skinning_benchmark( Allocator* allocator );
+
+} // namespace raptor
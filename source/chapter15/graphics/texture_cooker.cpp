@@ -0,0 +1,1047 @@
+#include "graphics/texture_cooker.hpp"
+#include "graphics/texture_mips.hpp"
+
+#include "foundation/assert.hpp"
+#include "foundation/file.hpp"
+#include "foundation/hash_map.hpp"
+#include "foundation/memory.hpp"
+#include "foundation/string.hpp"
+#include "foundation/time.hpp"
+
+#include "external/stb_image.h"
+
+#include "external/tracy/tracy/Tracy.hpp"
+
+#include <math.h>
+#include <string.h>
+
+namespace raptor {
+
+static inline i32 clamp_i32( i32 value, i32 min_value, i32 max_value ) {
+    return value < min_value ? min_value : ( value > max_value ? max_value : value );
+}
+
+// Principal axis of the block colors, num_channels up to 4. Returns false for a flat block.
+static bool block_principal_axis( const u8* rgba, u32 num_channels, f32* mean, f32* axis ) {
+    for ( u32 c = 0; c < num_channels; ++c ) {
+        mean[ c ] = 0.f;
+        for ( u32 i = 0; i < 16; ++i ) {
+            mean[ c ] += rgba[ i * 4 + c ];
+        }
+        mean[ c ] /= 16.f;
+    }
+
+    f32 covariance[ 4 ][ 4 ] = { };
+    for ( u32 i = 0; i < 16; ++i ) {
+        f32 d[ 4 ];
+        for ( u32 c = 0; c < num_channels; ++c ) {
+            d[ c ] = rgba[ i * 4 + c ] - mean[ c ];
+        }
+        for ( u32 r = 0; r < num_channels; ++r ) {
+            for ( u32 c = 0; c < num_channels; ++c ) {
+                covariance[ r ][ c ] += d[ r ] * d[ c ];
+            }
+        }
+    }
+
+    // Power iteration, starting from the diagonal to avoid a starting vector orthogonal to the axis.
+    for ( u32 c = 0; c < num_channels; ++c ) {
+        axis[ c ] = covariance[ c ][ c ] + 1.f;
+    }
+
+    f32 length = 0.f;
+    for ( u32 iteration = 0; iteration < 8; ++iteration ) {
+        f32 next[ 4 ] = { };
+        for ( u32 r = 0; r < num_channels; ++r ) {
+            for ( u32 c = 0; c < num_channels; ++c ) {
+                next[ r ] += covariance[ r ][ c ] * axis[ c ];
+            }
+        }
+
+        length = 0.f;
+        for ( u32 c = 0; c < num_channels; ++c ) {
+            length += next[ c ] * next[ c ];
+        }
+        length = sqrtf( length );
+        if ( length < 1e-6f ) {
+            return false;
+        }
+
+        for ( u32 c = 0; c < num_channels; ++c ) {
+            axis[ c ] = next[ c ] / length;
+        }
+    }
+
+    return true;
+}
+
+// Endpoints along the principal axis, at the extremes of the projected colors.
+static void block_axis_endpoints( const u8* rgba, u32 num_channels, f32* endpoint_min, f32* endpoint_max ) {
+    f32 mean[ 4 ], axis[ 4 ];
+    if ( !block_principal_axis( rgba, num_channels, mean, axis ) ) {
+        for ( u32 c = 0; c < num_channels; ++c ) {
+            endpoint_min[ c ] = endpoint_max[ c ] = mean[ c ];
+        }
+        return;
+    }
+
+    f32 min_t = 1e10f, max_t = -1e10f;
+    for ( u32 i = 0; i < 16; ++i ) {
+        f32 t = 0.f;
+        for ( u32 c = 0; c < num_channels; ++c ) {
+            t += ( rgba[ i * 4 + c ] - mean[ c ] ) * axis[ c ];
+        }
+        min_t = t < min_t ? t : min_t;
+        max_t = t > max_t ? t : max_t;
+    }
+
+    for ( u32 c = 0; c < num_channels; ++c ) {
+        endpoint_min[ c ] = mean[ c ] + axis[ c ] * min_t;
+        endpoint_max[ c ] = mean[ c ] + axis[ c ] * max_t;
+    }
+}
+
+// Least squares endpoints for fixed interpolation weights in [0, 1] from endpoint a to endpoint b.
+static bool block_least_squares_endpoints( const u8* rgba, u32 num_channels, const f32* weights, f32* a, f32* b ) {
+    f32 alpha2 = 0.f, beta2 = 0.f, alphabeta = 0.f;
+    f32 alphax[ 4 ] = { }, betax[ 4 ] = { };
+
+    for ( u32 i = 0; i < 16; ++i ) {
+        const f32 beta = weights[ i ];
+        const f32 alpha = 1.f - beta;
+
+        alpha2 += alpha * alpha;
+        beta2 += beta * beta;
+        alphabeta += alpha * beta;
+
+        for ( u32 c = 0; c < num_channels; ++c ) {
+            alphax[ c ] += alpha * rgba[ i * 4 + c ];
+            betax[ c ] += beta * rgba[ i * 4 + c ];
+        }
+    }
+
+    const f32 determinant = alpha2 * beta2 - alphabeta * alphabeta;
+    if ( fabsf( determinant ) < 1e-6f ) {
+        return false;
+    }
+
+    const f32 inverse_determinant = 1.f / determinant;
+    for ( u32 c = 0; c < num_channels; ++c ) {
+        a[ c ] = ( alphax[ c ] * beta2 - betax[ c ] * alphabeta ) * inverse_determinant;
+        b[ c ] = ( betax[ c ] * alpha2 - alphax[ c ] * alphabeta ) * inverse_determinant;
+    }
+
+    return true;
+}
+
+// BC1 ////////////////////////////////////////////////////////////////////
+
+static u16 pack_565( const f32* color ) {
+    const i32 r = clamp_i32( ( i32 )( color[ 0 ] * 31.f / 255.f + 0.5f ), 0, 31 );
+    const i32 g = clamp_i32( ( i32 )( color[ 1 ] * 63.f / 255.f + 0.5f ), 0, 63 );
+    const i32 b = clamp_i32( ( i32 )( color[ 2 ] * 31.f / 255.f + 0.5f ), 0, 31 );
+    return ( u16 )( ( r << 11 ) | ( g << 5 ) | b );
+}
+
+static void unpack_565( u16 color, i32* rgb ) {
+    const i32 r = ( color >> 11 ) & 31;
+    const i32 g = ( color >> 5 ) & 63;
+    const i32 b = color & 31;
+    rgb[ 0 ] = ( r << 3 ) | ( r >> 2 );
+    rgb[ 1 ] = ( g << 2 ) | ( g >> 4 );
+    rgb[ 2 ] = ( b << 3 ) | ( b >> 2 );
+}
+
+static void bc1_palette( u16 color0, u16 color1, i32 palette[ 4 ][ 3 ] ) {
+    unpack_565( color0, palette[ 0 ] );
+    unpack_565( color1, palette[ 1 ] );
+
+    for ( u32 c = 0; c < 3; ++c ) {
+        if ( color0 > color1 ) {
+            palette[ 2 ][ c ] = ( 2 * palette[ 0 ][ c ] + palette[ 1 ][ c ] ) / 3;
+            palette[ 3 ][ c ] = ( palette[ 0 ][ c ] + 2 * palette[ 1 ][ c ] ) / 3;
+        }
+        else {
+            palette[ 2 ][ c ] = ( palette[ 0 ][ c ] + palette[ 1 ][ c ] ) / 2;
+            palette[ 3 ][ c ] = 0;
+        }
+    }
+}
+
+// Nearest palette entry for each pixel, returns the squared error.
+static u32 bc1_fit_indices( const u8* rgba, u16 color0, u16 color1, u32* indices ) {
+    i32 palette[ 4 ][ 3 ];
+    bc1_palette( color0, color1, palette );
+
+    u32 error = 0;
+    for ( u32 i = 0; i < 16; ++i ) {
+        u32 best_error = u32_max;
+        for ( u32 p = 0; p < 4; ++p ) {
+            const i32 dr = rgba[ i * 4 + 0 ] - palette[ p ][ 0 ];
+            const i32 dg = rgba[ i * 4 + 1 ] - palette[ p ][ 1 ];
+            const i32 db = rgba[ i * 4 + 2 ] - palette[ p ][ 2 ];
+            const u32 pixel_error = ( u32 )( dr * dr + dg * dg + db * db );
+            if ( pixel_error < best_error ) {
+                best_error = pixel_error;
+                indices[ i ] = p;
+            }
+        }
+        error += best_error;
+    }
+
+    return error;
+}
+
+// Order the endpoints for the 4 colors mode, remapping the indices.
+static void bc1_order_endpoints( u16* color0, u16* color1, u32* indices ) {
+    if ( *color0 < *color1 ) {
+        const u16 temp = *color0;
+        *color0 = *color1;
+        *color1 = temp;
+        for ( u32 i = 0; i < 16; ++i ) {
+            indices[ i ] ^= 1;
+        }
+    }
+    else if ( *color0 == *color1 ) {
+        for ( u32 i = 0; i < 16; ++i ) {
+            indices[ i ] = 0;
+        }
+    }
+}
+
+static void bc1_write_block( u16 color0, u16 color1, const u32* indices, u8* output ) {
+    output[ 0 ] = ( u8 )( color0 & 0xff );
+    output[ 1 ] = ( u8 )( color0 >> 8 );
+    output[ 2 ] = ( u8 )( color1 & 0xff );
+    output[ 3 ] = ( u8 )( color1 >> 8 );
+
+    u32 bits = 0;
+    for ( u32 i = 0; i < 16; ++i ) {
+        bits |= indices[ i ] << ( i * 2 );
+    }
+    memcpy( output + 4, &bits, 4 );
+}
+
+void bc1_compress_block( const u8* rgba, u8* output ) {
+    f32 endpoint_min[ 3 ], endpoint_max[ 3 ];
+    block_axis_endpoints( rgba, 3, endpoint_min, endpoint_max );
+
+    // Inset the bounding line, extremes are rarely hit after the quantization.
+    for ( u32 c = 0; c < 3; ++c ) {
+        const f32 inset = ( endpoint_max[ c ] - endpoint_min[ c ] ) / 16.f;
+        endpoint_max[ c ] -= inset;
+        endpoint_min[ c ] += inset;
+    }
+
+    u16 color0 = pack_565( endpoint_max );
+    u16 color1 = pack_565( endpoint_min );
+    if ( color0 < color1 ) {
+        const u16 temp = color0;
+        color0 = color1;
+        color1 = temp;
+    }
+
+    u32 indices[ 16 ];
+    u32 error = bc1_fit_indices( rgba, color0, color1, indices );
+
+    // One refinement pass with the endpoints fitted to the chosen indices.
+    if ( color0 != color1 ) {
+        static const f32 k_index_weights[ 4 ] = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+
+        f32 weights[ 16 ];
+        for ( u32 i = 0; i < 16; ++i ) {
+            weights[ i ] = k_index_weights[ indices[ i ] ];
+        }
+
+        f32 a[ 3 ], b[ 3 ];
+        if ( block_least_squares_endpoints( rgba, 3, weights, a, b ) ) {
+            u16 refined0 = pack_565( a );
+            u16 refined1 = pack_565( b );
+            if ( refined0 < refined1 ) {
+                const u16 temp = refined0;
+                refined0 = refined1;
+                refined1 = temp;
+            }
+
+            u32 refined_indices[ 16 ];
+            const u32 refined_error = refined0 != refined1 ? bc1_fit_indices( rgba, refined0, refined1, refined_indices ) : u32_max;
+            if ( refined_error < error ) {
+                color0 = refined0;
+                color1 = refined1;
+                memcpy( indices, refined_indices, sizeof( indices ) );
+            }
+        }
+    }
+
+    bc1_order_endpoints( &color0, &color1, indices );
+    bc1_write_block( color0, color1, indices, output );
+}
+
+void bc1_decompress_block( const u8* block, u8* rgba ) {
+    const u16 color0 = ( u16 )( block[ 0 ] | ( block[ 1 ] << 8 ) );
+    const u16 color1 = ( u16 )( block[ 2 ] | ( block[ 3 ] << 8 ) );
+
+    i32 palette[ 4 ][ 3 ];
+    bc1_palette( color0, color1, palette );
+
+    u32 bits;
+    memcpy( &bits, block + 4, 4 );
+    for ( u32 i = 0; i < 16; ++i ) {
+        const u32 index = ( bits >> ( i * 2 ) ) & 3;
+        rgba[ i * 4 + 0 ] = ( u8 )palette[ index ][ 0 ];
+        rgba[ i * 4 + 1 ] = ( u8 )palette[ index ][ 1 ];
+        rgba[ i * 4 + 2 ] = ( u8 )palette[ index ][ 2 ];
+        rgba[ i * 4 + 3 ] = ( color0 <= color1 && index == 3 ) ? 0 : 255;
+    }
+}
+
+// BC4, BC3 and BC5 ///////////////////////////////////////////////////////
+
+void bc4_compress_block( const u8* rgba, u32 channel, u8* output ) {
+    i32 min_value = 255, max_value = 0;
+    for ( u32 i = 0; i < 16; ++i ) {
+        const i32 value = rgba[ i * 4 + channel ];
+        min_value = value < min_value ? value : min_value;
+        max_value = value > max_value ? value : max_value;
+    }
+
+    // 8 values mode: endpoint 0 is the maximum, indices 2 to 7 interpolate towards the minimum.
+    output[ 0 ] = ( u8 )max_value;
+    output[ 1 ] = ( u8 )min_value;
+
+    u64 bits = 0;
+    if ( max_value > min_value ) {
+        const i32 range = max_value - min_value;
+        for ( u32 i = 0; i < 16; ++i ) {
+            const i32 step = ( ( max_value - rgba[ i * 4 + channel ] ) * 14 + range ) / ( 2 * range );
+            const u64 index = step == 0 ? 0 : ( step == 7 ? 1 : step + 1 );
+            bits |= index << ( i * 3 );
+        }
+    }
+
+    for ( u32 i = 0; i < 6; ++i ) {
+        output[ 2 + i ] = ( u8 )( bits >> ( i * 8 ) );
+    }
+}
+
+void bc4_decompress_block( const u8* block, u32 channel, u8* rgba ) {
+    const i32 value0 = block[ 0 ];
+    const i32 value1 = block[ 1 ];
+
+    i32 palette[ 8 ];
+    palette[ 0 ] = value0;
+    palette[ 1 ] = value1;
+    if ( value0 > value1 ) {
+        for ( i32 i = 2; i < 8; ++i ) {
+            palette[ i ] = ( ( 8 - i ) * value0 + ( i - 1 ) * value1 + 3 ) / 7;
+        }
+    }
+    else {
+        for ( i32 i = 2; i < 6; ++i ) {
+            palette[ i ] = ( ( 6 - i ) * value0 + ( i - 1 ) * value1 + 2 ) / 5;
+        }
+        palette[ 6 ] = 0;
+        palette[ 7 ] = 255;
+    }
+
+    u64 bits = 0;
+    for ( u32 i = 0; i < 6; ++i ) {
+        bits |= ( u64 )block[ 2 + i ] << ( i * 8 );
+    }
+
+    for ( u32 i = 0; i < 16; ++i ) {
+        rgba[ i * 4 + channel ] = ( u8 )palette[ ( bits >> ( i * 3 ) ) & 7 ];
+    }
+}
+
+void bc3_compress_block( const u8* rgba, u8* output ) {
+    bc4_compress_block( rgba, 3, output );
+    bc1_compress_block( rgba, output + 8 );
+}
+
+void bc5_compress_block( const u8* rgba, u8* output ) {
+    bc4_compress_block( rgba, 0, output );
+    bc4_compress_block( rgba, 1, output + 8 );
+}
+
+// BC7 ////////////////////////////////////////////////////////////////////
+
+static const i32 k_bc7_weights4[ 16 ] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+//
+//
+struct Bc7Mode6Block {
+    i32                             endpoints[ 2 ][ 4 ];    // 7 bits per channel.
+    i32                             pbits[ 2 ];
+    u32                             indices[ 16 ];
+    u32                             error;
+}; // struct Bc7Mode6Block
+
+static inline i32 bc7_interpolate( i32 value0, i32 value1, i32 weight ) {
+    return ( ( 64 - weight ) * value0 + weight * value1 + 32 ) >> 6;
+}
+
+// Nearest index for each pixel, the weights are almost linear so only the neighbours of the projection are tested.
+static u32 bc7_mode6_fit_indices( const u8* rgba, Bc7Mode6Block& block ) {
+    i32 value0[ 4 ], value1[ 4 ], direction[ 4 ];
+    i32 direction_length = 0;
+    for ( u32 c = 0; c < 4; ++c ) {
+        value0[ c ] = ( block.endpoints[ 0 ][ c ] << 1 ) | block.pbits[ 0 ];
+        value1[ c ] = ( block.endpoints[ 1 ][ c ] << 1 ) | block.pbits[ 1 ];
+        direction[ c ] = value1[ c ] - value0[ c ];
+        direction_length += direction[ c ] * direction[ c ];
+    }
+
+    i32 palette[ 16 ][ 4 ];
+    for ( u32 index = 0; index < 16; ++index ) {
+        for ( u32 c = 0; c < 4; ++c ) {
+            palette[ index ][ c ] = bc7_interpolate( value0[ c ], value1[ c ], k_bc7_weights4[ index ] );
+        }
+    }
+    const f32 projection_scale = direction_length ? 15.f / direction_length : 0.f;
+
+    u32 error = 0;
+    for ( u32 i = 0; i < 16; ++i ) {
+        const u8* pixel = rgba + i * 4;
+
+        i32 dot = 0;
+        for ( u32 c = 0; c < 4; ++c ) {
+            dot += ( pixel[ c ] - value0[ c ] ) * direction[ c ];
+        }
+        const i32 projection = clamp_i32( ( i32 )( ( f32 )dot * projection_scale + 0.5f ), 0, 15 );
+
+        u32 best_error = u32_max;
+        const i32 first = projection > 0 ? projection - 1 : 0;
+        const i32 last = projection < 15 ? projection + 1 : 15;
+        for ( i32 index = first; index <= last; ++index ) {
+            u32 pixel_error = 0;
+            for ( u32 c = 0; c < 4; ++c ) {
+                const i32 d = pixel[ c ] - palette[ index ][ c ];
+                pixel_error += ( u32 )( d * d );
+            }
+            if ( pixel_error < best_error ) {
+                best_error = pixel_error;
+                block.indices[ i ] = ( u32 )index;
+            }
+        }
+        error += best_error;
+    }
+
+    block.error = error;
+    return error;
+}
+
+// Quantize to 7 bits endpoints testing the four p-bits combinations, keeps the best in block.
+static void bc7_mode6_quantize( const u8* rgba, const f32* endpoint0, const f32* endpoint1, Bc7Mode6Block& best ) {
+    for ( i32 p0 = 0; p0 < 2; ++p0 ) {
+        for ( i32 p1 = 0; p1 < 2; ++p1 ) {
+            Bc7Mode6Block block;
+            block.pbits[ 0 ] = p0;
+            block.pbits[ 1 ] = p1;
+            for ( u32 c = 0; c < 4; ++c ) {
+                block.endpoints[ 0 ][ c ] = clamp_i32( ( i32 )( ( endpoint0[ c ] - p0 ) * 0.5f + 0.5f ), 0, 127 );
+                block.endpoints[ 1 ][ c ] = clamp_i32( ( i32 )( ( endpoint1[ c ] - p1 ) * 0.5f + 0.5f ), 0, 127 );
+            }
+
+            if ( bc7_mode6_fit_indices( rgba, block ) < best.error ) {
+                best = block;
+            }
+        }
+    }
+}
+
+//
+//
+struct BitWriter {
+
+    void                            write( u32 value, u32 count ) {
+        for ( u32 i = 0; i < count; ++i, ++position ) {
+            output[ position >> 3 ] |= ( u8 )( ( ( value >> i ) & 1 ) << ( position & 7 ) );
+        }
+    }
+
+    u8*                             output;
+    u32                             position    = 0;
+}; // struct BitWriter
+
+//
+//
+struct BitReader {
+
+    u32                             read( u32 count ) {
+        u32 value = 0;
+        for ( u32 i = 0; i < count; ++i, ++position ) {
+            value |= ( ( input[ position >> 3 ] >> ( position & 7 ) ) & 1 ) << i;
+        }
+        return value;
+    }
+
+    const u8*                       input;
+    u32                             position    = 0;
+}; // struct BitReader
+
+void bc7_compress_block( const u8* rgba, u8* output ) {
+    f32 endpoint0[ 4 ], endpoint1[ 4 ];
+    block_axis_endpoints( rgba, 4, endpoint0, endpoint1 );
+
+    Bc7Mode6Block block;
+    block.error = u32_max;
+    bc7_mode6_quantize( rgba, endpoint0, endpoint1, block );
+
+    // One refinement pass with the endpoints fitted to the chosen indices.
+    if ( block.error ) {
+        f32 weights[ 16 ];
+        for ( u32 i = 0; i < 16; ++i ) {
+            weights[ i ] = k_bc7_weights4[ block.indices[ i ] ] / 64.f;
+        }
+
+        if ( block_least_squares_endpoints( rgba, 4, weights, endpoint0, endpoint1 ) ) {
+            bc7_mode6_quantize( rgba, endpoint0, endpoint1, block );
+        }
+    }
+
+    // The most significant bit of the first index is implicit zero.
+    if ( block.indices[ 0 ] & 8 ) {
+        for ( u32 c = 0; c < 4; ++c ) {
+            const i32 temp = block.endpoints[ 0 ][ c ];
+            block.endpoints[ 0 ][ c ] = block.endpoints[ 1 ][ c ];
+            block.endpoints[ 1 ][ c ] = temp;
+        }
+        const i32 temp = block.pbits[ 0 ];
+        block.pbits[ 0 ] = block.pbits[ 1 ];
+        block.pbits[ 1 ] = temp;
+
+        for ( u32 i = 0; i < 16; ++i ) {
+            block.indices[ i ] = 15 - block.indices[ i ];
+        }
+    }
+
+    memset( output, 0, 16 );
+    BitWriter writer{ output };
+    writer.write( 1 << 6, 7 );
+    for ( u32 c = 0; c < 4; ++c ) {
+        writer.write( block.endpoints[ 0 ][ c ], 7 );
+        writer.write( block.endpoints[ 1 ][ c ], 7 );
+    }
+    writer.write( block.pbits[ 0 ], 1 );
+    writer.write( block.pbits[ 1 ], 1 );
+
+    writer.write( block.indices[ 0 ], 3 );
+    for ( u32 i = 1; i < 16; ++i ) {
+        writer.write( block.indices[ i ], 4 );
+    }
+}
+
+void bc7_decompress_block( const u8* block, u8* rgba ) {
+    // Only mode 6 is decoded, other modes are written as magenta.
+    if ( ( block[ 0 ] & 0x7f ) != ( 1 << 6 ) ) {
+        for ( u32 i = 0; i < 16; ++i ) {
+            rgba[ i * 4 + 0 ] = 255;
+            rgba[ i * 4 + 1 ] = 0;
+            rgba[ i * 4 + 2 ] = 255;
+            rgba[ i * 4 + 3 ] = 255;
+        }
+        return;
+    }
+
+    BitReader reader{ block, 7 };
+    i32 value0[ 4 ], value1[ 4 ];
+    for ( u32 c = 0; c < 4; ++c ) {
+        value0[ c ] = reader.read( 7 );
+        value1[ c ] = reader.read( 7 );
+    }
+
+    const i32 p0 = reader.read( 1 );
+    const i32 p1 = reader.read( 1 );
+    for ( u32 c = 0; c < 4; ++c ) {
+        value0[ c ] = ( value0[ c ] << 1 ) | p0;
+        value1[ c ] = ( value1[ c ] << 1 ) | p1;
+    }
+
+    for ( u32 i = 0; i < 16; ++i ) {
+        const u32 index = reader.read( i == 0 ? 3 : 4 );
+        for ( u32 c = 0; c < 4; ++c ) {
+            rgba[ i * 4 + c ] = ( u8 )bc7_interpolate( value0[ c ], value1[ c ], k_bc7_weights4[ index ] );
+        }
+    }
+}
+
+// Images /////////////////////////////////////////////////////////////////
+
+sizet texture_compressed_size( TextureCookFormat::Enum format, u32 width, u32 height, u32 mip_levels ) {
+    const u32 block_size = TextureCookFormat::block_size( format );
+
+    sizet size = 0;
+    for ( u32 mip = 0; mip < mip_levels; ++mip ) {
+        size += ( sizet )( ( width + 3 ) / 4 ) * ( ( height + 3 ) / 4 ) * block_size;
+
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+
+    return size;
+}
+
+void texture_compress( TextureCookFormat::Enum format, const u8* rgba, u32 width, u32 height, u8* output ) {
+    ZoneScoped;
+
+    const u32 block_size = TextureCookFormat::block_size( format );
+    const u32 blocks_x = ( width + 3 ) / 4;
+    const u32 blocks_y = ( height + 3 ) / 4;
+
+    u8 block_pixels[ 64 ];
+    for ( u32 by = 0; by < blocks_y; ++by ) {
+        for ( u32 bx = 0; bx < blocks_x; ++bx ) {
+            // Blocks past the edge repeat the last row and column.
+            for ( u32 y = 0; y < 4; ++y ) {
+                const u32 source_y = ( by * 4 + y ) < height ? by * 4 + y : height - 1;
+                for ( u32 x = 0; x < 4; ++x ) {
+                    const u32 source_x = ( bx * 4 + x ) < width ? bx * 4 + x : width - 1;
+                    memcpy( block_pixels + ( y * 4 + x ) * 4, rgba + ( ( sizet )source_y * width + source_x ) * 4, 4 );
+                }
+            }
+
+            u8* block = output + ( ( sizet )by * blocks_x + bx ) * block_size;
+            switch ( format ) {
+                case TextureCookFormat::BC1:
+                    bc1_compress_block( block_pixels, block );
+                    break;
+                case TextureCookFormat::BC3:
+                    bc3_compress_block( block_pixels, block );
+                    break;
+                case TextureCookFormat::BC4:
+                    bc4_compress_block( block_pixels, 0, block );
+                    break;
+                case TextureCookFormat::BC5:
+                    bc5_compress_block( block_pixels, block );
+                    break;
+                case TextureCookFormat::BC7:
+                    bc7_compress_block( block_pixels, block );
+                    break;
+                default:
+                    RASSERTM( false, "Unsupported texture cook format %u\n", format );
+                    break;
+            }
+        }
+    }
+}
+
+void texture_decompress( TextureCookFormat::Enum format, const u8* blocks, u32 width, u32 height, u8* rgba ) {
+    const u32 block_size = TextureCookFormat::block_size( format );
+    const u32 blocks_x = ( width + 3 ) / 4;
+    const u32 blocks_y = ( height + 3 ) / 4;
+
+    u8 block_pixels[ 64 ];
+    for ( u32 by = 0; by < blocks_y; ++by ) {
+        for ( u32 bx = 0; bx < blocks_x; ++bx ) {
+            const u8* block = blocks + ( ( sizet )by * blocks_x + bx ) * block_size;
+
+            // Channels not stored in the format decode as 0, alpha as 255.
+            for ( u32 i = 0; i < 16; ++i ) {
+                block_pixels[ i * 4 + 0 ] = block_pixels[ i * 4 + 1 ] = block_pixels[ i * 4 + 2 ] = 0;
+                block_pixels[ i * 4 + 3 ] = 255;
+            }
+
+            switch ( format ) {
+                case TextureCookFormat::BC1:
+                    bc1_decompress_block( block, block_pixels );
+                    break;
+                case TextureCookFormat::BC3:
+                    bc1_decompress_block( block + 8, block_pixels );
+                    bc4_decompress_block( block, 3, block_pixels );
+                    break;
+                case TextureCookFormat::BC4:
+                    bc4_decompress_block( block, 0, block_pixels );
+                    break;
+                case TextureCookFormat::BC5:
+                    bc4_decompress_block( block, 0, block_pixels );
+                    bc4_decompress_block( block + 8, 1, block_pixels );
+                    break;
+                case TextureCookFormat::BC7:
+                    bc7_decompress_block( block, block_pixels );
+                    break;
+                default:
+                    break;
+            }
+
+            for ( u32 y = 0; y < 4 && by * 4 + y < height; ++y ) {
+                for ( u32 x = 0; x < 4 && bx * 4 + x < width; ++x ) {
+                    memcpy( rgba + ( ( sizet )( by * 4 + y ) * width + bx * 4 + x ) * 4, block_pixels + ( y * 4 + x ) * 4, 4 );
+                }
+            }
+        }
+    }
+}
+
+f64 texture_psnr( const u8* rgba_a, const u8* rgba_b, u32 width, u32 height, u32 num_channels ) {
+    const sizet num_pixels = ( sizet )width * height;
+
+    f64 squared_error = 0.0;
+    for ( sizet i = 0; i < num_pixels; ++i ) {
+        for ( u32 c = 0; c < num_channels; ++c ) {
+            const f64 d = ( f64 )rgba_a[ i * 4 + c ] - rgba_b[ i * 4 + c ];
+            squared_error += d * d;
+        }
+    }
+
+    const f64 mse = squared_error / ( ( f64 )num_pixels * num_channels );
+    if ( mse <= 0.0 ) {
+        return 99.0;
+    }
+
+    return 10.0 * log10( 255.0 * 255.0 / mse );
+}
+
+// DDS ////////////////////////////////////////////////////////////////////
+
+static const u32 k_dds_magic                = 0x20534444;   // "DDS "
+static const u32 k_dds_fourcc_dx10          = 0x30315844;   // "DX10"
+static const u32 k_dds_fourcc_dxt1          = 0x31545844;   // "DXT1"
+static const u32 k_dds_fourcc_dxt5          = 0x35545844;   // "DXT5"
+static const u32 k_dds_fourcc_ati1          = 0x31495441;   // "ATI1"
+static const u32 k_dds_fourcc_ati2          = 0x32495441;   // "ATI2"
+static const u32 k_dds_fourcc_bc4u          = 0x55344342;   // "BC4U"
+static const u32 k_dds_fourcc_bc5u          = 0x55354342;   // "BC5U"
+
+static const u32 k_dds_flags                = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000; // Caps, height, width, pixel format, mip count, linear size.
+static const u32 k_dds_pixel_format_fourcc  = 0x4;
+static const u32 k_dds_caps                 = 0x1000 | 0x400000 | 0x8; // Texture, mipmap, complex.
+static const u32 k_dds_dimension_texture2d  = 3;
+
+//
+//
+struct DdsPixelFormat {
+    u32                             size;
+    u32                             flags;
+    u32                             fourcc;
+    u32                             rgb_bit_count;
+    u32                             bit_masks[ 4 ];
+}; // struct DdsPixelFormat
+
+//
+//
+struct DdsHeader {
+    u32                             size;
+    u32                             flags;
+    u32                             height;
+    u32                             width;
+    u32                             pitch_or_linear_size;
+    u32                             depth;
+    u32                             mip_map_count;
+    u32                             reserved1[ 11 ];
+    DdsPixelFormat                  pixel_format;
+    u32                             caps[ 4 ];
+    u32                             reserved2;
+}; // struct DdsHeader
+
+//
+//
+struct DdsHeaderDx10 {
+    u32                             dxgi_format;
+    u32                             resource_dimension;
+    u32                             misc_flag;
+    u32                             array_size;
+    u32                             misc_flags2;
+}; // struct DdsHeaderDx10
+
+static_assert( sizeof( DdsHeader ) == 124, "DDS header size" );
+
+static const u32 k_dxgi_formats[ TextureCookFormat::Count ] = { 71, 77, 80, 83, 98 }; // BC1, BC3, BC4, BC5, BC7 UNORM.
+
+bool dds_read( const u8* memory, sizet size, CookedTexture* out_texture ) {
+    if ( size < 4 + sizeof( DdsHeader ) || *( const u32* )memory != k_dds_magic ) {
+        return false;
+    }
+
+    DdsHeader header;
+    memcpy( &header, memory + 4, sizeof( DdsHeader ) );
+    sizet data_offset = 4 + sizeof( DdsHeader );
+
+    if ( ( header.pixel_format.flags & k_dds_pixel_format_fourcc ) == 0 ) {
+        return false;
+    }
+
+    TextureCookFormat::Enum format = TextureCookFormat::Count;
+    switch ( header.pixel_format.fourcc ) {
+        case k_dds_fourcc_dxt1:
+            format = TextureCookFormat::BC1;
+            break;
+        case k_dds_fourcc_dxt5:
+            format = TextureCookFormat::BC3;
+            break;
+        case k_dds_fourcc_ati1:
+        case k_dds_fourcc_bc4u:
+            format = TextureCookFormat::BC4;
+            break;
+        case k_dds_fourcc_ati2:
+        case k_dds_fourcc_bc5u:
+            format = TextureCookFormat::BC5;
+            break;
+        case k_dds_fourcc_dx10:
+        {
+            if ( size < data_offset + sizeof( DdsHeaderDx10 ) ) {
+                return false;
+            }
+
+            DdsHeaderDx10 header_dx10;
+            memcpy( &header_dx10, memory + data_offset, sizeof( DdsHeaderDx10 ) );
+            data_offset += sizeof( DdsHeaderDx10 );
+
+            if ( header_dx10.resource_dimension != k_dds_dimension_texture2d || header_dx10.array_size > 1 ) {
+                return false;
+            }
+
+            for ( u32 i = 0; i < TextureCookFormat::Count; ++i ) {
+                if ( k_dxgi_formats[ i ] == header_dx10.dxgi_format ) {
+                    format = ( TextureCookFormat::Enum )i;
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    if ( format == TextureCookFormat::Count || header.width == 0 || header.height == 0 ) {
+        return false;
+    }
+
+    out_texture->format = format;
+    out_texture->width = header.width;
+    out_texture->height = header.height;
+    out_texture->mip_levels = header.mip_map_count ? header.mip_map_count : 1;
+    out_texture->data = memory + data_offset;
+    out_texture->data_size = texture_compressed_size( format, header.width, header.height, out_texture->mip_levels );
+
+    return data_offset + out_texture->data_size <= size;
+}
+
+void dds_write( cstring filename, const CookedTexture& texture, Allocator* allocator ) {
+    const sizet header_size = 4 + sizeof( DdsHeader ) + sizeof( DdsHeaderDx10 );
+    const sizet file_size = header_size + texture.data_size;
+    u8* memory = rallocam( file_size, allocator );
+
+    DdsHeader header;
+    memset( &header, 0, sizeof( DdsHeader ) );
+    header.size = sizeof( DdsHeader );
+    header.flags = k_dds_flags;
+    header.height = texture.height;
+    header.width = texture.width;
+    header.pitch_or_linear_size = ( u32 )texture_compressed_size( texture.format, texture.width, texture.height, 1 );
+    header.mip_map_count = texture.mip_levels;
+    header.pixel_format.size = sizeof( DdsPixelFormat );
+    header.pixel_format.flags = k_dds_pixel_format_fourcc;
+    header.pixel_format.fourcc = k_dds_fourcc_dx10;
+    header.caps[ 0 ] = k_dds_caps;
+
+    DdsHeaderDx10 header_dx10;
+    header_dx10.dxgi_format = k_dxgi_formats[ texture.format ];
+    header_dx10.resource_dimension = k_dds_dimension_texture2d;
+    header_dx10.misc_flag = 0;
+    header_dx10.array_size = 1;
+    header_dx10.misc_flags2 = 0;
+
+    memcpy( memory, &k_dds_magic, 4 );
+    memcpy( memory + 4, &header, sizeof( DdsHeader ) );
+    memcpy( memory + 4 + sizeof( DdsHeader ), &header_dx10, sizeof( DdsHeaderDx10 ) );
+    memcpy( memory + header_size, texture.data, texture.data_size );
+
+    file_write_binary( filename, memory, file_size );
+
+    rfree( memory, allocator );
+}
+
+// Cooking ////////////////////////////////////////////////////////////////
+
+void texture_cooked_path( cstring source_filename, char* out_path, u32 out_path_size ) {
+    snprintf( out_path, out_path_size, "%s", source_filename );
+
+    char* extension = strrchr( out_path, '.' );
+    const sizet base_length = extension ? ( sizet )( extension - out_path ) : strlen( out_path );
+    if ( base_length + 5 <= out_path_size ) {
+        memcpy( out_path + base_length, ".dds", 5 );
+    }
+}
+
+bool texture_cook( cstring source_filename, cstring destination_filename, TextureCookFormat::Enum format, u32 mip_flags, f32 alpha_cutoff, Allocator* allocator ) {
+    ZoneScoped;
+
+    int width, height, comp;
+    u8* pixels = stbi_load( source_filename, &width, &height, &comp, 4 );
+    if ( !pixels ) {
+        rprint( "Error cooking texture %s: %s\n", source_filename, stbi_failure_reason() );
+        return false;
+    }
+
+    CookedTexture texture;
+    texture.format = format;
+    texture.width = ( u32 )width;
+    texture.height = ( u32 )height;
+    texture.mip_levels = texture_mip_count( texture.width, texture.height );
+    texture.data_size = texture_compressed_size( format, texture.width, texture.height, texture.mip_levels );
+
+    // Offline, so the mips use the sharper Kaiser filter.
+    u8* chain = rallocam( texture_mip_chain_size( texture.width, texture.height, texture.mip_levels ), allocator );
+    memcpy( chain, pixels, ( sizet )width * height * 4 );
+    stbi_image_free( pixels );
+
+    texture_generate_mip_chain( chain, texture.width, texture.height, texture.mip_levels, mip_flags, alpha_cutoff, TextureMipFilter::Kaiser, allocator );
+
+    u8* blocks = rallocam( texture.data_size, allocator );
+
+    const u8* mip_pixels = chain;
+    u8* mip_blocks = blocks;
+    u32 mip_width = texture.width, mip_height = texture.height;
+    for ( u32 mip = 0; mip < texture.mip_levels; ++mip ) {
+        texture_compress( format, mip_pixels, mip_width, mip_height, mip_blocks );
+
+        mip_pixels += ( sizet )mip_width * mip_height * 4;
+        mip_blocks += texture_compressed_size( format, mip_width, mip_height, 1 );
+
+        mip_width = mip_width > 1 ? mip_width / 2 : 1;
+        mip_height = mip_height > 1 ? mip_height / 2 : 1;
+    }
+    texture.data = blocks;
+
+    dds_write( destination_filename, texture, allocator );
+
+    rfree( blocks, allocator );
+    rfree( chain, allocator );
+
+    return true;
+}
+
+// Benchmark //////////////////////////////////////////////////////////////
+
+//
+//
+struct CookFormatStatistics {
+    f64                             seconds     = 0.0;
+    f64                             psnr_sum    = 0.0;
+    f64                             psnr_min    = 99.0;
+    u64                             source_bytes = 0;
+    u64                             cooked_bytes = 0;
+}; // struct CookFormatStatistics
+
+void texture_cooker_benchmark( StringArray& texture_paths, Allocator* allocator ) {
+    const u32 num_textures = ( u32 )texture_paths.get_string_count();
+    if ( num_textures == 0 ) {
+        rprint( "Texture cooker benchmark: no texture requested, load a scene first\n" );
+        return;
+    }
+
+    // Normal maps are measured on the two stored channels only.
+    static const TextureCookFormat::Enum k_formats[] = { TextureCookFormat::BC1, TextureCookFormat::BC3, TextureCookFormat::BC5, TextureCookFormat::BC7 };
+    static const u32 k_psnr_channels[] = { 3, 4, 2, 4 };
+    static const u32 k_num_formats = ArraySize( k_formats );
+
+    CookFormatStatistics statistics[ k_num_formats ];
+
+    u32 num_cooked = 0, num_dds_loaded = 0;
+    f64 decode_seconds = 0.0, dds_seconds = 0.0;
+    u64 decoded_bytes = 0, dds_bytes = 0;
+
+    char source_path[ 512 ];
+    char cooked_path[ 512 ];
+
+    FlatHashMapIterator* it = texture_paths.begin_string_iteration();
+    while ( texture_paths.has_next_string( it ) ) {
+        cstring path = texture_paths.get_next_string( it );
+
+        // Scenes with cooked textures request the dds files, look for the source next to them.
+        texture_cooked_path( path, cooked_path, sizeof( cooked_path ) );
+        snprintf( source_path, sizeof( source_path ), "%s", path );
+        if ( strcmp( path, cooked_path ) == 0 ) {
+            static cstring k_source_extensions[] = { "png", "jpg", "jpeg" };
+            for ( u32 e = 0; e < ArraySize( k_source_extensions ); ++e ) {
+                snprintf( source_path + strlen( path ) - 3, sizeof( source_path ) - strlen( path ) + 3, "%s", k_source_extensions[ e ] );
+                if ( file_exists( source_path ) ) {
+                    break;
+                }
+            }
+        }
+
+        MappedFile source_file;
+        if ( !file_map( source_path, &source_file, FileMapFlags_Sequential ) ) {
+            continue;
+        }
+
+        i64 begin_time = time_now();
+        int width, height, comp;
+        u8* pixels = stbi_load_from_memory( ( const stbi_uc* )source_file.data, ( int )source_file.size, &width, &height, &comp, 4 );
+        decode_seconds += time_from_seconds( begin_time );
+        file_unmap( &source_file );
+
+        if ( !pixels ) {
+            continue;
+        }
+
+        const sizet image_size = ( sizet )width * height * 4;
+        decoded_bytes += image_size;
+        ++num_cooked;
+
+        u8* blocks = rallocam( texture_compressed_size( TextureCookFormat::BC7, width, height, 1 ), allocator );
+        u8* decoded = rallocam( image_size, allocator );
+
+        for ( u32 f = 0; f < k_num_formats; ++f ) {
+            const TextureCookFormat::Enum format = k_formats[ f ];
+            CookFormatStatistics& format_statistics = statistics[ f ];
+
+            begin_time = time_now();
+            texture_compress( format, pixels, width, height, blocks );
+            format_statistics.seconds += time_from_seconds( begin_time );
+
+            texture_decompress( format, blocks, width, height, decoded );
+            const f64 psnr = texture_psnr( pixels, decoded, width, height, k_psnr_channels[ f ] );
+
+            format_statistics.psnr_sum += psnr;
+            format_statistics.psnr_min = psnr < format_statistics.psnr_min ? psnr : format_statistics.psnr_min;
+            format_statistics.source_bytes += image_size;
+            format_statistics.cooked_bytes += texture_compressed_size( format, width, height, 1 );
+        }
+
+        rfree( decoded, allocator );
+        rfree( blocks, allocator );
+        stbi_image_free( pixels );
+
+        // Loading a cooked texture is mapping the file and pointing to the blocks, the copy stands for the staging memcpy.
+        MappedFile cooked_file;
+        if ( file_map( cooked_path, &cooked_file, FileMapFlags_Sequential ) ) {
+            begin_time = time_now();
+
+            CookedTexture cooked;
+            if ( dds_read( ( const u8* )cooked_file.data, cooked_file.size, &cooked ) ) {
+                u8* staging = rallocam( cooked.data_size, allocator );
+                memcpy( staging, cooked.data, cooked.data_size );
+                rfree( staging, allocator );
+
+                dds_seconds += time_from_seconds( begin_time );
+                dds_bytes += cooked.data_size;
+                ++num_dds_loaded;
+            }
+            file_unmap( &cooked_file );
+        }
+    }
+
+    rprint( "Texture cooker benchmark, %u textures\n", num_cooked );
+    for ( u32 f = 0; f < k_num_formats; ++f ) {
+        const CookFormatStatistics& format_statistics = statistics[ f ];
+        if ( num_cooked == 0 ) {
+            break;
+        }
+
+        rprint( "    %s: %8.3f s, %8.1f MB/s, ratio %5.1f:1, PSNR average %6.2f dB, min %6.2f dB\n", TextureCookFormat::ToString( k_formats[ f ] ),
+                format_statistics.seconds, format_statistics.source_bytes / ( 1024.0 * 1024.0 ) / format_statistics.seconds,
+                ( f64 )format_statistics.source_bytes / format_statistics.cooked_bytes, format_statistics.psnr_sum / num_cooked, format_statistics.psnr_min );
+    }
+
+    rprint( "    decode sources     : %8.3f s, %8.1f MB of pixels\n", decode_seconds, decoded_bytes / ( 1024.0 * 1024.0 ) );
+    if ( num_dds_loaded ) {
+        rprint( "    load cooked (dds)  : %8.3f s, %8.1f MB of blocks, %u files\n", dds_seconds, dds_bytes / ( 1024.0 * 1024.0 ), num_dds_loaded );
+    }
+    else {
+        rprint( "    no cooked textures found, bake the scene with --cook-textures to compare loading times\n" );
+    }
+}
+
+} // namespace raptor
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "foundation/platform.hpp"
+
+namespace raptor {
+
+struct Allocator;
+struct StringArray;
+
+namespace TextureCookFormat {
+    enum Enum {
+        BC1, BC3, BC4, BC5, BC7, Count
+    };
+
+    static const char* s_value_names[] = {
+        "BC1", "BC3", "BC4", "BC5", "BC7", "Count"
+    };
+
+    static const char* ToString( Enum e ) {
+        return ((u32)e < Enum::Count ? s_value_names[(int)e] : "unsupported" );
+    }
+
+    // Size in bytes of a 4x4 block.
+    inline u32                      block_size( Enum e ) {
+        return ( e == BC1 || e == BC4 ) ? 8 : 16;
+    }
+} // namespace TextureCookFormat
+
+//
+// Block compressed texture with its full mip chain, mips are stored tightly packed from the biggest.
+struct CookedTexture {
+
+    TextureCookFormat::Enum         format      = TextureCookFormat::Count;
+    u32                             width       = 0;
+    u32                             height      = 0;
+    u32                             mip_levels  = 0;
+
+    const u8*                       data        = nullptr;
+    sizet                           data_size   = 0;
+}; // struct CookedTexture
+
+// Block encoders, pixels are 4x4 RGBA8 texels in row order.
+void                                bc1_compress_block( const u8* rgba, u8* output );
+void                                bc3_compress_block( const u8* rgba, u8* output );
+void                                bc4_compress_block( const u8* rgba, u32 channel, u8* output );
+void                                bc5_compress_block( const u8* rgba, u8* output );
+// Mode 6 only: RGBA endpoints with 4 bits indices.
+void                                bc7_compress_block( const u8* rgba, u8* output );
+
+// Block decoders, used to measure the quality of the encoders.
+void                                bc1_decompress_block( const u8* block, u8* rgba );
+void                                bc4_decompress_block( const u8* block, u32 channel, u8* rgba );
+void                                bc7_decompress_block( const u8* block, u8* rgba );
+
+// Whole images, width and height do not need to be multiple of 4.
+sizet                               texture_compressed_size( TextureCookFormat::Enum format, u32 width, u32 height, u32 mip_levels );
+void                                texture_compress( TextureCookFormat::Enum format, const u8* rgba, u32 width, u32 height, u8* output );
+void                                texture_decompress( TextureCookFormat::Enum format, const u8* blocks, u32 width, u32 height, u8* rgba );
+
+// Peak signal to noise ratio in dB over the first num_channels channels.
+f64                                 texture_psnr( const u8* rgba_a, const u8* rgba_b, u32 width, u32 height, u32 num_channels );
+
+// DDS with the DX10 header extension. Reading also accepts the legacy DXT1, DXT5, ATI1 and ATI2 files.
+// The texture data points into memory.
+bool                                dds_read( const u8* memory, sizet size, CookedTexture* out_texture );
+void                                dds_write( cstring filename, const CookedTexture& texture, Allocator* allocator );
+
+// Cooked file name for a source image: same path with the dds extension.
+void                                texture_cooked_path( cstring source_filename, char* out_path, u32 out_path_size );
+
+// Compress source with its mip chain into a DDS file, mip_flags and alpha_cutoff are TextureMipFlags used to filter the mips.
+// Normal maps use only the first two channels.
+bool                                texture_cook( cstring source_filename, cstring destination_filename, TextureCookFormat::Enum format, u32 mip_flags, f32 alpha_cutoff, Allocator* allocator );
+
+// Cook every texture printing time, MB/s and PSNR per format, then compare loading the cooked files against decoding the sources.
+void                                texture_cooker_benchmark( StringArray& texture_paths, Allocator* allocator );
+
+} // namespace raptor
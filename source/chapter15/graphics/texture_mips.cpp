@@ -0,0 +1,607 @@
+#include "graphics/texture_mips.hpp"
+
+#include "graphics/renderer.hpp"
+
+#include "foundation/assert.hpp"
+#include "foundation/memory.hpp"
+#include "foundation/simd.hpp"
+#include "foundation/time.hpp"
+
+#include "external/tracy/tracy/Tracy.hpp"
+
+#include <math.h>
+#include <string.h>
+
+namespace raptor {
+
+// AVX2 only widens the 8 bit box filter, float paths use 4 wide SSE.
+#if defined(RAPTOR_SIMD_AVX2)
+static cstring k_texture_mips_simd_name = "AVX2";
+#elif defined(RAPTOR_SIMD_SSE2)
+static cstring k_texture_mips_simd_name = "SSE2";
+#else
+static cstring k_texture_mips_simd_name = "scalar";
+#endif
+
+// sRGB ///////////////////////////////////////////////////////////////////
+
+static const u32 k_linear_to_srgb_entries = 4096;
+
+//
+// Decode table from 8 bits sRGB and encode table from 12 bits linear values.
+struct SrgbTables {
+
+    SrgbTables();
+
+    f32                             to_linear[ 256 ];
+    u8                              to_srgb[ k_linear_to_srgb_entries ];
+}; // struct SrgbTables
+
+SrgbTables::SrgbTables() {
+    for ( u32 i = 0; i < 256; ++i ) {
+        const f32 c = i / 255.f;
+        to_linear[ i ] = c <= 0.04045f ? c / 12.92f : powf( ( c + 0.055f ) / 1.055f, 2.4f );
+    }
+
+    for ( u32 i = 0; i < k_linear_to_srgb_entries; ++i ) {
+        const f32 l = i / ( f32 )( k_linear_to_srgb_entries - 1 );
+        const f32 c = l <= 0.0031308f ? l * 12.92f : 1.055f * powf( l, 1.f / 2.4f ) - 0.055f;
+        to_srgb[ i ] = ( u8 )( c * 255.f + 0.5f );
+    }
+}
+
+// Built once on first use, loader threads can decode concurrently.
+static const SrgbTables& srgb_tables() {
+    static SrgbTables tables;
+    return tables;
+}
+
+// Texel ///////////////////////////////////////////////////////////////////
+
+// Float RGBA texel used by the sRGB and Kaiser paths.
+#if defined(RAPTOR_SIMD_SCALAR)
+
+struct Texel {
+    f32                             v[ 4 ];
+};
+
+static inline Texel texel_zero() {
+    return { { 0.f, 0.f, 0.f, 0.f } };
+}
+
+static inline Texel texel_set( f32 r, f32 g, f32 b, f32 a ) {
+    return { { r, g, b, a } };
+}
+
+static inline Texel texel_add( Texel a, Texel b ) {
+    return { { a.v[ 0 ] + b.v[ 0 ], a.v[ 1 ] + b.v[ 1 ], a.v[ 2 ] + b.v[ 2 ], a.v[ 3 ] + b.v[ 3 ] } };
+}
+
+static inline Texel texel_madd( Texel accumulator, Texel t, f32 weight ) {
+    return { { accumulator.v[ 0 ] + t.v[ 0 ] * weight, accumulator.v[ 1 ] + t.v[ 1 ] * weight,
+               accumulator.v[ 2 ] + t.v[ 2 ] * weight, accumulator.v[ 3 ] + t.v[ 3 ] * weight } };
+}
+
+static inline void texel_store( Texel t, f32* output ) {
+    memcpy( output, t.v, sizeof( f32 ) * 4 );
+}
+
+#else
+
+typedef __m128 Texel;
+
+static inline Texel texel_zero() {
+    return _mm_setzero_ps();
+}
+
+static inline Texel texel_set( f32 r, f32 g, f32 b, f32 a ) {
+    return _mm_set_ps( a, b, g, r );
+}
+
+static inline Texel texel_add( Texel a, Texel b ) {
+    return _mm_add_ps( a, b );
+}
+
+static inline Texel texel_madd( Texel accumulator, Texel t, f32 weight ) {
+    return _mm_add_ps( accumulator, _mm_mul_ps( t, _mm_set1_ps( weight ) ) );
+}
+
+static inline void texel_store( Texel t, f32* output ) {
+    _mm_storeu_ps( output, t );
+}
+
+#endif // RAPTOR_SIMD_SCALAR
+
+static inline Texel texel_load( const u8* rgba, const f32* to_linear ) {
+    if ( to_linear ) {
+        return texel_set( to_linear[ rgba[ 0 ] ], to_linear[ rgba[ 1 ] ], to_linear[ rgba[ 2 ] ], rgba[ 3 ] * ( 1.f / 255.f ) );
+    }
+    return texel_set( rgba[ 0 ] * ( 1.f / 255.f ), rgba[ 1 ] * ( 1.f / 255.f ), rgba[ 2 ] * ( 1.f / 255.f ), rgba[ 3 ] * ( 1.f / 255.f ) );
+}
+
+static inline f32 saturate( f32 value ) {
+    return value < 0.f ? 0.f : ( value > 1.f ? 1.f : value );
+}
+
+static inline void texel_encode( Texel t, const u8* to_srgb, u8* rgba ) {
+    f32 v[ 4 ];
+    texel_store( t, v );
+
+    for ( u32 c = 0; c < 3; ++c ) {
+        rgba[ c ] = to_srgb ? to_srgb[ ( u32 )( saturate( v[ c ] ) * ( k_linear_to_srgb_entries - 1 ) + 0.5f ) ]
+                            : ( u8 )( saturate( v[ c ] ) * 255.f + 0.5f );
+    }
+    rgba[ 3 ] = ( u8 )( saturate( v[ 3 ] ) * 255.f + 0.5f );
+}
+
+// Box filter /////////////////////////////////////////////////////////////
+
+// 2x2 average of 8 bits values with rounding, columns x0 and x1 of rows row0 and row1.
+static inline void box_linear_texel( const u8* row0, const u8* row1, u32 x0, u32 x1, u8* output ) {
+    for ( u32 c = 0; c < 4; ++c ) {
+        output[ c ] = ( u8 )( ( row0[ x0 * 4 + c ] + row0[ x1 * 4 + c ] + row1[ x0 * 4 + c ] + row1[ x1 * 4 + c ] + 2 ) >> 2 );
+    }
+}
+
+// Output texels from x_begin, source rows are clamped for odd sizes.
+static void box_linear_row_scalar( const u8* row0, const u8* row1, u32 width, u32 x_begin, u32 mip_width, u8* output ) {
+    for ( u32 x = x_begin; x < mip_width; ++x ) {
+        const u32 x0 = x * 2;
+        const u32 x1 = x0 + 1 < width ? x0 + 1 : width - 1;
+        box_linear_texel( row0, row1, x0, x1, output + x * 4 );
+    }
+}
+
+#if !defined(RAPTOR_SIMD_SCALAR)
+
+// 4 output texels from 8 source texels of both rows, 16 bits sums.
+static inline __m128i box_linear_sse2( const u8* row0, const u8* row1 ) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi16( 2 );
+
+    const __m128i a0 = _mm_loadu_si128( ( const __m128i* )row0 );
+    const __m128i a1 = _mm_loadu_si128( ( const __m128i* )( row0 + 16 ) );
+    const __m128i b0 = _mm_loadu_si128( ( const __m128i* )row1 );
+    const __m128i b1 = _mm_loadu_si128( ( const __m128i* )( row1 + 16 ) );
+
+    // Vertical sums, two texels per register.
+    const __m128i v0 = _mm_add_epi16( _mm_unpacklo_epi8( a0, zero ), _mm_unpacklo_epi8( b0, zero ) );
+    const __m128i v1 = _mm_add_epi16( _mm_unpackhi_epi8( a0, zero ), _mm_unpackhi_epi8( b0, zero ) );
+    const __m128i v2 = _mm_add_epi16( _mm_unpacklo_epi8( a1, zero ), _mm_unpacklo_epi8( b1, zero ) );
+    const __m128i v3 = _mm_add_epi16( _mm_unpackhi_epi8( a1, zero ), _mm_unpackhi_epi8( b1, zero ) );
+
+    // Horizontal sums of neighbour texels.
+    __m128i s01 = _mm_add_epi16( _mm_unpacklo_epi64( v0, v1 ), _mm_unpackhi_epi64( v0, v1 ) );
+    __m128i s23 = _mm_add_epi16( _mm_unpacklo_epi64( v2, v3 ), _mm_unpackhi_epi64( v2, v3 ) );
+    s01 = _mm_srli_epi16( _mm_add_epi16( s01, round ), 2 );
+    s23 = _mm_srli_epi16( _mm_add_epi16( s23, round ), 2 );
+
+    return _mm_packus_epi16( s01, s23 );
+}
+
+#endif // !RAPTOR_SIMD_SCALAR
+
+#if defined(RAPTOR_SIMD_AVX2)
+
+// 8 output texels from 16 source texels, same as the SSE2 version with the lanes reordered at the end.
+static inline __m256i box_linear_avx2( const u8* row0, const u8* row1 ) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i round = _mm256_set1_epi16( 2 );
+
+    const __m256i a0 = _mm256_loadu_si256( ( const __m256i* )row0 );
+    const __m256i a1 = _mm256_loadu_si256( ( const __m256i* )( row0 + 32 ) );
+    const __m256i b0 = _mm256_loadu_si256( ( const __m256i* )row1 );
+    const __m256i b1 = _mm256_loadu_si256( ( const __m256i* )( row1 + 32 ) );
+
+    const __m256i v0 = _mm256_add_epi16( _mm256_unpacklo_epi8( a0, zero ), _mm256_unpacklo_epi8( b0, zero ) );
+    const __m256i v1 = _mm256_add_epi16( _mm256_unpackhi_epi8( a0, zero ), _mm256_unpackhi_epi8( b0, zero ) );
+    const __m256i v2 = _mm256_add_epi16( _mm256_unpacklo_epi8( a1, zero ), _mm256_unpacklo_epi8( b1, zero ) );
+    const __m256i v3 = _mm256_add_epi16( _mm256_unpackhi_epi8( a1, zero ), _mm256_unpackhi_epi8( b1, zero ) );
+
+    __m256i s0 = _mm256_add_epi16( _mm256_unpacklo_epi64( v0, v1 ), _mm256_unpackhi_epi64( v0, v1 ) );
+    __m256i s1 = _mm256_add_epi16( _mm256_unpacklo_epi64( v2, v3 ), _mm256_unpackhi_epi64( v2, v3 ) );
+    s0 = _mm256_srli_epi16( _mm256_add_epi16( s0, round ), 2 );
+    s1 = _mm256_srli_epi16( _mm256_add_epi16( s1, round ), 2 );
+
+    // Packing interleaves the 128 bits lanes: texels 0 1 4 5 | 2 3 6 7.
+    return _mm256_permute4x64_epi64( _mm256_packus_epi16( s0, s1 ), _MM_SHUFFLE( 3, 1, 2, 0 ) );
+}
+
+#endif // RAPTOR_SIMD_AVX2
+
+static void box_linear_row( const u8* row0, const u8* row1, u32 width, u32 mip_width, u8* output, bool use_simd ) {
+    u32 x = 0;
+
+    if ( use_simd ) {
+#if defined(RAPTOR_SIMD_AVX2)
+        for ( ; x + 8 <= mip_width && ( x + 8 ) * 2 <= width; x += 8 ) {
+            _mm256_storeu_si256( ( __m256i* )( output + x * 4 ), box_linear_avx2( row0 + x * 8, row1 + x * 8 ) );
+        }
+#endif // RAPTOR_SIMD_AVX2
+#if !defined(RAPTOR_SIMD_SCALAR)
+        for ( ; x + 4 <= mip_width && ( x + 4 ) * 2 <= width; x += 4 ) {
+            _mm_storeu_si128( ( __m128i* )( output + x * 4 ), box_linear_sse2( row0 + x * 8, row1 + x * 8 ) );
+        }
+#endif // !RAPTOR_SIMD_SCALAR
+    }
+
+    box_linear_row_scalar( row0, row1, width, x, mip_width, output );
+}
+
+// sRGB texels are averaged in linear space, alpha stays linear.
+static void box_srgb_row( const u8* row0, const u8* row1, u32 width, u32 mip_width, u8* output ) {
+    const SrgbTables& tables = srgb_tables();
+
+    for ( u32 x = 0; x < mip_width; ++x ) {
+        const u32 x0 = x * 2;
+        const u32 x1 = x0 + 1 < width ? x0 + 1 : width - 1;
+
+        Texel sum = texel_add( texel_add( texel_load( row0 + x0 * 4, tables.to_linear ), texel_load( row0 + x1 * 4, tables.to_linear ) ),
+                               texel_add( texel_load( row1 + x0 * 4, tables.to_linear ), texel_load( row1 + x1 * 4, tables.to_linear ) ) );
+        texel_encode( texel_madd( texel_zero(), sum, 0.25f ), tables.to_srgb, output + x * 4 );
+    }
+}
+
+static void box_generate_mip( const u8* rgba, u32 width, u32 height, u8* output, u32 flags, bool use_simd ) {
+    const u32 mip_width = width > 1 ? width / 2 : 1;
+    const u32 mip_height = height > 1 ? height / 2 : 1;
+    const sizet row_size = ( sizet )width * 4;
+
+    for ( u32 y = 0; y < mip_height; ++y ) {
+        const u32 y0 = y * 2;
+        const u32 y1 = y0 + 1 < height ? y0 + 1 : height - 1;
+
+        const u8* row0 = rgba + y0 * row_size;
+        const u8* row1 = rgba + y1 * row_size;
+        u8* output_row = output + ( sizet )y * mip_width * 4;
+
+        if ( flags & TextureMipFlags_Srgb ) {
+            box_srgb_row( row0, row1, width, mip_width, output_row );
+        }
+        else {
+            box_linear_row( row0, row1, width, mip_width, output_row, use_simd );
+        }
+    }
+}
+
+// Kaiser filter //////////////////////////////////////////////////////////
+
+// Windowed sinc with the usual mip generation parameters: 3 lobes, alpha 4.
+static const f32 k_kaiser_width = 3.f;
+static const f32 k_kaiser_alpha = 4.f;
+// Odd sizes scale by up to 3 (3 to 1 texels), covering 2 * width * scale + 2 source texels.
+static const u32 k_kaiser_max_taps = 20;
+
+static f32 bessel_i0( f32 x ) {
+    f32 sum = 1.f, term = 1.f;
+    const f32 half_x_squared = x * x * 0.25f;
+    for ( u32 k = 1; k < 32 && term > sum * 1e-7f; ++k ) {
+        term *= half_x_squared / ( f32 )( k * k );
+        sum += term;
+    }
+    return sum;
+}
+
+static f32 kaiser_filter( f32 x ) {
+    x = fabsf( x );
+    if ( x >= k_kaiser_width ) {
+        return 0.f;
+    }
+
+    const f32 sinc = x < 1e-5f ? 1.f : sinf( 3.14159265f * x ) / ( 3.14159265f * x );
+    const f32 t = x / k_kaiser_width;
+    return sinc * bessel_i0( k_kaiser_alpha * sqrtf( 1.f - t * t ) ) / bessel_i0( k_kaiser_alpha );
+}
+
+//
+// Source texels and normalized weights of one output coordinate. Indices are clamped at the borders.
+struct KaiserTaps {
+
+    u32                             indices[ k_kaiser_max_taps ];
+    f32                             weights[ k_kaiser_max_taps ];
+    u32                             count       = 0;
+}; // struct KaiserTaps
+
+static void kaiser_compute_taps( u32 size, u32 mip_size, KaiserTaps* taps ) {
+    const f32 scale = size / ( f32 )mip_size;
+    const f32 support = k_kaiser_width * scale;
+
+    for ( u32 i = 0; i < mip_size; ++i ) {
+        KaiserTaps& t = taps[ i ];
+        t.count = 0;
+
+        const f32 center = ( i + 0.5f ) * scale;
+        const i32 first = ( i32 )floorf( center - support );
+        const i32 last = ( i32 )ceilf( center + support );
+
+        f32 total = 0.f;
+        for ( i32 s = first; s <= last && t.count < k_kaiser_max_taps; ++s ) {
+            const f32 weight = kaiser_filter( ( s + 0.5f - center ) / scale );
+            if ( weight == 0.f ) {
+                continue;
+            }
+
+            t.indices[ t.count ] = ( u32 )( s < 0 ? 0 : ( s >= ( i32 )size ? ( i32 )size - 1 : s ) );
+            t.weights[ t.count ] = weight;
+            total += weight;
+            ++t.count;
+        }
+
+        for ( u32 w = 0; w < t.count; ++w ) {
+            t.weights[ w ] /= total;
+        }
+    }
+}
+
+// Separable: each output row filters the source rows vertically into a float row, then horizontally.
+static void kaiser_generate_mip( const u8* rgba, u32 width, u32 height, u8* output, u32 flags, Allocator* temp_allocator ) {
+    RASSERTM( temp_allocator, "Kaiser mip filter needs a temporary allocator" );
+
+    const u32 mip_width = width > 1 ? width / 2 : 1;
+    const u32 mip_height = height > 1 ? height / 2 : 1;
+
+    const SrgbTables& tables = srgb_tables();
+    const f32* to_linear = ( flags & TextureMipFlags_Srgb ) ? tables.to_linear : nullptr;
+    const u8* to_srgb = ( flags & TextureMipFlags_Srgb ) ? tables.to_srgb : nullptr;
+
+    KaiserTaps* taps_x = ( KaiserTaps* )ralloca( sizeof( KaiserTaps ) * mip_width, temp_allocator );
+    KaiserTaps* taps_y = ( KaiserTaps* )ralloca( sizeof( KaiserTaps ) * mip_height, temp_allocator );
+    Texel* row = ( Texel* )rallocaa( sizeof( Texel ) * width, temp_allocator, 16 );
+
+    kaiser_compute_taps( width, mip_width, taps_x );
+    kaiser_compute_taps( height, mip_height, taps_y );
+
+    const sizet row_size = ( sizet )width * 4;
+    for ( u32 y = 0; y < mip_height; ++y ) {
+        const KaiserTaps& ty = taps_y[ y ];
+
+        for ( u32 x = 0; x < width; ++x ) {
+            Texel sum = texel_zero();
+            for ( u32 t = 0; t < ty.count; ++t ) {
+                sum = texel_madd( sum, texel_load( rgba + ty.indices[ t ] * row_size + x * 4, to_linear ), ty.weights[ t ] );
+            }
+            row[ x ] = sum;
+        }
+
+        u8* output_row = output + ( sizet )y * mip_width * 4;
+        for ( u32 x = 0; x < mip_width; ++x ) {
+            const KaiserTaps& tx = taps_x[ x ];
+
+            Texel sum = texel_zero();
+            for ( u32 t = 0; t < tx.count; ++t ) {
+                sum = texel_madd( sum, row[ tx.indices[ t ] ], tx.weights[ t ] );
+            }
+            texel_encode( sum, to_srgb, output_row + x * 4 );
+        }
+    }
+
+    rfree( row, temp_allocator );
+    rfree( taps_y, temp_allocator );
+    rfree( taps_x, temp_allocator );
+}
+
+// Normal maps and alpha coverage /////////////////////////////////////////
+
+static void renormalize_normals( u8* rgba, sizet num_texels ) {
+    for ( sizet i = 0; i < num_texels; ++i ) {
+        u8* texel = rgba + i * 4;
+
+        f32 n[ 3 ];
+        for ( u32 c = 0; c < 3; ++c ) {
+            n[ c ] = texel[ c ] / 255.f * 2.f - 1.f;
+        }
+
+        const f32 length = sqrtf( n[ 0 ] * n[ 0 ] + n[ 1 ] * n[ 1 ] + n[ 2 ] * n[ 2 ] );
+        if ( length > 1e-5f ) {
+            for ( u32 c = 0; c < 3; ++c ) {
+                texel[ c ] = ( u8 )( saturate( ( n[ c ] / length ) * 0.5f + 0.5f ) * 255.f + 0.5f );
+            }
+        }
+    }
+}
+
+f32 texture_alpha_coverage( const u8* rgba, u32 width, u32 height, f32 alpha_cutoff, f32 alpha_scale ) {
+    const sizet num_texels = ( sizet )width * height;
+    // Alpha tested materials discard alpha < cutoff.
+    const f32 threshold = alpha_cutoff * 255.f;
+
+    sizet passing = 0;
+    for ( sizet i = 0; i < num_texels; ++i ) {
+        passing += ( rgba[ i * 4 + 3 ] * alpha_scale >= threshold ) ? 1 : 0;
+    }
+
+    return num_texels ? ( f32 )passing / num_texels : 0.f;
+}
+
+// Scale alpha so that the coverage at the cutoff matches the first mip, binary search on the scale.
+static void scale_alpha_to_coverage( u8* rgba, u32 width, u32 height, f32 alpha_cutoff, f32 target_coverage ) {
+    f32 min_scale = 0.f, max_scale = 4.f;
+    for ( u32 i = 0; i < 12; ++i ) {
+        const f32 scale = ( min_scale + max_scale ) * 0.5f;
+        if ( texture_alpha_coverage( rgba, width, height, alpha_cutoff, scale ) < target_coverage ) {
+            min_scale = scale;
+        }
+        else {
+            max_scale = scale;
+        }
+    }
+
+    // Coverage is a step function on small mips, keep the closest side of the step.
+    const f32 min_error = fabsf( texture_alpha_coverage( rgba, width, height, alpha_cutoff, min_scale ) - target_coverage );
+    const f32 max_error = fabsf( texture_alpha_coverage( rgba, width, height, alpha_cutoff, max_scale ) - target_coverage );
+    const f32 scale = min_error < max_error ? min_scale : max_scale;
+
+    const sizet num_texels = ( sizet )width * height;
+    for ( sizet i = 0; i < num_texels; ++i ) {
+        const f32 alpha = rgba[ i * 4 + 3 ] * scale + 0.5f;
+        rgba[ i * 4 + 3 ] = ( u8 )( alpha > 255.f ? 255.f : alpha );
+    }
+}
+
+// Mip chain //////////////////////////////////////////////////////////////
+
+u32 texture_mip_count( u32 width, u32 height ) {
+    u32 mip_levels = 1;
+    while ( width > 1 && height > 1 ) {
+        width /= 2;
+        height /= 2;
+        ++mip_levels;
+    }
+    return mip_levels;
+}
+
+sizet texture_mip_chain_size( u32 width, u32 height, u32 mip_levels ) {
+    sizet size = 0;
+    for ( u32 mip = 0; mip < mip_levels; ++mip ) {
+        size += ( sizet )width * height * 4;
+
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return size;
+}
+
+static void generate_mip( const u8* rgba, u32 width, u32 height, u8* output, u32 flags, TextureMipFilter::Enum filter, Allocator* temp_allocator, bool use_simd ) {
+    if ( filter == TextureMipFilter::Kaiser ) {
+        kaiser_generate_mip( rgba, width, height, output, flags, temp_allocator );
+    }
+    else {
+        box_generate_mip( rgba, width, height, output, flags, use_simd );
+    }
+
+    if ( flags & TextureMipFlags_NormalMap ) {
+        const sizet num_texels = ( sizet )( width > 1 ? width / 2 : 1 ) * ( height > 1 ? height / 2 : 1 );
+        renormalize_normals( output, num_texels );
+    }
+}
+
+static void generate_mip_chain( u8* chain, u32 width, u32 height, u32 mip_levels, u32 flags, f32 alpha_cutoff, TextureMipFilter::Enum filter, Allocator* temp_allocator, bool use_simd ) {
+    const bool preserve_coverage = ( flags & TextureMipFlags_AlphaCoverage ) && alpha_cutoff > 0.f;
+    const f32 target_coverage = preserve_coverage ? texture_alpha_coverage( chain, width, height, alpha_cutoff, 1.f ) : 0.f;
+
+    u8* source = chain;
+    for ( u32 mip = 1; mip < mip_levels; ++mip ) {
+        u8* destination = source + ( sizet )width * height * 4;
+        generate_mip( source, width, height, destination, flags, filter, temp_allocator, use_simd );
+
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+
+        if ( preserve_coverage ) {
+            scale_alpha_to_coverage( destination, width, height, alpha_cutoff, target_coverage );
+        }
+
+        source = destination;
+    }
+}
+
+void texture_generate_mip( const u8* rgba, u32 width, u32 height, u8* output, u32 flags, TextureMipFilter::Enum filter, Allocator* temp_allocator ) {
+    generate_mip( rgba, width, height, output, flags, filter, temp_allocator, true );
+}
+
+void texture_generate_mip_chain( u8* chain, u32 width, u32 height, u32 mip_levels, u32 flags, f32 alpha_cutoff, TextureMipFilter::Enum filter, Allocator* temp_allocator ) {
+    ZoneScoped;
+
+    generate_mip_chain( chain, width, height, mip_levels, flags, alpha_cutoff, filter, temp_allocator, true );
+}
+
+// Benchmark //////////////////////////////////////////////////////////////
+
+//
+//
+struct MipBenchmarkCase {
+    cstring                         name;
+    u32                             flags;
+    TextureMipFilter::Enum          filter;
+    bool                            use_simd;
+}; // struct MipBenchmarkCase
+
+// Smooth gradients with a hashed noise on top and a circular alpha mask.
+static void mips_benchmark_fill( u8* rgba, u32 size ) {
+    for ( u32 y = 0; y < size; ++y ) {
+        for ( u32 x = 0; x < size; ++x ) {
+            u32 hash = ( x * 73856093u ) ^ ( y * 19349663u );
+            hash ^= hash >> 13;
+            hash *= 0x5bd1e995u;
+
+            const f32 dx = x / ( f32 )size - 0.5f, dy = y / ( f32 )size - 0.5f;
+            u8* texel = rgba + ( ( sizet )y * size + x ) * 4;
+            texel[ 0 ] = ( u8 )( x * 255 / size );
+            texel[ 1 ] = ( u8 )( y * 255 / size );
+            texel[ 2 ] = ( u8 )( hash & 0x3f );
+            texel[ 3 ] = ( dx * dx + dy * dy < 0.2f ) ? ( u8 )( 192 + ( hash >> 26 ) ) : ( u8 )( hash >> 27 );
+        }
+    }
+}
+
+void texture_mips_benchmark( Renderer* renderer, Allocator* allocator ) {
+    static const u32 k_sizes[] = { 1024, 2048, 4096 };
+    static const u32 k_iterations = 3;
+
+    static const MipBenchmarkCase k_cases[] = {
+        { "box scalar         ", TextureMipFlags_None, TextureMipFilter::Box, false },
+        { "box simd           ", TextureMipFlags_None, TextureMipFilter::Box, true },
+        { "box srgb           ", TextureMipFlags_Srgb, TextureMipFilter::Box, true },
+        { "box srgb + coverage", TextureMipFlags_Srgb | TextureMipFlags_AlphaCoverage, TextureMipFilter::Box, true },
+        { "kaiser srgb        ", TextureMipFlags_Srgb, TextureMipFilter::Kaiser, true },
+    };
+
+    rprint( "Mip generation benchmark, %s, best of %u runs\n", k_texture_mips_simd_name, k_iterations );
+
+    for ( u32 s = 0; s < ArraySize( k_sizes ); ++s ) {
+        const u32 size = k_sizes[ s ];
+        const u32 mip_levels = texture_mip_count( size, size );
+        const sizet chain_size = texture_mip_chain_size( size, size, mip_levels );
+        const sizet source_size = ( sizet )size * size * 4;
+
+        u8* chain = rallocam( chain_size, allocator );
+        mips_benchmark_fill( chain, size );
+
+        rprint( "    %4u x %4u, %2u mips\n", size, size, mip_levels );
+
+        for ( u32 c = 0; c < ArraySize( k_cases ); ++c ) {
+            const MipBenchmarkCase& bench = k_cases[ c ];
+
+            f64 best_ms = 1e30;
+            for ( u32 i = 0; i < k_iterations; ++i ) {
+                const i64 begin_time = time_now();
+                generate_mip_chain( chain, size, size, mip_levels, bench.flags, 0.5f, bench.filter, allocator, bench.use_simd );
+                const f64 ms = time_from_milliseconds( begin_time );
+                best_ms = ms < best_ms ? ms : best_ms;
+            }
+
+            rprint( "        cpu %s: %8.2f ms, %8.1f MB/s\n", bench.name, best_ms, source_size / ( best_ms * 1e-3 * 1024.0 * 1024.0 ) );
+        }
+
+        // Creating with initial data stages the first mip, blits the chain on the main queue and waits for idle.
+        // The same creation with a single mip isolates the upload.
+        if ( renderer ) {
+            TextureCreation creation;
+            creation.set_size( ( u16 )size, ( u16 )size, 1 ).set_format_type( VK_FORMAT_R8G8B8A8_UNORM, TextureType::Texture2D ).set_data( chain );
+
+            f64 upload_ms = 1e30, blit_ms = 1e30;
+            for ( u32 i = 0; i < k_iterations; ++i ) {
+                creation.set_mips( 1 );
+                i64 begin_time = time_now();
+                TextureResource* texture = renderer->create_texture( creation );
+                f64 ms = time_from_milliseconds( begin_time );
+                upload_ms = ms < upload_ms ? ms : upload_ms;
+                renderer->destroy_texture( texture );
+
+                creation.set_mips( mip_levels );
+                begin_time = time_now();
+                texture = renderer->create_texture( creation );
+                ms = time_from_milliseconds( begin_time );
+                blit_ms = ms < blit_ms ? ms : blit_ms;
+                renderer->destroy_texture( texture );
+            }
+
+            rprint( "        gpu upload first mip    : %8.2f ms\n", upload_ms );
+            rprint( "        gpu upload + blit chain : %8.2f ms, %8.2f ms of blits\n", blit_ms, blit_ms - upload_ms );
+        }
+
+        rfree( chain, allocator );
+    }
+}
+
+} // namespace raptor
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "foundation/platform.hpp"
+
+namespace raptor {
+
+struct Allocator;
+struct Renderer;
+
+namespace TextureMipFilter {
+    enum Enum {
+        Box, Kaiser, Count
+    };
+
+    static const char* s_value_names[] = {
+        "Box", "Kaiser", "Count"
+    };
+
+    static const char* ToString( Enum e ) {
+        return ((u32)e < Enum::Count ? s_value_names[(int)e] : "unsupported" );
+    }
+} // namespace TextureMipFilter
+
+enum TextureMipFlags {
+    TextureMipFlags_None            = 0,
+    TextureMipFlags_Srgb            = 1 << 0,   // Color channels are filtered in linear space.
+    TextureMipFlags_NormalMap       = 1 << 1,   // Texels are renormalized after filtering.
+    TextureMipFlags_AlphaCoverage   = 1 << 2,   // Alpha is scaled to keep the alpha test coverage of the first mip.
+}; // enum TextureMipFlags
+
+// Mip chain of RGBA8 textures, down to 1 texel in the smallest dimension like the GPU blit path.
+u32                                 texture_mip_count( u32 width, u32 height );
+// Size in bytes of mip_levels RGBA8 mips stored tightly packed from the biggest.
+sizet                               texture_mip_chain_size( u32 width, u32 height, u32 mip_levels );
+
+// Half resolution mip of a RGBA8 image. The Kaiser filter needs temp_allocator for its row and weights.
+void                                texture_generate_mip( const u8* rgba, u32 width, u32 height, u8* output, u32 flags, TextureMipFilter::Enum filter, Allocator* temp_allocator );
+// Fill the mips after the first one in a tightly packed chain, alpha_cutoff is used with TextureMipFlags_AlphaCoverage.
+void                                texture_generate_mip_chain( u8* chain, u32 width, u32 height, u32 mip_levels, u32 flags, f32 alpha_cutoff, TextureMipFilter::Enum filter, Allocator* temp_allocator );
+
+// Fraction of texels passing the alpha test once alpha is multiplied by alpha_scale.
+f32                                 texture_alpha_coverage( const u8* rgba, u32 width, u32 height, f32 alpha_cutoff, f32 alpha_scale );
+
+// Time the CPU filters at 1K, 2K and 4K against creating the same textures with the GPU blit chain.
+void                                texture_mips_benchmark( Renderer* renderer, Allocator* allocator );
+
+} // namespace raptor
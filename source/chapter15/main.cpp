@@ -4,6 +4,9 @@
 #include "application/keys.hpp"
 #include "application/game_camera.hpp"
 
+#include "graphics/animation.hpp"
+#include "graphics/animation_compression.hpp"
+#include "graphics/cloth.hpp"
 #include "graphics/gpu_device.hpp"
 #include "graphics/command_buffer.hpp"
 #include "graphics/spirv_parser.hpp"
@@ -12,11 +15,17 @@
 #include "graphics/renderer.hpp"
 #include "graphics/render_scene.hpp"
 #include "graphics/gltf_scene.hpp"
+#include "graphics/baked_scene.hpp"
 #include "graphics/obj_scene.hpp"
 #include "graphics/frame_graph.hpp"
 #include "graphics/asynchronous_loader.hpp"
 #include "graphics/scene_graph.hpp"
+#include "graphics/skinning.hpp"
 #include "graphics/render_resources_loader.hpp"
+#include "graphics/texture_cooker.hpp"
+#include "graphics/texture_mips.hpp"
+#include "graphics/meshlet_encoding.hpp"
+#include "graphics/meshlet_hierarchy.hpp"
 
 #include "external/cglm/struct/vec2.h"
 #include "external/cglm/struct/mat2.h"
@@ -28,7 +37,10 @@
 #include "external/enkiTS/TaskScheduler.h"
 #include "external/json.hpp"
 
+#include "foundation/blob_serialization.hpp"
 #include "foundation/file.hpp"
+#include "foundation/gltf.hpp"
+#include "foundation/hash_map.hpp"
 #include "foundation/numerics.hpp"
 #include "foundation/time.hpp"
 #include "foundation/resource_manager.hpp"
@@ -568,7 +580,7 @@ namespace JitterType {
 int main( int argc, char** argv ) {
 
     if ( argc < 2 ) {
-        printf( "Usage: chapter15 [path to glTF model]\n");
+        printf( "Usage: chapter15 [--bake] [--cook-textures] [--meshlet-cache] [--optimize-meshes] [--compress-animations] [--track-allocations] [path to glTF/glb model or baked .rscene file]\n");
         InjectDefault3DModel();
     }
 
@@ -579,12 +591,20 @@ int main( int argc, char** argv ) {
     // Init services
     MemoryServiceConfiguration memory_configuration;
     memory_configuration.maximum_dynamic_size = rgiga( 2ull );
+    // Loader, scene and renderer allocate from task threads.
+    memory_configuration.thread_safe_system_allocator = true;
+    // --track-allocations lists the allocation sites in the memory service debug window.
+    // Every allocation then goes through the tracker lock, so it is off by default.
+    for ( i32 arg_i = 1; arg_i < argc; ++arg_i ) {
+        memory_configuration.enable_allocation_tracking |= strcmp( argv[ arg_i ], "--track-allocations" ) == 0;
+    }
 
     MemoryService::instance()->init( &memory_configuration );
     Allocator* allocator = &MemoryService::instance()->system_allocator;
 
     StackAllocator scratch_allocator;
-    scratch_allocator.init( rmega( 8 ) );
+    // Reserve plenty of address space, pages are committed on demand and trimmed back towards 8MB once frames stop using them.
+    scratch_allocator.init_virtual( rgiga( 1ull ), rmega( 8 ) );
 
     enki::TaskSchedulerConfig config;
     // In this example we create more threads than the hardware can run,
@@ -595,6 +615,10 @@ int main( int argc, char** argv ) {
 
     task_scheduler.Initialize( config );
 
+    // Per-thread frame memory for work running on the task threads.
+    FrameThreadArenas* frame_arenas = &MemoryService::instance()->frame_thread_arenas;
+    frame_arenas->init( task_scheduler.GetNumTaskThreads(), rmega( 2 ) );
+
     // window
     WindowConfiguration wconf{ 1280, 800, "Raptor Chapter 15: RT Reflections", &MemoryService::instance()->system_allocator};
     raptor::Window window;
@@ -609,7 +633,8 @@ int main( int argc, char** argv ) {
     // graphics
     GpuDeviceCreation dc;
     dc.set_window( window.width, window.height, window.platform_handle ).set_allocator( &MemoryService::instance()->system_allocator )
-      .set_num_threads( task_scheduler.GetNumTaskThreads() ).set_linear_allocator( &scratch_allocator );
+      .set_num_threads( task_scheduler.GetNumTaskThreads() ).set_linear_allocator( &scratch_allocator )
+      .set_frame_arenas( frame_arenas );
     // Allocate specific resource pool sizes
     dc.resource_pool_creation.buffers = 512;
     dc.resource_pool_creation.descriptor_set_layouts = 256;
@@ -674,8 +699,35 @@ int main( int argc, char** argv ) {
     Directory cwd{ };
     directory_current(&cwd);
 
+    // --bake writes glTF scenes baked at load, to be loaded directly on the next run.
+    // --cook-textures compresses the glTF images to dds files while baking.
+    // --meshlet-cache reuses the meshlets built on previous runs, stored next to the scene.
+    // --optimize-meshes reorders indices and vertices of the glTF primitives while baking.
+    // --compress-animations reduces and quantizes the animation key frames at load.
+    bool write_baked_scenes = false;
+    bool cook_textures = false;
+    bool use_meshlet_cache = false;
+    bool optimize_meshes = false;
+    bool compress_animations = false;
+    for ( i32 arg_i = 1; arg_i < argc; ++arg_i ) {
+        write_baked_scenes |= strcmp( argv[ arg_i ], "--bake" ) == 0;
+        cook_textures |= strcmp( argv[ arg_i ], "--cook-textures" ) == 0;
+        use_meshlet_cache |= strcmp( argv[ arg_i ], "--meshlet-cache" ) == 0;
+        optimize_meshes |= strcmp( argv[ arg_i ], "--optimize-meshes" ) == 0;
+        compress_animations |= strcmp( argv[ arg_i ], "--compress-animations" ) == 0;
+    }
+
+    // Last glTF file loaded, relative to the starting directory restored after loading. Used by the parse benchmark.
+    char benchmark_gltf_file[ 512 ]{ };
+
     RenderScene* scene = nullptr;
     for ( i32 arg_i = 1; arg_i < argc; ++arg_i ) {
+        if ( strcmp( argv[ arg_i ], "--bake" ) == 0 || strcmp( argv[ arg_i ], "--cook-textures" ) == 0 || strcmp( argv[ arg_i ], "--meshlet-cache" ) == 0 ||
+             strcmp( argv[ arg_i ], "--optimize-meshes" ) == 0 || strcmp( argv[ arg_i ], "--compress-animations" ) == 0 ||
+             strcmp( argv[ arg_i ], "--track-allocations" ) == 0 ) {
+            continue;
+        }
+
         cstring scene_path = argv[ arg_i ];
         sizet scene_path_len = strlen( argv[ arg_i ] );
 
@@ -693,8 +745,14 @@ int main( int argc, char** argv ) {
 
         if ( scene == nullptr ) {
             // TODO(marco): further refactor to allow different formats
-            if ( strcmp( file_extension, "gltf" ) == 0 ) {
-                scene = new glTFScene;
+            if ( strcmp( file_extension, "gltf" ) == 0 || strcmp( file_extension, "glb" ) == 0 || strcmp( file_extension, k_baked_scene_extension ) == 0 ) {
+                glTFScene* gltf_scene = new glTFScene;
+                gltf_scene->write_baked_scenes = write_baked_scenes;
+                gltf_scene->cook_textures = cook_textures;
+                gltf_scene->use_meshlet_cache = use_meshlet_cache;
+                gltf_scene->optimize_meshes = optimize_meshes;
+                gltf_scene->compress_animations = compress_animations;
+                scene = gltf_scene;
             } else if ( strcmp( file_extension, "obj" ) == 0 ) {
                 scene = new ObjScene;
             }
@@ -704,6 +762,10 @@ int main( int argc, char** argv ) {
         }
 
         scene->add_mesh( file_name, file_base_path, &scratch_allocator, &async_loader );
+
+        if ( strcmp( file_extension, "gltf" ) == 0 || strcmp( file_extension, "glb" ) == 0 ) {
+            snprintf( benchmark_gltf_file, sizeof( benchmark_gltf_file ), "%s%s", file_base_path, file_name );
+        }
     }
 
     // NOTE(marco): restore working directory
@@ -776,7 +838,7 @@ int main( int argc, char** argv ) {
 
         // TODO: improve
         // Manually add point shadows texture format.
-        FrameGraphNode* point_shadows_pass_node = frame_graph.get_node( "point_shadows_pass" );
+        FrameGraphNode* point_shadows_pass_node = frame_graph.get_node( rhashed( "point_shadows_pass" ) );
         if ( point_shadows_pass_node ) {
             RenderPass* render_pass = gpu.access_render_pass( point_shadows_pass_node->render_pass );
             if ( render_pass ) {
@@ -790,12 +852,12 @@ int main( int argc, char** argv ) {
         }
 
         // Cache frame graph resources in scene
-        FrameGraphResource* resource = frame_graph.get_resource( "motion_vectors" );
+        FrameGraphResource* resource = frame_graph.get_resource( rhashed( "motion_vectors" ) );
         if ( resource ) {
             scene->motion_vector_texture = resource->resource_info.texture.handle;
         }
 
-        resource = frame_graph.get_resource( "visibility_motion_vectors" );
+        resource = frame_graph.get_resource( rhashed( "visibility_motion_vectors" ) );
         if ( resource ) {
             scene->visibility_motion_vector_texture = resource->resource_info.texture.handle;
         }
@@ -1019,7 +1081,7 @@ int main( int argc, char** argv ) {
             gpu.new_frame();
 
             static bool one_time_check = true;
-            if ( async_loader.file_load_requests.size == 0 && one_time_check ) {
+            if ( async_loader.is_idle() && one_time_check ) {
                 one_time_check = false;
                 rprint( "Finished uploading textures in %f seconds\n", time_from_seconds( absolute_begin_frame_tick ) );
             }
@@ -1072,6 +1134,8 @@ int main( int argc, char** argv ) {
         static bool shadow_meshlets_sphere_cull = true;
         static bool shadow_meshes_sphere_cull = true;
         static bool shadow_meshlets_cubemap_face_cull = true;
+        static bool enable_mesh_lods = true;
+        static f32 lod_error_pixels = 1.0f;
         static u32 lighting_debug_modes = 0;
         static u32 light_to_debug = 0;
         static vec2s last_clicked_position = vec2s{ 1280 / 2.0f, 800 / 2.0f };
@@ -1143,6 +1207,7 @@ int main( int argc, char** argv ) {
                     ImGui::InputFloat( "Spring stiffness", &spring_stiffness );
                     ImGui::InputFloat( "Spring damping", &spring_damping );
                     ImGui::Checkbox( "Reset simulation", &reset_simulation );
+                    ImGui::Checkbox( "Simulate on CPU", &scene->cloth_on_cpu );
                 }
 
                 if ( ImGui::CollapsingHeader( "Math tests" ) ) {
@@ -1184,6 +1249,17 @@ int main( int argc, char** argv ) {
                     ImGui::Checkbox( "Use meshlets sphere cull for shadows", &shadow_meshlets_sphere_cull );
                     ImGui::Checkbox( "Use meshlets cubemap face cull for shadows", &shadow_meshlets_cubemap_face_cull );
                     ImGui::Checkbox( "Freeze occlusion camera", &freeze_occlusion_camera );
+                    ImGui::Checkbox( "Use mesh levels of detail", &enable_mesh_lods );
+                    ImGui::SliderFloat( "LOD error pixels", &lod_error_pixels, 0.1f, 16.0f );
+
+                    // Same selection as the culling shader, before culling.
+                    raptor::MeshLodStats lod_stats;
+                    scene->lod_statistics( lod_stats );
+                    ImGui::Text( "LOD triangles %llu / %llu, %.1f%% saved", ( unsigned long long )lod_stats.lod_triangles, ( unsigned long long )lod_stats.full_triangles,
+                                 lod_stats.full_triangles ? 100.0 - lod_stats.lod_triangles * 100.0 / lod_stats.full_triangles : 0.0 );
+                    for ( u32 l = 0; l < raptor::k_max_mesh_lods; ++l ) {
+                        ImGui::Text( "Level %u: %u instances", l, lod_stats.instance_counts[ l ] );
+                    }
                 }
                 if ( ImGui::CollapsingHeader( "Clustered Lighting" ) ) {
 
@@ -1353,6 +1429,63 @@ int main( int argc, char** argv ) {
                     ImGui::SliderFloat( "Wavelet Sigma N", &scene->rt_wavelet_sigma_n, 0.001f, 200.0f );
                     ImGui::SliderFloat( "Wavelet Sigma Z", &scene->rt_wavelet_sigma_z, 0.0f, 1.0f );
                 }
+                if ( ImGui::CollapsingHeader( "Benchmarks" ) ) {
+                    // Results are printed to the log, these stall the frame while running.
+                    static i32 hash_map_max_entries_log10 = 6;
+                    ImGui::SliderInt( "Hash map max entries (log10)", &hash_map_max_entries_log10, 3, 7 );
+                    if ( ImGui::Button( "Run hash map benchmark" ) ) {
+                        u64 max_entries = 1;
+                        for ( i32 i = 0; i < hash_map_max_entries_log10; ++i ) {
+                            max_entries *= 10;
+                        }
+                        raptor::hash_map_benchmark( max_entries );
+                    }
+                    if ( ImGui::Button( "Run named lookup benchmark" ) ) {
+                        raptor::hashed_string_benchmark( 100000 );
+                    }
+                    if ( ImGui::Button( "Run blob load benchmark" ) ) {
+                        raptor::blob_serializer_benchmark( "blob_benchmark.bin", 100000, 64 );
+                    }
+                    if ( benchmark_gltf_file[ 0 ] && ImGui::Button( "Run glTF parse benchmark" ) ) {
+                        raptor::gltf_parse_benchmark( benchmark_gltf_file, 10 );
+                    }
+                    if ( ImGui::Button( "Run asynchronous loader benchmark" ) ) {
+                        raptor::asynchronous_loader_benchmark( async_loader.requested_texture_paths, &task_scheduler, allocator );
+                    }
+                    if ( ImGui::Button( "Run texture cooker benchmark" ) ) {
+                        raptor::texture_cooker_benchmark( async_loader.requested_texture_paths, allocator );
+                    }
+                    if ( ImGui::Button( "Run mip generation benchmark" ) ) {
+                        raptor::texture_mips_benchmark( &renderer, allocator );
+                    }
+                    if ( ImGui::Button( "Run meshlet encoding benchmark" ) ) {
+                        raptor::meshlet_encoding_benchmark( *scene, allocator );
+                    }
+                    if ( ImGui::Button( "Run meshlet hierarchy benchmark" ) ) {
+                        raptor::meshlet_hierarchy_benchmark( *scene, allocator );
+                    }
+                    if ( ImGui::Button( "Run meshlet hierarchy check" ) ) {
+                        raptor::meshlet_hierarchy_check( allocator );
+                    }
+                    if ( ImGui::Button( "Run scene graph benchmark" ) ) {
+                        raptor::scene_graph_benchmark( &task_scheduler, allocator );
+                    }
+                    if ( ImGui::Button( "Run animation benchmark" ) ) {
+                        raptor::animation_benchmark( &task_scheduler, allocator );
+                    }
+                    if ( ImGui::Button( "Run animation compression benchmark" ) ) {
+                        raptor::animation_compression_benchmark( *scene, allocator );
+                    }
+                    if ( ImGui::Button( "Run skinning benchmark" ) ) {
+                        raptor::skinning_benchmark( allocator );
+                    }
+                    if ( ImGui::Button( "Run cloth benchmark" ) ) {
+                        raptor::cloth_benchmark( &task_scheduler, allocator );
+                    }
+                    if ( ImGui::Button( "Run gpu ring allocator check" ) ) {
+                        raptor::gpu_ring_allocator_check();
+                    }
+                }
                 ImGui::Separator();
 
                 ImGui::Checkbox( "Show Debug GPU Draws", &scene->show_debug_gpu_draws );
@@ -1410,6 +1543,8 @@ int main( int argc, char** argv ) {
             }
             ImGui::End();
 
+            MemoryService::instance()->imgui_draw();
+
             if ( ImGui::Begin( "GPU Profiler" ) ) {
                 ImGui::Text( "Cpu Time %fms", delta_time * 1000.f );
                 gpu_profiler.imgui_draw();
@@ -1484,11 +1619,11 @@ int main( int argc, char** argv ) {
         }
         {
             ZoneScopedN( "AnimationsUpdate" );
-            scene->update_animations( delta_time * animation_speed_multiplier );
+            scene->update_animations( delta_time * animation_speed_multiplier, &task_scheduler );
         }
         {
             ZoneScopedN( "SceneGraphUpdate" );
-            scene_graph.update_matrices();
+            scene_graph.update_matrices( &task_scheduler );
         }
         {
             ZoneScopedN( "JointsUpdate" );
@@ -1529,7 +1664,7 @@ int main( int argc, char** argv ) {
             scene_data.forced_metalness = scene->forced_metalness;
             scene_data.forced_roughness = scene->forced_roughness;
 
-            FrameGraphResource* depth_resource = ( FrameGraphResource* )frame_graph.get_resource( "depth" );
+            FrameGraphResource* depth_resource = ( FrameGraphResource* )frame_graph.get_resource( rhashed( "depth" ) );
             if ( depth_resource ) {
                 scene_data.depth_texture_index = depth_resource->resource_info.texture.handle.index;
             }
@@ -1551,6 +1686,8 @@ int main( int argc, char** argv ) {
             scene_data.set_shadow_meshlets_cone_cull( shadow_meshlets_cone_cull );
             scene_data.set_shadow_meshlets_sphere_cull( shadow_meshlets_sphere_cull );
             scene_data.set_shadow_meshlets_cubemap_face_cull( shadow_meshlets_cubemap_face_cull );
+            scene_data.set_mesh_lods( enable_mesh_lods );
+            scene_data.lod_error_pixels = lod_error_pixels;
 
             scene_data.resolution_x = gpu.swapchain_width * 1.f;
             scene_data.resolution_y = gpu.swapchain_height * 1.f;
@@ -1598,22 +1735,22 @@ int main( int argc, char** argv ) {
                 gpu_lighting_data->gi_intensity = scene->gi_intensity;
                 gpu_lighting_data->brdf_lut_texture_index = scene->brdf_lut_texture.index;
 
-                FrameGraphResource* resource = frame_graph.get_resource( "shadow_visibility" );
+                FrameGraphResource* resource = frame_graph.get_resource( rhashed( "shadow_visibility" ) );
                 if ( resource ) {
                     gpu_lighting_data->shadow_visibility_texture_index = resource->resource_info.texture.handle.index;
                 }
 
-                resource = ( FrameGraphResource* )frame_graph.get_resource( "indirect_lighting" );
+                resource = ( FrameGraphResource* )frame_graph.get_resource( rhashed( "indirect_lighting" ) );
                 if ( resource ) {
                     gpu_lighting_data->indirect_lighting_texture_index = resource->resource_info.texture.handle.index;
                 }
 
-                resource = ( FrameGraphResource* )frame_graph.get_resource( "bilateral_weights" );
+                resource = ( FrameGraphResource* )frame_graph.get_resource( rhashed( "bilateral_weights" ) );
                 if ( resource ) {
                     gpu_lighting_data->bilateral_weights_texture_index = resource->resource_info.texture.handle.index;
                 }
 
-                resource = ( FrameGraphResource* )frame_graph.get_resource( "svgf_output" );
+                resource = ( FrameGraphResource* )frame_graph.get_resource( rhashed( "svgf_output" ) );
                 if ( resource ) {
                     gpu_lighting_data->reflections_texture_index = resource->resource_info.texture.handle.index;
                 }
@@ -1670,14 +1807,23 @@ int main( int argc, char** argv ) {
         }
 
         if ( !window.minimized ) {
+            // Cloth simulated on the cpu is split between the task threads and writes the buffers the
+            // draw reads, so it runs before the draw task. Gpu cloth is recorded while the draw task runs.
+            const bool cloth_on_cpu = scene->cloth_on_cpu;
+            CommandBuffer* async_compute_command_buffer = nullptr;
+            if ( cloth_on_cpu ) {
+                ZoneScopedN( "PhysicsUpdate" );
+                async_compute_command_buffer = scene->update_physics( delta_time, air_density, spring_stiffness, spring_damping, wind_direction, reset_simulation, &task_scheduler );
+                reset_simulation = false;
+            }
+
             DrawTask draw_task;
             draw_task.init( renderer.gpu, &frame_graph, &renderer, imgui, &gpu_profiler, scene, &frame_renderer );
             task_scheduler.AddTaskSetToPipe( &draw_task );
 
-            CommandBuffer* async_compute_command_buffer = nullptr;
-            {
+            if ( !cloth_on_cpu ) {
                 ZoneScopedN( "PhysicsUpdate" );
-                async_compute_command_buffer = scene->update_physics( delta_time, air_density, spring_stiffness, spring_damping, wind_direction, reset_simulation );
+                async_compute_command_buffer = scene->update_physics( delta_time, air_density, spring_stiffness, spring_damping, wind_direction, reset_simulation, &task_scheduler );
                 reset_simulation = false;
             }
 
@@ -102,6 +102,9 @@ void main() {
 
 		occlusion_visible = occlusion_visible || disable_occlusion_cull_meshes();
 
+	    // Level of detail drawn by this instance, all passes reading the commands use the same meshlet range.
+	    MeshLod lod = mesh_draw.lods[ select_mesh_lod( mesh_draw, mesh_draw_index, model ) ];
+
 	    uint flags = mesh_draw.flags;
 	    if ( frustum_visible && occlusion_visible ) {
 	    	// Add opaque draws
@@ -115,14 +118,14 @@ void main() {
 				draw_commands[draw_index].vertexOffset = mesh_draw.vertexOffset;
 				draw_commands[draw_index].firstInstance = 0;
 
-				uint task_count = (mesh_draw.meshlet_count + 31) / 32;
+				uint task_count = (lod.meshlet_count + 31) / 32;
 				draw_commands[draw_index].taskCount = task_count;
-				draw_commands[draw_index].firstTask = mesh_draw.meshlet_offset / 32;
+				draw_commands[draw_index].firstTask = lod.meshlet_offset / 32;
 
 				// TODO: add optional flags for dispatch of task shaders emulation
 				//atomicAdd( dispatch_task_x, task_count );
 
-				draw_commands[draw_index].indexCount = mesh_draw.meshlet_index_count;
+				draw_commands[draw_index].indexCount = lod.meshlet_index_count;
 			}
 			else {
 				// Transparent draws are written after total_count commands in the same buffer.
@@ -134,8 +137,8 @@ void main() {
 				draw_commands[draw_index].firstIndex = 0;
 				draw_commands[draw_index].vertexOffset = mesh_draw.vertexOffset;
 				draw_commands[draw_index].firstInstance = 0;
-				draw_commands[draw_index].taskCount = (mesh_draw.meshlet_count + 31) / 32;
-				draw_commands[draw_index].firstTask = mesh_draw.meshlet_offset / 32;
+				draw_commands[draw_index].taskCount = (lod.meshlet_count + 31) / 32;
+				draw_commands[draw_index].firstTask = lod.meshlet_offset / 32;
 			}
 	    } else if ( late_flag == 0 ) {
 			// Add culled object for re-test
@@ -143,8 +146,8 @@ void main() {
 				uint draw_index = atomicAdd( opaque_mesh_culled_count, 1 );
 
 				draw_late_commands[draw_index].drawId = mesh_instance_index;
-				draw_late_commands[draw_index].taskCount = (mesh_draw.meshlet_count + 31) / 32;
-				draw_late_commands[draw_index].firstTask = mesh_draw.meshlet_offset / 32;
+				draw_late_commands[draw_index].taskCount = (lod.meshlet_count + 31) / 32;
+				draw_late_commands[draw_index].firstTask = lod.meshlet_offset / 32;
 			}
 		}
 	}
@@ -30,6 +30,16 @@ layout(buffer_reference, std430, buffer_reference_align = 2) buffer int_array_ty
     uint16_t v;
 };
 
+// Must match k_max_mesh_lods.
+#define MAX_MESH_LODS 5
+
+struct MeshLod {
+    uint        meshlet_offset;
+    uint        meshlet_count;
+    uint        meshlet_index_count;
+    float       error;          // Object space simplification error
+};
+
 struct MeshDraw {
 
     // x = diffuse index, y = roughness index, z = normal index, w = occlusion index.
@@ -47,12 +57,15 @@ struct MeshDraw {
     uint        meshlet_offset;
     uint        meshlet_count;
     uint        meshlet_index_count;
-    uint        pad001;
+    uint        lod_count;
 
     uint64_t    position_buffer;
     uint64_t    uv_buffer;
     uint64_t    index_buffer;
     uint64_t    normals_buffer;
+
+    // Level 0 is the full detail meshlet range.
+    MeshLod     lods[MAX_MESH_LODS];
 };
 
 struct MeshInstanceDraw {
@@ -96,6 +109,33 @@ layout ( std430, set = MATERIAL_SET, binding = 12 ) readonly buffer MeshBounds {
     vec4        mesh_bounds[];
 };
 
+// Levels of detail //////////////////////////////////////////////////////
+// Coarsest level whose error, projected at the nearest point of the bounding sphere, stays under lod_error_pixels.
+// Must match mesh_lod_select in render_scene.cpp.
+uint select_mesh_lod( MeshDraw mesh_draw, uint mesh_draw_index, mat4 model ) {
+    if ( disable_mesh_lods() ) {
+        return 0;
+    }
+
+    vec4 bounding_sphere = mesh_bounds[mesh_draw_index];
+    vec4 view_center = world_to_camera * model * vec4(bounding_sphere.xyz, 1);
+
+    float scale = length( model[0] );
+    float distance = max( length( view_center.xyz ) - bounding_sphere.w * scale, z_near );
+    // Pixels covered by a world space unit at distance.
+    float pixels_per_unit = projection_11 * resolution.y * 0.5 / distance;
+
+    uint lod = 0;
+    for ( uint l = 1; l < mesh_draw.lod_count; ++l ) {
+        if ( mesh_draw.lods[l].error * scale * pixels_per_unit > lod_error_pixels ) {
+            break;
+        }
+        lod = l;
+    }
+
+    return lod;
+}
+
 // Material calculations /////////////////////////////////////////////////
 vec4 compute_diffuse_color(inout vec4 base_color, uint albedo_texture, vec2 uv) {
     if (albedo_texture != INVALID_TEXTURE_INDEX) {
@@ -119,7 +159,9 @@ vec3 apply_pixel_normal( uint normal_texture, vec2 uv, vec3 normal, vec3 tangent
 
     if (normal_texture != INVALID_TEXTURE_INDEX) {
         // NOTE(marco): normal textures are encoded to [0, 1] but need to be mapped to [-1, 1] value
-        const vec3 bump_normal = normalize( texture(global_textures[nonuniformEXT(normal_texture)], uv).rgb * 2.0 - 1.0 );
+        // Z is rebuilt from XY, cooked normal maps are BC5 and store only two channels.
+        const vec2 bump_xy = texture(global_textures[nonuniformEXT(normal_texture)], uv).rg * 2.0 - 1.0;
+        const vec3 bump_normal = vec3( bump_xy, sqrt( max( 0.0, 1.0 - dot( bump_xy, bump_xy ) ) ) );
         const mat3 TBN = mat3(
             tangent,
             bitangent,
@@ -971,8 +971,10 @@ void main() {
     uint mesh_draw_index = mesh_instance_draws[mesh_instance_index].mesh_draw_index;
 
     MeshDraw mesh_draw = mesh_draws[mesh_draw_index];
-    const uint meshlet_offset = mesh_draw.meshlet_offset;
-    const uint meshlet_count = mesh_draw.meshlet_count;
+    // Same level as selected by the mesh culling.
+    MeshLod lod = mesh_draw.lods[ select_mesh_lod( mesh_draw, mesh_draw_index, mesh_instance_draws[mesh_instance_index].model ) ];
+    const uint meshlet_offset = lod.meshlet_offset;
+    const uint meshlet_count = lod.meshlet_count;
 
     uint instance_write_offset = atomicAdd(meshlet_instances_count, meshlet_count);
     for ( uint i = 0; i < meshlet_count; ++i ) {
@@ -47,4 +47,38 @@ struct Meshlet
     uint8_t triangle_count;
 };
 
+// Compact meshlet encoding, written by meshlet_encode in graphics/meshlet_encoding.cpp.
+// Vertices are 4 words: x | y << 16, z | octahedral normal << 16, uv halves, octahedral tangent | sign << 16.
+// Positions are 16 bit snorm relative to the meshlet bounding sphere, bit packed local indices follow the vertices.
+#define MESHLET_ENCODED_VERTEX_WORDS 4
+
+vec3 decode_meshlet_position( uint word0, uint word1, vec3 center, float radius ) {
+    ivec3 quantized = ivec3( int( word0 << 16u ) >> 16, int( word0 ) >> 16, int( word1 << 16u ) >> 16 );
+    return center + vec3( quantized ) * ( radius / 32767.0 );
+}
+
+vec3 decode_oct_8( uint encoded ) {
+    vec2 e = vec2( encoded & 0xffu, ( encoded >> 8u ) & 0xffu ) * ( 2.0 / 255.0 ) - 1.0;
+    vec3 n = vec3( e, 1.0 - abs( e.x ) - abs( e.y ) );
+    float t = max( -n.z, 0.0 );
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize( n );
+}
+
+float decode_meshlet_tangent_sign( uint word3 ) {
+    return ( word3 & 0x10000u ) != 0u ? -1.0 : 1.0;
+}
+
+uint meshlet_encoded_index_bits( uint vertex_count ) {
+    return uint( findMSB( max( vertex_count, 2u ) - 1u ) ) + 1u;
+}
+
+// Index at bit_offset from the start of the index words, word0 and word1 being the words at bit_offset / 32 and the next.
+uint decode_meshlet_index( uint word0, uint word1, uint bit_offset, uint bits ) {
+    uint shift = bit_offset & 31u;
+    uint value = ( word0 >> shift ) | ( shift != 0u ? word1 << ( 32u - shift ) : 0u );
+    return value & ( ( 1u << bits ) - 1u );
+}
+
 #endif // RAPTOR_GLSL_MESHLET_H
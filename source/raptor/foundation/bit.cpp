@@ -11,28 +11,6 @@
 namespace raptor {
 
 
-u32 trailing_zeros_u32( u32 x ) {
-    /*unsigned long result = 0;  // NOLINT(runtime/int)
-    _BitScanForward( &result, x );
-    return result;*/
-#if defined(_MSC_VER)
-    return _tzcnt_u32( x );
-#else
-    return __builtin_ctz( x );
-#endif
-}
-
-u32 leading_zeroes_u32( u32 x ) {
-    /*unsigned long result = 0;  // NOLINT(runtime/int)
-    _BitScanReverse( &result, x );
-    return result;*/
-#if defined(_MSC_VER)
-    return __lzcnt( x );
-#else
-    return __builtin_clz( x );
-#endif
-}
-
 #if defined(_MSC_VER)
 u32 leading_zeroes_u32_msvc( u32 x ) {
     unsigned long result = 0;  // NOLINT(runtime/int)
@@ -43,14 +21,6 @@ u32 leading_zeroes_u32_msvc( u32 x ) {
 }
 #endif
 
-u64 trailing_zeros_u64( u64 x ) {
-#if defined(_MSC_VER)
-    return _tzcnt_u64( x );
-#else
-    return __builtin_ctzl( x );
-#endif
-}
-
 u32 round_up_to_power_of_2( u32 v ) {
 
     u32 nv = 1 << ( 32 - raptor::leading_zeroes_u32( v ) );
@@ -2,18 +2,32 @@
 
 #include "foundation/platform.hpp"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
 namespace raptor {
 
     struct Allocator;
 
     // Common methods /////////////////////////////////////////////////////
+    // Bit scans are inlined as they sit in the hash map probing hot path.
+    // Results are undefined for x == 0.
     u32             leading_zeroes_u32( u32 x );
+    u64             leading_zeroes_u64( u64 x );
 #if defined(_MSC_VER)
     u32             leading_zeroes_u32_msvc( u32 x );
 #endif
     u32             trailing_zeros_u32( u32 x );
     u64             trailing_zeros_u64( u64 x );
 
+    // Zero safe variants, returning the bit width of the type for x == 0.
+    u32             bit_trailing_zeros( u32 x );
+    u32             bit_trailing_zeros( u64 x );
+    u32             bit_leading_zeros( u32 x );
+    u32             bit_leading_zeros( u64 x );
+
     u32             round_up_to_power_of_2( u32 v );
 
     void            print_binary( u64 n );
@@ -54,10 +68,10 @@ namespace raptor {
             return LowestBitSet();
         }
         uint32_t LowestBitSet() const {
-            return trailing_zeros_u32( mask_ ) >> Shift;
+            return bit_trailing_zeros( mask_ ) >> Shift;
         }
         uint32_t HighestBitSet() const {
-            return static_cast< uint32_t >( ( bit_width( mask_ ) - 1 ) >> Shift );
+            return static_cast< uint32_t >( ( sizeof( T ) * 8 - 1 - bit_leading_zeros( mask_ ) ) >> Shift );
         }
 
         BitMask begin() const {
@@ -68,11 +82,15 @@ namespace raptor {
         }
 
         uint32_t TrailingZeros() const {
-            return trailing_zeros_u32( mask_ );// >> Shift;
+            return bit_trailing_zeros( mask_ ) >> Shift;
         }
 
+        // Leading zeros counted on the significant bits only, so a 16 wide mask
+        // stored in a u32 does not count the unused upper half.
         uint32_t LeadingZeros() const {
-            return leading_zeroes_u32( mask_ );// >> Shift;
+            constexpr int total_significant_bits = SignificantBits << Shift;
+            constexpr int extra_bits = sizeof( T ) * 8 - total_significant_bits;
+            return bit_leading_zeros( static_cast< T >( mask_ << extra_bits ) ) >> Shift;
         }
 
     private:
@@ -122,4 +140,42 @@ namespace raptor {
 
     }; // struct BitSetFixed
 
+    // Implementation /////////////////////////////////////////////////////
+    inline u32 trailing_zeros_u32( u32 x ) {
+#if defined(_MSC_VER)
+        return _tzcnt_u32( x );
+#else
+        return __builtin_ctz( x );
+#endif
+    }
+
+    inline u64 trailing_zeros_u64( u64 x ) {
+#if defined(_MSC_VER)
+        return _tzcnt_u64( x );
+#else
+        return __builtin_ctzll( x );
+#endif
+    }
+
+    inline u32 leading_zeroes_u32( u32 x ) {
+#if defined(_MSC_VER)
+        return __lzcnt( x );
+#else
+        return __builtin_clz( x );
+#endif
+    }
+
+    inline u64 leading_zeroes_u64( u64 x ) {
+#if defined(_MSC_VER)
+        return __lzcnt64( x );
+#else
+        return __builtin_clzll( x );
+#endif
+    }
+
+    inline u32 bit_trailing_zeros( u32 x )  { return x ? trailing_zeros_u32( x ) : 32; }
+    inline u32 bit_trailing_zeros( u64 x )  { return x ? ( u32 )trailing_zeros_u64( x ) : 64; }
+    inline u32 bit_leading_zeros( u32 x )   { return x ? leading_zeroes_u32( x ) : 32; }
+    inline u32 bit_leading_zeros( u64 x )   { return x ? ( u32 )leading_zeroes_u64( x ) : 64; }
+
 } // namespace raptor
@@ -12,13 +12,13 @@ namespace raptor {
 // offset to track where to allocate memory from when writing, so that Relative structures
 // like pointers and arrays can be serialized.
 //
-// TODO: when finalized and when reading, if data version matches between the one written in
-// the file and the root structure is marked as 'relative only', memory mappable is doable and
-// thus serialization is automatic.
+// A blob is mappable when all its data is expressed with Relative structures (no Array):
+// when reading it with the same data version the root can point straight into the file
+// memory, without any serialization. BlobSerializer::read_mapped maps the file and does so.
 //
 struct BlobHeader {
     u32                 version;
-    u32                 mappable;
+    u32                 mappable;       // 1 if the blob contains only relative data.
 }; // struct BlobHeader
 
 //
@@ -1,6 +1,7 @@
 #define RAPTOR_BLOB_WRITE
 #include <string.h>
 #include "blob_serialization.hpp"
+#include "time.hpp"
 
 #include <stdio.h>
 #include <stdarg.h>
@@ -10,7 +11,7 @@ namespace raptor {
 void BlobSerializer::write_common( Allocator* allocator_, u32 serializer_version_, sizet size ) {
     allocator = allocator_;
     // Allocate memory
-    blob_memory = ( char* )ralloca( size + sizeof( BlobHeader ), allocator_ );
+    blob_memory = ( char* )rallocaa( size + sizeof( BlobHeader ), allocator_, k_blob_alignment );
     RASSERT( blob_memory );
 
     has_allocated_memory = 1;
@@ -22,7 +23,8 @@ void BlobSerializer::write_common( Allocator* allocator_, u32 serializer_version
     // This will be written into the blob
     data_version = serializer_version_;
     is_reading = 0;
-    is_mappable = 0;
+    // Until an Array is written, everything is relative.
+    is_mappable = 1;
 
     // Write header
     BlobHeader* header = ( BlobHeader* )allocate_static( sizeof( BlobHeader ) );
@@ -34,6 +36,12 @@ void BlobSerializer::write_common( Allocator* allocator_, u32 serializer_version
 
 void BlobSerializer::shutdown() {
 
+    if ( mapped_file.data ) {
+        // Data was used in place from the mapped file.
+        file_unmap( &mapped_file );
+        blob_memory = nullptr;
+    }
+
     if ( is_reading ) {
         // When reading and serializing, we can free blob memory after read.
         // Otherwise we will free the pointer when done.
@@ -237,15 +245,15 @@ void BlobSerializer::serialize( cstring data ) {
     RASSERTM( false, "To be implemented!" );
 }
 
-char* BlobSerializer::allocate_static( sizet size ) {
-    if ( allocated_offset + size > total_size ) 
+char* BlobSerializer::allocate_static( sizet size, sizet alignment ) {
+    const u32 offset = ( u32 )memory_align( allocated_offset, alignment );
+    if ( offset + size > total_size ) 
     {
-        rprint( "Blob allocation error: allocated, requested, total - %u + %u > %u\n", allocated_offset, size, total_size );
+        rprint( "Blob allocation error: allocated, requested, total - %u + %u > %u\n", offset, size, total_size );
         return nullptr;
     }
 
-    u32 offset = allocated_offset;
-    allocated_offset += ( u32 )size;
+    allocated_offset = offset + ( u32 )size;
 
     return is_reading ? data_memory + offset : blob_memory + offset;
 }
@@ -272,7 +280,6 @@ void BlobSerializer::serialize( RelativeString* data ) {
 
             char* source_data = blob_memory + cached_serialized + source_data_offset - 4;
             memcpy( ( char* )data->c_str(), source_data, ( sizet )data->size + 1 );
-            rprint( "Found %s\n", data->c_str() );
             // Restore serialized
             serialized_offset = cached_serialized;
         } else {
@@ -293,7 +300,6 @@ void BlobSerializer::serialize( RelativeString* data ) {
 
         char* destination_data = blob_memory + serialized_offset;
         memcpy( destination_data, ( char* )data->c_str(), ( sizet )data->size + 1 );
-        rprint( "Written %s, Found %s\n", data->c_str(), destination_data );
 
         // Restore serialized
         serialized_offset = cached_serialized;
@@ -349,6 +355,11 @@ void BlobSerializer::allocate_and_set( RelativeString& string, char* text, u32 l
     string.set( destination_memory + cached_offset, length );
 }
 
+void BlobSerializer::write_file( cstring filename ) {
+    RASSERT( !is_reading );
+    file_write_binary( filename, blob_memory, allocated_offset );
+}
+
 i32 BlobSerializer::get_relative_data_offset( void* data ) {
     // data_memory points to the newly allocated data structure to be used at runtime.
     const i32 data_offset_from_start = ( i32 )( ( char* )data - data_memory );
@@ -356,4 +367,96 @@ i32 BlobSerializer::get_relative_data_offset( void* data ) {
     return data_offset;
 }
 
-} // namespace raptor
\ No newline at end of file
+// Benchmark //////////////////////////////////////////////////////////////
+
+struct BlobBenchmarkEntry {
+    RelativeString                  name;
+    RelativeArray<f32>              values;
+}; // struct BlobBenchmarkEntry
+
+struct BlobBenchmarkRoot : public Blob {
+    RelativeArray<BlobBenchmarkEntry> entries;
+}; // struct BlobBenchmarkRoot
+
+static const u32 k_blob_benchmark_version = 1;
+
+template<>
+void BlobSerializer::serialize<BlobBenchmarkEntry>( BlobBenchmarkEntry* data ) {
+    serialize( &data->name );
+    serialize( &data->values );
+}
+
+template<>
+void BlobSerializer::serialize<BlobBenchmarkRoot>( BlobBenchmarkRoot* data ) {
+    serialize( &data->entries );
+}
+
+// Touch all the loaded data, so the in place path pays for its page faults too.
+static f64 blob_benchmark_traverse( const BlobBenchmarkRoot* root ) {
+    f64 sum = 0;
+    for ( u32 e = 0; e < root->entries.size; ++e ) {
+        const BlobBenchmarkEntry& entry = root->entries[ e ];
+        sum += entry.name.size;
+        for ( u32 v = 0; v < entry.values.size; ++v ) {
+            sum += entry.values[ v ];
+        }
+    }
+    return sum;
+}
+
+void blob_serializer_benchmark( cstring filename, u32 num_entries, u32 values_per_entry ) {
+    MallocAllocator allocator;
+
+    // Write
+    {
+        const sizet blob_size = sizeof( BlobBenchmarkRoot ) + ( sizet )num_entries * ( sizeof( BlobBenchmarkEntry ) + 32 + sizeof( f32 ) * values_per_entry + k_blob_alignment );
+
+        BlobSerializer writer;
+        BlobBenchmarkRoot* root = writer.write_and_prepare<BlobBenchmarkRoot>( &allocator, k_blob_benchmark_version, blob_size );
+        writer.allocate_and_set( root->entries, num_entries );
+
+        for ( u32 e = 0; e < num_entries; ++e ) {
+            BlobBenchmarkEntry& entry = root->entries[ e ];
+            char name[ 32 ];
+            const int name_length = snprintf( name, sizeof( name ), "entry_%u", e );
+            writer.allocate_and_set( entry.name, name, ( u32 )name_length );
+            writer.allocate_and_set( entry.values, values_per_entry );
+            for ( u32 v = 0; v < values_per_entry; ++v ) {
+                entry.values[ v ] = ( f32 )( e + v );
+            }
+        }
+
+        writer.write_file( filename );
+        writer.shutdown();
+    }
+
+    // In place
+    i64 start = time_now();
+    BlobSerializer mapped_reader;
+    BlobBenchmarkRoot* mapped_root = mapped_reader.read_mapped<BlobBenchmarkRoot>( &allocator, k_blob_benchmark_version, filename );
+    const f64 mapped_open_ms = time_from_milliseconds( start );
+    const f64 mapped_sum = mapped_root ? blob_benchmark_traverse( mapped_root ) : 0;
+    const f64 mapped_ms = time_from_milliseconds( start );
+    const bool in_place = mapped_root && !mapped_reader.has_allocated_memory;
+    mapped_reader.shutdown();
+
+    // File read + serialization
+    start = time_now();
+    FileReadResult file = file_read_binary( filename, &allocator );
+    BlobSerializer reader;
+    BlobBenchmarkRoot* root = reader.read<BlobBenchmarkRoot>( &allocator, k_blob_benchmark_version, file.size, file.data, true );
+    const f64 serialized_open_ms = time_from_milliseconds( start );
+    const f64 serialized_sum = blob_benchmark_traverse( root );
+    const f64 serialized_ms = time_from_milliseconds( start );
+    // Frees the file memory, the serialized root is ours.
+    reader.shutdown();
+    rfree( root, &allocator );
+
+    rprint( "Blob benchmark %u entries x %u floats (%s, checksums %s):\n", num_entries, values_per_entry, in_place ? "mapped in place" : "MAPPING FELL BACK TO SERIALIZATION", mapped_sum == serialized_sum ? "match" : "DIFFER" );
+    rprint( "  read_mapped:           load %8.3f ms, load + traverse %8.3f ms\n", mapped_open_ms, mapped_ms );
+    rprint( "  file read + serialize: load %8.3f ms, load + traverse %8.3f ms\n", serialized_open_ms, serialized_ms );
+
+    file_delete( filename );
+}
+
+} // namespace raptor
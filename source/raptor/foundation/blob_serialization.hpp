@@ -5,6 +5,7 @@
 #include "foundation/assert.hpp"
 #include "foundation/array.hpp"
 #include "foundation/relative_data_structures.hpp"
+#include "foundation/file.hpp"
 
 #include "foundation/blob.hpp"
 
@@ -17,6 +18,8 @@ namespace raptor {
 
 struct Allocator;
 
+static const sizet      k_blob_alignment = 16;
+
 struct BlobSerializer {
 
     // Allocate size bytes, set the data version and start writing.
@@ -35,6 +38,18 @@ struct BlobSerializer {
     template <typename T>
     T*                  read( Allocator* allocator, u32 serializer_version, sizet size, char* blob_memory, bool force_serialization = false );
 
+    // Map the file and, if the blob is mappable and versions match, return the root
+    // pointing inside the mapped memory: no copies, Relative structures resolve in place.
+    // The mapping lives until shutdown. Otherwise the mapped memory is serialized into
+    // memory from allocator, the file is unmapped and the caller owns the returned root.
+    // map_flags are FileMapFlags. With strict_version only a mappable blob at serializer_version
+    // is accepted, for formats without serialization code: anything else returns nullptr.
+    template <typename T>
+    T*                  read_mapped( Allocator* allocator, u32 serializer_version, cstring filename, u32 map_flags = FileMapFlags_None, bool strict_version = false, bool force_serialization = false );
+
+    // Write the used part of the blob, header included.
+    void                write_file( cstring filename );
+
     void                shutdown();
 
     // Methods used both for reading and writing.
@@ -71,7 +86,7 @@ struct BlobSerializer {
     void                serialize( RelativeString* data );
 
     // Static allocation from the blob allocated memory.
-    char*               allocate_static( sizet size );  // Just allocate size bytes and return. Used to fill in structures.
+    char*               allocate_static( sizet size, sizet alignment = 1 );    // Just allocate size bytes and return. Used to fill in structures.
     
     template <typename T>
     T*                  allocate_static();
@@ -103,9 +118,15 @@ struct BlobSerializer {
     u32                 is_mappable         = 0;
 
     u32                 has_allocated_memory = 0;
-    
+
+    MappedFile          mapped_file;
+
 }; // struct BlobSerializer
 
+// Writes a test blob of num_entries named float arrays to filename and times loading it
+// in place with read_mapped versus reading the file and serializing it. Results go to rprint.
+void                    blob_serializer_benchmark( cstring filename, u32 num_entries, u32 values_per_entry );
+
 // Implementations/////////////////////////////////////////////////////////
 
 // BlobSerializer /////////////////////////////////////////////////////////////
@@ -160,9 +181,9 @@ T* BlobSerializer::read( Allocator* allocator_, u32 serializer_version_, sizet s
     data_version = header->version;
     is_mappable = header->mappable;
 
-    // If serializer and data are at the same version, no need to serialize.
-    // TODO: is mappable should be taken in consideration.
-    if ( serializer_version == data_version && !force_serialization ) {
+    // If serializer and data are at the same version and the data is relative only,
+    // no need to serialize.
+    if ( serializer_version == data_version && is_mappable && !force_serialization ) {
         return ( T* )( blob_memory );
     }
 
@@ -170,7 +191,7 @@ T* BlobSerializer::read( Allocator* allocator_, u32 serializer_version_, sizet s
     serializer_version = data_version;
 
     // Allocate data
-    data_memory = ( char* )rallocam( size, allocator );
+    data_memory = ( char* )rallocaa( size, allocator, k_blob_alignment );
     T* destination_data = ( T* )data_memory;
 
     serialized_offset += sizeof( BlobHeader );
@@ -182,9 +203,47 @@ T* BlobSerializer::read( Allocator* allocator_, u32 serializer_version_, sizet s
     return destination_data;
 }
 
+template<typename T>
+T* BlobSerializer::read_mapped( Allocator* allocator_, u32 serializer_version_, cstring filename, u32 map_flags, bool strict_version, bool force_serialization ) {
+
+    if ( !file_map( filename, &mapped_file, map_flags ) ) {
+        rprint( "Blob %s: cannot map file\n", filename );
+        return nullptr;
+    }
+
+    if ( mapped_file.size < sizeof( T ) || mapped_file.size > u32_max ) {
+        rprint( "Blob %s: invalid size %llu\n", filename, ( u64 )mapped_file.size );
+        file_unmap( &mapped_file );
+        return nullptr;
+    }
+
+    const BlobHeader* header = ( const BlobHeader* )mapped_file.data;
+    if ( header->mappable > 1 ) {
+        rprint( "Blob %s: corrupted header\n", filename );
+        file_unmap( &mapped_file );
+        return nullptr;
+    }
+
+    if ( strict_version && ( header->version != serializer_version_ || header->mappable != 1 ) ) {
+        rprint( "Blob %s: version %u, expected mappable version %u\n", filename, header->version, serializer_version_ );
+        file_unmap( &mapped_file );
+        return nullptr;
+    }
+
+    T* root = read<T>( allocator_, serializer_version_, mapped_file.size, mapped_file.data, force_serialization );
+
+    if ( has_allocated_memory ) {
+        // Everything was copied out of the mapping.
+        file_unmap( &mapped_file );
+        blob_memory = nullptr;
+    }
+
+    return root;
+}
+
 template<typename T>
 inline void BlobSerializer::allocate_and_set( RelativePointer<T>& data, void* source_data ) {
-    char* destination_memory = allocate_static( sizeof( T ) );
+    char* destination_memory = allocate_static( sizeof( T ), alignof( T ) );
     data.set( destination_memory );
 
     if ( source_data ) {
@@ -194,7 +253,7 @@ inline void BlobSerializer::allocate_and_set( RelativePointer<T>& data, void* so
 
 template<typename T>
 inline void BlobSerializer::allocate_and_set( RelativeArray<T>& data, u32 num_elements, void* source_data ) {
-    char* destination_memory = allocate_static( sizeof(T) * num_elements );
+    char* destination_memory = allocate_static( sizeof( T ) * num_elements, alignof( T ) );
     data.set( destination_memory, num_elements );
 
     if ( source_data ) {
@@ -358,6 +417,10 @@ inline void BlobSerializer::serialize( Array<T>* data ) {
 
     } else {
         // Data --> Blob
+        // Array stores an absolute pointer: the blob can't be used in place anymore.
+        is_mappable = 0;
+        ( ( BlobHeader* )blob_memory )->mappable = 0;
+
         serialize( &data->size );
         // Add serialization pads so that we serialize all bytes of the struct Array.
         u64 serialization_pad = 0;
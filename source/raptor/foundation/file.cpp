@@ -1,5 +1,6 @@
 #include "file.hpp"
 
+#include "foundation/array.hpp"
 #include "foundation/memory.hpp"
 #include "foundation/assert.hpp"
 #include "foundation/string.hpp"
@@ -10,11 +11,17 @@
 #define MAX_PATH 65536
 #include <stdlib.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <unistd.h>
 #endif
 
 #include <string.h>
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 namespace raptor {
 
 
@@ -436,6 +443,220 @@ void file_write_binary( cstring filename, void* memory, sizet size ) {
     fclose( file );
 }
 
+// Mapped file //////////////////////////////////////////////////////////////////
+bool file_map( cstring filename, MappedFile* out_file, u32 flags ) {
+    out_file->data = nullptr;
+    out_file->size = 0;
+
+#if defined(_WIN64)
+    const DWORD file_flags = ( flags & FileMapFlags_Sequential ) ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL;
+    HANDLE file = CreateFileA( filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, file_flags, nullptr );
+    if ( file == INVALID_HANDLE_VALUE ) {
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if ( !GetFileSizeEx( file, &file_size ) || file_size.QuadPart == 0 ) {
+        CloseHandle( file );
+        return false;
+    }
+
+    // The view keeps the mapping alive, both handles can be closed right away.
+    HANDLE mapping = CreateFileMappingA( file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr );
+    CloseHandle( file );
+    if ( mapping == nullptr ) {
+        return false;
+    }
+
+    void* data = MapViewOfFile( mapping, FILE_MAP_COPY, 0, 0, 0 );
+    CloseHandle( mapping );
+    if ( data == nullptr ) {
+        return false;
+    }
+
+    out_file->data = ( char* )data;
+    out_file->size = ( sizet )file_size.QuadPart;
+
+    if ( flags & FileMapFlags_WillNeed ) {
+        WIN32_MEMORY_RANGE_ENTRY range{ data, out_file->size };
+        PrefetchVirtualMemory( GetCurrentProcess(), 1, &range, 0 );
+    }
+#else
+    int file = open( filename, O_RDONLY );
+    if ( file < 0 ) {
+        return false;
+    }
+
+    struct stat file_stat;
+    if ( fstat( file, &file_stat ) != 0 || file_stat.st_size == 0 ) {
+        close( file );
+        return false;
+    }
+
+    // The mapping holds its own reference to the file.
+    void* data = mmap( nullptr, ( sizet )file_stat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0 );
+    close( file );
+    if ( data == MAP_FAILED ) {
+        return false;
+    }
+
+    out_file->data = ( char* )data;
+    out_file->size = ( sizet )file_stat.st_size;
+
+    if ( flags & FileMapFlags_Sequential ) {
+        madvise( data, out_file->size, MADV_SEQUENTIAL );
+    }
+    if ( flags & FileMapFlags_WillNeed ) {
+        madvise( data, out_file->size, MADV_WILLNEED );
+    }
+#endif // _WIN64
+
+    return true;
+}
+
+void file_unmap( MappedFile* file ) {
+    if ( file->data == nullptr ) {
+        return;
+    }
+
+#if defined(_WIN64)
+    UnmapViewOfFile( file->data );
+#else
+    munmap( file->data, file->size );
+#endif // _WIN64
+
+    file->data = nullptr;
+    file->size = 0;
+}
+
+// Asynchronous file reader /////////////////////////////////////////////////////
+
+//
+//
+struct AsynchronousFileReaderState {
+    std::mutex                      mutex;
+    std::condition_variable         work_condition;
+    std::condition_variable         done_condition;     // Signaled each time a read completes.
+
+    Array<FileReadFuture*>          queue;              // Reads start from queue_head, in order.
+    u32                             queue_head          = 0;
+    bool                            quit                = false;
+
+    std::thread                     threads[ AsynchronousFileReader::k_max_threads ];
+}; // struct AsynchronousFileReaderState
+
+// Fault every page in, so whoever reads the mapping next finds it resident.
+static void file_touch_pages( const MappedFile& file ) {
+    static const sizet k_page_size = 4096;
+
+    u8 checksum = 0;
+    for ( sizet offset = 0; offset < file.size; offset += k_page_size ) {
+        checksum += ( ( volatile u8* )file.data )[ offset ];
+    }
+    ( void )checksum;
+}
+
+static void file_reader_thread( AsynchronousFileReaderState* state ) {
+    for ( ;; ) {
+        FileReadFuture* future = nullptr;
+        {
+            std::unique_lock<std::mutex> lock( state->mutex );
+            state->work_condition.wait( lock, [ state ] { return state->quit || state->queue_head < state->queue.size; } );
+            if ( state->quit ) {
+                return;
+            }
+
+            future = state->queue[ state->queue_head++ ];
+            if ( state->queue_head == state->queue.size ) {
+                state->queue.clear();
+                state->queue_head = 0;
+            }
+        }
+
+        const bool mapped = file_map( future->path, &future->file, future->flags );
+        if ( mapped ) {
+            file_touch_pages( future->file );
+        }
+
+        {
+            std::lock_guard<std::mutex> lock( state->mutex );
+            future->status.store( mapped ? FileReadFuture::Status_Done : FileReadFuture::Status_Failed, std::memory_order_release );
+        }
+        state->done_condition.notify_all();
+    }
+}
+
+void AsynchronousFileReader::init( Allocator* allocator_, u32 num_threads_ ) {
+    allocator = allocator_;
+    num_threads = num_threads_ < k_max_threads ? num_threads_ : k_max_threads;
+    num_threads = num_threads ? num_threads : 1;
+
+    state = new ( rallocaa( sizeof( AsynchronousFileReaderState ), allocator, alignof( AsynchronousFileReaderState ) ) ) AsynchronousFileReaderState();
+    state->queue.init( allocator, 16 );
+
+    for ( u32 i = 0; i < num_threads; ++i ) {
+        state->threads[ i ] = std::thread( file_reader_thread, state );
+    }
+}
+
+void AsynchronousFileReader::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock( state->mutex );
+        state->quit = true;
+    }
+    state->work_condition.notify_all();
+
+    for ( u32 i = 0; i < num_threads; ++i ) {
+        state->threads[ i ].join();
+    }
+
+    // Nobody is left to serve queued reads.
+    for ( u32 i = state->queue_head; i < state->queue.size; ++i ) {
+        state->queue[ i ]->status.store( FileReadFuture::Status_Failed, std::memory_order_release );
+    }
+    state->done_condition.notify_all();
+
+    state->queue.shutdown();
+    state->~AsynchronousFileReaderState();
+    rfree( state, allocator );
+    state = nullptr;
+}
+
+void AsynchronousFileReader::read( cstring filename, u32 flags, FileReadFuture* future ) {
+    RASSERT( future->status.load( std::memory_order_relaxed ) != FileReadFuture::Status_Pending );
+
+    future->file = MappedFile{ };
+    future->reader = this;
+    future->flags = flags;
+    strncpy( future->path, filename, k_max_path - 1 );
+    future->path[ k_max_path - 1 ] = 0;
+    future->status.store( FileReadFuture::Status_Pending, std::memory_order_relaxed );
+
+    {
+        std::lock_guard<std::mutex> lock( state->mutex );
+        state->queue.push( future );
+    }
+    state->work_condition.notify_one();
+}
+
+bool FileReadFuture::is_ready() const {
+    const u32 current_status = status.load( std::memory_order_acquire );
+    return current_status == Status_Done || current_status == Status_Failed;
+}
+
+bool FileReadFuture::wait() {
+    u32 current_status = status.load( std::memory_order_acquire );
+    if ( current_status == Status_Pending ) {
+        AsynchronousFileReaderState* state = reader->state;
+
+        std::unique_lock<std::mutex> lock( state->mutex );
+        state->done_condition.wait( lock, [ this ] { return status.load( std::memory_order_acquire ) != Status_Pending; } );
+        current_status = status.load( std::memory_order_acquire );
+    }
+
+    return current_status == Status_Done;
+}
+
 // Scoped file //////////////////////////////////////////////////////////////////
 ScopedFile::ScopedFile( cstring filename, cstring mode ) {
     file_open( filename, mode, &file );
@@ -3,10 +3,13 @@
 #include "foundation/platform.hpp"
 #include <stdio.h>
 
+#include <atomic>
+
 namespace raptor {
 
     struct Allocator;
     struct StringArray;
+    struct AsynchronousFileReaderState;
 
 #if defined(_WIN64)
 
@@ -38,6 +41,64 @@ namespace raptor {
         sizet                       size;
     };
 
+    //
+    // Whole file mapped in memory. Pages are copy on write: the contents can be
+    // patched in place without touching the file on disk.
+    struct MappedFile {
+        char*                       data    = nullptr;
+        sizet                       size    = 0;
+    }; // struct MappedFile
+
+    // Access hints given to the OS when mapping a file, can be combined.
+    enum FileMapFlags {
+        FileMapFlags_None           = 0,
+        FileMapFlags_Sequential     = 1 << 0,   // Mostly read front to back: aggressive read ahead, pages are dropped early.
+        FileMapFlags_WillNeed       = 1 << 1,   // Whole file is going to be read, start reading it in the background now.
+    }; // enum FileMapFlags
+
+    struct AsynchronousFileReader;
+
+    //
+    // Result of an asynchronous read. Owned by the caller, it must stay alive and in place
+    // until it is ready. The mapping then belongs to the caller, release it with file_unmap.
+    struct FileReadFuture {
+
+        bool                        is_ready() const;
+        // Block until the file is read, returns false if it could not be mapped.
+        bool                        wait();
+
+        enum Status : u32 {
+            Status_Idle, Status_Pending, Status_Done, Status_Failed
+        };
+
+        MappedFile                  file;
+        AsynchronousFileReader*     reader      = nullptr;
+        std::atomic<u32>            status      { Status_Idle };
+        u32                         flags       = FileMapFlags_None;
+        char                        path[ k_max_path ];
+
+    }; // struct FileReadFuture
+
+    //
+    // Small pool of I/O threads mapping files and faulting all of their pages in,
+    // so disk reads overlap with the work of the calling thread.
+    struct AsynchronousFileReader {
+
+        static const u32            k_max_threads   = 4;
+
+        void                        init( Allocator* allocator, u32 num_threads );
+        // Waits for the reads in flight, requests still queued fail.
+        void                        shutdown();
+
+        // Queue the read of filename, future receives the mapped file.
+        void                        read( cstring filename, u32 flags, FileReadFuture* future );
+
+        Allocator*                  allocator       = nullptr;
+        AsynchronousFileReaderState* state          = nullptr;
+        u32                         num_threads     = 0;
+
+    }; // struct AsynchronousFileReader
+
     // Read file and allocate memory from allocator.
     // User is responsible for freeing the memory.
     char*                           file_read_binary( cstring filename, Allocator* allocator, sizet* size );
@@ -48,6 +109,11 @@ namespace raptor {
 
     void                            file_write_binary( cstring filename, void* memory, sizet size );
 
+    // Map the whole file in memory, returns false if the file can't be opened or is empty.
+    // flags are FileMapFlags hints on how the mapping is going to be read.
+    bool                            file_map( cstring filename, MappedFile* out_file, u32 flags = FileMapFlags_None );
+    void                            file_unmap( MappedFile* file );
+
     bool                            file_exists( cstring path );
     void                            file_open( cstring filename, cstring mode, FileHandle* file );
     void                            file_close( FileHandle file );
@@ -4,6 +4,8 @@
 
 #include "assert.hpp"
 #include "file.hpp"
+#include "hash_map.hpp"
+#include "time.hpp"
 
 using json = nlohmann::json;
 
@@ -546,7 +548,8 @@ static void load_animations( json& json_data, glTF::glTF& gltf_data, Allocator*
     }
 }
 
-glTF::glTF gltf_load_file( cstring file_path ) {
+// Reference loader going through a json document, kept to validate and benchmark the streaming one.
+static glTF::glTF gltf_load_file_json( cstring file_path ) {
     glTF::glTF result{ };
 
     if ( !file_exists( file_path ) ) {
@@ -560,7 +563,7 @@ glTF::glTF gltf_load_file( cstring file_path ) {
 
     json gltf_data = json::parse( read_result.data );
 
-    result.allocator.init( rmega(2) );
+    result.allocator.init_virtual( rmega( 64 ) + read_result.size * 16 );
     Allocator* allocator = &result.allocator;
 
     for ( auto properties : gltf_data.items() ) {
@@ -600,8 +603,1025 @@ glTF::glTF gltf_load_file( cstring file_path ) {
     return result;
 }
 
+// Streaming loader ///////////////////////////////////////////////////////
+//
+// Single pass over the json text without building a document: values are written straight
+// into the glTF structs as they are met. Arrays and objects are counted with a skip scan
+// before being allocated, so all memory comes from the glTF LinearAllocator.
+// Missing values get the same defaults as the json loader above.
+
+static const u32 k_glb_magic                = 0x46546C67;     // "glTF"
+static const u32 k_glb_version              = 2;
+static const u32 k_glb_chunk_json           = 0x4E4F534A;     // "JSON"
+static const u32 k_glb_chunk_bin            = 0x004E4942;     // "BIN\0"
+
+//
+//
+struct JsonReader {
+    const char*                 cursor;
+    const char*                 end;
+    const char*                 begin;
+    Allocator*                  allocator;
+    bool                        error;
+}; // struct JsonReader
+
+static void json_error( JsonReader& reader, cstring message ) {
+    if ( !reader.error ) {
+        rprint( "Error parsing glTF json at byte %llu: %s.\n", ( u64 )( reader.cursor - reader.begin ), message );
+    }
+    reader.error = true;
+    // Stops every loop, all readers see the end of the text from now on.
+    reader.cursor = reader.end;
+}
+
+static void json_skip_whitespace( JsonReader& reader ) {
+    const char* c = reader.cursor;
+    while ( c < reader.end && ( *c == ' ' || *c == '\n' || *c == '\r' || *c == '\t' ) ) {
+        ++c;
+    }
+    reader.cursor = c;
+}
+
+static bool json_expect( JsonReader& reader, char expected ) {
+    json_skip_whitespace( reader );
+    if ( reader.cursor >= reader.end || *reader.cursor != expected ) {
+        json_error( reader, "unexpected character" );
+        return false;
+    }
+    ++reader.cursor;
+    return true;
+}
+
+// Returns the position after the closing quote of the string starting at c.
+static const char* json_string_end( const char* c, const char* end ) {
+    for ( ++c; c < end; ++c ) {
+        if ( *c == '\\' ) {
+            ++c;
+        } else if ( *c == '"' ) {
+            return c + 1;
+        }
+    }
+    return nullptr;
+}
+
+// Count the values of the array or object at the cursor, without moving it.
+static u32 json_count_elements( JsonReader& reader ) {
+    const char* c = reader.cursor + 1;
+    u32 depth = 1;
+    u32 separators = 0;
+    bool empty = true;
+
+    for ( ; c < reader.end; ++c ) {
+        switch ( *c ) {
+            case '"':
+                c = json_string_end( c, reader.end );
+                if ( c == nullptr ) {
+                    json_error( reader, "unterminated string" );
+                    return 0;
+                }
+                --c;
+                empty = false;
+                break;
+            case '[':
+            case '{':
+                ++depth;
+                empty = false;
+                break;
+            case ']':
+            case '}':
+                if ( --depth == 0 ) {
+                    return empty ? 0 : separators + 1;
+                }
+                break;
+            case ',':
+                separators += depth == 1 ? 1 : 0;
+                break;
+            case ' ':
+            case '\n':
+            case '\r':
+            case '\t':
+                break;
+            default:
+                empty = false;
+                break;
+        }
+    }
+
+    json_error( reader, "unterminated array or object" );
+    return 0;
+}
+
+static void json_skip_value( JsonReader& reader ) {
+    json_skip_whitespace( reader );
+    if ( reader.cursor >= reader.end ) {
+        json_error( reader, "missing value" );
+        return;
+    }
+
+    const char first = *reader.cursor;
+    if ( first == '"' ) {
+        const char* string_end = json_string_end( reader.cursor, reader.end );
+        if ( string_end == nullptr ) {
+            json_error( reader, "unterminated string" );
+            return;
+        }
+        reader.cursor = string_end;
+    } else if ( first == '[' || first == '{' ) {
+        u32 depth = 0;
+        for ( const char* c = reader.cursor; c < reader.end; ++c ) {
+            if ( *c == '"' ) {
+                c = json_string_end( c, reader.end );
+                if ( c == nullptr ) {
+                    break;
+                }
+                --c;
+            } else if ( *c == '[' || *c == '{' ) {
+                ++depth;
+            } else if ( ( *c == ']' || *c == '}' ) && --depth == 0 ) {
+                reader.cursor = c + 1;
+                return;
+            }
+        }
+        json_error( reader, "unterminated array or object" );
+    } else {
+        // Numbers, true, false and null.
+        const char* c = reader.cursor;
+        while ( c < reader.end && *c != ',' && *c != '}' && *c != ']' && *c != ' ' && *c != '\n' && *c != '\r' && *c != '\t' ) {
+            ++c;
+        }
+        reader.cursor = c;
+    }
+}
+
+// Object iteration: call json_object_begin, then json_object_next until it returns false.
+// Each call consumes the separator, the key and the colon, leaving the cursor on the value.
+static u32 json_object_begin( JsonReader& reader, bool count ) {
+    json_skip_whitespace( reader );
+    if ( reader.cursor >= reader.end || *reader.cursor != '{' ) {
+        json_error( reader, "expected object" );
+        return 0;
+    }
+    const u32 elements = count ? json_count_elements( reader ) : 0;
+    ++reader.cursor;
+    return elements;
+}
+
+static bool json_object_next( JsonReader& reader, StringView& key ) {
+    json_skip_whitespace( reader );
+    if ( reader.cursor < reader.end && *reader.cursor == ',' ) {
+        ++reader.cursor;
+        json_skip_whitespace( reader );
+    }
+    if ( reader.cursor >= reader.end ) {
+        if ( !reader.error ) {
+            json_error( reader, "unterminated object" );
+        }
+        return false;
+    }
+    if ( *reader.cursor == '}' ) {
+        ++reader.cursor;
+        return false;
+    }
+    if ( *reader.cursor != '"' ) {
+        json_error( reader, "expected key" );
+        return false;
+    }
+
+    // glTF keys are plain ascii, escapes are kept as they are.
+    const char* key_end = json_string_end( reader.cursor, reader.end );
+    if ( key_end == nullptr ) {
+        json_error( reader, "unterminated key" );
+        return false;
+    }
+    key.text = ( char* )reader.cursor + 1;
+    key.length = key_end - reader.cursor - 2;
+    reader.cursor = key_end;
+
+    return json_expect( reader, ':' );
+}
+
+static u32 json_array_begin( JsonReader& reader ) {
+    json_skip_whitespace( reader );
+    if ( reader.cursor >= reader.end || *reader.cursor != '[' ) {
+        json_error( reader, "expected array" );
+        return 0;
+    }
+    const u32 elements = json_count_elements( reader );
+    ++reader.cursor;
+    return elements;
+}
+
+static bool json_array_next( JsonReader& reader ) {
+    json_skip_whitespace( reader );
+    if ( reader.cursor < reader.end && *reader.cursor == ',' ) {
+        ++reader.cursor;
+        json_skip_whitespace( reader );
+    }
+    if ( reader.cursor >= reader.end ) {
+        if ( !reader.error ) {
+            json_error( reader, "unterminated array" );
+        }
+        return false;
+    }
+    if ( *reader.cursor == ']' ) {
+        ++reader.cursor;
+        return false;
+    }
+    return true;
+}
+
+static u64 json_key_hash( const StringView& key ) {
+    return hash_bytes( key.text, key.length );
+}
+
+static f64 json_parse_number( JsonReader& reader ) {
+    // Powers of ten exactly representable as doubles.
+    static const f64 k_powers_of_ten[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                           1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+    json_skip_whitespace( reader );
+    const char* start = reader.cursor;
+    const char* c = start;
+    const char* end = reader.end;
+
+    const bool negative = c < end && *c == '-';
+    c += negative ? 1 : 0;
+    if ( c >= end || *c < '0' || *c > '9' ) {
+        json_error( reader, "expected number" );
+        return 0.0;
+    }
+
+    u64 mantissa = 0;
+    i32 exponent = 0;
+    u32 digits = 0;
+    for ( ; c < end && *c >= '0' && *c <= '9'; ++c ) {
+        if ( digits < 19 ) {
+            mantissa = mantissa * 10 + ( *c - '0' );
+            digits += mantissa != 0 ? 1 : 0;
+        } else {
+            ++exponent;
+        }
+    }
+    if ( c < end && *c == '.' ) {
+        for ( ++c; c < end && *c >= '0' && *c <= '9'; ++c ) {
+            if ( digits < 19 ) {
+                mantissa = mantissa * 10 + ( *c - '0' );
+                digits += mantissa != 0 ? 1 : 0;
+                --exponent;
+            }
+        }
+    }
+    if ( c < end && ( *c == 'e' || *c == 'E' ) ) {
+        ++c;
+        const bool negative_exponent = c < end && *c == '-';
+        c += ( c < end && ( *c == '-' || *c == '+' ) ) ? 1 : 0;
+        i32 explicit_exponent = 0;
+        for ( ; c < end && *c >= '0' && *c <= '9'; ++c ) {
+            explicit_exponent = explicit_exponent < 10000 ? explicit_exponent * 10 + ( *c - '0' ) : explicit_exponent;
+        }
+        exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+    }
+    reader.cursor = c;
+
+    // Exact when both mantissa and power of ten fit a double, otherwise let strtod round it.
+    if ( mantissa < ( 1ull << 53 ) && exponent >= -22 && exponent <= 22 ) {
+        f64 value = ( f64 )mantissa;
+        value = exponent < 0 ? value / k_powers_of_ten[ -exponent ] : value * k_powers_of_ten[ exponent ];
+        return negative ? -value : value;
+    }
+
+    char number[ 64 ];
+    const sizet length = ( sizet )( c - start ) < sizeof( number ) - 1 ? ( sizet )( c - start ) : sizeof( number ) - 1;
+    memcpy( number, start, length );
+    number[ length ] = 0;
+    return strtod( number, nullptr );
+}
+
+static i32 json_parse_int( JsonReader& reader ) {
+    return ( i32 )json_parse_number( reader );
+}
+
+static f32 json_parse_float( JsonReader& reader ) {
+    return ( f32 )json_parse_number( reader );
+}
+
+static bool json_parse_bool( JsonReader& reader ) {
+    json_skip_whitespace( reader );
+    const sizet remaining = reader.end - reader.cursor;
+    if ( remaining >= 4 && memcmp( reader.cursor, "true", 4 ) == 0 ) {
+        reader.cursor += 4;
+        return true;
+    }
+    if ( remaining >= 5 && memcmp( reader.cursor, "false", 5 ) == 0 ) {
+        reader.cursor += 5;
+        return false;
+    }
+    json_error( reader, "expected bool" );
+    return false;
+}
+
+// String contents, escapes are not decoded. Used for enumerations.
+static StringView json_parse_string_view( JsonReader& reader ) {
+    StringView view{ nullptr, 0 };
+
+    json_skip_whitespace( reader );
+    if ( reader.cursor >= reader.end || *reader.cursor != '"' ) {
+        json_error( reader, "expected string" );
+        return view;
+    }
+    const char* string_end = json_string_end( reader.cursor, reader.end );
+    if ( string_end == nullptr ) {
+        json_error( reader, "unterminated string" );
+        return view;
+    }
+
+    view.text = ( char* )reader.cursor + 1;
+    view.length = string_end - reader.cursor - 2;
+    reader.cursor = string_end;
+    return view;
+}
+
+static u32 json_hex_digit( char c ) {
+    if ( c >= '0' && c <= '9' ) return c - '0';
+    if ( c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+    if ( c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+    return 0;
+}
+
+static u32 json_parse_hex4( const char* c, const char* end ) {
+    if ( end - c < 4 ) {
+        return 0;
+    }
+    return ( json_hex_digit( c[ 0 ] ) << 12 ) | ( json_hex_digit( c[ 1 ] ) << 8 ) | ( json_hex_digit( c[ 2 ] ) << 4 ) | json_hex_digit( c[ 3 ] );
+}
+
+static void json_parse_string( JsonReader& reader, StringBuffer& string_buffer ) {
+    StringView raw = json_parse_string_view( reader );
+    if ( raw.text == nullptr ) {
+        return;
+    }
+
+    // Decoded strings are never longer than the escaped ones.
+    string_buffer.init( raw.length + 1, reader.allocator );
+
+    char* out = string_buffer.data;
+    const char* c = raw.text;
+    const char* end = raw.text + raw.length;
+    while ( c < end ) {
+        const char* escape = ( const char* )memchr( c, '\\', end - c );
+        const char* run_end = escape ? escape : end;
+        memcpy( out, c, run_end - c );
+        out += run_end - c;
+        c = run_end;
+
+        if ( escape == nullptr || c + 1 >= end ) {
+            break;
+        }
+
+        const char escaped = c[ 1 ];
+        c += 2;
+        switch ( escaped ) {
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u':
+            {
+                u32 code_point = json_parse_hex4( c, end );
+                c += 4;
+                // Surrogate pair
+                if ( code_point >= 0xD800 && code_point <= 0xDBFF && end - c >= 6 && c[ 0 ] == '\\' && c[ 1 ] == 'u' ) {
+                    const u32 low = json_parse_hex4( c + 2, end );
+                    code_point = 0x10000 + ( ( code_point - 0xD800 ) << 10 ) + ( low - 0xDC00 );
+                    c += 6;
+                }
+                // Utf8, at most 4 bytes for the 6 or 12 characters of the escape.
+                if ( code_point < 0x80 ) {
+                    *out++ = ( char )code_point;
+                } else if ( code_point < 0x800 ) {
+                    *out++ = ( char )( 0xC0 | ( code_point >> 6 ) );
+                    *out++ = ( char )( 0x80 | ( code_point & 0x3F ) );
+                } else if ( code_point < 0x10000 ) {
+                    *out++ = ( char )( 0xE0 | ( code_point >> 12 ) );
+                    *out++ = ( char )( 0x80 | ( ( code_point >> 6 ) & 0x3F ) );
+                    *out++ = ( char )( 0x80 | ( code_point & 0x3F ) );
+                } else {
+                    *out++ = ( char )( 0xF0 | ( code_point >> 18 ) );
+                    *out++ = ( char )( 0x80 | ( ( code_point >> 12 ) & 0x3F ) );
+                    *out++ = ( char )( 0x80 | ( ( code_point >> 6 ) & 0x3F ) );
+                    *out++ = ( char )( 0x80 | ( code_point & 0x3F ) );
+                }
+                break;
+            }
+            default: *out++ = escaped; break;     // '"', '\\' and '/'
+        }
+    }
+
+    *out = 0;
+    string_buffer.current_size = ( u32 )( out - string_buffer.data );
+}
+
+static void json_parse_int_array( JsonReader& reader, u32& count, i32** array ) {
+    count = json_array_begin( reader );
+    *array = count ? ( i32* )allocate_and_zero( reader.allocator, sizeof( i32 ) * count ) : nullptr;
+
+    u32 index = 0;
+    while ( json_array_next( reader ) ) {
+        const i32 value = json_parse_int( reader );
+        if ( index < count ) {
+            ( *array )[ index++ ] = value;
+        }
+    }
+}
+
+static void json_parse_float_array( JsonReader& reader, u32& count, f32** array ) {
+    count = json_array_begin( reader );
+    *array = count ? ( f32* )allocate_and_zero( reader.allocator, sizeof( f32 ) * count ) : nullptr;
+
+    u32 index = 0;
+    while ( json_array_next( reader ) ) {
+        const f32 value = json_parse_float( reader );
+        if ( index < count ) {
+            ( *array )[ index++ ] = value;
+        }
+    }
+}
+
+// Allocate count zeroed elements and parse each object with parse_element.
+template<typename T>
+static void json_parse_object_array( JsonReader& reader, u32& count, T** array, void ( *parse_element )( JsonReader&, T& ) ) {
+    count = json_array_begin( reader );
+    *array = count ? ( T* )allocate_and_zero( reader.allocator, sizeof( T ) * count ) : nullptr;
+
+    u32 index = 0;
+    while ( json_array_next( reader ) ) {
+        if ( index < count ) {
+            parse_element( reader, ( *array )[ index++ ] );
+        } else {
+            json_skip_value( reader );
+        }
+    }
+}
+
+static void parse_asset( JsonReader& reader, glTF::Asset& asset ) {
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "copyright" ): json_parse_string( reader, asset.copyright ); break;
+            case hash_calculate_constexpr( "generator" ): json_parse_string( reader, asset.generator ); break;
+            case hash_calculate_constexpr( "minVersion" ): json_parse_string( reader, asset.minVersion ); break;
+            case hash_calculate_constexpr( "version" ): json_parse_string( reader, asset.version ); break;
+            default: json_skip_value( reader ); break;
+        }
+    }
+}
+
+static void parse_scene( JsonReader& reader, glTF::Scene& scene ) {
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "nodes" ): json_parse_int_array( reader, scene.nodes_count, &scene.nodes ); break;
+            default: json_skip_value( reader ); break;
+        }
+    }
+}
+
+static void parse_buffer( JsonReader& reader, glTF::Buffer& buffer ) {
+    buffer.byte_length = glTF::INVALID_INT_VALUE;
+
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "uri" ): json_parse_string( reader, buffer.uri ); break;
+            case hash_calculate_constexpr( "byteLength" ): buffer.byte_length = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "name" ): json_parse_string( reader, buffer.name ); break;
+            default: json_skip_value( reader ); break;
+        }
+    }
+}
+
+static void parse_buffer_view( JsonReader& reader, glTF::BufferView& buffer_view ) {
+    buffer_view.buffer = glTF::INVALID_INT_VALUE;
+    buffer_view.byte_length = glTF::INVALID_INT_VALUE;
+    buffer_view.byte_offset = glTF::INVALID_INT_VALUE;
+    buffer_view.byte_stride = glTF::INVALID_INT_VALUE;
+    buffer_view.target = glTF::INVALID_INT_VALUE;
+
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "buffer" ): buffer_view.buffer = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "byteLength" ): buffer_view.byte_length = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "byteOffset" ): buffer_view.byte_offset = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "byteStride" ): buffer_view.byte_stride = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "target" ): buffer_view.target = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "name" ): json_parse_string( reader, buffer_view.name ); break;
+            default: json_skip_value( reader ); break;
+        }
+    }
+}
+
+static void parse_node( JsonReader& reader, glTF::Node& node ) {
+    node.camera = glTF::INVALID_INT_VALUE;
+    node.mesh = glTF::INVALID_INT_VALUE;
+    node.skin = glTF::INVALID_INT_VALUE;
+
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "camera" ): node.camera = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "mesh" ): node.mesh = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "skin" ): node.skin = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "children" ): json_parse_int_array( reader, node.children_count, &node.children ); break;
+            case hash_calculate_constexpr( "matrix" ): json_parse_float_array( reader, node.matrix_count, &node.matrix ); break;
+            case hash_calculate_constexpr( "rotation" ): json_parse_float_array( reader, node.rotation_count, &node.rotation ); break;
+            case hash_calculate_constexpr( "scale" ): json_parse_float_array( reader, node.scale_count, &node.scale ); break;
+            case hash_calculate_constexpr( "translation" ): json_parse_float_array( reader, node.translation_count, &node.translation ); break;
+            case hash_calculate_constexpr( "weights" ): json_parse_float_array( reader, node.weights_count, &node.weights ); break;
+            case hash_calculate_constexpr( "name" ): json_parse_string( reader, node.name ); break;
+            default: json_skip_value( reader ); break;
+        }
+    }
+}
+
+static void parse_mesh_primitive_attributes( JsonReader& reader, glTF::MeshPrimitive& mesh_primitive ) {
+    const u32 count = json_object_begin( reader, true );
+    mesh_primitive.attributes = count ? ( glTF::MeshPrimitive::Attribute* )allocate_and_zero( reader.allocator, sizeof( glTF::MeshPrimitive::Attribute ) * count ) : nullptr;
+    mesh_primitive.attribute_count = count;
+
+    u32 index = 0;
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        if ( index >= count ) {
+            json_skip_value( reader );
+            continue;
+        }
+
+        glTF::MeshPrimitive::Attribute& attribute = mesh_primitive.attributes[ index++ ];
+        attribute.key.init( key.length + 1, reader.allocator );
+        attribute.key.append( key );
+        attribute.accessor_index = json_parse_int( reader );
+    }
+}
+
+static void parse_mesh_primitive( JsonReader& reader, glTF::MeshPrimitive& mesh_primitive ) {
+    mesh_primitive.indices = glTF::INVALID_INT_VALUE;
+    mesh_primitive.material = glTF::INVALID_INT_VALUE;
+    mesh_primitive.mode = glTF::INVALID_INT_VALUE;
+
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "indices" ): mesh_primitive.indices = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "material" ): mesh_primitive.material = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "mode" ): mesh_primitive.mode = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "attributes" ): parse_mesh_primitive_attributes( reader, mesh_primitive ); break;
+            default: json_skip_value( reader ); break;
+        }
+    }
+}
+
+static void parse_mesh( JsonReader& reader, glTF::Mesh& mesh ) {
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "primitives" ): json_parse_object_array( reader, mesh.primitives_count, &mesh.primitives, parse_mesh_primitive ); break;
+            case hash_calculate_constexpr( "weights" ): json_parse_float_array( reader, mesh.weights_count, &mesh.weights ); break;
+            case hash_calculate_constexpr( "name" ): json_parse_string( reader, mesh.name ); break;
+            default: json_skip_value( reader ); break;
+        }
+    }
+}
+
+static glTF::Accessor::Type parse_accessor_type( JsonReader& reader ) {
+    StringView value = json_parse_string_view( reader );
+    switch ( json_key_hash( value ) ) {
+        case hash_calculate_constexpr( "SCALAR" ): return glTF::Accessor::Type::Scalar;
+        case hash_calculate_constexpr( "VEC2" ): return glTF::Accessor::Type::Vec2;
+        case hash_calculate_constexpr( "VEC3" ): return glTF::Accessor::Type::Vec3;
+        case hash_calculate_constexpr( "VEC4" ): return glTF::Accessor::Type::Vec4;
+        case hash_calculate_constexpr( "MAT2" ): return glTF::Accessor::Type::Mat2;
+        case hash_calculate_constexpr( "MAT3" ): return glTF::Accessor::Type::Mat3;
+        case hash_calculate_constexpr( "MAT4" ): return glTF::Accessor::Type::Mat4;
+        default: json_error( reader, "unknown accessor type" ); return glTF::Accessor::Type::Scalar;
+    }
+}
+
+static void parse_accessor( JsonReader& reader, glTF::Accessor& accessor ) {
+    accessor.buffer_view = glTF::INVALID_INT_VALUE;
+    accessor.byte_offset = glTF::INVALID_INT_VALUE;
+    accessor.component_type = glTF::INVALID_INT_VALUE;
+    accessor.count = glTF::INVALID_INT_VALUE;
+    accessor.sparse = glTF::INVALID_INT_VALUE;
+
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "bufferView" ): accessor.buffer_view = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "byteOffset" ): accessor.byte_offset = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "componentType" ): accessor.component_type = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "count" ): accessor.count = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "max" ): json_parse_float_array( reader, accessor.max_count, &accessor.max ); break;
+            case hash_calculate_constexpr( "min" ): json_parse_float_array( reader, accessor.min_count, &accessor.min ); break;
+            case hash_calculate_constexpr( "normalized" ): accessor.normalized = json_parse_bool( reader ); break;
+            case hash_calculate_constexpr( "type" ): accessor.type = parse_accessor_type( reader ); break;
+            // Sparse accessors are not supported.
+            default: json_skip_value( reader ); break;
+        }
+    }
+}
+
+static void parse_texture_info( JsonReader& reader, glTF::TextureInfo** texture_info ) {
+    glTF::TextureInfo* ti = ( glTF::TextureInfo* )reader.allocator->allocate( sizeof( glTF::TextureInfo ), 64 );
+    ti->index = glTF::INVALID_INT_VALUE;
+    ti->texCoord = glTF::INVALID_INT_VALUE;
+
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "index" ): ti->index = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "texCoord" ): ti->texCoord = json_parse_int( reader ); break;
+            default: json_skip_value( reader ); break;
+        }
+    }
+
+    *texture_info = ti;
+}
+
+static void parse_material_normal_texture_info( JsonReader& reader, glTF::MaterialNormalTextureInfo** texture_info ) {
+    glTF::MaterialNormalTextureInfo* ti = ( glTF::MaterialNormalTextureInfo* )reader.allocator->allocate( sizeof( glTF::MaterialNormalTextureInfo ), 64 );
+    ti->index = glTF::INVALID_INT_VALUE;
+    ti->tex_coord = glTF::INVALID_INT_VALUE;
+    ti->scale = glTF::INVALID_FLOAT_VALUE;
+
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "index" ): ti->index = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "texCoord" ): ti->tex_coord = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "scale" ): ti->scale = json_parse_float( reader ); break;
+            default: json_skip_value( reader ); break;
+        }
+    }
+
+    *texture_info = ti;
+}
+
+static void parse_material_occlusion_texture_info( JsonReader& reader, glTF::MaterialOcclusionTextureInfo** texture_info ) {
+    glTF::MaterialOcclusionTextureInfo* ti = ( glTF::MaterialOcclusionTextureInfo* )reader.allocator->allocate( sizeof( glTF::MaterialOcclusionTextureInfo ), 64 );
+    ti->index = glTF::INVALID_INT_VALUE;
+    ti->texCoord = glTF::INVALID_INT_VALUE;
+    ti->strength = glTF::INVALID_FLOAT_VALUE;
+
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "index" ): ti->index = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "texCoord" ): ti->texCoord = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "strength" ): ti->strength = json_parse_float( reader ); break;
+            default: json_skip_value( reader ); break;
+        }
+    }
+
+    *texture_info = ti;
+}
+
+static void parse_material_pbr_metallic_roughness( JsonReader& reader, glTF::MaterialPBRMetallicRoughness** pbr ) {
+    glTF::MaterialPBRMetallicRoughness* ti = ( glTF::MaterialPBRMetallicRoughness* )allocate_and_zero( reader.allocator, sizeof( glTF::MaterialPBRMetallicRoughness ) );
+    ti->metallic_factor = glTF::INVALID_FLOAT_VALUE;
+    ti->roughness_factor = glTF::INVALID_FLOAT_VALUE;
+
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "baseColorFactor" ): json_parse_float_array( reader, ti->base_color_factor_count, &ti->base_color_factor ); break;
+            case hash_calculate_constexpr( "baseColorTexture" ): parse_texture_info( reader, &ti->base_color_texture ); break;
+            case hash_calculate_constexpr( "metallicFactor" ): ti->metallic_factor = json_parse_float( reader ); break;
+            case hash_calculate_constexpr( "metallicRoughnessTexture" ): parse_texture_info( reader, &ti->metallic_roughness_texture ); break;
+            case hash_calculate_constexpr( "roughnessFactor" ): ti->roughness_factor = json_parse_float( reader ); break;
+            default: json_skip_value( reader ); break;
+        }
+    }
+
+    *pbr = ti;
+}
+
+static void parse_material( JsonReader& reader, glTF::Material& material ) {
+    material.alpha_cutoff = glTF::INVALID_FLOAT_VALUE;
+
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "emissiveFactor" ): json_parse_float_array( reader, material.emissive_factor_count, &material.emissive_factor ); break;
+            case hash_calculate_constexpr( "alphaCutoff" ): material.alpha_cutoff = json_parse_float( reader ); break;
+            case hash_calculate_constexpr( "alphaMode" ): json_parse_string( reader, material.alpha_mode ); break;
+            case hash_calculate_constexpr( "doubleSided" ): material.double_sided = json_parse_bool( reader ); break;
+            case hash_calculate_constexpr( "emissiveTexture" ): parse_texture_info( reader, &material.emissive_texture ); break;
+            case hash_calculate_constexpr( "normalTexture" ): parse_material_normal_texture_info( reader, &material.normal_texture ); break;
+            case hash_calculate_constexpr( "occlusionTexture" ): parse_material_occlusion_texture_info( reader, &material.occlusion_texture ); break;
+            case hash_calculate_constexpr( "pbrMetallicRoughness" ): parse_material_pbr_metallic_roughness( reader, &material.pbr_metallic_roughness ); break;
+            case hash_calculate_constexpr( "name" ): json_parse_string( reader, material.name ); break;
+            default: json_skip_value( reader ); break;
+        }
+    }
+}
+
+static void parse_texture( JsonReader& reader, glTF::Texture& texture ) {
+    texture.sampler = glTF::INVALID_INT_VALUE;
+    texture.source = glTF::INVALID_INT_VALUE;
+
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "sampler" ): texture.sampler = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "source" ): texture.source = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "name" ): json_parse_string( reader, texture.name ); break;
+            default: json_skip_value( reader ); break;
+        }
+    }
+}
+
+static void parse_image( JsonReader& reader, glTF::Image& image ) {
+    image.buffer_view = glTF::INVALID_INT_VALUE;
+
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "bufferView" ): image.buffer_view = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "mimeType" ): json_parse_string( reader, image.mime_type ); break;
+            case hash_calculate_constexpr( "uri" ): json_parse_string( reader, image.uri ); break;
+            default: json_skip_value( reader ); break;
+        }
+    }
+}
+
+static void parse_sampler( JsonReader& reader, glTF::Sampler& sampler ) {
+    sampler.mag_filter = glTF::INVALID_INT_VALUE;
+    sampler.min_filter = glTF::INVALID_INT_VALUE;
+    sampler.wrap_s = glTF::INVALID_INT_VALUE;
+    sampler.wrap_t = glTF::INVALID_INT_VALUE;
+
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "magFilter" ): sampler.mag_filter = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "minFilter" ): sampler.min_filter = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "wrapS" ): sampler.wrap_s = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "wrapT" ): sampler.wrap_t = json_parse_int( reader ); break;
+            default: json_skip_value( reader ); break;
+        }
+    }
+}
+
+static void parse_skin( JsonReader& reader, glTF::Skin& skin ) {
+    skin.skeleton_root_node_index = glTF::INVALID_INT_VALUE;
+    skin.inverse_bind_matrices_buffer_index = glTF::INVALID_INT_VALUE;
+
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "skeleton" ): skin.skeleton_root_node_index = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "inverseBindMatrices" ): skin.inverse_bind_matrices_buffer_index = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "joints" ): json_parse_int_array( reader, skin.joints_count, &skin.joints ); break;
+            default: json_skip_value( reader ); break;
+        }
+    }
+}
+
+static void parse_animation_sampler( JsonReader& reader, glTF::AnimationSampler& sampler ) {
+    sampler.input_keyframe_buffer_index = glTF::INVALID_INT_VALUE;
+    sampler.output_keyframe_buffer_index = glTF::INVALID_INT_VALUE;
+    sampler.interpolation = glTF::AnimationSampler::Linear;
+
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "input" ): sampler.input_keyframe_buffer_index = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "output" ): sampler.output_keyframe_buffer_index = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "interpolation" ):
+            {
+                StringView value = json_parse_string_view( reader );
+                switch ( json_key_hash( value ) ) {
+                    case hash_calculate_constexpr( "STEP" ): sampler.interpolation = glTF::AnimationSampler::Step; break;
+                    case hash_calculate_constexpr( "CUBICSPLINE" ): sampler.interpolation = glTF::AnimationSampler::CubicSpline; break;
+                    default: sampler.interpolation = glTF::AnimationSampler::Linear; break;
+                }
+                break;
+            }
+            default: json_skip_value( reader ); break;
+        }
+    }
+}
+
+static void parse_animation_channel_target( JsonReader& reader, glTF::AnimationChannel& channel ) {
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "node" ): channel.target_node = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "path" ):
+            {
+                StringView value = json_parse_string_view( reader );
+                switch ( json_key_hash( value ) ) {
+                    case hash_calculate_constexpr( "scale" ): channel.target_type = glTF::AnimationChannel::Scale; break;
+                    case hash_calculate_constexpr( "rotation" ): channel.target_type = glTF::AnimationChannel::Rotation; break;
+                    case hash_calculate_constexpr( "translation" ): channel.target_type = glTF::AnimationChannel::Translation; break;
+                    case hash_calculate_constexpr( "weights" ): channel.target_type = glTF::AnimationChannel::Weights; break;
+                    default:
+                        RASSERTM( false, "Error parsing target path %.*s\n", ( int )value.length, value.text );
+                        channel.target_type = glTF::AnimationChannel::Count;
+                        break;
+                }
+                break;
+            }
+            default: json_skip_value( reader ); break;
+        }
+    }
+}
+
+static void parse_animation_channel( JsonReader& reader, glTF::AnimationChannel& channel ) {
+    channel.sampler = glTF::INVALID_INT_VALUE;
+    channel.target_node = glTF::INVALID_INT_VALUE;
+    channel.target_type = glTF::AnimationChannel::Count;
+
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "sampler" ): channel.sampler = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "target" ): parse_animation_channel_target( reader, channel ); break;
+            default: json_skip_value( reader ); break;
+        }
+    }
+}
+
+static void parse_animation( JsonReader& reader, glTF::Animation& animation ) {
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "samplers" ): json_parse_object_array( reader, animation.samplers_count, &animation.samplers, parse_animation_sampler ); break;
+            case hash_calculate_constexpr( "channels" ): json_parse_object_array( reader, animation.channels_count, &animation.channels, parse_animation_channel ); break;
+            default: json_skip_value( reader ); break;
+        }
+    }
+}
+
+static bool parse_gltf( JsonReader& reader, glTF::glTF& gltf_data ) {
+    // "scene" is optional, default to the first one like the json loader.
+    gltf_data.scene = 0;
+
+    json_object_begin( reader, false );
+
+    StringView key;
+    while ( json_object_next( reader, key ) ) {
+        switch ( json_key_hash( key ) ) {
+            case hash_calculate_constexpr( "asset" ): parse_asset( reader, gltf_data.asset ); break;
+            case hash_calculate_constexpr( "scene" ): gltf_data.scene = json_parse_int( reader ); break;
+            case hash_calculate_constexpr( "scenes" ): json_parse_object_array( reader, gltf_data.scenes_count, &gltf_data.scenes, parse_scene ); break;
+            case hash_calculate_constexpr( "buffers" ): json_parse_object_array( reader, gltf_data.buffers_count, &gltf_data.buffers, parse_buffer ); break;
+            case hash_calculate_constexpr( "bufferViews" ): json_parse_object_array( reader, gltf_data.buffer_views_count, &gltf_data.buffer_views, parse_buffer_view ); break;
+            case hash_calculate_constexpr( "nodes" ): json_parse_object_array( reader, gltf_data.nodes_count, &gltf_data.nodes, parse_node ); break;
+            case hash_calculate_constexpr( "meshes" ): json_parse_object_array( reader, gltf_data.meshes_count, &gltf_data.meshes, parse_mesh ); break;
+            case hash_calculate_constexpr( "accessors" ): json_parse_object_array( reader, gltf_data.accessors_count, &gltf_data.accessors, parse_accessor ); break;
+            case hash_calculate_constexpr( "materials" ): json_parse_object_array( reader, gltf_data.materials_count, &gltf_data.materials, parse_material ); break;
+            case hash_calculate_constexpr( "textures" ): json_parse_object_array( reader, gltf_data.textures_count, &gltf_data.textures, parse_texture ); break;
+            case hash_calculate_constexpr( "images" ): json_parse_object_array( reader, gltf_data.images_count, &gltf_data.images, parse_image ); break;
+            case hash_calculate_constexpr( "samplers" ): json_parse_object_array( reader, gltf_data.samplers_count, &gltf_data.samplers, parse_sampler ); break;
+            case hash_calculate_constexpr( "skins" ): json_parse_object_array( reader, gltf_data.skins_count, &gltf_data.skins, parse_skin ); break;
+            case hash_calculate_constexpr( "animations" ): json_parse_object_array( reader, gltf_data.animations_count, &gltf_data.animations, parse_animation ); break;
+            default: json_skip_value( reader ); break;
+        }
+    }
+
+    return !reader.error;
+}
+
+// Find the json and binary chunks of a .glb container.
+static bool glb_read_chunks( const MappedFile& file, cstring file_path, StringView& json_chunk, StringView& binary_chunk ) {
+    const u32* header = ( const u32* )file.data;
+    if ( file.size < 20 || header[ 1 ] != k_glb_version || header[ 2 ] > file.size ) {
+        rprint( "Error: %s is not a valid glb version %u file.\n", file_path, k_glb_version );
+        return false;
+    }
+
+    const sizet total_size = header[ 2 ];
+    sizet offset = 12;
+
+    json_chunk = { nullptr, 0 };
+    binary_chunk = { nullptr, 0 };
+
+    while ( offset + 8 <= total_size ) {
+        const u32 chunk_length = *( const u32* )( file.data + offset );
+        const u32 chunk_type = *( const u32* )( file.data + offset + 4 );
+        offset += 8;
+        if ( offset + chunk_length > total_size ) {
+            break;
+        }
+
+        // Json comes first, the optional binary chunk second. Unknown chunks are skipped.
+        if ( chunk_type == k_glb_chunk_json && json_chunk.text == nullptr ) {
+            json_chunk = { file.data + offset, chunk_length };
+        } else if ( chunk_type == k_glb_chunk_bin && binary_chunk.text == nullptr ) {
+            binary_chunk = { file.data + offset, chunk_length };
+        }
+        offset += chunk_length;
+    }
+
+    if ( json_chunk.text == nullptr ) {
+        rprint( "Error: %s has no json chunk.\n", file_path );
+        return false;
+    }
+    return true;
+}
+
+glTF::glTF gltf_load_file( cstring file_path ) {
+    glTF::glTF result{ };
+
+    if ( !file_exists( file_path ) ) {
+        rprint( "Error: file %s does not exists.\n", file_path );
+        return result;
+    }
+
+    MappedFile file;
+    if ( !file_map( file_path, &file, FileMapFlags_WillNeed ) ) {
+        rprint( "Error: cannot map file %s.\n", file_path );
+        return result;
+    }
+
+    StringView json_text{ file.data, file.size };
+    StringView binary_chunk{ nullptr, 0 };
+    const bool is_glb = file.size >= 4 && *( const u32* )file.data == k_glb_magic;
+    if ( is_glb && !glb_read_chunks( file, file_path, json_text, binary_chunk ) ) {
+        file_unmap( &file );
+        return result;
+    }
+
+    // Structs take a few times the size of the json text they come from, address space
+    // is only reserved and pages are committed as the parser allocates.
+    result.allocator.init_virtual( rmega( 64 ) + json_text.length * 16 );
+
+    JsonReader reader{ json_text.text, json_text.text + json_text.length, json_text.text, &result.allocator, false };
+    if ( !parse_gltf( reader, result ) ) {
+        result.allocator.shutdown();
+        file_unmap( &file );
+        return glTF::glTF{ };
+    }
+
+    // The buffer without uri is the binary chunk, the mapping lives until gltf_free.
+    if ( binary_chunk.text != nullptr && result.buffers_count > 0 && result.buffers[ 0 ].uri.data == nullptr ) {
+        result.buffers[ 0 ].data = ( u8* )binary_chunk.text;
+        result.mapped_file = file;
+    } else {
+        file_unmap( &file );
+    }
+
+    return result;
+}
+
 void gltf_free( glTF::glTF& scene ) {
     scene.allocator.shutdown();
+    file_unmap( &scene.mapped_file );
 }
 
 i32 gltf_get_attribute_accessor_index( glTF::MeshPrimitive::Attribute* attributes, u32 attribute_count, cstring attribute_name ) {
@@ -615,6 +1635,125 @@ i32 gltf_get_attribute_accessor_index( glTF::MeshPrimitive::Attribute* attribute
     return -1;
 }
 
+
+// Benchmark //////////////////////////////////////////////////////////////
+
+static u64 gltf_checksum_add( u64 checksum, u64 value ) {
+    return checksum * 31 + value;
+}
+
+static u64 gltf_checksum_add_floats( u64 checksum, const f32* values, u32 count ) {
+    for ( u32 i = 0; i < count; ++i ) {
+        u32 bits;
+        memcpy( &bits, &values[ i ], sizeof( u32 ) );
+        checksum = gltf_checksum_add( checksum, bits );
+    }
+    return checksum;
+}
+
+// Covers the values the engine reads, so both loaders can be compared.
+static u64 gltf_benchmark_checksum( const glTF::glTF& gltf ) {
+    u64 checksum = gltf.scenes_count;
+    checksum = gltf_checksum_add( checksum, gltf.scene );
+    checksum = gltf_checksum_add( checksum, gltf.buffers_count );
+    checksum = gltf_checksum_add( checksum, gltf.buffer_views_count );
+    checksum = gltf_checksum_add( checksum, gltf.images_count );
+    checksum = gltf_checksum_add( checksum, gltf.textures_count );
+    checksum = gltf_checksum_add( checksum, gltf.samplers_count );
+    checksum = gltf_checksum_add( checksum, gltf.skins_count );
+
+    for ( u32 i = 0; i < gltf.buffer_views_count; ++i ) {
+        const glTF::BufferView& buffer_view = gltf.buffer_views[ i ];
+        checksum = gltf_checksum_add( checksum, buffer_view.buffer + buffer_view.byte_length + buffer_view.byte_offset + buffer_view.byte_stride );
+    }
+    for ( u32 i = 0; i < gltf.accessors_count; ++i ) {
+        const glTF::Accessor& accessor = gltf.accessors[ i ];
+        checksum = gltf_checksum_add( checksum, accessor.buffer_view + accessor.byte_offset + accessor.component_type + accessor.count + accessor.type );
+        checksum = gltf_checksum_add_floats( checksum, accessor.min, accessor.min_count );
+        checksum = gltf_checksum_add_floats( checksum, accessor.max, accessor.max_count );
+    }
+    for ( u32 i = 0; i < gltf.nodes_count; ++i ) {
+        const glTF::Node& node = gltf.nodes[ i ];
+        checksum = gltf_checksum_add( checksum, node.mesh + node.skin + node.children_count + node.name.current_size );
+        checksum = gltf_checksum_add_floats( checksum, node.matrix, node.matrix_count );
+        checksum = gltf_checksum_add_floats( checksum, node.translation, node.translation_count );
+        checksum = gltf_checksum_add_floats( checksum, node.rotation, node.rotation_count );
+        checksum = gltf_checksum_add_floats( checksum, node.scale, node.scale_count );
+    }
+    for ( u32 i = 0; i < gltf.meshes_count; ++i ) {
+        const glTF::Mesh& mesh = gltf.meshes[ i ];
+        for ( u32 p = 0; p < mesh.primitives_count; ++p ) {
+            const glTF::MeshPrimitive& primitive = mesh.primitives[ p ];
+            // The json document sorts attributes by name, the streaming loader keeps file order.
+            u64 attributes_checksum = 0;
+            for ( u32 a = 0; a < primitive.attribute_count; ++a ) {
+                attributes_checksum += hash_bytes( primitive.attributes[ a ].key.data, primitive.attributes[ a ].key.current_size ) + primitive.attributes[ a ].accessor_index;
+            }
+            checksum = gltf_checksum_add( checksum, primitive.indices + primitive.material + attributes_checksum );
+        }
+    }
+    for ( u32 i = 0; i < gltf.materials_count; ++i ) {
+        const glTF::Material& material = gltf.materials[ i ];
+        checksum = gltf_checksum_add( checksum, material.alpha_mode.current_size + material.double_sided + ( material.normal_texture ? material.normal_texture->index : 0 ) );
+        if ( material.pbr_metallic_roughness ) {
+            checksum = gltf_checksum_add_floats( checksum, material.pbr_metallic_roughness->base_color_factor, material.pbr_metallic_roughness->base_color_factor_count );
+        }
+    }
+    for ( u32 i = 0; i < gltf.animations_count; ++i ) {
+        const glTF::Animation& animation = gltf.animations[ i ];
+        for ( u32 c = 0; c < animation.channels_count; ++c ) {
+            checksum = gltf_checksum_add( checksum, animation.channels[ c ].sampler + animation.channels[ c ].target_node + animation.channels[ c ].target_type );
+        }
+        for ( u32 s = 0; s < animation.samplers_count; ++s ) {
+            checksum = gltf_checksum_add( checksum, animation.samplers[ s ].input_keyframe_buffer_index + animation.samplers[ s ].output_keyframe_buffer_index + animation.samplers[ s ].interpolation );
+        }
+    }
+
+    return checksum;
+}
+
+void gltf_parse_benchmark( cstring file_path, u32 iterations ) {
+    MappedFile file;
+    if ( iterations == 0 || !file_map( file_path, &file ) ) {
+        rprint( "glTF parse benchmark: cannot open %s.\n", file_path );
+        return;
+    }
+    // Throughput is measured on json bytes, the binary chunk of .glb files is not parsed.
+    const bool is_glb = file.size >= 20 && *( const u32* )file.data == k_glb_magic;
+    const sizet json_size = is_glb ? *( const u32* )( file.data + 12 ) : file.size;
+    const f64 json_mb = json_size / ( 1024.0 * 1024.0 );
+    file_unmap( &file );
+
+    u64 streaming_checksum = 0;
+    i64 start = time_now();
+    for ( u32 i = 0; i < iterations; ++i ) {
+        glTF::glTF gltf = gltf_load_file( file_path );
+        streaming_checksum = gltf_benchmark_checksum( gltf );
+        gltf_free( gltf );
+    }
+    const f64 streaming_ms = time_from_milliseconds( start ) / iterations;
+
+    rprint( "glTF parse benchmark %s (%.3f MB of json, %u iterations):\n", file_path, json_mb, iterations );
+    rprint( "  streaming:     %8.3f ms, %8.2f MB/s\n", streaming_ms, json_mb * 1000.0 / streaming_ms );
+
+    // The json document loader only reads .gltf files.
+    if ( is_glb ) {
+        return;
+    }
+
+    u64 json_checksum = 0;
+    start = time_now();
+    for ( u32 i = 0; i < iterations; ++i ) {
+        glTF::glTF gltf = gltf_load_file_json( file_path );
+        json_checksum = gltf_benchmark_checksum( gltf );
+        gltf_free( gltf );
+    }
+    const f64 json_ms = time_from_milliseconds( start ) / iterations;
+
+    rprint( "  json document: %8.3f ms, %8.2f MB/s\n", json_ms, json_mb * 1000.0 / json_ms );
+    rprint( "  speedup x%.2f, checksums %s\n", json_ms / streaming_ms, streaming_checksum == json_checksum ? "match" : "DIFFER" );
+}
+
 } // namespace raptor
 
 i32 raptor::glTF::get_data_offset( i32 accessor_offset, i32 buffer_view_offset ) {
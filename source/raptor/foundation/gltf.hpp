@@ -1,5 +1,6 @@
 #pragma once
 
+#include "file.hpp"
 #include "memory.hpp"
 #include "platform.hpp"
 #include "string.hpp"
@@ -236,6 +237,7 @@ namespace glTF {
         i32                         byte_length;
         StringBuffer                uri;
         StringBuffer                name;
+        u8*                         data;           // Binary chunk of a .glb file, nullptr when the buffer is read from uri.
     };
 
     struct CameraPerspective {
@@ -312,16 +314,23 @@ namespace glTF {
         Texture*                    textures;
 
         LinearAllocator             allocator;
+        MappedFile                  mapped_file;    // Kept mapped for .glb files, buffer data points inside it.
     };
 
     i32                             get_data_offset( i32 accessor_offset, i32 buffer_view_offset );
 
 } // namespace glTF
 
+    // Load a .gltf or .glb file. The json is parsed in a single streaming pass, no document is built.
+    // Returns an empty glTF ( scenes_count == 0 ) if the file is missing or invalid.
     glTF::glTF                      gltf_load_file( cstring file_path );
 
     void                            gltf_free( glTF::glTF& scene );
 
     i32                             gltf_get_attribute_accessor_index( glTF::MeshPrimitive::Attribute* attributes, u32 attribute_count, cstring attribute_name );
 
+    // Times gltf_load_file against a json document loader on the same file, printing MB/s
+    // and whether both produce the same data. Results go to rprint.
+    void                            gltf_parse_benchmark( cstring file_path, u32 iterations );
+
 } // namespace raptor
@@ -0,0 +1,249 @@
+#include "hash_map.hpp"
+#include "log.hpp"
+#include "time.hpp"
+
+#include <unordered_map>
+#include <mutex>
+
+namespace raptor {
+
+// Hashed string collision check //////////////////////////////////////////
+#if defined(RAPTOR_HASHED_STRING_CHECK)
+
+// Lives for the whole process: names are checked from static initialization
+// to shutdown, so the registry and its string copies are never freed.
+struct HashedStringRegistry {
+    MallocAllocator                 allocator;
+    FlatHashMap<u64, cstring>       strings;
+    std::mutex                      mutex;
+}; // struct HashedStringRegistry
+
+static HashedStringRegistry* s_hashed_string_registry = nullptr;
+
+void hashed_string_check( u64 hash, cstring string ) {
+    if ( string == nullptr ) {
+        return;
+    }
+
+    static std::once_flag once;
+    std::call_once( once, [] {
+        static HashedStringRegistry registry;
+        registry.strings.init( &registry.allocator, 256 );
+        s_hashed_string_registry = &registry;
+    } );
+
+    RASSERTM( hash == hash_calculate( string ), "Hashed string %s has a stale hash %llx", string, hash );
+
+    HashedStringRegistry& registry = *s_hashed_string_registry;
+    std::lock_guard<std::mutex> guard( registry.mutex );
+
+    FlatHashMapIterator it = registry.strings.find( hash );
+    if ( it.is_valid() ) {
+        cstring registered = registry.strings.get( it );
+        RASSERTM( strcmp( registered, string ) == 0, "Hash collision: %s and %s both hash to %llx", registered, string, hash );
+        return;
+    }
+
+    const sizet length = strlen( string ) + 1;
+    char* copy = ( char* )ralloca( length, &registry.allocator );
+    memcpy( copy, string, length );
+    registry.strings.insert( hash, copy );
+}
+
+#endif // RAPTOR_HASHED_STRING_CHECK
+
+// Benchmark //////////////////////////////////////////////////////////////
+
+// Same hash for both containers, so only the table layout and probing are compared.
+struct HashMapBenchmarkHasher {
+    sizet                           operator()( u64 key ) const { return hash_calculate( key ); }
+}; // struct HashMapBenchmarkHasher
+
+enum HashMapBenchmarkOperation {
+    HashMapBenchmarkOperation_Insert = 0,
+    HashMapBenchmarkOperation_FindHit,
+    HashMapBenchmarkOperation_FindHitPrecomputed,
+    HashMapBenchmarkOperation_FindMiss,
+    HashMapBenchmarkOperation_Erase,
+    HashMapBenchmarkOperation_Count
+}; // enum HashMapBenchmarkOperation
+
+static cstring s_hash_map_benchmark_operation_names[] = { "insert", "find hit", "find hit (hash)", "find miss", "erase" };
+
+// splitmix64
+static u64 hash_map_benchmark_random( u64& state ) {
+    u64 z = ( state += 0x9e3779b97f4a7c15ull );
+    z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+    z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebull;
+    return z ^ ( z >> 31 );
+}
+
+static f64 hash_map_benchmark_ns_per_op( i64 start, u64 count ) {
+    return time_from_microseconds( start ) * 1000.0 / ( f64 )count;
+}
+
+void hash_map_benchmark( u64 max_entries ) {
+    MallocAllocator allocator;
+
+    u64* keys = ( u64* )ralloca( sizeof( u64 ) * max_entries, &allocator );
+    u64* hashes = ( u64* )ralloca( sizeof( u64 ) * max_entries, &allocator );
+    u64* lookup_keys = ( u64* )ralloca( sizeof( u64 ) * max_entries, &allocator );
+    u64* miss_keys = ( u64* )ralloca( sizeof( u64 ) * max_entries, &allocator );
+
+    rprint( "Hash map benchmark, %s groups (%u wide), ns per operation:\n", Group::k_name, ( u32 )Group::kWidth );
+    rprint( "%10s %-16s %12s %12s %8s\n", "entries", "operation", "FlatHashMap", "unordered", "speedup" );
+
+    // Accumulated so the lookups can not be optimized away.
+    u64 checksum = 0;
+
+    for ( u64 entries = 1000; entries <= max_entries; entries *= 10 ) {
+        u64 random_state = entries;
+        for ( u64 i = 0; i < entries; ++i ) {
+            keys[ i ] = hash_map_benchmark_random( random_state );
+            // Even keys hit, odd keys from a separate stream miss (with overwhelming probability).
+            miss_keys[ i ] = hash_map_benchmark_random( random_state ) | 1;
+            keys[ i ] &= ~1ull;
+        }
+        // Look keys up in a different order than insertion to defeat prefetching.
+        for ( u64 i = 0; i < entries; ++i ) {
+            lookup_keys[ i ] = keys[ ( i * 7919 ) % entries ];
+            hashes[ i ] = hash_calculate( lookup_keys[ i ] );
+        }
+
+        f64 flat_ns[ HashMapBenchmarkOperation_Count ];
+        f64 std_ns[ HashMapBenchmarkOperation_Count ];
+
+        // FlatHashMap
+        {
+            FlatHashMap<u64, u64> map;
+            map.init( &allocator, 4 );
+
+            i64 start = time_now();
+            for ( u64 i = 0; i < entries; ++i ) {
+                map.insert( keys[ i ], i );
+            }
+            flat_ns[ HashMapBenchmarkOperation_Insert ] = hash_map_benchmark_ns_per_op( start, entries );
+
+            start = time_now();
+            for ( u64 i = 0; i < entries; ++i ) {
+                checksum += map.get( lookup_keys[ i ] );
+            }
+            flat_ns[ HashMapBenchmarkOperation_FindHit ] = hash_map_benchmark_ns_per_op( start, entries );
+
+            start = time_now();
+            for ( u64 i = 0; i < entries; ++i ) {
+                checksum += map.get( lookup_keys[ i ], hashes[ i ] );
+            }
+            flat_ns[ HashMapBenchmarkOperation_FindHitPrecomputed ] = hash_map_benchmark_ns_per_op( start, entries );
+
+            start = time_now();
+            for ( u64 i = 0; i < entries; ++i ) {
+                checksum += map.find( miss_keys[ i ] ).index;
+            }
+            flat_ns[ HashMapBenchmarkOperation_FindMiss ] = hash_map_benchmark_ns_per_op( start, entries );
+
+            start = time_now();
+            for ( u64 i = 0; i < entries; ++i ) {
+                checksum += map.remove( lookup_keys[ i ] );
+            }
+            flat_ns[ HashMapBenchmarkOperation_Erase ] = hash_map_benchmark_ns_per_op( start, entries );
+
+            RASSERT( map.size == 0 );
+            map.shutdown();
+        }
+
+        // std::unordered_map
+        {
+            std::unordered_map<u64, u64, HashMapBenchmarkHasher> map;
+
+            i64 start = time_now();
+            for ( u64 i = 0; i < entries; ++i ) {
+                map[ keys[ i ] ] = i;
+            }
+            std_ns[ HashMapBenchmarkOperation_Insert ] = hash_map_benchmark_ns_per_op( start, entries );
+
+            start = time_now();
+            for ( u64 i = 0; i < entries; ++i ) {
+                checksum += map.find( lookup_keys[ i ] )->second;
+            }
+            std_ns[ HashMapBenchmarkOperation_FindHit ] = hash_map_benchmark_ns_per_op( start, entries );
+            // No precomputed hash lookup in std::unordered_map.
+            std_ns[ HashMapBenchmarkOperation_FindHitPrecomputed ] = std_ns[ HashMapBenchmarkOperation_FindHit ];
+
+            start = time_now();
+            for ( u64 i = 0; i < entries; ++i ) {
+                checksum += map.find( miss_keys[ i ] ) == map.end();
+            }
+            std_ns[ HashMapBenchmarkOperation_FindMiss ] = hash_map_benchmark_ns_per_op( start, entries );
+
+            start = time_now();
+            for ( u64 i = 0; i < entries; ++i ) {
+                checksum += map.erase( lookup_keys[ i ] );
+            }
+            std_ns[ HashMapBenchmarkOperation_Erase ] = hash_map_benchmark_ns_per_op( start, entries );
+        }
+
+        for ( u32 o = 0; o < HashMapBenchmarkOperation_Count; ++o ) {
+            rprint( "%10llu %-16s %12.2f %12.2f %7.2fx\n", entries, s_hash_map_benchmark_operation_names[ o ], flat_ns[ o ], std_ns[ o ], std_ns[ o ] / flat_ns[ o ] );
+        }
+    }
+
+    rprint( "Hash map benchmark checksum %llu\n", checksum );
+
+    rfree( keys, &allocator );
+    rfree( hashes, &allocator );
+    rfree( lookup_keys, &allocator );
+    rfree( miss_keys, &allocator );
+}
+
+void hashed_string_benchmark( u32 frames ) {
+    MallocAllocator allocator;
+
+    // Names looked up every frame by the chapter 15 main loop and render passes.
+    static constexpr HashedString names[] = {
+        "motion_vectors", "visibility_motion_vectors", "depth", "shadow_visibility",
+        "indirect_lighting", "bilateral_weights", "svgf_output", "gbuffer_normals",
+        "lighting", "final", "shading_rate_image", "gbuffer_culling",
+        "deferred_lighting_compute", "commands_finalize", "debug_line_gpu", "temporal_aa",
+        "light_scattering", "composite_camera_motion", "meshlet_pointshadows_culling", "depth_cubemap" };
+
+    const u32 num_names = ArraySize( names );
+
+    // Same population as the frame graph resource map: the looked up names plus filler entries.
+    FlatHashMap<u64, u32> map;
+    map.init( &allocator, 256 );
+    for ( u32 i = 0; i < num_names; ++i ) {
+        map.insert( hash_calculate( names[ i ].string ), i );
+    }
+    char filler[ 32 ];
+    for ( u32 i = 0; i < 200; ++i ) {
+        snprintf( filler, sizeof( filler ), "filler_resource_%u", i );
+        map.insert( hash_calculate( filler ), num_names + i );
+    }
+
+    u64 checksum = 0;
+
+    i64 start = time_now();
+    for ( u32 f = 0; f < frames; ++f ) {
+        for ( u32 i = 0; i < num_names; ++i ) {
+            checksum += map.get( hash_calculate( names[ i ].string ) );
+        }
+    }
+    const f64 cstring_ns = time_from_microseconds( start ) * 1000.0 / frames;
+
+    start = time_now();
+    for ( u32 f = 0; f < frames; ++f ) {
+        for ( u32 i = 0; i < num_names; ++i ) {
+            const HashedString& name = names[ i ];
+            checksum += map.get( name.hash, name.key_hash );
+        }
+    }
+    const f64 hashed_ns = time_from_microseconds( start ) * 1000.0 / frames;
+
+    rprint( "Hashed string benchmark, %u lookups per frame: cstring %.1f ns/frame, HashedString %.1f ns/frame (%.2fx), checksum %llu\n",
+            num_names, cstring_ns, hashed_ns, cstring_ns / hashed_ns, checksum );
+
+    map.shutdown();
+}
+
+} // namespace raptor
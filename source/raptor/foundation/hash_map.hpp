@@ -6,6 +6,29 @@
 
 #include "external/wyhash.h"
 
+// Group kernel selection /////////////////////////////////////////////////
+// The control bytes are scanned one group at a time. The widest kernel
+// supported by the compilation target is picked; define RAPTOR_HASH_MAP_PORTABLE
+// to force the 8 wide scalar fallback or RAPTOR_HASH_MAP_NO_AVX2 to keep 16 wide
+// SSE2 groups on AVX2 builds.
+#if defined(RAPTOR_HASH_MAP_PORTABLE)
+    #define RAPTOR_HASH_MAP_GROUP_PORTABLE
+#elif defined(__AVX2__) && !defined(RAPTOR_HASH_MAP_NO_AVX2)
+    #define RAPTOR_HASH_MAP_GROUP_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+    #define RAPTOR_HASH_MAP_GROUP_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    #define RAPTOR_HASH_MAP_GROUP_NEON
+#else
+    #define RAPTOR_HASH_MAP_GROUP_PORTABLE
+#endif
+
+#if defined(RAPTOR_HASH_MAP_GROUP_AVX2) || defined(RAPTOR_HASH_MAP_GROUP_SSE2)
+    #include <immintrin.h>
+#elif defined(RAPTOR_HASH_MAP_GROUP_NEON)
+    #include <arm_neon.h>
+#endif
+
 namespace raptor {
 
 
@@ -44,7 +67,7 @@ namespace raptor {
     // Probing ////////////////////////////////////////////////////////////
     struct ProbeSequence {
 
-        static const u64            k_width = 16;   // TODO: this should be selectable.
+        static const u64            k_width;        // Group::kWidth of the selected kernel.
         static const sizet          k_engine_hash = 0x31d3a36013e;
 
         ProbeSequence( u64 hash, u64 mask );
@@ -86,6 +109,15 @@ namespace raptor {
         KeyValue&                   get_structure( const K& key );
         KeyValue&                   get_structure( const FlatHashMapIterator& it );
 
+        // Precomputed hash interface. 'hash' must be hash_calculate( key ): callers
+        // can compute it once (or at compile time) and skip hashing on every lookup.
+        FlatHashMapIterator         find( const K& key, u64 hash );
+        void                        insert( const K& key, const V& value, u64 hash );
+        u32                         remove( const K& key, u64 hash );
+
+        V&                          get( const K& key, u64 hash );
+        KeyValue&                   get_structure( const K& key, u64 hash );
+
         void                        set_default_value( const V& value );
 
         // Iterators
@@ -98,7 +130,7 @@ namespace raptor {
         // Internal methods
         void                        erase_meta( const FlatHashMapIterator& iterator );
 
-        FindResult                  find_or_prepare_insert( const K& key );
+        FindResult                  find_or_prepare_insert( const K& key, u64 hash );
         FindInfo                    find_first_non_full( u64 hash );
 
         u64                         prepare_insert( u64 hash );
@@ -134,6 +166,18 @@ namespace raptor {
 
     }; // struct FlatHashMap
 
+    // Benchmark //////////////////////////////////////////////////////////
+
+    // Times insert, find hit (runtime and precomputed hash), find miss and erase
+    // of random u64 keys for 1K entries up to max_entries, in steps of 10x,
+    // against std::unordered_map using the same hash. Results go to rprint.
+    void                            hash_map_benchmark( u64 max_entries );
+
+    // Per frame cost of ~20 name lookups as done by the chapter 15 main loop
+    // (frame graph resources, technique passes, bindings), hashing the cstring
+    // every call versus HashedString. Results go to rprint.
+    void                            hashed_string_benchmark( u32 frames );
+
     // Implementation /////////////////////////////////////////////////////
     //
     template<typename T>
@@ -156,6 +200,54 @@ namespace raptor {
         return wyhash( data, length, seed, _wyp );
     }
 
+    // Compile time hashing ///////////////////////////////////////////////
+    // constexpr port of wyhash (WYHASH_CONDOM 1, 64 bit multiply), matching
+    // hash_bytes/hash_calculate bit for bit on little endian targets.
+    constexpr u64           hash_bytes_constexpr( cstring data, sizet length, u64 seed = 0 );
+    constexpr u64           hash_calculate_constexpr( cstring string, u64 seed = 0 );
+    // Same as hash_calculate( key ) for a u64: the hash used by FlatHashMap<u64, V>.
+    constexpr u64           hash_key_constexpr( u64 key );
+
+    //
+    // A string together with its hash, and the hash of that hash as used by
+    // FlatHashMap<u64, V> keyed by name hashes. When built from a literal both
+    // are computed at compile time, so name lookups do not hash at all.
+    // Use rhashed( "name" ) to force compile time evaluation at call sites.
+    struct HashedString {
+
+        constexpr                   HashedString( u64 hash_, cstring string_ ) : hash( hash_ ), key_hash( hash_key_constexpr( hash_ ) ), string( string_ ) {}
+
+        template <sizet N>
+        constexpr                   HashedString( const char ( &string_ )[ N ] ) : HashedString( hash_bytes_constexpr( string_, N - 1 ), string_ ) {}
+
+        u64                         hash;       // hash_calculate( string )
+        u64                         key_hash;   // hash_calculate( hash )
+        cstring                     string;
+
+    }; // struct HashedString
+
+    template <u64 Value>
+    struct HashConstant {
+        static constexpr u64        k_value = Value;
+    }; // struct HashConstant
+
+    #define rhashed( string )       raptor::HashedString( raptor::HashConstant<raptor::hash_calculate_constexpr( string )>::k_value, string )
+
+    // Collision detection: in debug builds every hashed name seen at insertion
+    // and HashedString lookup is recorded, asserting if two different strings
+    // share a hash or if a HashedString hash does not match the runtime hash.
+#if defined(_DEBUG) || !defined(NDEBUG)
+    #define RAPTOR_HASHED_STRING_CHECK
+#endif
+
+#if defined(RAPTOR_HASHED_STRING_CHECK)
+    void                            hashed_string_check( u64 hash, cstring string );
+#else
+    inline void                     hashed_string_check( u64 hash, cstring string ) {}
+#endif // RAPTOR_HASHED_STRING_CHECK
+
+    inline void                     hashed_string_check( const HashedString& string ) { hashed_string_check( string.hash, string.string ); }
+
     // https://gankra.github.io/blah/hashbrown-tldr/
     // https://blog.waffles.space/2018/12/07/deep-dive-into-hashbrown/
     // https://abseil.io/blog/20180927-swisstables
@@ -187,8 +279,14 @@ namespace raptor {
     static i8               hash_2( u64 hash )                  { return hash & 0x7F; }
 
 
+    // Groups ///////////////////////////////////////////////////////////////
+    // Every group implementation exposes the same interface: the slot bitmask
+    // iterators over a window of kWidth control bytes starting at 'pos'.
+#if defined(RAPTOR_HASH_MAP_GROUP_AVX2) || defined(RAPTOR_HASH_MAP_GROUP_SSE2)
+
     struct GroupSse2Impl {
         static constexpr size_t kWidth = 16;  // the number of slots per group
+        static constexpr cstring k_name = "SSE2";
 
         explicit GroupSse2Impl( const i8* pos ) {
             ctrl = _mm_loadu_si128( reinterpret_cast< const __m128i* >( pos ) );
@@ -203,8 +301,8 @@ namespace raptor {
 
         // Returns a bitmask representing the positions of empty slots.
         BitMask<uint32_t, kWidth> MatchEmpty() const {
-#if ABSL_INTERNAL_RAW_HASH_SET_HAVE_SSSE3
-    // This only works because kEmpty is -128.
+#if defined(__SSSE3__) || defined(__AVX__)
+            // This only works because kEmpty is -128.
             return BitMask<uint32_t, kWidth>(
                 _mm_movemask_epi8( _mm_sign_epi8( ctrl, ctrl ) ) );
 #else
@@ -229,7 +327,7 @@ namespace raptor {
         void ConvertSpecialToEmptyAndFullToDeleted( i8* dst ) const {
             auto msbs = _mm_set1_epi8( static_cast< char >( -128 ) );
             auto x126 = _mm_set1_epi8( 126 );
-#if ABSL_INTERNAL_RAW_HASH_SET_HAVE_SSSE3
+#if defined(__SSSE3__) || defined(__AVX__)
             auto res = _mm_or_si128( _mm_shuffle_epi8( x126, ctrl ), msbs );
 #else
             auto zero = _mm_setzero_si128();
@@ -242,6 +340,166 @@ namespace raptor {
         __m128i ctrl;
     };
 
+#endif // RAPTOR_HASH_MAP_GROUP_AVX2 || RAPTOR_HASH_MAP_GROUP_SSE2
+
+#if defined(RAPTOR_HASH_MAP_GROUP_AVX2)
+
+    // 32 slots per group: one load and compare covers twice the SSE2 window,
+    // halving the probe steps on long sequences.
+    struct GroupAvx2Impl {
+        static constexpr size_t kWidth = 32;
+        static constexpr cstring k_name = "AVX2";
+
+        explicit GroupAvx2Impl( const i8* pos ) {
+            ctrl = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( pos ) );
+        }
+
+        BitMask<uint32_t, kWidth> Match( i8 hash ) const {
+            auto match = _mm256_set1_epi8( hash );
+            return BitMask<uint32_t, kWidth>( static_cast< uint32_t >(
+                _mm256_movemask_epi8( _mm256_cmpeq_epi8( match, ctrl ) ) ) );
+        }
+
+        BitMask<uint32_t, kWidth> MatchEmpty() const {
+            // This only works because kEmpty is -128: it is the only value whose sign
+            // survives negation.
+            return BitMask<uint32_t, kWidth>( static_cast< uint32_t >(
+                _mm256_movemask_epi8( _mm256_sign_epi8( ctrl, ctrl ) ) ) );
+        }
+
+        BitMask<uint32_t, kWidth> MatchEmptyOrDeleted() const {
+            auto special = _mm256_set1_epi8( k_control_bitmask_sentinel );
+            return BitMask<uint32_t, kWidth>( static_cast< uint32_t >(
+                _mm256_movemask_epi8( _mm256_cmpgt_epi8( special, ctrl ) ) ) );
+        }
+
+        uint32_t CountLeadingEmptyOrDeleted() const {
+            auto special = _mm256_set1_epi8( k_control_bitmask_sentinel );
+            // Widen before adding one: a fully empty group would overflow 32 bits.
+            const u64 mask = static_cast< uint32_t >( _mm256_movemask_epi8( _mm256_cmpgt_epi8( special, ctrl ) ) );
+            return static_cast< uint32_t >( trailing_zeros_u64( mask + 1 ) );
+        }
+
+        void ConvertSpecialToEmptyAndFullToDeleted( i8* dst ) const {
+            auto msbs = _mm256_set1_epi8( static_cast< char >( -128 ) );
+            auto x126 = _mm256_set1_epi8( 126 );
+            // Shuffle zeroes bytes with the top bit set, so specials become 0x80 and full 0xFE.
+            auto res = _mm256_or_si256( _mm256_shuffle_epi8( x126, ctrl ), msbs );
+            _mm256_storeu_si256( reinterpret_cast< __m256i* >( dst ), res );
+        }
+
+        __m256i ctrl;
+    };
+
+#endif // RAPTOR_HASH_MAP_GROUP_AVX2
+
+    // Scalar helpers shared by the NEON and portable groups, working on 8 control
+    // bytes packed in a little endian u64 with one bit per slot at the byte msb.
+    static const u64        k_group_msbs = 0x8080808080808080ull;
+    static const u64        k_group_lsbs = 0x0101010101010101ull;
+
+    static u64              group_convert_special_to_empty_and_full_to_deleted( u64 ctrl ) {
+        const u64 x = ctrl & k_group_msbs;
+        return ( ~x + ( x >> 7 ) ) & ~k_group_lsbs;
+    }
+
+#if defined(RAPTOR_HASH_MAP_GROUP_NEON)
+
+    struct GroupNeonImpl {
+        static constexpr size_t kWidth = 8;
+        static constexpr cstring k_name = "NEON";
+
+        explicit GroupNeonImpl( const i8* pos ) {
+            ctrl = vld1_u8( reinterpret_cast< const uint8_t* >( pos ) );
+        }
+
+        BitMask<uint64_t, kWidth, 3> Match( i8 hash ) const {
+            uint8x8_t mask = vceq_u8( ctrl, vdup_n_u8( static_cast< uint8_t >( hash ) ) );
+            return BitMask<uint64_t, kWidth, 3>( vget_lane_u64( vreinterpret_u64_u8( mask ), 0 ) & k_group_msbs );
+        }
+
+        BitMask<uint64_t, kWidth, 3> MatchEmpty() const {
+            uint8x8_t mask = vceq_s8( vdup_n_s8( k_control_bitmask_empty ), vreinterpret_s8_u8( ctrl ) );
+            return BitMask<uint64_t, kWidth, 3>( vget_lane_u64( vreinterpret_u64_u8( mask ), 0 ) & k_group_msbs );
+        }
+
+        BitMask<uint64_t, kWidth, 3> MatchEmptyOrDeleted() const {
+            uint8x8_t mask = vcgt_s8( vdup_n_s8( k_control_bitmask_sentinel ), vreinterpret_s8_u8( ctrl ) );
+            return BitMask<uint64_t, kWidth, 3>( vget_lane_u64( vreinterpret_u64_u8( mask ), 0 ) & k_group_msbs );
+        }
+
+        uint32_t CountLeadingEmptyOrDeleted() const {
+            // Full and sentinel bytes become 0xFF, the first one ends the run.
+            uint8x8_t mask = vcle_s8( vdup_n_s8( k_control_bitmask_sentinel ), vreinterpret_s8_u8( ctrl ) );
+            return bit_trailing_zeros( vget_lane_u64( vreinterpret_u64_u8( mask ), 0 ) ) >> 3;
+        }
+
+        void ConvertSpecialToEmptyAndFullToDeleted( i8* dst ) const {
+            const u64 res = group_convert_special_to_empty_and_full_to_deleted( vget_lane_u64( vreinterpret_u64_u8( ctrl ), 0 ) );
+            memcpy( dst, &res, sizeof( u64 ) );
+        }
+
+        uint8x8_t ctrl;
+    };
+
+#endif // RAPTOR_HASH_MAP_GROUP_NEON
+
+    // Portable group, bit tricks on a u64. Always compiled so it can be checked
+    // against the SIMD kernels. Assumes little endian control byte loads.
+    struct GroupPortableImpl {
+        static constexpr size_t kWidth = 8;
+        static constexpr cstring k_name = "Portable";
+
+        explicit GroupPortableImpl( const i8* pos ) {
+            memcpy( &ctrl, pos, sizeof( u64 ) );
+        }
+
+        // Can report false positives for bytes next to a real match (when hash
+        // differs only in the lowest bit); the key comparison filters them.
+        BitMask<uint64_t, kWidth, 3> Match( i8 hash ) const {
+            const u64 x = ctrl ^ ( k_group_lsbs * static_cast< u8 >( hash ) );
+            return BitMask<uint64_t, kWidth, 3>( ( x - k_group_lsbs ) & ~x & k_group_msbs );
+        }
+
+        // Empty is the only control value with bit 7 set and bit 1 clear.
+        BitMask<uint64_t, kWidth, 3> MatchEmpty() const {
+            return BitMask<uint64_t, kWidth, 3>( ( ctrl & ( ~ctrl << 6 ) ) & k_group_msbs );
+        }
+
+        // Empty and deleted have bit 7 set and bit 0 clear.
+        BitMask<uint64_t, kWidth, 3> MatchEmptyOrDeleted() const {
+            return BitMask<uint64_t, kWidth, 3>( ( ctrl & ( ~ctrl << 7 ) ) & k_group_msbs );
+        }
+
+        uint32_t CountLeadingEmptyOrDeleted() const {
+            constexpr u64 gaps = 0x00FEFEFEFEFEFEFEull;
+            return ( bit_trailing_zeros( ( ( ~ctrl & ( ctrl >> 7 ) ) | gaps ) + 1 ) + 7 ) >> 3;
+        }
+
+        void ConvertSpecialToEmptyAndFullToDeleted( i8* dst ) const {
+            const u64 res = group_convert_special_to_empty_and_full_to_deleted( ctrl );
+            memcpy( dst, &res, sizeof( u64 ) );
+        }
+
+        u64 ctrl;
+    };
+
+#if defined(RAPTOR_HASH_MAP_GROUP_AVX2)
+    using Group = GroupAvx2Impl;
+#elif defined(RAPTOR_HASH_MAP_GROUP_SSE2)
+    using Group = GroupSse2Impl;
+#elif defined(RAPTOR_HASH_MAP_GROUP_NEON)
+    using Group = GroupNeonImpl;
+#else
+    using Group = GroupPortableImpl;
+#endif
+
+    // Largest kWidth of all kernels, sizes the shared empty group.
+    static constexpr size_t k_group_max_width = 32;
+    static_assert( Group::kWidth <= k_group_max_width, "Group wider than the empty group" );
+
+    inline const u64 ProbeSequence::k_width = Group::kWidth;
+
     // Capacity ///////////////////////////////////////////////////////////
 
     //
@@ -269,11 +527,12 @@ namespace raptor {
     static void ConvertDeletedToEmptyAndFullToDeleted( i8* ctrl, size_t capacity ) {
         //assert( ctrl[ capacity ] == k_control_bitmask_sentinel );
         //assert( IsValidCapacity( capacity ) );
-        for ( i8* pos = ctrl; pos != ctrl + capacity + 1; pos += GroupSse2Impl::kWidth ) {
-            GroupSse2Impl{ pos }.ConvertSpecialToEmptyAndFullToDeleted( pos );
+        // Only called with capacity + 1 multiple of Group::kWidth, see rehash_and_grow_if_necessary.
+        for ( i8* pos = ctrl; pos < ctrl + capacity; pos += Group::kWidth ) {
+            Group{ pos }.ConvertSpecialToEmptyAndFullToDeleted( pos );
         }
         // Copy the cloned ctrl bytes.
-        raptor::memory_copy( ctrl + capacity + 1, ctrl, GroupSse2Impl::kWidth );
+        raptor::memory_copy( ctrl + capacity + 1, ctrl, Group::kWidth - 1 );
         ctrl[ capacity ] = k_control_bitmask_sentinel;
     }
 
@@ -281,7 +540,7 @@ namespace raptor {
     // FlatHashMap ////////////////////////////////////////////////////////
     template <typename K, typename V>
     void FlatHashMap<K,V>::reset_ctrl() {
-        memset( control_bytes, k_control_bitmask_empty, capacity + GroupSse2Impl::kWidth );
+        memset( control_bytes, k_control_bitmask_empty, capacity + Group::kWidth );
         control_bytes[ capacity ] = k_control_bitmask_sentinel;
         //SanitizerPoisonMemoryRegion( slots_, sizeof( slot_type ) * capacity_ );
     }
@@ -314,12 +573,16 @@ namespace raptor {
 
     template <typename K, typename V>
     FlatHashMapIterator FlatHashMap<K, V>::find( const K& key ) {
+        return find( key, hash_calculate( key ) );
+    }
+
+    template <typename K, typename V>
+    FlatHashMapIterator FlatHashMap<K, V>::find( const K& key, u64 hash ) {
 
-        const u64 hash = hash_calculate( key );
         ProbeSequence sequence = probe( hash );
 
         while ( true ) {
-            const GroupSse2Impl group{ control_bytes + sequence.get_offset() };
+            const Group group{ control_bytes + sequence.get_offset() };
             const i8 hash2 = hash_2( hash );
             for ( int i : group.Match( hash2 ) ) {
                 const KeyValue& key_value = *( slots_ + sequence.get_offset( i ) );
@@ -339,7 +602,12 @@ namespace raptor {
 
     template <typename K, typename V>
     void FlatHashMap<K, V>::insert( const K& key, const V& value ) {
-        const FindResult find_result = find_or_prepare_insert( key );
+        insert( key, value, hash_calculate( key ) );
+    }
+
+    template <typename K, typename V>
+    void FlatHashMap<K, V>::insert( const K& key, const V& value, u64 hash ) {
+        const FindResult find_result = find_or_prepare_insert( key, hash );
         if ( find_result.free_index ) {
             // Emplace
             slots_[ find_result.index ].key = key;
@@ -355,9 +623,9 @@ namespace raptor {
         --size;
 
         const u64 index = iterator.index;
-        const u64 index_before = ( index - GroupSse2Impl::kWidth ) & capacity;
-        const auto empty_after = GroupSse2Impl( control_bytes + index ).MatchEmpty();
-        const auto empty_before = GroupSse2Impl( control_bytes + index_before ).MatchEmpty();
+        const u64 index_before = ( index - Group::kWidth ) & capacity;
+        const auto empty_after = Group( control_bytes + index ).MatchEmpty();
+        const auto empty_before = Group( control_bytes + index_before ).MatchEmpty();
 
         // We count how many consecutive non empties we have to the right and to the
         // left of `it`. If the sum is >= kWidth then there is at least one probe
@@ -367,7 +635,7 @@ namespace raptor {
         const u64 zeros = trailing_zeros + leading_zeros;
         //printf( "%x, %x", empty_after.TrailingZeros(), empty_before.LeadingZeros() );
         bool was_never_full = empty_before && empty_after;
-        was_never_full = was_never_full && (zeros < GroupSse2Impl::kWidth);
+        was_never_full = was_never_full && (zeros < Group::kWidth);
 
         set_ctrl( index, was_never_full ? k_control_bitmask_empty : k_control_bitmask_deleted );
         growth_left += was_never_full;
@@ -375,7 +643,12 @@ namespace raptor {
 
     template <typename K, typename V>
     u32 FlatHashMap<K, V>::remove( const K& key ) {
-        FlatHashMapIterator iterator = find( key );
+        return remove( key, hash_calculate( key ) );
+    }
+
+    template <typename K, typename V>
+    u32 FlatHashMap<K, V>::remove( const K& key, u64 hash ) {
+        FlatHashMapIterator iterator = find( key, hash );
         if ( iterator.index == k_iterator_end )
             return 0;
 
@@ -393,12 +666,11 @@ namespace raptor {
     }
 
     template <typename K, typename V>
-    FindResult FlatHashMap<K, V>::find_or_prepare_insert( const K& key ) {
-        u64 hash = hash_calculate( key );
+    FindResult FlatHashMap<K, V>::find_or_prepare_insert( const K& key, u64 hash ) {
         ProbeSequence sequence = probe( hash );
 
         while ( true ) {
-            const GroupSse2Impl group{ control_bytes + sequence.get_offset() };
+            const Group group{ control_bytes + sequence.get_offset() };
             for ( int i : group.Match( hash_2( hash ) ) ) {
                 const KeyValue& key_value = *( slots_ + sequence.get_offset( i ) );
                 if ( key_value.key == key )
@@ -419,7 +691,7 @@ namespace raptor {
         ProbeSequence sequence = probe( hash );
 
         while ( true ) {
-            const GroupSse2Impl group{ control_bytes + sequence.get_offset() };
+            const Group group{ control_bytes + sequence.get_offset() };
             auto mask = group.MatchEmptyOrDeleted();
 
             if ( mask ) {
@@ -450,8 +722,9 @@ namespace raptor {
     void FlatHashMap<K, V>::rehash_and_grow_if_necessary() {
         if ( capacity == 0 ) {
             resize( 1 );
-        } else if ( size <= capacity_to_growth( capacity ) / 2 ) {
+        } else if ( capacity > Group::kWidth && size <= capacity_to_growth( capacity ) / 2 ) {
             // Squash DELETED without growing if there is enough capacity.
+            // Tables fitting a single group are cheap to grow instead.
             drop_deletes_without_resize();
         } else {
             // Otherwise grow the container.
@@ -479,7 +752,7 @@ namespace raptor {
         //       swap current element with target element
         //       mark target as FULL
         //       repeat procedure for current slot with moved from element (target)
-        //ConvertDeletedToEmptyAndFullToDeleted( control_bytes, capacity );
+        ConvertDeletedToEmptyAndFullToDeleted( control_bytes, capacity );
 
         alignas( KeyValue ) unsigned char raw[ sizeof( KeyValue ) ];
         size_t total_probe_length = 0;
@@ -499,7 +772,7 @@ namespace raptor {
             // If they do, we don't need to move the object as it falls already in the
             // best probe we can.
             const auto probe_index = [&]( size_t pos ) {
-                return ( ( pos - probe( hash ).get_offset() ) & capacity ) / GroupSse2Impl::kWidth;
+                return ( ( pos - probe( hash ).get_offset() ) & capacity ) / Group::kWidth;
             };
 
             // Element doesn't move.
@@ -531,7 +804,7 @@ namespace raptor {
 
     template <typename K, typename V>
     u64 FlatHashMap<K, V>::calculate_size( u64 new_capacity ) {
-        return ( new_capacity + GroupSse2Impl::kWidth + new_capacity * ( sizeof( KeyValue ) ) );
+        return ( new_capacity + Group::kWidth + new_capacity * ( sizeof( KeyValue ) ) );
     }
 
     template <typename K, typename V>
@@ -540,7 +813,7 @@ namespace raptor {
         char* new_memory = ( char* )ralloca( calculate_size( capacity ), allocator );
 
         control_bytes = reinterpret_cast< i8* >( new_memory );
-        slots_ = reinterpret_cast< KeyValue* >( new_memory + capacity + GroupSse2Impl::kWidth );
+        slots_ = reinterpret_cast< KeyValue* >( new_memory + capacity + Group::kWidth );
 
         reset_ctrl();
         reset_growth_left();
@@ -592,13 +865,18 @@ namespace raptor {
         }*/
 
         control_bytes[ i ] = h;
-        constexpr size_t kClonedBytes = GroupSse2Impl::kWidth - 1;
+        constexpr size_t kClonedBytes = Group::kWidth - 1;
         control_bytes[ ( ( i - kClonedBytes ) & capacity ) + ( kClonedBytes & capacity ) ] = h;
     }
 
     template <typename K, typename V>
     V& FlatHashMap<K, V>::get( const K& key ) {
-        FlatHashMapIterator iterator = find( key );
+        return get( key, hash_calculate( key ) );
+    }
+
+    template <typename K, typename V>
+    V& FlatHashMap<K, V>::get( const K& key, u64 hash ) {
+        FlatHashMapIterator iterator = find( key, hash );
         if ( iterator.index != k_iterator_end )
             return slots_[ iterator.index ].value;
         return default_key_value.value;
@@ -613,7 +891,12 @@ namespace raptor {
 
     template <typename K, typename V>
     typename FlatHashMap<K, V>::KeyValue& FlatHashMap<K, V>::get_structure( const K& key ) {
-        FlatHashMapIterator iterator = find( key );
+        return get_structure( key, hash_calculate( key ) );
+    }
+
+    template <typename K, typename V>
+    typename FlatHashMap<K, V>::KeyValue& FlatHashMap<K, V>::get_structure( const K& key, u64 hash ) {
+        FlatHashMapIterator iterator = find( key, hash );
         if ( iterator.index != k_iterator_end )
             return slots_[ iterator.index ];
         return default_key_value;
@@ -651,7 +934,7 @@ namespace raptor {
         i8* ctrl = control_bytes + it.index;
 
         while ( control_is_empty_or_deleted( *ctrl ) ) {
-            u32 shift = GroupSse2Impl{ ctrl }.CountLeadingEmptyOrDeleted();
+            u32 shift = Group{ ctrl }.CountLeadingEmptyOrDeleted();
             ctrl += shift;
             it.index += shift;
         }
@@ -693,7 +976,13 @@ namespace raptor {
     u64 capacity_normalize( u64 n )         { return n ? ~u64{} >> lzcnt_soft( n ) : 1; }
 
     //
-    u64 capacity_to_growth( u64 capacity )  { return capacity - capacity / 8; }
+    u64 capacity_to_growth( u64 capacity )  {
+        // x-x/8 does not work when x==7 with 8 wide groups: the single group would never see an empty slot.
+        if ( Group::kWidth == 8 && capacity == 7 ) {
+            return 6;
+        }
+        return capacity - capacity / 8;
+    }
 
     //
     u64 capacity_growth_to_lower_bound( u64 growth ) { return growth + static_cast< u64 >( ( static_cast< i64 >( growth ) - 1 ) / 7 ); }
@@ -701,13 +990,99 @@ namespace raptor {
 
     // Grouping: implementation ///////////////////////////////////////////
     inline i8* group_init_empty() {
-        alignas( 16 ) static constexpr i8 empty_group[] = {
+        alignas( 32 ) static constexpr i8 empty_group[ k_group_max_width ] = {
             k_control_bitmask_sentinel, k_control_bitmask_empty, k_control_bitmask_empty, k_control_bitmask_empty, k_control_bitmask_empty, k_control_bitmask_empty, k_control_bitmask_empty, k_control_bitmask_empty,
+            k_control_bitmask_empty,    k_control_bitmask_empty, k_control_bitmask_empty, k_control_bitmask_empty, k_control_bitmask_empty, k_control_bitmask_empty, k_control_bitmask_empty, k_control_bitmask_empty,
+            k_control_bitmask_empty,    k_control_bitmask_empty, k_control_bitmask_empty, k_control_bitmask_empty, k_control_bitmask_empty, k_control_bitmask_empty, k_control_bitmask_empty, k_control_bitmask_empty,
             k_control_bitmask_empty,    k_control_bitmask_empty, k_control_bitmask_empty, k_control_bitmask_empty, k_control_bitmask_empty, k_control_bitmask_empty, k_control_bitmask_empty, k_control_bitmask_empty };
         return const_cast< i8* >( empty_group );
     }
 
 
+    // Compile time hashing: implementation ///////////////////////////////
+    constexpr u64 hash_constexpr_read8( cstring p ) {
+        u64 v = 0;
+        for ( u32 i = 0; i < 8; ++i ) {
+            v |= static_cast< u64 >( static_cast< u8 >( p[ i ] ) ) << ( i * 8 );
+        }
+        return v;
+    }
+
+    constexpr u64 hash_constexpr_read4( cstring p ) {
+        u64 v = 0;
+        for ( u32 i = 0; i < 4; ++i ) {
+            v |= static_cast< u64 >( static_cast< u8 >( p[ i ] ) ) << ( i * 8 );
+        }
+        return v;
+    }
+
+    constexpr u64 hash_constexpr_read3( cstring p, sizet k ) {
+        return ( static_cast< u64 >( static_cast< u8 >( p[ 0 ] ) ) << 16 ) | ( static_cast< u64 >( static_cast< u8 >( p[ k >> 1 ] ) ) << 8 ) | static_cast< u8 >( p[ k - 1 ] );
+    }
+
+    // 64x64 -> 128 bit multiply, returns the xor of the two halves (_wymix).
+    constexpr u64 hash_constexpr_mix( u64 a, u64 b ) {
+        const u64 ha = a >> 32, hb = b >> 32, la = static_cast< u32 >( a ), lb = static_cast< u32 >( b );
+        const u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+        const u64 t = rl + ( rm0 << 32 );
+        u64 c = t < rl;
+        const u64 lo = t + ( rm1 << 32 );
+        c += lo < t;
+        const u64 hi = rh + ( rm0 >> 32 ) + ( rm1 >> 32 ) + c;
+        return lo ^ hi;
+    }
+
+    constexpr u64 hash_bytes_constexpr( cstring p, sizet length, u64 seed ) {
+        static_assert( WYHASH_CONDOM == 1 && WYHASH_32BIT_MUM == 0, "hash_bytes_constexpr mirrors the default wyhash configuration" );
+        constexpr u64 secret[ 4 ] = { 0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull };
+
+        seed ^= secret[ 0 ];
+        u64 a = 0, b = 0;
+        if ( length <= 16 ) {
+            if ( length >= 4 ) {
+                a = ( hash_constexpr_read4( p ) << 32 ) | hash_constexpr_read4( p + ( ( length >> 3 ) << 2 ) );
+                b = ( hash_constexpr_read4( p + length - 4 ) << 32 ) | hash_constexpr_read4( p + length - 4 - ( ( length >> 3 ) << 2 ) );
+            } else if ( length > 0 ) {
+                a = hash_constexpr_read3( p, length );
+            }
+        } else {
+            sizet i = length;
+            if ( i > 48 ) {
+                u64 see1 = seed, see2 = seed;
+                do {
+                    seed = hash_constexpr_mix( hash_constexpr_read8( p ) ^ secret[ 1 ], hash_constexpr_read8( p + 8 ) ^ seed );
+                    see1 = hash_constexpr_mix( hash_constexpr_read8( p + 16 ) ^ secret[ 2 ], hash_constexpr_read8( p + 24 ) ^ see1 );
+                    see2 = hash_constexpr_mix( hash_constexpr_read8( p + 32 ) ^ secret[ 3 ], hash_constexpr_read8( p + 40 ) ^ see2 );
+                    p += 48;
+                    i -= 48;
+                } while ( i > 48 );
+                seed ^= see1 ^ see2;
+            }
+            while ( i > 16 ) {
+                seed = hash_constexpr_mix( hash_constexpr_read8( p ) ^ secret[ 1 ], hash_constexpr_read8( p + 8 ) ^ seed );
+                i -= 16;
+                p += 16;
+            }
+            a = hash_constexpr_read8( p + i - 16 );
+            b = hash_constexpr_read8( p + i - 8 );
+        }
+        return hash_constexpr_mix( secret[ 1 ] ^ length, hash_constexpr_mix( a ^ secret[ 1 ], b ^ seed ) );
+    }
+
+    constexpr u64 hash_calculate_constexpr( cstring string, u64 seed ) {
+        sizet length = 0;
+        while ( string[ length ] ) {
+            ++length;
+        }
+        return hash_bytes_constexpr( string, length, seed );
+    }
+
+    constexpr u64 hash_key_constexpr( u64 key ) {
+        const char bytes[ 8 ] = { ( char )( key ), ( char )( key >> 8 ), ( char )( key >> 16 ), ( char )( key >> 24 ),
+                                  ( char )( key >> 32 ), ( char )( key >> 40 ), ( char )( key >> 48 ), ( char )( key >> 56 ) };
+        return hash_bytes_constexpr( bytes, 8 );
+    }
+
     // Probing: implementation ////////////////////////////////////////////
     inline ProbeSequence::ProbeSequence( u64 hash_, u64 mask_ ) {
         //assert( ( ( mask_ + 1 ) & mask_ ) == 0 && "not a mask" );
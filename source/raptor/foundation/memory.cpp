@@ -1,16 +1,37 @@
 #include "memory.hpp"
 #include "memory_utils.hpp"
 #include "assert.hpp"
+#include "numerics.hpp"
+#include "time.hpp"
+#include "file.hpp"
+#include "array.hpp"
+#include "hash_map.hpp"
 
 #include "external/tlsf.h"
 
 #include <stdlib.h>
 #include <memory.h>
 
+#if defined(_WIN64)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 #if defined RAPTOR_IMGUI
 #include "external/imgui/imgui.h"
 #endif // RAPTOR_IMGUI
 
+#include "external/tracy/tracy/Tracy.hpp"
+
 // Define this and add StackWalker to heavy memory profile
 //#define RAPTOR_MEMORY_STACK
 
@@ -39,6 +60,7 @@ static size_t s_size = rmega(32) + tlsf_size() + 8;
 //
 // Walker methods
 static void exit_walker( void* ptr, size_t size, int used, void* user );
+static void count_walker( void* ptr, size_t size, int used, void* user );
 static void imgui_walker( void* ptr, size_t size, int used, void* user );
 
 MemoryService* MemoryService::instance() {
@@ -51,11 +73,17 @@ void MemoryService::init( void* configuration ) {
 
     rprint( "Memory Service Init\n" );
     MemoryServiceConfiguration* memory_configuration = static_cast< MemoryServiceConfiguration* >( configuration );
-    system_allocator.init( memory_configuration ? memory_configuration->maximum_dynamic_size : s_size );
+    system_allocator.init( memory_configuration ? memory_configuration->maximum_dynamic_size : s_size,
+                           memory_configuration ? memory_configuration->thread_safe_system_allocator : false );
+
+    if ( memory_configuration && memory_configuration->enable_allocation_tracking ) {
+        system_allocator.enable_tracking();
+    }
 }
 
 void MemoryService::shutdown() {
 
+    frame_thread_arenas.shutdown();
     system_allocator.shutdown();
 
     rprint( "Memory Service Shutdown\n" );
@@ -69,6 +97,11 @@ void exit_walker( void* ptr, size_t size, int used, void* user ) {
         rprint( "Found active allocation %p, %llu\n", ptr, size );
 }
 
+void count_walker( void* /*ptr*/, size_t size, int used, void* user ) {
+    MemoryStatistics* stats = ( MemoryStatistics* )user;
+    stats->add( used ? size : 0 );
+}
+
 #if defined RAPTOR_IMGUI
 void imgui_walker( void* ptr, size_t size, int used, void* user ) {
 
@@ -94,6 +127,23 @@ void MemoryService::imgui_draw() {
     if ( ImGui::Begin( "Memory Service" ) ) {
 
         system_allocator.debug_ui();
+        frame_thread_arenas.debug_ui();
+
+        ImGui::Separator();
+        static const u32 k_benchmark_threads[] = { 1, 4, 16 };
+        static f64 locked_results[ ArraySize( k_benchmark_threads ) ]{};
+        static f64 concurrent_results[ ArraySize( k_benchmark_threads ) ]{};
+        if ( ImGui::Button( "Run heap benchmark" ) ) {
+            for ( u32 i = 0; i < ArraySize( k_benchmark_threads ); ++i ) {
+                heap_benchmark( k_benchmark_threads[ i ], 200000, locked_results[ i ], concurrent_results[ i ] );
+            }
+        }
+        for ( u32 i = 0; i < ArraySize( k_benchmark_threads ); ++i ) {
+            ImGui::Text( "\t%2u threads: locked %.0f allocs/ms, thread safe %.0f allocs/ms", k_benchmark_threads[ i ], locked_results[ i ], concurrent_results[ i ] );
+        }
+        if ( ImGui::Button( "Run heap thread churn test" ) ) {
+            heap_churn_test( 8, 4 );
+        }
     }
     ImGui::End();
 }
@@ -123,13 +173,792 @@ void MemoryService::test() {
     //rfree( out_bounds, &la );
 }
 
+//
+// Each thread repeatedly fills a window of random sized small allocations and frees it.
+static void heap_benchmark_thread( Allocator* allocator, std::mutex* mutex, u32 allocations, u32 seed ) {
+    static const u32 k_window = 256;
+    void* pointers[ k_window ];
+
+    u32 random_state = seed * 2654435761u + 1;
+    for ( u32 i = 0; i < allocations; i += k_window ) {
+        const u32 count = min( k_window, allocations - i );
+        for ( u32 a = 0; a < count; ++a ) {
+            random_state ^= random_state << 13;
+            random_state ^= random_state >> 17;
+            random_state ^= random_state << 5;
+            const sizet size = 8 + ( random_state & 1023 );
+
+            if ( mutex ) {
+                std::lock_guard<std::mutex> guard( *mutex );
+                pointers[ a ] = allocator->allocate( size, 1 );
+            } else {
+                pointers[ a ] = allocator->allocate( size, 1 );
+            }
+        }
+
+        for ( u32 a = 0; a < count; ++a ) {
+            if ( mutex ) {
+                std::lock_guard<std::mutex> guard( *mutex );
+                allocator->deallocate( pointers[ a ] );
+            } else {
+                allocator->deallocate( pointers[ a ] );
+            }
+        }
+    }
+}
+
+static f64 heap_benchmark_run( HeapAllocator* heap, std::mutex* mutex, u32 num_threads, u32 allocations_per_thread ) {
+    std::thread* threads = new std::thread[ num_threads ];
+
+    const i64 start = time_now();
+    for ( u32 t = 0; t < num_threads; ++t ) {
+        threads[ t ] = std::thread( heap_benchmark_thread, heap, mutex, allocations_per_thread, t );
+    }
+    for ( u32 t = 0; t < num_threads; ++t ) {
+        threads[ t ].join();
+    }
+    const f64 elapsed_ms = time_from_milliseconds( start );
+
+    delete[] threads;
+
+    return ( f64 )num_threads * allocations_per_thread / ( elapsed_ms > 0.0 ? elapsed_ms : 1.0 );
+}
+
+void MemoryService::heap_benchmark( u32 num_threads, u32 allocations_per_thread, f64& locked_per_ms, f64& concurrent_per_ms ) {
+
+    HeapAllocator locked_heap;
+    locked_heap.init( rmega( 64 ) );
+    std::mutex locked_heap_mutex;
+    locked_per_ms = heap_benchmark_run( &locked_heap, &locked_heap_mutex, num_threads, allocations_per_thread );
+    locked_heap.shutdown();
+
+    HeapAllocator concurrent_heap;
+    concurrent_heap.init( rmega( 64 ), true );
+    concurrent_per_ms = heap_benchmark_run( &concurrent_heap, nullptr, num_threads, allocations_per_thread );
+    concurrent_heap.shutdown();
+
+    rprint( "Heap benchmark %u threads: locked single pool %.0f allocs/ms, thread safe heap %.0f allocs/ms (%.2fx)\n",
+            num_threads, locked_per_ms, concurrent_per_ms, concurrent_per_ms / locked_per_ms );
+}
+
 // Memory Structs /////////////////////////////////////////////////////////
 
+// Concurrent heap ////////////////////////////////////////////////////////
+
+//
+// Small allocations are rounded up to one of these classes and served by the calling thread cache.
+static const u32    k_heap_size_classes[]       = { 16, 32, 64, 128, 256, 512, 1024, 2048 };
+static const u32    k_heap_num_size_classes     = ArraySize( k_heap_size_classes );
+static const u32    k_heap_large_class          = u32_max;
+static const sizet  k_heap_chunk_size           = rkilo( 64 );
+static const u32    k_heap_thread_cache_slots   = 4;
+// Added to the allocated bytes of a cache while its thread holds it. Block sizes are multiples
+// of 16, so the bit is free: the cache goes back to the pool when the count drops to zero.
+static const sizet  k_heap_owner_reference      = 1;
+
+struct HeapThreadCache;
+
+//
+// Placed right before every pointer returned in thread safe mode.
+struct HeapBlockHeader {
+    HeapThreadCache*                owner;          // Cache that carved the block, nullptr for large blocks.
+    u32                             size_class;
+    u32                             offset;         // Distance from the TLSF block start to the user pointer (large blocks only).
+}; // struct HeapBlockHeader
+
+static_assert( sizeof( HeapBlockHeader ) == 16, "Heap block header must keep 16 bytes alignment" );
+
+struct HeapFreeBlock {
+    HeapFreeBlock*                  next;
+}; // struct HeapFreeBlock
+
+struct HeapChunk {
+    HeapChunk*                      next;
+    u64                             padding;
+}; // struct HeapChunk
+
+//
+//
+struct HeapThreadCache {
+    HeapFreeBlock*                  free_lists[ k_heap_num_size_classes ]   = {};
+    // Blocks freed by other threads, pushed lock-free and reclaimed in bulk by the owner.
+    std::atomic<HeapFreeBlock*>     remote_frees[ k_heap_num_size_classes ] = {};
+
+    // Bytes in use from this cache, kept per cache to avoid a shared counter, plus k_heap_owner_reference
+    // until the owner thread exits or evicts it.
+    std::atomic<sizet>              allocated_bytes { k_heap_owner_reference };
+
+    HeapChunk*                      chunks          = nullptr;
+    HeapThreadCache*                next            = nullptr;
+}; // struct HeapThreadCache
+
+//
+//
+struct HeapConcurrentState {
+
+    void                            lock();
+    void                            unlock();
+
+    sizet                           get_allocated_bytes();
+
+    std::atomic<bool>               locked          { false };
+    std::atomic<u32>                cache_count     { 0 };
+
+    HeapThreadCache*                caches          = nullptr;  // Guarded by lock.
+    sizet                           large_allocated_bytes = 0;  // Guarded by lock.
+    u64                             generation      = 0;
+    void*                           tlsf_handle     = nullptr;
+
+    HeapConcurrentState*            next_live       = nullptr;  // Guarded by s_heap_live_mutex.
+}; // struct HeapConcurrentState
+
+// Heaps in thread safe mode that are not shut down, so that exiting threads
+// only touch caches of live heaps.
+static std::mutex                   s_heap_live_mutex;
+static HeapConcurrentState*         s_heap_live_states = nullptr;
+
+void HeapConcurrentState::lock() {
+    for ( ;; ) {
+        if ( !locked.exchange( true, std::memory_order_acquire ) ) {
+            return;
+        }
+        while ( locked.load( std::memory_order_relaxed ) ) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void HeapConcurrentState::unlock() {
+    locked.store( false, std::memory_order_release );
+}
+
+sizet HeapConcurrentState::get_allocated_bytes() {
+    lock();
+    sizet total = large_allocated_bytes;
+    for ( HeapThreadCache* cache = caches; cache; cache = cache->next ) {
+        total += cache->allocated_bytes.load( std::memory_order_relaxed ) & ~k_heap_owner_reference;
+    }
+    unlock();
+    return total;
+}
+
+//
+// Each thread remembers its cache for the last few heaps it used.
+// The generation protects against a new heap reusing the address of a destroyed one.
+struct HeapThreadCacheSlot {
+    HeapConcurrentState*            state;
+    u64                             generation;
+    HeapThreadCache*                cache;
+}; // struct HeapThreadCacheSlot
+
+//
+// Gives the caches back when the thread exits.
+struct HeapThreadCacheSlots {
+    ~HeapThreadCacheSlots();
+
+    HeapThreadCacheSlot             slots[ k_heap_thread_cache_slots ] = {};
+}; // struct HeapThreadCacheSlots
+
+static thread_local HeapThreadCacheSlots s_thread_caches;
+static std::atomic<u64>             s_heap_generation{ 1 };
+
+static void heap_release_thread_cache( HeapConcurrentState* state, HeapThreadCache* cache );
+
+// Drop the owner reference of the cache in the slot, if its heap is still alive. Blocks still
+// in use keep the cache until they are freed, by any thread.
+static void heap_abandon_thread_cache( HeapThreadCacheSlot& slot ) {
+    if ( slot.state == nullptr ) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard( s_heap_live_mutex );
+
+    for ( HeapConcurrentState* state = s_heap_live_states; state; state = state->next_live ) {
+        if ( state == slot.state && state->generation == slot.generation ) {
+            HeapThreadCache* cache = slot.cache;
+            if ( cache->allocated_bytes.fetch_sub( k_heap_owner_reference, std::memory_order_acq_rel ) == k_heap_owner_reference ) {
+                heap_release_thread_cache( state, cache );
+            }
+            break;
+        }
+    }
+
+    slot = { };
+}
+
+HeapThreadCacheSlots::~HeapThreadCacheSlots() {
+    for ( u32 i = 0; i < k_heap_thread_cache_slots; ++i ) {
+        heap_abandon_thread_cache( slots[ i ] );
+    }
+}
+
+static u32 heap_size_class( sizet size ) {
+    for ( u32 i = 0; i < k_heap_num_size_classes; ++i ) {
+        if ( size <= k_heap_size_classes[ i ] ) {
+            return i;
+        }
+    }
+    return k_heap_large_class;
+}
+
+static HeapThreadCache* heap_find_thread_cache( HeapConcurrentState* state ) {
+    for ( u32 i = 0; i < k_heap_thread_cache_slots; ++i ) {
+        const HeapThreadCacheSlot& slot = s_thread_caches.slots[ i ];
+        if ( slot.state == state && slot.generation == state->generation ) {
+            return slot.cache;
+        }
+    }
+    return nullptr;
+}
+
+static HeapThreadCache* heap_get_thread_cache( HeapConcurrentState* state ) {
+    HeapThreadCache* cache = heap_find_thread_cache( state );
+    if ( cache ) {
+        return cache;
+    }
+
+    cache = new HeapThreadCache();
+
+    state->lock();
+    cache->next = state->caches;
+    state->caches = cache;
+    state->unlock();
+    state->cache_count.fetch_add( 1, std::memory_order_relaxed );
+
+    // Use a free slot if possible, otherwise evict one: the evicted cache is given back like on
+    // thread exit, and its heap will simply create another cache for this thread.
+    u32 slot_index = ( u32 )( state->generation % k_heap_thread_cache_slots );
+    for ( u32 i = 0; i < k_heap_thread_cache_slots; ++i ) {
+        if ( s_thread_caches.slots[ i ].state == nullptr ) {
+            slot_index = i;
+            break;
+        }
+    }
+    heap_abandon_thread_cache( s_thread_caches.slots[ slot_index ] );
+    s_thread_caches.slots[ slot_index ] = { state, state->generation, cache };
+
+    return cache;
+}
+
+// Carve a new chunk from the TLSF pool into blocks of the given class.
+static HeapFreeBlock* heap_refill( HeapConcurrentState* state, void* tlsf_handle, HeapThreadCache* cache, u32 size_class ) {
+    state->lock();
+    u8* chunk_memory = ( u8* )tlsf_memalign( tlsf_handle, sizeof( HeapBlockHeader ), k_heap_chunk_size );
+    state->unlock();
+
+    if ( !chunk_memory ) {
+        return nullptr;
+    }
+
+    HeapChunk* chunk = ( HeapChunk* )chunk_memory;
+    chunk->next = cache->chunks;
+    cache->chunks = chunk;
+
+    const sizet stride = k_heap_size_classes[ size_class ] + sizeof( HeapBlockHeader );
+    const sizet block_count = ( k_heap_chunk_size - sizeof( HeapChunk ) ) / stride;
+
+    HeapFreeBlock* first = nullptr;
+    u8* block_memory = chunk_memory + sizeof( HeapChunk ) + stride * ( block_count - 1 );
+    for ( sizet i = 0; i < block_count; ++i, block_memory -= stride ) {
+        HeapBlockHeader* header = ( HeapBlockHeader* )block_memory;
+        header->owner = cache;
+        header->size_class = size_class;
+        header->offset = 0;
+
+        HeapFreeBlock* block = ( HeapFreeBlock* )( header + 1 );
+        block->next = first;
+        first = block;
+    }
+
+    return first;
+}
+
+static void* heap_allocate_concurrent( HeapAllocator* heap, sizet size, sizet alignment ) {
+    HeapConcurrentState* state = heap->concurrent;
+
+    const u32 size_class = alignment <= sizeof( HeapBlockHeader ) ? heap_size_class( size ) : k_heap_large_class;
+    if ( size_class != k_heap_large_class ) {
+        HeapThreadCache* cache = heap_get_thread_cache( state );
+
+        HeapFreeBlock* block = cache->free_lists[ size_class ];
+        if ( !block ) {
+            block = cache->remote_frees[ size_class ].exchange( nullptr, std::memory_order_acquire );
+            if ( !block ) {
+                block = heap_refill( state, heap->tlsf_handle, cache, size_class );
+                if ( !block ) {
+                    return nullptr;
+                }
+            }
+        }
+
+        cache->free_lists[ size_class ] = block->next;
+        cache->allocated_bytes.fetch_add( k_heap_size_classes[ size_class ], std::memory_order_relaxed );
+        return block;
+    }
+
+    // Large or over-aligned allocation: go to the pool directly, leaving room for the header.
+    const sizet offset = alignment > sizeof( HeapBlockHeader ) ? alignment : sizeof( HeapBlockHeader );
+
+    state->lock();
+    u8* block_memory = ( u8* )tlsf_memalign( heap->tlsf_handle, offset, size + offset );
+    if ( block_memory ) {
+        state->large_allocated_bytes += tlsf_block_size( block_memory );
+    }
+    state->unlock();
+
+    if ( !block_memory ) {
+        return nullptr;
+    }
+
+    u8* user_memory = block_memory + offset;
+    HeapBlockHeader* header = ( HeapBlockHeader* )user_memory - 1;
+    header->owner = nullptr;
+    header->size_class = k_heap_large_class;
+    header->offset = ( u32 )offset;
+
+    return user_memory;
+}
+
+static void heap_deallocate_concurrent( HeapAllocator* heap, void* pointer ) {
+    HeapConcurrentState* state = heap->concurrent;
+    HeapBlockHeader* header = ( HeapBlockHeader* )pointer - 1;
+
+    if ( header->size_class == k_heap_large_class ) {
+        u8* block_memory = ( u8* )pointer - header->offset;
+
+        state->lock();
+        state->large_allocated_bytes -= tlsf_block_size( block_memory );
+        tlsf_free( heap->tlsf_handle, block_memory );
+        state->unlock();
+        return;
+    }
+
+    const u32 size_class = header->size_class;
+    HeapThreadCache* owner = header->owner;
+    HeapFreeBlock* block = ( HeapFreeBlock* )pointer;
+    const sizet block_size = k_heap_size_classes[ size_class ];
+
+    if ( owner == heap_find_thread_cache( state ) ) {
+        block->next = owner->free_lists[ size_class ];
+        owner->free_lists[ size_class ] = block;
+        owner->allocated_bytes.fetch_sub( block_size, std::memory_order_relaxed );
+        return;
+    }
+
+    // Cross-thread free: only the owner pops, and it takes the whole list at once, so a plain push is ABA safe.
+    std::atomic<HeapFreeBlock*>& remote_list = owner->remote_frees[ size_class ];
+    HeapFreeBlock* head = remote_list.load( std::memory_order_relaxed );
+    do {
+        block->next = head;
+    } while ( !remote_list.compare_exchange_weak( head, block, std::memory_order_release, std::memory_order_relaxed ) );
+
+    // Last block of a cache whose thread is gone.
+    if ( owner->allocated_bytes.fetch_sub( block_size, std::memory_order_acq_rel ) == block_size ) {
+        heap_release_thread_cache( state, owner );
+    }
+}
+
+// Unlink a cache with no block in use and give its chunks, with the blocks in its free
+// and remote lists, back to the pool.
+static void heap_release_thread_cache( HeapConcurrentState* state, HeapThreadCache* cache ) {
+    state->lock();
+
+    HeapThreadCache** link = &state->caches;
+    while ( *link != cache ) {
+        link = &( *link )->next;
+    }
+    *link = cache->next;
+
+    HeapChunk* chunk = cache->chunks;
+    while ( chunk ) {
+        HeapChunk* next_chunk = chunk->next;
+        tlsf_free( state->tlsf_handle, chunk );
+        chunk = next_chunk;
+    }
+
+    state->unlock();
+
+    state->cache_count.fetch_sub( 1, std::memory_order_relaxed );
+    delete cache;
+}
+
+// Give all cached chunks back to the pool. Outstanding small allocations are lost.
+static void heap_release_thread_caches( HeapAllocator* heap ) {
+    HeapConcurrentState* state = heap->concurrent;
+
+    HeapThreadCache* cache = state->caches;
+    while ( cache ) {
+        HeapChunk* chunk = cache->chunks;
+        while ( chunk ) {
+            HeapChunk* next_chunk = chunk->next;
+            tlsf_free( heap->tlsf_handle, chunk );
+            chunk = next_chunk;
+        }
+
+        HeapThreadCache* next_cache = cache->next;
+        delete cache;
+        cache = next_cache;
+    }
+    state->caches = nullptr;
+}
+
+//
+// Frees the blocks handed over by the previous wave, then allocates from every heap, freeing half
+// of the blocks and handing the other half to the next wave.
+static void heap_churn_thread( HeapAllocator* heaps, u32 heap_count, void** handed_blocks, u32 blocks_per_heap, u32 seed ) {
+    u32 random_state = seed * 2654435761u + 1;
+    for ( u32 h = 0; h < heap_count; ++h ) {
+        void** blocks = handed_blocks + h * blocks_per_heap;
+        for ( u32 b = 0; b < blocks_per_heap; ++b ) {
+            if ( blocks[ b ] ) {
+                heaps[ h ].deallocate( blocks[ b ] );
+            }
+
+            random_state ^= random_state << 13;
+            random_state ^= random_state >> 17;
+            random_state ^= random_state << 5;
+            void* pointer = heaps[ h ].allocate( 8 + ( random_state & 1023 ), 1 );
+
+            if ( b & 1 ) {
+                blocks[ b ] = pointer;
+            } else {
+                heaps[ h ].deallocate( pointer );
+                blocks[ b ] = nullptr;
+            }
+        }
+    }
+}
+
+bool MemoryService::heap_churn_test( u32 waves, u32 threads_per_wave ) {
+    // More heaps than thread cache slots, so that caches are also given back on eviction.
+    static const u32 k_heap_count = k_heap_thread_cache_slots + 2;
+    static const u32 k_blocks_per_heap = 256;
+
+    HeapAllocator heaps[ k_heap_count ];
+    for ( u32 h = 0; h < k_heap_count; ++h ) {
+        heaps[ h ].init( rmega( 16 ), true );
+    }
+
+    const u32 blocks_per_thread = k_heap_count * k_blocks_per_heap;
+    void** handed_blocks = new void*[ threads_per_wave * blocks_per_thread ]();
+    std::thread* threads = new std::thread[ threads_per_wave ];
+
+    for ( u32 w = 0; w < waves; ++w ) {
+        for ( u32 t = 0; t < threads_per_wave; ++t ) {
+            threads[ t ] = std::thread( heap_churn_thread, heaps, k_heap_count, handed_blocks + t * blocks_per_thread, k_blocks_per_heap, w * threads_per_wave + t );
+        }
+        for ( u32 t = 0; t < threads_per_wave; ++t ) {
+            threads[ t ].join();
+        }
+    }
+
+    // Last blocks freed from a thread without caches: the caches of the exited threads go back to the pool.
+    for ( u32 t = 0; t < threads_per_wave; ++t ) {
+        for ( u32 h = 0; h < k_heap_count; ++h ) {
+            void** blocks = handed_blocks + t * blocks_per_thread + h * k_blocks_per_heap;
+            for ( u32 b = 0; b < k_blocks_per_heap; ++b ) {
+                if ( blocks[ b ] ) {
+                    heaps[ h ].deallocate( blocks[ b ] );
+                }
+            }
+        }
+    }
+
+    delete[] threads;
+    delete[] handed_blocks;
+
+    u32 cache_count = 0;
+    sizet pool_bytes = 0;
+    for ( u32 h = 0; h < k_heap_count; ++h ) {
+        MemoryStatistics stats{ 0, heaps[ h ].max_size };
+        tlsf_walk_pool( tlsf_get_pool( heaps[ h ].tlsf_handle ), count_walker, ( void* )&stats );
+
+        cache_count += heaps[ h ].concurrent->cache_count.load();
+        pool_bytes += stats.allocated_bytes;
+
+        heaps[ h ].shutdown();
+    }
+
+    rprint( "Heap churn test: %u waves of %u threads on %u heaps, %u thread caches and %llu pool bytes left at shutdown\n",
+            waves, threads_per_wave, k_heap_count, cache_count, ( u64 )pool_bytes );
+
+    RASSERTM( cache_count == 0 && pool_bytes == 0, "Thread caches of exited threads were not given back" );
+    return cache_count == 0 && pool_bytes == 0;
+}
+
+// AllocationTracker //////////////////////////////////////////////////////
+
+//
+//
+struct AllocationSite {
+    cstring                         file;
+    i32                             line;
+
+    sizet                           live_bytes;
+    sizet                           peak_bytes;
+    u64                             live_allocations;
+    u64                             total_allocations;
+
+    u64                             sampled_allocations;        // total_allocations at the last rate sample.
+    f64                             allocations_per_second;
+}; // struct AllocationSite
+
+//
+// Aggregates live/peak bytes and allocation rate per ralloca call site.
+// Both lookups (call site and live pointer) are hash map finds, so the cost
+// does not depend on the number of allocations in the pool.
+struct AllocationTracker {
+
+    void                            init();
+    void                            shutdown();
+
+    void                            on_allocate( void* pointer, sizet size, cstring file, i32 line );
+    void                            on_deallocate( void* pointer );
+
+    void                            sample_rates();
+    bool                            export_snapshot( cstring path, bool json );
+
+#if defined RAPTOR_IMGUI
+    void                            debug_ui();
+#endif // RAPTOR_IMGUI
+
+    static constexpr u32            k_size_bits     = 40;   // Live entries pack size and site index in a u64.
+    static constexpr u64            k_size_mask     = ( 1ull << k_size_bits ) - 1;
+
+    std::mutex                      mutex;
+    // Tables can't live in the tracked heap, it would recurse.
+    MallocAllocator                 table_allocator;
+
+    FlatHashMap<u64, u32>           site_indices;       // hash( file, line ) -> index in sites.
+    FlatHashMap<u64, u64>           live_allocations;   // pointer -> site index << k_size_bits | size.
+    Array<AllocationSite>           sites;
+
+    sizet                           live_bytes      = 0;
+    sizet                           peak_bytes      = 0;
+    i64                             last_sample_time = 0;
+
+}; // struct AllocationTracker
+
+void AllocationTracker::init() {
+    site_indices.init( &table_allocator, 256 );
+    live_allocations.init( &table_allocator, 4096 );
+    sites.init( &table_allocator, 256 );
+
+    last_sample_time = time_now();
+}
+
+void AllocationTracker::shutdown() {
+    site_indices.shutdown();
+    live_allocations.shutdown();
+    sites.shutdown();
+}
+
+void AllocationTracker::on_allocate( void* pointer, sizet size, cstring file, i32 line ) {
+    std::lock_guard<std::mutex> guard( mutex );
+
+    // File names are string literals, so the pointer identifies the file.
+    u64 site_key_data[ 2 ] = { ( u64 )( uintptr_t )file, ( u64 )line };
+    u64 site_key = hash_bytes( site_key_data, sizeof( site_key_data ) );
+
+    u32 site_index = u32_max;
+    for ( ;; ) {
+        FlatHashMapIterator it = site_indices.find( site_key );
+        if ( it.is_invalid() ) {
+            break;
+        }
+        const u32 index = site_indices.get( it );
+        if ( sites[ index ].file == file && sites[ index ].line == line ) {
+            site_index = index;
+            break;
+        }
+        // Extremely unlikely key collision: move to the next key.
+        ++site_key;
+    }
+
+    if ( site_index == u32_max ) {
+        site_index = sites.size;
+        AllocationSite& site = sites.push_use();
+        memset( &site, 0, sizeof( AllocationSite ) );
+        site.file = file;
+        site.line = line;
+        site_indices.insert( site_key, site_index );
+    }
+
+    AllocationSite& site = sites[ site_index ];
+    site.live_bytes += size;
+    site.peak_bytes = max( site.peak_bytes, site.live_bytes );
+    ++site.live_allocations;
+    ++site.total_allocations;
+
+    live_allocations.insert( ( u64 )( uintptr_t )pointer, ( ( u64 )site_index << k_size_bits ) | ( size & k_size_mask ) );
+
+    live_bytes += size;
+    peak_bytes = max( peak_bytes, live_bytes );
+
+    TracyAllocN( pointer, size, "HeapAllocator" );
+    TracyPlot( "Heap live bytes", ( i64 )live_bytes );
+}
+
+void AllocationTracker::on_deallocate( void* pointer ) {
+    std::lock_guard<std::mutex> guard( mutex );
+
+    FlatHashMapIterator it = live_allocations.find( ( u64 )( uintptr_t )pointer );
+    if ( it.is_invalid() ) {
+        // Allocated before tracking was enabled.
+        return;
+    }
+
+    const u64 entry = live_allocations.get( it );
+    live_allocations.remove( it );
+
+    const sizet size = entry & k_size_mask;
+    AllocationSite& site = sites[ ( u32 )( entry >> k_size_bits ) ];
+    site.live_bytes -= size;
+    --site.live_allocations;
+
+    live_bytes -= size;
+
+    TracyFreeN( pointer, "HeapAllocator" );
+    TracyPlot( "Heap live bytes", ( i64 )live_bytes );
+}
+
+void AllocationTracker::sample_rates() {
+    std::lock_guard<std::mutex> guard( mutex );
+
+    const i64 current_time = time_now();
+    const f64 elapsed_seconds = time_delta_seconds( last_sample_time, current_time );
+    if ( elapsed_seconds < 0.5 ) {
+        return;
+    }
+
+    for ( u32 i = 0; i < sites.size; ++i ) {
+        AllocationSite& site = sites[ i ];
+        site.allocations_per_second = ( site.total_allocations - site.sampled_allocations ) / elapsed_seconds;
+        site.sampled_allocations = site.total_allocations;
+    }
+    last_sample_time = current_time;
+}
+
+// Backslashes in Windows paths need escaping in json.
+static void fprint_json_string( FILE* file, cstring string ) {
+    fputc( '"', file );
+    for ( cstring c = string; *c; ++c ) {
+        if ( *c == '\\' || *c == '"' ) {
+            fputc( '\\', file );
+        }
+        fputc( *c, file );
+    }
+    fputc( '"', file );
+}
+
+bool AllocationTracker::export_snapshot( cstring path, bool json ) {
+    sample_rates();
+
+    FileHandle file;
+    file_open( path, "w", &file );
+    if ( !file ) {
+        rprint( "Cannot open %s to export allocation sites\n", path );
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard( mutex );
+
+    if ( json ) {
+        fprintf( file, "{\n  \"live_bytes\": %llu,\n  \"peak_bytes\": %llu,\n  \"sites\": [\n", ( unsigned long long )live_bytes, ( unsigned long long )peak_bytes );
+    } else {
+        fprintf( file, "file,line,live_bytes,peak_bytes,live_allocations,total_allocations,allocations_per_second\n" );
+    }
+
+    for ( u32 i = 0; i < sites.size; ++i ) {
+        const AllocationSite& site = sites[ i ];
+        cstring file_name = site.file ? site.file : "unknown";
+        if ( json ) {
+            fprintf( file, "    { \"file\": " );
+            fprint_json_string( file, file_name );
+            fprintf( file, ", \"line\": %d, \"live_bytes\": %llu, \"peak_bytes\": %llu, \"live_allocations\": %llu, \"total_allocations\": %llu, \"allocations_per_second\": %.2f }%s\n",
+                     site.line, ( unsigned long long )site.live_bytes, ( unsigned long long )site.peak_bytes, ( unsigned long long )site.live_allocations,
+                     ( unsigned long long )site.total_allocations, site.allocations_per_second, i + 1 < sites.size ? "," : "" );
+        } else {
+            fprintf( file, "\"%s\",%d,%llu,%llu,%llu,%llu,%.2f\n", file_name, site.line, ( unsigned long long )site.live_bytes, ( unsigned long long )site.peak_bytes,
+                     ( unsigned long long )site.live_allocations, ( unsigned long long )site.total_allocations, site.allocations_per_second );
+        }
+    }
+
+    if ( json ) {
+        fprintf( file, "  ]\n}\n" );
+    }
+
+    file_close( file );
+
+    rprint( "Exported %u allocation sites to %s\n", sites.size, path );
+    return true;
+}
+
+#if defined RAPTOR_IMGUI
+void AllocationTracker::debug_ui() {
+    sample_rates();
+
+    ImGui::Separator();
+    ImGui::Text( "Allocation Sites" );
+    ImGui::Separator();
+
+    std::lock_guard<std::mutex> guard( mutex );
+
+    ImGui::Text( "\tLive %llu K, peak %llu K, sites %u", ( unsigned long long )live_bytes / 1024, ( unsigned long long )peak_bytes / 1024, sites.size );
+
+    // Show the biggest owners of live memory.
+    static const u32 k_max_shown_sites = 32;
+    u32 shown[ k_max_shown_sites ];
+    u32 shown_count = 0;
+    for ( u32 i = 0; i < sites.size; ++i ) {
+        const sizet bytes = sites[ i ].live_bytes;
+        u32 position = shown_count;
+        while ( position > 0 && sites[ shown[ position - 1 ] ].live_bytes < bytes ) {
+            --position;
+        }
+        if ( position >= k_max_shown_sites ) {
+            continue;
+        }
+        const u32 last = min( shown_count, k_max_shown_sites - 1 );
+        for ( u32 s = last; s > position; --s ) {
+            shown[ s ] = shown[ s - 1 ];
+        }
+        shown[ position ] = i;
+        shown_count = min( shown_count + 1, k_max_shown_sites );
+    }
+
+    if ( ImGui::BeginTable( "allocation_sites", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg ) ) {
+        ImGui::TableSetupColumn( "Site" );
+        ImGui::TableSetupColumn( "Live K" );
+        ImGui::TableSetupColumn( "Peak K" );
+        ImGui::TableSetupColumn( "Live count" );
+        ImGui::TableSetupColumn( "Allocs/s" );
+        ImGui::TableHeadersRow();
+
+        for ( u32 i = 0; i < shown_count; ++i ) {
+            const AllocationSite& site = sites[ shown[ i ] ];
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text( "%s(%d)", site.file ? site.file : "unknown", site.line );
+            ImGui::TableNextColumn();
+            ImGui::Text( "%llu", ( unsigned long long )site.live_bytes / 1024 );
+            ImGui::TableNextColumn();
+            ImGui::Text( "%llu", ( unsigned long long )site.peak_bytes / 1024 );
+            ImGui::TableNextColumn();
+            ImGui::Text( "%llu", ( unsigned long long )site.live_allocations );
+            ImGui::TableNextColumn();
+            ImGui::Text( "%.1f", site.allocations_per_second );
+        }
+        ImGui::EndTable();
+    }
+}
+#endif // RAPTOR_IMGUI
+
 // HeapAllocator //////////////////////////////////////////////////////////
 HeapAllocator::~HeapAllocator() {
 }
 
-void HeapAllocator::init( sizet size ) {
+void HeapAllocator::init( sizet size, bool thread_safe ) {
     // Allocate
     memory = malloc( size );
     max_size = size;
@@ -137,11 +966,48 @@ void HeapAllocator::init( sizet size ) {
 
     tlsf_handle = tlsf_create_with_pool( memory, size );
 
-    rprint( "HeapAllocator of size %llu created\n", size );
+    if ( thread_safe ) {
+        concurrent = new HeapConcurrentState();
+        concurrent->generation = s_heap_generation.fetch_add( 1 );
+        concurrent->tlsf_handle = tlsf_handle;
+
+        std::lock_guard<std::mutex> guard( s_heap_live_mutex );
+        concurrent->next_live = s_heap_live_states;
+        s_heap_live_states = concurrent;
+    }
+
+    rprint( "HeapAllocator of size %llu created%s\n", size, thread_safe ? " (thread safe)" : "" );
 }
 
 void HeapAllocator::shutdown() {
 
+    if ( tracker ) {
+        tracker->shutdown();
+        delete tracker;
+        tracker = nullptr;
+    }
+
+    if ( concurrent ) {
+        {
+            std::lock_guard<std::mutex> guard( s_heap_live_mutex );
+            HeapConcurrentState** link = &s_heap_live_states;
+            while ( *link != concurrent ) {
+                link = &( *link )->next_live;
+            }
+            *link = concurrent->next_live;
+        }
+
+        const sizet small_bytes = concurrent->get_allocated_bytes() - concurrent->large_allocated_bytes;
+        heap_release_thread_caches( this );
+
+        if ( small_bytes ) {
+            rprint( "HeapAllocator Shutdown - %llu bytes still allocated through thread caches\n", small_bytes );
+        }
+
+        delete concurrent;
+        concurrent = nullptr;
+    }
+
     // Check memory at the application exit.
     MemoryStatistics stats{ 0, max_size };
     pool_t pool = tlsf_get_pool( tlsf_handle );
@@ -168,11 +1034,32 @@ void HeapAllocator::debug_ui() {
     ImGui::Separator();
     MemoryStatistics stats{ 0, max_size };
     pool_t pool = tlsf_get_pool( tlsf_handle );
+    if ( concurrent ) {
+        concurrent->lock();
+    }
     tlsf_walk_pool( pool, imgui_walker, ( void* )&stats );
+    if ( concurrent ) {
+        concurrent->unlock();
+    }
 
     ImGui::Separator();
     ImGui::Text( "\tAllocation count %d", stats.allocation_count );
     ImGui::Text( "\tAllocated %llu K, free %llu Mb, total %llu Mb", stats.allocated_bytes / (1024 * 1024), ( max_size - stats.allocated_bytes ) / ( 1024 * 1024 ), max_size / ( 1024 * 1024 ) );
+
+    if ( concurrent ) {
+        ImGui::Text( "\tThread caches %u, user allocated %llu K", concurrent->cache_count.load(), concurrent->get_allocated_bytes() / 1024 );
+    }
+
+    if ( tracker ) {
+        if ( ImGui::Button( "Export allocation sites csv" ) ) {
+            tracker->export_snapshot( "allocation_sites.csv", false );
+        }
+        ImGui::SameLine();
+        if ( ImGui::Button( "Export allocation sites json" ) ) {
+            tracker->export_snapshot( "allocation_sites.json", true );
+        }
+        tracker->debug_ui();
+    }
 }
 #endif // RAPTOR_IMGUI
 
@@ -188,41 +1075,67 @@ protected:
     }
 }; // class RaptorStackWalker
 
-void* HeapAllocator::allocate( sizet size, sizet alignment ) {
-    
+void* HeapAllocator::allocate( sizet size, sizet alignment, cstring file, i32 line ) {
+
+    void* mem = concurrent ? heap_allocate_concurrent( this, size, alignment ) : tlsf_malloc( tlsf_handle, size );
+
     /*if ( size == 16 ) 
     {
         RaptorStackWalker sw;
         sw.ShowCallstack();
     }*/
 
-    void* mem = tlsf_malloc( tlsf_handle, size );
+    if ( tracker && mem ) {
+        tracker->on_allocate( mem, size, file, line );
+    }
+
     rprint( "Mem: %p, size %llu \n", mem, size );
     return mem;
 }
 #else
 
-void* HeapAllocator::allocate( sizet size, sizet alignment ) {
+void* HeapAllocator::allocate( sizet size, sizet alignment, cstring file, i32 line ) {
+    void* allocated_memory = nullptr;
+
+    if ( concurrent ) {
+        allocated_memory = heap_allocate_concurrent( this, size, alignment );
+    } else {
 #if defined (HEAP_ALLOCATOR_STATS)
-    void* allocated_memory = alignment == 1 ? tlsf_malloc( tlsf_handle, size ) : tlsf_memalign( tlsf_handle, alignment, size );
-    sizet actual_size = tlsf_block_size( allocated_memory );
-    allocated_size += actual_size;
+        allocated_memory = alignment == 1 ? tlsf_malloc( tlsf_handle, size ) : tlsf_memalign( tlsf_handle, alignment, size );
+        sizet actual_size = tlsf_block_size( allocated_memory );
+        allocated_size += actual_size;
 
-    /*if ( size == 52224 ) {
-        return allocated_memory;
-    }*/
-    return allocated_memory;
+        /*if ( size == 52224 ) {
+            return allocated_memory;
+        }*/
 #else
-    return tlsf_malloc( tlsf_handle, size );
+        allocated_memory = tlsf_malloc( tlsf_handle, size );
 #endif // HEAP_ALLOCATOR_STATS
+    }
+
+    if ( tracker && allocated_memory ) {
+        tracker->on_allocate( allocated_memory, size, file, line );
+    }
+
+    return allocated_memory;
 }
 #endif // RAPTOR_MEMORY_STACK
 
-void* HeapAllocator::allocate( sizet size, sizet alignment, cstring file, i32 line ) {
-    return allocate( size, alignment );
+void* HeapAllocator::allocate( sizet size, sizet alignment ) {
+    // Untagged allocations are accounted to a single unknown site.
+    return allocate( size, alignment, nullptr, 0 );
 }
 
 void HeapAllocator::deallocate( void* pointer ) {
+    if ( tracker && pointer ) {
+        tracker->on_deallocate( pointer );
+    }
+
+    if ( concurrent ) {
+        heap_deallocate_concurrent( this, pointer );
+        return;
+    }
+
 #if defined (HEAP_ALLOCATOR_STATS)
     sizet actual_size = tlsf_block_size( pointer );
     allocated_size -= actual_size;
@@ -233,6 +1146,60 @@ void HeapAllocator::deallocate( void* pointer ) {
 #endif
 }
 
+void HeapAllocator::enable_tracking() {
+    if ( !tracker ) {
+        tracker = new AllocationTracker();
+        tracker->init();
+    }
+}
+
+bool HeapAllocator::export_tracking_snapshot( cstring path, bool json ) {
+    return tracker ? tracker->export_snapshot( path, json ) : false;
+}
+
+// Virtual memory helpers ///////////////////////////////////////////////////
+
+// Clears that must leave the top committed pages unused before they are decommitted.
+static const u32 k_virtual_trim_clears = 16;
+
+// Commit in bigger steps than a page to limit the number of system calls.
+static sizet virtual_commit_granularity() {
+    static const sizet granularity = memory_align( rkilo( 64 ), memory_page_size() );
+    return granularity;
+}
+
+static bool virtual_memory_grow( u8* memory, sizet& committed_size, sizet required_size, sizet total_size ) {
+    const sizet new_committed_size = min( memory_align( required_size, virtual_commit_granularity() ), total_size );
+    if ( !memory_commit( memory + committed_size, new_committed_size - committed_size ) ) {
+        hy_mem_assert( false && "Commit failed" );
+        return false;
+    }
+    committed_size = new_committed_size;
+    return true;
+}
+
+// Committed memory follows the high-water mark of the last k_virtual_trim_clears clears,
+// so an allocator cleared every frame does not decommit and commit again the same pages.
+static void virtual_memory_trim( u8* memory, sizet& committed_size, sizet& used_high_watermark, u32& clears_since_trim, sizet watermark ) {
+    if ( committed_size <= watermark ) {
+        used_high_watermark = 0;
+        clears_since_trim = 0;
+        return;
+    }
+
+    if ( ++clears_since_trim < k_virtual_trim_clears ) {
+        return;
+    }
+
+    const sizet kept_size = memory_align( max( used_high_watermark, watermark ), virtual_commit_granularity() );
+    if ( committed_size > kept_size ) {
+        memory_decommit( memory + kept_size, committed_size - kept_size );
+        committed_size = kept_size;
+    }
+    used_high_watermark = 0;
+    clears_since_trim = 0;
+}
+
 // LinearAllocator /////////////////////////////////////////////////////////
 
 LinearAllocator::~LinearAllocator() {
@@ -243,11 +1210,30 @@ void LinearAllocator::init( sizet size ) {
     memory = ( u8* )malloc( size );
     total_size = size;
     allocated_size = 0;
+    committed_size = size;
+    virtual_memory = false;
+}
+
+void LinearAllocator::init_virtual( sizet reserve_size, sizet decommit_watermark_ ) {
+
+    total_size = memory_align( reserve_size, virtual_commit_granularity() );
+    memory = ( u8* )memory_reserve( total_size );
+    RASSERTM( memory, "Cannot reserve %llu bytes of address space", total_size );
+    allocated_size = 0;
+    committed_size = 0;
+    used_high_watermark = 0;
+    clears_since_trim = 0;
+    decommit_watermark = decommit_watermark_;
+    virtual_memory = true;
 }
 
 void LinearAllocator::shutdown() {
     clear();
-    free( memory );
+    if ( virtual_memory ) {
+        memory_release( memory, total_size );
+    } else {
+        free( memory );
+    }
 }
 
 void* LinearAllocator::allocate( sizet size, sizet alignment ) {
@@ -261,7 +1247,12 @@ void* LinearAllocator::allocate( sizet size, sizet alignment ) {
         return nullptr;
     }
 
+    if ( new_allocated_size > committed_size && !virtual_memory_grow( memory, committed_size, new_allocated_size, total_size ) ) {
+        return nullptr;
+    }
+
     allocated_size = new_allocated_size;
+    used_high_watermark = max( used_high_watermark, new_allocated_size );
     return memory + new_start;
 }
 
@@ -275,8 +1266,65 @@ void LinearAllocator::deallocate( void*  ) {
 
 void LinearAllocator::clear() {
     allocated_size = 0;
+
+    if ( virtual_memory ) {
+        virtual_memory_trim( memory, committed_size, used_high_watermark, clears_since_trim, decommit_watermark );
+    }
+}
+
+// FrameThreadArenas //////////////////////////////////////////////////////
+void FrameThreadArenas::init( u32 num_threads_, sizet size_per_thread ) {
+    RASSERTM( num_threads_ <= k_max_threads, "Requested %u frame arenas, maximum is %u", num_threads_, k_max_threads );
+
+    num_threads = min( num_threads_, k_max_threads );
+    for ( u32 i = 0; i < num_threads; ++i ) {
+        arenas[ i ].init( size_per_thread );
+        last_frame_size[ i ] = 0;
+        high_watermark[ i ] = 0;
+    }
+
+    rprint( "FrameThreadArenas created: %u threads, %llu bytes each\n", num_threads, size_per_thread );
 }
 
+void FrameThreadArenas::shutdown() {
+    for ( u32 i = 0; i < num_threads; ++i ) {
+        arenas[ i ].shutdown();
+    }
+    num_threads = 0;
+}
+
+void FrameThreadArenas::new_frame() {
+    for ( u32 i = 0; i < num_threads; ++i ) {
+        LinearAllocator& arena = arenas[ i ];
+        last_frame_size[ i ] = arena.allocated_size;
+        high_watermark[ i ] = max( high_watermark[ i ], arena.allocated_size );
+        arena.clear();
+    }
+}
+
+LinearAllocator* FrameThreadArenas::get( u32 thread_index ) {
+    RASSERT( thread_index < num_threads );
+    return &arenas[ thread_index ];
+}
+
+#if defined RAPTOR_IMGUI
+void FrameThreadArenas::debug_ui() {
+
+    if ( num_threads == 0 ) {
+        return;
+    }
+
+    ImGui::Separator();
+    ImGui::Text( "Frame Thread Arenas" );
+    ImGui::Separator();
+
+    for ( u32 i = 0; i < num_threads; ++i ) {
+        const LinearAllocator& arena = arenas[ i ];
+        ImGui::Text( "\tThread %2u: last frame %llu K, high watermark %llu K, total %llu K", i, last_frame_size[ i ] / 1024, high_watermark[ i ] / 1024, arena.total_size / 1024 );
+    }
+}
+#endif // RAPTOR_IMGUI
+
 // Memory Methods /////////////////////////////////////////////////////////
 void memory_copy( void* destination, void* source, sizet size ) {
     memcpy( destination, source, size );
@@ -287,6 +1335,51 @@ sizet memory_align( sizet size, sizet alignment ) {
     return ( size + alignment_mask ) & ~alignment_mask;
 }
 
+sizet memory_page_size() {
+#if defined(_WIN64)
+    SYSTEM_INFO system_info;
+    GetSystemInfo( &system_info );
+    return system_info.dwPageSize;
+#else
+    return ( sizet )sysconf( _SC_PAGESIZE );
+#endif
+}
+
+void* memory_reserve( sizet size ) {
+#if defined(_WIN64)
+    return VirtualAlloc( nullptr, size, MEM_RESERVE, PAGE_NOACCESS );
+#else
+    void* address = mmap( nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+    return address == MAP_FAILED ? nullptr : address;
+#endif
+}
+
+bool memory_commit( void* address, sizet size ) {
+#if defined(_WIN64)
+    return VirtualAlloc( address, size, MEM_COMMIT, PAGE_READWRITE ) != nullptr;
+#else
+    return mprotect( address, size, PROT_READ | PROT_WRITE ) == 0;
+#endif
+}
+
+void memory_decommit( void* address, sizet size ) {
+#if defined(_WIN64)
+    VirtualFree( address, size, MEM_DECOMMIT );
+#else
+    // Drop the physical pages, then make the range inaccessible again.
+    madvise( address, size, MADV_DONTNEED );
+    mprotect( address, size, PROT_NONE );
+#endif
+}
+
+void memory_release( void* address, sizet size ) {
+#if defined(_WIN64)
+    VirtualFree( address, 0, MEM_RELEASE );
+#else
+    munmap( address, size );
+#endif
+}
+
 // MallocAllocator ///////////////////////////////////////////////////////
 void* MallocAllocator::allocate( sizet size, sizet alignment ) {
     return malloc( size );
@@ -305,10 +1398,28 @@ void StackAllocator::init( sizet size ) {
     memory = (u8*)malloc( size );
     allocated_size = 0;
     total_size = size;
+    committed_size = size;
+    virtual_memory = false;
+}
+
+void StackAllocator::init_virtual( sizet reserve_size, sizet decommit_watermark_ ) {
+    total_size = memory_align( reserve_size, virtual_commit_granularity() );
+    memory = ( u8* )memory_reserve( total_size );
+    RASSERTM( memory, "Cannot reserve %llu bytes of address space", total_size );
+    allocated_size = 0;
+    committed_size = 0;
+    used_high_watermark = 0;
+    clears_since_trim = 0;
+    decommit_watermark = decommit_watermark_;
+    virtual_memory = true;
 }
 
 void StackAllocator::shutdown() {
-    free( memory );
+    if ( virtual_memory ) {
+        memory_release( memory, total_size );
+    } else {
+        free( memory );
+    }
 }
 
 void* StackAllocator::allocate( sizet size, sizet alignment ) {
@@ -322,7 +1433,12 @@ void* StackAllocator::allocate( sizet size, sizet alignment ) {
         return nullptr;
     }
 
+    if ( new_allocated_size > committed_size && !virtual_memory_grow( memory, committed_size, new_allocated_size, total_size ) ) {
+        return nullptr;
+    }
+
     allocated_size = new_allocated_size;
+    used_high_watermark = max( used_high_watermark, new_allocated_size );
     return memory + new_start;
 }
 
@@ -354,6 +1470,10 @@ void StackAllocator::free_marker( sizet marker ) {
 
 void StackAllocator::clear() {
     allocated_size = 0;
+
+    if ( virtual_memory ) {
+        virtual_memory_trim( memory, committed_size, used_high_watermark, clears_since_trim, decommit_watermark );
+    }
 }
 
 // DoubleStackAllocator //////////////////////////////////////////////////
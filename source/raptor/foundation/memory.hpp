@@ -14,6 +14,14 @@ namespace raptor {
     //  Calculate aligned memory size.
     sizet           memory_align( sizet size, sizet alignment );
 
+    //
+    //  Virtual memory: reserve address space, then commit/decommit pages inside it.
+    sizet           memory_page_size();
+    void*           memory_reserve( sizet size );
+    bool            memory_commit( void* address, sizet size );
+    void            memory_decommit( void* address, sizet size );
+    void            memory_release( void* address, sizet size );
+
     // Memory Structs /////////////////////////////////////////////////////
     //
     //
@@ -42,13 +50,19 @@ namespace raptor {
     }; // struct Allocator
 
 
+    struct HeapConcurrentState;
+    struct AllocationTracker;
+
     //
-    //
+    // TLSF based heap.
+    // In thread safe mode small allocations are served by per-thread caches of
+    // size classes, refilled from the TLSF pool under a lock. Frees coming from
+    // another thread are pushed lock-free to the owning cache.
     struct HeapAllocator : public Allocator {
 
         ~HeapAllocator() override;
 
-        void                        init( sizet size );
+        void                        init( sizet size, bool thread_safe = false );
         void                        shutdown();
 
 #if defined RAPTOR_IMGUI
@@ -60,11 +74,18 @@ namespace raptor {
 
         void                        deallocate( void* pointer ) override;
 
+        // Per call site statistics using the file/line passed by ralloca & co.
+        void                        enable_tracking();
+        bool                        export_tracking_snapshot( cstring path, bool json );
+
         void*                       tlsf_handle;
         void*                       memory;
         sizet                       allocated_size = 0;
         sizet                       max_size = 0;
-        
+
+        HeapConcurrentState*        concurrent = nullptr;   // Valid only in thread safe mode.
+        AllocationTracker*          tracker = nullptr;      // Valid only when tracking is enabled.
+
     }; // struct HeapAllocator
 
     //
@@ -72,6 +93,9 @@ namespace raptor {
     struct StackAllocator : public Allocator {
 
         void                        init( sizet size );
+        // Reserve address space only, pages are committed while the stack grows.
+        // Committed memory above decommit_watermark and unused for a few clears is given back to the OS.
+        void                        init_virtual( sizet reserve_size, sizet decommit_watermark = SIZE_MAX );
         void                        shutdown();
 
         void*                       allocate( sizet size, sizet alignment ) override;
@@ -88,6 +112,12 @@ namespace raptor {
         sizet                       total_size      = 0;
         sizet                       allocated_size  = 0;
 
+        sizet                       committed_size  = 0;
+        sizet                       decommit_watermark = SIZE_MAX;
+        sizet                       used_high_watermark = 0;    // Peak usage since the last trim.
+        u32                         clears_since_trim = 0;
+        bool                        virtual_memory  = false;
+
     }; // struct StackAllocator
 
     //
@@ -131,6 +161,9 @@ namespace raptor {
         ~LinearAllocator();
 
         void                        init( sizet size );
+        // Reserve address space only, pages are committed while allocations grow.
+        // Committed memory above decommit_watermark and unused for a few clears is given back to the OS.
+        void                        init_virtual( sizet reserve_size, sizet decommit_watermark = SIZE_MAX );
         void                        shutdown();
 
         void*                       allocate( sizet size, sizet alignment ) override;
@@ -143,6 +176,12 @@ namespace raptor {
         u8*                         memory          = nullptr;
         sizet                       total_size      = 0;
         sizet                       allocated_size  = 0;
+
+        sizet                       committed_size  = 0;
+        sizet                       decommit_watermark = SIZE_MAX;
+        sizet                       used_high_watermark = 0;    // Peak usage since the last trim.
+        u32                         clears_since_trim = 0;
+        bool                        virtual_memory  = false;
     }; // struct LinearAllocator
 
     //
@@ -154,12 +193,43 @@ namespace raptor {
         void                        deallocate( void* pointer ) override;
     };
 
+    //
+    // One LinearAllocator per worker thread, all cleared once per frame.
+    // Each thread must only allocate from the arena of its own thread index,
+    // so no locking is needed.
+    struct FrameThreadArenas {
+
+        void                        init( u32 num_threads, sizet size_per_thread );
+        void                        shutdown();
+
+        // Records per-thread usage and clears all arenas.
+        // Must be called when no worker is allocating, e.g. at the start of the frame.
+        void                        new_frame();
+
+        LinearAllocator*            get( u32 thread_index );
+
+#if defined RAPTOR_IMGUI
+        void                        debug_ui();
+#endif // RAPTOR_IMGUI
+
+        static constexpr u32        k_max_threads   = 64;
+
+        LinearAllocator             arenas[ k_max_threads ];
+        sizet                       last_frame_size[ k_max_threads ];
+        sizet                       high_watermark[ k_max_threads ];
+
+        u32                         num_threads     = 0;
+
+    }; // struct FrameThreadArenas
+
     // Memory Service /////////////////////////////////////////////////////
     // 
     // 
     struct MemoryServiceConfiguration {
 
         sizet                       maximum_dynamic_size = 32 * 1024 * 1024;    // Defaults to max 32MB of dynamic memory.
+        bool                        thread_safe_system_allocator = false;
+        bool                        enable_allocation_tracking = false;
 
     }; // struct MemoryServiceConfiguration
     //
@@ -178,11 +248,20 @@ namespace raptor {
         // Frame allocator
         LinearAllocator             scratch_allocator;
         HeapAllocator               system_allocator;
+        // Per-thread frame allocators, initialized once the number of task threads is known.
+        FrameThreadArenas           frame_thread_arenas;
 
         //
         // Test allocators.
         void                        test();
 
+        // Multi-threaded alloc/free throughput of a mutex guarded single pool versus the thread safe heap.
+        // Returns allocations per millisecond for both.
+        static void                 heap_benchmark( u32 num_threads, u32 allocations_per_thread, f64& locked_per_ms, f64& concurrent_per_ms );
+        // Waves of short lived threads allocating from and freeing to thread safe heaps, some blocks freed by
+        // the next wave. Checks that the heaps are empty at shutdown, thread caches included.
+        static bool                 heap_churn_test( u32 waves, u32 threads_per_wave );
+
         static constexpr cstring    k_name = "raptor_memory_service";
 
     }; // struct MemoryService
@@ -19,7 +19,7 @@
 #define RAPTOR_CONCAT_OPERATOR(x, y)                x##y
 #else
 #define RAPTOR_INLINE                               inline
-#define RAPTOR_FINLINE                              always_inline
+#define RAPTOR_FINLINE                              inline __attribute__( ( always_inline ) )
 #define RAPTOR_DEBUG_BREAK                          raise(SIGTRAP);
 #define RAPTOR_CONCAT_OPERATOR(x, y)                x y
 #endif // MSVC
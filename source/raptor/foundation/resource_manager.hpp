@@ -57,6 +57,10 @@ struct ResourceManager {
     template <typename T>
     T*              load( cstring name );
 
+    // Resolves the cache lookup with the precomputed name hash.
+    template <typename T>
+    T*              load( const HashedString& name );
+
     template <typename T>
     T*              get( cstring name );
 
@@ -93,6 +97,23 @@ inline T* ResourceManager::load( cstring name ) {
     return nullptr;
 }
 
+template<typename T>
+inline T* ResourceManager::load( const HashedString& name ) {
+    ResourceLoader* loader = loaders.get( T::k_type_hash );
+    if ( loader ) {
+        hashed_string_check( name );
+        // Search if the resource is already in cache
+        T* resource = ( T* )loader->get( name.hash );
+        if ( resource )
+            return resource;
+
+        // Resource not in cache, create from file
+        cstring path = filename_resolver->get_binary_path_from_name( name.string );
+        return (T*)loader->create_from_file( name.string, path, this );
+    }
+    return nullptr;
+}
+
 template<typename T>
 inline T* ResourceManager::get( cstring name ) {
     ResourceLoader* loader = loaders.get( T::k_type_hash );
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "foundation/platform.hpp"
+
+#include "external/cglm/struct/mat4.h"
+
+#include <stdint.h>
+
+// Defines:
+// RAPTOR_SIMD_PORTABLE     - force the scalar fallback of every SIMD kernel, shared ones like simd_mat4_mul included.
+//
+// Kernels use the widest instruction set enabled at compile time, each level implies the lower ones:
+// RAPTOR_SIMD_AVX2, RAPTOR_SIMD_AVX and RAPTOR_SIMD_SSE2. RAPTOR_SIMD_SCALAR is defined when none is available.
+
+#if defined(RAPTOR_SIMD_PORTABLE)
+    #define RAPTOR_SIMD_SCALAR
+#elif defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+    #define RAPTOR_SIMD_SSE2
+    #if defined(__AVX__)
+        #define RAPTOR_SIMD_AVX
+    #endif
+    #if defined(__AVX2__)
+        #define RAPTOR_SIMD_AVX2
+    #endif
+#else
+    #define RAPTOR_SIMD_SCALAR
+#endif
+
+#if !defined(RAPTOR_SIMD_SCALAR)
+    #include <immintrin.h>
+#endif
+
+namespace raptor {
+
+#if defined(RAPTOR_SIMD_AVX)
+    static const uintptr_t k_simd_stream_alignment = 32;
+#else
+    static const uintptr_t k_simd_stream_alignment = 16;
+#endif
+
+    // Column major product a * b, result can not alias the inputs.
+    // Stream writes around the caches: result must be aligned to k_simd_stream_alignment and
+    // the stores are made visible with _mm_sfence once all the products are written.
+    template <bool Stream = false>
+    inline void simd_mat4_mul( const mat4s& a, const mat4s& b, mat4s& result ) {
+#if defined(RAPTOR_SIMD_AVX)
+        // Both halves hold the same column of a, each half multiplies one column of b.
+        const __m256 a0 = _mm256_broadcast_ps( ( const __m128* )a.raw[ 0 ] );
+        const __m256 a1 = _mm256_broadcast_ps( ( const __m128* )a.raw[ 1 ] );
+        const __m256 a2 = _mm256_broadcast_ps( ( const __m128* )a.raw[ 2 ] );
+        const __m256 a3 = _mm256_broadcast_ps( ( const __m128* )a.raw[ 3 ] );
+
+        const __m256 b01 = _mm256_loadu_ps( b.raw[ 0 ] );
+        const __m256 b23 = _mm256_loadu_ps( b.raw[ 2 ] );
+
+        __m256 r01 = _mm256_mul_ps( a0, _mm256_permute_ps( b01, 0x00 ) );
+        r01 = _mm256_add_ps( r01, _mm256_mul_ps( a1, _mm256_permute_ps( b01, 0x55 ) ) );
+        r01 = _mm256_add_ps( r01, _mm256_mul_ps( a2, _mm256_permute_ps( b01, 0xAA ) ) );
+        r01 = _mm256_add_ps( r01, _mm256_mul_ps( a3, _mm256_permute_ps( b01, 0xFF ) ) );
+
+        __m256 r23 = _mm256_mul_ps( a0, _mm256_permute_ps( b23, 0x00 ) );
+        r23 = _mm256_add_ps( r23, _mm256_mul_ps( a1, _mm256_permute_ps( b23, 0x55 ) ) );
+        r23 = _mm256_add_ps( r23, _mm256_mul_ps( a2, _mm256_permute_ps( b23, 0xAA ) ) );
+        r23 = _mm256_add_ps( r23, _mm256_mul_ps( a3, _mm256_permute_ps( b23, 0xFF ) ) );
+
+        if ( Stream ) {
+            _mm256_stream_ps( result.raw[ 0 ], r01 );
+            _mm256_stream_ps( result.raw[ 2 ], r23 );
+        } else {
+            _mm256_storeu_ps( result.raw[ 0 ], r01 );
+            _mm256_storeu_ps( result.raw[ 2 ], r23 );
+        }
+#elif defined(RAPTOR_SIMD_SSE2)
+        const __m128 a0 = _mm_loadu_ps( a.raw[ 0 ] );
+        const __m128 a1 = _mm_loadu_ps( a.raw[ 1 ] );
+        const __m128 a2 = _mm_loadu_ps( a.raw[ 2 ] );
+        const __m128 a3 = _mm_loadu_ps( a.raw[ 3 ] );
+
+        for ( u32 c = 0; c < 4; ++c ) {
+            const __m128 column = _mm_loadu_ps( b.raw[ c ] );
+            __m128 r = _mm_mul_ps( a0, _mm_shuffle_ps( column, column, 0x00 ) );
+            r = _mm_add_ps( r, _mm_mul_ps( a1, _mm_shuffle_ps( column, column, 0x55 ) ) );
+            r = _mm_add_ps( r, _mm_mul_ps( a2, _mm_shuffle_ps( column, column, 0xAA ) ) );
+            r = _mm_add_ps( r, _mm_mul_ps( a3, _mm_shuffle_ps( column, column, 0xFF ) ) );
+            if ( Stream ) {
+                _mm_stream_ps( result.raw[ c ], r );
+            } else {
+                _mm_storeu_ps( result.raw[ c ], r );
+            }
+        }
+#else
+        result = glms_mat4_mul( a, b );
+#endif
+    }
+
+} // namespace raptor